@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include <memory>
+
+
+class App
+{
+public:
+    /* Public functions */
+     App();
+    ~App();
+
+    void init();
+    void run ();
+
+private:
+    /* Private functions */
+    App           (const App&);
+    App& operator=(const App&);
+
+    void deinit     ();
+    void init_vulkan();
+
+    double measure_items_per_second(uint32_t in_n_threads,
+                                    bool     in_use_thread_safe_pool);
+
+
+    /* Private variables */
+    std::weak_ptr<Anvil::SGPUDevice>     m_device_ptr;
+    std::shared_ptr<Anvil::Instance>     m_instance_ptr;
+    std::weak_ptr<Anvil::PhysicalDevice> m_physical_device_ptr;
+};
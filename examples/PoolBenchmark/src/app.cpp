@@ -0,0 +1,216 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* This example does not open a window. It measures how many command buffers per second can be taken
+ * from & returned to a PrimaryCommandBufferPool by a varying number of threads. Two configurations are
+ * compared:
+ *
+ * - a pool created in thread-safe mode, which is accessed without any extra synchronization.
+ * - a pool created in the default single-threaded mode, whose accesses are guarded by a mutex.
+ *
+ * Each thread holds on to a few command buffers at a time, in order to mimic a thread recording
+ * a couple of command buffers per frame.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "misc/object_tracker.h"
+#include "misc/pools.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/command_pool.h"
+#include "wrappers/device.h"
+#include "wrappers/instance.h"
+#include "wrappers/physical_device.h"
+#include "../include/app.h"
+
+
+#define APP_NAME                    "Pool benchmark app"
+#define N_ITEMS_HELD_PER_THREAD     (4)
+#define N_ITERATIONS_PER_THREAD     (100000)
+#define N_MAX_THREADS               (8)
+#define N_PREALLOCATED_ITEMS        (N_MAX_THREADS * N_ITEMS_HELD_PER_THREAD)
+
+
+App::App()
+{
+    // ..
+}
+
+App::~App()
+{
+    deinit();
+}
+
+void App::deinit()
+{
+    vkDeviceWaitIdle(m_device_ptr.lock()->get_device_vk() );
+
+    m_device_ptr.lock()->destroy();
+    m_device_ptr.reset();
+
+    m_instance_ptr->destroy();
+    m_instance_ptr.reset();
+}
+
+void App::init()
+{
+    init_vulkan();
+}
+
+void App::init_vulkan()
+{
+    /* Create a Vulkan instance */
+    m_instance_ptr = Anvil::Instance::create(APP_NAME,  /* app_name */
+                                             APP_NAME,  /* engine_name */
+                                             nullptr,   /* validation_proc */
+                                             nullptr);  /* validation_proc_user_arg */
+
+    m_physical_device_ptr = m_instance_ptr->get_physical_device(0);
+
+    /* Create a Vulkan device. Pooled command buffers are reset whenever they are taken from the pool,
+     * so they need to be resettable. */
+    m_device_ptr = Anvil::SGPUDevice::create(m_physical_device_ptr,
+                                             std::vector<const char*>(), /* extensions */
+                                             std::vector<const char*>(), /* layers     */
+                                             false,                      /* transient_command_buffer_allocs_only */
+                                             true);                      /* support_resettable_command_buffers   */
+}
+
+/** Spawns @param in_n_threads threads, each of which takes N_ITERATIONS_PER_THREAD command buffers
+ *  from a pool, and returns the total number of command buffers taken per second.
+ *
+ *  @param in_n_threads            Number of threads to use.
+ *  @param in_use_thread_safe_pool true to use a pool created in thread-safe mode, false to use a
+ *                                 single-threaded pool guarded by a mutex.
+ **/
+double App::measure_items_per_second(uint32_t in_n_threads,
+                                     bool     in_use_thread_safe_pool)
+{
+    std::shared_ptr<Anvil::PrimaryCommandBufferPool> pool_ptr;
+    std::mutex                                       pool_mutex;
+    std::chrono::high_resolution_clock::time_point   end_time;
+    std::chrono::high_resolution_clock::time_point   start_time;
+    std::vector<std::thread>                         threads;
+
+    pool_ptr = Anvil::PrimaryCommandBufferPool::create(m_device_ptr.lock()->get_command_pool(Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL),
+                                                       N_PREALLOCATED_ITEMS,
+                                                       in_use_thread_safe_pool);
+
+    auto thread_proc = [&]()
+    {
+        std::shared_ptr<Anvil::PrimaryCommandBuffer> held_items[N_ITEMS_HELD_PER_THREAD];
+
+        for (uint32_t n_iteration = 0;
+                      n_iteration < N_ITERATIONS_PER_THREAD;
+                    ++n_iteration)
+        {
+            std::shared_ptr<Anvil::PrimaryCommandBuffer>& item_ptr = held_items[n_iteration % N_ITEMS_HELD_PER_THREAD];
+
+            if (in_use_thread_safe_pool)
+            {
+                item_ptr = nullptr;
+                item_ptr = pool_ptr->get_item();
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lock(pool_mutex);
+
+                item_ptr = nullptr;
+                item_ptr = pool_ptr->get_item();
+            }
+        }
+
+        if (!in_use_thread_safe_pool)
+        {
+            std::unique_lock<std::mutex> lock(pool_mutex);
+
+            for (uint32_t n_item = 0;
+                          n_item < N_ITEMS_HELD_PER_THREAD;
+                        ++n_item)
+            {
+                held_items[n_item] = nullptr;
+            }
+        }
+    };
+
+    start_time = std::chrono::high_resolution_clock::now();
+    {
+        for (uint32_t n_thread = 0;
+                      n_thread < in_n_threads;
+                    ++n_thread)
+        {
+            threads.push_back(std::thread(thread_proc) );
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+
+    return double(in_n_threads) * double(N_ITERATIONS_PER_THREAD) / std::chrono::duration<double>(end_time - start_time).count();
+}
+
+void App::run()
+{
+    printf("Command buffers taken from the pool per second (%d iterations per thread):\n"
+           "  Threads | Mutex-guarded pool | Thread-safe pool\n",
+           N_ITERATIONS_PER_THREAD);
+
+    for (uint32_t n_threads = 1;
+                  n_threads <= N_MAX_THREADS;
+                  n_threads *= 2)
+    {
+        const double mutex_guarded_items_per_second = measure_items_per_second(n_threads,
+                                                                               false); /* in_use_thread_safe_pool */
+        const double thread_safe_items_per_second   = measure_items_per_second(n_threads,
+                                                                               true);  /* in_use_thread_safe_pool */
+
+        printf("  %7u | %18.0f | %16.0f\n",
+               n_threads,
+               mutex_guarded_items_per_second,
+               thread_safe_items_per_second);
+    }
+}
+
+
+int main()
+{
+    std::shared_ptr<App> app_ptr(new App() );
+
+    app_ptr->init();
+    app_ptr->run();
+
+    #ifdef _DEBUG
+    {
+        app_ptr.reset();
+
+        Anvil::ObjectTracker::get()->check_for_leaks();
+    }
+    #endif
+
+    return 0;
+}
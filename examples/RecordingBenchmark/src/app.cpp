@@ -0,0 +1,605 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Uncomment the #define below to enable validation */
+// #define ENABLE_VALIDATION
+
+/* This example does not open a window. It records the same stream of draw calls into a command buffer,
+ * first with the regular record_*() functions and then with the raw-handle CommandBufferBase::fast()
+ * interface, and prints the number of draw calls recorded per second for each of the two. The command
+ * buffers are never submitted.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "misc/glsl_to_spirv.h"
+#include "misc/memory_allocator.h"
+#include "misc/object_tracker.h"
+#include "wrappers/buffer.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/command_pool.h"
+#include "wrappers/descriptor_set.h"
+#include "wrappers/descriptor_set_group.h"
+#include "wrappers/device.h"
+#include "wrappers/graphics_pipeline_manager.h"
+#include "wrappers/framebuffer.h"
+#include "wrappers/image.h"
+#include "wrappers/image_view.h"
+#include "wrappers/instance.h"
+#include "wrappers/physical_device.h"
+#include "wrappers/pipeline_layout.h"
+#include "wrappers/render_pass.h"
+#include "wrappers/shader_module.h"
+#include "../include/app.h"
+
+
+#define APP_NAME               "Recording benchmark app"
+#define N_DRAWS_PER_ITERATION  (10000)
+#define N_ITERATIONS           (50)
+#define N_WARMUP_ITERATIONS    (5)
+#define RT_HEIGHT              (64)
+#define RT_WIDTH               (64)
+
+
+static const char* g_glsl_frag =
+    "#version 430\n"
+    "\n"
+    "layout (location = 0) out vec4 result;\n"
+    "\n"
+    "layout (push_constant) uniform PC\n"
+    "{\n"
+    "    vec4 color;\n"
+    "} pc;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    result = pc.color;\n"
+    "}\n";
+
+static const char* g_glsl_vert =
+    "#version 430\n"
+    "\n"
+    "layout (location = 0) in vec4 vertexData;\n"
+    "\n"
+    "layout (std140, binding = 0) uniform dataUB\n"
+    "{\n"
+    "    vec4 offset;\n"
+    "};\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(vertexData.xy + offset.xy, 0.0, 1.0);\n"
+    "}\n";
+
+static const float g_mesh_data[] =
+{
+   -1.0f,  1.0f,  0.0f, 1.0f,
+   -1.0f, -1.0f,  0.0f, 1.0f,
+    1.0f, -1.0f,  0.0f, 1.0f,
+};
+
+static const uint16_t g_index_data[] =
+{
+    0, 1, 2
+};
+
+static const float g_ub_data[] =
+{
+    0.0f, 0.0f, 0.0f, 0.0f
+};
+
+
+App::App()
+{
+    // ..
+}
+
+App::~App()
+{
+    deinit();
+}
+
+void App::deinit()
+{
+    vkDeviceWaitIdle(m_device_ptr.lock()->get_device_vk() );
+
+    m_command_buffer_ptr.reset();
+    m_color_image_view_ptr.reset();
+    m_color_image_ptr.reset();
+    m_data_buffer_ptr.reset();
+    m_dsg_ptr.reset();
+    m_fbo_ptr.reset();
+    m_fs_ptr.reset();
+    m_index_buffer_ptr.reset();
+    m_mesh_data_buffer_ptr.reset();
+    m_renderpass_ptr.reset();
+    m_vs_ptr.reset();
+
+    m_device_ptr.lock()->destroy();
+    m_device_ptr.reset();
+
+    m_instance_ptr->destroy();
+    m_instance_ptr.reset();
+}
+
+void App::init()
+{
+    init_vulkan();
+
+    init_buffers     ();
+    init_dsgs        ();
+    init_images      ();
+    init_framebuffers();
+    init_shaders     ();
+
+    init_gfx_pipelines  ();
+    init_command_buffers();
+}
+
+void App::init_buffers()
+{
+    /* Use a memory allocator to re-use memory blocks wherever possible */
+    std::shared_ptr<Anvil::MemoryAllocator> allocator_ptr = Anvil::MemoryAllocator::create(m_device_ptr);
+
+    m_data_buffer_ptr      = Anvil::Buffer::create_nonsparse(m_device_ptr,
+                                                             sizeof(g_ub_data),
+                                                             Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                             VK_SHARING_MODE_EXCLUSIVE,
+                                                             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    m_index_buffer_ptr     = Anvil::Buffer::create_nonsparse(m_device_ptr,
+                                                             sizeof(g_index_data),
+                                                             Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                             VK_SHARING_MODE_EXCLUSIVE,
+                                                             VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    m_mesh_data_buffer_ptr = Anvil::Buffer::create_nonsparse(m_device_ptr,
+                                                             sizeof(g_mesh_data),
+                                                             Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                             VK_SHARING_MODE_EXCLUSIVE,
+                                                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+    allocator_ptr->add_buffer(m_data_buffer_ptr,
+                              0); /* in_required_memory_features */
+    allocator_ptr->add_buffer(m_index_buffer_ptr,
+                              0); /* in_required_memory_features */
+    allocator_ptr->add_buffer(m_mesh_data_buffer_ptr,
+                              0); /* in_required_memory_features */
+
+    /* Allocate memory blocks and copy data */
+    allocator_ptr->bake();
+
+    m_data_buffer_ptr->write     (0, /* start_offset */
+                                  sizeof(g_ub_data),
+                                  g_ub_data);
+    m_index_buffer_ptr->write    (0, /* start_offset */
+                                  sizeof(g_index_data),
+                                  g_index_data);
+    m_mesh_data_buffer_ptr->write(0, /* start_offset */
+                                  sizeof(g_mesh_data),
+                                  g_mesh_data);
+}
+
+void App::init_command_buffers()
+{
+    std::shared_ptr<Anvil::SGPUDevice> device_locked_ptr(m_device_ptr);
+
+    m_command_buffer_ptr = device_locked_ptr->get_command_pool(Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL)->alloc_primary_level_command_buffer();
+}
+
+void App::init_dsgs()
+{
+    m_dsg_ptr = Anvil::DescriptorSetGroup::create(m_device_ptr,
+                                                  false, /* releaseable_sets */
+                                                  1      /* n_sets           */);
+
+    m_dsg_ptr->add_binding     (0, /* n_set     */
+                                0, /* n_binding */
+                                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                1, /* n_elements */
+                                VK_SHADER_STAGE_VERTEX_BIT);
+    m_dsg_ptr->set_binding_item(0, /* n_set     */
+                                0, /* n_binding */
+                                m_data_buffer_ptr);
+}
+
+void App::init_framebuffers()
+{
+    bool result;
+
+    m_fbo_ptr = Anvil::Framebuffer::create(m_device_ptr,
+                                           RT_WIDTH,
+                                           RT_HEIGHT,
+                                           1 /* n_layers */);
+
+    result = m_fbo_ptr->add_attachment(m_color_image_view_ptr,
+                                       nullptr /* out_opt_attachment_id_ptr */);
+
+    anvil_assert(result);
+}
+
+void App::init_gfx_pipelines()
+{
+    std::shared_ptr<Anvil::SGPUDevice>              device_locked_ptr       (m_device_ptr);
+    std::shared_ptr<Anvil::GraphicsPipelineManager> gfx_pipeline_manager_ptr(device_locked_ptr->get_graphics_pipeline_manager() );
+    bool                                            result;
+
+    /* Create a renderpass for the pipeline */
+    Anvil::RenderPassAttachmentID render_pass_color_attachment_id;
+    Anvil::SubPassID              render_pass_subpass_id;
+
+    m_renderpass_ptr = Anvil::RenderPass::create(m_device_ptr,
+                                                 nullptr); /* opt_swapchain_ptr */
+
+    result = m_renderpass_ptr->add_color_attachment(VK_FORMAT_R8G8B8A8_UNORM,
+                                                     VK_SAMPLE_COUNT_1_BIT,
+                                                     VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                                     VK_ATTACHMENT_STORE_OP_STORE,
+                                                     VK_IMAGE_LAYOUT_UNDEFINED,
+                                                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                                     false, /* may_alias */
+                                                    &render_pass_color_attachment_id);
+    anvil_assert(result);
+
+    result = m_renderpass_ptr->add_subpass(*m_fs_ptr,
+                                            Anvil::ShaderModuleStageEntryPoint(), /* geometry_shader        */
+                                            Anvil::ShaderModuleStageEntryPoint(), /* tess_control_shader    */
+                                            Anvil::ShaderModuleStageEntryPoint(), /* tess_evaluation_shader */
+                                            *m_vs_ptr,
+                                           &render_pass_subpass_id);
+    anvil_assert(result);
+
+    result = m_renderpass_ptr->get_subpass_graphics_pipeline_id(render_pass_subpass_id,
+                                                                &m_pipeline_id);
+    anvil_assert(result);
+
+    result = m_renderpass_ptr->add_subpass_color_attachment(render_pass_subpass_id,
+                                                             VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                                             render_pass_color_attachment_id,
+                                                             0,        /* location                      */
+                                                             nullptr); /* opt_attachment_resolve_id_ptr */
+    anvil_assert(result);
+
+    result  = gfx_pipeline_manager_ptr->set_pipeline_dsg                      (m_pipeline_id,
+                                                                               m_dsg_ptr);
+    result &= gfx_pipeline_manager_ptr->attach_push_constant_range_to_pipeline(m_pipeline_id,
+                                                                               0, /* offset */
+                                                                               sizeof(float) * 4, /* vec4 */
+                                                                               VK_SHADER_STAGE_FRAGMENT_BIT);
+    anvil_assert(result);
+
+    result = gfx_pipeline_manager_ptr->add_vertex_attribute(m_pipeline_id,
+                                                            0, /* location */
+                                                            VK_FORMAT_R32G32B32A32_SFLOAT,
+                                                            0,                 /* offset_in_bytes */
+                                                            sizeof(float) * 4, /* stride_in_bytes */
+                                                            VK_VERTEX_INPUT_RATE_VERTEX);
+    anvil_assert(result);
+}
+
+void App::init_images()
+{
+    m_color_image_ptr = Anvil::Image::create_nonsparse(m_device_ptr,
+                                                       VK_IMAGE_TYPE_2D,
+                                                       VK_FORMAT_R8G8B8A8_UNORM,
+                                                       VK_IMAGE_TILING_OPTIMAL,
+                                                       VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                                                       RT_WIDTH,
+                                                       RT_HEIGHT,
+                                                       1, /* base_mipmap_depth */
+                                                       1, /* n_layers          */
+                                                       VK_SAMPLE_COUNT_1_BIT,
+                                                       Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                       VK_SHARING_MODE_EXCLUSIVE,
+                                                       false, /* use_full_mipmap_chain             */
+                                                       false, /* should_memory_backing_be_mappable */
+                                                       false, /* should_memory_backing_be_coherent */
+                                                       false, /* is_mutable                        */
+                                                       VK_IMAGE_LAYOUT_UNDEFINED,
+                                                       nullptr); /* mipmaps_ptr */
+
+    m_color_image_view_ptr = Anvil::ImageView::create_2D(m_device_ptr,
+                                                         m_color_image_ptr,
+                                                         0, /* n_base_layer        */
+                                                         0, /* n_base_mipmap_level */
+                                                         1, /* n_mipmaps           */
+                                                         VK_IMAGE_ASPECT_COLOR_BIT,
+                                                         VK_FORMAT_R8G8B8A8_UNORM,
+                                                         VK_COMPONENT_SWIZZLE_R,
+                                                         VK_COMPONENT_SWIZZLE_G,
+                                                         VK_COMPONENT_SWIZZLE_B,
+                                                         VK_COMPONENT_SWIZZLE_A);
+}
+
+void App::init_shaders()
+{
+    std::shared_ptr<Anvil::GLSLShaderToSPIRVGenerator> fragment_shader_ptr;
+    std::shared_ptr<Anvil::ShaderModule>               fragment_shader_module_ptr;
+    std::shared_ptr<Anvil::GLSLShaderToSPIRVGenerator> vertex_shader_ptr;
+    std::shared_ptr<Anvil::ShaderModule>               vertex_shader_module_ptr;
+
+    fragment_shader_ptr = Anvil::GLSLShaderToSPIRVGenerator::create(m_device_ptr,
+                                                                    Anvil::GLSLShaderToSPIRVGenerator::MODE_USE_SPECIFIED_SOURCE,
+                                                                    g_glsl_frag,
+                                                                    Anvil::SHADER_STAGE_FRAGMENT);
+    vertex_shader_ptr   = Anvil::GLSLShaderToSPIRVGenerator::create(m_device_ptr,
+                                                                    Anvil::GLSLShaderToSPIRVGenerator::MODE_USE_SPECIFIED_SOURCE,
+                                                                    g_glsl_vert,
+                                                                    Anvil::SHADER_STAGE_VERTEX);
+
+    fragment_shader_module_ptr = Anvil::ShaderModule::create_from_spirv_generator(m_device_ptr,
+                                                                                  fragment_shader_ptr);
+    vertex_shader_module_ptr   = Anvil::ShaderModule::create_from_spirv_generator(m_device_ptr,
+                                                                                  vertex_shader_ptr);
+
+    m_fs_ptr.reset(
+        new Anvil::ShaderModuleStageEntryPoint(
+            "main",
+            fragment_shader_module_ptr,
+            Anvil::SHADER_STAGE_FRAGMENT)
+    );
+    m_vs_ptr.reset(
+        new Anvil::ShaderModuleStageEntryPoint(
+            "main",
+            vertex_shader_module_ptr,
+            Anvil::SHADER_STAGE_VERTEX)
+    );
+}
+
+void App::init_vulkan()
+{
+    /* Create a Vulkan instance */
+    m_instance_ptr = Anvil::Instance::create(APP_NAME,  /* app_name */
+                                             APP_NAME,  /* engine_name */
+#ifdef ENABLE_VALIDATION
+                                             on_validation_callback,
+#else
+                                             nullptr,
+#endif
+                                             nullptr);   /* validation_proc_user_arg */
+
+    m_physical_device_ptr = m_instance_ptr->get_physical_device(0);
+
+    /* Create a Vulkan device. Command buffers are re-recorded many times, so they need to be resettable. */
+    m_device_ptr = Anvil::SGPUDevice::create(m_physical_device_ptr,
+                                             std::vector<const char*>(), /* extensions */
+                                             std::vector<const char*>(), /* layers     */
+                                             false,                      /* transient_command_buffer_allocs_only */
+                                             true);                      /* support_resettable_command_buffers   */
+}
+
+/** Records N_ITERATIONS render passes, each holding N_DRAWS_PER_ITERATION draw calls, and returns
+ *  the number of draw calls recorded per second.
+ *
+ *  @param in_use_fast_path true to record the draw calls with CommandBufferBase::fast(), false to use
+ *                          the regular record_*() functions.
+ **/
+double App::measure_draws_per_second(bool in_use_fast_path)
+{
+    std::chrono::high_resolution_clock::time_point end_time;
+    std::chrono::high_resolution_clock::time_point start_time;
+
+    for (uint32_t n_iteration = 0;
+                  n_iteration < N_WARMUP_ITERATIONS;
+                ++n_iteration)
+    {
+        record_render_pass(in_use_fast_path);
+    }
+
+    start_time = std::chrono::high_resolution_clock::now();
+    {
+        for (uint32_t n_iteration = 0;
+                      n_iteration < N_ITERATIONS;
+                    ++n_iteration)
+        {
+            record_render_pass(in_use_fast_path);
+        }
+    }
+    end_time = std::chrono::high_resolution_clock::now();
+
+    return double(N_ITERATIONS) * double(N_DRAWS_PER_ITERATION) / std::chrono::duration<double>(end_time - start_time).count();
+}
+
+VkBool32 App::on_validation_callback(VkDebugReportFlagsEXT      message_flags,
+                                     VkDebugReportObjectTypeEXT object_type,
+                                     const char*                layer_prefix,
+                                     const char*                message,
+                                     void*                      user_arg)
+{
+    if ((message_flags & VK_DEBUG_REPORT_ERROR_BIT_EXT) != 0)
+    {
+        fprintf(stderr,
+                "[!] %s\n",
+                message);
+    }
+
+    return false;
+}
+
+/** Records the draw call stream using CommandBufferBase::fast(). Wrapper instances are kept alive by
+ *  the app, so none of them needs to be retained by the command buffer.
+ **/
+void App::record_draws_fast()
+{
+    std::shared_ptr<Anvil::GraphicsPipelineManager> gfx_pipeline_manager_ptr(m_device_ptr.lock()->get_graphics_pipeline_manager() );
+    const float                                     color[4]                = {1.0f, 0.5f, 0.25f, 1.0f};
+    const VkDescriptorSet                           ds_vk                   = m_dsg_ptr->get_descriptor_set(0 /* n_set */)->get_descriptor_set_vk();
+    const VkBuffer                                  index_buffer_vk         = m_index_buffer_ptr->get_buffer();
+    const VkDeviceSize                              mesh_data_buffer_offset = 0;
+    const VkBuffer                                  mesh_data_buffer_vk     = m_mesh_data_buffer_ptr->get_buffer();
+    const VkPipelineLayout                          pipeline_layout_vk      = gfx_pipeline_manager_ptr->get_graphics_pipeline_layout(m_pipeline_id)->get_pipeline_layout();
+    Anvil::CommandBufferBase::FastRecorder          recorder                = m_command_buffer_ptr->fast();
+
+    recorder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                           gfx_pipeline_manager_ptr->get_graphics_pipeline(m_pipeline_id) );
+
+    for (uint32_t n_draw = 0;
+                  n_draw < N_DRAWS_PER_ITERATION;
+                ++n_draw)
+    {
+        recorder.bind_descriptor_sets(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                      pipeline_layout_vk,
+                                      0, /* in_first_set */
+                                      1, /* in_set_count */
+                                     &ds_vk,
+                                      0,        /* in_dynamic_offset_count */
+                                      nullptr); /* in_dynamic_offsets      */
+        recorder.bind_vertex_buffers (0, /* in_first_binding */
+                                      1, /* in_binding_count */
+                                     &mesh_data_buffer_vk,
+                                     &mesh_data_buffer_offset);
+        recorder.bind_index_buffer   (index_buffer_vk,
+                                      0, /* in_offset */
+                                      VK_INDEX_TYPE_UINT16);
+        recorder.push_constants      (pipeline_layout_vk,
+                                      VK_SHADER_STAGE_FRAGMENT_BIT,
+                                      0, /* in_offset */
+                                      sizeof(color),
+                                      color);
+        recorder.draw_indexed        (3, /* in_index_count    */
+                                      1, /* in_instance_count */
+                                      0, /* in_first_index    */
+                                      0, /* in_vertex_offset  */
+                                      0);/* in_first_instance */
+    }
+}
+
+/** Records the draw call stream using the regular record_*() functions. */
+void App::record_draws_legacy()
+{
+    std::shared_ptr<Anvil::GraphicsPipelineManager> gfx_pipeline_manager_ptr(m_device_ptr.lock()->get_graphics_pipeline_manager() );
+    const float                                     color[4]                = {1.0f, 0.5f, 0.25f, 1.0f};
+    std::shared_ptr<Anvil::DescriptorSet>           ds_ptr                  = m_dsg_ptr->get_descriptor_set(0 /* n_set */);
+    const VkDeviceSize                              mesh_data_buffer_offset = 0;
+    std::shared_ptr<Anvil::PipelineLayout>          pipeline_layout_ptr     = gfx_pipeline_manager_ptr->get_graphics_pipeline_layout(m_pipeline_id);
+
+    m_command_buffer_ptr->record_bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                               m_pipeline_id);
+
+    for (uint32_t n_draw = 0;
+                  n_draw < N_DRAWS_PER_ITERATION;
+                ++n_draw)
+    {
+        m_command_buffer_ptr->record_bind_descriptor_sets(VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                                          pipeline_layout_ptr,
+                                                          0, /* firstSet */
+                                                          1, /* setCount */
+                                                         &ds_ptr,
+                                                          0,        /* dynamicOffsetCount */
+                                                          nullptr); /* pDynamicOffsets    */
+        m_command_buffer_ptr->record_bind_vertex_buffers (0, /* startBinding */
+                                                          1, /* bindingCount */
+                                                         &m_mesh_data_buffer_ptr,
+                                                         &mesh_data_buffer_offset);
+        m_command_buffer_ptr->record_bind_index_buffer   (m_index_buffer_ptr,
+                                                          0, /* in_offset */
+                                                          VK_INDEX_TYPE_UINT16);
+        m_command_buffer_ptr->record_push_constants      (pipeline_layout_ptr,
+                                                          VK_SHADER_STAGE_FRAGMENT_BIT,
+                                                          0, /* in_offset */
+                                                          sizeof(color),
+                                                          color);
+        m_command_buffer_ptr->record_draw_indexed        (3, /* in_index_count    */
+                                                          1, /* in_instance_count */
+                                                          0, /* in_first_index    */
+                                                          0, /* in_vertex_offset  */
+                                                          0);/* in_first_instance */
+    }
+}
+
+/** Re-records the command buffer with a single render pass instance holding N_DRAWS_PER_ITERATION draw calls.
+ *
+ *  @param in_use_fast_path true to record the draw calls with CommandBufferBase::fast(), false to use
+ *                          the regular record_*() functions.
+ **/
+void App::record_render_pass(bool in_use_fast_path)
+{
+    VkClearValue attachment_clear_value;
+    VkRect2D     render_area;
+
+    attachment_clear_value.color.float32[0] = 0.0f;
+    attachment_clear_value.color.float32[1] = 0.0f;
+    attachment_clear_value.color.float32[2] = 0.0f;
+    attachment_clear_value.color.float32[3] = 1.0f;
+
+    render_area.extent.height = RT_HEIGHT;
+    render_area.extent.width  = RT_WIDTH;
+    render_area.offset.x      = 0;
+    render_area.offset.y      = 0;
+
+    m_command_buffer_ptr->start_recording(true,   /* one_time_submit          */
+                                          false); /* simultaneous_use_allowed */
+
+    m_command_buffer_ptr->record_begin_render_pass(1, /* in_n_clear_values */
+                                                  &attachment_clear_value,
+                                                   m_fbo_ptr,
+                                                   render_area,
+                                                   m_renderpass_ptr,
+                                                   VK_SUBPASS_CONTENTS_INLINE);
+    {
+        if (in_use_fast_path)
+        {
+            record_draws_fast();
+        }
+        else
+        {
+            record_draws_legacy();
+        }
+    }
+    m_command_buffer_ptr->record_end_render_pass();
+
+    m_command_buffer_ptr->stop_recording();
+}
+
+void App::run()
+{
+    const double fast_draws_per_second   = measure_draws_per_second(true);  /* in_use_fast_path */
+    const double legacy_draws_per_second = measure_draws_per_second(false); /* in_use_fast_path */
+
+    printf("Draw calls recorded per second (%d iterations, %d draws each):\n"
+           "  record_*() functions: %.0f\n"
+           "  fast() interface:     %.0f\n"
+           "  Speed-up:             %.2fx\n",
+           N_ITERATIONS,
+           N_DRAWS_PER_ITERATION,
+           legacy_draws_per_second,
+           fast_draws_per_second,
+           fast_draws_per_second / legacy_draws_per_second);
+}
+
+
+int main()
+{
+    std::shared_ptr<App> app_ptr(new App() );
+
+    app_ptr->init();
+    app_ptr->run();
+
+    #ifdef _DEBUG
+    {
+        app_ptr.reset();
+
+        Anvil::ObjectTracker::get()->check_for_leaks();
+    }
+    #endif
+
+    return 0;
+}
@@ -0,0 +1,388 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a scheduler, which distributes GPU jobs across the universal queue and the compute queues
+ *  exposed by a device, so that compute work (such as post-processing or simulation) can overlap rendering.
+ *
+ *  Apps wrap each frame with begin_frame() and end_frame() calls. In-between, they add jobs. Each job consists
+ *  of zero or more command buffers and declares:
+ *
+ *  - its queue affinity. Universal jobs run on the universal queue. Compute jobs are assigned to the compute
+ *    queue with the lowest estimated load at the time the job is added. If the device exposes no compute
+ *    queues, compute jobs run on the universal queue.
+ *  - explicit dependencies on jobs which have been added earlier in the same frame.
+ *  - buffers and images it accesses, together with access masks, pipeline stages and, for images, the layout
+ *    the image should be in when the job executes.
+ *
+ *  Jobs are submitted in end_frame(), in the order in which they have been added. Since a job can only depend
+ *  on jobs added before it, this order is a valid topological order. For each dependency:
+ *
+ *  - a semaphore is signalled and waited on, if the two jobs run on different queues.
+ *  - a memory barrier is recorded before the dependent job, if the two jobs run on the same queue.
+ *
+ *  Dependencies are also derived from the declared resource accesses: a job depends on the last job which
+ *  wrote to a resource it accesses and, if it writes to the resource itself, on all jobs which have read
+ *  the resource since. Image layout changes are considered writes. Layout transitions are recorded before the
+ *  job which requested the new layout.
+ *
+ *  Resources created with VK_SHARING_MODE_EXCLUSIVE are transferred between queue families whenever a job
+ *  accesses them from a family other than the one which currently owns them. The release barrier is recorded
+ *  after the last job which accessed the resource on the owning family, and the acquire barrier before the job
+ *  which requested the transfer. At the end of each frame, ownership and layout of every resource are
+ *  returned to the family and layout of its first access in the frame. The scheduler therefore expects each
+ *  resource to be owned by that family, and - for images - to be in that layout, when a frame starts.
+ *  Image accesses are tracked per image, so all accesses to an image should use the same subresource range.
+ *
+ *  Hazards between jobs of different frames are not tracked. Resources accessed by jobs of more than one
+ *  frame should either be replicated for each frame in flight (eg. with PerFrame<>), or be synchronized
+ *  by the app.
+ *
+ *  Each job is surrounded by a pair of timestamp queries, unless its queue does not support timestamps.
+ *  Per-queue busy time, which is the length of the union of the queue's job execution intervals, is read back
+ *  once the frame slot is reused - that is, N frames later, N being the number of frames in flight.
+ *
+ *  The scheduler is not thread-safe.
+ **/
+#ifndef MISC_ASYNC_COMPUTE_SCHEDULER_H
+#define MISC_ASYNC_COMPUTE_SCHEDULER_H
+
+#include "../misc/types.h"
+#include <map>
+
+
+namespace Anvil
+{
+    /** Identifies a job added to an AsyncComputeScheduler within a single frame. */
+    typedef uint32_t AsyncComputeJobID;
+
+    /** Defines queues an AsyncComputeScheduler job may be assigned to. */
+    typedef enum
+    {
+        /* The job can run on any compute queue. */
+        ASYNC_COMPUTE_JOB_AFFINITY_COMPUTE,
+
+        /* The job must run on the universal queue. */
+        ASYNC_COMPUTE_JOB_AFFINITY_UNIVERSAL,
+
+        ASYNC_COMPUTE_JOB_AFFINITY_COUNT
+    } AsyncComputeJobAffinity;
+
+    /** Implements an async compute scheduler. For more details, please see the header. */
+    class AsyncComputeScheduler
+    {
+    public:
+        /* Public functions */
+
+        /** Adds a new job to the current frame.
+         *
+         *  @param in_affinity        Queues the job may be assigned to.
+         *  @param in_n_cmd_buffers   Number of command buffers under @param in_cmd_buffer_ptrs. May be 0, in which
+         *                            case the job only acts as a synchronization point.
+         *  @param in_cmd_buffer_ptrs Command buffers to execute. Must have been allocated from a command pool
+         *                            compatible with the queues described by @param in_affinity.
+         *  @param in_cost_estimate   Estimated cost of the job, in arbitrary units. Used to balance the load
+         *                            between compute queues.
+         *  @param out_job_id_ptr     Deref will be set to the ID of the new job. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_job(AsyncComputeJobAffinity                          in_affinity,
+                     uint32_t                                         in_n_cmd_buffers,
+                     std::shared_ptr<Anvil::CommandBufferBase> const* in_cmd_buffer_ptrs,
+                     float                                            in_cost_estimate,
+                     AsyncComputeJobID*                               out_job_id_ptr);
+
+        /** Declares that a job accesses the specified buffer.
+         *
+         *  @param in_job_id      ID of the job.
+         *  @param in_buffer_ptr  Buffer accessed by the job. Must not be nullptr.
+         *  @param in_access_mask Types of accesses the job performs.
+         *  @param in_stage_mask  Pipeline stages which perform the accesses.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_job_buffer_access(AsyncComputeJobID              in_job_id,
+                                   std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                   VkAccessFlags                  in_access_mask,
+                                   VkPipelineStageFlags           in_stage_mask);
+
+        /** Declares that a job must not start executing before another job finishes executing.
+         *
+         *  @param in_job_id            ID of the dependent job.
+         *  @param in_dependency_job_id ID of the job to depend on. Must be lower than @param in_job_id.
+         *  @param in_wait_stage_mask   Pipeline stages of the dependent job which should wait.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_job_dependency(AsyncComputeJobID    in_job_id,
+                                AsyncComputeJobID    in_dependency_job_id,
+                                VkPipelineStageFlags in_wait_stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+        /** Declares that a job accesses the specified image.
+         *
+         *  @param in_job_id            ID of the job.
+         *  @param in_image_ptr         Image accessed by the job. Must not be nullptr.
+         *  @param in_subresource_range Subresource range accessed by the job.
+         *  @param in_layout            Layout the image should be in when the job executes.
+         *  @param in_access_mask       Types of accesses the job performs.
+         *  @param in_stage_mask        Pipeline stages which perform the accesses.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_job_image_access(AsyncComputeJobID             in_job_id,
+                                  std::shared_ptr<Anvil::Image> in_image_ptr,
+                                  VkImageSubresourceRange       in_subresource_range,
+                                  VkImageLayout                 in_layout,
+                                  VkAccessFlags                 in_access_mask,
+                                  VkPipelineStageFlags          in_stage_mask);
+
+        /** Makes a job signal the specified semaphore once it finishes executing. Can be used to make work
+         *  submitted outside the scheduler (eg. presentation) wait on the job.
+         *
+         *  @param in_job_id        ID of the job.
+         *  @param in_semaphore_ptr Semaphore to signal. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_job_signal_semaphore(AsyncComputeJobID                 in_job_id,
+                                      std::shared_ptr<Anvil::Semaphore> in_semaphore_ptr);
+
+        /** Makes a job wait on the specified semaphore. Can be used to make the job wait on work submitted
+         *  outside the scheduler (eg. swapchain image acquisition).
+         *
+         *  @param in_job_id          ID of the job.
+         *  @param in_semaphore_ptr   Semaphore to wait on. Must not be nullptr.
+         *  @param in_wait_stage_mask Pipeline stages of the job which should wait.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_job_wait_semaphore(AsyncComputeJobID                 in_job_id,
+                                    std::shared_ptr<Anvil::Semaphore> in_semaphore_ptr,
+                                    VkPipelineStageFlags              in_wait_stage_mask);
+
+        /** Starts a new frame.
+         *
+         *  Blocks until the frame which has last used the new frame's slot finishes executing, reads back its
+         *  per-queue busy times and recycles the slot's resources.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool begin_frame();
+
+        /** Creates a new AsyncComputeScheduler instance.
+         *
+         *  @param in_device_ptr           Device to use.
+         *  @param in_n_frames_in_flight   Number of frames which can be executed by the GPU at the same time.
+         *                                 Must not be 0.
+         *  @param in_n_max_jobs_per_frame Maximum number of jobs per frame which are surrounded by timestamp
+         *                                 queries. Jobs exceeding the limit are executed, but not measured.
+         *
+         *  @return New instance if successful, nullptr otherwise.
+         **/
+        static std::shared_ptr<AsyncComputeScheduler> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                             uint32_t                         in_n_frames_in_flight,
+                                                             uint32_t                         in_n_max_jobs_per_frame);
+
+        /** Ends the current frame and submits all of its jobs.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool end_frame();
+
+        /** Destructor. Blocks until all frames in flight finish executing. */
+        ~AsyncComputeScheduler();
+
+        /** Returns the index of the queue the specified job of the current frame has been assigned to. */
+        uint32_t get_job_queue_index(AsyncComputeJobID in_job_id) const
+        {
+            return m_jobs.at(in_job_id).n_queue;
+        }
+
+        /** Returns the number of queues jobs can be assigned to. Queue 0 is the universal queue. Queues
+         *  1..N are the device's compute queues.
+         **/
+        uint32_t get_n_queues() const
+        {
+            return static_cast<uint32_t>(m_queues.size() );
+        }
+
+        /** Returns the specified queue. */
+        std::shared_ptr<Anvil::Queue> get_queue(uint32_t in_n_queue) const
+        {
+            return m_queues.at(in_n_queue).queue_ptr;
+        }
+
+        /** Returns the busy time of the specified queue in the most recently read back frame, in milliseconds.
+         *  Returns 0 if the queue does not support timestamps.
+         **/
+        double get_queue_busy_time_ms(uint32_t in_n_queue) const
+        {
+            return m_queues.at(in_n_queue).busy_time_ms;
+        }
+
+        /** Returns the number of jobs executed by the specified queue in the most recently read back frame. */
+        uint32_t get_queue_n_jobs(uint32_t in_n_queue) const
+        {
+            return m_queues.at(in_n_queue).n_jobs;
+        }
+
+    private:
+        /* Private type definitions */
+        typedef struct ResourceAccess
+        {
+            VkAccessFlags                  access_mask;
+            std::shared_ptr<Anvil::Buffer> buffer_ptr;
+            std::shared_ptr<Anvil::Image>  image_ptr;
+            VkImageLayout                  layout;
+            VkPipelineStageFlags           stage_mask;
+            VkImageSubresourceRange        subresource_range;
+        } ResourceAccess;
+
+        typedef struct Job
+        {
+            std::vector<Anvil::BufferBarrier>                       acquire_buffer_barriers;
+            std::vector<Anvil::ImageBarrier>                        acquire_image_barriers;
+            VkPipelineStageFlags                                    acquire_stage_mask;
+            std::vector<std::shared_ptr<Anvil::CommandBufferBase> > cmd_buffers;
+            std::map<AsyncComputeJobID, VkPipelineStageFlags>       dependencies;
+            bool                                                    is_ownership_return_job;
+            std::vector<Anvil::ImageBarrier>                        layout_transition_barriers;
+            VkPipelineStageFlags                                    layout_transition_stage_mask;
+            uint32_t                                                n_queue;
+            std::vector<Anvil::BufferBarrier>                       release_buffer_barriers;
+            std::vector<Anvil::ImageBarrier>                        release_image_barriers;
+            VkPipelineStageFlags                                    release_stage_mask;
+            std::vector<ResourceAccess>                             resource_accesses;
+            VkPipelineStageFlags                                    same_queue_wait_stage_mask;
+            std::vector<std::shared_ptr<Anvil::Semaphore> >         signal_semaphores;
+            std::vector<VkPipelineStageFlags>                       wait_stage_masks;
+            std::vector<std::shared_ptr<Anvil::Semaphore> >         wait_semaphores;
+
+            Job()
+            {
+                acquire_stage_mask           = 0;
+                is_ownership_return_job      = false;
+                layout_transition_stage_mask = 0;
+                n_queue                      = 0;
+                release_stage_mask           = 0;
+                same_queue_wait_stage_mask   = 0;
+            }
+        } Job;
+
+        typedef struct FrameSlot
+        {
+            std::vector<std::shared_ptr<Anvil::PrimaryCommandBuffer> > cmd_buffers   [QUEUE_FAMILY_TYPE_COUNT];
+            std::shared_ptr<Anvil::CommandPool>                        command_pools [QUEUE_FAMILY_TYPE_COUNT];
+            std::vector<std::shared_ptr<Anvil::Fence> >                fences;
+            std::vector<uint32_t>                                      job_queue_indices;
+            uint32_t                                                   n_used_cmd_buffers[QUEUE_FAMILY_TYPE_COUNT];
+            uint32_t                                                   n_used_semaphores;
+            std::shared_ptr<Anvil::QueryPool>                          query_pool_ptr;
+            std::vector<std::shared_ptr<Anvil::Semaphore> >            semaphores;
+
+            FrameSlot()
+            {
+                for (uint32_t n_family_type = 0;
+                              n_family_type < QUEUE_FAMILY_TYPE_COUNT;
+                            ++n_family_type)
+                {
+                    n_used_cmd_buffers[n_family_type] = 0;
+                }
+
+                n_used_semaphores = 0;
+            }
+        } FrameSlot;
+
+        typedef struct QueueInfo
+        {
+            double                        busy_time_ms;
+            Anvil::QueueFamilyType        family_type;
+            float                         load;
+            uint32_t                      n_jobs;
+            std::shared_ptr<Anvil::Queue> queue_ptr;
+            bool                          supports_timestamps;
+
+            QueueInfo()
+            {
+                busy_time_ms        = 0.0;
+                family_type         = Anvil::QUEUE_FAMILY_TYPE_UNDEFINED;
+                load                = 0.0f;
+                n_jobs              = 0;
+                supports_timestamps = false;
+            }
+        } QueueInfo;
+
+        typedef struct ResourceState
+        {
+            ResourceAccess                 first_access;
+            uint32_t                       first_n_queue;
+            uint32_t                       first_queue_family_index;
+            bool                           is_exclusive;
+            VkAccessFlags                  last_access_mask;
+            AsyncComputeJobID              last_access_job_id;
+            VkPipelineStageFlags           last_stage_mask;
+            AsyncComputeJobID              last_writer_job_id;
+            VkImageLayout                  layout;
+            uint32_t                       owner_queue_family_index;
+            std::vector<AsyncComputeJobID> reader_job_ids;
+        } ResourceState;
+
+        /* Private functions */
+        AsyncComputeScheduler(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                              uint32_t                         in_n_frames_in_flight,
+                              uint32_t                         in_n_max_jobs_per_frame);
+
+        AsyncComputeScheduler           (const AsyncComputeScheduler&);
+        AsyncComputeScheduler& operator=(const AsyncComputeScheduler&);
+
+        void                                         add_dependency         (AsyncComputeJobID                          in_job_id,
+                                                                             AsyncComputeJobID                          in_dependency_job_id,
+                                                                             VkPipelineStageFlags                       in_wait_stage_mask);
+        std::shared_ptr<Anvil::PrimaryCommandBuffer> get_cmd_buffer         (Anvil::QueueFamilyType                     in_family_type);
+        std::shared_ptr<Anvil::Semaphore>            get_semaphore          ();
+        bool                                         init                   ();
+        bool                                         is_job_measured        (AsyncComputeJobID                          in_job_id,
+                                                                             uint32_t                                   in_n_queue) const;
+        void                                         process_resource_access(AsyncComputeJobID                          in_job_id,
+                                                                             const ResourceAccess&                      in_access,
+                                                                             std::map<const void*, ResourceState>*      in_resource_states_ptr);
+        bool                                         record_epilogue        (AsyncComputeJobID                          in_job_id,
+                                                                             std::shared_ptr<Anvil::CommandBufferBase>* out_cmd_buffer_ptr);
+        bool                                         record_prologue        (AsyncComputeJobID                          in_job_id,
+                                                                             std::shared_ptr<Anvil::CommandBufferBase>* out_cmd_buffer_ptr);
+        void                                         resolve_frame          (FrameSlot*                                 in_frame_slot_ptr);
+        bool                                         wait_for_frame         (FrameSlot*                                 in_frame_slot_ptr);
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice> m_device_ptr;
+        std::vector<FrameSlot>           m_frame_slots;
+        bool                             m_is_frame_active;
+        std::vector<Job>                 m_jobs;
+        uint32_t                         m_n_current_frame_slot;
+        uint32_t                         m_n_frames_in_flight;
+        uint32_t                         m_n_max_jobs_per_frame;
+        std::vector<QueueInfo>           m_queues;
+        double                           m_timestamp_period_ns;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_ASYNC_COMPUTE_SCHEDULER_H */
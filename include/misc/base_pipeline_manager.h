@@ -39,7 +39,14 @@
 
 #include "../misc/debug.h"
 #include "../misc/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <vector>
 
 namespace Anvil
@@ -52,6 +59,37 @@ namespace Anvil
 
        typedef uint32_t ShaderIndex;
 
+       /** Describes data to assign to a single specialization constant of a pipeline variant.
+        *  Please see get_pipeline_variant() for more details.
+        **/
+       typedef struct SpecializationConstantValue
+       {
+           uint32_t           constant_id;
+           const void*        data_ptr;
+           uint32_t           n_data_bytes;
+           Anvil::ShaderStage shader_stage;
+
+           /** Constructor.
+            *
+            *  @param in_shader_stage Shader stage, with which the specialization constant is associated. The base
+            *                         pipeline must define a shader for the stage.
+            *  @param in_constant_id  ID of the specialization constant to assign data for.
+            *  @param in_n_data_bytes Number of bytes under @param in_data_ptr. Must not be 0.
+            *  @param in_data_ptr     Data to assign to the constant. Must not be nullptr. Only read for the duration
+            *                         of the call, to which the descriptor is passed.
+            **/
+           SpecializationConstantValue(Anvil::ShaderStage in_shader_stage,
+                                       uint32_t           in_constant_id,
+                                       uint32_t           in_n_data_bytes,
+                                       const void*        in_data_ptr)
+           {
+               constant_id  = in_constant_id;
+               data_ptr     = in_data_ptr;
+               n_data_bytes = in_n_data_bytes;
+               shader_stage = in_shader_stage;
+           }
+       } SpecializationConstantValue;
+
        /* Public functions */
 
        /** Constructor. Initializes base layer of a pipeline manager.
@@ -127,6 +165,27 @@ namespace Anvil
            return static_cast<uint32_t>(m_pipelines.size() );
        }
 
+       /** Returns the number of worker threads bake() splits dirty pipelines across. 0 indicates all dirty
+        *  pipelines are baked with a single vkCreate*Pipelines() call on the calling thread.
+        **/
+       uint32_t get_n_bake_worker_threads() const
+       {
+           return m_n_bake_worker_threads;
+       }
+
+       /** Returns the time it took to create the Vulkan pipeline object for the specified pipeline, the last time
+        *  it was baked. Compile times are only measured if the pipeline was baked in parallel mode, since a batched
+        *  vkCreate*Pipelines() call does not expose per-pipeline timings.
+        *
+        *  @param pipeline_id          ID of the pipeline to return the compile time for.
+        *  @param out_bake_time_ms_ptr Deref will be set to the compile time, in milliseconds. Must not be nullptr.
+        *
+        *  @return true if successful, false if the pipeline ID is invalid or no compile time has been measured
+        *          for the pipeline.
+        **/
+       bool get_pipeline_bake_time(PipelineID pipeline_id,
+                                   double*    out_bake_time_ms_ptr) const;
+
        /** Returns ID of a pipeline at user-specified index.
         *
         *  @param n_pipeline          Index of the pipeline to return ID of.
@@ -154,6 +213,44 @@ namespace Anvil
        bool set_pipeline_bakeability(PipelineID pipeline_id,
                                      bool       bakeable);
 
+       /** Enables or disables the parallel bake mode.
+        *
+        *  In parallel mode, bake() splits dirty pipelines across a pool of worker threads, each of which creates
+        *  pipelines with separate vkCreate*Pipelines() calls issued against the manager's pipeline cache. Workers
+        *  pull pipelines from a shared queue, so a single slow pipeline does not hold back the others. Derivative
+        *  pipelines are only created after their base pipelines have been baked. The compile time of each pipeline
+        *  can be retrieved with get_pipeline_bake_time().
+        *
+        *  The calling thread acts as one of the workers, so a value of 1 bakes pipelines one at a time on the
+        *  calling thread, which is mostly useful for profiling.
+        *
+        *  Worker threads also run async bakes, if the manager supports them. At least one worker thread is
+        *  spawned for these, even if the parallel mode is disabled.
+        *
+        *  @param n_worker_threads Number of threads to bake pipelines with. 0 (default) disables the parallel mode.
+        **/
+       void set_n_bake_worker_threads(uint32_t n_worker_threads)
+       {
+           m_n_bake_worker_threads = n_worker_threads;
+       }
+
+       /** Sets the maximum number of pipeline variants the manager caches. When the limit is exceeded, least
+        *  recently used variants are evicted. If the new limit is lower than the number of variants currently
+        *  cached, excess variants are evicted immediately.
+        *
+        *  Evicted variants are deleted. Their Vulkan pipeline objects may still be used by command buffers in
+        *  flight, so they are never released right away. If the device's deferred deletion queue is enabled, they
+        *  are handed over to it, tagged with the current serial. Otherwise, the manager retires them: a fence is
+        *  submitted to each queue which has been used so far, and the pipeline objects are released once all of
+        *  these fences have been signalled.
+        *
+        *  The ID of an evicted variant becomes invalid. IDs are never reused, so functions called with it fail.
+        *  Callers should not hold on to variant IDs, and should call get_pipeline_variant() again instead.
+        *
+        *  @param n_max_variants New limit. Must be at least 1. Default value is 256.
+        **/
+       void set_max_n_pipeline_variants(uint32_t n_max_variants);
+
     protected:
        /* Protected type declarations */
        struct SpecializationConstant
@@ -189,6 +286,45 @@ namespace Anvil
        typedef std::vector<SpecializationConstant>            SpecializationConstants;
        typedef std::map<ShaderIndex, SpecializationConstants> ShaderIndexToSpecializationConstantsMap;
 
+       /** Owns a Vulkan pipeline object, which may be shared by multiple pipelines with identical state. The Vulkan
+        *  object is released when the last pipeline referring to it is released or re-baked.
+        *
+        *  The pipeline layout and shader modules the pipeline has been created with are kept alive for as long as
+        *  the pipeline object is, so that their Vulkan handles cannot be reused by other objects in the meantime.
+        **/
+       typedef struct SharedVkPipeline
+       {
+           std::weak_ptr<BaseDevice>                   device_ptr;
+           std::shared_ptr<PipelineLayout>             layout_ptr;
+           VkPipeline                                  pipeline;
+           std::vector<std::shared_ptr<ShaderModule> > shader_module_ptrs;
+
+           /** Constructor.
+            *
+            *  @param in_device_ptr         Device the pipeline has been created for.
+            *  @param in_pipeline           Vulkan pipeline handle to take ownership of. Must not be VK_NULL_HANDLE.
+            *  @param in_layout_ptr         Pipeline layout the pipeline has been created with.
+            *  @param in_shader_module_ptrs Shader modules the pipeline has been created with.
+            **/
+           SharedVkPipeline(std::weak_ptr<Anvil::BaseDevice>                   in_device_ptr,
+                            VkPipeline                                         in_pipeline,
+                            std::shared_ptr<PipelineLayout>                    in_layout_ptr,
+                            const std::vector<std::shared_ptr<ShaderModule> >& in_shader_module_ptrs)
+           {
+               device_ptr         = in_device_ptr;
+               layout_ptr         = in_layout_ptr;
+               pipeline           = in_pipeline;
+               shader_module_ptrs = in_shader_module_ptrs;
+           }
+
+           /** Destructor. Releases the Vulkan pipeline object. */
+           ~SharedVkPipeline();
+
+       private:
+           SharedVkPipeline           (const SharedVkPipeline&);
+           SharedVkPipeline& operator=(const SharedVkPipeline&);
+       } SharedVkPipeline;
+
        /** Internal pipeline object descriptor */
        typedef struct Pipeline
        {
@@ -206,13 +342,15 @@ namespace Anvil
            bool                            layout_dirty;
            std::shared_ptr<PipelineLayout> layout_ptr;
 
-           bool             allow_derivatives;
-           VkPipeline       baked_pipeline;
-           bool             dirty;
-           bool             disable_optimizations;
-           bool             is_bakeable;
-           bool             is_derivative;
-           bool             is_proxy;
+           bool                              allow_derivatives;
+           VkPipeline                        baked_pipeline;
+           double                            bake_time_ms;
+           std::shared_ptr<SharedVkPipeline> shared_baked_pipeline_ptr;
+           bool                              dirty;
+           bool                              disable_optimizations;
+           bool                              is_bakeable;
+           bool                              is_derivative;
+           bool                              is_proxy;
 
            /** Stores the specified shader modules and associates an empty specialization constant map for each
             *  shader.
@@ -237,7 +375,9 @@ namespace Anvil
                }
            }
 
-           /** Releases pipeline & pipeline layout instances **/
+           /** Releases the pipeline instance, or the reference to the shared pipeline instance, if the pipeline
+            *  has been deduplicated.
+            **/
            void release_vulkan_objects();
 
            /** Constructor. Should be used to initialize a derivative pipeline object from an existing
@@ -263,6 +403,7 @@ namespace Anvil
                     const ShaderModuleStageEntryPoint* in_shader_module_stage_entrypoint_ptrs)
            {
                allow_derivatives     = in_allow_derivatives;
+               bake_time_ms          = -1.0;
                baked_pipeline        = VK_NULL_HANDLE;
                base_pipeline         = VK_NULL_HANDLE;
                base_pipeline_ptr     = in_base_pipeline_ptr;
@@ -302,6 +443,7 @@ namespace Anvil
                     const ShaderModuleStageEntryPoint* in_shader_module_stage_entrypoint_ptrs)
            {
                allow_derivatives     = in_allow_derivatives;
+               bake_time_ms          = -1.0;
                baked_pipeline        = VK_NULL_HANDLE;
                base_pipeline         = in_base_pipeline;
                device_ptr            = in_device_ptr;
@@ -338,6 +480,7 @@ namespace Anvil
                     bool                               in_is_proxy)
            {
                allow_derivatives     = in_allow_derivatives;
+               bake_time_ms          = -1.0;
                baked_pipeline        = VK_NULL_HANDLE;
                base_pipeline         = VK_NULL_HANDLE;
                device_ptr            = in_device_ptr;
@@ -368,6 +511,82 @@ namespace Anvil
 
        typedef std::map<PipelineID, std::shared_ptr<Pipeline> > Pipelines;
 
+       /** Serialized base pipeline ID and specialization constant values, identifying a pipeline variant. */
+       typedef std::vector<unsigned char> PipelineVariantKey;
+
+       /** Describes a pipeline variant cached by get_pipeline_variant() */
+       typedef struct PipelineVariant
+       {
+           PipelineID         base_pipeline_id;
+           PipelineVariantKey key;
+           uint64_t           key_hash;
+           PipelineID         pipeline_id;
+
+           /** Constructor.
+            *
+            *  @param in_base_pipeline_id ID of the pipeline the variant has been derived from.
+            *  @param in_key              Key of the variant.
+            *  @param in_key_hash         Hash of @param in_key.
+            *  @param in_pipeline_id      ID of the variant pipeline.
+            **/
+           PipelineVariant(PipelineID                in_base_pipeline_id,
+                           const PipelineVariantKey& in_key,
+                           uint64_t                  in_key_hash,
+                           PipelineID                in_pipeline_id)
+           {
+               base_pipeline_id = in_base_pipeline_id;
+               key              = in_key;
+               key_hash         = in_key_hash;
+               pipeline_id      = in_pipeline_id;
+           }
+       } PipelineVariant;
+
+       /* Most recently used variants come first */
+       typedef std::list<PipelineVariant>                                   PipelineVariants;
+       typedef std::map<uint64_t, std::vector<PipelineVariants::iterator> > PipelineVariantsByHash;
+
+       /** Function prototype of a callback, which creates a single Vulkan pipeline object for the parallel bake mode.
+        *  Called from multiple threads at the same time.
+        *
+        *  @param user_arg          User argument, as specified for the create_pipelines_in_parallel() call.
+        *  @param n_item            Index of the item to create a pipeline object for.
+        *  @param base_pipeline     If not VK_NULL_HANDLE, handle of the base pipeline the new pipeline should be
+        *                           derived from.
+        *  @param out_pipeline_ptr  Deref should be set to the created pipeline handle. Never nullptr.
+        *
+        *  @return Result of the vkCreate*Pipelines() call.
+        **/
+       typedef VkResult (*PFNCREATEPIPELINEPROC)(void*       user_arg,
+                                                 uint32_t    n_item,
+                                                 VkPipeline  base_pipeline,
+                                                 VkPipeline* out_pipeline_ptr);
+
+       /** Function prototype of a job run by one of the bake worker threads. Please see push_bake_worker_job().
+        *
+        *  @param user_arg User argument, as specified for the job.
+        **/
+       typedef void (*PFNBAKEWORKERJOBPROC)(void* user_arg);
+
+       /** Describes a job pushed with push_bake_worker_job(). */
+       typedef struct BakeWorkerJob
+       {
+           std::atomic<bool>    is_complete;
+           PFNBAKEWORKERJOBPROC pfn_job_proc;
+           void*                user_arg;
+
+           BakeWorkerJob()
+               :is_complete (false),
+                pfn_job_proc(nullptr),
+                user_arg    (nullptr)
+           {
+               /* Stub */
+           }
+
+       private:
+           BakeWorkerJob           (const BakeWorkerJob&);
+           BakeWorkerJob& operator=(const BakeWorkerJob&);
+       } BakeWorkerJob;
+
        /* Protected functions */
 
        /** Registers a new derivative pipeline which is going to inherit state from another pipeline object,
@@ -455,6 +674,22 @@ namespace Anvil
                                  const ShaderModuleStageEntryPoint* shader_module_stage_entrypoint_ptrs,
                                  PipelineID*                        out_pipeline_id_ptr);
 
+       /** Registers a new pipeline variant: a derivative pipeline, which uses the same shader stages as the base
+        *  pipeline and starts off with a copy of the base pipeline's descriptor set group, push constant ranges
+        *  and specialization constants. Called by get_pipeline_variant() on a cache miss.
+        *
+        *  Managers, which store additional per-pipeline state, should override this function to copy that
+        *  state, too.
+        *
+        *  @param base_pipeline_id    ID of the pipeline to derive the variant from. Must not describe a proxy
+        *                             pipeline. The pipeline must have been created with derivatives allowed.
+        *  @param out_pipeline_id_ptr Deref will be set to the ID of the new pipeline. Must not be nullptr.
+        *
+        *  @return true if successful, false otherwise.
+        **/
+       virtual bool add_pipeline_variant(PipelineID  base_pipeline_id,
+                                         PipelineID* out_pipeline_id_ptr);
+
        /** Adds a new specialization constant to the specified pipeline object.
         *
         *  This function marks the pipeline as dirty, meaning it will be rebaked at the next get_() call.
@@ -491,13 +726,45 @@ namespace Anvil
                                         std::vector<VkSpecializationMapEntry>* out_specialization_map_entry_vk_vector,
                                         VkSpecializationInfo*                  out_specialization_info_ptr);
 
+       /** Creates pipeline objects for all specified items, using @param n_threads threads. Items are processed in
+        *  waves: an item becomes ready for baking after its base item, if any, has been baked.
+        *
+        *  The calling thread bakes items, too. It is helped by a pool of worker threads, which are spawned
+        *  on first use and kept alive until the manager is destroyed. Worker threads busy with other jobs do
+        *  not hold the call back, since the calling thread bakes all items nobody else has picked up.
+        *
+        *  Can be called from a bake worker job.
+        *
+        *  @param n_threads                Number of threads to use, including the calling thread. Must not be 0.
+        *  @param n_items                  Number of items to create pipelines for.
+        *  @param base_item_indices        Array of @param n_items indices of base items, or -1 for items which
+        *                                  do not derive from another item baked in this call. Must not be nullptr.
+        *  @param pfn_create_pipeline_proc Callback to create each pipeline with. Must not be nullptr.
+        *  @param user_arg                 User argument to pass to @param pfn_create_pipeline_proc.
+        *  @param out_pipelines_ptr        Array of @param n_items pipeline handles to fill. Must not be nullptr.
+        *  @param out_bake_times_ms_ptr    Array of @param n_items compile times (in ms) to fill. Must not be nullptr.
+        *
+        *  @return true if all pipelines have been created successfully, false otherwise. In the latter case, any
+        *          pipelines created by the call are released, and all handles are set to VK_NULL_HANDLE.
+        **/
+       bool create_pipelines_in_parallel(uint32_t              n_threads,
+                                         uint32_t              n_items,
+                                         const int32_t*        base_item_indices,
+                                         PFNCREATEPIPELINEPROC pfn_create_pipeline_proc,
+                                         void*                 user_arg,
+                                         VkPipeline*           out_pipelines_ptr,
+                                         double*               out_bake_times_ms_ptr);
+
        /** Deletes an existing pipeline.
+        *
+        *  If the pipeline is a cached pipeline variant, it is removed from the cache. If other pipeline variants
+        *  have been derived from the pipeline, these are deleted, too.
         *
         *  @param pipeline_id ID of a pipeline to delete.
         *
         *  @return true if successful, false otherwise.
         **/
-       bool delete_pipeline(PipelineID pipeline_id);
+       virtual bool delete_pipeline(PipelineID pipeline_id);
 
        /** Retrieves a VkPipeline instance associated with the specified pipeline ID.
         *
@@ -523,19 +790,148 @@ namespace Anvil
         **/
        std::shared_ptr<Anvil::PipelineLayout> get_pipeline_layout(PipelineID pipeline_id);
 
+       /** Returns a variant of the specified pipeline, which uses the specified specialization constant values.
+        *
+        *  Variants are cached. The first request for a given set of values creates a new derivative pipeline
+        *  from the base pipeline, using add_pipeline_variant(), and assigns the values to it. Constants already
+        *  defined for the base pipeline are overwritten, others are added. Subsequent requests for the same base
+        *  pipeline and values, specified in the same order, return the same pipeline ID until the variant is
+        *  evicted from the cache. Once evicted, the variant's ID is invalid, and a later request for the same
+        *  values returns a new variant. Please see set_max_n_pipeline_variants() for more details.
+        *
+        *  Variants copy the state of the base pipeline at creation time. Any later changes made to the base
+        *  pipeline are not propagated to variants, which have already been created.
+        *
+        *  The function does not bake the variant. This happens at the next bake() or get_*() call.
+        *
+        *  @param base_pipeline_id            ID of the pipeline to derive the variant from. Must not describe a
+        *                                     proxy pipeline. The pipeline must have been created with derivatives
+        *                                     allowed.
+        *  @param n_values                    Number of items available under @param value_ptrs.
+        *  @param value_ptrs                  Array of @param n_values specialization constant values. May only be
+        *                                     nullptr if @param n_values is 0.
+        *  @param out_variant_pipeline_id_ptr Deref will be set to the ID of the variant pipeline. Must not be nullptr.
+        *
+        *  @return true if successful, false otherwise.
+        **/
+       bool get_pipeline_variant(PipelineID                         base_pipeline_id,
+                                 uint32_t                           n_values,
+                                 const SpecializationConstantValue* value_ptrs,
+                                 PipelineID*                        out_variant_pipeline_id_ptr);
+
+       /** Marks the specified pipeline as dirty and adds it to the list of pipelines bake() needs to consider.
+        *
+        *  @param pipeline_id ID of the pipeline to mark as dirty. Must describe an existing pipeline.
+        **/
+       void mark_pipeline_dirty(PipelineID pipeline_id);
+
+       /** Schedules the specified job for execution on one of the bake worker threads. Jobs are started in the
+        *  order they were pushed in. The number of jobs running at the same time is bounded by the number of
+        *  worker threads, which is max(1, get_n_bake_worker_threads() - 1) or the largest number of threads any
+        *  preceding parallel bake has used.
+        *
+        *  @param in_job_ptr Job to run. pfn_job_proc must not be nullptr. The descriptor must stay alive until
+        *                    the job completes. Please see wait_for_bake_worker_job().
+        **/
+       void push_bake_worker_job(BakeWorkerJob* in_job_ptr);
+
+       /** Blocks until the specified job, pushed with push_bake_worker_job(), completes.
+        *
+        *  @param in_job_ptr Job to wait for. Must not be nullptr.
+        **/
+       void wait_for_bake_worker_job(BakeWorkerJob* in_job_ptr);
+
        /* Protected members */
        std::weak_ptr<Anvil::BaseDevice> m_device_ptr;
+       uint32_t                         m_n_bake_worker_threads;
        uint32_t                         m_pipeline_counter;
        Pipelines                        m_pipelines;
 
+       /* IDs of pipelines which may need to be baked, so that bake() does not need to iterate over all pipelines.
+        * May also hold IDs of pipelines which have been deleted, or which cannot be baked yet. */
+       std::set<PipelineID> m_dirty_pipeline_ids;
+
+       uint32_t               m_max_n_pipeline_variants;
+       PipelineVariants       m_pipeline_variants;
+       PipelineVariantsByHash m_pipeline_variants_by_hash;
+
        std::shared_ptr<Anvil::PipelineCache>  m_pipeline_cache_ptr;
        std::shared_ptr<PipelineLayoutManager> m_pipeline_layout_manager_ptr;
        bool                                   m_use_pipeline_cache;
 
 private:
+       /* Private type definitions */
+
+       /** State of a create_pipelines_in_parallel() call, shared by the calling thread and bake worker threads. */
+       typedef struct BakeWave
+       {
+           const int32_t*        base_item_indices;
+           std::atomic<bool>     has_failed;
+           uint32_t              n_busy_workers; /* guarded by m_bake_workers_mutex */
+           std::atomic<uint32_t> n_next_wave_item;
+           double*               out_bake_times_ms_ptr;
+           VkPipeline*           out_pipelines_ptr;
+           PFNCREATEPIPELINEPROC pfn_create_pipeline_proc;
+           void*                 user_arg;
+           std::vector<uint32_t> wave_items;
+
+           BakeWave()
+               :base_item_indices       (nullptr),
+                has_failed              (false),
+                n_busy_workers          (0),
+                n_next_wave_item        (0),
+                out_bake_times_ms_ptr   (nullptr),
+                out_pipelines_ptr       (nullptr),
+                pfn_create_pipeline_proc(nullptr),
+                user_arg                (nullptr)
+           {
+               /* Stub */
+           }
+       } BakeWave;
+
+       /** An item of the bake worker threads' job queue. Exactly one of the pointers is not nullptr. */
+       typedef struct BakeWorkerQueueItem
+       {
+           BakeWorkerJob* job_ptr;
+           BakeWave*      wave_ptr;
+
+           BakeWorkerQueueItem(BakeWorkerJob* in_job_ptr,
+                               BakeWave*      in_wave_ptr)
+           {
+               job_ptr  = in_job_ptr;
+               wave_ptr = in_wave_ptr;
+           }
+       } BakeWorkerQueueItem;
+
+       /** Pipeline variants evicted while the deferred deletion queue was disabled. Please see
+        *  evict_pipeline_variants() for more details. */
+       typedef struct RetiredPipelineVariants
+       {
+           std::vector<std::shared_ptr<Anvil::Fence> > fence_ptrs;
+           std::vector<std::shared_ptr<Pipeline> >     pipeline_ptrs;
+       } RetiredPipelineVariants;
+
        /* Private functions */
        BasePipelineManager& operator=(const BasePipelineManager&);
        BasePipelineManager           (const BasePipelineManager&);
+
+       void        bake_worker_thread_entrypoint();
+       void        evict_pipeline_variants      ();
+       static void process_bake_wave            (BakeWave* in_wave_ptr);
+       void        release_retired_pipelines    (bool      in_should_wait);
+       void        start_bake_worker_threads    (uint32_t  in_n_threads);
+
+       /* Private members */
+       std::condition_variable         m_bake_worker_job_done_cv;
+       std::deque<BakeWorkerQueueItem> m_bake_worker_jobs;
+       std::condition_variable         m_bake_worker_jobs_cv;
+       std::vector<std::thread>        m_bake_worker_threads;
+       std::mutex                      m_bake_workers_mutex;
+       bool                            m_bake_workers_terminating;
+
+       bool                                    m_is_retiring_pipeline_variants;
+       std::deque<RetiredPipelineVariants>     m_retired_pipeline_variants;
+       std::vector<std::shared_ptr<Pipeline> > m_retiring_pipeline_ptrs;
     };
 }; /* Vulkan namespace */
 
@@ -0,0 +1,512 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a frame graph renderer.
+ *
+ *  Apps describe a frame as a set of passes. Each pass declares the images and buffers it reads and writes,
+ *  and provides a callback which records the pass commands. At baking time, the renderer:
+ *
+ *  - culls passes whose results do not contribute to the frame outputs.
+ *  - orders the remaining passes, respecting the dependencies implied by declaration order.
+ *  - works out life-times of transient resources and places those which are never alive at the same
+ *    time in overlapping memory regions, using MemoryAllocator.
+ *  - creates render passes and framebuffers for graphics passes.
+ *
+ *  At recording time, the renderer inserts the minimal set of barriers needed to safely execute the
+ *  passes by using resource state tracking provided by command buffers. See
+ *  CommandBufferBase::record_transition() for more details.
+ *
+ *  Accesses to a given resource are ordered by the order, in which the passes have been declared.
+ *  A pass which reads a resource depends on the passes declared earlier which write to it.
+ **/
+#ifndef MISC_DAG_RENDERER_H
+#define MISC_DAG_RENDERER_H
+
+#include "../misc/types.h"
+#include <map>
+
+
+namespace Anvil
+{
+    /** ID of a DAGRenderer pass */
+    typedef uint32_t DAGRendererPassID;
+
+    /** ID of a DAGRenderer resource */
+    typedef uint32_t DAGRendererResourceID;
+
+    /** Callback used by DAGRenderer to record commands of a pass.
+     *
+     *  For graphics passes, the render pass has already been started by the time the callback is invoked,
+     *  and will be ended by the renderer after the callback returns. All resources declared by the pass
+     *  have been transitioned to the requested usages.
+     *
+     *  @param renderer_ptr   Renderer invoking the callback.
+     *  @param pass_id        ID of the pass whose commands should be recorded.
+     *  @param cmd_buffer_ptr Command buffer to record the commands to.
+     *  @param user_arg       User argument, as specified at pass creation time.
+     **/
+    typedef void (*PFNDAGRENDERERPASSPROC)(Anvil::DAGRenderer*                          renderer_ptr,
+                                           DAGRendererPassID                            pass_id,
+                                           std::shared_ptr<Anvil::PrimaryCommandBuffer> cmd_buffer_ptr,
+                                           void*                                        user_arg);
+
+    /** Implements a frame graph renderer. For more details, please see the header. */
+    class DAGRenderer
+    {
+    public:
+        /* Public functions */
+
+        /** Adds a new compute pass to the graph.
+         *
+         *  @param in_pfn_record_proc Callback to use for recording pass commands. Must not be nullptr.
+         *  @param in_user_arg        User argument to pass with the callback. May be nullptr.
+         *  @param out_pass_id_ptr    Deref will be set to the ID of the new pass. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_compute_pass(PFNDAGRENDERERPASSPROC in_pfn_record_proc,
+                              void*                  in_user_arg,
+                              DAGRendererPassID*     out_pass_id_ptr);
+
+        /** Adds a new graphics pass to the graph.
+         *
+         *  Each graphics pass is assigned a render pass with a single subpass. A graphics pipeline is created
+         *  for the subpass at bake() time. Its ID can be retrieved by calling get_graphics_pass_pipeline_id()
+         *  afterward, so that the pipeline can be further configured by the app.
+         *
+         *  Please see RenderPass::add_subpass() for more details regarding the shader entrypoint arguments.
+         *
+         *  @param in_pfn_record_proc Callback to use for recording pass commands. Must not be nullptr.
+         *  @param in_user_arg        User argument to pass with the callback. May be nullptr.
+         *  @param out_pass_id_ptr    Deref will be set to the ID of the new pass. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_graphics_pass(const ShaderModuleStageEntryPoint& in_fragment_shader_entrypoint,
+                               const ShaderModuleStageEntryPoint& in_geometry_shader_entrypoint,
+                               const ShaderModuleStageEntryPoint& in_tess_control_shader_entrypoint,
+                               const ShaderModuleStageEntryPoint& in_tess_evaluation_shader_entrypoint,
+                               const ShaderModuleStageEntryPoint& in_vertex_shader_entrypoint,
+                               PFNDAGRENDERERPASSPROC             in_pfn_record_proc,
+                               void*                              in_user_arg,
+                               DAGRendererPassID*                 out_pass_id_ptr);
+
+        /** Declares that a pass reads a buffer.
+         *
+         *  @param in_pass_id     ID of the pass to update.
+         *  @param in_resource_id ID of a buffer resource.
+         *  @param in_usage       Usage the buffer is going to be accessed with. Must describe a read-only access.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_pass_buffer_input(DAGRendererPassID     in_pass_id,
+                                   DAGRendererResourceID in_resource_id,
+                                   Anvil::ResourceUsage  in_usage);
+
+        /** Declares that a pass writes to a buffer.
+         *
+         *  @param in_pass_id     ID of the pass to update.
+         *  @param in_resource_id ID of a buffer resource.
+         *  @param in_usage       Usage the buffer is going to be accessed with.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_pass_buffer_output(DAGRendererPassID     in_pass_id,
+                                    DAGRendererResourceID in_resource_id,
+                                    Anvil::ResourceUsage  in_usage);
+
+        /** Declares that a graphics pass renders to an image. The image is bound as a color attachment at location
+         *  equal to the number of color outputs declared for the pass so far.
+         *
+         *  @param in_pass_id           ID of a graphics pass to update.
+         *  @param in_resource_id       ID of an image resource.
+         *  @param opt_clear_value_ptr  If not nullptr, the attachment is going to be cleared with the specified
+         *                              value when the render pass starts. Otherwise, previous contents of the image
+         *                              are preserved.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_pass_color_output(DAGRendererPassID        in_pass_id,
+                                   DAGRendererResourceID    in_resource_id,
+                                   const VkClearColorValue* opt_clear_value_ptr);
+
+        /** Declares that a graphics pass uses an image as a depth/stencil attachment. Only one depth/stencil output
+         *  can be declared for a pass.
+         *
+         *  @param in_pass_id           ID of a graphics pass to update.
+         *  @param in_resource_id       ID of an image resource.
+         *  @param opt_clear_value_ptr  If not nullptr, the attachment is going to be cleared with the specified
+         *                              value when the render pass starts. Otherwise, previous contents of the image
+         *                              are preserved.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_pass_depth_stencil_output(DAGRendererPassID               in_pass_id,
+                                           DAGRendererResourceID           in_resource_id,
+                                           const VkClearDepthStencilValue* opt_clear_value_ptr);
+
+        /** Declares that a pass reads an image.
+         *
+         *  Images read with RESOURCE_USAGE_INPUT_ATTACHMENT usage are bound as input attachments of the pass's
+         *  subpass, using the input attachment index equal to the number of such inputs declared for the pass
+         *  so far. This usage is only supported for graphics passes.
+         *
+         *  @param in_pass_id     ID of the pass to update.
+         *  @param in_resource_id ID of an image resource.
+         *  @param in_usage       Usage the image is going to be accessed with. Must describe a read-only access.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_pass_image_input(DAGRendererPassID     in_pass_id,
+                                  DAGRendererResourceID in_resource_id,
+                                  Anvil::ResourceUsage  in_usage);
+
+        /** Declares that a pass writes to an image through a non-attachment usage (eg. storage image
+         *  or transfer destination). Use add_pass_color_output() and add_pass_depth_stencil_output()
+         *  for attachments.
+         *
+         *  @param in_pass_id     ID of the pass to update.
+         *  @param in_resource_id ID of an image resource.
+         *  @param in_usage       Usage the image is going to be accessed with.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_pass_image_output(DAGRendererPassID     in_pass_id,
+                                   DAGRendererResourceID in_resource_id,
+                                   Anvil::ResourceUsage  in_usage);
+
+        /** Adds a new transfer pass to the graph.
+         *
+         *  @param in_pfn_record_proc Callback to use for recording pass commands. Must not be nullptr.
+         *  @param in_user_arg        User argument to pass with the callback. May be nullptr.
+         *  @param out_pass_id_ptr    Deref will be set to the ID of the new pass. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_transfer_pass(PFNDAGRENDERERPASSPROC in_pfn_record_proc,
+                               void*                  in_user_arg,
+                               DAGRendererPassID*     out_pass_id_ptr);
+
+        /** Adds a new transient buffer to the graph.
+         *
+         *  Transient resources are created & assigned memory by the renderer at bake() time. Their contents
+         *  are undefined when first accessed within a frame, and are not preserved between frames. Usage
+         *  flags are derived from the usages declared by the passes.
+         *
+         *  @param in_size             Size of the buffer. Must not be 0.
+         *  @param out_resource_id_ptr Deref will be set to the ID of the new resource. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_transient_buffer(VkDeviceSize           in_size,
+                                  DAGRendererResourceID* out_resource_id_ptr);
+
+        /** Adds a new transient 2D image to the graph. The image holds a single layer and a single mipmap.
+         *
+         *  Please see add_transient_buffer() for more details regarding transient resources.
+         *
+         *  @param in_format           Format of the image.
+         *  @param in_width            Width of the image. Must not be 0.
+         *  @param in_height           Height of the image. Must not be 0.
+         *  @param in_sample_count     Number of samples to use.
+         *  @param out_resource_id_ptr Deref will be set to the ID of the new resource. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool add_transient_image(VkFormat               in_format,
+                                 uint32_t               in_width,
+                                 uint32_t               in_height,
+                                 VkSampleCountFlagBits  in_sample_count,
+                                 DAGRendererResourceID* out_resource_id_ptr);
+
+        /** Culls & orders the passes, creates transient resources, render passes and graphics pipelines.
+         *
+         *  The graph cannot be modified after it has been baked, with the exception of set_imported_buffer()
+         *  and set_imported_image() calls.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool bake();
+
+        /** Creates a new DAGRenderer instance.
+         *
+         *  @param in_device_ptr        Device to use.
+         *  @param opt_swapchain_ptr    Swapchain to pass to render passes created by the renderer. Please see
+         *                              RenderPass::create() for more details. May be nullptr.
+         **/
+        static std::shared_ptr<DAGRenderer> create(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
+                                                   std::shared_ptr<Anvil::Swapchain> opt_swapchain_ptr);
+
+        /** Destructor. */
+        ~DAGRenderer();
+
+        /** Returns the buffer, which is currently associated with a buffer resource. */
+        std::shared_ptr<Anvil::Buffer> get_buffer(DAGRendererResourceID in_resource_id) const;
+
+        /** Returns ID of the graphics pipeline, created for a graphics pass.
+         *
+         *  @param in_pass_id                   ID of a graphics pass.
+         *  @param out_graphics_pipeline_id_ptr Deref will be set to the pipeline ID. Must not be nullptr.
+         *
+         *  @return true if successful, false if the renderer has not been baked yet, the pass is not a graphics
+         *          pass, or it has been culled.
+         **/
+        bool get_graphics_pass_pipeline_id(DAGRendererPassID   in_pass_id,
+                                           GraphicsPipelineID* out_graphics_pipeline_id_ptr) const;
+
+        /** Returns the render pass, created for a graphics pass. Returns nullptr if the pass has been culled
+         *  or the renderer has not been baked yet.
+         **/
+        std::shared_ptr<Anvil::RenderPass> get_graphics_pass_render_pass(DAGRendererPassID in_pass_id) const;
+
+        /** Returns the image, which is currently associated with an image resource. */
+        std::shared_ptr<Anvil::Image> get_image(DAGRendererResourceID in_resource_id) const;
+
+        /** Returns a 2D view of the image, which is currently associated with an image resource. Views are
+         *  created on first request & cached.
+         **/
+        std::shared_ptr<Anvil::ImageView> get_image_view(DAGRendererResourceID in_resource_id);
+
+        /** Adds an app-managed buffer to the graph.
+         *
+         *  @param in_buffer_ptr       Buffer to use. May be nullptr, in which case the buffer must be specified
+         *                             with a set_imported_buffer() call before the graph is recorded.
+         *  @param out_resource_id_ptr Deref will be set to the ID of the new resource. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool import_buffer(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                           DAGRendererResourceID*         out_resource_id_ptr);
+
+        /** Adds an app-managed image to the graph. Contents of imported resources are preserved.
+         *
+         *  Images used as attachments must be specified before bake() is called, as their properties are
+         *  needed to create render passes. Images which are later assigned to the resource with
+         *  set_imported_image() (eg. swapchain images) must use the same format, size and sample count.
+         *
+         *  @param in_image_ptr        Image to use. See above for more details.
+         *  @param out_resource_id_ptr Deref will be set to the ID of the new resource. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool import_image(std::shared_ptr<Anvil::Image> in_image_ptr,
+                          DAGRendererResourceID*        out_resource_id_ptr);
+
+        /** Tells whether a pass has been culled at bake() time. */
+        bool is_pass_culled(DAGRendererPassID in_pass_id) const;
+
+        /** Marks a resource as a frame output. Passes contributing to frame outputs are never culled.
+         *
+         *  At the end of the frame, the resource is transitioned to @param in_final_usage (eg.
+         *  RESOURCE_USAGE_PRESENT for swapchain images).
+         *
+         *  @param in_resource_id ID of the resource.
+         *  @param in_final_usage Usage to transition the resource to at the end of the frame.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool mark_as_output(DAGRendererResourceID in_resource_id,
+                            Anvil::ResourceUsage  in_final_usage);
+
+        /** Records commands of all passes which have not been culled, along with the barriers needed to
+         *  synchronize them, to a command buffer. The renderer must have been baked.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the commands to. Must be in recording state.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool record(std::shared_ptr<Anvil::PrimaryCommandBuffer> in_cmd_buffer_ptr);
+
+        /** Associates a different buffer with an imported buffer resource. */
+        bool set_imported_buffer(DAGRendererResourceID          in_resource_id,
+                                 std::shared_ptr<Anvil::Buffer> in_buffer_ptr);
+
+        /** Associates a different image with an imported image resource. Please see import_image() for
+         *  more details.
+         **/
+        bool set_imported_image(DAGRendererResourceID         in_resource_id,
+                                std::shared_ptr<Anvil::Image> in_image_ptr);
+
+        /** Prevents a pass from being culled, even if none of its results contribute to the frame outputs.
+         *  Useful for passes with side effects the renderer is not aware of.
+         **/
+        bool set_pass_never_culled(DAGRendererPassID in_pass_id);
+
+    private:
+        /* Private type declarations */
+        typedef enum
+        {
+            PASS_TYPE_COMPUTE,
+            PASS_TYPE_GRAPHICS,
+            PASS_TYPE_TRANSFER,
+        } PassType;
+
+        typedef enum
+        {
+            /* Read-only access */
+            ACCESS_TYPE_INPUT,
+
+            /* Write access, which does not depend on previous contents of the resource */
+            ACCESS_TYPE_OVERWRITE,
+
+            /* Write access, which preserves previous contents of the resource */
+            ACCESS_TYPE_READ_WRITE,
+        } AccessType;
+
+        typedef struct Access
+        {
+            AccessType            access_type;
+            DAGRendererResourceID resource_id;
+            Anvil::ResourceUsage  usage;
+
+            Access(DAGRendererResourceID in_resource_id,
+                   Anvil::ResourceUsage  in_usage,
+                   AccessType            in_access_type)
+                :access_type(in_access_type),
+                 resource_id(in_resource_id),
+                 usage      (in_usage)
+            {
+                /* Stub */
+            }
+        } Access;
+
+        typedef struct Attachment
+        {
+            VkClearValue          clear_value;
+            bool                  has_clear_value;
+            DAGRendererResourceID resource_id;
+            Anvil::ResourceUsage  usage;
+        } Attachment;
+
+        typedef struct Pass
+        {
+            std::vector<Access>     accesses;
+            std::vector<Attachment> attachments;
+            std::vector<uint32_t>   dependencies;
+            bool                    has_depth_stencil_attachment;
+            bool                    is_culled;
+            bool                    is_never_culled;
+            PFNDAGRENDERERPASSPROC  pfn_record_proc;
+            PassType                type;
+            void*                   user_arg;
+
+            ShaderModuleStageEntryPoint fragment_shader_entrypoint;
+            ShaderModuleStageEntryPoint geometry_shader_entrypoint;
+            ShaderModuleStageEntryPoint tess_control_shader_entrypoint;
+            ShaderModuleStageEntryPoint tess_evaluation_shader_entrypoint;
+            ShaderModuleStageEntryPoint vertex_shader_entrypoint;
+
+            std::vector<VkClearValue>                                                  clear_values;
+            std::map<std::vector<Anvil::Image*>, std::shared_ptr<Anvil::Framebuffer> > framebuffers;
+            GraphicsPipelineID                                                         pipeline_id;
+            VkExtent2D                                                                 render_area_extent;
+            std::shared_ptr<Anvil::RenderPass>                                         render_pass_ptr;
+
+            Pass(PassType               in_type,
+                 PFNDAGRENDERERPASSPROC in_pfn_record_proc,
+                 void*                  in_user_arg)
+                :has_depth_stencil_attachment(false),
+                 is_culled                   (false),
+                 is_never_culled             (false),
+                 pfn_record_proc             (in_pfn_record_proc),
+                 type                        (in_type),
+                 user_arg                    (in_user_arg),
+                 pipeline_id                 (UINT32_MAX)
+            {
+                render_area_extent.height = 0;
+                render_area_extent.width  = 0;
+            }
+        } Pass;
+
+        typedef struct Resource
+        {
+            Anvil::ResourceState           aliased_state;
+            std::shared_ptr<Anvil::Buffer> buffer_ptr;
+            VkDeviceSize                   buffer_size;
+            Anvil::ResourceUsage           final_usage;
+            uint32_t                       first_use;
+            VkFormat                       image_format;
+            uint32_t                       image_height;
+            std::shared_ptr<Anvil::Image>  image_ptr;
+            VkSampleCountFlagBits          image_sample_count;
+            uint32_t                       image_width;
+            bool                           is_image;
+            bool                           is_output;
+            bool                           is_transient;
+            uint32_t                       last_use;
+            Anvil::ResourceState           last_use_state;
+
+            Resource()
+                :buffer_size       (0),
+                 final_usage       (Anvil::RESOURCE_USAGE_COUNT),
+                 first_use         (UINT32_MAX),
+                 image_format      (VK_FORMAT_UNDEFINED),
+                 image_height      (0),
+                 image_sample_count(VK_SAMPLE_COUNT_1_BIT),
+                 image_width       (0),
+                 is_image          (false),
+                 is_output         (false),
+                 is_transient      (false),
+                 last_use          (UINT32_MAX)
+            {
+                /* Stub */
+            }
+        } Resource;
+
+        /* Private functions */
+        DAGRenderer(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
+                    std::shared_ptr<Anvil::Swapchain> in_swapchain_ptr);
+
+        DAGRenderer           (const DAGRenderer&);
+        DAGRenderer& operator=(const DAGRenderer&);
+
+        bool add_access            (DAGRendererPassID     in_pass_id,
+                                    DAGRendererResourceID in_resource_id,
+                                    bool                  in_is_image,
+                                    Anvil::ResourceUsage  in_usage,
+                                    AccessType            in_access_type);
+        bool add_attachment        (DAGRendererPassID     in_pass_id,
+                                    DAGRendererResourceID in_resource_id,
+                                    Anvil::ResourceUsage  in_usage,
+                                    const VkClearValue*   opt_clear_value_ptr);
+        bool bake_render_pass      (Pass*                 in_pass_ptr,
+                                    uint32_t              in_n_ordered_pass);
+        void cull_passes           ();
+        bool create_transient_resources();
+        void order_passes          ();
+
+        std::shared_ptr<Anvil::Framebuffer> get_framebuffer(Pass* in_pass_ptr);
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice>                            m_device_ptr;
+        std::map<Anvil::Image*, std::shared_ptr<Anvil::ImageView> > m_image_views;
+        bool                                                        m_is_baked;
+        std::shared_ptr<Anvil::MemoryAllocator>                     m_memory_allocator_ptr;
+        std::vector<uint32_t>                                       m_ordered_passes;
+        std::vector<Pass>                                           m_passes;
+        std::vector<Resource>                                       m_resources;
+        std::shared_ptr<Anvil::Swapchain>                           m_swapchain_ptr;
+        std::vector<Anvil::Image*>                                  m_temp_framebuffer_key;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_DAG_RENDERER_H */
@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a deferred deletion queue, which lets applications release wrapper instances whose Vulkan
+ *  objects may still be used by submissions which have not finished executing.
+ *
+ *  Each device owns a deferred deletion queue, which can be retrieved with BaseDevice::get_deferred_deletion_queue().
+ *  The queue is disabled by default, in which case wrapper instances release their Vulkan objects right away.
+ *
+ *  Once enabled, wrapper destructors hand their Vulkan object handles over to the queue. Each handle is tagged
+ *  with the current submission serial. The application is expected to call end_serial() once per frame. The
+ *  function closes the current serial by submitting a fence to each of the device's queues, which have been
+ *  used since the previous call. Handles are released by collect() once all fences of their serial have been
+ *  signalled. end_serial() calls collect() on its own.
+ *
+ *  The following object types can be deferred:
+ *
+ *  - buffers, buffer views, images, image views and samplers.
+ *  - command buffers and command pools.
+ *  - descriptor pools, descriptor set layouts, framebuffers and render passes.
+ *  - events, query pools and semaphores.
+ *  - memory blocks.
+ *  - pipelines, pipeline layouts and shader modules.
+ *
+ *  Since vkFreeCommandBuffers() requires access to the parent command pool to be externally synchronized,
+ *  collected command buffers are not freed by collect(). Instead, they are handed back to their command pool,
+ *  which frees them on the thread owning it, the next time a command buffer is allocated from it or it is
+ *  reset. Command buffers of a destroyed command pool are released together with the pool.
+ *
+ *  All remaining handles are released when the device is destroyed.
+ *
+ *  The queue is thread-safe.
+ **/
+#ifndef MISC_DEFERRED_DELETION_QUEUE_H
+#define MISC_DEFERRED_DELETION_QUEUE_H
+
+#include "../misc/types.h"
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+
+
+namespace Anvil
+{
+    /** Implements a deferred deletion queue. For more details, please see the header. */
+    class DeferredDeletionQueue
+    {
+    public:
+        /* Public functions */
+
+        /** Creates a new DeferredDeletionQueue instance. The queue is disabled after creation.
+         *
+         *  @param in_device_ptr Device to use.
+         **/
+        static std::shared_ptr<DeferredDeletionQueue> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr);
+
+        /** Destructor. */
+        ~DeferredDeletionQueue();
+
+        /** Releases all handles whose serials have completed.
+         *
+         *  This function never blocks on the GPU.
+         **/
+        void collect();
+
+        /** Releases the specified Vulkan object. If @param in_device_ptr's deferred deletion queue is enabled,
+         *  the handle is tagged with the current serial and released once all work submitted up to the end
+         *  of that serial finishes executing. Otherwise, the handle is released right away.
+         *
+         *  @param in_device_ptr        Device the object has been created for. Must not be nullptr.
+         *  @param in_object_type       Type of the object. Please see the header for supported types.
+         *  @param in_handle            Vulkan handle of the object to release.
+         *  @param in_opt_parent_handle Vulkan handle of the command pool, if @param in_object_type is
+         *                              OBJECT_TYPE_COMMAND_BUFFER. Ignored otherwise.
+         **/
+        template<typename HandleType, typename ParentHandleType = uint64_t>
+        static void destroy(const std::shared_ptr<Anvil::BaseDevice>& in_device_ptr,
+                            Anvil::ObjectType                         in_object_type,
+                            HandleType                                in_handle,
+                            ParentHandleType                          in_opt_parent_handle = 0)
+        {
+            destroy_internal(in_device_ptr,
+                             in_object_type,
+                             reinterpret_cast<uint64_t>(in_handle),
+                             reinterpret_cast<uint64_t>(in_opt_parent_handle) );
+        }
+
+        /** Closes the current serial, and starts a new one.
+         *
+         *  A fence is submitted to each of the device's queues, which have been used since the previous
+         *  end_serial() call. Handles of the closed serial are released once all of these fences are
+         *  signalled. Afterward, collect() is called.
+         **/
+        void end_serial();
+
+        /** Frees command buffers, allocated from the specified command pool, which have been collected.
+         *
+         *  Called by CommandPool, which must be owned by the calling thread. Please see the header for
+         *  more details.
+         *
+         *  @param in_command_pool Command pool to free collected command buffers of.
+         **/
+        void free_command_buffers(VkCommandPool in_command_pool);
+
+        /** Returns the serial new handles are tagged with. */
+        uint64_t get_current_serial() const
+        {
+            return m_current_serial;
+        }
+
+        /** Returns the number of handles waiting to be released. */
+        uint32_t get_n_pending_handles() const
+        {
+            return m_n_pending_handles;
+        }
+
+        /** Tells whether the queue is enabled. */
+        bool is_enabled() const
+        {
+            return m_enabled;
+        }
+
+        /** Releases all handles held by the queue, after waiting until the device becomes idle. */
+        void release_all();
+
+        /** Enables or disables the queue.
+         *
+         *  Disabling the queue does not release handles which are already held by it. Since a command buffer
+         *  has to be released before its command pool, the function should be called before any command
+         *  buffers are created.
+         *
+         *  @param in_enabled true to enable the queue, false to disable it.
+         **/
+        void set_enabled(bool in_enabled)
+        {
+            m_enabled = in_enabled;
+        }
+
+    private:
+        /* Private type definitions */
+        typedef struct Item
+        {
+            uint64_t          handle;
+            Anvil::ObjectType object_type;
+            uint64_t          parent_handle;
+            uint64_t          serial;
+
+            Item(Anvil::ObjectType in_object_type,
+                 uint64_t          in_handle,
+                 uint64_t          in_parent_handle,
+                 uint64_t          in_serial)
+                :handle       (in_handle),
+                 object_type  (in_object_type),
+                 parent_handle(in_parent_handle),
+                 serial       (in_serial)
+            {
+                /* Stub */
+            }
+        } Item;
+
+        typedef struct PendingSerial
+        {
+            std::vector<std::shared_ptr<Anvil::Fence> > fence_ptrs;
+            uint64_t                                    serial;
+        } PendingSerial;
+
+        /* Private functions */
+        DeferredDeletionQueue(std::weak_ptr<Anvil::BaseDevice> in_device_ptr);
+
+        DeferredDeletionQueue           (const DeferredDeletionQueue&);
+        DeferredDeletionQueue& operator=(const DeferredDeletionQueue&);
+
+        void        collect_internal(uint64_t                                  in_completed_serial);
+        void        init_queues     ();
+        static void destroy_internal(const std::shared_ptr<Anvil::BaseDevice>& in_device_ptr,
+                                     Anvil::ObjectType                         in_object_type,
+                                     uint64_t                                  in_handle,
+                                     uint64_t                                  in_parent_handle);
+        static void release_handle  (const std::shared_ptr<Anvil::BaseDevice>& in_device_ptr,
+                                     Anvil::ObjectType                         in_object_type,
+                                     uint64_t                                  in_handle,
+                                     uint64_t                                  in_parent_handle);
+
+        /* Private variables */
+        std::map<VkCommandPool, std::vector<VkCommandBuffer> > m_collected_command_buffers;
+        std::atomic<uint64_t>                                  m_current_serial;
+        std::weak_ptr<Anvil::BaseDevice>                       m_device_ptr;
+        std::atomic<bool>                                      m_enabled;
+        std::mutex                                             m_end_serial_mutex;
+        std::deque<Item>                                       m_items;
+        std::mutex                                             m_mutex;
+        std::atomic<uint32_t>                                  m_n_pending_handles;
+        std::deque<PendingSerial>                              m_pending_serials;
+        std::vector<uint64_t>                                  m_queue_n_submissions;
+        std::vector<Anvil::Queue*>                             m_queue_ptrs;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_DEFERRED_DELETION_QUEUE_H */
@@ -0,0 +1,204 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a builder of batched indexed indirect draw calls.
+ *
+ *  Apps add indexed draws, each tagged with a state key which identifies the pipeline, descriptor sets
+ *  and vertex/index buffers the draw needs to be executed with. At recording time, the builder:
+ *
+ *  - sorts the draws by their state keys. Draws sharing the same key retain their submission order.
+ *  - writes VkDrawIndexedIndirectCommand entries for all draws to a contiguous region of a host-coherent
+ *    indirect buffer, which is used as a ring.
+ *  - for each bucket of draws sharing the same state key, invokes a user callback which binds the state
+ *    and then records the draws with a single vkCmdDrawIndexedIndirect() call, if the multiDrawIndirect
+ *    feature is supported. Otherwise, one vkCmdDrawIndexedIndirect() call is recorded per draw.
+ *
+ *  The ring is written to by the CPU at recording time. Apps start each frame with a begin_frame() call.
+ *  Each ring region written by record() is tagged with the frame it has been written for, and is only
+ *  reused once N further frames have been started, N being the number of frames in flight. It is the app's
+ *  responsibility to ensure, for example by waiting on a fence, that the GPU has finished executing a frame
+ *  before the frame started N frames later begins. If the pending draws do not fit in the part of the ring
+ *  which is not in flight, record() fails instead of overwriting indirect commands the GPU may still read.
+ *
+ *  The builder is not thread-safe.
+ **/
+#ifndef MISC_DRAW_BATCH_BUILDER_H
+#define MISC_DRAW_BATCH_BUILDER_H
+
+#include "../misc/types.h"
+#include <deque>
+
+
+namespace Anvil
+{
+    /** State key of a DrawBatchBuilder draw. Draws using the same key are recorded together. */
+    typedef uint64_t DrawBatchStateKey;
+
+    /** Callback used by DrawBatchBuilder to bind the state of a bucket of draws.
+     *
+     *  The callback is invoked right before the draws using @param state_key are recorded.
+     *
+     *  @param builder_ptr    Builder invoking the callback.
+     *  @param state_key      State key of the draws which are about to be recorded.
+     *  @param cmd_buffer_ptr Command buffer to record the state binding commands to.
+     *  @param user_arg       User argument, as specified at DrawBatchBuilder::record() call time.
+     **/
+    typedef void (*PFNDRAWBATCHBUCKETPROC)(Anvil::DrawBatchBuilder*                  builder_ptr,
+                                           DrawBatchStateKey                         state_key,
+                                           std::shared_ptr<Anvil::CommandBufferBase> cmd_buffer_ptr,
+                                           void*                                     user_arg);
+
+    /** Implements a builder of batched indexed indirect draw calls. For more details, please see the header. */
+    class DrawBatchBuilder
+    {
+    public:
+        /* Public functions */
+
+        /** Adds a new indexed draw to the batch. Arguments match VkDrawIndexedIndirectCommand fields.
+         *
+         *  @param in_state_key State key to associate with the draw.
+         **/
+        void add_draw(DrawBatchStateKey in_state_key,
+                      uint32_t          in_index_count,
+                      uint32_t          in_instance_count,
+                      uint32_t          in_first_index,
+                      int32_t           in_vertex_offset,
+                      uint32_t          in_first_instance);
+
+        /** Starts a new frame. Ring regions written for the frame started N frames earlier, N being the number
+         *  of frames in flight, become available for reuse.
+         **/
+        void begin_frame();
+
+        /** Creates a new DrawBatchBuilder instance.
+         *
+         *  @param in_device_ptr          Device to use.
+         *  @param in_n_frames_in_flight  Number of frames which can be executed by the GPU at the same time.
+         *                                Must not be 0.
+         *  @param in_n_max_draws_in_ring Number of VkDrawIndexedIndirectCommand entries the indirect buffer ring
+         *                                should be able to hold. Should be large enough to hold the draws of
+         *                                all frames in flight. Must not be 0.
+         *
+         *  @return New instance if successful, nullptr otherwise.
+         **/
+        static std::shared_ptr<DrawBatchBuilder> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                        uint32_t                         in_n_frames_in_flight,
+                                                        uint32_t                         in_n_max_draws_in_ring);
+
+        /** Destructor. */
+        ~DrawBatchBuilder();
+
+        /** Returns the indirect buffer used as the ring. */
+        std::shared_ptr<Anvil::Buffer> get_indirect_buffer() const
+        {
+            return m_indirect_buffer_ptr;
+        }
+
+        /** Returns the number of draws which have been added since the last record() call. */
+        uint32_t get_n_pending_draws() const
+        {
+            return static_cast<uint32_t>(m_pending_draws.size() );
+        }
+
+        /** Records all pending draws to the specified command buffer and clears the batch.
+         *
+         *  Must be called while a render pass is active, with a command buffer which is in recording mode.
+         *  Index buffers, vertex buffers and graphics pipelines should be bound by @param in_pfn_bucket_proc.
+         *  A frame must have been started with begin_frame(). The command buffer must be submitted as part
+         *  of that frame.
+         *
+         *  @param in_cmd_buffer_ptr  Command buffer to record the draws to. Must not be nullptr.
+         *  @param in_pfn_bucket_proc Callback to invoke for each bucket of draws sharing the same state key.
+         *                            Must not be nullptr.
+         *  @param in_user_arg        User argument to pass to @param in_pfn_bucket_proc.
+         *
+         *  @return true if successful, false otherwise. The call fails if the pending draws do not fit in a
+         *          contiguous part of the ring which is not in flight. In that case, nothing is recorded, the
+         *          ring is left intact and the pending draws are discarded.
+         **/
+        bool record(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                    PFNDRAWBATCHBUCKETPROC                    in_pfn_bucket_proc,
+                    void*                                     in_user_arg);
+
+    private:
+        /* Private type definitions */
+        typedef struct PendingDraw
+        {
+            VkDrawIndexedIndirectCommand command;
+            DrawBatchStateKey            state_key;
+
+            PendingDraw(DrawBatchStateKey                   in_state_key,
+                        const VkDrawIndexedIndirectCommand& in_command)
+            {
+                command   = in_command;
+                state_key = in_state_key;
+            }
+
+            bool operator<(const PendingDraw& in_draw) const
+            {
+                return state_key < in_draw.state_key;
+            }
+        } PendingDraw;
+
+        /* Describes a ring region written for a frame, which may still be in flight */
+        typedef struct RingRegion
+        {
+            uint64_t frame_index;
+            uint32_t n_draws;
+            uint32_t n_first_draw;
+
+            RingRegion(uint64_t in_frame_index,
+                       uint32_t in_n_first_draw,
+                       uint32_t in_n_draws)
+            {
+                frame_index  = in_frame_index;
+                n_draws      = in_n_draws;
+                n_first_draw = in_n_first_draw;
+            }
+        } RingRegion;
+
+        /* Private functions */
+        DrawBatchBuilder(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                         uint32_t                         in_n_frames_in_flight,
+                         uint32_t                         in_n_max_draws_in_ring);
+
+        DrawBatchBuilder           (const DrawBatchBuilder&);
+        DrawBatchBuilder& operator=(const DrawBatchBuilder&);
+
+        bool init();
+        bool is_ring_range_in_flight(uint32_t in_n_first_draw,
+                                     uint32_t in_n_draws) const;
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice>          m_device_ptr;
+        std::deque<RingRegion>                    m_in_flight_ring_regions;
+        std::shared_ptr<Anvil::Buffer>            m_indirect_buffer_ptr;
+        uint32_t                                  m_n_frames_in_flight;
+        uint32_t                                  m_n_max_draws_in_ring;
+        uint32_t                                  m_n_ring_head_draw;
+        uint64_t                                  m_n_started_frames;
+        std::vector<PendingDraw>                  m_pending_draws;
+        std::vector<VkDrawIndexedIndirectCommand> m_sorted_commands;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_DRAW_BATCH_BUILDER_H */
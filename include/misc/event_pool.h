@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a pool of events, which lets code paths using events for fine-grained synchronization (such as
+ *  SplitBarrier) do so without creating and destroying Vulkan event objects.
+ *
+ *  get_event() hands out unsignalled events. An event goes back to the pool as soon as the last reference
+ *  to it is dropped. The last reference must only be dropped once the GPU no longer uses the event, which is
+ *  why command buffers recording commands for pooled events should retain them (see
+ *  CommandBufferBase::FastRecorder::retain() ). Returned events, which have been left signalled, are reset
+ *  from the host before they are reused.
+ *
+ *  Each device owns an event pool, which can be retrieved with BaseDevice::get_event_pool(). The pool is
+ *  thread-safe.
+ **/
+#ifndef MISC_EVENT_POOL_H
+#define MISC_EVENT_POOL_H
+
+#include "../misc/types.h"
+#include <atomic>
+#include <mutex>
+
+
+namespace Anvil
+{
+    /** Implements a pool of events. For more details, please see the header. */
+    class EventPool : public std::enable_shared_from_this<EventPool>
+    {
+    public:
+        /* Public functions */
+
+        /** Creates a new EventPool instance.
+         *
+         *  @param in_device_ptr Device to use.
+         **/
+        static std::shared_ptr<EventPool> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr);
+
+        /** Destructor. */
+        ~EventPool();
+
+        /** Returns an unsignalled event. The event is returned to the pool when the last reference to it
+         *  is dropped.
+         *
+         *  If no event is available for reuse, a new one is created.
+         **/
+        std::shared_ptr<Anvil::Event> get_event();
+
+        /** Returns the number of events the pool has created. */
+        uint32_t get_n_events_created() const
+        {
+            return m_n_events_created;
+        }
+
+        /** Returns the number of get_event() calls which have been served without creating a new event. */
+        uint32_t get_n_events_reused() const
+        {
+            return m_n_events_reused;
+        }
+
+    private:
+        /* Private type definitions */
+
+        /** Returns an event to the pool, when the last reference to it is dropped. */
+        struct ReturnToPoolFunctor
+        {
+            explicit ReturnToPoolFunctor(std::shared_ptr<EventPool> in_pool_ptr)
+                :pool_ptr(in_pool_ptr)
+            {
+                /* Stub */
+            }
+
+            void operator()(Anvil::Event* in_event_ptr)
+            {
+                pool_ptr->return_event(in_event_ptr);
+            }
+
+        private:
+            std::shared_ptr<EventPool> pool_ptr;
+        };
+
+        /* Private functions */
+        EventPool(std::weak_ptr<Anvil::BaseDevice> in_device_ptr);
+
+        EventPool           (const EventPool&);
+        EventPool& operator=(const EventPool&);
+
+        void return_event(Anvil::Event* in_event_ptr);
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice>            m_device_ptr;
+        std::vector<std::shared_ptr<Anvil::Event> > m_event_ptrs;
+        std::vector<Anvil::Event*>                  m_free_events;
+        std::mutex                                  m_mutex;
+        std::atomic<uint32_t>                       m_n_events_created;
+        std::atomic<uint32_t>                       m_n_events_reused;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_EVENT_POOL_H */
@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a service, which runs CPU-side continuations once fences signal. It lets GPU completion drive
+ *  CPU work - such as releasing staging memory, recycling command buffers or fulfilling readback requests -
+ *  without blocking the calling thread in vkWaitForFences(), or polling Fence::is_set().
+ *
+ *  All fences registered with the service are waited on by a single background thread, which calls
+ *  vkWaitForFences() with waitAll set to VK_FALSE. Once any fence signals, the thread runs continuations of
+ *  all signalled fences, in the order they have been registered in. The thread is only started when the first
+ *  continuation is registered, and sleeps while no fences are pending.
+ *
+ *  The wait set also includes an internal wake-up fence. A registration made while the thread is blocked in
+ *  vkWaitForFences() submits an empty batch, which signals the wake-up fence, so that the thread picks the
+ *  new fence up right away. Waits are therefore unbounded. The batch is submitted to the first device queue
+ *  which does not use QUEUE_SUBMISSION_MODE_UNSYNCHRONIZED, since registrations may come from any thread.
+ *  If all queues are unsynchronized, each wait is bounded by a timeout instead (1 ms by default).
+ *
+ *  Continuations run on the service's thread, so they must be thread-safe. They may register further
+ *  continuations. A registered fence is retained until its continuations have run, and must not be reset
+ *  in the meantime.
+ *
+ *  Each device owns a completion service, which can be retrieved with
+ *  BaseDevice::get_fence_completion_service(). When the device is destroyed, the service waits for all
+ *  pending fences and runs their continuations before its thread is stopped.
+ *
+ *  The service is thread-safe.
+ **/
+#ifndef MISC_FENCE_COMPLETION_SERVICE_H
+#define MISC_FENCE_COMPLETION_SERVICE_H
+
+#include "../misc/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+namespace Anvil
+{
+    /** Prototype of a function, which is called once a fence registered with a FenceCompletionService signals.
+     *
+     *  @param in_user_arg User argument, as specified at registration time.
+     **/
+    typedef void (*PFNFENCECONTINUATIONPROC)(void* in_user_arg);
+
+    /** Implements a fence completion service. For more details, please see the header. */
+    class FenceCompletionService
+    {
+    public:
+        /* Public functions */
+
+        /** Creates a new FenceCompletionService instance.
+         *
+         *  @param in_device_ptr Device to use.
+         **/
+        static std::shared_ptr<FenceCompletionService> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr);
+
+        /** Destructor. Blocks until all pending fences signal and their continuations finish running. */
+        ~FenceCompletionService();
+
+        /** Returns the number of continuations which have not been run yet. */
+        uint32_t get_n_pending_continuations() const
+        {
+            return m_n_pending_continuations;
+        }
+
+        /** Registers a continuation, which is going to be run once the specified fence signals.
+         *
+         *  @param in_fence_ptr        Fence to wait on. Must not be nullptr. The fence may be registered more
+         *                             than once.
+         *  @param in_continuation_ptr Function to call. Must not be nullptr.
+         *  @param in_user_arg         Argument to pass to @param in_continuation_ptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool register_continuation(std::shared_ptr<Anvil::Fence> in_fence_ptr,
+                                   PFNFENCECONTINUATIONPROC      in_continuation_ptr,
+                                   void*                         in_user_arg);
+
+        /** Retains the specified object until the specified fence signals. Can be used to keep resources,
+         *  which are accessed by in-flight command buffers (such as staging buffers), alive without
+         *  tracking their lifetime on the app side.
+         *
+         *  @param in_fence_ptr  Fence to wait on. Must not be nullptr.
+         *  @param in_object_ptr Object to release once the fence signals. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool release_on_completion(std::shared_ptr<Anvil::Fence> in_fence_ptr,
+                                   std::shared_ptr<void>         in_object_ptr);
+
+        /** Sets the maximum amount of time a single vkWaitForFences() call made by the service's thread may
+         *  block for, while no queue can be used to submit wake-up batches. Lower values make the thread pick
+         *  up new registrations sooner, at the expense of more frequent wake-ups.
+         *
+         *  @param in_timeout_ns New timeout, in nanoseconds.
+         **/
+        void set_wait_timeout(uint64_t in_timeout_ns)
+        {
+            m_wait_timeout_ns = in_timeout_ns;
+        }
+
+        /** Blocks until all continuations, which have been registered prior to the call, finish running.
+         *  Must not be called from a continuation.
+         **/
+        void wait_idle();
+
+    private:
+        /* Private type definitions */
+        typedef struct Continuation
+        {
+            PFNFENCECONTINUATIONPROC      continuation_ptr;
+            std::shared_ptr<Anvil::Fence> fence_ptr;
+            std::shared_ptr<void>         object_ptr;
+            uint64_t                      serial;
+            void*                         user_arg;
+
+            Continuation()
+            {
+                continuation_ptr = nullptr;
+                serial           = 0;
+                user_arg         = nullptr;
+            }
+        } Continuation;
+
+        /* Private functions */
+        FenceCompletionService(std::weak_ptr<Anvil::BaseDevice> in_device_ptr);
+
+        FenceCompletionService           (const FenceCompletionService&);
+        FenceCompletionService& operator=(const FenceCompletionService&);
+
+        std::shared_ptr<Anvil::Queue> get_wake_up_queue             () const;
+        bool                          register_continuation_internal(const Continuation& in_continuation);
+        void                          thread_entrypoint             ();
+
+        /* Private variables */
+        std::condition_variable          m_condition_variable;
+        std::vector<Continuation>        m_continuations;
+        std::weak_ptr<Anvil::BaseDevice> m_device_ptr;
+        VkDevice                         m_device_vk;
+        bool                             m_is_waiting;
+        bool                             m_is_wake_up_pending;
+        bool                             m_is_wake_up_submitted;
+        std::mutex                       m_mutex;
+        std::atomic<uint32_t>            m_n_pending_continuations;
+        uint64_t                         m_n_registered_continuations;
+        uint64_t                         m_oldest_running_serial;
+        bool                             m_should_stop;
+        std::thread                      m_thread;
+        std::atomic<uint64_t>            m_wait_timeout_ns;
+        std::shared_ptr<Anvil::Fence>    m_wake_up_fence_ptr;
+        std::shared_ptr<Anvil::Queue>    m_wake_up_queue_ptr;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_FENCE_COMPLETION_SERVICE_H */
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a pool of fences, which lets per-frame code paths use fences without creating and destroying
+ *  Vulkan fence objects.
+ *
+ *  get_fence() hands out unsignalled fences. A fence goes back to the pool as soon as the last reference
+ *  to it is dropped. Since it may still be in flight at that point, it is only reused once it has been
+ *  observed signalled. Signalled fences are reset in batches with Fence::reset_fences().
+ *
+ *  A fence which is released without ever being submitted (see Fence::is_possibly_set() ) is still
+ *  unsignalled, so it is put back in the free fence list straight away.
+ *
+ *  Each device owns a fence pool, which can be retrieved with BaseDevice::get_fence_pool(). The pool is
+ *  thread-safe.
+ **/
+#ifndef MISC_FENCE_POOL_H
+#define MISC_FENCE_POOL_H
+
+#include "../misc/types.h"
+#include <atomic>
+#include <mutex>
+
+
+namespace Anvil
+{
+    /** Implements a pool of fences. For more details, please see the header. */
+    class FencePool : public std::enable_shared_from_this<FencePool>
+    {
+    public:
+        /* Public functions */
+
+        /** Creates a new FencePool instance.
+         *
+         *  @param in_device_ptr              Device to use.
+         *  @param in_n_fences_to_preallocate Number of fences to create at creation time.
+         **/
+        static std::shared_ptr<FencePool> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                 uint32_t                         in_n_fences_to_preallocate);
+
+        /** Destructor. */
+        ~FencePool();
+
+        /** Returns an unsignalled fence. The fence is returned to the pool when the last reference to it
+         *  is dropped.
+         *
+         *  If no fence is available for reuse, a new one is created.
+         **/
+        std::shared_ptr<Anvil::Fence> get_fence();
+
+        /** Returns the number of fences the pool has created. */
+        uint32_t get_n_fences_created() const
+        {
+            return m_n_fences_created;
+        }
+
+        /** Returns the number of get_fence() calls which have been served without creating a new fence. */
+        uint32_t get_n_fences_reused() const
+        {
+            return m_n_fences_reused;
+        }
+
+    private:
+        /* Private type definitions */
+
+        /** Returns a fence to the pool, when the last reference to it is dropped. */
+        struct ReturnToPoolFunctor
+        {
+            explicit ReturnToPoolFunctor(std::shared_ptr<FencePool> in_pool_ptr)
+                :pool_ptr(in_pool_ptr)
+            {
+                /* Stub */
+            }
+
+            void operator()(Anvil::Fence* in_fence_ptr)
+            {
+                pool_ptr->return_fence(in_fence_ptr);
+            }
+
+        private:
+            std::shared_ptr<FencePool> pool_ptr;
+        };
+
+        /* Private functions */
+        FencePool(std::weak_ptr<Anvil::BaseDevice> in_device_ptr);
+
+        FencePool           (const FencePool&);
+        FencePool& operator=(const FencePool&);
+
+        void create_fence  ();
+        void recycle_fences();
+        void return_fence  (Anvil::Fence* in_fence_ptr);
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice>            m_device_ptr;
+        std::vector<std::shared_ptr<Anvil::Fence> > m_fence_ptrs;
+        std::vector<Anvil::Fence*>                  m_fences_to_reset;
+        std::vector<Anvil::Fence*>                  m_free_fences;
+        std::mutex                                  m_mutex;
+        std::atomic<uint32_t>                       m_n_fences_created;
+        std::atomic<uint32_t>                       m_n_fences_reused;
+        std::vector<Anvil::Fence*>                  m_returned_fences;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_FENCE_POOL_H */
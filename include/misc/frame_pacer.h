@@ -0,0 +1,306 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements frame pacing for applications which keep a number of frames in flight.
+ *
+ *  The pacer owns a frame slot for each frame in flight. Each slot comes with:
+ *
+ *  - a fence, signalled when the frame finishes executing.
+ *  - a semaphore, signalled when the swapchain image the frame renders to becomes available.
+ *  - a semaphore, signalled when the frame's command buffers finish executing and waited on by the
+ *    presentation engine.
+ *  - a transient command pool, reset when the slot is reused.
+ *  - a region of a persistently mapped, host-coherent ring buffer, which per-frame data (such as uniforms)
+ *    can be sub-allocated from. The region is rewound when the slot is reused.
+ *
+ *  Apps wrap each frame with begin_frame() and end_frame() calls. begin_frame() only blocks until frame
+ *  (N - k) finishes executing, where N is the index of the new frame and k is the maximum number of frames
+ *  which are allowed to be in flight. k defaults to the number of frame slots, and can be lowered at any
+ *  time with set_n_max_frames_in_flight(). Lower values reduce input latency, higher values let the CPU
+ *  run further ahead of the GPU.
+ *
+ *  App-side resources, which need to be replicated for each frame in flight, can be stored in PerFrame<>
+ *  containers.
+ *
+ *  If the device's deferred deletion queue is enabled, end_frame() also closes its current serial.
+ *
+ *  The pacer is not thread-safe.
+ **/
+#ifndef MISC_FRAME_PACER_H
+#define MISC_FRAME_PACER_H
+
+#include "../misc/types.h"
+
+
+namespace Anvil
+{
+    /** Implements frame pacing. For more details, please see the header. */
+    class FramePacer
+    {
+    public:
+        /* Public functions */
+
+        /** Creates a new FramePacer instance.
+         *
+         *  @param in_device_ptr                 Device to use.
+         *  @param in_opt_swapchain_ptr          Swapchain to acquire images from and present them to. If nullptr,
+         *                                       no images are acquired or presented.
+         *  @param in_n_frames_in_flight         Number of frame slots to create. Must be at least 1.
+         *  @param in_ring_buffer_size_per_frame Size of the ring buffer region assigned to each frame slot. If 0,
+         *                                       no ring buffer is created.
+         *  @param in_ring_buffer_usage_flags    Usage flags to create the ring buffer with. Ignored if
+         *                                       @param in_ring_buffer_size_per_frame is 0.
+         *
+         *  @return New instance if successful, nullptr otherwise.
+         **/
+        static std::shared_ptr<FramePacer> create(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
+                                                  std::shared_ptr<Anvil::Swapchain> in_opt_swapchain_ptr,
+                                                  uint32_t                          in_n_frames_in_flight,
+                                                  VkDeviceSize                      in_ring_buffer_size_per_frame,
+                                                  VkBufferUsageFlags                in_ring_buffer_usage_flags);
+
+        /** Destructor. Blocks until all frames in flight finish executing. */
+        ~FramePacer();
+
+        /** Sub-allocates a region of the current frame's ring buffer region.
+         *
+         *  @param in_size            Number of bytes to allocate.
+         *  @param in_alignment       Required alignment of the region's start offset. Must be a power of two.
+         *  @param out_offset_ptr     Deref will be set to the start offset of the region, relative to the
+         *                            start of the ring buffer. Must not be nullptr.
+         *  @param out_opt_mapped_ptr If not nullptr, deref will be set to a host pointer to the region. Since
+         *                            the ring buffer is host-coherent, no flushes are necessary after writes.
+         *
+         *  @return true if successful, false if the frame's ring buffer region has been exhausted.
+         **/
+        bool allocate_ring_memory(VkDeviceSize  in_size,
+                                  VkDeviceSize  in_alignment,
+                                  VkDeviceSize* out_offset_ptr,
+                                  void**        out_opt_mapped_ptr = nullptr);
+
+        /** Starts a new frame.
+         *
+         *  Blocks until frame (N - k) finishes executing, where N is the index of the new frame and k is the
+         *  maximum number of frames in flight. Afterward, resets the frame slot's fence and command pool,
+         *  rewinds its ring buffer region and, if a swapchain is used, acquires a new swapchain image.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool begin_frame();
+
+        /** Ends the current frame.
+         *
+         *  Submits the specified command buffers to the universal queue, with the frame slot's fence. If a
+         *  swapchain is used, the submission waits on the acquire semaphore, signals the present semaphore,
+         *  and the acquired swapchain image is presented.
+         *
+         *  @param in_n_cmd_buffers           Number of command buffers under @param in_opt_cmd_buffer_ptrs. May be 0.
+         *  @param in_opt_cmd_buffer_ptrs     Command buffers to submit.
+         *  @param in_acquire_wait_stage_mask Pipeline stages which should wait for the swapchain image to become
+         *                                    available.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool end_frame(uint32_t                                         in_n_cmd_buffers,
+                       std::shared_ptr<Anvil::CommandBufferBase> const* in_opt_cmd_buffer_ptrs,
+                       VkPipelineStageFlags                             in_acquire_wait_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+        /** Returns the semaphore which is signalled when the current frame's swapchain image becomes available. */
+        std::shared_ptr<Anvil::Semaphore> get_acquire_semaphore() const
+        {
+            return m_frame_slots[m_n_current_frame_slot].acquire_semaphore_ptr;
+        }
+
+        /** Returns the current frame's command pool. Command buffers allocated from the pool may be re-recorded
+         *  once the frame slot is reused.
+         **/
+        std::shared_ptr<Anvil::CommandPool> get_command_pool() const
+        {
+            return m_frame_slots[m_n_current_frame_slot].command_pool_ptr;
+        }
+
+        /** Returns the index of the current frame. The first frame has an index of 0. */
+        uint64_t get_current_frame_index() const
+        {
+            return m_frame_slots[m_n_current_frame_slot].frame_index;
+        }
+
+        /** Returns the index of the current frame's slot. */
+        uint32_t get_current_frame_slot() const
+        {
+            return m_n_current_frame_slot;
+        }
+
+        /** Returns the fence which is signalled when the current frame finishes executing. */
+        std::shared_ptr<Anvil::Fence> get_fence() const
+        {
+            return m_frame_slots[m_n_current_frame_slot].fence_ptr;
+        }
+
+        /** Returns the result of the last presentation request. */
+        VkResult get_last_present_result() const
+        {
+            return m_last_present_result;
+        }
+
+        /** Returns the number of frame slots. */
+        uint32_t get_n_frames_in_flight() const
+        {
+            return m_n_frames_in_flight;
+        }
+
+        /** Returns the maximum number of frames which are allowed to be in flight. */
+        uint32_t get_n_max_frames_in_flight() const
+        {
+            return m_n_max_frames_in_flight;
+        }
+
+        /** Returns the semaphore which is signalled when the current frame's command buffers finish executing. */
+        std::shared_ptr<Anvil::Semaphore> get_present_semaphore() const
+        {
+            return m_frame_slots[m_n_current_frame_slot].present_semaphore_ptr;
+        }
+
+        /** Returns the ring buffer. May be nullptr, if no ring buffer has been requested at creation time. */
+        std::shared_ptr<Anvil::Buffer> get_ring_buffer() const
+        {
+            return m_ring_buffer_ptr;
+        }
+
+        /** Returns the index of the swapchain image acquired for the current frame. */
+        uint32_t get_swapchain_image_index() const
+        {
+            return m_swapchain_image_index;
+        }
+
+        /** Sets the maximum number of frames which are allowed to be in flight.
+         *
+         *  @param in_n_max_frames_in_flight New value to use. Must be between 1 and the number of frame slots.
+         **/
+        void set_n_max_frames_in_flight(uint32_t in_n_max_frames_in_flight);
+
+    private:
+        /* Private type definitions */
+        typedef struct FrameSlot
+        {
+            std::shared_ptr<Anvil::Semaphore>   acquire_semaphore_ptr;
+            std::shared_ptr<Anvil::CommandPool> command_pool_ptr;
+            std::shared_ptr<Anvil::Fence>       fence_ptr;
+            uint64_t                            frame_index;
+            bool                                has_been_submitted;
+            VkDeviceSize                        n_ring_bytes_used;
+            std::shared_ptr<Anvil::Semaphore>   present_semaphore_ptr;
+
+            FrameSlot()
+            {
+                frame_index        = 0;
+                has_been_submitted = false;
+                n_ring_bytes_used  = 0;
+            }
+        } FrameSlot;
+
+        /* Private functions */
+        FramePacer(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
+                   std::shared_ptr<Anvil::Swapchain> in_opt_swapchain_ptr,
+                   uint32_t                          in_n_frames_in_flight,
+                   VkDeviceSize                      in_ring_buffer_size_per_frame);
+
+        FramePacer           (const FramePacer&);
+        FramePacer& operator=(const FramePacer&);
+
+        bool init          (VkBufferUsageFlags in_ring_buffer_usage_flags);
+        bool wait_for_frame(uint32_t           in_n_frame_slot);
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice>  m_device_ptr;
+        std::vector<FrameSlot>            m_frame_slots;
+        bool                              m_is_frame_active;
+        VkResult                          m_last_present_result;
+        uint8_t*                          m_mapped_ring_buffer_ptr;
+        uint32_t                          m_n_current_frame_slot;
+        uint32_t                          m_n_frames_in_flight;
+        uint32_t                          m_n_max_frames_in_flight;
+        uint64_t                          m_n_started_frames;
+        std::shared_ptr<Anvil::Buffer>    m_ring_buffer_ptr;
+        VkDeviceSize                      m_ring_buffer_size_per_frame;
+        std::shared_ptr<Anvil::Swapchain> m_swapchain_ptr;
+        uint32_t                          m_swapchain_image_index;
+    };
+
+    /** Stores one instance of an app-defined type for each frame slot of a FramePacer, and hands out the
+     *  instance assigned to the pacer's current frame slot.
+     **/
+    template<typename Type>
+    class PerFrame
+    {
+    public:
+        /* Public functions */
+
+        /** Constructor. Creates one default-constructed instance for each frame slot of @param in_pacer_ptr.
+         *
+         *  @param in_pacer_ptr Frame pacer to use. Must not be nullptr.
+         **/
+        explicit PerFrame(std::shared_ptr<Anvil::FramePacer> in_pacer_ptr)
+            :m_items    (in_pacer_ptr->get_n_frames_in_flight() ),
+             m_pacer_ptr(in_pacer_ptr)
+        {
+            /* Stub */
+        }
+
+        /** Returns the instance assigned to the pacer's current frame slot. */
+        Type& get()
+        {
+            return m_items[m_pacer_ptr->get_current_frame_slot()];
+        }
+
+        /** Returns the instance assigned to the pacer's current frame slot. */
+        const Type& get() const
+        {
+            return m_items[m_pacer_ptr->get_current_frame_slot()];
+        }
+
+        /** Returns the instance assigned to the specified frame slot. */
+        Type& get(uint32_t in_n_frame_slot)
+        {
+            return m_items.at(in_n_frame_slot);
+        }
+
+        /** Returns the instance assigned to the specified frame slot. */
+        const Type& get(uint32_t in_n_frame_slot) const
+        {
+            return m_items.at(in_n_frame_slot);
+        }
+
+        /** Returns the number of instances, which equals the number of the pacer's frame slots. */
+        uint32_t get_n_items() const
+        {
+            return static_cast<uint32_t>(m_items.size() );
+        }
+
+    private:
+        /* Private variables */
+        std::vector<Type>                  m_items;
+        std::shared_ptr<Anvil::FramePacer> m_pacer_ptr;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_FRAME_PACER_H */
@@ -0,0 +1,264 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a GPU profiler, which measures execution time of nested zones of GPU commands.
+ *
+ *  Apps wrap each frame with begin_frame() and end_frame() calls, and the commands they want to measure
+ *  with begin_zone() and end_zone() calls (or GPUProfilerScope instances). Zones can be nested.
+ *
+ *  Each zone writes a begin and an end timestamp to a query pool. The profiler owns one query pool per
+ *  frame in flight, used as a ring. Results of a frame are read back, without waiting, when its query
+ *  pool is about to be reused - that is, N frames later, N being the number of frames in flight. If the
+ *  results are not available by then, they are discarded. Timestamps are converted to milliseconds with
+ *  the device's timestampPeriod.
+ *
+ *  For each zone name, the profiler accumulates the last, minimum, average and maximum execution time.
+ *  The most recent zone instances can also be exported in the Chrome trace event format, which can be
+ *  loaded into chrome://tracing.
+ *
+ *  The profiler is not thread-safe. Zones must be recorded to command buffers which are submitted
+ *  to queues supporting timestamp queries, in the order in which the zones have been recorded.
+ **/
+#ifndef MISC_GPU_PROFILER_H
+#define MISC_GPU_PROFILER_H
+
+#include "../misc/types.h"
+#include <map>
+
+
+namespace Anvil
+{
+    /** Holds execution time statistics of a GPUProfiler zone. */
+    typedef struct GPUProfilerZoneStats
+    {
+        double   last_time_ms;
+        double   max_time_ms;
+        double   min_time_ms;
+        uint32_t n_samples;
+        double   total_time_ms;
+
+        /** Dummy constructor */
+        GPUProfilerZoneStats()
+        {
+            last_time_ms  = 0.0;
+            max_time_ms   = 0.0;
+            min_time_ms   = 0.0;
+            n_samples     = 0;
+            total_time_ms = 0.0;
+        }
+
+        /** Returns average execution time of the zone, or 0 if no samples have been gathered. */
+        double get_avg_time_ms() const
+        {
+            return (n_samples > 0) ? total_time_ms / static_cast<double>(n_samples)
+                                   : 0.0;
+        }
+    } GPUProfilerZoneStats;
+
+    /** Implements a GPU profiler. For more details, please see the header. */
+    class GPUProfiler
+    {
+    public:
+        /* Public functions */
+
+        /** Starts a new frame.
+         *
+         *  Reads back results of the frame which has last used the query pool assigned to the new frame,
+         *  and records a command resetting the pool.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the reset command to. Must be in recording mode,
+         *                           outside a render pass, and must be submitted before any of the commands
+         *                           recorded for the frame's zones.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool begin_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr);
+
+        /** Starts a new zone. The zone is nested in the zone which was last started and has not ended yet.
+         *
+         *  If the frame's zone capacity has been exhausted, the zone is ignored. The corresponding end_zone()
+         *  call must still be made.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the begin timestamp to.
+         *  @param in_name           Zone name. Zones sharing the same name share statistics.
+         *
+         *  @return true if the zone is going to be measured, false otherwise.
+         **/
+        bool begin_zone(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                        const char*                               in_name);
+
+        /** Creates a new GPUProfiler instance.
+         *
+         *  @param in_device_ptr            Device to use.
+         *  @param in_n_frames_in_flight    Number of frames which can be executed by the GPU at the same time.
+         *                                  Determines the number of query pools, as well as the latency
+         *                                  of the results. Must not be 0.
+         *  @param in_n_max_zones_per_frame Maximum number of zones which can be measured in a single frame.
+         *  @param in_n_max_trace_events    Number of most recent zone instances to keep for the Chrome trace
+         *                                  export. May be 0.
+         *
+         *  @return New instance if successful, nullptr otherwise.
+         **/
+        static std::shared_ptr<GPUProfiler> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                   uint32_t                         in_n_frames_in_flight,
+                                                   uint32_t                         in_n_max_zones_per_frame,
+                                                   uint32_t                         in_n_max_trace_events);
+
+        /** Ends the current frame. All zones started for the frame must have been ended. */
+        void end_frame();
+
+        /** Ends the zone which was last started.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the end timestamp to.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool end_zone(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr);
+
+        /** Destructor. */
+        ~GPUProfiler();
+
+        /** Returns the most recent zone instances in the Chrome trace event format. */
+        std::string get_chrome_trace() const;
+
+        /** Returns the number of frames, whose results were not available by the time they were read back. */
+        uint32_t get_n_dropped_frames() const
+        {
+            return m_n_dropped_frames;
+        }
+
+        /** Returns the number of frames, whose results have been read back. */
+        uint32_t get_n_resolved_frames() const
+        {
+            return m_n_resolved_frames;
+        }
+
+        /** Returns execution time statistics, mapped to zone names. */
+        const std::map<std::string, GPUProfilerZoneStats>& get_zone_stats() const
+        {
+            return m_zone_stats;
+        }
+
+        /** Returns execution time statistics of the zone with the specified name.
+         *
+         *  @param in_name       Name of the zone to return statistics for.
+         *  @param out_stats_ptr Deref will be set to the statistics. Must not be nullptr.
+         *
+         *  @return true if the zone has been measured at least once, false otherwise.
+         **/
+        bool get_zone_stats(const std::string&    in_name,
+                            GPUProfilerZoneStats* out_stats_ptr) const;
+
+        /** Discards all statistics and trace events gathered so far. */
+        void reset_stats();
+
+        /** Writes the most recent zone instances in the Chrome trace event format to the specified file. */
+        void write_chrome_trace(const std::string& in_filename) const;
+
+    private:
+        /* Private type definitions */
+        typedef struct FrameSlot
+        {
+            bool                              has_pending_results;
+            uint32_t                          n_zones;
+            std::shared_ptr<Anvil::QueryPool> query_pool_ptr;
+            std::vector<std::string>          zone_names;
+
+            FrameSlot()
+            {
+                has_pending_results = false;
+                n_zones             = 0;
+            }
+        } FrameSlot;
+
+        typedef struct TraceEvent
+        {
+            double             duration_us;
+            const std::string* name_ptr;
+            double             start_us;
+        } TraceEvent;
+
+        /* Private functions */
+        GPUProfiler(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                    uint32_t                         in_n_frames_in_flight,
+                    uint32_t                         in_n_max_zones_per_frame,
+                    uint32_t                         in_n_max_trace_events);
+
+        GPUProfiler           (const GPUProfiler&);
+        GPUProfiler& operator=(const GPUProfiler&);
+
+        bool init         ();
+        void resolve_frame(FrameSlot* in_frame_slot_ptr);
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice>            m_device_ptr;
+        std::vector<FrameSlot>                      m_frame_slots;
+        bool                                        m_is_frame_active;
+        uint32_t                                    m_n_current_frame_slot;
+        uint32_t                                    m_n_dropped_frames;
+        uint32_t                                    m_n_frames_in_flight;
+        uint32_t                                    m_n_max_trace_events;
+        uint32_t                                    m_n_max_zones_per_frame;
+        uint32_t                                    m_n_next_trace_event;
+        uint32_t                                    m_n_resolved_frames;
+        std::vector<uint32_t>                       m_open_zones;
+        std::vector<uint64_t>                       m_query_results;
+        double                                      m_timestamp_period_ns;
+        bool                                        m_trace_base_timestamp_set;
+        uint64_t                                    m_trace_base_timestamp;
+        std::vector<TraceEvent>                     m_trace_events;
+        std::map<std::string, GPUProfilerZoneStats> m_zone_stats;
+    };
+
+    /** Measures the zone spanning the life-time of the instance. */
+    class GPUProfilerScope
+    {
+    public:
+        /* Public functions */
+
+        /** Starts a new zone. Please see GPUProfiler::begin_zone() for more details. */
+        GPUProfilerScope(Anvil::GPUProfiler*                       in_profiler_ptr,
+                         std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                         const char*                               in_name)
+            :m_cmd_buffer_ptr(in_cmd_buffer_ptr),
+             m_profiler_ptr  (in_profiler_ptr)
+        {
+            m_profiler_ptr->begin_zone(m_cmd_buffer_ptr,
+                                       in_name);
+        }
+
+        /** Ends the zone. */
+        ~GPUProfilerScope()
+        {
+            m_profiler_ptr->end_zone(m_cmd_buffer_ptr);
+        }
+
+    private:
+        GPUProfilerScope           (const GPUProfilerScope&);
+        GPUProfilerScope& operator=(const GPUProfilerScope&);
+
+        std::shared_ptr<Anvil::CommandBufferBase> m_cmd_buffer_ptr;
+        Anvil::GPUProfiler*                       m_profiler_ptr;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_GPU_PROFILER_H */
@@ -144,6 +144,48 @@ namespace Anvil
                                           VkExtent3D                    in_extent,
                                           MemoryFeatureFlags            in_required_memory_features);
 
+        /** Adds a new transient Buffer object, which is only going to be accessed between the
+         *  @param in_first_use and @param in_last_use points of an app-defined timeline (eg. indices
+         *  of render passes within a frame).
+         *
+         *  At baking time, transient objects whose life-times do not overlap may be assigned
+         *  overlapping memory regions. It is the app's responsibility to synchronize accesses to
+         *  such objects and to treat their contents as undefined at first use.
+         *
+         *  @param in_buffer_ptr               Buffer to configure storage for at bake() call time. Must not
+         *                                     be nullptr.
+         *  @param in_first_use                Index of the first point of the timeline, at which the buffer
+         *                                     is accessed.
+         *  @param in_last_use                 Index of the last point of the timeline, at which the buffer
+         *                                     is accessed. Must not be smaller than @param in_first_use.
+         *  @param in_required_memory_features Memory features the assigned memory must support.
+         *                                     See MemoryFeatureFlagBits for more details.
+         *
+         *  @return true if the buffer has been successfully scheduled for baking, false otherwise.
+         **/
+        bool add_transient_buffer(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                  uint32_t                       in_first_use,
+                                  uint32_t                       in_last_use,
+                                  MemoryFeatureFlags             in_required_memory_features);
+
+        /** Adds a new non-sparse transient Image object. Please see add_transient_buffer() for more details.
+         *
+         *  @param in_image_ptr                Image to configure storage for at bake() call time. Must not
+         *                                     be nullptr.
+         *  @param in_first_use                Index of the first point of the timeline, at which the image
+         *                                     is accessed.
+         *  @param in_last_use                 Index of the last point of the timeline, at which the image
+         *                                     is accessed. Must not be smaller than @param in_first_use.
+         *  @param in_required_memory_features Memory features the assigned memory must support.
+         *                                     See MemoryFeatureFlagBits for more details.
+         *
+         *  @return true if the image has been successfully scheduled for baking, false otherwise.
+         **/
+        bool add_transient_image_whole(std::shared_ptr<Anvil::Image> in_image_ptr,
+                                       uint32_t                      in_first_use,
+                                       uint32_t                      in_last_use,
+                                       MemoryFeatureFlags            in_required_memory_features);
+
         /** Tries to create a memory object of size large enough to capacitate all added objects,
          *  given their alignment, size, and other requirements.
          *
@@ -151,7 +193,8 @@ namespace Anvil
          *  called with more details about what memory object they should use, along with
          *  a start offset and size of the granted allocation.
          *
-         *  The allocations are guaranteed not to overlap.
+         *  The allocations are guaranteed not to overlap, unless they belong to transient objects
+         *  with disjoint life-times.
          *
          *  @return true if successful, false otherwise.
          **/
@@ -214,6 +257,10 @@ namespace Anvil
             VkDeviceSize                        alloc_offset;
             VkDeviceSize                        alloc_size;
 
+            bool     is_transient;
+            uint32_t transient_first_use;
+            uint32_t transient_last_use;
+
             VkExtent3D         extent;
             VkDeviceSize       miptail_offset;
             uint32_t           n_layer;
@@ -233,6 +280,9 @@ namespace Anvil
                 alloc_offset                    = UINT64_MAX;
                 alloc_size                      = in_alloc_size;
                 buffer_ptr                      = in_buffer_ptr;
+                is_transient                    = false;
+                transient_first_use             = 0;
+                transient_last_use              = 0;
                 type                            = ITEM_TYPE_BUFFER;
             }
 
@@ -253,6 +303,9 @@ namespace Anvil
                 image_ptr                       = in_image_ptr;
                 miptail_offset                  = in_miptail_offset;
                 n_layer                         = in_n_layer;
+                is_transient                    = false;
+                transient_first_use             = 0;
+                transient_last_use              = 0;
                 type                            = ITEM_TYPE_SPARSE_IMAGE_MIPTAIL;
             }
 
@@ -275,6 +328,9 @@ namespace Anvil
                 image_ptr                       = in_image_ptr;
                 offset                          = in_offset;
                 subresource                     = in_subresource;
+                is_transient                    = false;
+                transient_first_use             = 0;
+                transient_last_use              = 0;
                 type                            = ITEM_TYPE_SPARSE_IMAGE_SUBRESOURCE;
             }
 
@@ -291,6 +347,9 @@ namespace Anvil
                 alloc_offset                    = UINT64_MAX;
                 alloc_size                      = in_alloc_size;
                 image_ptr                       = in_image_ptr;
+                is_transient                    = false;
+                transient_first_use             = 0;
+                transient_last_use              = 0;
                 type                            = ITEM_TYPE_IMAGE_WHOLE;
             }
 
@@ -0,0 +1,153 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a persistent pipeline cache, which lets applications reuse pipeline compilation results
+ *  across process runs.
+ *
+ *  At creation time, the cache attempts to load pipeline cache data from a file, stored in a user-specified
+ *  directory. The file name is derived from the vendor & device IDs of the physical device. Data is only
+ *  used if it was generated for the same device: vendor ID, device ID, driver version and pipeline cache UUID
+ *  must all match, and the checksum of the payload must be correct. Otherwise, the cache starts empty.
+ *
+ *  store() writes cache data back to the file. The data is first written to a temporary file, which then
+ *  replaces the previous one. This ensures a crash or a full disk never leaves a truncated cache behind.
+ *  If the cache is owned by a device, store() is called automatically at device destruction time.
+ *
+ *  Threads which create pipelines on their own can use get_thread_pipeline_cache() to retrieve a pipeline
+ *  cache used exclusively by the calling thread. Thread caches are merged into the main cache by store().
+ *
+ *  This class is thread-safe.
+ **/
+#ifndef MISC_PERSISTENT_PIPELINE_CACHE_H
+#define MISC_PERSISTENT_PIPELINE_CACHE_H
+
+#include "../misc/types.h"
+#include <mutex>
+#include <thread>
+
+
+namespace Anvil
+{
+    class PersistentPipelineCache
+    {
+    public:
+        /* Public functions */
+
+        /** Creates a new persistent pipeline cache instance and pre-populates it with data stored in
+         *  @param in_cache_directory, if the data is compatible with the device.
+         *
+         *  @param in_device_ptr      Device to create the pipeline caches for. Must not be nullptr.
+         *  @param in_cache_directory Directory to load cache data from and store it to. The directory must
+         *                            exist.
+         *
+         *  @return New PersistentPipelineCache instance.
+         **/
+        static std::shared_ptr<PersistentPipelineCache> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                               const std::string&               in_cache_directory);
+
+        /** Destructor. Does NOT store the data. */
+        ~PersistentPipelineCache();
+
+        /** Returns full path of the file the cache data is loaded from and stored to. */
+        const std::string& get_filename() const
+        {
+            return m_filename;
+        }
+
+        /** Returns the number of pipeline cache data bytes loaded at creation time. 0 indicates the cache
+         *  has started cold: either no file was found, or its contents were incompatible with the device.
+         **/
+        size_t get_n_loaded_bytes() const
+        {
+            return m_n_loaded_bytes;
+        }
+
+        /** Returns the main pipeline cache. Its contents are written to disk by store(). */
+        std::shared_ptr<Anvil::PipelineCache> get_pipeline_cache() const
+        {
+            return m_pipeline_cache_ptr;
+        }
+
+        /** Returns a pipeline cache, which is only going to be returned to the calling thread. The cache is
+         *  created at first call. Its contents are merged into the main pipeline cache by
+         *  merge_thread_pipeline_caches() and store().
+         **/
+        std::shared_ptr<Anvil::PipelineCache> get_thread_pipeline_cache();
+
+        /** Merges contents of all thread pipeline caches into the main pipeline cache.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool merge_thread_pipeline_caches();
+
+        /** Merges thread pipeline caches into the main one and atomically replaces the cache file with
+         *  the main pipeline cache's contents.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool store();
+
+    private:
+        /* Private type definitions */
+
+        /* Header preceding pipeline cache data in the cache file. The layout does not include any padding. */
+        typedef struct
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t data_size;
+            uint64_t data_hash;
+            uint32_t vendor_id;
+            uint32_t device_id;
+            uint32_t driver_version;
+            uint32_t reserved;
+            uint8_t  pipeline_cache_uuid[VK_UUID_SIZE];
+        } FileHeader;
+
+        typedef std::map<std::thread::id, std::shared_ptr<Anvil::PipelineCache> > ThreadPipelineCacheMap;
+
+        /* Private functions */
+        PersistentPipelineCache(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                const std::string&               in_cache_directory);
+
+        PersistentPipelineCache           (const PersistentPipelineCache&);
+        PersistentPipelineCache& operator=(const PersistentPipelineCache&);
+
+        static uint64_t hash_data                            (const void*       in_data_ptr,
+                                                              size_t            in_data_size);
+        void            init                                 ();
+        void            init_file_header                     (FileHeader*       out_header_ptr) const;
+        bool            is_cache_data_compatible             (const FileHeader& in_header,
+                                                              const void*       in_data_ptr) const;
+        bool            merge_thread_pipeline_caches_internal();
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice>      m_device_ptr;
+        std::string                           m_filename;
+        size_t                                m_n_loaded_bytes;
+        std::shared_ptr<Anvil::PipelineCache> m_pipeline_cache_ptr;
+        std::mutex                            m_mutex;
+        ThreadPipelineCacheMap                m_thread_pipeline_caches;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_PERSISTENT_PIPELINE_CACHE_H */
@@ -0,0 +1,270 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements an aggregator of pipeline statistics queries.
+ *
+ *  Apps wrap each frame with begin_frame() and end_frame() calls, and render passes or dispatches they want
+ *  to measure with begin_region() and end_region() calls. Regions cannot be nested, since only one pipeline
+ *  statistics query can be active at a time.
+ *
+ *  Queries are allocated from a QueryPoolRing, so results of a frame become available N frames later, N being
+ *  the number of frames in flight, and are never waited for. Once a frame's results are read back, the
+ *  aggregator decodes the enabled counters and, for each region name, as well as for the whole frame:
+ *
+ *  - sums the counter values of all region instances of the frame.
+ *  - updates a rolling average of the per-frame sums.
+ *
+ *  Subscribers of PIPELINE_STATISTICS_AGGREGATOR_CALLBACK_ID_FRAME_RESOLVED are notified whenever a frame's
+ *  results have been processed. get_json() can be used to log them.
+ *
+ *  The aggregator is not thread-safe.
+ **/
+#ifndef MISC_PIPELINE_STATISTICS_AGGREGATOR_H
+#define MISC_PIPELINE_STATISTICS_AGGREGATOR_H
+
+#include "../misc/callbacks.h"
+#include "../misc/types.h"
+#include <map>
+
+
+namespace Anvil
+{
+    enum PipelineStatisticsAggregatorCallbackID
+    {
+        /* Call-back issued whenever results of a frame have been read back and aggregated.
+         *
+         * callback_arg: PipelineStatisticsFrameResolvedCallbackData instance.
+         */
+        PIPELINE_STATISTICS_AGGREGATOR_CALLBACK_ID_FRAME_RESOLVED,
+
+        /* Always last */
+        PIPELINE_STATISTICS_AGGREGATOR_CALLBACK_ID_COUNT
+    };
+
+    /* Structure passed as a PIPELINE_STATISTICS_AGGREGATOR_CALLBACK_ID_FRAME_RESOLVED call-back argument */
+    typedef struct PipelineStatisticsFrameResolvedCallbackData
+    {
+        PipelineStatisticsAggregator* aggregator_ptr;
+        uint64_t                      frame_index;
+        bool                          is_complete;
+
+        /** Constructor.
+         *
+         *  @param in_aggregator_ptr Aggregator instance which has processed the frame.
+         *  @param in_frame_index    Index of the frame, as assigned by the underlying QueryPoolRing.
+         *  @param in_is_complete    true if results of all regions of the frame were available.
+         **/
+        explicit PipelineStatisticsFrameResolvedCallbackData(PipelineStatisticsAggregator* in_aggregator_ptr,
+                                                             uint64_t                      in_frame_index,
+                                                             bool                          in_is_complete)
+            :aggregator_ptr(in_aggregator_ptr),
+             frame_index   (in_frame_index),
+             is_complete   (in_is_complete)
+        {
+            /* Stub */
+        }
+    } PipelineStatisticsFrameResolvedCallbackData;
+
+    /** Holds aggregated pipeline statistics of a region, or of a whole frame.
+     *
+     *  Values are stored in counter order. Please see PipelineStatisticsAggregator::get_counter_bit().
+     **/
+    typedef struct PipelineStatisticsRegionStats
+    {
+        /* Sums of counter values of all region instances, recorded in the last frame the region was used in. */
+        std::vector<uint64_t> last_frame_values;
+
+        /* Number of frames, in which the region has been used. */
+        uint32_t n_frames;
+
+        /* Rolling averages of the per-frame sums. Until the number of frames the averages are calculated over
+         * is reached, this is the average of all frames. Afterwards, an exponential moving average with
+         * a smoothing factor of (1 / the number of frames) is used. */
+        std::vector<double> rolling_avg_values;
+
+        /** Dummy constructor */
+        PipelineStatisticsRegionStats()
+        {
+            n_frames = 0;
+        }
+    } PipelineStatisticsRegionStats;
+
+    /** Implements an aggregator of pipeline statistics queries. For more details, please see the header. */
+    class PipelineStatisticsAggregator : public CallbacksSupportProvider
+    {
+    public:
+        /* Public functions */
+
+        /** Starts a new frame. Aggregates results of the frame which has been started N frames earlier,
+         *  if they have been read back, and notifies the subscribers.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record query reset commands to. Please see
+         *                           QueryPoolRing::begin_frame() for more details.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool begin_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr);
+
+        /** Starts a new region, by beginning a pipeline statistics query.
+         *
+         *  If the frame's region capacity has been exhausted, the region is ignored. The corresponding
+         *  end_region() call must still be made.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the command to.
+         *  @param in_name           Region name. Regions sharing the same name share statistics.
+         *
+         *  @return true if the region is going to be measured, false otherwise.
+         **/
+        bool begin_region(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                          const char*                               in_name);
+
+        /** Creates a new PipelineStatisticsAggregator instance.
+         *
+         *  @param in_device_ptr                    Device to use.
+         *  @param in_pipeline_statistics           Pipeline statistics to gather. Must not be 0. The device
+         *                                          must support the pipelineStatisticsQuery feature.
+         *  @param in_n_frames_in_flight            Number of frames which can be executed by the GPU at the same
+         *                                          time. Must not be 0.
+         *  @param in_n_max_regions_per_frame       Maximum number of regions which can be measured in a frame.
+         *  @param in_n_rolling_avg_frames          Number of frames the rolling averages are calculated over.
+         *                                          Must not be 0.
+         *  @param in_should_copy_results_to_buffer Please see QueryPoolRing::create() for more details.
+         *
+         *  @return New instance if successful, nullptr otherwise.
+         **/
+        static std::shared_ptr<PipelineStatisticsAggregator> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                                    VkQueryPipelineStatisticFlags    in_pipeline_statistics,
+                                                                    uint32_t                         in_n_frames_in_flight,
+                                                                    uint32_t                         in_n_max_regions_per_frame,
+                                                                    uint32_t                         in_n_rolling_avg_frames,
+                                                                    bool                             in_should_copy_results_to_buffer);
+
+        /** Ends the current frame. Please see QueryPoolRing::end_frame() for more details. */
+        bool end_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr);
+
+        /** Ends the current region.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the command to.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool end_region(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr);
+
+        /** Destructor. */
+        virtual ~PipelineStatisticsAggregator();
+
+        /** Returns the pipeline statistic bit, whose values are stored at index @param in_n_counter. */
+        VkQueryPipelineStatisticFlagBits get_counter_bit(uint32_t in_n_counter) const
+        {
+            anvil_assert(in_n_counter < m_counter_bits.size() );
+
+            return m_counter_bits[in_n_counter];
+        }
+
+        /** Returns a human-readable name of the specified pipeline statistic, eg. "vertex_shader_invocations". */
+        static const char* get_counter_name(VkQueryPipelineStatisticFlagBits in_counter_bit);
+
+        /** Returns statistics of all regions used in the frames processed so far. */
+        const PipelineStatisticsRegionStats& get_frame_stats() const
+        {
+            return m_frame_stats;
+        }
+
+        /** Returns statistics of the last processed frame and rolling averages in JSON format. */
+        std::string get_json() const;
+
+        /** Returns index of the last processed frame, or UINT64_MAX if no frame has been processed yet. */
+        uint64_t get_last_resolved_frame_index() const
+        {
+            return m_last_resolved_frame_index;
+        }
+
+        /** Returns the number of enabled counters. */
+        uint32_t get_n_counters() const
+        {
+            return static_cast<uint32_t>(m_counter_bits.size() );
+        }
+
+        /** Returns statistics, mapped to region names. */
+        const std::map<std::string, PipelineStatisticsRegionStats>& get_region_stats() const
+        {
+            return m_region_stats;
+        }
+
+        /** Returns statistics of the region with the specified name.
+         *
+         *  @param in_name       Name of the region to return statistics for.
+         *  @param out_stats_ptr Deref will be set to the statistics. Must not be nullptr.
+         *
+         *  @return true if the region has been measured at least once, false otherwise.
+         **/
+        bool get_region_stats(const std::string&             in_name,
+                              PipelineStatisticsRegionStats* out_stats_ptr) const;
+
+    private:
+        /* Private type definitions */
+        typedef struct FrameRegionValues
+        {
+            uint32_t              n_instances;
+            std::vector<uint64_t> values;
+
+            FrameRegionValues()
+            {
+                n_instances = 0;
+            }
+        } FrameRegionValues;
+
+        /* Private functions */
+        PipelineStatisticsAggregator(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                     VkQueryPipelineStatisticFlags    in_pipeline_statistics,
+                                     uint32_t                         in_n_frames_in_flight,
+                                     uint32_t                         in_n_max_regions_per_frame,
+                                     uint32_t                         in_n_rolling_avg_frames);
+
+        PipelineStatisticsAggregator           (const PipelineStatisticsAggregator&);
+        PipelineStatisticsAggregator& operator=(const PipelineStatisticsAggregator&);
+
+        bool init          (bool                           in_should_copy_results_to_buffer);
+        void resolve_frame ();
+        void update_stats  (const std::vector<uint64_t>&   in_frame_values,
+                            PipelineStatisticsRegionStats* in_stats_ptr);
+
+        /* Private variables */
+        Anvil::QueryIndex                                    m_active_query;
+        std::vector<VkQueryPipelineStatisticFlagBits>        m_counter_bits;
+        std::weak_ptr<Anvil::BaseDevice>                     m_device_ptr;
+        PipelineStatisticsRegionStats                        m_frame_stats;
+        std::vector<uint64_t>                                m_frame_values;
+        std::map<std::string, FrameRegionValues>             m_frame_values_per_region;
+        bool                                                 m_is_region_active;
+        uint64_t                                             m_last_resolved_frame_index;
+        uint32_t                                             m_n_frames_in_flight;
+        uint32_t                                             m_n_max_regions_per_frame;
+        uint32_t                                             m_n_rolling_avg_frames;
+        VkQueryPipelineStatisticFlags                        m_pipeline_statistics;
+        std::shared_ptr<Anvil::QueryPoolRing>                m_query_pool_ring_ptr;
+        std::vector<std::vector<std::string> >               m_region_names_per_frame_slot;
+        std::map<std::string, PipelineStatisticsRegionStats> m_region_stats;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_PIPELINE_STATISTICS_AGGREGATOR_H */
@@ -33,13 +33,23 @@
  *  3. Finally, at the top we have specialized classes which inherit from Pool. At instantiation time,
  *     they initialize a worker's instance and pass it down to the middle layer.
  *
- *  Pools are NOT thread-safe at the moment. This will be added in the near future.
+ *  Both get_item() and return_item() are O(1). Each handed-out item carries the index of the pool slot
+ *  it came from, and free slots are linked into an intrusive free list.
+ *
+ *  Pools are NOT thread-safe by default. A pool created in thread-safe mode keeps a small cache
+ *  ("magazine") of free slots per thread, and exchanges slots in batches via a lock-free global stack.
+ *  Worker calls are serialized by the pool, unless the worker reports it is thread-safe.
  */
 #ifndef WRAPPERS_POOLS_H
 #define WRAPPERS_POOLS_H
 
+#include "../misc/debug.h"
 #include "../misc/types.h"
+#include <atomic>
 #include <forward_list>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 
 namespace Anvil
@@ -49,6 +59,11 @@ namespace Anvil
               class PoolItemPtrType>
     class GenericPool;
 
+    /** Returns a small integer, unique to the calling thread. Used by pools working in thread-safe mode
+     *  to pick the magazine to use.
+     **/
+    uint32_t get_pool_thread_index();
+
     /** A generic pool item interface which provides life-time control & reset facilities
      *  to the pool.
      **/
@@ -65,27 +80,15 @@ namespace Anvil
         virtual PoolItem create_item ()                  = 0;
         virtual void     release_item(PoolItem item_ptr) = 0;
         virtual void     reset_item  (PoolItem item_ptr) = 0;
-    };
 
-    /** Generic pool implementation  */
-    template<class PoolItemType, class PoolItemPtrType>
-    struct PoolItemContainer
-    {
-        PoolItemPtrType item;
-
-        PoolItemContainer()
-        {
-            /* Stub */
-        }
-
-        PoolItemContainer(PoolItemPtrType in_item)
-        {
-            item = in_item;
-        }
-
-        bool operator==(const PoolItemType* item_ptr) const
+        /** Tells whether reset_item() can be called from many threads at the same time. If false,
+         *  pools working in thread-safe mode serialize reset_item() calls.
+         *
+         *  create_item() and release_item() calls are always serialized.
+         **/
+        virtual bool is_reset_item_thread_safe() const
         {
-            return item.get() == item_ptr;
+            return false;
         }
     };
 
@@ -102,22 +105,28 @@ namespace Anvil
     {
         /** Constructor.
          *
-         *  @param in_pool_ptr Pointer to the command buffer pool, to which the command buffer
-         *                     should be returned when the auto pointer goes out of scope. Must
-         *                     not be nullptr.
+         *  @param in_pool_ptr   Pointer to the command buffer pool, to which the command buffer
+         *                       should be returned when the auto pointer goes out of scope. Must
+         *                       not be nullptr.
+         *  @param in_slot_index Index of the pool slot the item has been taken from.
          **/
-        ReturnToPoolFunctor(GenericPool<PoolItemType, PoolItemPtrType>* in_pool_ptr)
+        ReturnToPoolFunctor(GenericPool<PoolItemType, PoolItemPtrType>* in_pool_ptr,
+                            uint32_t                                    in_slot_index)
         {
-            pool_ptr = in_pool_ptr;
+            pool_ptr   = in_pool_ptr;
+            slot_index = in_slot_index;
         }
 
         void operator()(PoolItemType* item)
         {
-            pool_ptr->return_item(item);
+            ANVIL_REDUNDANT_ARGUMENT(item);
+
+            pool_ptr->return_item(slot_index);
         }
 
     private:
         GenericPool<PoolItemType, PoolItemPtrType>* pool_ptr;
+        uint32_t                                    slot_index;
     };
 
     template <class PoolItemType,
@@ -134,20 +143,29 @@ namespace Anvil
          *  @param in_n_items_to_preallocate Number of pool items to preallocate.
          *  @param in_worker_ptr             Pointer to the pool item worker implementation.
          *                                   Must not be nullptr. Also see the note above.
+         *  @param in_is_thread_safe         true if get_item() and return_item() are going to be called
+         *                                   from more than one thread at a time. Defaults to false.
          *
          **/
         GenericPool(uint32_t                      in_n_items_to_preallocate,
-                    IPoolWorker<PoolItemPtrType>* in_worker_ptr)
-            :m_capacity  (in_n_items_to_preallocate),
-             m_worker_ptr(in_worker_ptr)
+                    IPoolWorker<PoolItemPtrType>* in_worker_ptr,
+                    bool                          in_is_thread_safe = false)
+            :m_capacity      (in_n_items_to_preallocate),
+             m_free_slot_head(0),
+             m_is_thread_safe(in_is_thread_safe),
+             m_n_slots       (0),
+             m_worker_ptr    (in_worker_ptr)
         {
+            if (m_is_thread_safe)
+            {
+                m_magazines.reset(new Magazine[N_MAGAZINES]);
+            }
+
             for (uint32_t n_item = 0;
                           n_item < in_n_items_to_preallocate;
                         ++n_item)
             {
-                PoolItemContainer<PoolItemType, PoolItemPtrType> new_item_container(m_worker_ptr->create_item() );
-
-                m_available_pool_item_containers.push_back(new_item_container);
+                push_free_slot(create_slot() );
             }
         }
 
@@ -158,22 +176,17 @@ namespace Anvil
          **/
         virtual ~GenericPool()
         {
-            while (!m_active_pool_item_containers.empty())
-            {
-                Anvil::PoolItemContainer<PoolItemType, PoolItemPtrType> current_item_container = m_active_pool_item_containers.front();
-
-                m_worker_ptr->release_item(current_item_container.item);
+            const uint32_t n_slots = m_n_slots.load();
 
-                m_active_pool_item_containers.pop_back();
-            }
-
-            while (!m_available_pool_item_containers.empty())
+            for (uint32_t n_slot = 0;
+                          n_slot < n_slots;
+                        ++n_slot)
             {
-                Anvil::PoolItemContainer<PoolItemType, PoolItemPtrType> current_item_container = m_available_pool_item_containers.front();
+                Slot& current_slot = get_slot(n_slot);
 
-                m_worker_ptr->release_item(current_item_container.item);
+                m_worker_ptr->release_item(current_slot.item);
 
-                m_available_pool_item_containers.pop_back();
+                current_slot.item = PoolItemPtrType();
             }
 
             if (m_worker_ptr != nullptr)
@@ -200,64 +213,100 @@ namespace Anvil
          *  @return As per description. */
         PoolItemPtrType get_item()
         {
-            ReturnToPoolFunctor<PoolItemType, PoolItemPtrType> release_functor(this);
-            PoolItemPtrType                                    result;
+            PoolItemPtrType result;
+            uint32_t        slot_index = INVALID_SLOT_INDEX;
 
-            if (!m_available_pool_item_containers.empty())
+            if (m_is_thread_safe)
             {
-                result = PoolItemPtrType(m_available_pool_item_containers.back().item.get(),
-                                         release_functor);
+                Magazine& magazine = m_magazines[get_pool_thread_index() % N_MAGAZINES];
 
-                m_active_pool_item_containers.push_back  (m_available_pool_item_containers.back() );
-                m_available_pool_item_containers.pop_back();
+                magazine.lock();
+                {
+                    if (magazine.n_slots == 0)
+                    {
+                        /* Refill the magazine from the global stack */
+                        uint32_t popped_slot_index;
+
+                        while (magazine.n_slots < MAGAZINE_CAPACITY / 2                   &&
+                               (popped_slot_index = pop_free_slot() ) != INVALID_SLOT_INDEX)
+                        {
+                            magazine.slot_indices[magazine.n_slots++] = popped_slot_index;
+                        }
+                    }
+
+                    if (magazine.n_slots > 0)
+                    {
+                        slot_index = magazine.slot_indices[--magazine.n_slots];
+                    }
+                }
+                magazine.unlock();
             }
             else
             {
-                PoolItemContainer<PoolItemType, PoolItemPtrType> new_item_container(m_worker_ptr->create_item() );
+                slot_index = pop_free_slot();
+            }
+
+            if (slot_index == INVALID_SLOT_INDEX)
+            {
+                slot_index = create_slot();
+            }
 
-                m_active_pool_item_containers.push_back(new_item_container);
+            {
+                Slot& slot = get_slot(slot_index);
 
-                result = PoolItemPtrType(m_active_pool_item_containers.back().item.get(),
-                                         release_functor);
+                result = PoolItemPtrType(slot.item.get(),
+                                         ReturnToPoolFunctor<PoolItemType, PoolItemPtrType>(this,
+                                                                                            slot_index) );
             }
 
-            m_worker_ptr->reset_item(result);
+            if (m_is_thread_safe                           &&
+               !m_worker_ptr->is_reset_item_thread_safe() )
+            {
+                std::unique_lock<std::mutex> lock(m_worker_mutex);
+
+                m_worker_ptr->reset_item(result);
+            }
+            else
+            {
+                m_worker_ptr->reset_item(result);
+            }
 
             return result;
         }
 
-        /** Stores the provided instance back in the pool. */
-        void return_item(PoolItemType* item_ptr)
+        /** Stores the item held by slot @param in_slot_index back in the pool. Called by ReturnToPoolFunctor
+         *  when the last reference to an item returned by get_item() is dropped.
+         **/
+        void return_item(uint32_t in_slot_index)
         {
-            PoolItemContainer<PoolItemType, PoolItemPtrType> container;
-            bool                                             has_found = false;
-
-            ANVIL_REDUNDANT_VARIABLE(has_found);
+            anvil_assert(in_slot_index < m_n_slots.load(std::memory_order_relaxed) );
 
-            for (auto iterator  = m_active_pool_item_containers.begin();
-                      iterator != m_active_pool_item_containers.end();
-                    ++iterator)
+            if (m_is_thread_safe)
             {
-                if (iterator->item.get() == item_ptr)
-                {
-                    container = *iterator;
-                    has_found = true;
-
-                    m_active_pool_item_containers.erase(iterator);
+                Magazine& magazine = m_magazines[get_pool_thread_index() % N_MAGAZINES];
 
-                    break;
+                magazine.lock();
+                {
+                    if (magazine.n_slots == MAGAZINE_CAPACITY)
+                    {
+                        /* Spill half of the magazine to the global stack */
+                        while (magazine.n_slots > MAGAZINE_CAPACITY / 2)
+                        {
+                            push_free_slot(magazine.slot_indices[--magazine.n_slots]);
+                        }
+                    }
+
+                    magazine.slot_indices[magazine.n_slots++] = in_slot_index;
                 }
+                magazine.unlock();
+            }
+            else
+            {
+                push_free_slot(in_slot_index);
             }
-
-            anvil_assert(has_found);
-
-            m_available_pool_item_containers.push_back(container);
         }
 
     protected:
-        /* Protected type declarations */
-        typedef std::vector<PoolItemContainer<PoolItemType, PoolItemPtrType> > PoolItemContainers;
-
         /* Protected functions */
 
         /** Retrieves the underlying pool worker instance */
@@ -266,13 +315,226 @@ namespace Anvil
             return m_worker_ptr;
         }
 
-        /* Protected variables */
-        PoolItemContainers m_active_pool_item_containers;
-        PoolItemContainers m_available_pool_item_containers;
-
     private:
+        /* Private type declarations */
+        enum
+        {
+            /* Slot storage is split into segments, each twice as large as the previous one. Segments are
+             * never moved, so a slot can be accessed while other threads add new ones. */
+            FIRST_SLOT_SEGMENT_SIZE = 32,
+            N_MAX_SLOT_SEGMENTS     = 26,
+
+            MAGAZINE_CAPACITY       = 32,
+            N_MAGAZINES             = 16
+        };
+
+        static const uint32_t INVALID_SLOT_INDEX = UINT32_MAX;
+
+        typedef struct Slot
+        {
+            PoolItemPtrType       item;
+            std::atomic<uint32_t> next_free_slot_index;
+
+            Slot()
+                :next_free_slot_index(INVALID_SLOT_INDEX)
+            {
+                /* Stub */
+            }
+        } Slot;
+
+        /** A per-thread cache of free slots. Threads whose indices map to the same magazine share it,
+         *  so each magazine is guarded by a spin lock, which is uncontended in the common case. Under
+         *  contention, the lock yields after a short spin, so that a preempted owner can make progress. */
+        typedef struct Magazine
+        {
+            std::atomic<bool> is_locked;
+            uint32_t          n_slots;
+            uint32_t          slot_indices[MAGAZINE_CAPACITY];
+
+            Magazine()
+                :is_locked(false),
+                 n_slots  (0)
+            {
+                /* Stub */
+            }
+
+            void lock()
+            {
+                static const uint32_t n_max_spins = 64;
+
+                while (is_locked.exchange(true,
+                                          std::memory_order_acquire) )
+                {
+                    /* Wait for the lock to be released without writing to the cache line */
+                    for (uint32_t n_spins = 0;
+                                  is_locked.load(std::memory_order_relaxed);
+                                ++n_spins)
+                    {
+                        if (n_spins >= n_max_spins)
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+            }
+
+            void unlock()
+            {
+                is_locked.store(false,
+                                std::memory_order_release);
+            }
+        } Magazine;
+
+        /* Private functions */
+        GenericPool           (const GenericPool&);
+        GenericPool& operator=(const GenericPool&);
+
+        /** Creates a new pool item and a slot to hold it.
+         *
+         *  @return Index of the new slot. The slot is not linked into the free list.
+         **/
+        uint32_t create_slot()
+        {
+            std::unique_lock<std::mutex> lock      (m_worker_mutex);
+            const uint32_t               new_index = m_n_slots.load(std::memory_order_relaxed);
+            uint32_t                     n_segment;
+            uint32_t                     segment_start_index;
+
+            get_slot_location(new_index,
+                             &n_segment,
+                             &segment_start_index);
+
+            anvil_assert(n_segment < N_MAX_SLOT_SEGMENTS);
+
+            if (m_slot_segments[n_segment] == nullptr)
+            {
+                m_slot_segments[n_segment].reset(new Slot[static_cast<uint32_t>(FIRST_SLOT_SEGMENT_SIZE) << n_segment]);
+            }
+
+            m_slot_segments[n_segment][new_index - segment_start_index].item = m_worker_ptr->create_item();
+
+            m_n_slots.store(new_index + 1,
+                            std::memory_order_relaxed);
+
+            return new_index;
+        }
+
+        /** Returns the slot at index @param in_slot_index */
+        Slot& get_slot(uint32_t in_slot_index)
+        {
+            uint32_t n_segment;
+            uint32_t segment_start_index;
+
+            get_slot_location(in_slot_index,
+                             &n_segment,
+                             &segment_start_index);
+
+            return m_slot_segments[n_segment][in_slot_index - segment_start_index];
+        }
+
+        /** Works out which slot segment holds the slot at index @param in_slot_index, and the index
+         *  of the first slot stored in that segment.
+         **/
+        static void get_slot_location(uint32_t  in_slot_index,
+                                      uint32_t* out_n_segment_ptr,
+                                      uint32_t* out_segment_start_index_ptr)
+        {
+            /* Segment n holds slots [FIRST_SLOT_SEGMENT_SIZE * (2^n - 1), FIRST_SLOT_SEGMENT_SIZE * (2^(n + 1) - 1) ) */
+            uint32_t n_segment = 0;
+            uint32_t value     = in_slot_index / FIRST_SLOT_SEGMENT_SIZE + 1;
+
+            while (value > 1)
+            {
+                value >>= 1;
+
+                ++n_segment;
+            }
+
+            *out_n_segment_ptr           = n_segment;
+            *out_segment_start_index_ptr = FIRST_SLOT_SEGMENT_SIZE * ((1u << n_segment) - 1);
+        }
+
+        /** Pops a slot off the free list.
+         *
+         *  In thread-safe mode, the free list is a lock-free stack. The upper 32 bits of the head carry
+         *  a tag, which is bumped with each update to protect against the ABA problem.
+         *
+         *  @return Index of the popped slot, or INVALID_SLOT_INDEX if the list is empty.
+         **/
+        uint32_t pop_free_slot()
+        {
+            uint64_t current_head = m_free_slot_head.load(std::memory_order_acquire);
+            uint64_t new_head;
+            uint32_t result;
+
+            do
+            {
+                /* Lower 32 bits hold (slot index + 1), so that a zero head denotes an empty list */
+                if (static_cast<uint32_t>(current_head) == 0)
+                {
+                    result = INVALID_SLOT_INDEX;
+
+                    goto end;
+                }
+
+                result   = static_cast<uint32_t>(current_head) - 1;
+                new_head = ((current_head >> 32) + 1) << 32                                                                    |
+                           static_cast<uint64_t>(get_slot(result).next_free_slot_index.load(std::memory_order_relaxed) + 1);
+
+                if (!m_is_thread_safe)
+                {
+                    m_free_slot_head.store(new_head,
+                                           std::memory_order_relaxed);
+
+                    break;
+                }
+            }
+            while (!m_free_slot_head.compare_exchange_weak(current_head,
+                                                           new_head,
+                                                           std::memory_order_acquire,
+                                                           std::memory_order_acquire) );
+
+        end:
+            return result;
+        }
+
+        /** Pushes slot @param in_slot_index onto the free list. Please see pop_free_slot() for more details. */
+        void push_free_slot(uint32_t in_slot_index)
+        {
+            uint64_t current_head = m_free_slot_head.load(std::memory_order_relaxed);
+            uint64_t new_head;
+            Slot&    slot         = get_slot(in_slot_index);
+
+            do
+            {
+                slot.next_free_slot_index.store(static_cast<uint32_t>(current_head) - 1,
+                                                std::memory_order_relaxed);
+
+                new_head = ((current_head >> 32) + 1) << 32 |
+                           static_cast<uint64_t>(in_slot_index + 1);
+
+                if (!m_is_thread_safe)
+                {
+                    m_free_slot_head.store(new_head,
+                                           std::memory_order_relaxed);
+
+                    break;
+                }
+            }
+            while (!m_free_slot_head.compare_exchange_weak(current_head,
+                                                           new_head,
+                                                           std::memory_order_release,
+                                                           std::memory_order_relaxed) );
+        }
+
         /* Private variables */
         uint32_t                      m_capacity;
+        std::atomic<uint64_t>         m_free_slot_head;
+        bool                          m_is_thread_safe;
+        std::unique_ptr<Magazine[]>   m_magazines;
+        std::atomic<uint32_t>         m_n_slots;
+        std::unique_ptr<Slot[]>       m_slot_segments[N_MAX_SLOT_SEGMENTS];
+        std::mutex                    m_worker_mutex;
         IPoolWorker<PoolItemPtrType>* m_worker_ptr;
     };
 
@@ -294,7 +556,7 @@ namespace Anvil
         CommandBufferPoolWorker(std::shared_ptr<Anvil::CommandPool> parent_command_pool_ptr)
             :m_parent_command_pool_ptr(parent_command_pool_ptr)
         {
-            anvil_assert(m_parent_command_pool_ptr != nullptr)
+            anvil_assert(m_parent_command_pool_ptr != nullptr);
         }
 
         /** Destructor.
@@ -384,17 +646,24 @@ namespace Anvil
          *  @param parent_command_pool_ptr Command pool instance, from which command buffers
          *                                 should be spawned. Must not be nullptr.
          *  @param n_preallocated_items    Number of command buffers to preallocate at creation time.
+         *  @param is_thread_safe          true if command buffers are going to be taken from & returned
+         *                                 to the pool by more than one thread at a time. Note that the
+         *                                 command buffers are still allocated from a single command pool,
+         *                                 so recording them concurrently is not allowed by Vulkan.
+         *                                 Defaults to false.
          *
          **/
         static std::shared_ptr<CommandBufferPool<PoolWorker, CommandBufferType, CommandBufferPtrType> > create(std::shared_ptr<Anvil::CommandPool> parent_command_pool_ptr,
-                                                                                                               uint32_t                            n_preallocated_items)
+                                                                                                               uint32_t                            n_preallocated_items,
+                                                                                                               bool                                is_thread_safe = false)
         {
             std::shared_ptr<CommandBufferPool<PoolWorker, CommandBufferType, CommandBufferPtrType> > result_ptr;
 
             result_ptr.reset(
                 new CommandBufferPool<PoolWorker, CommandBufferType, CommandBufferPtrType>(parent_command_pool_ptr,
                                                                                            n_preallocated_items,
-                                                                                           new PoolWorker(parent_command_pool_ptr))
+                                                                                           new PoolWorker(parent_command_pool_ptr),
+                                                                                           is_thread_safe)
             );
 
             return result_ptr;
@@ -411,9 +680,11 @@ namespace Anvil
         /* Constructor. Please see create() for documentation */
         CommandBufferPool(std::shared_ptr<Anvil::CommandPool> parent_command_pool_ptr,
                           uint32_t                            n_preallocated_items,
-                          PoolWorker*                         pool_worker_ptr)
+                          PoolWorker*                         pool_worker_ptr,
+                          bool                                is_thread_safe)
             :GenericPool<CommandBufferType, CommandBufferPtrType>(n_preallocated_items,
-                                                                  pool_worker_ptr)
+                                                                  pool_worker_ptr,
+                                                                  is_thread_safe)
         {
             /* Stub */
         }
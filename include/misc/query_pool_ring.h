@@ -0,0 +1,225 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements a ring of query pools, which hands out query ranges per frame and reads back their results
+ *  without stalling the CPU.
+ *
+ *  The ring owns one query pool per frame in flight. Apps wrap each frame with begin_frame() and end_frame()
+ *  calls, and allocate queries for the frame with allocate_queries(). When a frame starts, results of the
+ *  frame which has last used the same query pool (that is, the frame started N frames earlier, N being the
+ *  number of frames in flight) are read back without using VK_QUERY_RESULT_WAIT_BIT, and the pool is reset.
+ *  Results of queries which have not completed by then are reported as unavailable.
+ *
+ *  Results can be read back in two ways:
+ *
+ *  - with vkGetQueryPoolResults() calls, issued when a frame starts (default).
+ *  - by recording a vkCmdCopyQueryPoolResults() command at the end of each frame, which copies the results
+ *    to a persistently mapped, host-coherent buffer. The CPU reads the results from the mapped memory
+ *    when the frame slot is reused.
+ *
+ *  All results are exposed as 64-bit values.
+ *
+ *  The ring is not thread-safe.
+ **/
+#ifndef MISC_QUERY_POOL_RING_H
+#define MISC_QUERY_POOL_RING_H
+
+#include "../misc/types.h"
+
+
+namespace Anvil
+{
+    /** Implements a ring of query pools. For more details, please see the header. */
+    class QueryPoolRing
+    {
+    public:
+        /* Public functions */
+
+        /** Allocates a range of consecutive queries from the current frame's query pool.
+         *
+         *  @param in_n_queries        Number of queries to allocate.
+         *  @param out_first_query_ptr Deref will be set to the index of the first allocated query.
+         *                             Must not be nullptr.
+         *
+         *  @return true if successful, false if the frame's query capacity has been exhausted.
+         **/
+        bool allocate_queries(uint32_t           in_n_queries,
+                              Anvil::QueryIndex* out_first_query_ptr);
+
+        /** Tells whether results of all queries of the frame, which have last been read back, were available. */
+        bool are_resolved_results_complete() const
+        {
+            return m_are_resolved_results_complete;
+        }
+
+        /** Starts a new frame.
+         *
+         *  Reads back results of the frame which has last used the query pool assigned to the new frame,
+         *  and records a command resetting the pool.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the reset command to. Must be in recording mode,
+         *                           and outside a render pass. Must be submitted before any commands using
+         *                           queries allocated for the frame.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool begin_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr);
+
+        /** Creates a new QueryPoolRing instance.
+         *
+         *  @param in_device_ptr                    Device to use.
+         *  @param in_query_type                    Type of queries to create the pools for.
+         *  @param in_pipeline_statistics           Pipeline statistics to enable, if @param in_query_type is
+         *                                          VK_QUERY_TYPE_PIPELINE_STATISTICS. Ignored otherwise.
+         *  @param in_n_frames_in_flight            Number of frames which can be executed by the GPU at the same
+         *                                          time. Determines the number of query pools, as well as the
+         *                                          latency of the results. Must not be 0.
+         *  @param in_n_queries_per_frame           Number of queries which can be allocated in a single frame.
+         *                                          Must not be 0.
+         *  @param in_should_copy_results_to_buffer true if the results should be copied to a persistently mapped
+         *                                          buffer on the GPU, false if they should be retrieved with
+         *                                          vkGetQueryPoolResults() calls.
+         *
+         *  @return New instance if successful, nullptr otherwise.
+         **/
+        static std::shared_ptr<QueryPoolRing> create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                     VkQueryType                      in_query_type,
+                                                     VkQueryPipelineStatisticFlags    in_pipeline_statistics,
+                                                     uint32_t                         in_n_frames_in_flight,
+                                                     uint32_t                         in_n_queries_per_frame,
+                                                     bool                             in_should_copy_results_to_buffer);
+
+        /** Ends the current frame.
+         *
+         *  If the ring copies results to a buffer, records the copy command, followed by a barrier which makes
+         *  the results visible to the host.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the commands to. Must be in recording mode, outside
+         *                           a render pass, and must be submitted after all commands using queries
+         *                           allocated for the frame. Ignored if the results are not copied to a buffer.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool end_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr);
+
+        /** Destructor. */
+        ~QueryPoolRing();
+
+        /** Returns the index of the current frame. Frames are indexed from 0, in the order they are started. */
+        uint64_t get_current_frame_index() const
+        {
+            return m_n_started_frames - 1;
+        }
+
+        /** Returns the query pool assigned to the current frame. */
+        std::shared_ptr<Anvil::QueryPool> get_current_query_pool() const;
+
+        /** Returns the number of queries allocated for the frame, whose results have last been read back. */
+        uint32_t get_n_resolved_queries() const
+        {
+            return m_n_resolved_queries;
+        }
+
+        /** Returns the number of values each query produces. */
+        uint32_t get_n_values_per_query() const
+        {
+            return m_n_values_per_query;
+        }
+
+        /** Returns the index of the frame, whose results have last been read back.
+         *
+         *  Only valid if has_resolved_results() returns true.
+         **/
+        uint64_t get_resolved_frame_index() const
+        {
+            return m_resolved_frame_index;
+        }
+
+        /** Returns results of a query of the frame, whose results have last been read back.
+         *
+         *  @param in_n_query Index of the query, as returned by allocate_queries() for that frame.
+         *
+         *  @return Pointer to get_n_values_per_query() values if the query's results are available,
+         *          nullptr otherwise.
+         **/
+        const uint64_t* get_resolved_query_results(Anvil::QueryIndex in_n_query) const;
+
+        /** Tells whether the last begin_frame() call has read back results of an earlier frame. */
+        bool has_resolved_results() const
+        {
+            return m_has_resolved_results;
+        }
+
+    private:
+        /* Private type definitions */
+        typedef struct FrameSlot
+        {
+            uint64_t                          frame_index;
+            bool                              has_pending_results;
+            uint32_t                          n_allocated_queries;
+            std::shared_ptr<Anvil::QueryPool> query_pool_ptr;
+
+            FrameSlot()
+            {
+                frame_index         = 0;
+                has_pending_results = false;
+                n_allocated_queries = 0;
+            }
+        } FrameSlot;
+
+        /* Private functions */
+        QueryPoolRing(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                      VkQueryType                      in_query_type,
+                      VkQueryPipelineStatisticFlags    in_pipeline_statistics,
+                      uint32_t                         in_n_frames_in_flight,
+                      uint32_t                         in_n_queries_per_frame,
+                      bool                             in_should_copy_results_to_buffer);
+
+        QueryPoolRing           (const QueryPoolRing&);
+        QueryPoolRing& operator=(const QueryPoolRing&);
+
+        bool init         ();
+        bool resolve_frame(uint32_t in_n_frame_slot);
+
+        /* Private variables */
+        bool                                m_are_resolved_results_complete;
+        std::weak_ptr<Anvil::BaseDevice>    m_device_ptr;
+        std::vector<FrameSlot>              m_frame_slots;
+        bool                                m_has_resolved_results;
+        bool                                m_is_frame_active;
+        uint64_t*                           m_mapped_results_ptr;
+        uint32_t                            m_n_current_frame_slot;
+        uint32_t                            m_n_frames_in_flight;
+        uint32_t                            m_n_queries_per_frame;
+        uint32_t                            m_n_resolved_queries;
+        uint64_t                            m_n_started_frames;
+        uint32_t                            m_n_values_per_query;
+        VkQueryPipelineStatisticFlags       m_pipeline_statistics;
+        VkQueryType                         m_query_type;
+        uint64_t                            m_resolved_frame_index;
+        std::vector<uint64_t>               m_resolved_results;
+        std::shared_ptr<Anvil::Buffer>      m_results_buffer_ptr;
+        bool                                m_should_copy_results_to_buffer;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_QUERY_POOL_RING_H */
@@ -0,0 +1,279 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements resource state tracking, which is used by command buffers to work out the minimal set of
+ *  barriers required to transition buffer ranges and image subresources between usages.
+ *
+ *  Each command buffer owns a ResourceStateTracker instance. The first time a resource is transitioned
+ *  within a command buffer, the tracker assumes the resource is in the state it was left in by the most
+ *  recently submitted command buffer. When the command buffer is submitted, the states it leaves the
+ *  resources in are committed back to the Buffer and Image instances, so that command buffers submitted
+ *  later on can pick them up.
+ *
+ *  Image states are tracked at layer/mip granularity. All aspects of a subresource are assumed to share
+ *  the same state.
+ **/
+#ifndef MISC_RESOURCE_STATE_TRACKER_H
+#define MISC_RESOURCE_STATE_TRACKER_H
+
+#include "../misc/types.h"
+#include <map>
+
+
+namespace Anvil
+{
+    /** Holds states of a set of non-overlapping byte ranges. Adjacent ranges sharing the same state
+     *  are coalesced into a single descriptor.
+     **/
+    class BufferRangeStates
+    {
+    public:
+        /* Public type declarations */
+        typedef struct Range
+        {
+            VkDeviceSize         end_offset;
+            bool                 has_state;
+            VkDeviceSize         start_offset;
+            Anvil::ResourceState state;
+
+            Range(VkDeviceSize                in_start_offset,
+                  VkDeviceSize                in_end_offset,
+                  bool                        in_has_state,
+                  const Anvil::ResourceState& in_state)
+                :end_offset  (in_end_offset),
+                 has_state   (in_has_state),
+                 start_offset(in_start_offset),
+                 state       (in_state)
+            {
+                /* Stub */
+            }
+        } Range;
+
+        /* Public functions */
+
+        /** Removes all tracked states. */
+        void clear()
+        {
+            m_ranges.clear();
+        }
+
+        /** Returns all ranges which have been assigned a state, sorted by start offset. */
+        const std::vector<Range>& get_ranges() const
+        {
+            return m_ranges;
+        }
+
+        /** Splits the <@param in_start_offset, @param in_end_offset) region into subranges of uniform
+         *  state and appends them, sorted by start offset, to @param out_ranges_ptr.
+         *
+         *  Subranges which have never been assigned a state are reported with has_state set to false.
+         *
+         *  @param in_start_offset Start offset of the region to query.
+         *  @param in_end_offset   End offset of the region to query. Must be larger than @param in_start_offset.
+         *  @param out_ranges_ptr  Deref will be appended the subranges. Must not be nullptr.
+         **/
+        void get_states(VkDeviceSize        in_start_offset,
+                        VkDeviceSize        in_end_offset,
+                        std::vector<Range>* out_ranges_ptr) const;
+
+        /** Assigns a new state to the <@param in_start_offset, @param in_end_offset) region.
+         *
+         *  @param in_start_offset Start offset of the region to update.
+         *  @param in_end_offset   End offset of the region to update. Must be larger than @param in_start_offset.
+         *  @param in_state        State to use.
+         **/
+        void set_state(VkDeviceSize                in_start_offset,
+                       VkDeviceSize                in_end_offset,
+                       const Anvil::ResourceState& in_state);
+
+    private:
+        /* Private variables */
+        std::vector<Range> m_ranges;
+        std::vector<Range> m_temp_ranges;
+    };
+
+    /** Tracks states of resources accessed by a single command buffer & computes barriers necessary to
+     *  transition them to new usages. */
+    class ResourceStateTracker
+    {
+    public:
+        /* Public functions */
+
+        /** Constructor. */
+        ResourceStateTracker();
+
+        /** Destructor. */
+        ~ResourceStateTracker();
+
+        /** Informs the tracker that memory backing @param in_buffer_ptr is shared with other resources,
+         *  which have last been accessed the way described by @param in_aliased_state.
+         *
+         *  The accesses are merged into the tracked state of the buffer, so that the next transition
+         *  waits for them to finish.
+         *
+         *  @param in_buffer_ptr    Buffer which is about to be used for the first time since the aliased
+         *                          resources have been accessed. Must not be nullptr.
+         *  @param in_aliased_state Union of the last states of all aliased resources. Layout is ignored.
+         **/
+        void add_aliasing_dependency(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                     const Anvil::ResourceState&    in_aliased_state);
+
+        /** Informs the tracker that memory backing @param in_image_ptr is shared with other resources.
+         *  Please see the other add_aliasing_dependency() overload for more details.
+         *
+         *  All subresources of the image are considered to hold undefined contents.
+         *
+         *  @param in_image_ptr     Image which is about to be used for the first time since the aliased
+         *                          resources have been accessed. Must not be nullptr.
+         *  @param in_aliased_state Union of the last states of all aliased resources. Layout is ignored.
+         **/
+        void add_aliasing_dependency(std::shared_ptr<Anvil::Image> in_image_ptr,
+                                     const Anvil::ResourceState&   in_aliased_state);
+
+        /** Writes states all tracked resources have been left in back to the Buffer and Image instances.
+         *
+         *  This function should be called whenever the command buffer is submitted for execution.
+         *
+         *  @return true if the states the command buffer assumed the images were in at recording time
+         *          match the states committed by previously submitted command buffers, false otherwise.
+         *          States are committed regardless of the result.
+         **/
+        bool commit();
+
+        /** Drops all tracked states. Should be called whenever the command buffer is reset. */
+        void reset();
+
+        /** Works out dependencies needed to transition a buffer region to a new state & updates the
+         *  tracked state of the region.
+         *
+         *  @param in_buffer_ptr           Buffer to transition. Must not be nullptr. States are tracked for
+         *                                 the base buffer, so that transitions of overlapping sub-buffers
+         *                                 are correctly synchronized.
+         *  @param in_offset               Start offset, relative to @param in_buffer_ptr.
+         *  @param in_size                 Size of the region to transition. May be VK_WHOLE_SIZE.
+         *  @param in_new_state            State to transition the region to.
+         *  @param out_src_stage_mask_ptr  Deref will be OR-ed with source stages of the required dependency.
+         *                                 Left untouched if no dependency is required. Must not be nullptr.
+         *  @param out_buffer_barriers_ptr Deref will be appended buffer barriers the dependency needs to
+         *                                 include. The barriers do not retain the buffer; the tracker does.
+         *                                 Must not be nullptr.
+         **/
+        void transition_buffer(std::shared_ptr<Anvil::Buffer>        in_buffer_ptr,
+                               VkDeviceSize                          in_offset,
+                               VkDeviceSize                          in_size,
+                               const Anvil::ResourceState&           in_new_state,
+                               VkPipelineStageFlags*                 out_src_stage_mask_ptr,
+                               std::vector<Anvil::BufferBarrierRef>* out_buffer_barriers_ptr);
+
+        /** Works out dependencies needed to transition an image subresource range to a new state &
+         *  updates the tracked state of the range.
+         *
+         *  @param in_image_ptr           Image to transition. Must not be nullptr.
+         *  @param in_subresource_range   Subresource range to transition. VK_REMAINING_ARRAY_LAYERS and
+         *                                VK_REMAINING_MIP_LEVELS are accepted.
+         *  @param in_new_state           State to transition the range to.
+         *  @param in_discard_contents    true if the current contents of the range need not be preserved.
+         *                                Transitions from VK_IMAGE_LAYOUT_UNDEFINED will be used in that case.
+         *  @param out_src_stage_mask_ptr Deref will be OR-ed with source stages of the required dependency.
+         *                                Left untouched if no dependency is required. Must not be nullptr.
+         *  @param out_image_barriers_ptr Deref will be appended image barriers the dependency needs to
+         *                                include. The barriers do not retain the image; the tracker does.
+         *                                Must not be nullptr.
+         **/
+        void transition_image(std::shared_ptr<Anvil::Image>        in_image_ptr,
+                              const VkImageSubresourceRange&       in_subresource_range,
+                              const Anvil::ResourceState&          in_new_state,
+                              bool                                 in_discard_contents,
+                              VkPipelineStageFlags*                out_src_stage_mask_ptr,
+                              std::vector<Anvil::ImageBarrierRef>* out_image_barriers_ptr);
+
+    private:
+        /* Private type declarations */
+        typedef struct BufferData
+        {
+            std::shared_ptr<Anvil::Buffer> buffer_ptr;
+            Anvil::BufferRangeStates       current_states;
+            Anvil::BufferRangeStates       initial_states;
+        } BufferData;
+
+        typedef struct ImageSubresourceData
+        {
+            Anvil::ResourceState current_state;
+            Anvil::ResourceState initial_state;
+            bool                 is_used;
+
+            ImageSubresourceData()
+                :is_used(false)
+            {
+                /* Stub */
+            }
+        } ImageSubresourceData;
+
+        typedef struct ImageData
+        {
+            std::shared_ptr<Anvil::Image>     image_ptr;
+            std::vector<ImageSubresourceData> subresources; /* n_mipmap * n_layers + n_layer */
+        } ImageData;
+
+        typedef struct PendingImageBarrier
+        {
+            uint32_t      base_layer;
+            uint32_t      base_mipmap;
+            uint32_t      n_layers;
+            uint32_t      n_mipmaps;
+            VkImageLayout old_layout;
+            VkAccessFlags src_access_mask;
+        } PendingImageBarrier;
+
+        /* Private functions */
+        ResourceStateTracker           (const ResourceStateTracker&);
+        ResourceStateTracker& operator=(const ResourceStateTracker&);
+
+        BufferData& get_buffer_data(std::shared_ptr<Anvil::Buffer> in_base_buffer_ptr,
+                                    VkDeviceSize                   in_start_offset,
+                                    VkDeviceSize                   in_end_offset);
+
+        ImageData&            get_image_data            (std::shared_ptr<Anvil::Image> in_image_ptr);
+        ImageSubresourceData& get_image_subresource_data(ImageData&                    in_image_data,
+                                                         uint32_t                      in_n_layer,
+                                                         uint32_t                      in_n_mipmap,
+                                                         bool                          in_discard_contents);
+
+        static bool get_dependency(const Anvil::ResourceState& in_old_state,
+                                   const Anvil::ResourceState& in_new_state,
+                                   bool                        in_is_image,
+                                   VkPipelineStageFlags*       out_src_stage_mask_ptr,
+                                   VkAccessFlags*              out_src_access_mask_ptr,
+                                   bool*                       out_needs_barrier_ptr,
+                                   Anvil::ResourceState*       out_updated_state_ptr);
+
+        /* Private variables */
+        std::map<Anvil::Buffer*, BufferData> m_buffers;
+        std::map<Anvil::Image*,  ImageData>  m_images;
+
+        std::vector<Anvil::BufferRangeStates::Range> m_temp_committed_ranges;
+        std::vector<PendingImageBarrier>             m_temp_pending_image_barriers;
+        std::vector<Anvil::BufferRangeStates::Range> m_temp_ranges;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_RESOURCE_STATE_TRACKER_H */
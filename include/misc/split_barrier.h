@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/** Implements split barriers, which let independent commands execute while a dependency is being resolved,
+ *  instead of stalling the pipeline at a full pipeline barrier.
+ *
+ *  A split barrier is started with begin(), recorded right after the last command producing data, and ended
+ *  with end(), recorded right before the first command consuming it. begin() records a vkCmdSetEvent() call.
+ *  end() records a vkCmdWaitEvents() call, carrying the memory, buffer and image barriers which would
+ *  otherwise have been passed to a pipeline barrier, followed by a vkCmdResetEvent() call. Commands recorded
+ *  in-between are not affected by the dependency.
+ *
+ *  Events are taken from the device's event pool, and are retained by the command buffers they are recorded
+ *  to, so they return to the pool once those command buffers are reset, re-recorded or released. Since the
+ *  event is reset by the consumer, command buffers holding both halves of a split barrier can be resubmitted
+ *  once their previous submission finishes executing.
+ *
+ *  Both halves must be recorded to command buffers submitted to the same queue, with begin() preceding end()
+ *  in submission order, and outside render passes. A SplitBarrier instance can be reused once it has been
+ *  ended.
+ *
+ *  The class is not thread-safe.
+ **/
+#ifndef MISC_SPLIT_BARRIER_H
+#define MISC_SPLIT_BARRIER_H
+
+#include "../misc/types.h"
+
+
+namespace Anvil
+{
+    /** Implements a split barrier. For more details, please see the header. */
+    class SplitBarrier
+    {
+    public:
+        /* Public functions */
+
+        /** Constructor.
+         *
+         *  @param in_device_ptr Device, whose event pool should be used.
+         **/
+        explicit SplitBarrier(std::weak_ptr<Anvil::BaseDevice> in_device_ptr);
+
+        /** Destructor. The split barrier must not be pending. */
+        ~SplitBarrier();
+
+        /** Starts the split barrier by recording a vkCmdSetEvent() call.
+         *
+         *  @param in_cmd_buffer_ptr Command buffer to record the command to. Must be in recording mode.
+         *  @param in_src_stage_mask Pipeline stages of the preceding commands, which the consumer depends on.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool begin(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                   VkPipelineStageFlags                      in_src_stage_mask);
+
+        /** Ends the split barrier by recording a vkCmdWaitEvents() call with the specified barriers, followed
+         *  by a vkCmdResetEvent() call.
+         *
+         *  Source access masks of the barriers should describe accesses performed by commands preceding the
+         *  begin() call.
+         *
+         *  @param in_cmd_buffer_ptr              Command buffer to record the commands to. Must be in recording mode.
+         *  @param in_dst_stage_mask              Pipeline stages of the subsequent commands, which should wait.
+         *  @param in_memory_barrier_count        Number of items under @param in_memory_barriers_ptr.
+         *  @param in_memory_barriers_ptr         Memory barriers to use. May be nullptr if the count is 0.
+         *  @param in_buffer_memory_barrier_count Number of items under @param in_buffer_memory_barriers_ptr.
+         *  @param in_buffer_memory_barriers_ptr  Buffer memory barriers to use. May be nullptr if the count is 0.
+         *  @param in_image_memory_barrier_count  Number of items under @param in_image_memory_barriers_ptr.
+         *  @param in_image_memory_barriers_ptr   Image memory barriers to use. May be nullptr if the count is 0.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool end(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                 VkPipelineStageFlags                      in_dst_stage_mask,
+                 uint32_t                                  in_memory_barrier_count,
+                 const MemoryBarrier* const                in_memory_barriers_ptr,
+                 uint32_t                                  in_buffer_memory_barrier_count,
+                 const BufferBarrier* const                in_buffer_memory_barriers_ptr,
+                 uint32_t                                  in_image_memory_barrier_count,
+                 const ImageBarrier* const                 in_image_memory_barriers_ptr);
+
+        /** Tells whether the split barrier has been started, but not ended yet. */
+        bool is_pending() const
+        {
+            return (m_event_ptr != nullptr);
+        }
+
+    private:
+        /* Private functions */
+        SplitBarrier           (const SplitBarrier&);
+        SplitBarrier& operator=(const SplitBarrier&);
+
+        /* Private variables */
+        std::weak_ptr<Anvil::BaseDevice> m_device_ptr;
+        std::shared_ptr<Anvil::Event>    m_event_ptr;
+        VkPipelineStageFlags             m_src_stage_mask;
+    };
+}; /* namespace Anvil */
+
+#endif /* MISC_SPLIT_BARRIER_H */
@@ -62,7 +62,8 @@
     #include "../misc/xcb_loader_for_anvil.h"
     #include <string.h>
 
-    #ifndef nullptr
+    /* nullptr is a keyword since C++11. Redefining it breaks standard headers such as <thread>. */
+    #if !defined(nullptr) && __cplusplus < 201103L
         #define nullptr NULL
     #endif
 
@@ -493,6 +494,7 @@
 namespace Anvil
 {
     /* Forward declarations */
+    class  AsyncComputeScheduler;
     class  BaseDevice;
     class  Buffer;
     class  BufferView;
@@ -500,13 +502,20 @@ namespace Anvil
     class  CommandPool;
     class  ComputePipelineManager;
     class  DAGRenderer;
+    class  DeferredDeletionQueue;
     class  DescriptorPool;
     class  DescriptorSet;
     class  DescriptorSetGroup;
     class  DescriptorSetLayout;
+    class  DrawBatchBuilder;
     class  Event;
+    class  EventPool;
     class  Fence;
+    class  FenceCompletionService;
+    class  FencePool;
     class  Framebuffer;
+    class  FramePacer;
+    class  GPUProfiler;
     class  GraphicsPipelineManager;
     class  Image;
     class  ImageView;
@@ -516,20 +525,25 @@ namespace Anvil
     struct MemoryHeap;
     struct MemoryProperties;
     struct MemoryType;
+    class  PersistentPipelineCache;
     class  PhysicalDevice;
     class  PipelineCache;
     class  PipelineLayout;
     class  PipelineLayoutManager;
+    class  PipelineStatisticsAggregator;
     class  PrimaryCommandBuffer;
     class  QueryPool;
+    class  QueryPoolRing;
     class  Queue;
     class  RenderingSurface;
     class  RenderPass;
+    class  ResourceStateTracker;
     class  Sampler;
     class  SecondaryCommandBuffer;
     class  Semaphore;
     class  SGPUDevice;
     class  ShaderModule;
+    class  SplitBarrier;
     class  Swapchain;
     class  Window;
 
@@ -620,6 +634,73 @@ namespace Anvil
         BufferBarrier& operator=(const BufferBarrier&);
     } BufferBarrier;
 
+    /** Describes a buffer memory barrier.
+     *
+     *  Unlike BufferBarrier, the descriptor only holds the raw Vulkan buffer handle and does not retain
+     *  the Buffer instance it refers to. Arrays of such descriptors can be built and copied without
+     *  touching any reference counters. It is the caller's responsibility to keep the buffer alive
+     *  until the command buffer the barrier is recorded to finishes executing.
+     *
+     *  The structure is binary-compatible with VkBufferMemoryBarrier.
+     **/
+    typedef struct BufferBarrierRef
+    {
+        VkBufferMemoryBarrier buffer_barrier_vk;
+
+        /** Dummy constructor. Leaves the descriptor uninitialized. */
+        BufferBarrierRef()
+        {
+            /* Stub */
+        }
+
+        /** Constructor.
+         *
+         *  @param in_source_access_mask      Source access mask to use for the barrier.
+         *  @param in_destination_access_mask Destination access mask to use for the barrier.
+         *  @param in_src_queue_family_index  Source queue family index to use for the barrier.
+         *  @param in_dst_queue_family_index  Destination queue family index to use for the barrier.
+         *  @param in_buffer                  Raw Vulkan handle of the buffer the barrier refers to.
+         *  @param in_offset                  Start offset of the region described by the barrier.
+         *  @param in_size                    Size of the region described by the barrier.
+         **/
+        BufferBarrierRef(VkAccessFlags in_source_access_mask,
+                         VkAccessFlags in_destination_access_mask,
+                         uint32_t      in_src_queue_family_index,
+                         uint32_t      in_dst_queue_family_index,
+                         VkBuffer      in_buffer,
+                         VkDeviceSize  in_offset,
+                         VkDeviceSize  in_size)
+        {
+            buffer_barrier_vk.buffer              = in_buffer;
+            buffer_barrier_vk.dstAccessMask       = in_destination_access_mask;
+            buffer_barrier_vk.dstQueueFamilyIndex = in_dst_queue_family_index;
+            buffer_barrier_vk.offset              = in_offset;
+            buffer_barrier_vk.pNext               = nullptr;
+            buffer_barrier_vk.size                = in_size;
+            buffer_barrier_vk.srcAccessMask       = in_source_access_mask;
+            buffer_barrier_vk.srcQueueFamilyIndex = in_src_queue_family_index;
+            buffer_barrier_vk.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        }
+
+        /** Conversion constructor. Copies the Vulkan descriptor held by @param in. The Buffer instance
+         *  @param in refers to is NOT retained.
+         **/
+        BufferBarrierRef(const BufferBarrier& in)
+            :buffer_barrier_vk(in.buffer_barrier_vk)
+        {
+            /* Stub */
+        }
+
+        /** Returns the Vulkan buffer memory barrier descriptor. */
+        const VkBufferMemoryBarrier& get_barrier_vk() const
+        {
+            return buffer_barrier_vk;
+        }
+    } BufferBarrierRef;
+
+    static_assert(sizeof(BufferBarrierRef) == sizeof(VkBufferMemoryBarrier),
+                  "BufferBarrierRef must be binary-compatible with VkBufferMemoryBarrier");
+
     /** Describes component layout of a format */
     typedef enum
     {
@@ -910,6 +991,74 @@ namespace Anvil
         ImageBarrier& operator=(const ImageBarrier&);
     } ImageBarrier;
 
+    /** Describes an image memory barrier.
+     *
+     *  Unlike ImageBarrier, the descriptor only holds the raw Vulkan image handle and does not retain
+     *  the Image instance it refers to. Please see BufferBarrierRef for more details.
+     *
+     *  The structure is binary-compatible with VkImageMemoryBarrier.
+     **/
+    typedef struct ImageBarrierRef
+    {
+        VkImageMemoryBarrier image_barrier_vk;
+
+        /** Dummy constructor. Leaves the descriptor uninitialized. */
+        ImageBarrierRef()
+        {
+            /* Stub */
+        }
+
+        /** Constructor.
+         *
+         *  @param in_source_access_mask      Source access mask to use for the barrier.
+         *  @param in_destination_access_mask Destination access mask to use for the barrier.
+         *  @param in_old_layout              Old layout of @param in_image to use for the barrier.
+         *  @param in_new_layout              New layout of @param in_image to use for the barrier.
+         *  @param in_src_queue_family_index  Source queue family index to use for the barrier.
+         *  @param in_dst_queue_family_index  Destination queue family index to use for the barrier.
+         *  @param in_image                   Raw Vulkan handle of the image the barrier refers to.
+         *  @param in_image_subresource_range Subresource range to use for the barrier.
+         **/
+        ImageBarrierRef(VkAccessFlags                  in_source_access_mask,
+                        VkAccessFlags                  in_destination_access_mask,
+                        VkImageLayout                  in_old_layout,
+                        VkImageLayout                  in_new_layout,
+                        uint32_t                       in_src_queue_family_index,
+                        uint32_t                       in_dst_queue_family_index,
+                        VkImage                        in_image,
+                        const VkImageSubresourceRange& in_image_subresource_range)
+        {
+            image_barrier_vk.dstAccessMask       = in_destination_access_mask;
+            image_barrier_vk.dstQueueFamilyIndex = in_dst_queue_family_index;
+            image_barrier_vk.image               = in_image;
+            image_barrier_vk.newLayout           = in_new_layout;
+            image_barrier_vk.oldLayout           = in_old_layout;
+            image_barrier_vk.pNext               = nullptr;
+            image_barrier_vk.srcAccessMask       = in_source_access_mask;
+            image_barrier_vk.srcQueueFamilyIndex = in_src_queue_family_index;
+            image_barrier_vk.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            image_barrier_vk.subresourceRange    = in_image_subresource_range;
+        }
+
+        /** Conversion constructor. Copies the Vulkan descriptor held by @param in. The Image instance
+         *  @param in refers to is NOT retained.
+         **/
+        ImageBarrierRef(const ImageBarrier& in)
+            :image_barrier_vk(in.image_barrier_vk)
+        {
+            /* Stub */
+        }
+
+        /** Returns the Vulkan image memory barrier descriptor. */
+        const VkImageMemoryBarrier& get_barrier_vk() const
+        {
+            return image_barrier_vk;
+        }
+    } ImageBarrierRef;
+
+    static_assert(sizeof(ImageBarrierRef) == sizeof(VkImageMemoryBarrier),
+                  "ImageBarrierRef must be binary-compatible with VkImageMemoryBarrier");
+
     /** Holds properties of a single Vulkan Layer. */
     typedef struct Layer
     {
@@ -1439,6 +1588,9 @@ namespace Anvil
         /* For DOT serialization, we also need a handful of fake object types. */
         OBJECT_TYPE_GRAPHICS_PIPELINE,
 
+        /* Used by DeferredDeletionQueue to identify VkPipeline handles. */
+        OBJECT_TYPE_PIPELINE,
+
         /* Always last */
         OBJECT_TYPE_COUNT
     } ObjectType;
@@ -1546,6 +1698,26 @@ namespace Anvil
         QUEUE_FAMILY_TYPE_UNDEFINED = QUEUE_FAMILY_TYPE_COUNT
     } QueueFamilyType;
 
+    /** Enumerates the ways in which a Queue can synchronize access to the underlying Vulkan queue.
+     *  Please see Queue::set_submission_mode() for more details.
+     */
+    typedef enum
+    {
+        /* Submissions are not synchronized. The application must make sure queue-related calls are
+         * never issued from more than one thread at a time. */
+        QUEUE_SUBMISSION_MODE_UNSYNCHRONIZED,
+
+        /* Each queue-related call owns a per-queue mutex for the duration of the Vulkan call. */
+        QUEUE_SUBMISSION_MODE_MUTEX,
+
+        /* Submissions are pushed to a lock-free queue, which is drained by a dedicated submit thread.
+         * Requests which have been pushed in the meantime are coalesced into a single vkQueueSubmit() call. */
+        QUEUE_SUBMISSION_MODE_SUBMIT_THREAD,
+
+        /* Always last */
+        QUEUE_SUBMISSION_MODE_COUNT
+    } QueueSubmissionMode;
+
     /** Base pipeline ID. Internal type, used to represent compute / graphics pipeline IDs */
     typedef uint32_t PipelineID;
 
@@ -1606,6 +1778,126 @@ namespace Anvil
     /* Unique ID of a render-pass attachment within scope of a RenderPass instance. */
     typedef uint32_t RenderPassAttachmentID;
 
+    /** Describes the state a buffer range or an image subresource has been left in by the most recent
+     *  access, as tracked by Anvil::ResourceStateTracker.
+     *
+     *  Default state (all fields set to zero / VK_IMAGE_LAYOUT_UNDEFINED) is used for resources
+     *  which have not been accessed by the device since they were created.
+     **/
+    typedef struct ResourceState
+    {
+        /* Accesses which have been performed on the resource since the last barrier. */
+        VkAccessFlagsVariable(access_mask);
+
+        /* Layout the image subresource is in. Irrelevant for buffers. */
+        VkImageLayout layout;
+
+        /* Pipeline stages which have performed the accesses described by access_mask. */
+        VkPipelineStageFlagsVariable(stage_mask);
+
+        /** Dummy constructor. Initializes the structure to the default state. */
+        ResourceState()
+        {
+            access_mask = 0;
+            layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+            stage_mask  = 0;
+        }
+
+        /** Constructor.
+         *
+         *  @param in_access_mask Access mask to use.
+         *  @param in_layout      Image layout to use.
+         *  @param in_stage_mask  Pipeline stage mask to use.
+         **/
+        ResourceState(VkAccessFlags        in_access_mask,
+                      VkImageLayout        in_layout,
+                      VkPipelineStageFlags in_stage_mask)
+        {
+            access_mask = in_access_mask;
+            layout      = in_layout;
+            stage_mask  = in_stage_mask;
+        }
+
+        /** Tells whether any of the accesses described by the structure modify the resource's contents. */
+        bool has_write_access() const;
+
+        bool operator==(const ResourceState& in) const
+        {
+            return (access_mask == in.access_mask &&
+                    layout      == in.layout      &&
+                    stage_mask  == in.stage_mask);
+        }
+
+        bool operator!=(const ResourceState& in) const
+        {
+            return !(*this == in);
+        }
+    } ResourceState;
+
+    /** Describes how a resource is going to be accessed by commands recorded after a
+     *  CommandBufferBase::record_transition() call.
+     *
+     *  Use Anvil::Utils::get_resource_state_for_resource_usage() to convert a value to the
+     *  corresponding access mask, image layout and pipeline stage mask.
+     **/
+    typedef enum
+    {
+        RESOURCE_USAGE_FIRST,
+
+        /* Color attachment, read & written by color attachment output stage. */
+        RESOURCE_USAGE_COLOR_ATTACHMENT = RESOURCE_USAGE_FIRST,
+
+        /* Sampled image, uniform texel buffer or storage resource read by compute shaders. */
+        RESOURCE_USAGE_COMPUTE_SHADER_READ,
+
+        /* Storage image or storage buffer, read & written by compute shaders. */
+        RESOURCE_USAGE_COMPUTE_SHADER_STORAGE,
+
+        /* Depth/stencil attachment, read & written by fragment tests. */
+        RESOURCE_USAGE_DEPTH_STENCIL_ATTACHMENT,
+
+        /* Depth/stencil attachment, read by fragment tests and/or fragment shaders. */
+        RESOURCE_USAGE_DEPTH_STENCIL_READ_ONLY,
+
+        /* Sampled image, uniform texel buffer or storage resource read by fragment shaders. */
+        RESOURCE_USAGE_FRAGMENT_SHADER_READ,
+
+        /* Storage image or storage buffer, read & written by fragment shaders. */
+        RESOURCE_USAGE_FRAGMENT_SHADER_STORAGE,
+
+        /* Resource is going to be read by the host after the command buffer finishes executing. */
+        RESOURCE_USAGE_HOST_READ,
+
+        /* Index buffer. */
+        RESOURCE_USAGE_INDEX_BUFFER,
+
+        /* Indirect draw / dispatch argument buffer. */
+        RESOURCE_USAGE_INDIRECT_BUFFER,
+
+        /* Input attachment, read by fragment shaders. */
+        RESOURCE_USAGE_INPUT_ATTACHMENT,
+
+        /* Swapchain image, which is going to be presented. */
+        RESOURCE_USAGE_PRESENT,
+
+        /* Source of a transfer operation (copy, blit, etc.) */
+        RESOURCE_USAGE_TRANSFER_SRC,
+
+        /* Destination of a transfer operation (copy, blit, clear, fill, update, etc.) */
+        RESOURCE_USAGE_TRANSFER_DST,
+
+        /* Uniform buffer, read by any of the shader stages. */
+        RESOURCE_USAGE_UNIFORM_BUFFER,
+
+        /* Vertex buffer. */
+        RESOURCE_USAGE_VERTEX_BUFFER,
+
+        /* Sampled image, uniform texel buffer or storage resource read by vertex shaders. */
+        RESOURCE_USAGE_VERTEX_SHADER_READ,
+
+        RESOURCE_USAGE_COUNT
+    } ResourceUsage;
+
     /* Specifies one of the compute / rendering pipeline stages. */
     typedef enum
     {
@@ -1890,6 +2182,15 @@ namespace Anvil
          */
         const char* get_raw_string(VkStencilOp in_stencil_op);
 
+        /** Converts the specified Anvil::ResourceUsage value to the access mask, image layout & pipeline
+         *  stage mask the resource is going to be accessed with.
+         *
+         *  @param in_usage Input value. Must be smaller than RESOURCE_USAGE_COUNT.
+         *
+         *  @return Requested state.
+         */
+        Anvil::ResourceState get_resource_state_for_resource_usage(Anvil::ResourceUsage in_usage);
+
         /** Tells whether @param value is a power-of-two. */
         template <typename type>
         type is_pow2(const type value)
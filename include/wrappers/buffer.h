@@ -35,6 +35,8 @@
 
 #include "../misc/types.h"
 #include "../misc/page_tracker.h"
+#include "../misc/resource_state_tracker.h"
+#include <mutex>
 
 namespace Anvil
 {
@@ -367,11 +369,14 @@ namespace Anvil
         Anvil::SparseResidencyScope         m_residency_scope;
         VkSharingMode                       m_sharing_mode;
         VkDeviceSize                        m_start_offset;
+        Anvil::BufferRangeStates            m_tracked_states; /* Only used by base buffers */
+        mutable std::mutex                  m_tracked_states_mutex;
 
         VkBufferCreateFlagsVariable(m_create_flags);
         VkBufferUsageFlagsVariable (m_usage_flags);
 
-        friend class Anvil::Queue; /* set_sparse_memory() */
+        friend class Anvil::Queue;                /* set_sparse_memory() */
+        friend class Anvil::ResourceStateTracker; /* m_tracked_states   */
     };
 }; /* namespace Anvil */
 
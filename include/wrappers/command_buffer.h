@@ -36,6 +36,7 @@
 #define WRAPPERS_COMMAND_BUFFER_H
 
 #include "../misc/callbacks.h"
+#include "../misc/resource_state_tracker.h"
 #include "../misc/types.h"
 
 #ifdef _DEBUG
@@ -252,6 +253,10 @@ namespace Anvil
         std::vector<ImageBarrier>  image_barriers;
         std::vector<MemoryBarrier> memory_barriers;
 
+        /* Barriers specified with non-owning descriptors. Objects they refer to are not retained. */
+        std::vector<BufferBarrierRef> buffer_barrier_refs;
+        std::vector<ImageBarrierRef>  image_barrier_refs;
+
         VkDependencyFlagsVariable(flags);
 
         VkPipelineStageFlagsVariable(dst_stage_mask);
@@ -310,8 +315,323 @@ namespace Anvil
     class CommandBufferBase : public CallbacksSupportProvider
     {
     public:
+        /* Public type definitions */
+
+        /** Light-weight recording interface, which takes raw Vulkan handles instead of wrapper instances.
+         *
+         *  Use CommandBufferBase::fast() to obtain an instance. Each function issues the corresponding
+         *  vkCmd*() call directly. Compared to the record_*() functions:
+         *
+         *  - no shared_ptr is passed by value, so no atomic reference counter traffic is generated.
+         *  - arrays are forwarded to Vulkan as is, so there is no limit on their size.
+         *  - nothing is appended to the internal vector of commands (STORE_COMMAND_BUFFER_COMMANDS builds),
+         *    no call-backs are issued, and render-pass state is not validated.
+         *  - objects referred to by the handles are not retained, unless retain() is called for them.
+         *    Otherwise, the caller must keep them alive until the command buffer finishes executing.
+         *  - resource states tracked for record_transition() are not updated. Resources accessed by the
+         *    commands must still be transitioned with record_transition() to the usage the commands
+         *    access them with, since the tracker has no other way of learning about these accesses.
+         *
+         *  Pipeline barriers batched by the parent command buffer are flushed before each command.
+         *
+         *  Both interfaces can be used interchangeably for the same command buffer. Argument meaning is
+         *  as per Vulkan API specification.
+         **/
+        class FastRecorder
+        {
+        public:
+            /** Issues a vkCmdBindDescriptorSets() call. @param in_descriptor_sets and @param in_dynamic_offsets
+             *  are passed to Vulkan as is, so they must hold @param in_set_count and @param in_dynamic_offset_count
+             *  items respectively.
+             **/
+            FastRecorder& bind_descriptor_sets(VkPipelineBindPoint    in_pipeline_bind_point,
+                                               VkPipelineLayout       in_layout,
+                                               uint32_t               in_first_set,
+                                               uint32_t               in_set_count,
+                                               const VkDescriptorSet* in_descriptor_sets,
+                                               uint32_t               in_dynamic_offset_count,
+                                               const uint32_t*        in_dynamic_offsets)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdBindDescriptorSets(m_command_buffer,
+                                        in_pipeline_bind_point,
+                                        in_layout,
+                                        in_first_set,
+                                        in_set_count,
+                                        in_descriptor_sets,
+                                        in_dynamic_offset_count,
+                                        in_dynamic_offsets);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdBindIndexBuffer() call. */
+            FastRecorder& bind_index_buffer(VkBuffer     in_buffer,
+                                            VkDeviceSize in_offset,
+                                            VkIndexType  in_index_type)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdBindIndexBuffer(m_command_buffer,
+                                     in_buffer,
+                                     in_offset,
+                                     in_index_type);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdBindPipeline() call. */
+            FastRecorder& bind_pipeline(VkPipelineBindPoint in_pipeline_bind_point,
+                                        VkPipeline          in_pipeline)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdBindPipeline(m_command_buffer,
+                                  in_pipeline_bind_point,
+                                  in_pipeline);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdBindVertexBuffers() call. @param in_buffers and @param in_offsets must hold
+             *  @param in_binding_count items each.
+             **/
+            FastRecorder& bind_vertex_buffers(uint32_t            in_first_binding,
+                                              uint32_t            in_binding_count,
+                                              const VkBuffer*     in_buffers,
+                                              const VkDeviceSize* in_offsets)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdBindVertexBuffers(m_command_buffer,
+                                       in_first_binding,
+                                       in_binding_count,
+                                       in_buffers,
+                                       in_offsets);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdCopyBuffer() call. @param in_regions must hold @param in_region_count items. */
+            FastRecorder& copy_buffer(VkBuffer            in_src_buffer,
+                                      VkBuffer            in_dst_buffer,
+                                      uint32_t            in_region_count,
+                                      const VkBufferCopy* in_regions)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdCopyBuffer(m_command_buffer,
+                                in_src_buffer,
+                                in_dst_buffer,
+                                in_region_count,
+                                in_regions);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdDispatch() call. */
+            FastRecorder& dispatch(uint32_t in_x,
+                                   uint32_t in_y,
+                                   uint32_t in_z)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdDispatch(m_command_buffer,
+                              in_x,
+                              in_y,
+                              in_z);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdDispatchIndirect() call. */
+            FastRecorder& dispatch_indirect(VkBuffer     in_buffer,
+                                            VkDeviceSize in_offset)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdDispatchIndirect(m_command_buffer,
+                                      in_buffer,
+                                      in_offset);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdDraw() call. Must only be called when recording renderpass commands. */
+            FastRecorder& draw(uint32_t in_vertex_count,
+                               uint32_t in_instance_count,
+                               uint32_t in_first_vertex,
+                               uint32_t in_first_instance)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdDraw(m_command_buffer,
+                          in_vertex_count,
+                          in_instance_count,
+                          in_first_vertex,
+                          in_first_instance);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdDrawIndexed() call. Must only be called when recording renderpass commands. */
+            FastRecorder& draw_indexed(uint32_t in_index_count,
+                                       uint32_t in_instance_count,
+                                       uint32_t in_first_index,
+                                       int32_t  in_vertex_offset,
+                                       uint32_t in_first_instance)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdDrawIndexed(m_command_buffer,
+                                 in_index_count,
+                                 in_instance_count,
+                                 in_first_index,
+                                 in_vertex_offset,
+                                 in_first_instance);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdDrawIndexedIndirect() call. Must only be called when recording renderpass commands. */
+            FastRecorder& draw_indexed_indirect(VkBuffer     in_buffer,
+                                                VkDeviceSize in_offset,
+                                                uint32_t     in_count,
+                                                uint32_t     in_stride)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdDrawIndexedIndirect(m_command_buffer,
+                                         in_buffer,
+                                         in_offset,
+                                         in_count,
+                                         in_stride);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdDrawIndirect() call. Must only be called when recording renderpass commands. */
+            FastRecorder& draw_indirect(VkBuffer     in_buffer,
+                                        VkDeviceSize in_offset,
+                                        uint32_t     in_count,
+                                        uint32_t     in_stride)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdDrawIndirect(m_command_buffer,
+                                  in_buffer,
+                                  in_offset,
+                                  in_count,
+                                  in_stride);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdPushConstants() call. @param in_values must hold @param in_size bytes. */
+            FastRecorder& push_constants(VkPipelineLayout   in_layout,
+                                         VkShaderStageFlags in_stage_flags,
+                                         uint32_t           in_offset,
+                                         uint32_t           in_size,
+                                         const void*        in_values)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdPushConstants(m_command_buffer,
+                                   in_layout,
+                                   in_stage_flags,
+                                   in_offset,
+                                   in_size,
+                                   in_values);
+
+                return *this;
+            }
+
+            /** Retains @param in_object_ptr until the parent command buffer is reset, re-recorded or released.
+             *
+             *  Only needs to be called for objects whose lifetime is not guaranteed by other means.
+             **/
+            FastRecorder& retain(const std::shared_ptr<void>& in_object_ptr)
+            {
+                m_parent_ptr->m_retained_objects.push_back(in_object_ptr);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdSetScissor() call. @param in_scissors must hold @param in_scissor_count items. */
+            FastRecorder& set_scissor(uint32_t        in_first_scissor,
+                                      uint32_t        in_scissor_count,
+                                      const VkRect2D* in_scissors)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdSetScissor(m_command_buffer,
+                                in_first_scissor,
+                                in_scissor_count,
+                                in_scissors);
+
+                return *this;
+            }
+
+            /** Issues a vkCmdSetViewport() call. @param in_viewports must hold @param in_viewport_count items. */
+            FastRecorder& set_viewport(uint32_t          in_first_viewport,
+                                       uint32_t          in_viewport_count,
+                                       const VkViewport* in_viewports)
+            {
+                flush_pipeline_barriers();
+
+                vkCmdSetViewport(m_command_buffer,
+                                 in_first_viewport,
+                                 in_viewport_count,
+                                 in_viewports);
+
+                return *this;
+            }
+
+        private:
+            explicit FastRecorder(CommandBufferBase* in_parent_ptr)
+                :m_command_buffer(in_parent_ptr->m_command_buffer),
+                 m_parent_ptr    (in_parent_ptr)
+            {
+                /* Stub */
+            }
+
+            void flush_pipeline_barriers()
+            {
+                if (m_parent_ptr->has_batched_pipeline_barriers() )
+                {
+                    m_parent_ptr->flush_pipeline_barriers();
+                }
+            }
+
+            VkCommandBuffer    m_command_buffer;
+            CommandBufferBase* m_parent_ptr;
+
+            friend class CommandBufferBase;
+        };
+
         /* Public functions */
 
+        /** Informs the command buffer that memory backing @param in_buffer_ptr is shared with other
+         *  resources, which have last been accessed the way described by @param in_aliased_state.
+         *
+         *  The next record_transition() call for the buffer is going to wait for these accesses to
+         *  finish, in addition to accesses to the buffer itself.
+         *
+         *  @param in_buffer_ptr    Buffer to use. Must not be nullptr.
+         *  @param in_aliased_state Union of the last states of all aliased resources. Layout is ignored.
+         **/
+        void add_aliasing_dependency(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                     const Anvil::ResourceState&    in_aliased_state);
+
+        /** Informs the command buffer that memory backing @param in_image_ptr is shared with other
+         *  resources. Contents of all image subresources are considered undefined after the call.
+         *
+         *  Please see the other add_aliasing_dependency() overload for more details.
+         **/
+        void add_aliasing_dependency(std::shared_ptr<Anvil::Image> in_image_ptr,
+                                     const Anvil::ResourceState&   in_aliased_state);
+
         /* Disables internal command stashing which is enbled for builds created with
          * STORE_COMMAND_BUFFER_COMMANDS enabled.
          *
@@ -322,6 +642,33 @@ namespace Anvil
             m_command_stashing_disabled = true;
         }
 
+        /** Returns a light-weight recording interface for the command buffer, which takes raw Vulkan handles.
+         *
+         *  Please see FastRecorder documentation for more details.
+         *
+         *  The command buffer must be in the recording mode. The returned instance must not outlive it.
+         **/
+        FastRecorder fast()
+        {
+            anvil_assert(m_recording_in_progress);
+
+            return FastRecorder(this);
+        }
+
+        /** Issues a single vkCmdPipelineBarrier() call for all pipeline barriers which have been batched
+         *  since the last flush. The barriers are merged into one command, whose source and destination
+         *  stage masks are a union of the stage masks specified for the batched barriers.
+         *
+         *  Any other record_*() call, as well as stop_recording(), flushes the batch implicitly. This
+         *  function only needs to be called explicitly if the raw Vulkan command buffer handle is used
+         *  to record commands in-between barriers recorded via this wrapper.
+         *
+         *  Nop if no barriers are pending.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool flush_pipeline_barriers();
+
         /** Returns a handle to the raw Vulkan command buffer instance, encapsulated by the object */
         const VkCommandBuffer get_command_buffer() const
         {
@@ -342,6 +689,14 @@ namespace Anvil
             return m_type;
         }
 
+        /** Tells whether record_pipeline_barrier() calls are batched for this command buffer instance.
+         *
+         *  See set_pipeline_barrier_batching_enabled() for more details.
+         **/
+        bool is_pipeline_barrier_batching_enabled() const
+        {
+            return m_pipeline_barrier_batching_enabled;
+        }
 
         /** Issues a vkCmdBeginQuery() call and appends it to the internal vector of commands
          *  recorded for the specified command buffer (for builds with STORE_COMMAND_BUFFER_COMMANDS
@@ -859,6 +1214,10 @@ namespace Anvil
          *  Any Vulkan object wrapper instances, passed implicitly to this function, are going to be retained,
          *  and will be released when the command buffer is released or resetted.
          *
+         *  If pipeline barrier batching is enabled and no renderpass is active, the barriers are not recorded
+         *  right away. Instead, they are merged with other barriers recorded back-to-back and issued as a single
+         *  vkCmdPipelineBarrier() call right before the next non-barrier command is recorded.
+         *
          *  Argument meaning is as per Vulkan API specification.
          *
          *  @return true if successful, false otherwise.
@@ -873,6 +1232,30 @@ namespace Anvil
                                      uint32_t                   in_image_memory_barrier_count,
                                      const ImageBarrier*  const in_image_memory_barriers_ptr);
 
+        /** Issues a vkCmdPipelineBarrier() call for barriers described with non-owning descriptors.
+         *
+         *  Works exactly like the other record_pipeline_barrier() overload, except that the buffers and images
+         *  the barriers refer to are NOT retained, and no reference counters are touched while the barriers are
+         *  recorded. The objects must be kept alive by the caller until the command buffer finishes executing.
+         *
+         *  The barrier arrays are passed to Vulkan as is, so there is no limit on the number of buffer and image
+         *  barriers which can be recorded with a single call.
+         *
+         *  Note that passing nullptr for both buffer & image barrier arrays is ambiguous. Please pass typed null
+         *  pointers in such case.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool record_pipeline_barrier(VkPipelineStageFlags          in_src_stage_mask,
+                                     VkPipelineStageFlags          in_dst_stage_mask,
+                                     VkBool32                      in_by_region,
+                                     uint32_t                      in_memory_barrier_count,
+                                     const MemoryBarrier* const    in_memory_barriers_ptr,
+                                     uint32_t                      in_buffer_memory_barrier_count,
+                                     const BufferBarrierRef* const in_buffer_memory_barriers_ptr,
+                                     uint32_t                      in_image_memory_barrier_count,
+                                     const ImageBarrierRef*  const in_image_memory_barriers_ptr);
+
         /** Issues a vkCmdPushConstants() call and appends it to the internal vector of commands
          *  recorded for the specified command buffer (for builds with STORE_COMMAND_BUFFER_COMMANDS
          *  #define enabled).
@@ -1099,6 +1482,66 @@ namespace Anvil
                                  uint32_t          in_viewport_count,
                                  const VkViewport* in_viewport_ptrs);
 
+        /** Transitions a buffer region to a new usage.
+         *
+         *  The command buffer tracks states of all resources passed to record_transition() calls. The first
+         *  time a resource is transitioned, it is assumed to be in the state it was left in by the most
+         *  recently submitted command buffer. The function then records the cheapest dependency which makes
+         *  the transition safe:
+         *
+         *  - no dependency at all for read-after-read accesses, whose stages and access types have already
+         *    been made visible.
+         *  - an execution-only dependency for write-after-read hazards.
+         *  - a buffer memory barrier, flushing writes only, for read-after-write and write-after-write hazards.
+         *
+         *  Barriers are recorded with record_pipeline_barrier(), so they are subject to pipeline barrier
+         *  batching if it has been enabled for the command buffer.
+         *
+         *  Resource states are committed back to the resources when the command buffer is submitted with
+         *  Anvil::Queue. Resources should not be transitioned with both this function and manually recorded
+         *  barriers, as the latter are not taken into account by the tracker.
+         *
+         *  It is illegal to call this function when recording renderpass commands. Doing so will result in
+         *  an assertion failure.
+         *
+         *  @param in_buffer_ptr Buffer to transition. Must not be nullptr.
+         *  @param in_offset     Start offset of the region to transition.
+         *  @param in_size       Size of the region to transition. May be VK_WHOLE_SIZE.
+         *  @param in_usage      Usage to transition the region to.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool record_transition(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                               VkDeviceSize                   in_offset,
+                               VkDeviceSize                   in_size,
+                               Anvil::ResourceUsage           in_usage);
+
+        /** Transitions an image subresource range to a new usage.
+         *
+         *  Works just like the buffer version of record_transition(). Image barriers also take care of
+         *  layout transitions, as implied by @param in_usage.
+         *
+         *  @param in_image_ptr         Image to transition. Must not be nullptr.
+         *  @param in_subresource_range Subresource range to transition.
+         *  @param in_usage             Usage to transition the range to.
+         *  @param in_discard_contents  true if the current contents of the range need not be preserved, in
+         *                              which case the transition is performed from VK_IMAGE_LAYOUT_UNDEFINED.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool record_transition(std::shared_ptr<Anvil::Image>  in_image_ptr,
+                               const VkImageSubresourceRange& in_subresource_range,
+                               Anvil::ResourceUsage           in_usage,
+                               bool                           in_discard_contents = false);
+
+        /** Transitions all subresources of an image to a new usage.
+         *
+         *  See the record_transition() overload taking a subresource range for more details.
+         **/
+        bool record_transition(std::shared_ptr<Anvil::Image> in_image_ptr,
+                               Anvil::ResourceUsage          in_usage,
+                               bool                          in_discard_contents = false);
+
         /** Issues a vkCmdUpdateBuffer() call and appends it to the internal vector of commands
          *  recorded for the specified command buffer (for builds with STORE_COMMAND_BUFFER_COMMANDS
          *  #define enabled).
@@ -1146,6 +1589,25 @@ namespace Anvil
                                 uint32_t                       in_image_memory_barrier_count,
                                 const ImageBarrier* const      in_image_memory_barriers_ptr);
 
+        /** Issues a vkCmdWaitEvents() call for barriers described with non-owning descriptors.
+         *
+         *  Events are retained as usual. Buffers and images the barriers refer to are NOT retained. Please see
+         *  the record_pipeline_barrier() overload taking BufferBarrierRef and ImageBarrierRef arrays for more
+         *  details.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool record_wait_events(uint32_t                       in_event_count,
+                                std::shared_ptr<Anvil::Event>* in_event_ptrs,
+                                VkPipelineStageFlags           in_src_stage_mask,
+                                VkPipelineStageFlags           in_dst_stage_mask,
+                                uint32_t                       in_memory_barrier_count,
+                                const MemoryBarrier* const     in_memory_barriers_ptr,
+                                uint32_t                       in_buffer_memory_barrier_count,
+                                const BufferBarrierRef* const  in_buffer_memory_barriers_ptr,
+                                uint32_t                       in_image_memory_barrier_count,
+                                const ImageBarrierRef* const   in_image_memory_barriers_ptr);
+
         /** Issues a vkCmdWriteTimestamp() call and appends it to the internal vector of commands
          *  recorded for the specified command buffer (for builds with STORE_COMMAND_BUFFER_COMMANDS
          *  #define enabled).
@@ -1174,6 +1636,26 @@ namespace Anvil
          **/
         bool reset(bool should_release_resources);
 
+        /** Enables or disables pipeline barrier batching for this command buffer instance.
+         *
+         *  When enabled, barriers passed to subsequent record_pipeline_barrier() calls, which are made outside
+         *  renderpasses, are accumulated and flushed with a single vkCmdPipelineBarrier() call right before
+         *  the next non-barrier command is recorded. A barrier which touches a buffer region or an image
+         *  subresource range already referred to by a batched barrier, or which uses different dependency
+         *  flags, causes the batch to be flushed before it is added. Global memory barriers are treated as
+         *  overlapping any other barrier, so they are never merged with barriers from other calls.
+         *
+         *  COMMAND_BUFFER_CALLBACK_ID_PIPELINE_BARRIER_COMMAND_RECORDED call-backs are issued at flush time
+         *  and describe the merged command.
+         *
+         *  Disabling batching flushes any pending barriers.
+         *
+         *  Batching is disabled by default.
+         *
+         *  @param in_enabled true to enable batching, false to disable it.
+         **/
+        void set_pipeline_barrier_batching_enabled(bool in_enabled);
+
         /** Stops an ongoing command recording process.
          *
          *  It is an error to invoke this function if the command buffer has not been put
@@ -2253,6 +2735,10 @@ namespace Anvil
             std::vector<ImageBarrier>   image_barriers;
             std::vector<MemoryBarrier>  memory_barriers;
 
+            /* Barriers specified with non-owning descriptors. Objects they refer to are not retained. */
+            std::vector<BufferBarrierRef> buffer_barrier_refs;
+            std::vector<ImageBarrierRef>  image_barrier_refs;
+
             std::vector<VkEvent>                        events;
             std::vector<std::shared_ptr<Anvil::Event> > event_ptrs;
 
@@ -2312,6 +2798,8 @@ namespace Anvil
 
         virtual ~CommandBufferBase();
 
+        void clear_batched_pipeline_barriers();
+
         #ifdef STORE_COMMAND_BUFFER_COMMANDS
             void clear_commands();
         #endif
@@ -2321,12 +2809,14 @@ namespace Anvil
             Commands m_commands;
         #endif
 
-        VkCommandBuffer                   m_command_buffer;
-        std::weak_ptr<Anvil::BaseDevice>  m_device_ptr;
-        bool                              m_is_renderpass_active;
-        std::weak_ptr<Anvil::CommandPool> m_parent_command_pool_ptr;
-        bool                              m_recording_in_progress;
-        CommandBufferType                 m_type;
+        VkCommandBuffer                     m_command_buffer;
+        std::weak_ptr<Anvil::BaseDevice>    m_device_ptr;
+        bool                                m_is_renderpass_active;
+        std::weak_ptr<Anvil::CommandPool>   m_parent_command_pool_ptr;
+        bool                                m_recording_in_progress;
+        Anvil::ResourceStateTracker         m_resource_state_tracker;
+        std::vector<std::shared_ptr<void> > m_retained_objects; /* See FastRecorder::retain() */
+        CommandBufferType                   m_type;
 
         static bool m_command_stashing_disabled;
 
@@ -2334,10 +2824,54 @@ namespace Anvil
         /* Private type definitions */
 
         /* Private functions */
+        bool commit_resource_states();
+
+        bool has_batched_pipeline_barriers() const
+        {
+            return !m_batched_buffer_barrier_refs.empty() ||
+                   !m_batched_buffer_barriers.empty    () ||
+                   !m_batched_image_barrier_refs.empty () ||
+                   !m_batched_image_barriers.empty     () ||
+                   !m_batched_memory_barriers.empty    ();
+        }
+
+        bool does_batched_pipeline_barrier_overlap(const BufferBarrierRef& in_barrier) const;
+        bool does_batched_pipeline_barrier_overlap(const ImageBarrierRef&  in_barrier) const;
+
+        /** Tells whether a barrier defining @param in_n_memory_barriers global memory barriers must not be merged
+         *  with the batch. Global memory barriers apply to all resources, so a pending or an incoming one is
+         *  treated as overlapping any other barrier.
+         **/
+        bool does_batched_pipeline_barrier_overlap(uint32_t in_n_memory_barriers) const
+        {
+            return has_batched_pipeline_barriers()                                    &&
+                   (in_n_memory_barriers > 0 || !m_batched_memory_barriers.empty() );
+        }
+
+        bool record_transition_barriers(VkPipelineStageFlags in_src_stage_mask,
+                                        VkPipelineStageFlags in_dst_stage_mask);
+
         CommandBufferBase           (const CommandBufferBase&);
         CommandBufferBase& operator=(const CommandBufferBase&);
 
+        /* Private variables */
+        std::vector<BufferBarrierRef>      m_batched_buffer_barrier_refs;
+        std::vector<BufferBarrier>         m_batched_buffer_barriers;
+        std::vector<VkBufferMemoryBarrier> m_batched_buffer_barriers_vk;
+        VkDependencyFlags                  m_batched_dependency_flags;
+        VkPipelineStageFlags               m_batched_dst_stage_mask;
+        std::vector<ImageBarrierRef>       m_batched_image_barrier_refs;
+        std::vector<ImageBarrier>          m_batched_image_barriers;
+        std::vector<VkImageMemoryBarrier>  m_batched_image_barriers_vk;
+        std::vector<MemoryBarrier>         m_batched_memory_barriers;
+        std::vector<VkMemoryBarrier>       m_batched_memory_barriers_vk;
+        VkPipelineStageFlags               m_batched_src_stage_mask;
+        bool                               m_pipeline_barrier_batching_enabled;
+        std::vector<BufferBarrierRef>      m_transition_buffer_barriers;
+        std::vector<ImageBarrierRef>       m_transition_image_barriers;
+
         friend class Anvil::CommandPool;
+        friend class Anvil::Queue; /* commit_resource_states() */
     };
 
     /** Wrapper class for primary command buffers. */
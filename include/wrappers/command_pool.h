@@ -47,6 +47,9 @@ namespace Anvil
          *
          *  When no longer needed, the returned instance should be released by the app.
          *
+         *  Command buffers released via the device's deferred deletion queue, which have been collected
+         *  since the pool was last used, are freed first.
+         *
          *  @return As per description.
          **/
         std::shared_ptr<Anvil::PrimaryCommandBuffer> alloc_primary_level_command_buffer();
@@ -55,6 +58,9 @@ namespace Anvil
          *
          *  When no longer needed, the returned instance should be released by the app.
          *
+         *  Command buffers released via the device's deferred deletion queue, which have been collected
+         *  since the pool was last used, are freed first.
+         *
          *  @return As per description.
          **/
         std::shared_ptr<Anvil::SecondaryCommandBuffer> alloc_secondary_level_command_buffer();
@@ -94,6 +100,9 @@ namespace Anvil
         }
 
         /** Reset the command pool.
+         *
+         *  Command buffers released via the device's deferred deletion queue, which have been collected
+         *  since the pool was last used, are freed first.
          *
          *  @param release_resources true if the vkResetCommandPool() call should be invoked with
          *                           the VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT flag.
@@ -120,6 +129,8 @@ namespace Anvil
         CommandPool           (const CommandPool&);
         CommandPool& operator=(const CommandPool&);
 
+        void free_collected_command_buffers();
+
         /* Private variables */
         VkCommandPool                    m_command_pool;
         std::weak_ptr<Anvil::BaseDevice> m_device_ptr;
@@ -203,13 +203,61 @@ namespace Anvil
            return BasePipelineManager::get_pipeline_layout(pipeline_id);
        }
 
+       /** Returns a variant of the specified compute pipeline, which uses the specified specialization constant values.
+        *  Variants are created as derivatives of the base pipeline on first use, and cached.
+        *
+        *  Please see BasePipelineManager::get_pipeline_variant() for more details.
+        *
+        *  @param base_pipeline_id            ID of the pipeline to derive the variant from. The pipeline must have
+        *                                     been created with derivatives allowed.
+        *  @param n_values                    Number of items available under @param value_ptrs.
+        *  @param value_ptrs                  Array of @param n_values specialization constant values. All values must
+        *                                     use Anvil::SHADER_STAGE_COMPUTE.
+        *  @param out_variant_pipeline_id_ptr Deref will be set to the ID of the variant pipeline. Must not be nullptr.
+        *
+        *  @return true if successful, false otherwise.
+        **/
+       bool get_compute_pipeline_variant(ComputePipelineID                  base_pipeline_id,
+                                         uint32_t                           n_values,
+                                         const SpecializationConstantValue* value_ptrs,
+                                         ComputePipelineID*                 out_variant_pipeline_id_ptr)
+       {
+           return BasePipelineManager::get_pipeline_variant(base_pipeline_id,
+                                                            n_values,
+                                                            value_ptrs,
+                                                            out_variant_pipeline_id_ptr);
+       }
+
        private:
+           /* Private type definitions */
+
+           /** Holds data needed to create pipelines in the parallel bake mode */
+           typedef struct ParallelBakeContext
+           {
+               std::vector<VkComputePipelineCreateInfo> create_info_items_vk;
+               VkDevice                                 device_vk;
+               VkPipelineCache                          pipeline_cache_vk;
+
+               ParallelBakeContext()
+               {
+                   device_vk         = VK_NULL_HANDLE;
+                   pipeline_cache_vk = VK_NULL_HANDLE;
+               }
+           } ParallelBakeContext;
+
+           /* Private functions */
+
            /* Constructor */
            explicit ComputePipelineManager(std::weak_ptr<Anvil::BaseDevice>      device_ptr,
                                            bool                                  use_pipeline_cache          = false,
                                            std::shared_ptr<Anvil::PipelineCache> pipeline_cache_to_reuse_ptr = nullptr);
 
 
+           static VkResult create_pipeline_for_parallel_bake(void*       user_arg,
+                                                             uint32_t    n_item,
+                                                             VkPipeline  base_pipeline,
+                                                             VkPipeline* out_pipeline_ptr);
+
            ANVIL_DISABLE_ASSIGNMENT_OPERATOR(ComputePipelineManager);
            ANVIL_DISABLE_COPY_CONSTRUCTOR   (ComputePipelineManager);
     };
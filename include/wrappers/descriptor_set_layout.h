@@ -86,6 +86,13 @@ namespace Anvil
                          VkShaderStageFlags                     stage_flags,
                          const std::shared_ptr<Anvil::Sampler>* immutable_sampler_ptrs = nullptr);
 
+        /** Appends data describing all bindings defined for the layout, including immutable sampler handles,
+         *  to the specified vector. Layouts, for which equal data is appended, are identically defined.
+         *
+         *  @param inout_data_ptr Vector to append the data to. Must not be nullptr.
+         **/
+        void append_contents_data(std::vector<uint64_t>* inout_data_ptr) const;
+
         /** Converts internal layout representation to a Vulkan object.
          *
          *  The baking will only occur if the object is internally marked as dirty. If it is not,
@@ -120,6 +120,44 @@ namespace Anvil
          **/
         const ExtensionKHRSwapchainEntrypoints& get_extension_khr_swapchain_entrypoints() const;
 
+        /** Retrieves a deferred deletion queue, created for this device instance. Please see DeferredDeletionQueue
+         *  for more details.
+         *
+         *  @return As per description. nullptr once the device has been destroyed.
+         **/
+        std::shared_ptr<Anvil::DeferredDeletionQueue> get_deferred_deletion_queue() const
+        {
+            return m_deferred_deletion_queue_ptr;
+        }
+
+        /** Retrieves an event pool, created for this device instance. Please see EventPool for more details.
+         *
+         *  @return As per description
+         **/
+        std::shared_ptr<Anvil::EventPool> get_event_pool() const
+        {
+            return m_event_pool_ptr;
+        }
+
+        /** Retrieves a fence completion service, created for this device instance. Please see
+         *  FenceCompletionService for more details.
+         *
+         *  @return As per description
+         **/
+        std::shared_ptr<Anvil::FenceCompletionService> get_fence_completion_service() const
+        {
+            return m_fence_completion_service_ptr;
+        }
+
+        /** Retrieves a fence pool, created for this device instance. Please see FencePool for more details.
+         *
+         *  @return As per description
+         **/
+        std::shared_ptr<Anvil::FencePool> get_fence_pool() const
+        {
+            return m_fence_pool_ptr;
+        }
+
         /** Retrieves a graphics pipeline manager, created for this device instance.
          *
          *  @return As per description
@@ -273,6 +311,15 @@ namespace Anvil
             return m_pipeline_cache_ptr;
         }
 
+        /** Returns the persistent pipeline cache, which backs the pipeline cache returned by get_pipeline_cache().
+         *
+         *  @return As per description. nullptr if no pipeline cache directory was specified at creation time.
+         **/
+        std::shared_ptr<Anvil::PersistentPipelineCache> get_persistent_pipeline_cache() const
+        {
+            return m_persistent_pipeline_cache_ptr;
+        }
+
         /** Returns a pipeline layout manager, created specifically for this device.
          *
          *  @return As per description
@@ -389,7 +436,8 @@ namespace Anvil
         void               init                (const std::vector<const char*>&   extensions,
                                                 const std::vector<const char*>&   layers,
                                                 bool                              transient_command_buffer_allocs_only,
-                                                bool                              support_resettable_command_buffer_allocs);
+                                                bool                              support_resettable_command_buffer_allocs,
+                                                const std::string&                pipeline_cache_directory);
 
         BaseDevice& operator=(const BaseDevice&);
         BaseDevice           (const BaseDevice&);
@@ -429,10 +477,15 @@ namespace Anvil
     private:
         /* Private variables */
         std::shared_ptr<Anvil::ComputePipelineManager>  m_compute_pipeline_manager_ptr;
+        std::shared_ptr<Anvil::DeferredDeletionQueue>   m_deferred_deletion_queue_ptr;
         std::shared_ptr<Anvil::DescriptorSetGroup>      m_dummy_dsg_ptr;
         std::vector<std::string>                        m_enabled_extensions;
+        std::shared_ptr<Anvil::EventPool>               m_event_pool_ptr;
+        std::shared_ptr<Anvil::FenceCompletionService>  m_fence_completion_service_ptr;
+        std::shared_ptr<Anvil::FencePool>               m_fence_pool_ptr;
         std::shared_ptr<Anvil::GraphicsPipelineManager> m_graphics_pipeline_manager_ptr;
         std::weak_ptr<Anvil::Instance>                  m_parent_instance_ptr;
+        std::shared_ptr<Anvil::PersistentPipelineCache> m_persistent_pipeline_cache_ptr;
         std::shared_ptr<Anvil::PipelineCache>           m_pipeline_cache_ptr;
         std::shared_ptr<Anvil::PipelineLayoutManager>   m_pipeline_layout_manager_ptr;
         uint32_t                                        m_queue_family_index[Anvil::QUEUE_FAMILY_TYPE_COUNT];
@@ -462,6 +515,10 @@ namespace Anvil
          *                                                  support.
          *  @param support_resettable_command_buffer_allocs True if the command pools should be configured for resettable command
          *                                                  buffer support.
+         *  @param pipeline_cache_directory                 If not empty, the device's pipeline cache is going to be pre-populated
+         *                                                  with data stored in this directory by earlier runs, and its contents
+         *                                                  are going to be written back to the directory when the device is
+         *                                                  destroyed. See PersistentPipelineCache for more details.
          *
          *  @return A new Device instance.
          **/
@@ -469,7 +526,8 @@ namespace Anvil
                                                        const std::vector<const char*>&      extensions,
                                                        const std::vector<const char*>&      layers,
                                                        bool                                 transient_command_buffer_allocs_only,
-                                                       bool                                 support_resettable_command_buffer_allocs);
+                                                       bool                                 support_resettable_command_buffer_allocs,
+                                                       const std::string&                   pipeline_cache_directory = std::string() );
 
         /** Creates a new swapchain instance for the device.
          *
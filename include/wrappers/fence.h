@@ -72,6 +72,17 @@ namespace Anvil
             return &m_fence;
         }
 
+        /** Tells whether the fence may have been signalled since it was created or last reset. This is
+         *  the case once a pointer to the raw handle has been retrieved with get_fence_ptr(), which Queue
+         *  does whenever it submits the fence.
+         *
+         *  @return false if the fence is guaranteed to be unsignalled, true otherwise.
+         **/
+        bool is_possibly_set() const
+        {
+            return m_possibly_set;
+        }
+
         /** Tells whether the fence is signalled at the time of the call.
          *
          *  @return true if the fence is set, false otherwise.
@@ -98,6 +109,18 @@ namespace Anvil
         static bool reset_fences(const uint32_t n_fences,
                                  Fence*         fences);
 
+        /** Resets the specified number of Vulkan fences. Please see the other reset_fences() overload
+         *  for more details.
+         *
+         *  @param n_fences   Number of Fence instance pointers accessible under @param fence_ptrs.
+         *  @param fence_ptrs An array of @param n_fences pointers to Fence instances to reset. Must not be
+         *                    nullptr, unless @param n_fences is 0.
+         *
+         *  @return true if the function executed successfully, false otherwise.
+         **/
+        static bool reset_fences(const uint32_t      n_fences,
+                                 Fence* const* const fence_ptrs);
+
     private:
         /* Private functions */
 
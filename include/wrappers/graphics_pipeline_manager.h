@@ -28,6 +28,10 @@
  * - baking of the graphics pipeline object
  * - pipeline properties are assigned default values, as described below. They can be
  *   adjusted by calling relevant entrypoints, prior to baking.
+ * - deduplication of pipeline objects. Pipelines whose full state (including shader modules,
+ *   specialization constants, the pipeline layout and the render pass compatibility class)
+ *   matches share a single, reference-counted Vulkan pipeline object. Derivative pipelines,
+ *   pipelines which allow derivatives and pipelines with a pre-bake call-back are never shared.
  *
  *  Each baked graphics pipeline is configured as below at Pipeline object creation time:
  *
@@ -73,7 +77,9 @@
 #include "../misc/base_pipeline_manager.h"
 #include "../misc/types.h"
 #include "../wrappers/render_pass.h"
+#include <atomic>
 #include <map>
+#include <thread>
 
 namespace Anvil
 {
@@ -94,6 +100,9 @@ namespace Anvil
             DYNAMIC_STATE_VIEWPORT_BIT             = 1 << 8,
         } DynamicStateBits;
 
+        /* Identifies a set of pipelines scheduled for baking by a bake_async() call. 0 is never used as a ticket. */
+        typedef uint32_t AsyncBakeTicket;
+
         typedef uint32_t DynamicStateBitfield;
 
         /* Prototype for a call-back function, invoked right after vkCreateGraphicsPipelines() call returns. **/
@@ -280,10 +289,41 @@ namespace Anvil
         /** Generates a VkPipeline instance for each pipeline object marked as dirty. If a dirty pipeline
          *  has already been baked in the past, the former object instance is released.
          *
+         *  Pipelines with a pending async bake are skipped.
+         *
          *  @return true if successful, false otherwise.
          **/
         bool bake();
 
+        /** Schedules creation of Vulkan pipeline objects for the specified pipelines on one of the manager's bake
+         *  worker threads, so that the calling thread is not blocked while the driver compiles them. Bakes are queued,
+         *  so the number of async bakes running at the same time is bounded by the number of worker threads. Please
+         *  see BasePipelineManager::set_n_bake_worker_threads() for more details.
+         *
+         *  Until the bake completes, get_graphics_pipeline() returns the fallback pipeline assigned to the pipeline
+         *  with set_pipeline_fallback(), or VK_NULL_HANDLE if there is none. Once completed, the new pipeline object
+         *  replaces the pipeline's former one the next time the pipeline is queried. Completed bakes are also retired
+         *  by is_async_bake_complete() and wait_for_async_bake().
+         *
+         *  Pipeline state is captured at call time. Pipelines modified while their bake is pending are baked again
+         *  the first time they are queried after the bake completes.
+         *
+         *  Dirty base pipelines of the specified derivative pipelines are baked together with them. Pipelines which are
+         *  not dirty, or which already have an async bake pending, are skipped. Pipelines are created the same way
+         *  bake() would create them at call time: in parallel mode, the worker thread running the bake splits them
+         *  across other worker threads, which are not busy at the time.
+         *
+         *  @param n_pipelines    Number of pipeline IDs available under @param pipeline_ids.
+         *  @param pipeline_ids   IDs of the pipelines to bake. Must not be nullptr if @param n_pipelines is not 0.
+         *  @param out_ticket_ptr Deref will be set to a ticket identifying the bake, or to 0 if none of the pipelines
+         *                        needed baking. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool bake_async(uint32_t                  n_pipelines,
+                        const GraphicsPipelineID* pipeline_ids,
+                        AsyncBakeTicket*          out_ticket_ptr);
+
         /** Tells whether the graphics pipeline has been created with enabled alpha-to-coverage mode.
          *
          *  @param graphics_pipeline_id   ID of the graphics pipeline the query is being made for.
@@ -492,6 +532,9 @@ namespace Anvil
         /** Returns a VkPipeline instance for the specified graphics pipeline ID. If the pipeline is marked as dirty,
          *  the Vulkan object will be created before returning after former instance is released.
          *
+         *  If an async bake is pending for the pipeline, the function does not block. Instead, it returns the
+         *  pipeline's fallback pipeline, or VK_NULL_HANDLE if no fallback pipeline has been assigned.
+         *
          *  @param pipeline_id ID of the pipeline to return the VkPipeline instance for. Must not describe
          *                     a proxy pipeline.
          *
@@ -511,6 +554,26 @@ namespace Anvil
          **/
         std::shared_ptr<Anvil::PipelineLayout> get_graphics_pipeline_layout(GraphicsPipelineID pipeline_id);
 
+        /** Returns a variant of the specified graphics pipeline, which uses the specified specialization constant values.
+         *  Variants are created as derivatives of the base pipeline on first use, and cached. A new variant uses the
+         *  base pipeline's renderpass, subpass and all other state, as configured at the time the variant is created.
+         *
+         *  Please see BasePipelineManager::get_pipeline_variant() for more details.
+         *
+         *  @param base_pipeline_id            ID of the pipeline to derive the variant from. Must not refer to a proxy
+         *                                     pipeline. The pipeline must have been created with derivatives allowed.
+         *  @param n_values                    Number of items available under @param value_ptrs.
+         *  @param value_ptrs                  Array of @param n_values specialization constant values. The base pipeline
+         *                                     must define a shader for each stage used by the values.
+         *  @param out_variant_pipeline_id_ptr Deref will be set to the ID of the variant pipeline. Must not be nullptr.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool get_graphics_pipeline_variant(GraphicsPipelineID                 base_pipeline_id,
+                                           uint32_t                           n_values,
+                                           const SpecializationConstantValue* value_ptrs,
+                                           GraphicsPipelineID*                out_variant_pipeline_id_ptr);
+
         /** Tells what primitive topology the specified graphics pipeline has been created for.
          *
          *  @param graphics_pipeline_id           ID of the graphics pipeline the query is being made for.
@@ -758,6 +821,15 @@ namespace Anvil
                                      float*             out_opt_min_depth_ptr,
                                      float*             out_opt_max_depth_ptr) const;
 
+        /** Tells whether the specified async bake has completed. If so, the bake is retired and its pipeline objects
+         *  are handed over to the baked pipelines.
+         *
+         *  @param ticket Ticket returned by a preceding bake_async() call.
+         *
+         *  @return true if the bake has completed or has been retired before, false otherwise.
+         **/
+        bool is_async_bake_complete(AsyncBakeTicket ticket);
+
         /** Sets a new blend constant for the specified graphics pipeline and marks the pipeline as dirty.
          *
          *  @param graphics_pipeline_id ID of the graphics pipeline to update. The ID must come from a preceding add_()
@@ -834,6 +906,20 @@ namespace Anvil
                                           float                 min_sample_shading,
                                           const VkSampleMask    sample_mask);
 
+        /** Assigns a fallback pipeline to the specified graphics pipeline. get_graphics_pipeline() returns the fallback
+         *  pipeline's Vulkan object while an async bake is pending for the pipeline. This call overwrites any previous
+         *  set_pipeline_fallback() calls.
+         *
+         *  @param graphics_pipeline_id          ID of the graphics pipeline to assign the fallback pipeline to.
+         *  @param fallback_graphics_pipeline_id ID of the fallback pipeline. Must not be equal to @param graphics_pipeline_id.
+         *                                       The fallback pipeline should be baked synchronously, since it is going to be
+         *                                       baked at first use otherwise.
+         *
+         *  @return true if successful, false otherwise.
+         **/
+        bool set_pipeline_fallback(GraphicsPipelineID graphics_pipeline_id,
+                                   GraphicsPipelineID fallback_graphics_pipeline_id);
+
         /** Sets a call-back, which GFX pipeline manager will invoke right after a vkCreateGraphicsPipeline() call is made.
          *
          *  The call-back will be issued right before the vkCreateGraphicsPipelines() call is issued.
@@ -1123,6 +1209,15 @@ namespace Anvil
         void toggle_stencil_test(GraphicsPipelineID graphics_pipeline_id,
                                  bool               should_enable);
 
+        /** Blocks until the specified async bake completes, and retires it.
+         *
+         *  @param ticket Ticket returned by a preceding bake_async() call.
+         *
+         *  @return true if the pipelines have been baked successfully, or if the bake has been retired before.
+         *          false otherwise.
+         **/
+        bool wait_for_async_bake(AsyncBakeTicket ticket);
+
     private:
         /* Private type declarations */
 
@@ -1374,6 +1469,37 @@ namespace Anvil
         typedef std::map<uint32_t, InternalScissorBox>   InternalScissorBoxes;
         typedef std::map<uint32_t, InternalViewport>     InternalViewports;
 
+        /** Vulkan create info descriptors formed for a graphics pipeline at its last bake, along with all data they
+         *  point to. Storage is kept between bakes, so re-baking a pipeline re-forms its descriptors in place, without
+         *  reallocating memory, and pipelines which have not been modified are not touched at all.
+         *
+         *  The descriptors are not re-formed while an async bake of the pipeline is pending.
+         */
+        typedef struct BakedCreateInfo
+        {
+            std::vector<VkPipelineColorBlendAttachmentState> color_blend_attachment_states_vk;
+            VkPipelineColorBlendStateCreateInfo              color_blend_state_create_info_vk;
+            VkPipelineDepthStencilStateCreateInfo            depth_stencil_state_create_info_vk;
+            VkPipelineDynamicStateCreateInfo                 dynamic_state_create_info_vk;
+            std::vector<VkDynamicState>                      enabled_dynamic_states_vk;
+            VkGraphicsPipelineCreateInfo                     graphics_pipeline_create_info_vk;
+            VkPipelineInputAssemblyStateCreateInfo           input_assembly_state_create_info_vk;
+            VkPipelineMultisampleStateCreateInfo             multisample_state_create_info_vk;
+            VkPipelineRasterizationStateCreateInfo           raster_state_create_info_vk;
+            VkSampleMask                                     sample_mask_vk;
+            std::vector<VkRect2D>                            scissor_boxes_vk;
+            std::vector<VkPipelineShaderStageCreateInfo>     shader_stage_create_info_items_vk;
+            std::vector<unsigned char>                       specialization_constant_data;
+            VkSpecializationInfo                             specialization_info_items_vk     [GRAPHICS_SHADER_STAGE_COUNT];
+            std::vector<VkSpecializationMapEntry>            specialization_map_entry_items_vk[GRAPHICS_SHADER_STAGE_COUNT];
+            VkPipelineTessellationStateCreateInfo            tessellation_state_create_info_vk;
+            std::vector<VkVertexInputAttributeDescription>   vertex_input_attributes_vk;
+            std::vector<VkVertexInputBindingDescription>     vertex_input_bindings_vk;
+            VkPipelineVertexInputStateCreateInfo             vertex_input_state_create_info_vk;
+            VkPipelineViewportStateCreateInfo                viewport_state_create_info_vk;
+            std::vector<VkViewport>                          viewports_vk;
+        } BakedCreateInfo;
+
         /** Descriptor which encapsulates all state of a single graphics pipeline.
          *
          *  This descriptor is not exposed to the Vulkan implementation. It is used to form Vulkan-specific
@@ -1442,6 +1568,13 @@ namespace Anvil
             std::shared_ptr<RenderPass> renderpass_ptr;
             SubPassID                   subpass_id;
 
+            GraphicsPipelineID fallback_pipeline_id;
+            bool               has_fallback_pipeline;
+            AsyncBakeTicket    pending_async_bake_ticket;
+
+            /* Not copied by the assignment operator */
+            BakedCreateInfo baked_create_info;
+
             /** Constructor.
              *
              *  @param in_renderpass_ptr RenderPass instance the graphics pipeline will be used for.
@@ -1486,6 +1619,10 @@ namespace Anvil
                 renderpass_ptr = in_renderpass_ptr;
                 subpass_id     = in_subpass_id;
 
+                fallback_pipeline_id      = 0;
+                has_fallback_pipeline     = false;
+                pending_async_bake_ticket = 0;
+
                 stencil_state_back_face.compareMask = ~0u;
                 stencil_state_back_face.compareOp   = VK_COMPARE_OP_ALWAYS;
                 stencil_state_back_face.depthFailOp = VK_STENCIL_OP_KEEP;
@@ -1530,6 +1667,11 @@ namespace Anvil
                 /* Override the renderpass & the subpass with the data we've been provided */
                 renderpass_ptr = in_renderpass_ptr;
                 subpass_id     = in_subpass_id;
+
+                /* Fallback pipelines and pending bakes are specific to a pipeline */
+                fallback_pipeline_id      = 0;
+                has_fallback_pipeline     = false;
+                pending_async_bake_ticket = 0;
             }
 
             /** Destructor. */
@@ -1607,18 +1749,190 @@ namespace Anvil
 
         typedef std::map<GraphicsPipelineID, std::shared_ptr<GraphicsPipelineConfiguration> > GraphicsPipelineConfigurations;
 
+        /** Data identifying the full state of a graphics pipeline: all fixed-function state, shader modules and
+         *  entry points, specialization constants, the pipeline layout and the render pass compatibility class.
+         *  Pipelines with equal keys can share a single Vulkan pipeline object.
+         */
+        typedef std::vector<uint32_t> PipelineStateKey;
+
+        /** Describes a Vulkan pipeline object, which can be shared by all pipelines with a matching state key. */
+        typedef struct SharedPipelineEntry
+        {
+            std::weak_ptr<SharedVkPipeline> pipeline_ptr;
+            PipelineStateKey                state_key;
+
+            /** Constructor.
+             *
+             *  @param in_pipeline_ptr Shared pipeline object. Not retained.
+             *  @param in_state_key    State key of the pipeline.
+             **/
+            SharedPipelineEntry(std::shared_ptr<SharedVkPipeline> in_pipeline_ptr,
+                                const PipelineStateKey&           in_state_key)
+            {
+                pipeline_ptr = in_pipeline_ptr;
+                state_key    = in_state_key;
+            }
+        } SharedPipelineEntry;
+
+        typedef std::map<uint64_t, std::vector<SharedPipelineEntry> > SharedPipelineEntries;
+
+        /** Holds data needed to create pipelines in the parallel bake mode */
+        typedef struct ParallelBakeContext
+        {
+            const VkGraphicsPipelineCreateInfo* create_info_items_vk_ptr;
+            VkDevice                            device_vk;
+            VkPipelineCache                     pipeline_cache_vk;
+
+            ParallelBakeContext()
+            {
+                create_info_items_vk_ptr = nullptr;
+                device_vk                = VK_NULL_HANDLE;
+                pipeline_cache_vk        = VK_NULL_HANDLE;
+            }
+        } ParallelBakeContext;
+
+        /** Describes a single pipeline baked by a bake() or bake_async() call. The pipeline's configuration
+         *  and layout are retained, so that they stay alive while an async bake is pending.
+         */
+        typedef struct BakeItem
+        {
+            std::shared_ptr<GraphicsPipelineConfiguration> config_ptr;
+            std::shared_ptr<PipelineLayout>                layout_ptr;
+            GraphicsPipelineID                             pipeline_id;
+            std::shared_ptr<Pipeline>                      pipeline_ptr;
+
+            BakeItem(std::shared_ptr<GraphicsPipelineConfiguration> in_config_ptr,
+                     std::shared_ptr<PipelineLayout>                in_layout_ptr,
+                     GraphicsPipelineID                             in_pipeline_id,
+                     std::shared_ptr<Pipeline>                      in_pipeline_ptr)
+            {
+                config_ptr   = in_config_ptr;
+                layout_ptr   = in_layout_ptr;
+                pipeline_id  = in_pipeline_id;
+                pipeline_ptr = in_pipeline_ptr;
+            }
+
+            bool operator==(std::shared_ptr<Pipeline> in_pipeline_ptr) const
+            {
+                return pipeline_ptr == in_pipeline_ptr;
+            }
+        } BakeItem;
+
+        /** Holds all data needed to create Vulkan pipeline objects for a set of pipelines, and to hand the objects
+         *  over to the pipelines afterward.
+         *
+         *  Create info descriptors point at the per-pipeline BakedCreateInfo storage, which also holds copies of
+         *  pipeline state (vertex input descriptors, sample masks, specialization constant data). An async bake can
+         *  thus proceed while the application modifies the pipelines.
+         *
+         *  Batches used by bake() are recycled, so that the vectors below do not need to be reallocated.
+         */
+        typedef struct BakeBatch
+        {
+            std::vector<double>                             bake_item_bake_times_ms;
+            std::vector<int32_t>                            bake_item_created_pipeline_indices;
+            std::vector<VkPipeline>                         bake_item_result_pipelines;
+            std::vector<std::shared_ptr<SharedVkPipeline> > bake_item_shared_pipeline_ptrs;
+            std::vector<int32_t>                            bake_item_source_indices;
+            std::vector<uint64_t>                           bake_item_state_key_hashes;
+            std::vector<PipelineStateKey>                   bake_item_state_keys;
+            std::vector<BakeItem>                           bake_items;
+
+            std::vector<VkGraphicsPipelineCreateInfo> create_info_items_to_bake_vk;
+            std::vector<int32_t>                      created_pipeline_base_indices;
+            std::vector<double>                       created_pipeline_bake_times_ms;
+            std::vector<VkPipeline>                   created_pipelines;
+
+            VkDevice        device_vk;
+            uint32_t        n_bake_worker_threads;
+            VkPipelineCache pipeline_cache_vk;
+
+            /* Async bakes only */
+            BakeWorkerJob            async_job;
+            GraphicsPipelineManager* manager_ptr;
+            bool                     result;
+            AsyncBakeTicket          ticket;
+
+            BakeBatch()
+            {
+                device_vk             = VK_NULL_HANDLE;
+                manager_ptr           = nullptr;
+                n_bake_worker_threads = 0;
+                pipeline_cache_vk     = VK_NULL_HANDLE;
+                result                = false;
+                ticket                = 0;
+            }
+
+            /** Releases references held by the batch, so that it can be reused by another bake() call. Capacity
+             *  of all vectors is retained.
+             *
+             *  Must not be called for batches of async bakes.
+             **/
+            void clear()
+            {
+                bake_item_bake_times_ms.clear           ();
+                bake_item_created_pipeline_indices.clear();
+                bake_item_result_pipelines.clear        ();
+                bake_item_shared_pipeline_ptrs.clear    ();
+                bake_item_source_indices.clear          ();
+                bake_item_state_key_hashes.clear        ();
+                bake_items.clear                        ();
+                create_info_items_to_bake_vk.clear      ();
+                created_pipeline_base_indices.clear     ();
+                created_pipeline_bake_times_ms.clear    ();
+                created_pipelines.clear                 ();
+
+                /* State keys are overwritten when the batch is prepared. Keep them, along with their storage. */
+                device_vk             = VK_NULL_HANDLE;
+                n_bake_worker_threads = 0;
+                pipeline_cache_vk     = VK_NULL_HANDLE;
+            }
+
+        private:
+            BakeBatch           (const BakeBatch&);
+            BakeBatch& operator=(const BakeBatch&);
+        } BakeBatch;
+
+        typedef std::map<AsyncBakeTicket, std::shared_ptr<BakeBatch> > AsyncBakes;
+
         /* Private functions */
         explicit GraphicsPipelineManager(std::weak_ptr<Anvil::BaseDevice>      device_ptr,
                                          bool                                  use_pipeline_cache,
                                          std::shared_ptr<Anvil::PipelineCache> pipeline_cache_to_reuse_ptr);
 
+        bool add_pipeline_variant(PipelineID  base_pipeline_id,
+                                  PipelineID* out_pipeline_id_ptr);
+
         void bake_vk_attributes_and_bindings(std::shared_ptr<GraphicsPipelineConfiguration> pipeline_config_ptr);
 
+        bool            create_bake_batch_pipelines         (BakeBatch*  bake_batch_ptr);
+        static bool     create_bake_batch_pipelines_serially(BakeBatch*  bake_batch_ptr);
+        static void     run_async_bake                      (void*       user_arg);
+        static VkResult create_pipeline_for_parallel_bake   (void*       user_arg,
+                                                             uint32_t    n_item,
+                                                             VkPipeline  base_pipeline,
+                                                             VkPipeline* out_pipeline_ptr);
+
+        bool finish_async_bake (AsyncBakes::iterator                   async_bake_iterator);
+        bool finish_bake_batch (BakeBatch*                             bake_batch_ptr,
+                                bool                                   creation_succeeded);
+        bool prepare_bake_batch(const std::vector<GraphicsPipelineID>* opt_pipeline_ids_ptr,
+                                BakeBatch*                             out_bake_batch_ptr);
+
+        static bool get_pipeline_state_key(const VkGraphicsPipelineCreateInfo& create_info,
+                                           std::shared_ptr<RenderPass>         renderpass_ptr,
+                                           PipelineStateKey*                   out_state_key_ptr,
+                                           uint64_t*                           out_state_key_hash_ptr);
+
         ANVIL_DISABLE_ASSIGNMENT_OPERATOR(GraphicsPipelineManager);
         ANVIL_DISABLE_COPY_CONSTRUCTOR   (GraphicsPipelineManager);
 
         /* Private members */
+        AsyncBakeTicket                m_async_bake_ticket_counter;
+        AsyncBakes                     m_async_bakes;
+        std::unique_ptr<BakeBatch>     m_bake_batch_ptr;
         GraphicsPipelineConfigurations m_pipeline_configurations;
+        SharedPipelineEntries          m_shared_pipelines;
     };
 }; /* Vulkan namespace */
 
@@ -31,6 +31,7 @@
 
 #include "../misc/types.h"
 #include "../misc/page_tracker.h"
+#include <mutex>
 
 namespace Anvil
 {
@@ -347,6 +348,22 @@ namespace Anvil
         /** Returns a filled subresource range descriptor, covering all layers & mipmaps of the image */
         VkImageSubresourceRange get_subresource_range() const;
 
+        /** Returns the state the specified subresource has been left in by the most recently submitted
+         *  command buffer, which transitioned it with CommandBufferBase::record_transition().
+         *
+         *  For subresources which have never been transitioned that way, the returned state
+         *  holds the layout the image has been transitioned to at creation time.
+         *
+         *  @param n_layer  Index of the layer to use.
+         *  @param n_mipmap Index of the mipmap to use.
+         *
+         *  This function is thread-safe.
+         *
+         *  @return Requested state.
+         **/
+        Anvil::ResourceState get_tracked_subresource_state(uint32_t n_layer,
+                                                           uint32_t n_mipmap) const;
+
         /** Tells whether this image provides data for the specified image aspects.
          *
          *  @param aspects A bitfield of image aspect bits which should be used for the query.
@@ -676,6 +693,12 @@ namespace Anvil
                                std::shared_ptr<Anvil::MemoryBlock> memory_block_ptr,
                                VkDeviceSize                        memory_block_start_offset);
 
+        Anvil::ResourceState get_untracked_subresource_state() const;
+
+        void set_tracked_subresource_state(uint32_t                    n_layer,
+                                           uint32_t                    n_mipmap,
+                                           const Anvil::ResourceState& state);
+
         void transition_to_post_create_image_layout(VkAccessFlags src_access_mask,
                                                     VkImageLayout src_layout);
 
@@ -727,8 +750,11 @@ namespace Anvil
         std::unique_ptr<Anvil::PageTracker>                                        m_page_tracker_ptr; /* only used for sparse non-resident images */
         std::map<VkImageAspectFlagBits, std::shared_ptr<AspectPageOccupancyData> > m_sparse_aspect_page_occupancy;
         std::map<VkImageAspectFlagBits, Anvil::SparseImageAspectProperties>        m_sparse_aspect_props;
+        std::vector<Anvil::ResourceState>                                          m_tracked_subresource_states; /* n_mipmap * m_n_layers + n_layer */
+        mutable std::mutex                                                         m_tracked_subresource_states_mutex;
 
         friend class Anvil::Queue;
+        friend class Anvil::ResourceStateTracker; /* set_tracked_subresource_state() */
     };
 }; /* Vulkan namespace */
 
@@ -63,8 +63,8 @@ namespace Anvil
          *
          *  @return true if successful, false otherwise.
          **/
-        bool get_data(size_t*      out_n_data_bytes_ptr,
-                      const void** out_data_ptr);
+        bool get_data(size_t* out_n_data_bytes_ptr,
+                      void*   out_data_ptr);
 
         /** Retrieves raw Vulkan pipeline cache handle */
         const VkPipelineCache& get_pipeline_cache() const
@@ -45,6 +45,11 @@ namespace Anvil
         /** Returns a pipeline layout wrapper matching the specified DSG + push constant range configuration.
          *  If such pipeline layout has never been defined before, it will be created at the call time.
          *
+         *  Layouts are matched by the contents of the DSG's descriptor set layouts, rather than by the DSG
+         *  instance. Different DSGs with identically defined descriptor set layouts and equal push constant
+         *  ranges are therefore given the same layout wrapper, whose attached DSG is the one the layout has
+         *  been created for.
+         *
          *  If the function returns a Anvil::PipelineLayout instance, it is caller's responsibility to release it
          *  in order for the object to be correctly deleted when its reference counter drops to zero.
          *
@@ -76,10 +81,42 @@ namespace Anvil
     private:
         /* Private type declarations */
 
+        /** Serialized descriptor set layout bindings and push constant ranges, identifying a pipeline layout. */
+        typedef std::vector<uint64_t> PipelineLayoutKey;
+
+        typedef struct PipelineLayoutInfo
+        {
+            PipelineLayoutKey                    key;
+            uint64_t                             key_hash;
+            std::weak_ptr<Anvil::PipelineLayout> layout_ptr;
+
+            /** Dummy constructor. Should only be used by STL containers. */
+            PipelineLayoutInfo()
+            {
+                key_hash = 0;
+            }
+
+            /** Constructor.
+             *
+             *  @param in_key        Key of the pipeline layout.
+             *  @param in_key_hash   Hash of @param in_key.
+             *  @param in_layout_ptr Pipeline layout wrapper. Not retained.
+             **/
+            PipelineLayoutInfo(const PipelineLayoutKey&               in_key,
+                               uint64_t                               in_key_hash,
+                               std::shared_ptr<Anvil::PipelineLayout> in_layout_ptr)
+            {
+                key        = in_key;
+                key_hash   = in_key_hash;
+                layout_ptr = in_layout_ptr;
+            }
+        } PipelineLayoutInfo;
+
         /* NOTE: We do NOT own pipeline layouts. As soon as all wrapper instances are out of scope,
          *       we drop the ID.
          */
-        typedef std::map<Anvil::PipelineLayoutID, std::weak_ptr<Anvil::PipelineLayout> > PipelineLayouts;
+        typedef std::map<Anvil::PipelineLayoutID, PipelineLayoutInfo>     PipelineLayouts;
+        typedef std::map<uint64_t, std::vector<Anvil::PipelineLayoutID> > PipelineLayoutIDsByHash;
 
         /* Private functions */
         PipelineLayoutManager(std::weak_ptr<Anvil::BaseDevice> device_ptr);
@@ -97,11 +134,17 @@ namespace Anvil
          **/
         static std::shared_ptr<PipelineLayoutManager> create(std::weak_ptr<Anvil::BaseDevice> device_ptr);
 
+        static void get_layout_key(std::shared_ptr<DescriptorSetGroup> dsg_ptr,
+                                   const PushConstantRanges&           push_constant_ranges,
+                                   PipelineLayoutKey*                  out_key_ptr,
+                                   uint64_t*                           out_key_hash_ptr);
+
         static void on_pipeline_layout_dropped(void* callback_arg,
                                                void* user_arg);
 
         /* Private members */
         std::weak_ptr<Anvil::BaseDevice> m_device_ptr;
+        PipelineLayoutIDsByHash          m_pipeline_layout_ids_by_hash;
         PipelineLayouts                  m_pipeline_layouts;
         Anvil::PipelineLayoutID          m_pipeline_layouts_created;
 
@@ -76,12 +76,64 @@ namespace Anvil
             return m_n_max_indices;
         }
 
+        /** Retrieves the number of values each query of the pool produces. This is 1 for occlusion and
+         *  timestamp queries, and the number of enabled counters for pipeline statistics queries.
+         **/
+        uint32_t get_n_values_per_query() const;
+
+        /** Retrieves pipeline statistics enabled for the pool. Returns 0 for non-PS query pools. */
+        VkQueryPipelineStatisticFlags get_pipeline_statistics() const
+        {
+            return m_pipeline_statistics;
+        }
+
         /** Retrieves the raw Vulkan handle of the encapsulated query pool. */
         VkQueryPool get_query_pool() const
         {
             return m_query_pool_vk;
         }
 
+        /** Retrieves type of queries the pool has been created for. */
+        VkQueryType get_query_type() const
+        {
+            return m_query_type;
+        }
+
+        /** Retrieves results of a range of queries as 32-bit values, by issuing a vkGetQueryPoolResults() call.
+         *
+         *  Results of each query are stored as get_n_values_per_query() consecutive values. If @param in_flags
+         *  includes VK_QUERY_RESULT_WITH_AVAILABILITY_BIT, they are followed by an availability value, which
+         *  is non-zero if the query's results are available.
+         *
+         *  Unless @param in_flags includes VK_QUERY_RESULT_WAIT_BIT, the call does not block. Values of queries,
+         *  whose results are not available, are only written if VK_QUERY_RESULT_PARTIAL_BIT is specified.
+         *
+         *  @param in_first_query            Index of the first query to retrieve results for.
+         *  @param in_n_queries              Number of queries to retrieve results for.
+         *  @param in_flags                  Query result flags. VK_QUERY_RESULT_64_BIT is ignored.
+         *  @param in_n_out_values           Number of values @param out_results_ptr can hold. Must be large enough
+         *                                   to hold results of all queries, as described above.
+         *  @param out_results_ptr           Deref will be filled with query results. Must not be nullptr.
+         *  @param opt_out_all_available_ptr If not nullptr, deref will be set to true if results of all queries
+         *                                   were available at the time of the call, and to false otherwise.
+         *
+         *  @return true if successful, false otherwise. Unavailable results do not cause the call to fail.
+         **/
+        bool get_results(Anvil::QueryIndex  in_first_query,
+                         uint32_t           in_n_queries,
+                         VkQueryResultFlags in_flags,
+                         uint32_t           in_n_out_values,
+                         uint32_t*          out_results_ptr,
+                         bool*              opt_out_all_available_ptr = nullptr);
+
+        /** Retrieves results of a range of queries as 64-bit values. Please see the 32-bit version for more details. */
+        bool get_results(Anvil::QueryIndex  in_first_query,
+                         uint32_t           in_n_queries,
+                         VkQueryResultFlags in_flags,
+                         uint32_t           in_n_out_values,
+                         uint64_t*          out_results_ptr,
+                         bool*              opt_out_all_available_ptr = nullptr);
+
 
     private:
         /* Constructor. Please see corresponding create() for specification */
@@ -108,10 +160,20 @@ namespace Anvil
                   VkFlags                          in_flags,
                   uint32_t                         in_n_max_concurrent_queries);
 
+        bool get_results_internal(Anvil::QueryIndex  in_first_query,
+                                  uint32_t           in_n_queries,
+                                  VkQueryResultFlags in_flags,
+                                  uint32_t           in_value_size,
+                                  uint32_t           in_n_out_values,
+                                  void*              out_results_ptr,
+                                  bool*              opt_out_all_available_ptr);
+
         /* Private variables */
         std::weak_ptr<Anvil::BaseDevice> m_device_ptr;
         uint32_t                         m_n_max_indices;
+        VkQueryPipelineStatisticFlags    m_pipeline_statistics;
         VkQueryPool                      m_query_pool_vk;
+        VkQueryType                      m_query_type;
     };
 }; /* namespace Anvil */
 
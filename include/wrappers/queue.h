@@ -24,17 +24,99 @@
  *
  *  - encapsulate all state related to a single queue.
  *  - let ObjectTracker detect leaking queue wrapper instances.
+ *  - optionally synchronize submissions issued from many threads.
  *
- *  The wrapper is NOT thread-safe.
+ *  By default, the wrapper is NOT thread-safe. Please see Queue::set_submission_mode() for
+ *  thread-safe submission modes.
  **/
 #ifndef WRAPPERS_QUEUE_H
 #define WRAPPERS_QUEUE_H
 
 #include "../misc/debug.h"
 #include "../misc/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace Anvil
 {
+    /** Collects a number of logical queue submissions, each with its own command buffers, wait semaphores,
+     *  wait stage masks and signal semaphores, so that they can be submitted with a single vkQueueSubmit()
+     *  call. Please see Queue::submit_batch() for more details.
+     *
+     *  Storage is retained across clear() calls, so a batch which is reused every frame does not allocate
+     *  memory once it has grown to its working size.
+     *
+     *  The batch retains command buffers and semaphores added to it until it is cleared.
+     **/
+    class QueueSubmitBatch
+    {
+    public:
+        /* Public functions */
+
+        /** Constructor. */
+        QueueSubmitBatch();
+
+        /** Appends a new logical submission to the batch. Submissions are executed in the order they have
+         *  been added.
+         *
+         *  For argument discussion, please see Queue::submit_command_buffers() documentation.
+         **/
+        void add_submit(uint32_t                                         n_command_buffers,
+                        std::shared_ptr<Anvil::CommandBufferBase> const* opt_cmd_buffer_ptrs,
+                        uint32_t                                         n_semaphores_to_signal,
+                        std::shared_ptr<Anvil::Semaphore> const*         opt_semaphore_to_signal_ptr_ptrs,
+                        uint32_t                                         n_semaphores_to_wait_on,
+                        std::shared_ptr<Anvil::Semaphore> const*         opt_semaphore_to_wait_on_ptr_ptrs,
+                        const VkPipelineStageFlags*                      opt_dst_stage_masks_to_wait_on_ptrs);
+
+        /** Removes all submissions from the batch. */
+        void clear();
+
+        /** Returns the number of logical submissions held by the batch. */
+        uint32_t get_n_submits() const
+        {
+            return static_cast<uint32_t>(m_submits.size() );
+        }
+
+        /** Tells whether the batch holds no submissions. */
+        bool is_empty() const
+        {
+            return (m_submits.size() == 0);
+        }
+
+    private:
+        /* Private type definitions */
+        typedef struct Submit
+        {
+            uint32_t n_command_buffers;
+            uint32_t n_first_command_buffer;
+            uint32_t n_first_signal_semaphore;
+            uint32_t n_first_wait_semaphore;
+            uint32_t n_signal_semaphores;
+            uint32_t n_wait_semaphores;
+        } Submit;
+
+        /* Private functions */
+        QueueSubmitBatch           (const QueueSubmitBatch&);
+        QueueSubmitBatch& operator=(const QueueSubmitBatch&);
+
+        void move_submits_from(QueueSubmitBatch& in_batch);
+
+        /* Private variables */
+        std::vector<std::shared_ptr<Anvil::CommandBufferBase> > m_cmd_buffers;
+        std::vector<VkCommandBuffer>                            m_cmd_buffers_vk;
+        std::vector<std::shared_ptr<Anvil::Semaphore> >         m_semaphores;
+        std::vector<VkSemaphore>                                m_signal_semaphores_vk;
+        std::vector<VkSubmitInfo>                               m_submit_infos_vk;
+        std::vector<Submit>                                     m_submits;
+        std::vector<VkPipelineStageFlags>                       m_wait_dst_stage_masks;
+        std::vector<VkSemaphore>                                m_wait_semaphores_vk;
+
+        friend class Queue;
+    };
+
     class Queue
     {
     public:
@@ -63,6 +145,21 @@ namespace Anvil
          **/
         bool bind_sparse_memory(Anvil::Utils::SparseMemoryBindingUpdateInfo& update);
 
+        /** Blocks until all submissions, which have been pushed to the submit thread prior to the call,
+         *  have been submitted to the Vulkan queue.
+         *
+         *  This function is a nop, unless the queue uses QUEUE_SUBMISSION_MODE_SUBMIT_THREAD submission mode.
+         **/
+        void flush_submissions();
+
+        /** Returns the number of submission requests issued to the queue so far. This includes
+         *  sparse binding requests.
+         **/
+        uint64_t get_n_submissions() const
+        {
+            return m_n_submissions;
+        }
+
         /** Retrieves parent device instance */
         std::weak_ptr<Anvil::BaseDevice> get_parent_device() const
         {
@@ -81,6 +178,12 @@ namespace Anvil
             return m_queue_family_index;
         }
 
+        /** Retrieves the submission mode used by the queue. */
+        Anvil::QueueSubmissionMode get_submission_mode() const
+        {
+            return m_submission_mode;
+        }
+
         /** Presents the specified swapchain image using this queue.
          *
          *  This function will only succeed if supports_presentation() returns true.
@@ -104,6 +207,52 @@ namespace Anvil
                          uint32_t                           n_wait_semaphores,
                          std::shared_ptr<Anvil::Semaphore>* wait_semaphore_ptrs);
 
+        /** Changes the way the queue synchronizes access to the underlying Vulkan queue.
+         *
+         *  In QUEUE_SUBMISSION_MODE_UNSYNCHRONIZED mode (default), submissions are issued directly from the
+         *  calling thread, and the application must synchronize all queue-related calls.
+         *
+         *  In QUEUE_SUBMISSION_MODE_MUTEX mode, present(), bind_sparse_memory() and all submission functions
+         *  can be called from any thread. Each call owns a per-queue mutex while it talks to Vulkan.
+         *
+         *  In QUEUE_SUBMISSION_MODE_SUBMIT_THREAD mode, submission functions push their requests to a lock-free
+         *  multi-producer queue and return straight away, unless they have been asked to block. A dedicated
+         *  submit thread drains the queue, and coalesces all requests it finds there into as few vkQueueSubmit()
+         *  calls as possible. A new call is only started after each request which comes with a fence. Requests
+         *  are submitted in the order they have been pushed in. present() and bind_sparse_memory() flush pending
+         *  requests before they execute.
+         *
+         *  In all modes, command buffers are committed (please see CommandBufferBase::commit_resource_states())
+         *  on the calling thread, before the submission function returns. Command buffers recorded after
+         *  the call therefore see resource states left by the submitted ones, even if the submit thread has
+         *  not picked the request up yet.
+         *
+         *  This function must not be called while other threads use the queue.
+         *
+         *  @param in_submission_mode New submission mode to use.
+         **/
+        void set_submission_mode(Anvil::QueueSubmissionMode in_submission_mode);
+
+        /** Submits all logical submissions held by the batch with a single vkQueueSubmit() call, and
+         *  clears the batch.
+         *
+         *  Submitting several logical submissions at once is considerably cheaper than issuing a separate
+         *  vkQueueSubmit() call for each of them. Semaphore waits and signals of each logical submission
+         *  behave exactly as if the submissions were issued one after another.
+         *
+         *  If @param should_block is true and @param opt_fence_ptr is nullptr, the function will take
+         *  a fence from the device's fence pool, wait on it, and then return it to the pool prior to leaving.
+         *
+         *  @param batch_ptr     Batch to submit. Must not be nullptr. If the batch is empty and no fence
+         *                       is used, no vkQueueSubmit() call is made.
+         *  @param should_block  true if the function should wait for all submissions to finish executing,
+         *                       false otherwise.
+         *  @param opt_fence_ptr Fence to signal once all submissions finish executing. May be nullptr.
+         **/
+        void submit_batch(Anvil::QueueSubmitBatch*      batch_ptr,
+                          bool                          should_block,
+                          std::shared_ptr<Anvil::Fence> opt_fence_ptr = std::shared_ptr<Anvil::Fence>() );
+
         /** Waits on the semaphores specified by the user, executes user-defined command buffers,
          *  and then signals the semaphores passed by arguments. If a non-nullptr fence is specified,
          *  the function will also wait on the call to finish GPU-side before returning.
@@ -111,8 +260,8 @@ namespace Anvil
          *  It is valid to specify 0 command buffers or signal/wait semaphores, in which case
          *  these steps will be skipped.
          *
-         *  If @param should_block is true and @param opt_fence_ptr is nullptr, the function will create
-         *  a new fence, wait on it, and then release it prior to leaving. This may come at a performance cost.
+         *  If @param should_block is true and @param opt_fence_ptr is nullptr, the function will take
+         *  a fence from the device's fence pool, wait on it, and then return it to the pool prior to leaving.
          *
          *  @param n_command_buffers                   Number of command buffers under @param opt_cmd_buffer_ptrs
          *                                             which should be executed. May be 0.
@@ -248,6 +397,21 @@ namespace Anvil
         }
 
     private:
+        /* Private type definitions */
+
+        /** A request pushed to the submit thread. Please see set_submission_mode() for more details. */
+        typedef struct SubmitRequest
+        {
+            Anvil::QueueSubmitBatch       batch;
+            std::shared_ptr<Anvil::Fence> fence_ptr;
+            SubmitRequest*                next_ptr;
+
+            SubmitRequest()
+            {
+                next_ptr = nullptr;
+            }
+        } SubmitRequest;
+
         /* Private functions */
 
         /* Constructor. Please see create() for specification */
@@ -258,12 +422,40 @@ namespace Anvil
         Queue          (const Queue&);
         Queue operator=(const Queue&);
 
+        SubmitRequest* acquire_submit_request   ();
+        void           commit_resource_states   (uint32_t                                         in_n_command_buffers,
+                                                 std::shared_ptr<Anvil::CommandBufferBase> const* in_cmd_buffer_ptrs);
+        void           process_submit_requests  (SubmitRequest*                in_requests_ptr);
+        void           push_submit_request      (SubmitRequest*                in_request_ptr);
+        void           start_submit_thread      ();
+        void           stop_submit_thread       ();
+        void           submit_batch_internal    (Anvil::QueueSubmitBatch*      in_batch_ptr,
+                                                 std::shared_ptr<Anvil::Fence> in_opt_fence_ptr);
+        void           submit_thread_entrypoint ();
+        void           wait_for_fence           (std::shared_ptr<Anvil::Fence> in_fence_ptr);
+
         /* Private variables */
         std::weak_ptr<Anvil::BaseDevice> m_device_ptr;
+        std::atomic<uint64_t>            m_n_submissions;
         VkQueue                          m_queue;
         uint32_t                         m_queue_family_index;
         uint32_t                         m_queue_index;
+        std::mutex                       m_queue_mutex;
+        Anvil::QueueSubmitBatch          m_single_submit_batch;
+        Anvil::QueueSubmissionMode       m_submission_mode;
         bool                             m_supports_sparse_bindings;
+
+        std::vector<SubmitRequest*>  m_free_submit_requests;
+        std::mutex                   m_free_submit_requests_mutex;
+        std::atomic<uint64_t>        m_n_submit_requests_pushed;
+        uint64_t                     m_n_submit_requests_submitted;
+        std::condition_variable      m_submit_requests_submitted_cv;
+        std::atomic<SubmitRequest*>  m_submit_requests_head;
+        std::thread                  m_submit_thread;
+        Anvil::QueueSubmitBatch      m_submit_thread_batch;
+        std::condition_variable      m_submit_thread_cv;
+        std::mutex                   m_submit_thread_mutex;
+        bool                         m_submit_thread_should_quit;
     };
 }; /* namespace Anvil */
 
@@ -386,6 +386,17 @@ namespace Anvil
                                              VkImageLayout*         out_opt_final_layout_ptr   = nullptr,
                                              bool*                  out_opt_may_alias_ptr      = nullptr) const;
 
+        /** Fills @param out_key_ptr with data identifying the render pass compatibility class.
+         *
+         *  Two render passes which produce the same key are compatible, as defined by the Vulkan specification,
+         *  so a graphics pipeline created for one of them can be used with the other. Load/store ops and image
+         *  layouts are not included in the key. The key errs on the side of caution, so some compatible render
+         *  passes may still produce different keys.
+         *
+         *  @param out_key_ptr Deref will be cleared and filled with the key. Must not be nullptr.
+         **/
+        void get_compatibility_key(std::vector<uint32_t>* out_key_ptr) const;
+
         /** Retrieves properties of a dependency at user-specified index.
          *
          *  @param n_dependency                    Index of the dependency to retrieve properties of.
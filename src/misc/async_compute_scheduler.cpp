@@ -0,0 +1,1232 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "misc/async_compute_scheduler.h"
+#include "misc/debug.h"
+#include "misc/fence_pool.h"
+#include "wrappers/buffer.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/command_pool.h"
+#include "wrappers/device.h"
+#include "wrappers/fence.h"
+#include "wrappers/image.h"
+#include "wrappers/query_pool.h"
+#include "wrappers/queue.h"
+#include "wrappers/semaphore.h"
+#include <algorithm>
+
+/* Access types which modify the accessed resource */
+static const VkAccessFlags g_write_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT         |
+                                                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                                 VK_ACCESS_HOST_WRITE_BIT                     |
+                                                 VK_ACCESS_MEMORY_WRITE_BIT                   |
+                                                 VK_ACCESS_SHADER_WRITE_BIT                   |
+                                                 VK_ACCESS_TRANSFER_WRITE_BIT;
+
+
+/** Please see header for specification */
+Anvil::AsyncComputeScheduler::AsyncComputeScheduler(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                    uint32_t                         in_n_frames_in_flight,
+                                                    uint32_t                         in_n_max_jobs_per_frame)
+    :m_device_ptr          (in_device_ptr),
+     m_is_frame_active     (false),
+     m_n_current_frame_slot(in_n_frames_in_flight - 1),
+     m_n_frames_in_flight  (in_n_frames_in_flight),
+     m_n_max_jobs_per_frame(in_n_max_jobs_per_frame),
+     m_timestamp_period_ns (0.0)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::AsyncComputeScheduler::~AsyncComputeScheduler()
+{
+    anvil_assert(!m_is_frame_active);
+
+    /* Frame slot resources must not be released while the GPU may still use them */
+    for (auto frame_slot_iterator  = m_frame_slots.begin();
+              frame_slot_iterator != m_frame_slots.end();
+            ++frame_slot_iterator)
+    {
+        wait_for_frame(&(*frame_slot_iterator) );
+    }
+}
+
+/** Makes a job depend on another job. If the dependency has already been declared, the wait stage masks
+ *  are merged.
+ *
+ *  @param in_job_id            ID of the dependent job.
+ *  @param in_dependency_job_id ID of the job to depend on.
+ *  @param in_wait_stage_mask   Pipeline stages of the dependent job which should wait.
+ **/
+void Anvil::AsyncComputeScheduler::add_dependency(AsyncComputeJobID    in_job_id,
+                                                  AsyncComputeJobID    in_dependency_job_id,
+                                                  VkPipelineStageFlags in_wait_stage_mask)
+{
+    std::map<AsyncComputeJobID, VkPipelineStageFlags>& dependencies = m_jobs[in_job_id].dependencies;
+    auto                                               dep_iterator = dependencies.find(in_dependency_job_id);
+
+    anvil_assert(in_dependency_job_id < in_job_id);
+
+    if (dep_iterator == dependencies.end() )
+    {
+        dependencies[in_dependency_job_id] = in_wait_stage_mask;
+    }
+    else
+    {
+        dep_iterator->second |= in_wait_stage_mask;
+    }
+}
+
+/** Please see header for specification */
+bool Anvil::AsyncComputeScheduler::add_job(AsyncComputeJobAffinity                          in_affinity,
+                                           uint32_t                                         in_n_cmd_buffers,
+                                           std::shared_ptr<Anvil::CommandBufferBase> const* in_cmd_buffer_ptrs,
+                                           float                                            in_cost_estimate,
+                                           AsyncComputeJobID*                               out_job_id_ptr)
+{
+    Job      new_job;
+    uint32_t n_queue = 0;
+    bool     result  = false;
+
+    anvil_assert(m_is_frame_active);
+
+    if (in_affinity == ASYNC_COMPUTE_JOB_AFFINITY_COMPUTE)
+    {
+        /* Pick the compute queue with the lowest estimated load. Queue 0 is the universal queue, which is
+         * only used if the device exposes no compute queues. */
+        for (uint32_t n_compute_queue = 1;
+                      n_compute_queue < static_cast<uint32_t>(m_queues.size() );
+                    ++n_compute_queue)
+        {
+            if (n_queue                        == 0 ||
+                m_queues[n_compute_queue].load <  m_queues[n_queue].load)
+            {
+                n_queue = n_compute_queue;
+            }
+        }
+    }
+    else
+    if (in_affinity != ASYNC_COMPUTE_JOB_AFFINITY_UNIVERSAL)
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    new_job.cmd_buffers.assign(in_cmd_buffer_ptrs,
+                               in_cmd_buffer_ptrs + in_n_cmd_buffers);
+
+    new_job.n_queue         = n_queue;
+    m_queues[n_queue].load += in_cost_estimate;
+    *out_job_id_ptr         = static_cast<AsyncComputeJobID>(m_jobs.size() );
+
+    m_jobs.push_back(new_job);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::AsyncComputeScheduler::add_job_buffer_access(AsyncComputeJobID              in_job_id,
+                                                         std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                                         VkAccessFlags                  in_access_mask,
+                                                         VkPipelineStageFlags           in_stage_mask)
+{
+    ResourceAccess access;
+    bool           result = false;
+
+    if (in_job_id     >= m_jobs.size() ||
+        in_buffer_ptr == nullptr)
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    access.access_mask       = in_access_mask;
+    access.buffer_ptr        = in_buffer_ptr;
+    access.layout            = VK_IMAGE_LAYOUT_UNDEFINED;
+    access.stage_mask        = in_stage_mask;
+    access.subresource_range = VkImageSubresourceRange();
+
+    m_jobs[in_job_id].resource_accesses.push_back(access);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::AsyncComputeScheduler::add_job_dependency(AsyncComputeJobID    in_job_id,
+                                                      AsyncComputeJobID    in_dependency_job_id,
+                                                      VkPipelineStageFlags in_wait_stage_mask)
+{
+    bool result = false;
+
+    if (in_job_id            >= m_jobs.size() ||
+        in_dependency_job_id >= in_job_id)
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    add_dependency(in_job_id,
+                   in_dependency_job_id,
+                   in_wait_stage_mask);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::AsyncComputeScheduler::add_job_image_access(AsyncComputeJobID             in_job_id,
+                                                        std::shared_ptr<Anvil::Image> in_image_ptr,
+                                                        VkImageSubresourceRange       in_subresource_range,
+                                                        VkImageLayout                 in_layout,
+                                                        VkAccessFlags                 in_access_mask,
+                                                        VkPipelineStageFlags          in_stage_mask)
+{
+    ResourceAccess access;
+    bool           result = false;
+
+    if (in_job_id    >= m_jobs.size() ||
+        in_image_ptr == nullptr)
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    access.access_mask       = in_access_mask;
+    access.image_ptr         = in_image_ptr;
+    access.layout            = in_layout;
+    access.stage_mask        = in_stage_mask;
+    access.subresource_range = in_subresource_range;
+
+    m_jobs[in_job_id].resource_accesses.push_back(access);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::AsyncComputeScheduler::add_job_signal_semaphore(AsyncComputeJobID                 in_job_id,
+                                                            std::shared_ptr<Anvil::Semaphore> in_semaphore_ptr)
+{
+    bool result = false;
+
+    if (in_job_id        >= m_jobs.size() ||
+        in_semaphore_ptr == nullptr)
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    m_jobs[in_job_id].signal_semaphores.push_back(in_semaphore_ptr);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::AsyncComputeScheduler::add_job_wait_semaphore(AsyncComputeJobID                 in_job_id,
+                                                          std::shared_ptr<Anvil::Semaphore> in_semaphore_ptr,
+                                                          VkPipelineStageFlags              in_wait_stage_mask)
+{
+    bool result = false;
+
+    if (in_job_id        >= m_jobs.size() ||
+        in_semaphore_ptr == nullptr)
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    m_jobs[in_job_id].wait_semaphores.push_back (in_semaphore_ptr);
+    m_jobs[in_job_id].wait_stage_masks.push_back(in_wait_stage_mask);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::AsyncComputeScheduler::begin_frame()
+{
+    FrameSlot* frame_slot_ptr = nullptr;
+    bool       result         = false;
+
+    anvil_assert(!m_is_frame_active);
+
+    m_n_current_frame_slot = (m_n_current_frame_slot + 1) % m_n_frames_in_flight;
+    frame_slot_ptr         = &m_frame_slots[m_n_current_frame_slot];
+
+    if (!wait_for_frame(frame_slot_ptr) )
+    {
+        goto end;
+    }
+
+    for (uint32_t n_family_type = 0;
+                  n_family_type < QUEUE_FAMILY_TYPE_COUNT;
+                ++n_family_type)
+    {
+        if (frame_slot_ptr->n_used_cmd_buffers[n_family_type] == 0)
+        {
+            continue;
+        }
+
+        if (!frame_slot_ptr->command_pools[n_family_type]->reset(false) ) /* release_resources */
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        frame_slot_ptr->n_used_cmd_buffers[n_family_type] = 0;
+    }
+
+    for (auto queue_iterator  = m_queues.begin();
+              queue_iterator != m_queues.end();
+            ++queue_iterator)
+    {
+        queue_iterator->load = 0.0f;
+    }
+
+    frame_slot_ptr->n_used_semaphores = 0;
+    m_is_frame_active                 = true;
+
+    m_jobs.clear();
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::AsyncComputeScheduler> Anvil::AsyncComputeScheduler::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                                                   uint32_t                         in_n_frames_in_flight,
+                                                                                   uint32_t                         in_n_max_jobs_per_frame)
+{
+    std::shared_ptr<Anvil::AsyncComputeScheduler> result_ptr;
+
+    if (in_n_frames_in_flight == 0)
+    {
+        anvil_assert(in_n_frames_in_flight > 0);
+
+        goto end;
+    }
+
+    result_ptr.reset(
+        new Anvil::AsyncComputeScheduler(in_device_ptr,
+                                         in_n_frames_in_flight,
+                                         in_n_max_jobs_per_frame)
+    );
+
+    if (!result_ptr->init() )
+    {
+        result_ptr.reset();
+    }
+
+end:
+    return result_ptr;
+}
+
+/** Please see header for specification */
+bool Anvil::AsyncComputeScheduler::end_frame()
+{
+    Anvil::QueueSubmitBatch                                 batch;
+    uint32_t                                                batch_n_queue     = UINT32_MAX;
+    bool                                                    batch_needs_fence = false;
+    std::vector<std::shared_ptr<Anvil::CommandBufferBase> > cmd_buffers;
+    std::shared_ptr<Anvil::BaseDevice>                      device_locked_ptr(m_device_ptr);
+    FrameSlot&                                              frame_slot       (m_frame_slots[m_n_current_frame_slot]);
+    std::vector<AsyncComputeJobID>                          last_job_ids     (m_queues.size(), UINT32_MAX);
+    const AsyncComputeJobID                                 n_user_jobs       = static_cast<AsyncComputeJobID>(m_jobs.size() );
+    std::map<const void*, ResourceState>                    resource_states;
+    bool                                                    result            = false;
+
+    anvil_assert(m_is_frame_active);
+
+    m_is_frame_active = false;
+
+    /* Derive dependencies, ownership transfers and layout transitions from resource accesses */
+    for (AsyncComputeJobID n_job = 0;
+                           n_job < n_user_jobs;
+                         ++n_job)
+    {
+        for (uint32_t n_access = 0;
+                      n_access < static_cast<uint32_t>(m_jobs[n_job].resource_accesses.size() );
+                    ++n_access)
+        {
+            /* Copy, as process_resource_access() may grow m_jobs */
+            const ResourceAccess access = m_jobs[n_job].resource_accesses[n_access];
+
+            process_resource_access(n_job,
+                                    access,
+                                   &resource_states);
+        }
+    }
+
+    /* Return ownership and layout of all resources to the state they were in when the frame started. This
+     * is done by jobs appended to the end of the frame, which execute on the queue of each resource's first
+     * access and carry the acquire barriers. */
+    for (auto state_iterator  = resource_states.begin();
+              state_iterator != resource_states.end();
+            ++state_iterator)
+    {
+        const ResourceState& state = state_iterator->second;
+        ResourceAccess       return_access;
+        Job                  return_job;
+
+        if (!(state.is_exclusive && state.owner_queue_family_index != state.first_queue_family_index) &&
+            state.layout == state.first_access.layout)
+        {
+            continue;
+        }
+
+        return_access             = state.first_access;
+        return_access.access_mask = 0;
+        return_access.stage_mask  = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        return_job.is_ownership_return_job = true;
+        return_job.n_queue                 = state.first_n_queue;
+
+        return_job.resource_accesses.push_back(return_access);
+        m_jobs.push_back                      (return_job);
+    }
+
+    for (AsyncComputeJobID n_job = n_user_jobs;
+                           n_job < static_cast<AsyncComputeJobID>(m_jobs.size() );
+                         ++n_job)
+    {
+        const ResourceAccess access = m_jobs[n_job].resource_accesses[0];
+
+        process_resource_access(n_job,
+                                access,
+                               &resource_states);
+    }
+
+    /* Jobs on different queues are synchronized with semaphores. Jobs on the same queue are synchronized
+     * with a memory barrier, recorded before the dependent job. */
+    for (AsyncComputeJobID n_job = 0;
+                           n_job < static_cast<AsyncComputeJobID>(m_jobs.size() );
+                         ++n_job)
+    {
+        Job& job = m_jobs[n_job];
+
+        for (auto dep_iterator  = job.dependencies.begin();
+                  dep_iterator != job.dependencies.end();
+                ++dep_iterator)
+        {
+            Job& dependency_job = m_jobs[dep_iterator->first];
+
+            if (dependency_job.n_queue == job.n_queue)
+            {
+                job.same_queue_wait_stage_mask |= dep_iterator->second;
+            }
+            else
+            {
+                std::shared_ptr<Anvil::Semaphore> semaphore_ptr = get_semaphore();
+
+                if (semaphore_ptr == nullptr)
+                {
+                    anvil_assert(false);
+
+                    goto end;
+                }
+
+                dependency_job.signal_semaphores.push_back(semaphore_ptr);
+                job.wait_semaphores.push_back             (semaphore_ptr);
+                job.wait_stage_masks.push_back            (dep_iterator->second);
+            }
+        }
+
+        last_job_ids[job.n_queue] = n_job;
+    }
+
+    /* Submit the jobs in the order they have been added. Consecutive jobs assigned to the same queue are
+     * submitted with a single vkQueueSubmit() call. A batch is flushed whenever the next job is assigned to
+     * a different queue, so that all semaphores a job waits on have their signal operations submitted first.
+     * The batch holding the last job of a queue is submitted with a fence, which is waited on when the frame
+     * slot is reused. */
+    frame_slot.job_queue_indices.resize(m_jobs.size() );
+
+    for (AsyncComputeJobID n_job = 0;
+                           n_job <= static_cast<AsyncComputeJobID>(m_jobs.size() );
+                         ++n_job)
+    {
+        std::shared_ptr<Anvil::CommandBufferBase> epilogue_cmd_buffer_ptr;
+        std::shared_ptr<Anvil::CommandBufferBase> prologue_cmd_buffer_ptr;
+
+        if (!batch.is_empty()                    &&
+            (n_job                 == m_jobs.size() ||
+             m_jobs[n_job].n_queue != batch_n_queue) )
+        {
+            std::shared_ptr<Anvil::Fence> fence_ptr;
+
+            if (batch_needs_fence)
+            {
+                fence_ptr = device_locked_ptr->get_fence_pool()->get_fence();
+
+                frame_slot.fences.push_back(fence_ptr);
+            }
+
+            m_queues[batch_n_queue].queue_ptr->submit_batch(&batch,
+                                                            false, /* should_block */
+                                                            fence_ptr);
+
+            batch_needs_fence = false;
+        }
+
+        if (n_job == m_jobs.size() )
+        {
+            break;
+        }
+
+        Job& job = m_jobs[n_job];
+
+        if (!record_prologue(n_job,
+                            &prologue_cmd_buffer_ptr) ||
+            !record_epilogue(n_job,
+                            &epilogue_cmd_buffer_ptr) )
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        cmd_buffers.clear();
+
+        if (prologue_cmd_buffer_ptr != nullptr)
+        {
+            cmd_buffers.push_back(prologue_cmd_buffer_ptr);
+        }
+
+        cmd_buffers.insert(cmd_buffers.end(),
+                           job.cmd_buffers.begin(),
+                           job.cmd_buffers.end() );
+
+        if (epilogue_cmd_buffer_ptr != nullptr)
+        {
+            cmd_buffers.push_back(epilogue_cmd_buffer_ptr);
+        }
+
+        batch.add_submit(static_cast<uint32_t>(cmd_buffers.size() ),
+                         (cmd_buffers.size() > 0)           ? &cmd_buffers[0]           : nullptr,
+                         static_cast<uint32_t>(job.signal_semaphores.size() ),
+                         (job.signal_semaphores.size() > 0) ? &job.signal_semaphores[0] : nullptr,
+                         static_cast<uint32_t>(job.wait_semaphores.size() ),
+                         (job.wait_semaphores.size() > 0)   ? &job.wait_semaphores[0]   : nullptr,
+                         (job.wait_stage_masks.size() > 0)  ? &job.wait_stage_masks[0]  : nullptr);
+
+        batch_n_queue                       = job.n_queue;
+        batch_needs_fence                  |= (last_job_ids[job.n_queue] == n_job);
+        frame_slot.job_queue_indices[n_job] = job.n_queue;
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Returns a primary command buffer, allocated from the current frame slot's command pool for the specified
+ *  queue family type. Command buffers are reused once the frame slot is reused.
+ *
+ *  @param in_family_type Queue family type the command buffer is going to be submitted to.
+ *
+ *  @return Command buffer instance if successful, nullptr otherwise.
+ **/
+std::shared_ptr<Anvil::PrimaryCommandBuffer> Anvil::AsyncComputeScheduler::get_cmd_buffer(Anvil::QueueFamilyType in_family_type)
+{
+    FrameSlot&                                   frame_slot(m_frame_slots[m_n_current_frame_slot]);
+    uint32_t&                                    n_used    (frame_slot.n_used_cmd_buffers[in_family_type]);
+    std::shared_ptr<Anvil::PrimaryCommandBuffer> result_ptr;
+
+    if (n_used < frame_slot.cmd_buffers[in_family_type].size() )
+    {
+        result_ptr = frame_slot.cmd_buffers[in_family_type][n_used];
+    }
+    else
+    {
+        result_ptr = frame_slot.command_pools[in_family_type]->alloc_primary_level_command_buffer();
+
+        if (result_ptr == nullptr)
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        frame_slot.cmd_buffers[in_family_type].push_back(result_ptr);
+    }
+
+    ++n_used;
+end:
+    return result_ptr;
+}
+
+/** Returns a semaphore, owned by the current frame slot. Semaphores are reused once the frame slot is reused.
+ *
+ *  @return Semaphore instance if successful, nullptr otherwise.
+ **/
+std::shared_ptr<Anvil::Semaphore> Anvil::AsyncComputeScheduler::get_semaphore()
+{
+    FrameSlot&                        frame_slot(m_frame_slots[m_n_current_frame_slot]);
+    std::shared_ptr<Anvil::Semaphore> result_ptr;
+
+    if (frame_slot.n_used_semaphores < frame_slot.semaphores.size() )
+    {
+        result_ptr = frame_slot.semaphores[frame_slot.n_used_semaphores];
+    }
+    else
+    {
+        result_ptr = Anvil::Semaphore::create(m_device_ptr);
+
+        if (result_ptr == nullptr)
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        frame_slot.semaphores.push_back(result_ptr);
+    }
+
+    ++frame_slot.n_used_semaphores;
+end:
+    return result_ptr;
+}
+
+/** Gathers the queues jobs can be assigned to and creates resources of all frame slots.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::AsyncComputeScheduler::init()
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    const Anvil::QueueFamilyInfoItems& queue_families   (device_locked_ptr->get_physical_device_queue_families() );
+    const uint32_t                     n_compute_queues (device_locked_ptr->get_n_compute_queues() );
+    bool                               result           (false);
+    bool                               uses_timestamps  (false);
+
+    m_queues.resize(1 + n_compute_queues);
+
+    for (uint32_t n_queue = 0;
+                  n_queue < static_cast<uint32_t>(m_queues.size() );
+                ++n_queue)
+    {
+        QueueInfo& queue_info = m_queues[n_queue];
+
+        if (n_queue == 0)
+        {
+            queue_info.family_type = Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL;
+            queue_info.queue_ptr   = device_locked_ptr->get_universal_queue(0);
+        }
+        else
+        {
+            queue_info.family_type = Anvil::QUEUE_FAMILY_TYPE_COMPUTE;
+            queue_info.queue_ptr   = device_locked_ptr->get_compute_queue(n_queue - 1);
+        }
+
+        if (queue_info.queue_ptr == nullptr)
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        queue_info.supports_timestamps = (queue_families[queue_info.queue_ptr->get_queue_family_index()].n_timestamp_bits > 0);
+        uses_timestamps               |= queue_info.supports_timestamps;
+    }
+
+    m_timestamp_period_ns = static_cast<double>(device_locked_ptr->get_physical_device_properties().limits.timestampPeriod);
+
+    if (m_n_max_jobs_per_frame == 0)
+    {
+        uses_timestamps = false;
+    }
+
+    /* is_job_measured() relies on this */
+    if (!uses_timestamps)
+    {
+        for (auto queue_iterator  = m_queues.begin();
+                  queue_iterator != m_queues.end();
+                ++queue_iterator)
+        {
+            queue_iterator->supports_timestamps = false;
+        }
+    }
+
+    m_frame_slots.resize(m_n_frames_in_flight);
+
+    for (auto frame_slot_iterator  = m_frame_slots.begin();
+              frame_slot_iterator != m_frame_slots.end();
+            ++frame_slot_iterator)
+    {
+        for (auto queue_iterator  = m_queues.begin();
+                  queue_iterator != m_queues.end();
+                ++queue_iterator)
+        {
+            std::shared_ptr<Anvil::CommandPool>& command_pool_ptr = frame_slot_iterator->command_pools[queue_iterator->family_type];
+
+            if (command_pool_ptr != nullptr)
+            {
+                continue;
+            }
+
+            command_pool_ptr = Anvil::CommandPool::create(m_device_ptr,
+                                                          true,  /* transient_allocations_friendly */
+                                                          false, /* support_per_cmdbuf_reset_ops   */
+                                                          queue_iterator->family_type);
+
+            if (command_pool_ptr == nullptr)
+            {
+                anvil_assert(false);
+
+                goto end;
+            }
+        }
+
+        if (uses_timestamps)
+        {
+            frame_slot_iterator->query_pool_ptr = Anvil::QueryPool::create_non_ps_query_pool(m_device_ptr,
+                                                                                             VK_QUERY_TYPE_TIMESTAMP,
+                                                                                             m_n_max_jobs_per_frame * 2);
+
+            if (frame_slot_iterator->query_pool_ptr == nullptr)
+            {
+                anvil_assert(false);
+
+                goto end;
+            }
+        }
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Tells whether the specified job is surrounded by timestamp queries.
+ *
+ *  @param in_job_id  ID of the job.
+ *  @param in_n_queue Index of the queue the job has been assigned to.
+ *
+ *  @return As per description.
+ **/
+bool Anvil::AsyncComputeScheduler::is_job_measured(AsyncComputeJobID in_job_id,
+                                                   uint32_t          in_n_queue) const
+{
+    return (in_job_id < m_n_max_jobs_per_frame &&
+            m_queues[in_n_queue].supports_timestamps);
+}
+
+/** Updates the tracked state of a resource with a new access, adding dependencies, ownership transfer
+ *  barriers and layout transitions to the involved jobs as necessary.
+ *
+ *  @param in_job_id              ID of the job performing the access.
+ *  @param in_access              Access to process.
+ *  @param in_resource_states_ptr Tracked resource states. Must not be nullptr.
+ **/
+void Anvil::AsyncComputeScheduler::process_resource_access(AsyncComputeJobID                     in_job_id,
+                                                           const ResourceAccess&                 in_access,
+                                                           std::map<const void*, ResourceState>* in_resource_states_ptr)
+{
+    Job&              job                      = m_jobs[in_job_id];
+    const uint32_t    queue_family_index       = m_queues[job.n_queue].queue_ptr->get_queue_family_index();
+    const void*       resource_raw_ptr         = (in_access.buffer_ptr != nullptr) ? static_cast<const void*>(in_access.buffer_ptr.get() )
+                                                                                   : static_cast<const void*>(in_access.image_ptr.get() );
+    auto              state_iterator           = in_resource_states_ptr->find(resource_raw_ptr);
+    bool              is_write                 = false;
+    bool              needs_layout_transition  = false;
+    bool              needs_ownership_transfer = false;
+
+    if (state_iterator == in_resource_states_ptr->end() )
+    {
+        ResourceState new_state;
+
+        new_state.first_access             = in_access;
+        new_state.first_n_queue            = job.n_queue;
+        new_state.first_queue_family_index = queue_family_index;
+        new_state.is_exclusive             = (in_access.buffer_ptr != nullptr) ? (in_access.buffer_ptr->get_sharing_mode()      == VK_SHARING_MODE_EXCLUSIVE)
+                                                                               : (in_access.image_ptr->get_image_sharing_mode() == VK_SHARING_MODE_EXCLUSIVE);
+        new_state.last_access_job_id       = UINT32_MAX;
+        new_state.last_access_mask         = 0;
+        new_state.last_stage_mask          = 0;
+        new_state.last_writer_job_id       = UINT32_MAX;
+        new_state.layout                   = in_access.layout;
+        new_state.owner_queue_family_index = queue_family_index;
+
+        state_iterator = in_resource_states_ptr->insert(std::make_pair(resource_raw_ptr,
+                                                                       new_state) ).first;
+    }
+
+    ResourceState& state = state_iterator->second;
+
+    needs_layout_transition  = (in_access.image_ptr != nullptr && state.layout != in_access.layout);
+    needs_ownership_transfer = (state.is_exclusive && state.owner_queue_family_index != queue_family_index);
+    is_write                 = (job.is_ownership_return_job                     ||
+                                needs_layout_transition                         ||
+                                (in_access.access_mask & g_write_access_mask) != 0);
+
+    /* Dependencies on earlier accesses */
+    if (is_write || needs_ownership_transfer)
+    {
+        for (auto reader_iterator  = state.reader_job_ids.begin();
+                  reader_iterator != state.reader_job_ids.end();
+                ++reader_iterator)
+        {
+            if (*reader_iterator != in_job_id)
+            {
+                add_dependency(in_job_id,
+                               *reader_iterator,
+                               in_access.stage_mask);
+            }
+        }
+    }
+
+    if (state.last_writer_job_id != UINT32_MAX &&
+        state.last_writer_job_id != in_job_id)
+    {
+        add_dependency(in_job_id,
+                       state.last_writer_job_id,
+                       in_access.stage_mask);
+    }
+
+    /* The release half of the transfer goes after the last job which accessed the resource on the owning
+     * family. Since the dependent job waits on that job, the acquire half is guaranteed to execute after it. */
+    if (needs_ownership_transfer)
+    {
+        Job& releasing_job = m_jobs[state.last_access_job_id];
+
+        if (in_access.buffer_ptr != nullptr)
+        {
+            releasing_job.release_buffer_barriers.push_back(
+                Anvil::BufferBarrier(state.last_access_mask,
+                                     0, /* in_destination_access_mask */
+                                     state.owner_queue_family_index,
+                                     queue_family_index,
+                                     in_access.buffer_ptr,
+                                     in_access.buffer_ptr->get_start_offset(),
+                                     in_access.buffer_ptr->get_size() )
+            );
+
+            job.acquire_buffer_barriers.push_back(
+                Anvil::BufferBarrier(0, /* in_source_access_mask */
+                                     in_access.access_mask,
+                                     state.owner_queue_family_index,
+                                     queue_family_index,
+                                     in_access.buffer_ptr,
+                                     in_access.buffer_ptr->get_start_offset(),
+                                     in_access.buffer_ptr->get_size() )
+            );
+        }
+        else
+        {
+            /* The layout is not changed by the transfer itself. If necessary, the new layout is set by
+             * a separate transition, recorded after the acquire barrier. */
+            releasing_job.release_image_barriers.push_back(
+                Anvil::ImageBarrier(state.last_access_mask,
+                                    0,     /* in_destination_access_mask */
+                                    false, /* in_by_region_barrier       */
+                                    state.layout,
+                                    state.layout,
+                                    state.owner_queue_family_index,
+                                    queue_family_index,
+                                    in_access.image_ptr,
+                                    in_access.subresource_range)
+            );
+
+            job.acquire_image_barriers.push_back(
+                Anvil::ImageBarrier(0,     /* in_source_access_mask */
+                                    in_access.access_mask,
+                                    false, /* in_by_region_barrier  */
+                                    state.layout,
+                                    state.layout,
+                                    state.owner_queue_family_index,
+                                    queue_family_index,
+                                    in_access.image_ptr,
+                                    in_access.subresource_range)
+            );
+        }
+
+        releasing_job.release_stage_mask |= state.last_stage_mask;
+        job.acquire_stage_mask           |= in_access.stage_mask;
+    }
+
+    if (needs_layout_transition)
+    {
+        job.layout_transition_barriers.push_back(
+            Anvil::ImageBarrier(0, /* in_source_access_mask */
+                                in_access.access_mask,
+                                false, /* in_by_region_barrier */
+                                state.layout,
+                                in_access.layout,
+                                VK_QUEUE_FAMILY_IGNORED,
+                                VK_QUEUE_FAMILY_IGNORED,
+                                in_access.image_ptr,
+                                in_access.subresource_range)
+        );
+
+        job.layout_transition_stage_mask |= in_access.stage_mask;
+    }
+
+    /* Update the state */
+    if (is_write)
+    {
+        state.last_writer_job_id = in_job_id;
+
+        state.reader_job_ids.clear();
+    }
+    else
+    if (state.reader_job_ids.size() == 0      ||
+        state.reader_job_ids.back()  != in_job_id)
+    {
+        state.reader_job_ids.push_back(in_job_id);
+    }
+
+    if (state.last_access_job_id == in_job_id)
+    {
+        state.last_access_mask |= in_access.access_mask;
+        state.last_stage_mask  |= in_access.stage_mask;
+    }
+    else
+    {
+        state.last_access_job_id = in_job_id;
+        state.last_access_mask   = in_access.access_mask;
+        state.last_stage_mask    = in_access.stage_mask;
+    }
+
+    state.layout                   = in_access.layout;
+    state.owner_queue_family_index = queue_family_index;
+}
+
+/** Records a command buffer, which is submitted right after the job's command buffers. The command buffer
+ *  holds release barriers of ownership transfers and the job's end timestamp.
+ *
+ *  @param in_job_id          ID of the job.
+ *  @param out_cmd_buffer_ptr Deref will be set to the recorded command buffer, or to nullptr if the job does
+ *                            not need one. Must not be nullptr.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::AsyncComputeScheduler::record_epilogue(AsyncComputeJobID                          in_job_id,
+                                                   std::shared_ptr<Anvil::CommandBufferBase>* out_cmd_buffer_ptr)
+{
+    std::shared_ptr<Anvil::PrimaryCommandBuffer> cmd_buffer_ptr;
+    const Job&                                   job         = m_jobs[in_job_id];
+    const bool                                   is_measured = is_job_measured(in_job_id,
+                                                                               job.n_queue);
+    bool                                         result      = false;
+
+    out_cmd_buffer_ptr->reset();
+
+    if (!is_measured                            &&
+         job.release_buffer_barriers.size() == 0 &&
+         job.release_image_barriers.size()  == 0)
+    {
+        result = true;
+
+        goto end;
+    }
+
+    cmd_buffer_ptr = get_cmd_buffer(m_queues[job.n_queue].family_type);
+
+    if (cmd_buffer_ptr == nullptr)
+    {
+        goto end;
+    }
+
+    cmd_buffer_ptr->start_recording(true,   /* one_time_submit          */
+                                    false); /* simultaneous_use_allowed */
+    {
+        if (job.release_buffer_barriers.size() > 0 ||
+            job.release_image_barriers.size()  > 0)
+        {
+            cmd_buffer_ptr->record_pipeline_barrier(job.release_stage_mask,
+                                                    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                                    VK_FALSE, /* in_by_region */
+                                                    0,        /* in_memory_barrier_count */
+                                                    nullptr,  /* in_memory_barriers_ptr  */
+                                                    static_cast<uint32_t>(job.release_buffer_barriers.size() ),
+                                                    (job.release_buffer_barriers.size() > 0) ? &job.release_buffer_barriers[0] : nullptr,
+                                                    static_cast<uint32_t>(job.release_image_barriers.size() ),
+                                                    (job.release_image_barriers.size()  > 0) ? &job.release_image_barriers[0]  : nullptr);
+        }
+
+        if (is_measured)
+        {
+            cmd_buffer_ptr->record_write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                                   m_frame_slots[m_n_current_frame_slot].query_pool_ptr,
+                                                   in_job_id * 2 + 1);
+        }
+    }
+    cmd_buffer_ptr->stop_recording();
+
+    *out_cmd_buffer_ptr = cmd_buffer_ptr;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Records a command buffer, which is submitted right before the job's command buffers. The command buffer
+ *  holds the job's start timestamp, the memory barrier synchronizing the job with its dependencies on the
+ *  same queue, acquire barriers of ownership transfers and layout transitions.
+ *
+ *  @param in_job_id          ID of the job.
+ *  @param out_cmd_buffer_ptr Deref will be set to the recorded command buffer, or to nullptr if the job does
+ *                            not need one. Must not be nullptr.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::AsyncComputeScheduler::record_prologue(AsyncComputeJobID                          in_job_id,
+                                                   std::shared_ptr<Anvil::CommandBufferBase>* out_cmd_buffer_ptr)
+{
+    std::shared_ptr<Anvil::PrimaryCommandBuffer> cmd_buffer_ptr;
+    const Job&                                   job                  = m_jobs[in_job_id];
+    const bool                                   has_acquire_barriers = (job.acquire_buffer_barriers.size() > 0 ||
+                                                                         job.acquire_image_barriers.size()  > 0);
+    const bool                                   is_measured          = is_job_measured(in_job_id,
+                                                                                        job.n_queue);
+    bool                                         result               = false;
+
+    out_cmd_buffer_ptr->reset();
+
+    if (!is_measured                               &&
+        !has_acquire_barriers                      &&
+         job.layout_transition_barriers.size() == 0 &&
+         job.same_queue_wait_stage_mask        == 0)
+    {
+        result = true;
+
+        goto end;
+    }
+
+    cmd_buffer_ptr = get_cmd_buffer(m_queues[job.n_queue].family_type);
+
+    if (cmd_buffer_ptr == nullptr)
+    {
+        goto end;
+    }
+
+    cmd_buffer_ptr->start_recording(true,   /* one_time_submit          */
+                                    false); /* simultaneous_use_allowed */
+    {
+        if (is_measured)
+        {
+            std::shared_ptr<Anvil::QueryPool> query_pool_ptr = m_frame_slots[m_n_current_frame_slot].query_pool_ptr;
+
+            cmd_buffer_ptr->record_reset_query_pool(query_pool_ptr,
+                                                    in_job_id * 2,
+                                                    2); /* in_query_count */
+            cmd_buffer_ptr->record_write_timestamp (VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                                    query_pool_ptr,
+                                                    in_job_id * 2);
+        }
+
+        if (has_acquire_barriers                ||
+            job.same_queue_wait_stage_mask != 0)
+        {
+            const Anvil::MemoryBarrier memory_barrier(VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, /* in_destination_access_mask */
+                                                      VK_ACCESS_MEMORY_WRITE_BIT);                            /* in_source_access_mask      */
+            const uint32_t             n_memory_barriers = (job.same_queue_wait_stage_mask != 0) ? 1 : 0;
+
+            /* Stages of the dependencies executed on the same queue are unknown, hence ALL_COMMANDS */
+            cmd_buffer_ptr->record_pipeline_barrier((n_memory_barriers > 0) ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT
+                                                                            : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                                    job.acquire_stage_mask | job.same_queue_wait_stage_mask,
+                                                    VK_FALSE, /* in_by_region */
+                                                    n_memory_barriers,
+                                                   &memory_barrier,
+                                                    static_cast<uint32_t>(job.acquire_buffer_barriers.size() ),
+                                                    (job.acquire_buffer_barriers.size() > 0) ? &job.acquire_buffer_barriers[0] : nullptr,
+                                                    static_cast<uint32_t>(job.acquire_image_barriers.size() ),
+                                                    (job.acquire_image_barriers.size()  > 0) ? &job.acquire_image_barriers[0]  : nullptr);
+        }
+
+        /* Layout transitions are recorded separately, so that they execute after the acquire barriers.
+         * Their source stages equal the stages the job's semaphore waits and the barrier above block, which
+         * chains the transitions after all of the job's dependencies. */
+        if (job.layout_transition_barriers.size() > 0)
+        {
+            cmd_buffer_ptr->record_pipeline_barrier(job.layout_transition_stage_mask,
+                                                    job.layout_transition_stage_mask,
+                                                    VK_FALSE, /* in_by_region */
+                                                    0,        /* in_memory_barrier_count */
+                                                    nullptr,  /* in_memory_barriers_ptr  */
+                                                    0,        /* in_buffer_memory_barrier_count */
+                                                    nullptr,  /* in_buffer_memory_barriers_ptr  */
+                                                    static_cast<uint32_t>(job.layout_transition_barriers.size() ),
+                                                   &job.layout_transition_barriers[0]);
+        }
+    }
+    cmd_buffer_ptr->stop_recording();
+
+    *out_cmd_buffer_ptr = cmd_buffer_ptr;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Reads back the timestamps written by the frame which last used the specified frame slot, and updates
+ *  per-queue statistics. Must only be called once the frame has finished executing.
+ *
+ *  @param in_frame_slot_ptr Frame slot to process. Must not be nullptr.
+ **/
+void Anvil::AsyncComputeScheduler::resolve_frame(FrameSlot* in_frame_slot_ptr)
+{
+    std::vector<std::vector<std::pair<uint64_t, uint64_t> > > intervals(m_queues.size() );
+    const double                                              ns_to_ms = 1.0 / 1000000.0;
+
+    for (auto queue_iterator  = m_queues.begin();
+              queue_iterator != m_queues.end();
+            ++queue_iterator)
+    {
+        queue_iterator->busy_time_ms = 0.0;
+        queue_iterator->n_jobs       = 0;
+    }
+
+    for (AsyncComputeJobID n_job = 0;
+                           n_job < static_cast<AsyncComputeJobID>(in_frame_slot_ptr->job_queue_indices.size() );
+                         ++n_job)
+    {
+        const uint32_t n_queue = in_frame_slot_ptr->job_queue_indices[n_job];
+        uint64_t       query_results[4]; /* begin, begin availability, end, end availability */
+
+        ++m_queues[n_queue].n_jobs;
+
+        if (!is_job_measured(n_job,
+                             n_queue) )
+        {
+            continue;
+        }
+
+        if (!in_frame_slot_ptr->query_pool_ptr->get_results(n_job * 2,
+                                                            2, /* in_n_queries */
+                                                            VK_QUERY_RESULT_WITH_AVAILABILITY_BIT,
+                                                            sizeof(query_results) / sizeof(query_results[0]),
+                                                            query_results) ||
+            query_results[1] == 0                                       ||
+            query_results[3] == 0                                       ||
+            query_results[2]  < query_results[0])
+        {
+            continue;
+        }
+
+        intervals[n_queue].push_back(std::make_pair(query_results[0],
+                                                    query_results[2]) );
+    }
+
+    /* Jobs submitted to the same queue may overlap, so the busy time is the length of the union of
+     * their execution intervals */
+    for (uint32_t n_queue = 0;
+                  n_queue < static_cast<uint32_t>(m_queues.size() );
+                ++n_queue)
+    {
+        std::vector<std::pair<uint64_t, uint64_t> >& queue_intervals = intervals[n_queue];
+        uint64_t                                     busy_ticks      = 0;
+        uint64_t                                     current_end     = 0;
+
+        std::sort(queue_intervals.begin(),
+                  queue_intervals.end() );
+
+        for (auto interval_iterator  = queue_intervals.begin();
+                  interval_iterator != queue_intervals.end();
+                ++interval_iterator)
+        {
+            const uint64_t start = std::max(interval_iterator->first,
+                                            current_end);
+
+            if (interval_iterator->second > start)
+            {
+                busy_ticks += interval_iterator->second - start;
+            }
+
+            current_end = std::max(current_end,
+                                   interval_iterator->second);
+        }
+
+        m_queues[n_queue].busy_time_ms = static_cast<double>(busy_ticks) * m_timestamp_period_ns * ns_to_ms;
+    }
+
+    in_frame_slot_ptr->job_queue_indices.clear();
+}
+
+/** Blocks until the frame, which has last used the specified frame slot, finishes executing, and reads
+ *  back its per-queue statistics. Returns immediately if the slot has not been submitted since.
+ *
+ *  @param in_frame_slot_ptr Frame slot to wait on. Must not be nullptr.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::AsyncComputeScheduler::wait_for_frame(FrameSlot* in_frame_slot_ptr)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    std::vector<VkFence>               fences_vk;
+    bool                               result           (true);
+    VkResult                           result_vk;
+
+    if (in_frame_slot_ptr->fences.size() > 0)
+    {
+        for (auto fence_iterator  = in_frame_slot_ptr->fences.begin();
+                  fence_iterator != in_frame_slot_ptr->fences.end();
+                ++fence_iterator)
+        {
+            fences_vk.push_back(*(*fence_iterator)->get_fence_ptr() );
+        }
+
+        result_vk = vkWaitForFences(device_locked_ptr->get_device_vk(),
+                                    static_cast<uint32_t>(fences_vk.size() ),
+                                   &fences_vk[0],
+                                    VK_TRUE,     /* waitAll */
+                                    UINT64_MAX); /* timeout */
+
+        anvil_assert_vk_call_succeeded(result_vk);
+
+        result = is_vk_call_successful(result_vk);
+
+        if (!result)
+        {
+            goto end;
+        }
+
+        /* Hand the fences back to the device's fence pool */
+        in_frame_slot_ptr->fences.clear();
+    }
+
+    if (in_frame_slot_ptr->job_queue_indices.size() > 0)
+    {
+        resolve_frame(in_frame_slot_ptr);
+    }
+
+end:
+    return result;
+}
@@ -22,19 +22,30 @@
 
 #include "misc/base_pipeline_manager.h"
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
+#include "misc/fence_pool.h"
 #include "wrappers/descriptor_set_group.h"
 #include "wrappers/device.h"
+#include "wrappers/fence.h"
 #include "wrappers/pipeline_layout.h"
 #include "wrappers/pipeline_layout_manager.h"
 #include "wrappers/pipeline_cache.h"
+#include "wrappers/queue.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 /** Please see header for specification */
 Anvil::BasePipelineManager::BasePipelineManager(std::weak_ptr<Anvil::BaseDevice>      device_ptr,
                                                 bool                                  use_pipeline_cache,
                                                 std::shared_ptr<Anvil::PipelineCache> pipeline_cache_to_reuse_ptr)
-    :m_device_ptr      (device_ptr),
-     m_pipeline_counter(0)
+    :m_bake_workers_terminating     (false),
+     m_device_ptr                   (device_ptr),
+     m_is_retiring_pipeline_variants(false),
+     m_max_n_pipeline_variants      (256),
+     m_n_bake_worker_threads        (0),
+     m_pipeline_counter             (0)
 {
     anvil_assert(!use_pipeline_cache && pipeline_cache_to_reuse_ptr == nullptr ||
                  use_pipeline_cache);
@@ -63,7 +74,25 @@ Anvil::BasePipelineManager::~BasePipelineManager()
 {
     anvil_assert(m_pipelines.size() == 0);
 
+    release_retired_pipelines(true); /* in_should_wait */
+
    m_pipeline_layout_manager_ptr.reset();
+
+    /* Stop the bake worker threads, if any have been spawned */
+    {
+        std::unique_lock<std::mutex> lock(m_bake_workers_mutex);
+
+        anvil_assert(m_bake_worker_jobs.size() == 0);
+
+        m_bake_workers_terminating = true;
+    }
+
+    m_bake_worker_jobs_cv.notify_all();
+
+    for (auto& current_thread : m_bake_worker_threads)
+    {
+        current_thread.join();
+    }
 }
 
 
@@ -73,18 +102,38 @@ Anvil::BasePipelineManager::~BasePipelineManager()
  *s*/
 void Anvil::BasePipelineManager::Pipeline::release_vulkan_objects()
 {
+    if (shared_baked_pipeline_ptr != nullptr)
+    {
+        /* The pipeline object is released once the last pipeline referring to it drops its reference */
+        anvil_assert(shared_baked_pipeline_ptr->pipeline == baked_pipeline);
+
+        baked_pipeline = VK_NULL_HANDLE;
+
+        shared_baked_pipeline_ptr.reset();
+    }
+    else
     if (baked_pipeline != VK_NULL_HANDLE)
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(device_ptr);
 
-        vkDestroyPipeline(device_locked_ptr->get_device_vk(),
-                          baked_pipeline,
-                          nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_PIPELINE,
+                                              baked_pipeline);
 
         baked_pipeline = VK_NULL_HANDLE;
     }
 }
 
+/** Please see header for specification */
+Anvil::BasePipelineManager::SharedVkPipeline::~SharedVkPipeline()
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(device_ptr);
+
+    Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                          Anvil::OBJECT_TYPE_PIPELINE,
+                                          pipeline);
+}
+
 /* Please see header for specification */
 bool Anvil::BasePipelineManager::add_derivative_pipeline_from_sibling_pipeline(bool                               disable_optimizations,
                                                                                bool                               allow_derivatives,
@@ -93,21 +142,23 @@ bool Anvil::BasePipelineManager::add_derivative_pipeline_from_sibling_pipeline(b
                                                                                PipelineID                         base_pipeline_id,
                                                                                PipelineID*                        out_pipeline_id_ptr)
 {
+    auto                      base_pipeline_iterator = m_pipelines.find(base_pipeline_id);
     std::shared_ptr<Pipeline> base_pipeline_ptr;
-    PipelineID                new_pipeline_id  = 0;
+    PipelineID                new_pipeline_id        = 0;
     std::shared_ptr<Pipeline> new_pipeline_ptr;
-    bool                      result           = false;
+    bool                      result                 = false;
 
-    /* Retrieve base pipeline's descriptor */
-    if (m_pipelines.size() <= base_pipeline_id)
+    /* Retrieve base pipeline's descriptor. Pipeline IDs are not contiguous once pipelines start being deleted,
+     * so the ID must be looked up rather than compared against the number of pipelines. */
+    if (base_pipeline_iterator == m_pipelines.end() )
     {
-        anvil_assert(!(m_pipelines.size() <= base_pipeline_id) );
+        anvil_assert(!(base_pipeline_iterator == m_pipelines.end()) );
 
         goto end;
     }
     else
     {
-        base_pipeline_ptr = m_pipelines[base_pipeline_id];
+        base_pipeline_ptr = base_pipeline_iterator->second;
 
         anvil_assert(base_pipeline_ptr != nullptr);
     }
@@ -128,6 +179,8 @@ bool Anvil::BasePipelineManager::add_derivative_pipeline_from_sibling_pipeline(b
     m_pipelines[new_pipeline_id] = new_pipeline_ptr;
     *out_pipeline_id_ptr         = new_pipeline_id;
 
+    m_dirty_pipeline_ids.insert(new_pipeline_id);
+
     /* All done */
     result  = true;
 end:
@@ -165,6 +218,62 @@ bool Anvil::BasePipelineManager::add_derivative_pipeline_from_pipeline(bool
     *out_pipeline_id_ptr         = new_pipeline_id;
     m_pipelines[new_pipeline_id] = new_pipeline_ptr;
 
+    m_dirty_pipeline_ids.insert(new_pipeline_id);
+
+    /* All done */
+    result = true;
+end:
+    return result;
+}
+
+/* Please see header for specification */
+bool Anvil::BasePipelineManager::add_pipeline_variant(PipelineID  base_pipeline_id,
+                                                      PipelineID* out_pipeline_id_ptr)
+{
+    auto                      base_pipeline_iterator = m_pipelines.find(base_pipeline_id);
+    std::shared_ptr<Pipeline> base_pipeline_ptr;
+    std::shared_ptr<Pipeline> variant_pipeline_ptr;
+    bool                      result                 = false;
+
+    if (base_pipeline_iterator == m_pipelines.end() )
+    {
+        anvil_assert(!(base_pipeline_iterator == m_pipelines.end()) );
+
+        goto end;
+    }
+    else
+    {
+        base_pipeline_ptr = base_pipeline_iterator->second;
+    }
+
+    if (base_pipeline_ptr->is_proxy            ||
+       !base_pipeline_ptr->allow_derivatives)
+    {
+        anvil_assert(!base_pipeline_ptr->is_proxy          &&
+                      base_pipeline_ptr->allow_derivatives);
+
+        goto end;
+    }
+
+    if (!add_derivative_pipeline_from_sibling_pipeline(base_pipeline_ptr->disable_optimizations,
+                                                       false, /* allow_derivatives */
+                                                       static_cast<uint32_t>(base_pipeline_ptr->shader_stages.size() ),
+                                                      &base_pipeline_ptr->shader_stages[0],
+                                                       base_pipeline_id,
+                                                       out_pipeline_id_ptr) )
+    {
+        goto end;
+    }
+
+    /* Start off with the base pipeline's state. The layout is going to be re-created from the copied DSG
+     * and push constant ranges at baking time. */
+    variant_pipeline_ptr = m_pipelines[*out_pipeline_id_ptr];
+
+    variant_pipeline_ptr->dsg_ptr                             = base_pipeline_ptr->dsg_ptr;
+    variant_pipeline_ptr->push_constant_ranges                = base_pipeline_ptr->push_constant_ranges;
+    variant_pipeline_ptr->specialization_constant_data_buffer = base_pipeline_ptr->specialization_constant_data_buffer;
+    variant_pipeline_ptr->specialization_constants_map        = base_pipeline_ptr->specialization_constants_map;
+
     /* All done */
     result = true;
 end:
@@ -215,6 +324,8 @@ bool Anvil::BasePipelineManager::add_regular_pipeline(bool
     *out_pipeline_id_ptr         = new_pipeline_id;
     m_pipelines[new_pipeline_id] = new_pipeline_ptr;
 
+    m_dirty_pipeline_ids.insert(new_pipeline_id);
+
     /* All done */
     return true;
 }
@@ -226,9 +337,10 @@ bool Anvil::BasePipelineManager::add_specialization_constant_to_pipeline(Pipelin
                                                                          uint32_t    n_data_bytes,
                                                                          void*       data_ptr)
 {
+    auto                      pipeline_iterator = m_pipelines.find(pipeline_id);
     std::shared_ptr<Pipeline> pipeline_ptr;
-    uint32_t                  data_buffer_size = 0;
-    bool                      result           = false;
+    uint32_t                  data_buffer_size  = 0;
+    bool                      result            = false;
 
     if (n_data_bytes == 0)
     {
@@ -245,15 +357,15 @@ bool Anvil::BasePipelineManager::add_specialization_constant_to_pipeline(Pipelin
     }
 
     /* Retrieve the pipeline's descriptor */
-    if (pipeline_id >= m_pipelines.size() )
+    if (pipeline_iterator == m_pipelines.end() )
     {
-        anvil_assert(!(pipeline_id >= m_pipelines.size()) );
+        anvil_assert(!(pipeline_iterator == m_pipelines.end()) );
 
         goto end;
     }
     else
     {
-        pipeline_ptr = m_pipelines[pipeline_id];
+        pipeline_ptr = pipeline_iterator->second;
     }
 
     if (pipeline_ptr->is_proxy)
@@ -273,13 +385,15 @@ bool Anvil::BasePipelineManager::add_specialization_constant_to_pipeline(Pipelin
                                                                                               n_data_bytes,
                                                                                               data_buffer_size));
 
-    pipeline_ptr->specialization_constant_data_buffer.reserve(data_buffer_size + n_data_bytes);
+    pipeline_ptr->specialization_constant_data_buffer.resize(data_buffer_size + n_data_bytes);
 
 
     memcpy(&pipeline_ptr->specialization_constant_data_buffer[data_buffer_size],
            data_ptr,
            n_data_bytes);
 
+    mark_pipeline_dirty(pipeline_id);
+
     /* All done */
     result = true;
 end:
@@ -321,10 +435,11 @@ bool Anvil::BasePipelineManager::set_pipeline_dsg(PipelineID
     }
 
     /* If we reached this place, we can update the DSG */
-    pipeline_ptr->dirty        = true;
     pipeline_ptr->dsg_ptr      = dsg_ptr;
     pipeline_ptr->layout_dirty = true;
 
+    mark_pipeline_dirty(pipeline_id);
+
     /* All done */
     result = true;
 end:
@@ -359,9 +474,10 @@ bool Anvil::BasePipelineManager::attach_push_constant_range_to_pipeline(Pipeline
         goto end;
     }
 
-    pipeline_ptr->dirty        = true;
     pipeline_ptr->layout_dirty = true;
 
+    mark_pipeline_dirty(pipeline_id);
+
     pipeline_ptr->push_constant_ranges.push_back(Anvil::PushConstantRange(offset,
                                                                            size,
                                                                            stages) );
@@ -411,18 +527,282 @@ void Anvil::BasePipelineManager::bake_specialization_info_vk(const Specializatio
                                                                                   : nullptr;
 }
 
+/** Entry-point of bake worker threads. Runs jobs pushed with push_bake_worker_job(), and helps threads which
+ *  have called create_pipelines_in_parallel() process their waves, until the manager is destroyed.
+ **/
+void Anvil::BasePipelineManager::bake_worker_thread_entrypoint()
+{
+    std::unique_lock<std::mutex> lock(m_bake_workers_mutex);
+
+    while (true)
+    {
+        BakeWorkerJob* job_ptr;
+        BakeWave*      wave_ptr;
+
+        m_bake_worker_jobs_cv.wait(lock,
+                                   [this]()
+                                   {
+                                       return m_bake_workers_terminating       ||
+                                              m_bake_worker_jobs.size() > 0;
+                                   });
+
+        if (m_bake_worker_jobs.size() == 0)
+        {
+            /* The manager is being destroyed */
+            break;
+        }
+
+        job_ptr  = m_bake_worker_jobs.front().job_ptr;
+        wave_ptr = m_bake_worker_jobs.front().wave_ptr;
+
+        m_bake_worker_jobs.pop_front();
+
+        lock.unlock();
+        {
+            if (wave_ptr != nullptr)
+            {
+                process_bake_wave(wave_ptr);
+            }
+            else
+            {
+                job_ptr->pfn_job_proc(job_ptr->user_arg);
+            }
+        }
+        lock.lock();
+
+        if (wave_ptr != nullptr)
+        {
+            if (--wave_ptr->n_busy_workers == 0)
+            {
+                m_bake_worker_job_done_cv.notify_all();
+            }
+        }
+        else
+        {
+            job_ptr->is_complete = true;
+
+            m_bake_worker_job_done_cv.notify_all();
+        }
+    }
+}
+
+/* Please see header for specification */
+bool Anvil::BasePipelineManager::create_pipelines_in_parallel(uint32_t              n_threads,
+                                                              uint32_t              n_items,
+                                                              const int32_t*        base_item_indices,
+                                                              PFNCREATEPIPELINEPROC pfn_create_pipeline_proc,
+                                                              void*                 user_arg,
+                                                              VkPipeline*           out_pipelines_ptr,
+                                                              double*               out_bake_times_ms_ptr)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    std::vector<bool>                  is_item_baked    (n_items,
+                                                         false);
+    uint32_t                           n_items_baked    (0);
+    bool                               result           (false);
+    BakeWave                           wave;
+
+    anvil_assert(n_threads > 0);
+
+    for (uint32_t n_item = 0;
+                  n_item < n_items;
+                ++n_item)
+    {
+        anvil_assert(base_item_indices[n_item] < static_cast<int32_t>(n_items) );
+
+        out_bake_times_ms_ptr[n_item] = -1.0;
+        out_pipelines_ptr    [n_item] = VK_NULL_HANDLE;
+    }
+
+    wave.base_item_indices        = base_item_indices;
+    wave.out_bake_times_ms_ptr    = out_bake_times_ms_ptr;
+    wave.out_pipelines_ptr        = out_pipelines_ptr;
+    wave.pfn_create_pipeline_proc = pfn_create_pipeline_proc;
+    wave.user_arg                 = user_arg;
+
+    start_bake_worker_threads(n_threads - 1);
+
+    while (n_items_baked < n_items)
+    {
+        uint32_t n_helper_workers;
+
+        /* Gather all items whose base pipelines, if any, are already available */
+        wave.wave_items.clear();
+
+        for (uint32_t n_item = 0;
+                      n_item < n_items;
+                    ++n_item)
+        {
+            const int32_t n_base_item = base_item_indices[n_item];
+
+            if (!is_item_baked[n_item]                       &&
+                (n_base_item < 0 || is_item_baked[n_base_item]) )
+            {
+                wave.wave_items.push_back(n_item);
+            }
+        }
+
+        if (wave.wave_items.size() == 0)
+        {
+            /* Circular base pipeline dependency */
+            anvil_assert(wave.wave_items.size() != 0);
+
+            goto end;
+        }
+
+        wave.n_next_wave_item = 0;
+        n_helper_workers      = std::min(n_threads,
+                                         static_cast<uint32_t>(wave.wave_items.size() )) - 1;
+
+        /* Hand the wave over to the worker threads, and join in. Base pipelines have been baked in one of
+         * the preceding waves, which all workers have finished processing before this wave was started.
+         * Waves are put in front of other jobs, since the calling thread is blocked until they finish. */
+        if (n_helper_workers > 0)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_bake_workers_mutex);
+
+                wave.n_busy_workers = n_helper_workers;
+
+                for (uint32_t n_helper_worker = 0;
+                              n_helper_worker < n_helper_workers;
+                            ++n_helper_worker)
+                {
+                    m_bake_worker_jobs.push_front(BakeWorkerQueueItem(nullptr, /* in_job_ptr */
+                                                                      &wave) );
+                }
+            }
+
+            m_bake_worker_jobs_cv.notify_all();
+        }
+
+        process_bake_wave(&wave);
+
+        /* All items have been picked up by now. Workers, which have not joined in yet, may be busy with other
+         * jobs, so withdraw their share of the wave rather than wait for them. */
+        {
+            std::unique_lock<std::mutex> lock(m_bake_workers_mutex);
+
+            for (auto job_iterator  = m_bake_worker_jobs.begin();
+                      job_iterator != m_bake_worker_jobs.end();
+                     )
+            {
+                if (job_iterator->wave_ptr == &wave)
+                {
+                    job_iterator = m_bake_worker_jobs.erase(job_iterator);
+
+                    --wave.n_busy_workers;
+                }
+                else
+                {
+                    ++job_iterator;
+                }
+            }
+
+            m_bake_worker_job_done_cv.wait(lock,
+                                     [&wave]()
+                                     {
+                                         return wave.n_busy_workers == 0;
+                                     });
+        }
+
+        if (wave.has_failed)
+        {
+            goto end;
+        }
+
+        for (auto n_item : wave.wave_items)
+        {
+            is_item_baked[n_item] = true;
+        }
+
+        n_items_baked += static_cast<uint32_t>(wave.wave_items.size() );
+    }
+
+    /* All done */
+    result = true;
+end:
+    if (!result)
+    {
+        for (uint32_t n_item = 0;
+                      n_item < n_items;
+                    ++n_item)
+        {
+            if (out_pipelines_ptr[n_item] != VK_NULL_HANDLE)
+            {
+                vkDestroyPipeline(device_locked_ptr->get_device_vk(),
+                                  out_pipelines_ptr[n_item],
+                                  nullptr /* pAllocator */);
+
+                out_pipelines_ptr[n_item] = VK_NULL_HANDLE;
+            }
+        }
+    }
+
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::BasePipelineManager::delete_pipeline(PipelineID pipeline_id)
 {
-    auto pipeline_iterator = m_pipelines.find(pipeline_id);
-    bool result = false;
+    auto                    pipeline_iterator = m_pipelines.find(pipeline_id);
+    bool                    result            = false;
+    std::vector<PipelineID> variant_pipeline_ids_to_delete;
 
     if (pipeline_iterator == m_pipelines.end() )
     {
         goto end;
     }
 
-    m_pipelines.erase(pipeline_iterator);
+    if (m_is_retiring_pipeline_variants)
+    {
+        /* Keep the pipeline alive until GPU-side work, which may use it, completes. Please see
+         * evict_pipeline_variants() for more details. */
+        m_retiring_pipeline_ptrs.push_back(pipeline_iterator->second);
+    }
+
+    m_dirty_pipeline_ids.erase(pipeline_id);
+    m_pipelines.erase         (pipeline_iterator);
+
+    /* Drop the pipeline's variant cache entry, if it is a variant, as well as entries of any variants
+     * derived from it. The latter are then deleted. */
+    for (auto variant_iterator  = m_pipeline_variants.begin();
+              variant_iterator != m_pipeline_variants.end();
+             )
+    {
+        if (variant_iterator->pipeline_id      != pipeline_id &&
+            variant_iterator->base_pipeline_id != pipeline_id)
+        {
+            ++variant_iterator;
+
+            continue;
+        }
+
+        auto& hash_bucket = m_pipeline_variants_by_hash[variant_iterator->key_hash];
+
+        hash_bucket.erase(std::find(hash_bucket.begin(),
+                                    hash_bucket.end(),
+                                    variant_iterator) );
+
+        if (hash_bucket.size() == 0)
+        {
+            m_pipeline_variants_by_hash.erase(variant_iterator->key_hash);
+        }
+
+        if (variant_iterator->base_pipeline_id == pipeline_id)
+        {
+            variant_pipeline_ids_to_delete.push_back(variant_iterator->pipeline_id);
+        }
+
+        variant_iterator = m_pipeline_variants.erase(variant_iterator);
+    }
+
+    for (auto variant_pipeline_id_iterator  = variant_pipeline_ids_to_delete.begin();
+              variant_pipeline_id_iterator != variant_pipeline_ids_to_delete.end();
+            ++variant_pipeline_id_iterator)
+    {
+        delete_pipeline(*variant_pipeline_id_iterator);
+    }
 
     /* All done */
     result = true;
@@ -430,6 +810,96 @@ end:
     return result;
 }
 
+/** Deletes least recently used pipeline variants, until no more than m_max_n_pipeline_variants are cached.
+ *  delete_pipeline() takes care of removing the cache entries.
+ *
+ *  Variants may still be used by command buffers in flight, so their Vulkan pipeline objects must not be
+ *  released right away. If the device's deferred deletion queue is enabled, delete_pipeline() hands them
+ *  over to it. Otherwise, the evicted pipelines are retired: they are kept alive until fences, submitted to
+ *  all queues which have been used so far, are signalled. Retired pipelines whose fences have been
+ *  signalled in the meantime are released first.
+ **/
+void Anvil::BasePipelineManager::evict_pipeline_variants()
+{
+    std::shared_ptr<Anvil::BaseDevice>            device_locked_ptr(m_device_ptr);
+    Anvil::QueueSubmitBatch                       empty_batch;
+    std::shared_ptr<Anvil::DeferredDeletionQueue> queue_ptr        (device_locked_ptr->get_deferred_deletion_queue() );
+    RetiredPipelineVariants                       retired_variants;
+    const bool                                    should_retire    (queue_ptr == nullptr || !queue_ptr->is_enabled() );
+
+    release_retired_pipelines(false); /* in_should_wait */
+
+    if (m_pipeline_variants.size() <= m_max_n_pipeline_variants)
+    {
+        goto end;
+    }
+
+    m_is_retiring_pipeline_variants = should_retire;
+    {
+        while (m_pipeline_variants.size() > m_max_n_pipeline_variants)
+        {
+            delete_pipeline(m_pipeline_variants.back().pipeline_id);
+        }
+    }
+    m_is_retiring_pipeline_variants = false;
+
+    if (!should_retire)
+    {
+        goto end;
+    }
+
+    /* A fence is signalled once all work submitted to its queue beforehand finishes executing. Sparse binding
+     * queues are not enumerated, since they are also exposed as queues of one of the families below. */
+    for (Anvil::QueueFamilyType queue_family_type  = Anvil::QUEUE_FAMILY_TYPE_FIRST;
+                                queue_family_type <  Anvil::QUEUE_FAMILY_TYPE_COUNT;
+                                queue_family_type  = static_cast<Anvil::QueueFamilyType>(queue_family_type + 1))
+    {
+        const uint32_t n_queues = device_locked_ptr->get_n_queues(queue_family_type);
+
+        for (uint32_t n_queue = 0;
+                      n_queue < n_queues;
+                    ++n_queue)
+        {
+            std::shared_ptr<Anvil::Queue> current_queue_ptr;
+
+            switch (queue_family_type)
+            {
+                case Anvil::QUEUE_FAMILY_TYPE_COMPUTE:   current_queue_ptr = device_locked_ptr->get_compute_queue  (n_queue); break;
+                case Anvil::QUEUE_FAMILY_TYPE_TRANSFER:  current_queue_ptr = device_locked_ptr->get_transfer_queue (n_queue); break;
+                case Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL: current_queue_ptr = device_locked_ptr->get_universal_queue(n_queue); break;
+
+                default:
+                {
+                    anvil_assert(false);
+                }
+            }
+
+            if (current_queue_ptr                      == nullptr ||
+                current_queue_ptr->get_n_submissions() == 0)
+            {
+                continue;
+            }
+
+            retired_variants.fence_ptrs.push_back(device_locked_ptr->get_fence_pool()->get_fence() );
+
+            current_queue_ptr->submit_batch(&empty_batch,
+                                            false, /* should_block */
+                                            retired_variants.fence_ptrs.back() );
+
+            /* The fence is going to be polled from this thread, so it must have been handed over to Vulkan
+             * by the time this function leaves. */
+            current_queue_ptr->flush_submissions();
+        }
+    }
+
+    retired_variants.pipeline_ptrs.swap(m_retiring_pipeline_ptrs);
+
+    m_retired_pipeline_variants.push_back(retired_variants);
+
+end:
+    ;
+}
+
 /* Please see header for specification */
 bool Anvil::BasePipelineManager::get_general_pipeline_properties(PipelineID pipeline_id,
                                                                  bool*      out_opt_has_optimizations_disabled_ptr,
@@ -502,6 +972,33 @@ end:
     return result;
 }
 
+/* Please see header for specification */
+bool Anvil::BasePipelineManager::get_pipeline_bake_time(PipelineID pipeline_id,
+                                                        double*    out_bake_time_ms_ptr) const
+{
+    auto pipeline_iterator = m_pipelines.find(pipeline_id);
+    bool result            = false;
+
+    if (pipeline_iterator == m_pipelines.end() )
+    {
+        anvil_assert(!(pipeline_iterator == m_pipelines.end()) );
+
+        goto end;
+    }
+
+    if (pipeline_iterator->second->bake_time_ms < 0.0)
+    {
+        goto end;
+    }
+
+    *out_bake_time_ms_ptr = pipeline_iterator->second->bake_time_ms;
+
+    /* All done */
+    result = true;
+end:
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::BasePipelineManager::get_pipeline_id_at_index(uint32_t    n_pipeline,
                                                           PipelineID* out_pipeline_id_ptr) const
@@ -573,6 +1070,181 @@ end:
     return result_ptr;
 }
 
+/* Please see header for specification */
+bool Anvil::BasePipelineManager::get_pipeline_variant(PipelineID                         base_pipeline_id,
+                                                      uint32_t                           n_values,
+                                                      const SpecializationConstantValue* value_ptrs,
+                                                      PipelineID*                        out_variant_pipeline_id_ptr)
+{
+    PipelineVariantsByHash::iterator hash_bucket_iterator;
+    PipelineVariantKey               key;
+    uint64_t                         key_hash            = 14695981039346656037ull; /* FNV-1a offset basis */
+    bool                             result              = false;
+    PipelineID                       variant_pipeline_id = 0;
+    std::shared_ptr<Pipeline>        variant_pipeline_ptr;
+
+    if (n_values   >  0       &&
+        value_ptrs == nullptr)
+    {
+        anvil_assert(!(n_values > 0 && value_ptrs == nullptr) );
+
+        goto end;
+    }
+
+    /* Serialize the base pipeline ID & all values into a key, and hash it. */
+    key.insert(key.end(),
+               reinterpret_cast<const unsigned char*>(&base_pipeline_id),
+               reinterpret_cast<const unsigned char*>(&base_pipeline_id) + sizeof(base_pipeline_id) );
+
+    for (uint32_t n_value = 0;
+                  n_value < n_values;
+                ++n_value)
+    {
+        const SpecializationConstantValue& current_value = value_ptrs[n_value];
+        const uint32_t                     value_header[] =
+        {
+            static_cast<uint32_t>(current_value.shader_stage),
+            current_value.constant_id,
+            current_value.n_data_bytes
+        };
+
+        if (current_value.n_data_bytes == 0       ||
+            current_value.data_ptr     == nullptr)
+        {
+            anvil_assert(!(current_value.n_data_bytes == 0 || current_value.data_ptr == nullptr) );
+
+            goto end;
+        }
+
+        key.insert(key.end(),
+                   reinterpret_cast<const unsigned char*>(value_header),
+                   reinterpret_cast<const unsigned char*>(value_header) + sizeof(value_header) );
+        key.insert(key.end(),
+                   static_cast<const unsigned char*>(current_value.data_ptr),
+                   static_cast<const unsigned char*>(current_value.data_ptr) + current_value.n_data_bytes);
+    }
+
+    for (auto key_iterator  = key.begin();
+              key_iterator != key.end();
+            ++key_iterator)
+    {
+        key_hash ^= *key_iterator;
+        key_hash *= 1099511628211ull; /* FNV-1a prime */
+    }
+
+    /* Has the variant already been created? */
+    hash_bucket_iterator = m_pipeline_variants_by_hash.find(key_hash);
+
+    if (hash_bucket_iterator != m_pipeline_variants_by_hash.end() )
+    {
+        for (auto variant_iterator_iterator  = hash_bucket_iterator->second.begin();
+                  variant_iterator_iterator != hash_bucket_iterator->second.end();
+                ++variant_iterator_iterator)
+        {
+            if ((*variant_iterator_iterator)->key == key)
+            {
+                /* Mark the variant as the most recently used one. This does not invalidate list iterators. */
+                m_pipeline_variants.splice(m_pipeline_variants.begin(),
+                                           m_pipeline_variants,
+                                          *variant_iterator_iterator);
+
+                *out_variant_pipeline_id_ptr = (*variant_iterator_iterator)->pipeline_id;
+                result                       = true;
+
+                goto end;
+            }
+        }
+    }
+
+    /* Nope, create a new one and assign the values. */
+    if (!add_pipeline_variant(base_pipeline_id,
+                             &variant_pipeline_id) )
+    {
+        goto end;
+    }
+
+    variant_pipeline_ptr = m_pipelines[variant_pipeline_id];
+
+    for (uint32_t n_value = 0;
+                  n_value < n_values;
+                ++n_value)
+    {
+        ShaderIndex                                       shader_index        = 0;
+        const SpecializationConstantValue&                current_value       = value_ptrs[n_value];
+        ShaderIndexToSpecializationConstantsMap::iterator constants_iterator;
+        bool                                              constant_overridden = false;
+
+        /* Shader indices correspond to positions of the shader stages specified at creation time */
+        while (shader_index                                       <  variant_pipeline_ptr->shader_stages.size() &&
+               variant_pipeline_ptr->shader_stages[shader_index].stage != current_value.shader_stage)
+        {
+            ++shader_index;
+        }
+
+        constants_iterator = variant_pipeline_ptr->specialization_constants_map.find(shader_index);
+
+        if (constants_iterator == variant_pipeline_ptr->specialization_constants_map.end() )
+        {
+            anvil_assert(!(constants_iterator == variant_pipeline_ptr->specialization_constants_map.end()) );
+
+            delete_pipeline(variant_pipeline_id);
+            goto end;
+        }
+
+        for (auto constant_iterator  = constants_iterator->second.begin();
+                  constant_iterator != constants_iterator->second.end();
+                ++constant_iterator)
+        {
+            if (constant_iterator->constant_id != current_value.constant_id)
+            {
+                continue;
+            }
+
+            if (constant_iterator->n_bytes != current_value.n_data_bytes)
+            {
+                anvil_assert(constant_iterator->n_bytes == current_value.n_data_bytes);
+
+                delete_pipeline(variant_pipeline_id);
+                goto end;
+            }
+
+            memcpy(&variant_pipeline_ptr->specialization_constant_data_buffer[constant_iterator->start_offset],
+                    current_value.data_ptr,
+                    current_value.n_data_bytes);
+
+            constant_overridden = true;
+            break;
+        }
+
+        if (!constant_overridden)
+        {
+            if (!add_specialization_constant_to_pipeline(variant_pipeline_id,
+                                                         shader_index,
+                                                         current_value.constant_id,
+                                                         current_value.n_data_bytes,
+                                                         const_cast<void*>(current_value.data_ptr) ))
+            {
+                delete_pipeline(variant_pipeline_id);
+                goto end;
+            }
+        }
+    }
+
+    m_pipeline_variants.push_front(PipelineVariant(base_pipeline_id,
+                                                   key,
+                                                   key_hash,
+                                                   variant_pipeline_id) );
+
+    m_pipeline_variants_by_hash[key_hash].push_back(m_pipeline_variants.begin() );
+
+    evict_pipeline_variants();
+
+    *out_variant_pipeline_id_ptr = variant_pipeline_id;
+    result                       = true;
+end:
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::BasePipelineManager::get_shader_stage_properties(PipelineID                   pipeline_id,
                                                              Anvil::ShaderStage           shader_stage,
@@ -608,6 +1280,133 @@ end:
     return result;
 }
 
+/* Please see header for specification */
+void Anvil::BasePipelineManager::mark_pipeline_dirty(PipelineID pipeline_id)
+{
+    auto pipeline_iterator = m_pipelines.find(pipeline_id);
+
+    if (pipeline_iterator == m_pipelines.end() )
+    {
+        anvil_assert(!(pipeline_iterator == m_pipelines.end()) );
+
+        goto end;
+    }
+
+    pipeline_iterator->second->dirty = true;
+
+    m_dirty_pipeline_ids.insert(pipeline_id);
+end:
+    ;
+}
+
+/** Creates pipeline objects for items of the specified wave, until all of them have been picked up by
+ *  one of the threads processing the wave, or until creation of any of the pipelines fails.
+ *
+ *  Called by the thread which issued the create_pipelines_in_parallel() call, and by bake worker threads.
+ *
+ *  @param in_wave_ptr Wave to process. Must not be nullptr.
+ **/
+void Anvil::BasePipelineManager::process_bake_wave(BakeWave* in_wave_ptr)
+{
+    const uint32_t n_wave_items = static_cast<uint32_t>(in_wave_ptr->wave_items.size() );
+    uint32_t       n_wave_item;
+
+    /* Each item is created with a separate call, so that we can tell how long it took the driver to compile
+     * each pipeline. */
+    while (!in_wave_ptr->has_failed                                                  &&
+           (n_wave_item = in_wave_ptr->n_next_wave_item.fetch_add(1) ) < n_wave_items)
+    {
+        const uint32_t n_item      = in_wave_ptr->wave_items[n_wave_item];
+        const int32_t  n_base_item = in_wave_ptr->base_item_indices[n_item];
+        const auto     start_time  = std::chrono::steady_clock::now();
+        VkResult       result_vk;
+
+        result_vk = in_wave_ptr->pfn_create_pipeline_proc(in_wave_ptr->user_arg,
+                                                          n_item,
+                                                          (n_base_item >= 0) ? in_wave_ptr->out_pipelines_ptr[n_base_item]
+                                                                             : VK_NULL_HANDLE,
+                                                          in_wave_ptr->out_pipelines_ptr + n_item);
+
+        in_wave_ptr->out_bake_times_ms_ptr[n_item] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+        if (!is_vk_call_successful(result_vk) )
+        {
+            anvil_assert_vk_call_succeeded(result_vk);
+
+            in_wave_ptr->out_pipelines_ptr[n_item] = VK_NULL_HANDLE;
+            in_wave_ptr->has_failed                = true;
+        }
+    }
+}
+
+/** Releases pipeline variants retired by evict_pipeline_variants(), whose fences have all been signalled.
+ *  Retired variants are released in the order they were retired in.
+ *
+ *  @param in_should_wait true to wait until all retired variants can be released, false to only release
+ *                        those which can be released right away.
+ **/
+void Anvil::BasePipelineManager::release_retired_pipelines(bool in_should_wait)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+
+    while (m_retired_pipeline_variants.size() > 0)
+    {
+        RetiredPipelineVariants& retired_variants = m_retired_pipeline_variants.front();
+        bool                     is_complete      = true;
+
+        for (auto fence_iterator  = retired_variants.fence_ptrs.cbegin();
+                  fence_iterator != retired_variants.fence_ptrs.cend();
+                ++fence_iterator)
+        {
+            if (in_should_wait)
+            {
+                const VkResult result_vk = vkWaitForFences(device_locked_ptr->get_device_vk(),
+                                                           1, /* fenceCount */
+                                                           (*fence_iterator)->get_fence_ptr(),
+                                                           VK_TRUE,     /* waitAll */
+                                                           UINT64_MAX); /* timeout */
+
+                anvil_assert_vk_call_succeeded(result_vk);
+                ANVIL_REDUNDANT_VARIABLE_CONST(result_vk);
+            }
+            else
+            if (!(*fence_iterator)->is_set() )
+            {
+                is_complete = false;
+
+                break;
+            }
+        }
+
+        if (!is_complete)
+        {
+            break;
+        }
+
+        m_retired_pipeline_variants.pop_front();
+    }
+}
+
+/* Please see header for specification */
+void Anvil::BasePipelineManager::push_bake_worker_job(BakeWorkerJob* in_job_ptr)
+{
+    anvil_assert(in_job_ptr->pfn_job_proc != nullptr);
+
+    in_job_ptr->is_complete = false;
+
+    start_bake_worker_threads(std::max(m_n_bake_worker_threads,
+                                       2u) - 1);
+
+    {
+        std::unique_lock<std::mutex> lock(m_bake_workers_mutex);
+
+        m_bake_worker_jobs.push_back(BakeWorkerQueueItem(in_job_ptr,
+                                                         nullptr) ); /* in_wave_ptr */
+    }
+
+    m_bake_worker_jobs_cv.notify_one();
+}
+
 /* Please see header for specification */
 bool Anvil::BasePipelineManager::set_pipeline_bakeability(PipelineID pipeline_id,
                                                           bool       bakeable)
@@ -632,3 +1431,41 @@ bool Anvil::BasePipelineManager::set_pipeline_bakeability(PipelineID pipeline_id
 end:
     return result;
 }
+
+/* Please see header for specification */
+void Anvil::BasePipelineManager::set_max_n_pipeline_variants(uint32_t n_max_variants)
+{
+    anvil_assert(n_max_variants >= 1);
+
+    m_max_n_pipeline_variants = n_max_variants;
+
+    evict_pipeline_variants();
+}
+
+/** Makes sure at least @param in_n_threads bake worker threads are running. Threads are never stopped before
+ *  the manager is destroyed, so that subsequent bake() calls do not pay for spawning them again.
+ *
+ *  @param in_n_threads Minimum number of worker threads to keep alive.
+ **/
+void Anvil::BasePipelineManager::start_bake_worker_threads(uint32_t in_n_threads)
+{
+    std::unique_lock<std::mutex> lock(m_bake_workers_mutex);
+
+    while (static_cast<uint32_t>(m_bake_worker_threads.size() ) < in_n_threads)
+    {
+        m_bake_worker_threads.push_back(std::thread(&Anvil::BasePipelineManager::bake_worker_thread_entrypoint,
+                                                    this) );
+    }
+}
+
+/* Please see header for specification */
+void Anvil::BasePipelineManager::wait_for_bake_worker_job(BakeWorkerJob* in_job_ptr)
+{
+    std::unique_lock<std::mutex> lock(m_bake_workers_mutex);
+
+    m_bake_worker_job_done_cv.wait(lock,
+                                   [in_job_ptr]()
+                                   {
+                                       return in_job_ptr->is_complete.load();
+                                   });
+}
@@ -0,0 +1,1874 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "misc/dag_renderer.h"
+#include "misc/debug.h"
+#include "misc/formats.h"
+#include "misc/memory_allocator.h"
+#include "wrappers/buffer.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/device.h"
+#include "wrappers/framebuffer.h"
+#include "wrappers/image.h"
+#include "wrappers/image_view.h"
+#include "wrappers/memory_block.h"
+#include "wrappers/render_pass.h"
+#include <algorithm>
+#include <cstring>
+
+
+/** Tells what buffer or image usage flags a resource needs to be created with, so that it can
+ *  be accessed with @param in_usage.
+ *
+ *  @param in_usage            Resource usage to use for the query.
+ *  @param in_is_image         true if the query is made for an image, false if it's made for a buffer.
+ *  @param out_usage_flags_ptr Deref will be OR-ed with VkImageUsageFlagBits or VkBufferUsageFlagBits
+ *                             values. Must not be nullptr.
+ *
+ *  @return true if @param in_usage is valid for the resource type, false otherwise.
+ **/
+static bool get_usage_flags_for_resource_usage(Anvil::ResourceUsage in_usage,
+                                               bool                 in_is_image,
+                                               VkFlags*             out_usage_flags_ptr)
+{
+    bool    result      = true;
+    VkFlags usage_flags = 0;
+
+    switch (in_usage)
+    {
+        case Anvil::RESOURCE_USAGE_COLOR_ATTACHMENT:
+        {
+            result      = in_is_image;
+            usage_flags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_DEPTH_STENCIL_ATTACHMENT:
+        {
+            result      = in_is_image;
+            usage_flags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_DEPTH_STENCIL_READ_ONLY:
+        {
+            result      = in_is_image;
+            usage_flags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_INPUT_ATTACHMENT:
+        {
+            result      = in_is_image;
+            usage_flags = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_PRESENT:
+        {
+            result = in_is_image;
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_COMPUTE_SHADER_READ:
+        case Anvil::RESOURCE_USAGE_FRAGMENT_SHADER_READ:
+        case Anvil::RESOURCE_USAGE_VERTEX_SHADER_READ:
+        {
+            usage_flags = (in_is_image) ? static_cast<VkFlags>(VK_IMAGE_USAGE_SAMPLED_BIT)
+                                        : static_cast<VkFlags>(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT);
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_COMPUTE_SHADER_STORAGE:
+        case Anvil::RESOURCE_USAGE_FRAGMENT_SHADER_STORAGE:
+        {
+            usage_flags = (in_is_image) ? static_cast<VkFlags>(VK_IMAGE_USAGE_STORAGE_BIT)
+                                        : static_cast<VkFlags>(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT);
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_HOST_READ:
+        {
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_TRANSFER_DST:
+        {
+            usage_flags = (in_is_image) ? static_cast<VkFlags>(VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+                                        : static_cast<VkFlags>(VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_TRANSFER_SRC:
+        {
+            usage_flags = (in_is_image) ? static_cast<VkFlags>(VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+                                        : static_cast<VkFlags>(VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_INDEX_BUFFER:
+        {
+            result      = !in_is_image;
+            usage_flags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_INDIRECT_BUFFER:
+        {
+            result      = !in_is_image;
+            usage_flags = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_UNIFORM_BUFFER:
+        {
+            result      = !in_is_image;
+            usage_flags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
+            break;
+        }
+
+        case Anvil::RESOURCE_USAGE_VERTEX_BUFFER:
+        {
+            result      = !in_is_image;
+            usage_flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+
+            break;
+        }
+
+        default:
+        {
+            anvil_assert(false);
+
+            result = false;
+        }
+    }
+
+    if (result)
+    {
+        *out_usage_flags_ptr |= usage_flags;
+    }
+
+    return result;
+}
+
+/** Tells whether @param in_format exposes a depth and/or a stencil aspect. */
+static bool is_depth_stencil_format(VkFormat in_format)
+{
+    std::vector<VkImageAspectFlags> aspects;
+    bool                            result = false;
+
+    Anvil::Formats::get_format_aspects(in_format,
+                                      &aspects);
+
+    for (const auto& current_aspect : aspects)
+    {
+        if ((current_aspect & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) != 0)
+        {
+            result = true;
+
+            break;
+        }
+    }
+
+    return result;
+}
+
+
+/** Constructor. Please see create() for specification */
+Anvil::DAGRenderer::DAGRenderer(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
+                                std::shared_ptr<Anvil::Swapchain> in_swapchain_ptr)
+    :m_device_ptr   (in_device_ptr),
+     m_is_baked     (false),
+     m_swapchain_ptr(in_swapchain_ptr)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::DAGRenderer::~DAGRenderer()
+{
+    /* Stub */
+}
+
+/** Declares an access of a pass to a resource.
+ *
+ *  @param in_pass_id     ID of the pass to update.
+ *  @param in_resource_id ID of the resource.
+ *  @param in_is_image    true if the resource is expected to be an image, false if it is expected to be a buffer.
+ *  @param in_usage       Usage of the resource.
+ *  @param in_access_type Type of the access.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::DAGRenderer::add_access(DAGRendererPassID     in_pass_id,
+                                    DAGRendererResourceID in_resource_id,
+                                    bool                  in_is_image,
+                                    Anvil::ResourceUsage  in_usage,
+                                    AccessType            in_access_type)
+{
+    bool    result      = false;
+    VkFlags usage_flags = 0;
+
+    if (m_is_baked)
+    {
+        anvil_assert(!m_is_baked);
+
+        goto end;
+    }
+
+    if (in_pass_id     >= m_passes.size()    ||
+        in_resource_id >= m_resources.size() )
+    {
+        anvil_assert(in_pass_id     < m_passes.size()    &&
+                     in_resource_id < m_resources.size() );
+
+        goto end;
+    }
+
+    if (m_resources[in_resource_id].is_image != in_is_image)
+    {
+        anvil_assert(m_resources[in_resource_id].is_image == in_is_image);
+
+        goto end;
+    }
+
+    if (!get_usage_flags_for_resource_usage(in_usage,
+                                            in_is_image,
+                                           &usage_flags) )
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    if (in_access_type == ACCESS_TYPE_INPUT                                             &&
+        Anvil::Utils::get_resource_state_for_resource_usage(in_usage).has_write_access() )
+    {
+        /* Inputs must not be written to */
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    for (const auto& current_access : m_passes[in_pass_id].accesses)
+    {
+        if (current_access.resource_id == in_resource_id)
+        {
+            /* A pass can only access a given resource in a single way */
+            anvil_assert(current_access.resource_id != in_resource_id);
+
+            goto end;
+        }
+    }
+
+    m_passes[in_pass_id].accesses.push_back(Access(in_resource_id,
+                                                   in_usage,
+                                                   in_access_type) );
+
+    result = true;
+end:
+    return result;
+}
+
+/** Adds a render pass attachment to a graphics pass.
+ *
+ *  @param in_pass_id          ID of a graphics pass to update.
+ *  @param in_resource_id      ID of an image resource.
+ *  @param in_usage            Usage of the attachment.
+ *  @param opt_clear_value_ptr Clear value to use for the attachment. May be nullptr.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::DAGRenderer::add_attachment(DAGRendererPassID     in_pass_id,
+                                        DAGRendererResourceID in_resource_id,
+                                        Anvil::ResourceUsage  in_usage,
+                                        const VkClearValue*   opt_clear_value_ptr)
+{
+    Attachment new_attachment;
+    bool       result = false;
+
+    if (m_is_baked)
+    {
+        anvil_assert(!m_is_baked);
+
+        goto end;
+    }
+
+    if (in_pass_id     >= m_passes.size()    ||
+        in_resource_id >= m_resources.size() )
+    {
+        anvil_assert(in_pass_id     < m_passes.size()    &&
+                     in_resource_id < m_resources.size() );
+
+        goto end;
+    }
+
+    if (m_passes[in_pass_id].type != PASS_TYPE_GRAPHICS)
+    {
+        anvil_assert(m_passes[in_pass_id].type == PASS_TYPE_GRAPHICS);
+
+        goto end;
+    }
+
+    if (!m_resources[in_resource_id].is_image                          ||
+         m_resources[in_resource_id].image_format == VK_FORMAT_UNDEFINED)
+    {
+        /* Attachment properties need to be known at bake time */
+        anvil_assert(m_resources[in_resource_id].is_image                           &&
+                     m_resources[in_resource_id].image_format != VK_FORMAT_UNDEFINED);
+
+        goto end;
+    }
+
+    new_attachment.has_clear_value = (opt_clear_value_ptr != nullptr);
+    new_attachment.resource_id     = in_resource_id;
+    new_attachment.usage           = in_usage;
+
+    if (opt_clear_value_ptr != nullptr)
+    {
+        new_attachment.clear_value = *opt_clear_value_ptr;
+    }
+    else
+    {
+        memset(&new_attachment.clear_value,
+               0,
+               sizeof(new_attachment.clear_value) );
+    }
+
+    m_passes[in_pass_id].attachments.push_back(new_attachment);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_compute_pass(PFNDAGRENDERERPASSPROC in_pfn_record_proc,
+                                          void*                  in_user_arg,
+                                          DAGRendererPassID*     out_pass_id_ptr)
+{
+    bool result = false;
+
+    if (m_is_baked                   ||
+        in_pfn_record_proc == nullptr)
+    {
+        anvil_assert(!m_is_baked                   &&
+                      in_pfn_record_proc != nullptr);
+
+        goto end;
+    }
+
+    *out_pass_id_ptr = static_cast<DAGRendererPassID>(m_passes.size() );
+
+    m_passes.push_back(Pass(PASS_TYPE_COMPUTE,
+                            in_pfn_record_proc,
+                            in_user_arg) );
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_graphics_pass(const ShaderModuleStageEntryPoint& in_fragment_shader_entrypoint,
+                                           const ShaderModuleStageEntryPoint& in_geometry_shader_entrypoint,
+                                           const ShaderModuleStageEntryPoint& in_tess_control_shader_entrypoint,
+                                           const ShaderModuleStageEntryPoint& in_tess_evaluation_shader_entrypoint,
+                                           const ShaderModuleStageEntryPoint& in_vertex_shader_entrypoint,
+                                           PFNDAGRENDERERPASSPROC             in_pfn_record_proc,
+                                           void*                              in_user_arg,
+                                           DAGRendererPassID*                 out_pass_id_ptr)
+{
+    bool result = false;
+
+    if (m_is_baked                   ||
+        in_pfn_record_proc == nullptr)
+    {
+        anvil_assert(!m_is_baked                   &&
+                      in_pfn_record_proc != nullptr);
+
+        goto end;
+    }
+
+    *out_pass_id_ptr = static_cast<DAGRendererPassID>(m_passes.size() );
+
+    m_passes.push_back(Pass(PASS_TYPE_GRAPHICS,
+                            in_pfn_record_proc,
+                            in_user_arg) );
+
+    m_passes.back().fragment_shader_entrypoint        = in_fragment_shader_entrypoint;
+    m_passes.back().geometry_shader_entrypoint        = in_geometry_shader_entrypoint;
+    m_passes.back().tess_control_shader_entrypoint    = in_tess_control_shader_entrypoint;
+    m_passes.back().tess_evaluation_shader_entrypoint = in_tess_evaluation_shader_entrypoint;
+    m_passes.back().vertex_shader_entrypoint          = in_vertex_shader_entrypoint;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_pass_buffer_input(DAGRendererPassID     in_pass_id,
+                                               DAGRendererResourceID in_resource_id,
+                                               Anvil::ResourceUsage  in_usage)
+{
+    return add_access(in_pass_id,
+                      in_resource_id,
+                      false, /* in_is_image */
+                      in_usage,
+                      ACCESS_TYPE_INPUT);
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_pass_buffer_output(DAGRendererPassID     in_pass_id,
+                                                DAGRendererResourceID in_resource_id,
+                                                Anvil::ResourceUsage  in_usage)
+{
+    return add_access(in_pass_id,
+                      in_resource_id,
+                      false, /* in_is_image */
+                      in_usage,
+                      ACCESS_TYPE_READ_WRITE);
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_pass_color_output(DAGRendererPassID        in_pass_id,
+                                               DAGRendererResourceID    in_resource_id,
+                                               const VkClearColorValue* opt_clear_value_ptr)
+{
+    VkClearValue clear_value;
+    bool         result = false;
+
+    if (opt_clear_value_ptr != nullptr)
+    {
+        clear_value.color = *opt_clear_value_ptr;
+    }
+
+    if (!add_attachment(in_pass_id,
+                        in_resource_id,
+                        Anvil::RESOURCE_USAGE_COLOR_ATTACHMENT,
+                        (opt_clear_value_ptr != nullptr) ? &clear_value : nullptr) )
+    {
+        goto end;
+    }
+
+    result = add_access(in_pass_id,
+                        in_resource_id,
+                        true, /* in_is_image */
+                        Anvil::RESOURCE_USAGE_COLOR_ATTACHMENT,
+                        (opt_clear_value_ptr != nullptr) ? ACCESS_TYPE_OVERWRITE
+                                                         : ACCESS_TYPE_READ_WRITE);
+
+    if (!result)
+    {
+        m_passes[in_pass_id].attachments.pop_back();
+    }
+
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_pass_depth_stencil_output(DAGRendererPassID               in_pass_id,
+                                                       DAGRendererResourceID           in_resource_id,
+                                                       const VkClearDepthStencilValue* opt_clear_value_ptr)
+{
+    VkClearValue clear_value;
+    bool         result = false;
+
+    if (in_pass_id >= m_passes.size() )
+    {
+        anvil_assert(in_pass_id < m_passes.size() );
+
+        goto end;
+    }
+
+    if (m_passes[in_pass_id].has_depth_stencil_attachment)
+    {
+        anvil_assert(!m_passes[in_pass_id].has_depth_stencil_attachment);
+
+        goto end;
+    }
+
+    if (opt_clear_value_ptr != nullptr)
+    {
+        clear_value.depthStencil = *opt_clear_value_ptr;
+    }
+
+    if (!add_attachment(in_pass_id,
+                        in_resource_id,
+                        Anvil::RESOURCE_USAGE_DEPTH_STENCIL_ATTACHMENT,
+                        (opt_clear_value_ptr != nullptr) ? &clear_value : nullptr) )
+    {
+        goto end;
+    }
+
+    result = add_access(in_pass_id,
+                        in_resource_id,
+                        true, /* in_is_image */
+                        Anvil::RESOURCE_USAGE_DEPTH_STENCIL_ATTACHMENT,
+                        (opt_clear_value_ptr != nullptr) ? ACCESS_TYPE_OVERWRITE
+                                                         : ACCESS_TYPE_READ_WRITE);
+
+    if (!result)
+    {
+        m_passes[in_pass_id].attachments.pop_back();
+    }
+    else
+    {
+        m_passes[in_pass_id].has_depth_stencil_attachment = true;
+    }
+
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_pass_image_input(DAGRendererPassID     in_pass_id,
+                                              DAGRendererResourceID in_resource_id,
+                                              Anvil::ResourceUsage  in_usage)
+{
+    bool result = false;
+
+    if (in_usage == Anvil::RESOURCE_USAGE_INPUT_ATTACHMENT)
+    {
+        if (!add_attachment(in_pass_id,
+                            in_resource_id,
+                            in_usage,
+                            nullptr) ) /* opt_clear_value_ptr */
+        {
+            goto end;
+        }
+    }
+
+    result = add_access(in_pass_id,
+                        in_resource_id,
+                        true, /* in_is_image */
+                        in_usage,
+                        ACCESS_TYPE_INPUT);
+
+    if (!result                                         &&
+         in_usage == Anvil::RESOURCE_USAGE_INPUT_ATTACHMENT)
+    {
+        m_passes[in_pass_id].attachments.pop_back();
+    }
+
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_pass_image_output(DAGRendererPassID     in_pass_id,
+                                               DAGRendererResourceID in_resource_id,
+                                               Anvil::ResourceUsage  in_usage)
+{
+    bool result = false;
+
+    if (in_usage == Anvil::RESOURCE_USAGE_COLOR_ATTACHMENT         ||
+        in_usage == Anvil::RESOURCE_USAGE_DEPTH_STENCIL_ATTACHMENT ||
+        in_usage == Anvil::RESOURCE_USAGE_INPUT_ATTACHMENT)
+    {
+        /* Attachments need to be declared with the dedicated functions */
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    result = add_access(in_pass_id,
+                        in_resource_id,
+                        true, /* in_is_image */
+                        in_usage,
+                        ACCESS_TYPE_READ_WRITE);
+
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_transfer_pass(PFNDAGRENDERERPASSPROC in_pfn_record_proc,
+                                           void*                  in_user_arg,
+                                           DAGRendererPassID*     out_pass_id_ptr)
+{
+    bool result = false;
+
+    if (m_is_baked                   ||
+        in_pfn_record_proc == nullptr)
+    {
+        anvil_assert(!m_is_baked                   &&
+                      in_pfn_record_proc != nullptr);
+
+        goto end;
+    }
+
+    *out_pass_id_ptr = static_cast<DAGRendererPassID>(m_passes.size() );
+
+    m_passes.push_back(Pass(PASS_TYPE_TRANSFER,
+                            in_pfn_record_proc,
+                            in_user_arg) );
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_transient_buffer(VkDeviceSize           in_size,
+                                              DAGRendererResourceID* out_resource_id_ptr)
+{
+    Resource new_resource;
+    bool     result = false;
+
+    if (m_is_baked  ||
+        in_size == 0)
+    {
+        anvil_assert(!m_is_baked  &&
+                      in_size != 0);
+
+        goto end;
+    }
+
+    new_resource.buffer_size  = in_size;
+    new_resource.is_image     = false;
+    new_resource.is_transient = true;
+
+    *out_resource_id_ptr = static_cast<DAGRendererResourceID>(m_resources.size() );
+
+    m_resources.push_back(new_resource);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::add_transient_image(VkFormat               in_format,
+                                             uint32_t               in_width,
+                                             uint32_t               in_height,
+                                             VkSampleCountFlagBits  in_sample_count,
+                                             DAGRendererResourceID* out_resource_id_ptr)
+{
+    Resource new_resource;
+    bool     result = false;
+
+    if (m_is_baked                      ||
+        in_format == VK_FORMAT_UNDEFINED ||
+        in_width  == 0                   ||
+        in_height == 0)
+    {
+        anvil_assert(!m_is_baked                      &&
+                      in_format != VK_FORMAT_UNDEFINED &&
+                      in_width  != 0                   &&
+                      in_height != 0);
+
+        goto end;
+    }
+
+    new_resource.image_format       = in_format;
+    new_resource.image_height       = in_height;
+    new_resource.image_sample_count = in_sample_count;
+    new_resource.image_width        = in_width;
+    new_resource.is_image           = true;
+    new_resource.is_transient       = true;
+
+    *out_resource_id_ptr = static_cast<DAGRendererResourceID>(m_resources.size() );
+
+    m_resources.push_back(new_resource);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::bake()
+{
+    const uint32_t n_resources = static_cast<uint32_t>(m_resources.size() );
+    bool           result      = false;
+    uint32_t       n_ordered_passes;
+
+    if (m_is_baked)
+    {
+        anvil_assert(!m_is_baked);
+
+        goto end;
+    }
+
+    cull_passes ();
+    order_passes();
+
+    n_ordered_passes = static_cast<uint32_t>(m_ordered_passes.size() );
+
+    /* Work out life-times of the resources. Outputs need to stay alive till the end of the frame, as they are
+     * transitioned to their final usages after all passes execute. */
+    for (uint32_t n_ordered_pass = 0;
+                  n_ordered_pass < n_ordered_passes;
+                ++n_ordered_pass)
+    {
+        for (const auto& current_access : m_passes[m_ordered_passes[n_ordered_pass] ].accesses)
+        {
+            Resource& resource = m_resources[current_access.resource_id];
+
+            if (resource.first_use == UINT32_MAX)
+            {
+                resource.first_use = n_ordered_pass;
+            }
+
+            resource.last_use = n_ordered_pass;
+        }
+    }
+
+    for (uint32_t n_resource = 0;
+                  n_resource < n_resources;
+                ++n_resource)
+    {
+        Resource& resource = m_resources[n_resource];
+
+        if (resource.first_use == UINT32_MAX)
+        {
+            continue;
+        }
+
+        for (const auto& current_access : m_passes[m_ordered_passes[resource.last_use] ].accesses)
+        {
+            if (current_access.resource_id == n_resource)
+            {
+                resource.last_use_state = Anvil::Utils::get_resource_state_for_resource_usage(current_access.usage);
+            }
+        }
+
+        if (resource.is_output)
+        {
+            resource.last_use       = n_ordered_passes;
+            resource.last_use_state = Anvil::Utils::get_resource_state_for_resource_usage(resource.final_usage);
+        }
+    }
+
+    if (!create_transient_resources() )
+    {
+        goto end;
+    }
+
+    for (uint32_t n_ordered_pass = 0;
+                  n_ordered_pass < n_ordered_passes;
+                ++n_ordered_pass)
+    {
+        Pass& pass = m_passes[m_ordered_passes[n_ordered_pass] ];
+
+        if (pass.type != PASS_TYPE_GRAPHICS)
+        {
+            continue;
+        }
+
+        if (!bake_render_pass(&pass,
+                              n_ordered_pass) )
+        {
+            goto end;
+        }
+    }
+
+    m_is_baked = true;
+    result     = true;
+end:
+    return result;
+}
+
+/** Creates a render pass with a single subpass for a graphics pass, and a graphics pipeline for the subpass.
+ *
+ *  @param in_pass_ptr       Graphics pass to create the render pass for.
+ *  @param in_n_ordered_pass Index of the pass in the execution order.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::DAGRenderer::bake_render_pass(Pass*    in_pass_ptr,
+                                          uint32_t in_n_ordered_pass)
+{
+    std::vector<RenderPassAttachmentID> attachment_ids;
+    uint32_t                            n_color_attachments = 0;
+    uint32_t                            n_input_attachments = 0;
+    std::shared_ptr<Anvil::RenderPass>  render_pass_ptr;
+    bool                                result              = false;
+    SubPassID                           subpass_id;
+
+    if (in_pass_ptr->attachments.size() == 0)
+    {
+        /* Graphics passes need to render to at least one attachment */
+        anvil_assert(in_pass_ptr->attachments.size() > 0);
+
+        goto end;
+    }
+
+    render_pass_ptr = Anvil::RenderPass::create(m_device_ptr,
+                                                m_swapchain_ptr);
+
+    in_pass_ptr->clear_values.clear();
+
+    in_pass_ptr->render_area_extent.height = UINT32_MAX;
+    in_pass_ptr->render_area_extent.width  = UINT32_MAX;
+
+    for (const auto& current_attachment : in_pass_ptr->attachments)
+    {
+        const Resource&     resource      = m_resources[current_attachment.resource_id];
+        const VkImageLayout layout        = Anvil::Utils::get_resource_state_for_resource_usage(current_attachment.usage).layout;
+        const bool          is_first_use  = (resource.is_transient && resource.first_use == in_n_ordered_pass);
+        const bool          is_last_use   = (resource.is_transient && resource.last_use  == in_n_ordered_pass);
+        RenderPassAttachmentID attachment_id;
+        VkAttachmentLoadOp  load_op;
+        VkAttachmentStoreOp store_op;
+
+        /* Contents of transient attachments need not be loaded at first use, nor stored at last use. */
+        load_op  = (current_attachment.has_clear_value) ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                 : (is_first_use)                       ? VK_ATTACHMENT_LOAD_OP_DONT_CARE
+                                                        : VK_ATTACHMENT_LOAD_OP_LOAD;
+        store_op = (is_last_use)                        ? VK_ATTACHMENT_STORE_OP_DONT_CARE
+                                                        : VK_ATTACHMENT_STORE_OP_STORE;
+
+        /* Attachments are transitioned to the layouts needed by the subpass before the render pass starts, so
+         * the render pass itself does not need to perform any layout transitions. */
+        if (is_depth_stencil_format(resource.image_format) )
+        {
+            result = render_pass_ptr->add_depth_stencil_attachment(resource.image_format,
+                                                                   resource.image_sample_count,
+                                                                   load_op,
+                                                                   store_op,
+                                                                   load_op,
+                                                                   store_op,
+                                                                   layout,
+                                                                   layout,
+                                                                   false, /* may_alias */
+                                                                  &attachment_id);
+        }
+        else
+        {
+            result = render_pass_ptr->add_color_attachment(resource.image_format,
+                                                           resource.image_sample_count,
+                                                           load_op,
+                                                           store_op,
+                                                           layout,
+                                                           layout,
+                                                           false, /* may_alias */
+                                                          &attachment_id);
+        }
+
+        if (!result)
+        {
+            goto end;
+        }
+
+        attachment_ids.push_back            (attachment_id);
+        in_pass_ptr->clear_values.push_back(current_attachment.clear_value);
+
+        in_pass_ptr->render_area_extent.height = std::min(in_pass_ptr->render_area_extent.height,
+                                                          resource.image_height);
+        in_pass_ptr->render_area_extent.width  = std::min(in_pass_ptr->render_area_extent.width,
+                                                          resource.image_width);
+    }
+
+    result = render_pass_ptr->add_subpass(in_pass_ptr->fragment_shader_entrypoint,
+                                          in_pass_ptr->geometry_shader_entrypoint,
+                                          in_pass_ptr->tess_control_shader_entrypoint,
+                                          in_pass_ptr->tess_evaluation_shader_entrypoint,
+                                          in_pass_ptr->vertex_shader_entrypoint,
+                                         &subpass_id);
+
+    if (!result)
+    {
+        goto end;
+    }
+
+    for (uint32_t n_attachment = 0;
+                  n_attachment < static_cast<uint32_t>(in_pass_ptr->attachments.size() ) && result;
+                ++n_attachment)
+    {
+        const Attachment&   current_attachment = in_pass_ptr->attachments[n_attachment];
+        const VkImageLayout layout             = Anvil::Utils::get_resource_state_for_resource_usage(current_attachment.usage).layout;
+
+        switch (current_attachment.usage)
+        {
+            case Anvil::RESOURCE_USAGE_COLOR_ATTACHMENT:
+            {
+                result = render_pass_ptr->add_subpass_color_attachment(subpass_id,
+                                                                       layout,
+                                                                       attachment_ids[n_attachment],
+                                                                       n_color_attachments++,
+                                                                       nullptr); /* opt_attachment_resolve_id_ptr */
+
+                break;
+            }
+
+            case Anvil::RESOURCE_USAGE_DEPTH_STENCIL_ATTACHMENT:
+            {
+                result = render_pass_ptr->add_subpass_depth_stencil_attachment(subpass_id,
+                                                                               attachment_ids[n_attachment],
+                                                                               layout);
+
+                break;
+            }
+
+            case Anvil::RESOURCE_USAGE_INPUT_ATTACHMENT:
+            {
+                result = render_pass_ptr->add_subpass_input_attachment(subpass_id,
+                                                                       layout,
+                                                                       attachment_ids[n_attachment],
+                                                                       n_input_attachments++);
+
+                break;
+            }
+
+            default:
+            {
+                anvil_assert(false);
+
+                result = false;
+            }
+        }
+    }
+
+    if (!result)
+    {
+        goto end;
+    }
+
+    result = render_pass_ptr->get_subpass_graphics_pipeline_id(subpass_id,
+                                                              &in_pass_ptr->pipeline_id);
+
+    if (!result)
+    {
+        goto end;
+    }
+
+    in_pass_ptr->render_pass_ptr = render_pass_ptr;
+end:
+    return result;
+}
+
+/* Please see header for specification */
+std::shared_ptr<Anvil::DAGRenderer> Anvil::DAGRenderer::create(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
+                                                               std::shared_ptr<Anvil::Swapchain> opt_swapchain_ptr)
+{
+    std::shared_ptr<DAGRenderer> result_ptr;
+
+    result_ptr.reset(
+        new Anvil::DAGRenderer(in_device_ptr,
+                               opt_swapchain_ptr)
+    );
+
+    return result_ptr;
+}
+
+/** Identifies passes which do not contribute to frame outputs.
+ *
+ *  Passes are traversed in reverse declaration order. A pass is kept if it is marked as never culled, or
+ *  if it writes to a resource which is needed by frame outputs or by a pass which has already been kept.
+ *  Resources read by a kept pass are needed, unless they are fully overwritten by it.
+ **/
+void Anvil::DAGRenderer::cull_passes()
+{
+    std::vector<bool> is_resource_needed(m_resources.size(),
+                                         false);
+
+    for (uint32_t n_resource = 0;
+                  n_resource < static_cast<uint32_t>(m_resources.size() );
+                ++n_resource)
+    {
+        is_resource_needed[n_resource] = m_resources[n_resource].is_output;
+    }
+
+    for (uint32_t n_pass = static_cast<uint32_t>(m_passes.size() );
+                  n_pass > 0;
+                --n_pass)
+    {
+        Pass& current_pass = m_passes[n_pass - 1];
+        bool  is_live      = current_pass.is_never_culled;
+
+        for (const auto& current_access : current_pass.accesses)
+        {
+            if (current_access.access_type != ACCESS_TYPE_INPUT &&
+                is_resource_needed[current_access.resource_id])
+            {
+                is_live = true;
+
+                break;
+            }
+        }
+
+        current_pass.is_culled = !is_live;
+
+        if (!is_live)
+        {
+            continue;
+        }
+
+        for (const auto& current_access : current_pass.accesses)
+        {
+            if (current_access.access_type != ACCESS_TYPE_OVERWRITE)
+            {
+                is_resource_needed[current_access.resource_id] = true;
+            }
+        }
+    }
+}
+
+/** Creates transient resources used by passes which have not been culled, assigns them memory and works
+ *  out which of them share memory regions.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::DAGRenderer::create_transient_resources()
+{
+    const uint32_t       n_resources = static_cast<uint32_t>(m_resources.size() );
+    bool                 result      = false;
+    std::vector<VkFlags> usage_flags (n_resources,
+                                      0);
+
+    for (const auto& current_pass_index : m_ordered_passes)
+    {
+        for (const auto& current_access : m_passes[current_pass_index].accesses)
+        {
+            get_usage_flags_for_resource_usage(current_access.usage,
+                                               m_resources[current_access.resource_id].is_image,
+                                              &usage_flags[current_access.resource_id]);
+        }
+    }
+
+    for (uint32_t n_resource = 0;
+                  n_resource < n_resources;
+                ++n_resource)
+    {
+        Resource& resource = m_resources[n_resource];
+
+        if (!resource.is_transient            ||
+             resource.first_use == UINT32_MAX)
+        {
+            continue;
+        }
+
+        if (m_memory_allocator_ptr == nullptr)
+        {
+            m_memory_allocator_ptr = Anvil::MemoryAllocator::create(m_device_ptr);
+        }
+
+        if (resource.is_output)
+        {
+            get_usage_flags_for_resource_usage(resource.final_usage,
+                                               resource.is_image,
+                                              &usage_flags[n_resource]);
+        }
+
+        if (resource.is_image)
+        {
+            resource.image_ptr = Anvil::Image::create_nonsparse(m_device_ptr,
+                                                                VK_IMAGE_TYPE_2D,
+                                                                resource.image_format,
+                                                                VK_IMAGE_TILING_OPTIMAL,
+                                                                usage_flags[n_resource],
+                                                                resource.image_width,
+                                                                resource.image_height,
+                                                                1, /* base_mipmap_depth */
+                                                                1, /* n_layers          */
+                                                                resource.image_sample_count,
+                                                                Anvil::QUEUE_FAMILY_COMPUTE_BIT | Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                                VK_SHARING_MODE_EXCLUSIVE,
+                                                                false, /* use_full_mipmap_chain */
+                                                                false, /* is_mutable            */
+                                                                VK_IMAGE_LAYOUT_UNDEFINED,
+                                                                nullptr); /* opt_mipmaps_ptr */
+
+            result = m_memory_allocator_ptr->add_transient_image_whole(resource.image_ptr,
+                                                                       resource.first_use,
+                                                                       resource.last_use,
+                                                                       0); /* in_required_memory_features */
+        }
+        else
+        {
+            resource.buffer_ptr = Anvil::Buffer::create_nonsparse(m_device_ptr,
+                                                                  resource.buffer_size,
+                                                                  Anvil::QUEUE_FAMILY_COMPUTE_BIT | Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                                  VK_SHARING_MODE_EXCLUSIVE,
+                                                                  usage_flags[n_resource]);
+
+            result = m_memory_allocator_ptr->add_transient_buffer(resource.buffer_ptr,
+                                                                  resource.first_use,
+                                                                  resource.last_use,
+                                                                  0); /* in_required_memory_features */
+        }
+
+        if (!result)
+        {
+            anvil_assert(result);
+
+            goto end;
+        }
+    }
+
+    if (m_memory_allocator_ptr == nullptr)
+    {
+        /* No transient resources are used by the frame */
+        result = true;
+
+        goto end;
+    }
+
+    result = m_memory_allocator_ptr->bake();
+
+    if (!result)
+    {
+        anvil_assert(result);
+
+        goto end;
+    }
+
+    /* Identify resources which share memory. The first access to a transient resource within a frame needs to
+     * wait for accesses to all resources it shares memory with, including the ones which follow it in the frame,
+     * as these may still be executing on behalf of the previous frame. */
+    for (uint32_t n_resource = 0;
+                  n_resource < n_resources;
+                ++n_resource)
+    {
+        Resource&                           resource         = m_resources[n_resource];
+        std::shared_ptr<Anvil::MemoryBlock> memory_block_ptr;
+
+        if (!resource.is_transient            ||
+             resource.first_use == UINT32_MAX)
+        {
+            continue;
+        }
+
+        memory_block_ptr = (resource.is_image) ? resource.image_ptr->get_memory_block  ()
+                                               : resource.buffer_ptr->get_memory_block(0);
+
+        for (uint32_t n_other_resource = 0;
+                      n_other_resource < n_resources;
+                    ++n_other_resource)
+        {
+            const Resource&                     other_resource         = m_resources[n_other_resource];
+            std::shared_ptr<Anvil::MemoryBlock> other_memory_block_ptr;
+
+            if (n_other_resource == n_resource      ||
+                !other_resource.is_transient        ||
+                 other_resource.first_use == UINT32_MAX)
+            {
+                continue;
+            }
+
+            other_memory_block_ptr = (other_resource.is_image) ? other_resource.image_ptr->get_memory_block  ()
+                                                               : other_resource.buffer_ptr->get_memory_block(0);
+
+            if (memory_block_ptr->get_memory()                                                       != other_memory_block_ptr->get_memory()                                               ||
+                memory_block_ptr->get_start_offset()                                                 >= other_memory_block_ptr->get_start_offset() + other_memory_block_ptr->get_size() ||
+                other_memory_block_ptr->get_start_offset()                                           >= memory_block_ptr->get_start_offset()       + memory_block_ptr->get_size() )
+            {
+                continue;
+            }
+
+            resource.aliased_state.access_mask |= other_resource.last_use_state.access_mask;
+            resource.aliased_state.stage_mask  |= other_resource.last_use_state.stage_mask;
+        }
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::Buffer> Anvil::DAGRenderer::get_buffer(DAGRendererResourceID in_resource_id) const
+{
+    anvil_assert(in_resource_id < m_resources.size() );
+
+    return m_resources.at(in_resource_id).buffer_ptr;
+}
+
+/** Returns a framebuffer which can be used with the render pass of a graphics pass, given images currently
+ *  associated with its attachment resources. Framebuffers are created on first request & cached.
+ *
+ *  @param in_pass_ptr Graphics pass to return the framebuffer for. Must have been baked.
+ *
+ *  @return Requested framebuffer or nullptr, if the function failed.
+ **/
+std::shared_ptr<Anvil::Framebuffer> Anvil::DAGRenderer::get_framebuffer(Pass* in_pass_ptr)
+{
+    std::shared_ptr<Anvil::Framebuffer> result_ptr;
+
+    m_temp_framebuffer_key.clear();
+
+    for (const auto& current_attachment : in_pass_ptr->attachments)
+    {
+        m_temp_framebuffer_key.push_back(m_resources[current_attachment.resource_id].image_ptr.get() );
+    }
+
+    auto framebuffer_iterator = in_pass_ptr->framebuffers.find(m_temp_framebuffer_key);
+
+    if (framebuffer_iterator != in_pass_ptr->framebuffers.end() )
+    {
+        result_ptr = framebuffer_iterator->second;
+
+        goto end;
+    }
+
+    result_ptr = Anvil::Framebuffer::create(m_device_ptr,
+                                            in_pass_ptr->render_area_extent.width,
+                                            in_pass_ptr->render_area_extent.height,
+                                            1); /* n_layers */
+
+    for (const auto& current_attachment : in_pass_ptr->attachments)
+    {
+        std::shared_ptr<Anvil::ImageView> image_view_ptr = get_image_view(current_attachment.resource_id);
+
+        if (image_view_ptr == nullptr                     ||
+            !result_ptr->add_attachment(image_view_ptr,
+                                        nullptr) )        /* out_opt_attachment_id_ptr */
+        {
+            anvil_assert(false);
+
+            result_ptr.reset();
+            goto end;
+        }
+    }
+
+    if (!result_ptr->bake(in_pass_ptr->render_pass_ptr) )
+    {
+        anvil_assert(false);
+
+        result_ptr.reset();
+        goto end;
+    }
+
+    in_pass_ptr->framebuffers[m_temp_framebuffer_key] = result_ptr;
+end:
+    return result_ptr;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::get_graphics_pass_pipeline_id(DAGRendererPassID   in_pass_id,
+                                                       GraphicsPipelineID* out_graphics_pipeline_id_ptr) const
+{
+    bool result = false;
+
+    if (in_pass_id >= m_passes.size() )
+    {
+        anvil_assert(in_pass_id < m_passes.size() );
+
+        goto end;
+    }
+
+    if (m_passes[in_pass_id].render_pass_ptr == nullptr)
+    {
+        goto end;
+    }
+
+    *out_graphics_pipeline_id_ptr = m_passes[in_pass_id].pipeline_id;
+    result                        = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::RenderPass> Anvil::DAGRenderer::get_graphics_pass_render_pass(DAGRendererPassID in_pass_id) const
+{
+    anvil_assert(in_pass_id < m_passes.size() );
+
+    return m_passes.at(in_pass_id).render_pass_ptr;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::Image> Anvil::DAGRenderer::get_image(DAGRendererResourceID in_resource_id) const
+{
+    anvil_assert(in_resource_id < m_resources.size() );
+
+    return m_resources.at(in_resource_id).image_ptr;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::ImageView> Anvil::DAGRenderer::get_image_view(DAGRendererResourceID in_resource_id)
+{
+    std::shared_ptr<Anvil::Image>     image_ptr;
+    std::shared_ptr<Anvil::ImageView> result_ptr;
+
+    if (in_resource_id >= m_resources.size() )
+    {
+        anvil_assert(in_resource_id < m_resources.size() );
+
+        goto end;
+    }
+
+    image_ptr = m_resources[in_resource_id].image_ptr;
+
+    if (image_ptr == nullptr)
+    {
+        goto end;
+    }
+
+    {
+        auto view_iterator = m_image_views.find(image_ptr.get() );
+
+        if (view_iterator != m_image_views.end() )
+        {
+            result_ptr = view_iterator->second;
+        }
+        else
+        {
+            std::vector<VkImageAspectFlags> aspects;
+            VkImageAspectFlags              aspect_mask = 0;
+
+            Anvil::Formats::get_format_aspects(image_ptr->get_image_format(),
+                                              &aspects);
+
+            for (const auto& current_aspect : aspects)
+            {
+                aspect_mask |= current_aspect;
+            }
+
+            result_ptr = Anvil::ImageView::create_2D(m_device_ptr,
+                                                     image_ptr,
+                                                     0, /* n_base_layer        */
+                                                     0, /* n_base_mipmap_level */
+                                                     image_ptr->get_image_n_mipmaps(),
+                                                     static_cast<VkImageAspectFlagBits>(aspect_mask),
+                                                     image_ptr->get_image_format(),
+                                                     VK_COMPONENT_SWIZZLE_R,
+                                                     VK_COMPONENT_SWIZZLE_G,
+                                                     VK_COMPONENT_SWIZZLE_B,
+                                                     VK_COMPONENT_SWIZZLE_A);
+
+            m_image_views[image_ptr.get()] = result_ptr;
+        }
+    }
+
+end:
+    return result_ptr;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::import_buffer(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                       DAGRendererResourceID*         out_resource_id_ptr)
+{
+    Resource new_resource;
+    bool     result = false;
+
+    if (m_is_baked)
+    {
+        anvil_assert(!m_is_baked);
+
+        goto end;
+    }
+
+    new_resource.buffer_ptr = in_buffer_ptr;
+    new_resource.is_image   = false;
+
+    *out_resource_id_ptr = static_cast<DAGRendererResourceID>(m_resources.size() );
+
+    m_resources.push_back(new_resource);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::import_image(std::shared_ptr<Anvil::Image> in_image_ptr,
+                                      DAGRendererResourceID*        out_resource_id_ptr)
+{
+    bool result = false;
+
+    if (m_is_baked)
+    {
+        anvil_assert(!m_is_baked);
+
+        goto end;
+    }
+
+    *out_resource_id_ptr = static_cast<DAGRendererResourceID>(m_resources.size() );
+
+    m_resources.push_back(Resource() );
+    m_resources.back().is_image = true;
+
+    if (in_image_ptr != nullptr)
+    {
+        result = set_imported_image(*out_resource_id_ptr,
+                                    in_image_ptr);
+    }
+    else
+    {
+        result = true;
+    }
+
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::is_pass_culled(DAGRendererPassID in_pass_id) const
+{
+    anvil_assert(in_pass_id < m_passes.size() );
+
+    return m_passes.at(in_pass_id).is_culled;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::mark_as_output(DAGRendererResourceID in_resource_id,
+                                        Anvil::ResourceUsage  in_final_usage)
+{
+    bool    result      = false;
+    VkFlags usage_flags = 0;
+
+    if (m_is_baked                           ||
+        in_resource_id >= m_resources.size() )
+    {
+        anvil_assert(!m_is_baked                           &&
+                      in_resource_id < m_resources.size() );
+
+        goto end;
+    }
+
+    if (!get_usage_flags_for_resource_usage(in_final_usage,
+                                            m_resources[in_resource_id].is_image,
+                                           &usage_flags) )
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    m_resources[in_resource_id].final_usage = in_final_usage;
+    m_resources[in_resource_id].is_output   = true;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Orders passes which have not been culled, so that each pass is executed after all passes it depends on.
+ *
+ *  A pass depends on the passes declared earlier, which write to resources it accesses, and, if the pass
+ *  writes to a resource, on the passes which read its previous contents. Among passes whose dependencies
+ *  have been met, the scheduler prefers those which do not depend on the most recently scheduled pass, so
+ *  that dependent passes are spread apart and barriers stall the pipeline less often. Ties are broken
+ *  using declaration order.
+ **/
+void Anvil::DAGRenderer::order_passes()
+{
+    const uint32_t                      n_passes           = static_cast<uint32_t>(m_passes.size() );
+    std::vector<uint32_t>               last_writers       (m_resources.size(),
+                                                            UINT32_MAX);
+    uint32_t                            last_scheduled_pass = UINT32_MAX;
+    std::vector<uint32_t>               n_unmet_dependencies(n_passes,
+                                                             0);
+    std::vector<std::vector<uint32_t> > readers            (m_resources.size() );
+    std::vector<uint32_t>               ready_passes;
+    std::vector<std::vector<uint32_t> > successors         (n_passes);
+
+    m_ordered_passes.clear();
+
+    /* Build the dependency graph */
+    for (uint32_t n_pass = 0;
+                  n_pass < n_passes;
+                ++n_pass)
+    {
+        Pass& current_pass = m_passes[n_pass];
+
+        current_pass.dependencies.clear();
+
+        if (current_pass.is_culled)
+        {
+            continue;
+        }
+
+        for (const auto& current_access : current_pass.accesses)
+        {
+            if (last_writers[current_access.resource_id] != UINT32_MAX)
+            {
+                current_pass.dependencies.push_back(last_writers[current_access.resource_id]);
+            }
+
+            if (current_access.access_type != ACCESS_TYPE_INPUT)
+            {
+                current_pass.dependencies.insert(current_pass.dependencies.end(),
+                                                 readers[current_access.resource_id].begin(),
+                                                 readers[current_access.resource_id].end() );
+            }
+        }
+
+        for (const auto& current_access : current_pass.accesses)
+        {
+            if (current_access.access_type == ACCESS_TYPE_INPUT)
+            {
+                readers[current_access.resource_id].push_back(n_pass);
+            }
+            else
+            {
+                last_writers[current_access.resource_id] = n_pass;
+
+                readers[current_access.resource_id].clear();
+            }
+        }
+
+        std::sort(current_pass.dependencies.begin(),
+                  current_pass.dependencies.end() );
+
+        current_pass.dependencies.erase(std::unique(current_pass.dependencies.begin(),
+                                                    current_pass.dependencies.end() ),
+                                        current_pass.dependencies.end() );
+
+        for (const auto& current_dependency : current_pass.dependencies)
+        {
+            successors[current_dependency].push_back(n_pass);
+        }
+
+        n_unmet_dependencies[n_pass] = static_cast<uint32_t>(current_pass.dependencies.size() );
+
+        if (n_unmet_dependencies[n_pass] == 0)
+        {
+            ready_passes.push_back(n_pass);
+        }
+    }
+
+    /* Schedule the passes. Dependencies always point at passes declared earlier, so the graph is acyclic. */
+    while (ready_passes.size() > 0)
+    {
+        uint32_t n_selected_ready_pass = UINT32_MAX;
+
+        for (uint32_t n_ready_pass = 0;
+                      n_ready_pass < static_cast<uint32_t>(ready_passes.size() );
+                    ++n_ready_pass)
+        {
+            const Pass& ready_pass = m_passes[ready_passes[n_ready_pass] ];
+
+            if (n_selected_ready_pass != UINT32_MAX &&
+                ready_passes[n_selected_ready_pass] < ready_passes[n_ready_pass])
+            {
+                continue;
+            }
+
+            if (last_scheduled_pass != UINT32_MAX                       &&
+                std::binary_search(ready_pass.dependencies.begin(),
+                                   ready_pass.dependencies.end(),
+                                   last_scheduled_pass) )
+            {
+                continue;
+            }
+
+            n_selected_ready_pass = n_ready_pass;
+        }
+
+        if (n_selected_ready_pass == UINT32_MAX)
+        {
+            /* All ready passes depend on the last scheduled one. Use declaration order. */
+            n_selected_ready_pass = static_cast<uint32_t>(std::min_element(ready_passes.begin(),
+                                                                           ready_passes.end() ) - ready_passes.begin() );
+        }
+
+        last_scheduled_pass = ready_passes[n_selected_ready_pass];
+
+        ready_passes.erase(ready_passes.begin() + n_selected_ready_pass);
+        m_ordered_passes.push_back(last_scheduled_pass);
+
+        for (const auto& current_successor : successors[last_scheduled_pass])
+        {
+            if (--n_unmet_dependencies[current_successor] == 0)
+            {
+                ready_passes.push_back(current_successor);
+            }
+        }
+    }
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::record(std::shared_ptr<Anvil::PrimaryCommandBuffer> in_cmd_buffer_ptr)
+{
+    bool result = false;
+
+    if (!m_is_baked)
+    {
+        anvil_assert(m_is_baked);
+
+        goto end;
+    }
+
+    for (uint32_t n_ordered_pass = 0;
+                  n_ordered_pass < static_cast<uint32_t>(m_ordered_passes.size() );
+                ++n_ordered_pass)
+    {
+        const DAGRendererPassID pass_id = m_ordered_passes[n_ordered_pass];
+        Pass&                   pass    = m_passes[pass_id];
+
+        /* Transition all resources accessed by the pass to the declared usages. The command buffer works out
+         * the minimal set of barriers needed to do so. */
+        for (const auto& current_access : pass.accesses)
+        {
+            const Resource& resource     = m_resources[current_access.resource_id];
+            const bool      is_first_use = (resource.first_use == n_ordered_pass);
+
+            if (resource.is_image)
+            {
+                if (resource.image_ptr == nullptr)
+                {
+                    anvil_assert(resource.image_ptr != nullptr);
+
+                    goto end;
+                }
+
+                if (resource.is_transient                    &&
+                    is_first_use                             &&
+                    resource.aliased_state.stage_mask != 0)
+                {
+                    in_cmd_buffer_ptr->add_aliasing_dependency(resource.image_ptr,
+                                                               resource.aliased_state);
+                }
+
+                result = in_cmd_buffer_ptr->record_transition(resource.image_ptr,
+                                                              current_access.usage,
+                                                              is_first_use && (resource.is_transient || current_access.access_type == ACCESS_TYPE_OVERWRITE) );
+            }
+            else
+            {
+                if (resource.buffer_ptr == nullptr)
+                {
+                    anvil_assert(resource.buffer_ptr != nullptr);
+
+                    goto end;
+                }
+
+                if (resource.is_transient                    &&
+                    is_first_use                             &&
+                    resource.aliased_state.stage_mask != 0)
+                {
+                    in_cmd_buffer_ptr->add_aliasing_dependency(resource.buffer_ptr,
+                                                               resource.aliased_state);
+                }
+
+                result = in_cmd_buffer_ptr->record_transition(resource.buffer_ptr,
+                                                              0, /* in_offset */
+                                                              VK_WHOLE_SIZE,
+                                                              current_access.usage);
+            }
+
+            if (!result)
+            {
+                goto end;
+            }
+        }
+
+        if (pass.type == PASS_TYPE_GRAPHICS)
+        {
+            std::shared_ptr<Anvil::Framebuffer> framebuffer_ptr = get_framebuffer(&pass);
+            VkRect2D                            render_area;
+
+            if (framebuffer_ptr == nullptr)
+            {
+                result = false;
+
+                goto end;
+            }
+
+            render_area.extent   = pass.render_area_extent;
+            render_area.offset.x = 0;
+            render_area.offset.y = 0;
+
+            result = in_cmd_buffer_ptr->record_begin_render_pass(static_cast<uint32_t>(pass.clear_values.size() ),
+                                                                 &pass.clear_values[0],
+                                                                 framebuffer_ptr,
+                                                                 render_area,
+                                                                 pass.render_pass_ptr,
+                                                                 VK_SUBPASS_CONTENTS_INLINE);
+
+            if (!result)
+            {
+                goto end;
+            }
+        }
+
+        pass.pfn_record_proc(this,
+                             pass_id,
+                             in_cmd_buffer_ptr,
+                             pass.user_arg);
+
+        if (pass.type == PASS_TYPE_GRAPHICS)
+        {
+            result = in_cmd_buffer_ptr->record_end_render_pass();
+
+            if (!result)
+            {
+                goto end;
+            }
+        }
+    }
+
+    /* Transition frame outputs to their final usages */
+    for (const auto& current_resource : m_resources)
+    {
+        if (!current_resource.is_output                                               ||
+            (current_resource.is_transient && current_resource.first_use == UINT32_MAX) )
+        {
+            continue;
+        }
+
+        if (current_resource.is_image)
+        {
+            result = (current_resource.image_ptr != nullptr) &&
+                     in_cmd_buffer_ptr->record_transition(current_resource.image_ptr,
+                                                          current_resource.final_usage);
+        }
+        else
+        {
+            result = (current_resource.buffer_ptr != nullptr) &&
+                     in_cmd_buffer_ptr->record_transition(current_resource.buffer_ptr,
+                                                          0, /* in_offset */
+                                                          VK_WHOLE_SIZE,
+                                                          current_resource.final_usage);
+        }
+
+        if (!result)
+        {
+            anvil_assert(result);
+
+            goto end;
+        }
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::set_imported_buffer(DAGRendererResourceID          in_resource_id,
+                                             std::shared_ptr<Anvil::Buffer> in_buffer_ptr)
+{
+    bool result = false;
+
+    if (in_resource_id >= m_resources.size() )
+    {
+        anvil_assert(in_resource_id < m_resources.size() );
+
+        goto end;
+    }
+
+    if ( m_resources[in_resource_id].is_image     ||
+         m_resources[in_resource_id].is_transient)
+    {
+        anvil_assert(!m_resources[in_resource_id].is_image     &&
+                     !m_resources[in_resource_id].is_transient);
+
+        goto end;
+    }
+
+    m_resources[in_resource_id].buffer_ptr = in_buffer_ptr;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::set_imported_image(DAGRendererResourceID         in_resource_id,
+                                            std::shared_ptr<Anvil::Image> in_image_ptr)
+{
+    uint32_t  image_height = 0;
+    uint32_t  image_width  = 0;
+    Resource* resource_ptr = nullptr;
+    bool      result       = false;
+
+    if (in_resource_id >= m_resources.size() ||
+        in_image_ptr   == nullptr)
+    {
+        anvil_assert(in_resource_id < m_resources.size() &&
+                     in_image_ptr   != nullptr);
+
+        goto end;
+    }
+
+    resource_ptr = &m_resources[in_resource_id];
+
+    if (!resource_ptr->is_image     ||
+         resource_ptr->is_transient)
+    {
+        anvil_assert( resource_ptr->is_image     &&
+                     !resource_ptr->is_transient);
+
+        goto end;
+    }
+
+    in_image_ptr->get_image_mipmap_size(0, /* n_mipmap */
+                                       &image_width,
+                                       &image_height,
+                                        nullptr); /* opt_out_depth_ptr */
+
+    if (resource_ptr->image_format != VK_FORMAT_UNDEFINED)
+    {
+        /* Render passes & framebuffers have been created with the original image properties in mind */
+        if (resource_ptr->image_format       != in_image_ptr->get_image_format()       ||
+            resource_ptr->image_height       != image_height                           ||
+            resource_ptr->image_sample_count != in_image_ptr->get_image_sample_count() ||
+            resource_ptr->image_width        != image_width)
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+    }
+    else
+    {
+        resource_ptr->image_format       = in_image_ptr->get_image_format      ();
+        resource_ptr->image_height       = image_height;
+        resource_ptr->image_sample_count = in_image_ptr->get_image_sample_count();
+        resource_ptr->image_width        = image_width;
+    }
+
+    resource_ptr->image_ptr = in_image_ptr;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DAGRenderer::set_pass_never_culled(DAGRendererPassID in_pass_id)
+{
+    bool result = false;
+
+    if (m_is_baked                     ||
+        in_pass_id >= m_passes.size() )
+    {
+        anvil_assert(!m_is_baked                     &&
+                      in_pass_id < m_passes.size() );
+
+        goto end;
+    }
+
+    m_passes[in_pass_id].is_never_culled = true;
+
+    result = true;
+end:
+    return result;
+}
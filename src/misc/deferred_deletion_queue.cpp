@@ -0,0 +1,408 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
+#include "misc/fence_pool.h"
+#include "wrappers/device.h"
+#include "wrappers/fence.h"
+#include "wrappers/queue.h"
+
+
+/** Please see header for specification */
+Anvil::DeferredDeletionQueue::DeferredDeletionQueue(std::weak_ptr<Anvil::BaseDevice> in_device_ptr)
+    :m_current_serial   (0),
+     m_device_ptr       (in_device_ptr),
+     m_enabled          (false),
+     m_n_pending_handles(0)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::DeferredDeletionQueue::~DeferredDeletionQueue()
+{
+    /* The device is expected to call release_all() before it drops the queue. */
+    anvil_assert(m_collected_command_buffers.size() == 0);
+    anvil_assert(m_items.size()                     == 0);
+}
+
+/** Please see header for specification */
+void Anvil::DeferredDeletionQueue::collect()
+{
+    uint64_t                     completed_serial = UINT64_MAX;
+    std::unique_lock<std::mutex> lock            (m_mutex);
+
+    /* Serials complete in order, so stop at the first one whose fences have not all been signalled yet */
+    while (m_pending_serials.size() > 0)
+    {
+        PendingSerial& pending_serial = m_pending_serials.front();
+        bool           is_complete    = true;
+
+        for (auto fence_iterator  = pending_serial.fence_ptrs.cbegin();
+                  fence_iterator != pending_serial.fence_ptrs.cend();
+                ++fence_iterator)
+        {
+            if (!(*fence_iterator)->is_set() )
+            {
+                is_complete = false;
+
+                break;
+            }
+        }
+
+        if (!is_complete)
+        {
+            break;
+        }
+
+        completed_serial = pending_serial.serial;
+
+        m_pending_serials.pop_front();
+    }
+
+    if (completed_serial != UINT64_MAX)
+    {
+        collect_internal(completed_serial);
+    }
+}
+
+/** Releases all handles tagged with a serial, which is not larger than @param in_completed_serial.
+ *  Command buffers are handed back to their command pools instead of being freed.
+ *
+ *  The caller must own the queue's mutex.
+ *
+ *  @param in_completed_serial Largest serial whose handles should be released.
+ **/
+void Anvil::DeferredDeletionQueue::collect_internal(uint64_t in_completed_serial)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+
+    /* Handles are stored in the order they were handed over in. This guarantees that command buffers
+     * are released before the command pools they have been allocated from. */
+    while (m_items.size()          >  0                   &&
+           m_items.front().serial <= in_completed_serial)
+    {
+        const Item& item = m_items.front();
+
+        if (item.object_type == Anvil::OBJECT_TYPE_COMMAND_BUFFER)
+        {
+            m_collected_command_buffers[reinterpret_cast<VkCommandPool>(item.parent_handle)].push_back(reinterpret_cast<VkCommandBuffer>(item.handle) );
+        }
+        else
+        {
+            /* Destroying a command pool frees all command buffers allocated from it */
+            if (item.object_type == Anvil::OBJECT_TYPE_COMMAND_POOL)
+            {
+                m_collected_command_buffers.erase(reinterpret_cast<VkCommandPool>(item.handle) );
+            }
+
+            release_handle(device_locked_ptr,
+                           item.object_type,
+                           item.handle,
+                           item.parent_handle);
+        }
+
+        m_items.pop_front();
+
+        --m_n_pending_handles;
+    }
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::DeferredDeletionQueue> Anvil::DeferredDeletionQueue::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr)
+{
+    std::shared_ptr<Anvil::DeferredDeletionQueue> result_ptr;
+
+    result_ptr.reset(
+        new Anvil::DeferredDeletionQueue(in_device_ptr)
+    );
+
+    return result_ptr;
+}
+
+/** Hands the specified handle over to @param in_device_ptr's deferred deletion queue, or releases it
+ *  right away if the queue is disabled or not available.
+ *
+ *  For argument discussion, please see destroy().
+ **/
+void Anvil::DeferredDeletionQueue::destroy_internal(const std::shared_ptr<Anvil::BaseDevice>& in_device_ptr,
+                                                    Anvil::ObjectType                         in_object_type,
+                                                    uint64_t                                  in_handle,
+                                                    uint64_t                                  in_parent_handle)
+{
+    std::shared_ptr<Anvil::DeferredDeletionQueue> queue_ptr = in_device_ptr->get_deferred_deletion_queue();
+
+    if (queue_ptr != nullptr &&
+        queue_ptr->m_enabled)
+    {
+        std::unique_lock<std::mutex> lock(queue_ptr->m_mutex);
+
+        queue_ptr->m_items.push_back(Item(in_object_type,
+                                          in_handle,
+                                          in_parent_handle,
+                                          queue_ptr->m_current_serial) );
+
+        ++queue_ptr->m_n_pending_handles;
+    }
+    else
+    {
+        /* The queue may have been disabled after it collected command buffers of the pool */
+        if (queue_ptr      != nullptr &&
+            in_object_type == Anvil::OBJECT_TYPE_COMMAND_POOL)
+        {
+            std::unique_lock<std::mutex> lock(queue_ptr->m_mutex);
+
+            queue_ptr->m_collected_command_buffers.erase(reinterpret_cast<VkCommandPool>(in_handle) );
+        }
+
+        release_handle(in_device_ptr,
+                       in_object_type,
+                       in_handle,
+                       in_parent_handle);
+    }
+}
+
+/** Please see header for specification */
+void Anvil::DeferredDeletionQueue::end_serial()
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    Anvil::QueueSubmitBatch            empty_batch;
+    std::unique_lock<std::mutex>       end_serial_lock  (m_end_serial_mutex);
+    PendingSerial                      pending_serial;
+
+    /* Start a new serial before the fences are submitted. Handles released from now on may be used by
+     * submissions the fences do not cover. Handles released before have only been used by submissions
+     * issued before, which the fences do cover. */
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        init_queues();
+
+        pending_serial.serial = m_current_serial++;
+    }
+
+    /* The queue's mutex must not be owned while submitting, since releasing the batch's command buffers
+     * may hand their handles over to the queue. */
+    for (uint32_t n_queue = 0;
+                  n_queue < static_cast<uint32_t>(m_queue_ptrs.size() );
+                ++n_queue)
+    {
+        Anvil::Queue*  queue_ptr     = m_queue_ptrs[n_queue];
+        const uint64_t n_submissions = queue_ptr->get_n_submissions();
+
+        /* Skip queues which have not been used since the last serial ended */
+        if (m_queue_n_submissions[n_queue] == n_submissions)
+        {
+            continue;
+        }
+
+        pending_serial.fence_ptrs.push_back(device_locked_ptr->get_fence_pool()->get_fence() );
+
+        queue_ptr->submit_batch(&empty_batch,
+                                false, /* should_block */
+                                pending_serial.fence_ptrs.back() );
+
+        /* Submissions issued by other threads after get_n_submissions() was called are not covered
+         * by the fence. Only account for the one made above, so that the next serial covers them. */
+        m_queue_n_submissions[n_queue] = n_submissions + 1;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_pending_serials.push_back(pending_serial);
+    }
+
+    collect();
+}
+
+/** Please see header for specification */
+void Anvil::DeferredDeletionQueue::free_command_buffers(VkCommandPool in_command_pool)
+{
+    std::vector<VkCommandBuffer>       command_buffers_vk;
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto                         map_iterator = m_collected_command_buffers.find(in_command_pool);
+
+        if (map_iterator == m_collected_command_buffers.end() )
+        {
+            goto end;
+        }
+
+        command_buffers_vk.swap(map_iterator->second);
+
+        m_collected_command_buffers.erase(map_iterator);
+    }
+
+    device_locked_ptr = m_device_ptr.lock();
+
+    vkFreeCommandBuffers(device_locked_ptr->get_device_vk(),
+                         in_command_pool,
+                         static_cast<uint32_t>(command_buffers_vk.size() ),
+                        &command_buffers_vk[0]);
+
+end:
+    ;
+}
+
+/** Caches pointers to all queues of the device, unless already done.
+ *
+ *  The caller must own the queue's mutex.
+ **/
+void Anvil::DeferredDeletionQueue::init_queues()
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr;
+
+    if (m_queue_ptrs.size() > 0)
+    {
+        goto end;
+    }
+
+    device_locked_ptr = m_device_ptr.lock();
+
+    /* Sparse binding queues are not enumerated, since they are also exposed as queues of one of the
+     * families below. */
+    for (Anvil::QueueFamilyType queue_family_type  = Anvil::QUEUE_FAMILY_TYPE_FIRST;
+                                queue_family_type <  Anvil::QUEUE_FAMILY_TYPE_COUNT;
+                                queue_family_type  = static_cast<Anvil::QueueFamilyType>(queue_family_type + 1))
+    {
+        const uint32_t n_queues = device_locked_ptr->get_n_queues(queue_family_type);
+
+        for (uint32_t n_queue = 0;
+                      n_queue < n_queues;
+                    ++n_queue)
+        {
+            std::shared_ptr<Anvil::Queue> queue_ptr;
+
+            switch (queue_family_type)
+            {
+                case Anvil::QUEUE_FAMILY_TYPE_COMPUTE:   queue_ptr = device_locked_ptr->get_compute_queue  (n_queue); break;
+                case Anvil::QUEUE_FAMILY_TYPE_TRANSFER:  queue_ptr = device_locked_ptr->get_transfer_queue (n_queue); break;
+                case Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL: queue_ptr = device_locked_ptr->get_universal_queue(n_queue); break;
+
+                default:
+                {
+                    anvil_assert(false);
+                }
+            }
+
+            m_queue_n_submissions.push_back(0);
+            m_queue_ptrs.push_back         (queue_ptr.get() );
+        }
+    }
+
+end:
+    ;
+}
+
+/** Please see header for specification */
+void Anvil::DeferredDeletionQueue::release_all()
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    std::unique_lock<std::mutex>       lock             (m_mutex);
+
+    init_queues();
+
+    /* Make sure all submissions have been handed over to Vulkan before waiting for the device. The submit
+     * threads may hand handles over to the queue in the meantime, so the mutex must not be owned. */
+    lock.unlock();
+
+    for (auto queue_iterator  = m_queue_ptrs.begin();
+              queue_iterator != m_queue_ptrs.end();
+            ++queue_iterator)
+    {
+        (*queue_iterator)->flush_submissions();
+    }
+
+    vkDeviceWaitIdle(device_locked_ptr->get_device_vk() );
+
+    lock.lock();
+
+    m_pending_serials.clear();
+
+    collect_internal(UINT64_MAX);
+
+    /* Command pools, which are still alive at this point, are no longer used by the app */
+    for (auto map_iterator  = m_collected_command_buffers.cbegin();
+              map_iterator != m_collected_command_buffers.cend();
+            ++map_iterator)
+    {
+        vkFreeCommandBuffers(device_locked_ptr->get_device_vk(),
+                             map_iterator->first,
+                             static_cast<uint32_t>(map_iterator->second.size() ),
+                            &map_iterator->second[0]);
+    }
+
+    m_collected_command_buffers.clear();
+}
+
+/** Releases the specified Vulkan object right away.
+ *
+ *  For argument discussion, please see destroy().
+ **/
+void Anvil::DeferredDeletionQueue::release_handle(const std::shared_ptr<Anvil::BaseDevice>& in_device_ptr,
+                                                  Anvil::ObjectType                         in_object_type,
+                                                  uint64_t                                  in_handle,
+                                                  uint64_t                                  in_parent_handle)
+{
+    const VkDevice device_vk = in_device_ptr->get_device_vk();
+
+    switch (in_object_type)
+    {
+        case Anvil::OBJECT_TYPE_BUFFER:                vkDestroyBuffer              (device_vk, reinterpret_cast<VkBuffer>              (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_BUFFER_VIEW:           vkDestroyBufferView          (device_vk, reinterpret_cast<VkBufferView>          (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_COMMAND_POOL:          vkDestroyCommandPool         (device_vk, reinterpret_cast<VkCommandPool>         (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_DESCRIPTOR_POOL:       vkDestroyDescriptorPool      (device_vk, reinterpret_cast<VkDescriptorPool>      (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT: vkDestroyDescriptorSetLayout (device_vk, reinterpret_cast<VkDescriptorSetLayout> (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_EVENT:                 vkDestroyEvent               (device_vk, reinterpret_cast<VkEvent>               (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_FRAMEBUFFER:           vkDestroyFramebuffer         (device_vk, reinterpret_cast<VkFramebuffer>         (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_IMAGE:                 vkDestroyImage               (device_vk, reinterpret_cast<VkImage>               (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_IMAGE_VIEW:            vkDestroyImageView           (device_vk, reinterpret_cast<VkImageView>           (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_MEMORY_BLOCK:          vkFreeMemory                 (device_vk, reinterpret_cast<VkDeviceMemory>        (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_PIPELINE:              vkDestroyPipeline            (device_vk, reinterpret_cast<VkPipeline>            (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_PIPELINE_LAYOUT:       vkDestroyPipelineLayout      (device_vk, reinterpret_cast<VkPipelineLayout>      (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_QUERY_POOL:            vkDestroyQueryPool           (device_vk, reinterpret_cast<VkQueryPool>           (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_RENDER_PASS:           vkDestroyRenderPass          (device_vk, reinterpret_cast<VkRenderPass>          (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_SAMPLER:               vkDestroySampler             (device_vk, reinterpret_cast<VkSampler>             (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_SEMAPHORE:             vkDestroySemaphore           (device_vk, reinterpret_cast<VkSemaphore>           (in_handle), nullptr /* pAllocator */); break;
+        case Anvil::OBJECT_TYPE_SHADER_MODULE:         vkDestroyShaderModule        (device_vk, reinterpret_cast<VkShaderModule>        (in_handle), nullptr /* pAllocator */); break;
+
+        case Anvil::OBJECT_TYPE_COMMAND_BUFFER:
+        {
+            const VkCommandBuffer cmd_buffer_vk = reinterpret_cast<VkCommandBuffer>(in_handle);
+
+            vkFreeCommandBuffers(device_vk,
+                                 reinterpret_cast<VkCommandPool>(in_parent_handle),
+                                 1, /* commandBufferCount */
+                                &cmd_buffer_vk);
+
+            break;
+        }
+
+        default:
+        {
+            anvil_assert(false);
+        }
+    }
+}
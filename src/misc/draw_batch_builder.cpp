@@ -0,0 +1,281 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "misc/debug.h"
+#include "misc/draw_batch_builder.h"
+#include "wrappers/buffer.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/device.h"
+#include <algorithm>
+
+
+/** Please see header for specification */
+Anvil::DrawBatchBuilder::DrawBatchBuilder(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                          uint32_t                         in_n_frames_in_flight,
+                                          uint32_t                         in_n_max_draws_in_ring)
+    :m_device_ptr         (in_device_ptr),
+     m_n_frames_in_flight (in_n_frames_in_flight),
+     m_n_max_draws_in_ring(in_n_max_draws_in_ring),
+     m_n_ring_head_draw   (0),
+     m_n_started_frames   (0)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::DrawBatchBuilder::~DrawBatchBuilder()
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+void Anvil::DrawBatchBuilder::add_draw(DrawBatchStateKey in_state_key,
+                                       uint32_t          in_index_count,
+                                       uint32_t          in_instance_count,
+                                       uint32_t          in_first_index,
+                                       int32_t           in_vertex_offset,
+                                       uint32_t          in_first_instance)
+{
+    VkDrawIndexedIndirectCommand command;
+
+    command.firstIndex    = in_first_index;
+    command.firstInstance = in_first_instance;
+    command.indexCount    = in_index_count;
+    command.instanceCount = in_instance_count;
+    command.vertexOffset  = in_vertex_offset;
+
+    m_pending_draws.push_back(
+        PendingDraw(in_state_key,
+                    command)
+    );
+}
+
+/** Please see header for specification */
+void Anvil::DrawBatchBuilder::begin_frame()
+{
+    const uint64_t current_frame_index = m_n_started_frames++;
+
+    /* Regions are stored in the order they have been written in, so the oldest ones come first */
+    while (m_in_flight_ring_regions.size()                                        > 0 &&
+           m_in_flight_ring_regions.front().frame_index + m_n_frames_in_flight <= current_frame_index)
+    {
+        m_in_flight_ring_regions.pop_front();
+    }
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::DrawBatchBuilder> Anvil::DrawBatchBuilder::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                                         uint32_t                         in_n_frames_in_flight,
+                                                                         uint32_t                         in_n_max_draws_in_ring)
+{
+    std::shared_ptr<DrawBatchBuilder> result_ptr;
+
+    anvil_assert(in_n_frames_in_flight  > 0);
+    anvil_assert(in_n_max_draws_in_ring > 0);
+
+    result_ptr.reset(
+        new Anvil::DrawBatchBuilder(in_device_ptr,
+                                    in_n_frames_in_flight,
+                                    in_n_max_draws_in_ring)
+    );
+
+    if (!result_ptr->init() )
+    {
+        result_ptr.reset();
+    }
+
+    return result_ptr;
+}
+
+/** Creates the indirect buffer used as the ring.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::DrawBatchBuilder::init()
+{
+    m_indirect_buffer_ptr = Anvil::Buffer::create_nonsparse(m_device_ptr,
+                                                            sizeof(VkDrawIndexedIndirectCommand) * m_n_max_draws_in_ring,
+                                                            Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                            VK_SHARING_MODE_EXCLUSIVE,
+                                                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                                            true,     /* should_be_mappable */
+                                                            true,     /* should_be_coherent */
+                                                            nullptr); /* opt_client_data    */
+
+    m_sorted_commands.reserve(m_n_max_draws_in_ring);
+
+    return (m_indirect_buffer_ptr != nullptr);
+}
+
+/** Tells whether any part of the specified ring range has been written for a frame, which may still be in flight.
+ *
+ *  @param in_n_first_draw Index of the first draw entry in the range.
+ *  @param in_n_draws      Number of draw entries in the range.
+ *
+ *  @return As per description.
+ **/
+bool Anvil::DrawBatchBuilder::is_ring_range_in_flight(uint32_t in_n_first_draw,
+                                                      uint32_t in_n_draws) const
+{
+    bool result = false;
+
+    for (auto region_iterator  = m_in_flight_ring_regions.cbegin();
+              region_iterator != m_in_flight_ring_regions.cend() && !result;
+            ++region_iterator)
+    {
+        result = (region_iterator->n_first_draw                            < in_n_first_draw + in_n_draws &&
+                  region_iterator->n_first_draw + region_iterator->n_draws > in_n_first_draw);
+    }
+
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::DrawBatchBuilder::record(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                                     PFNDRAWBATCHBUCKETPROC                    in_pfn_bucket_proc,
+                                     void*                                     in_user_arg)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    uint32_t                           max_draw_count;
+    const uint32_t                     n_draws          = static_cast<uint32_t>(m_pending_draws.size() );
+    uint32_t                           n_first_draw;
+    bool                               result           = false;
+    const uint32_t                     stride           = sizeof(VkDrawIndexedIndirectCommand);
+
+    anvil_assert(in_cmd_buffer_ptr  != nullptr);
+    anvil_assert(in_pfn_bucket_proc != nullptr);
+
+    if (n_draws == 0)
+    {
+        result = true;
+
+        goto end;
+    }
+
+    if (n_draws > m_n_max_draws_in_ring)
+    {
+        anvil_assert(n_draws <= m_n_max_draws_in_ring);
+
+        goto end;
+    }
+
+    if (m_n_started_frames == 0)
+    {
+        anvil_assert(m_n_started_frames != 0);
+
+        goto end;
+    }
+
+    /* Allocate a contiguous region of the ring. Wrap around if the region would not fit at the end. The skipped
+     * tail is used again after the next wrap-around. Never overwrite draws the GPU may still read. */
+    n_first_draw = m_n_ring_head_draw;
+
+    if (n_first_draw + n_draws > m_n_max_draws_in_ring)
+    {
+        n_first_draw = 0;
+    }
+
+    if (is_ring_range_in_flight(n_first_draw,
+                                n_draws) )
+    {
+        goto end;
+    }
+
+    /* Without multiDrawIndirect, drawCount must be 0 or 1. */
+    max_draw_count = (device_locked_ptr->get_physical_device_features().multiDrawIndirect == VK_TRUE) ? device_locked_ptr->get_physical_device_properties().limits.maxDrawIndirectCount
+                                                                                                     : 1;
+
+    if (max_draw_count == 0)
+    {
+        max_draw_count = 1;
+    }
+
+    /* Group the draws by state key. Stable sort preserves the order, in which the draws of a single bucket
+     * have been submitted. */
+    std::stable_sort(m_pending_draws.begin(),
+                     m_pending_draws.end() );
+
+    m_sorted_commands.clear();
+
+    for (auto draw_iterator  = m_pending_draws.cbegin();
+              draw_iterator != m_pending_draws.cend();
+            ++draw_iterator)
+    {
+        m_sorted_commands.push_back(draw_iterator->command);
+    }
+
+    if (!m_indirect_buffer_ptr->write(static_cast<VkDeviceSize>(n_first_draw) * stride,
+                                      static_cast<VkDeviceSize>(n_draws)      * stride,
+                                      &m_sorted_commands[0]) )
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    m_in_flight_ring_regions.push_back(RingRegion(m_n_started_frames - 1, /* in_frame_index */
+                                                  n_first_draw,
+                                                  n_draws) );
+
+    m_n_ring_head_draw = n_first_draw + n_draws;
+
+    /* Record the buckets */
+    for (uint32_t n_bucket_start_draw = 0;
+                  n_bucket_start_draw < n_draws;
+                 )
+    {
+        const DrawBatchStateKey bucket_state_key  = m_pending_draws[n_bucket_start_draw].state_key;
+        uint32_t                n_bucket_end_draw = n_bucket_start_draw + 1;
+
+        while (n_bucket_end_draw                             <  n_draws           &&
+               m_pending_draws[n_bucket_end_draw].state_key == bucket_state_key)
+        {
+            ++n_bucket_end_draw;
+        }
+
+        in_pfn_bucket_proc(this,
+                           bucket_state_key,
+                           in_cmd_buffer_ptr,
+                           in_user_arg);
+
+        for (uint32_t n_draw = n_bucket_start_draw;
+                      n_draw < n_bucket_end_draw;
+                      n_draw += max_draw_count)
+        {
+            const uint32_t draw_count = std::min(n_bucket_end_draw - n_draw,
+                                                 max_draw_count);
+
+            in_cmd_buffer_ptr->record_draw_indexed_indirect(m_indirect_buffer_ptr,
+                                                            static_cast<VkDeviceSize>(n_first_draw + n_draw) * stride,
+                                                            draw_count,
+                                                            stride);
+        }
+
+        n_bucket_start_draw = n_bucket_end_draw;
+    }
+
+    result = true;
+end:
+    m_pending_draws.clear();
+
+    return result;
+}
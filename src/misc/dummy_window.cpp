@@ -164,6 +164,9 @@ std::shared_ptr<unsigned char> Anvil::DummyWindowWithPNGSnapshots::get_swapchain
     universal_command_pool_ptr = device_locked_ptr->get_command_pool(Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL);
     command_buffer_ptr         = universal_command_pool_ptr->alloc_primary_level_command_buffer();
 
+    /* The command buffer is only recorded through the wrapper, so its barriers can be batched */
+    command_buffer_ptr->set_pipeline_barrier_batching_enabled(true);
+
     command_buffer_ptr->start_recording(true,   /* one_time_submit          */
                                         false); /* simultaneous_use_allowed */
     {
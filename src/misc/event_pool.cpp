@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "misc/debug.h"
+#include "misc/event_pool.h"
+#include "wrappers/event.h"
+
+
+/** Please see header for specification */
+Anvil::EventPool::EventPool(std::weak_ptr<Anvil::BaseDevice> in_device_ptr)
+    :m_device_ptr      (in_device_ptr),
+     m_n_events_created(0),
+     m_n_events_reused (0)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::EventPool::~EventPool()
+{
+    /* All events handed out by the pool retain it, so all of them have been returned by now. */
+    anvil_assert(m_free_events.size() == m_event_ptrs.size() );
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::EventPool> Anvil::EventPool::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr)
+{
+    std::shared_ptr<Anvil::EventPool> result_ptr;
+
+    result_ptr.reset(
+        new Anvil::EventPool(in_device_ptr)
+    );
+
+    return result_ptr;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::Event> Anvil::EventPool::get_event()
+{
+    Anvil::Event* event_ptr = nullptr;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_free_events.size() == 0)
+        {
+            std::shared_ptr<Anvil::Event> new_event_ptr = Anvil::Event::create(m_device_ptr);
+
+            m_event_ptrs.push_back(new_event_ptr);
+
+            event_ptr = new_event_ptr.get();
+
+            ++m_n_events_created;
+        }
+        else
+        {
+            event_ptr = m_free_events.back();
+
+            m_free_events.pop_back();
+
+            ++m_n_events_reused;
+        }
+    }
+
+    return std::shared_ptr<Anvil::Event>(event_ptr,
+                                         ReturnToPoolFunctor(shared_from_this() ));
+}
+
+/** Resets an event, whose last reference has been dropped, if it has been left signalled, and stores it
+ *  in the free event list.
+ *
+ *  @param in_event_ptr Event to store. Must not be nullptr.
+ **/
+void Anvil::EventPool::return_event(Anvil::Event* in_event_ptr)
+{
+    /* The GPU no longer uses the event, so it can be reset from the host */
+    if (in_event_ptr->is_set() )
+    {
+        const bool reset_result = in_event_ptr->reset();
+
+        anvil_assert(reset_result);
+        ANVIL_REDUNDANT_VARIABLE_CONST(reset_result);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_free_events.push_back(in_event_ptr);
+    }
+}
@@ -0,0 +1,426 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "misc/debug.h"
+#include "misc/fence_completion_service.h"
+#include "wrappers/device.h"
+#include "wrappers/fence.h"
+#include "wrappers/queue.h"
+
+
+/** Please see header for specification */
+Anvil::FenceCompletionService::FenceCompletionService(std::weak_ptr<Anvil::BaseDevice> in_device_ptr)
+    :m_device_ptr                (in_device_ptr),
+     m_device_vk                 (std::shared_ptr<Anvil::BaseDevice>(in_device_ptr)->get_device_vk() ),
+     m_is_waiting                (false),
+     m_is_wake_up_pending        (false),
+     m_is_wake_up_submitted      (false),
+     m_n_pending_continuations   (0),
+     m_n_registered_continuations(0),
+     m_oldest_running_serial     (UINT64_MAX),
+     m_should_stop               (false),
+     m_wait_timeout_ns           (1000000)
+{
+    m_wake_up_fence_ptr = Anvil::Fence::create(in_device_ptr,
+                                               false); /* create_signalled */
+}
+
+/** Please see header for specification */
+Anvil::FenceCompletionService::~FenceCompletionService()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_should_stop = true;
+    }
+
+    m_condition_variable.notify_all();
+
+    /* The thread only quits once all pending continuations have been run */
+    if (m_thread.joinable() )
+    {
+        m_thread.join();
+    }
+
+    anvil_assert(m_continuations.size() == 0);
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::FenceCompletionService> Anvil::FenceCompletionService::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr)
+{
+    std::shared_ptr<Anvil::FenceCompletionService> result_ptr;
+
+    result_ptr.reset(
+        new Anvil::FenceCompletionService(in_device_ptr)
+    );
+
+    return result_ptr;
+}
+
+/** Returns the queue wake-up batches should be submitted to, or nullptr if all queues of the device are
+ *  unsynchronized. Sparse binding queues are not enumerated, since they are also exposed as queues of one of
+ *  the families below.
+ **/
+std::shared_ptr<Anvil::Queue> Anvil::FenceCompletionService::get_wake_up_queue() const
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    std::shared_ptr<Anvil::Queue>      result_ptr;
+
+    for (Anvil::QueueFamilyType queue_family_type  = Anvil::QUEUE_FAMILY_TYPE_FIRST;
+                                queue_family_type <  Anvil::QUEUE_FAMILY_TYPE_COUNT;
+                                queue_family_type  = static_cast<Anvil::QueueFamilyType>(queue_family_type + 1))
+    {
+        const uint32_t n_queues = device_locked_ptr->get_n_queues(queue_family_type);
+
+        for (uint32_t n_queue = 0;
+                      n_queue < n_queues;
+                    ++n_queue)
+        {
+            std::shared_ptr<Anvil::Queue> current_queue_ptr;
+
+            switch (queue_family_type)
+            {
+                case Anvil::QUEUE_FAMILY_TYPE_COMPUTE:   current_queue_ptr = device_locked_ptr->get_compute_queue  (n_queue); break;
+                case Anvil::QUEUE_FAMILY_TYPE_TRANSFER:  current_queue_ptr = device_locked_ptr->get_transfer_queue (n_queue); break;
+                case Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL: current_queue_ptr = device_locked_ptr->get_universal_queue(n_queue); break;
+
+                default:
+                {
+                    anvil_assert(false);
+                }
+            }
+
+            if (current_queue_ptr                        != nullptr &&
+                current_queue_ptr->get_submission_mode() != Anvil::QUEUE_SUBMISSION_MODE_UNSYNCHRONIZED)
+            {
+                result_ptr = current_queue_ptr;
+
+                goto end;
+            }
+        }
+    }
+
+end:
+    return result_ptr;
+}
+
+/** Please see header for specification */
+bool Anvil::FenceCompletionService::register_continuation(std::shared_ptr<Anvil::Fence> in_fence_ptr,
+                                                          PFNFENCECONTINUATIONPROC      in_continuation_ptr,
+                                                          void*                         in_user_arg)
+{
+    Continuation continuation;
+    bool         result = false;
+
+    if (in_continuation_ptr == nullptr)
+    {
+        anvil_assert(in_continuation_ptr != nullptr);
+
+        goto end;
+    }
+
+    continuation.continuation_ptr = in_continuation_ptr;
+    continuation.fence_ptr        = in_fence_ptr;
+    continuation.user_arg         = in_user_arg;
+
+    result = register_continuation_internal(continuation);
+end:
+    return result;
+}
+
+/** Adds a continuation to the list of pending continuations and, if necessary, starts the service's thread.
+ *  If the thread is blocked in vkWaitForFences(), it is woken up by signalling the wake-up fence.
+ *
+ *  @param in_continuation Continuation to register.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::FenceCompletionService::register_continuation_internal(const Continuation& in_continuation)
+{
+    Anvil::QueueSubmitBatch       empty_batch;
+    bool                          should_notify = false;
+    bool                          result        = false;
+    std::shared_ptr<Anvil::Queue> wake_up_queue_ptr;
+
+    if (in_continuation.fence_ptr == nullptr)
+    {
+        anvil_assert(in_continuation.fence_ptr != nullptr);
+
+        goto end;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        anvil_assert(!m_should_stop);
+
+        if (!m_thread.joinable() )
+        {
+            m_thread = std::thread(&Anvil::FenceCompletionService::thread_entrypoint,
+                                   this);
+        }
+
+        /* If other continuations are pending, the thread is either running continuations or blocked in
+         * vkWaitForFences(), and is going to pick the new one up without being notified. */
+        should_notify = (m_continuations.size() == 0);
+
+        m_continuations.push_back(in_continuation);
+
+        m_continuations.back().serial = ++m_n_registered_continuations;
+        ++m_n_pending_continuations;
+
+        /* Only one wake-up can be in flight at a time. Until it is reset, the wake-up fence stays signalled,
+         * so later registrations do not need to submit another one. */
+        if ( m_is_waiting                    &&
+            !m_is_wake_up_pending            &&
+             m_wake_up_queue_ptr != nullptr)
+        {
+            m_is_wake_up_pending = true;
+            wake_up_queue_ptr    = m_wake_up_queue_ptr;
+        }
+    }
+
+    if (should_notify)
+    {
+        m_condition_variable.notify_all();
+    }
+
+    if (wake_up_queue_ptr != nullptr)
+    {
+        wake_up_queue_ptr->submit_batch(&empty_batch,
+                                        false, /* should_block */
+                                        m_wake_up_fence_ptr);
+
+        /* The fence must not be reset until it has been handed over to Vulkan */
+        wake_up_queue_ptr->flush_submissions();
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_is_wake_up_submitted = true;
+        }
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::FenceCompletionService::release_on_completion(std::shared_ptr<Anvil::Fence> in_fence_ptr,
+                                                          std::shared_ptr<void>         in_object_ptr)
+{
+    Continuation continuation;
+    bool         result = false;
+
+    if (in_object_ptr == nullptr)
+    {
+        anvil_assert(in_object_ptr != nullptr);
+
+        goto end;
+    }
+
+    continuation.fence_ptr  = in_fence_ptr;
+    continuation.object_ptr = in_object_ptr;
+
+    result = register_continuation_internal(continuation);
+end:
+    return result;
+}
+
+/** Entry-point of the service's thread. Waits on all pending fences and the wake-up fence at once, and runs
+ *  continuations of the fences which have signalled. Quits once the service is being destroyed and no
+ *  continuations are pending.
+ **/
+void Anvil::FenceCompletionService::thread_entrypoint()
+{
+    std::vector<Continuation>    completed_continuations;
+    std::vector<VkFence>         fences_vk;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        VkResult result_vk;
+        uint64_t timeout_ns;
+
+        while (m_continuations.size() == 0 &&
+              !m_should_stop)
+        {
+            m_condition_variable.wait(lock);
+        }
+
+        if (m_is_wake_up_submitted          &&
+            m_wake_up_fence_ptr->is_set() )
+        {
+            const bool reset_result = m_wake_up_fence_ptr->reset();
+
+            anvil_assert(reset_result);
+            ANVIL_REDUNDANT_VARIABLE_CONST(reset_result);
+
+            m_is_wake_up_pending   = false;
+            m_is_wake_up_submitted = false;
+        }
+
+        if (m_continuations.size() == 0 &&
+           !m_is_wake_up_pending)
+        {
+            /* The service is being destroyed */
+            break;
+        }
+
+        /* The wake-up fence is part of the wait set whenever a registration may signal it during the wait.
+         * A wake-up which is still pending must be waited on, too, before the fence can be reset. */
+        m_wake_up_queue_ptr = get_wake_up_queue();
+        timeout_ns          = (m_wake_up_queue_ptr != nullptr) ? UINT64_MAX
+                                                               : m_wait_timeout_ns.load();
+
+        fences_vk.clear();
+
+        if (m_wake_up_queue_ptr != nullptr ||
+            m_is_wake_up_pending)
+        {
+            fences_vk.push_back(m_wake_up_fence_ptr->get_fence() );
+        }
+
+        for (auto continuation_iterator  = m_continuations.begin();
+                  continuation_iterator != m_continuations.end();
+                ++continuation_iterator)
+        {
+            const VkFence fence_vk = continuation_iterator->fence_ptr->get_fence();
+
+            /* Continuations registered for the same fence tend to be adjacent */
+            if (fences_vk.size() == 0       ||
+                fences_vk.back() != fence_vk)
+            {
+                fences_vk.push_back(fence_vk);
+            }
+        }
+
+        /* Do not block registrations while waiting */
+        m_is_waiting = true;
+
+        lock.unlock();
+        {
+            result_vk = vkWaitForFences(m_device_vk,
+                                        static_cast<uint32_t>(fences_vk.size() ),
+                                       &fences_vk[0],
+                                        VK_FALSE, /* waitAll */
+                                        timeout_ns);
+        }
+        lock.lock();
+
+        m_is_waiting = false;
+        m_wake_up_queue_ptr.reset();
+
+        if (result_vk == VK_TIMEOUT)
+        {
+            continue;
+        }
+
+        /* Move continuations of all signalled fences out of the pending list, preserving the order. If the
+         * wait failed (eg. due to a device loss), none of the fences is ever going to signal, so all
+         * continuations are run. */
+        {
+            uint32_t n_pending_continuations = 0;
+
+            for (uint32_t n_continuation = 0;
+                          n_continuation < static_cast<uint32_t>(m_continuations.size() );
+                        ++n_continuation)
+            {
+                Continuation& continuation = m_continuations[n_continuation];
+
+                if (!is_vk_call_successful(result_vk)                                             ||
+                    vkGetFenceStatus(m_device_vk, continuation.fence_ptr->get_fence() ) != VK_NOT_READY)
+                {
+                    completed_continuations.push_back(continuation);
+                }
+                else
+                {
+                    if (n_continuation != n_pending_continuations)
+                    {
+                        m_continuations[n_pending_continuations] = continuation;
+                    }
+
+                    ++n_pending_continuations;
+                }
+            }
+
+            m_continuations.resize(n_pending_continuations);
+
+            /* A wake-up fence is not going to signal after a failed wait, either */
+            if (!is_vk_call_successful(result_vk) &&
+                 m_is_wake_up_submitted)
+            {
+                m_is_wake_up_pending   = false;
+                m_is_wake_up_submitted = false;
+            }
+        }
+
+        anvil_assert_vk_call_succeeded(result_vk);
+
+        if (completed_continuations.size() == 0)
+        {
+            continue;
+        }
+
+        m_oldest_running_serial = completed_continuations.front().serial;
+
+        /* Continuations may register further continuations, so they must be run without the lock held */
+        lock.unlock();
+        {
+            for (auto continuation_iterator  = completed_continuations.begin();
+                      continuation_iterator != completed_continuations.end();
+                    ++continuation_iterator)
+            {
+                if (continuation_iterator->continuation_ptr != nullptr)
+                {
+                    continuation_iterator->continuation_ptr(continuation_iterator->user_arg);
+                }
+            }
+
+            m_n_pending_continuations -= static_cast<uint32_t>(completed_continuations.size() );
+
+            /* Drops the fences and the retained objects */
+            completed_continuations.clear();
+        }
+        lock.lock();
+
+        m_oldest_running_serial = UINT64_MAX;
+
+        m_condition_variable.notify_all();
+    }
+}
+
+/** Please see header for specification */
+void Anvil::FenceCompletionService::wait_idle()
+{
+    std::unique_lock<std::mutex> lock        (m_mutex);
+    const uint64_t               last_serial (m_n_registered_continuations);
+
+    anvil_assert(std::this_thread::get_id() != m_thread.get_id() );
+
+    /* Pending continuations are kept in registration order, so it is enough to check the oldest one */
+    while ((m_continuations.size() > 0 && m_continuations.front().serial <= last_serial) ||
+           m_oldest_running_serial <= last_serial)
+    {
+        m_condition_variable.wait(lock);
+    }
+}
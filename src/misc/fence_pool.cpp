@@ -0,0 +1,170 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "misc/debug.h"
+#include "misc/fence_pool.h"
+#include "wrappers/fence.h"
+
+
+/** Please see header for specification */
+Anvil::FencePool::FencePool(std::weak_ptr<Anvil::BaseDevice> in_device_ptr)
+    :m_device_ptr      (in_device_ptr),
+     m_n_fences_created(0),
+     m_n_fences_reused (0)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::FencePool::~FencePool()
+{
+    /* All fences handed out by the pool retain it, so all of them have been returned by now. */
+    anvil_assert(m_free_fences.size() + m_returned_fences.size() == m_fence_ptrs.size() );
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::FencePool> Anvil::FencePool::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                           uint32_t                         in_n_fences_to_preallocate)
+{
+    std::shared_ptr<Anvil::FencePool> result_ptr;
+
+    result_ptr.reset(
+        new Anvil::FencePool(in_device_ptr)
+    );
+
+    for (uint32_t n_fence = 0;
+                  n_fence < in_n_fences_to_preallocate;
+                ++n_fence)
+    {
+        result_ptr->create_fence();
+    }
+
+    return result_ptr;
+}
+
+/** Creates a new unsignalled fence and stores it in the free fence list.
+ *
+ *  The caller must own the pool's mutex, unless the pool has not been handed out yet.
+ **/
+void Anvil::FencePool::create_fence()
+{
+    std::shared_ptr<Anvil::Fence> new_fence_ptr = Anvil::Fence::create(m_device_ptr,
+                                                                       false); /* create_signalled */
+
+    m_fence_ptrs.push_back (new_fence_ptr);
+    m_free_fences.push_back(new_fence_ptr.get() );
+
+    ++m_n_fences_created;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::Fence> Anvil::FencePool::get_fence()
+{
+    Anvil::Fence* fence_ptr = nullptr;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_free_fences.size() == 0)
+        {
+            recycle_fences();
+        }
+
+        if (m_free_fences.size() == 0)
+        {
+            create_fence();
+        }
+        else
+        {
+            ++m_n_fences_reused;
+        }
+
+        fence_ptr = m_free_fences.back();
+
+        m_free_fences.pop_back();
+    }
+
+    return std::shared_ptr<Anvil::Fence>(fence_ptr,
+                                         ReturnToPoolFunctor(shared_from_this() ));
+}
+
+/** Moves returned fences, which have been signalled, to the free fence list. The fences are reset
+ *  with a single batched call.
+ *
+ *  The caller must own the pool's mutex.
+ **/
+void Anvil::FencePool::recycle_fences()
+{
+    uint32_t n_still_returned_fences = 0;
+
+    for (uint32_t n_returned_fence = 0;
+                  n_returned_fence < static_cast<uint32_t>(m_returned_fences.size() );
+                ++n_returned_fence)
+    {
+        Anvil::Fence* fence_ptr = m_returned_fences[n_returned_fence];
+
+        if (fence_ptr->is_set() )
+        {
+            m_fences_to_reset.push_back(fence_ptr);
+        }
+        else
+        {
+            /* The fence may still be in flight. */
+            m_returned_fences[n_still_returned_fences++] = fence_ptr;
+        }
+    }
+
+    m_returned_fences.resize(n_still_returned_fences);
+
+    if (m_fences_to_reset.size() > 0)
+    {
+        const bool reset_result = Anvil::Fence::reset_fences(static_cast<uint32_t>(m_fences_to_reset.size() ),
+                                                            &m_fences_to_reset[0]);
+
+        anvil_assert(reset_result);
+        ANVIL_REDUNDANT_VARIABLE_CONST(reset_result);
+
+        m_free_fences.insert(m_free_fences.end(),
+                             m_fences_to_reset.begin(),
+                             m_fences_to_reset.end() );
+        m_fences_to_reset.clear();
+    }
+}
+
+/** Stores a fence, whose last reference has been dropped, in the returned fence list. Fences which
+ *  have never been submitted are still unsignalled, so they go straight back to the free fence list.
+ *
+ *  @param in_fence_ptr Fence to store. Must not be nullptr.
+ **/
+void Anvil::FencePool::return_fence(Anvil::Fence* in_fence_ptr)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (in_fence_ptr->is_possibly_set() )
+    {
+        m_returned_fences.push_back(in_fence_ptr);
+    }
+    else
+    {
+        m_free_fences.push_back(in_fence_ptr);
+    }
+}
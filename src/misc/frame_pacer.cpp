@@ -0,0 +1,393 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
+#include "misc/frame_pacer.h"
+#include "wrappers/buffer.h"
+#include "wrappers/command_pool.h"
+#include "wrappers/device.h"
+#include "wrappers/fence.h"
+#include "wrappers/memory_block.h"
+#include "wrappers/queue.h"
+#include "wrappers/semaphore.h"
+#include "wrappers/swapchain.h"
+
+
+/** Please see header for specification */
+Anvil::FramePacer::FramePacer(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
+                              std::shared_ptr<Anvil::Swapchain> in_opt_swapchain_ptr,
+                              uint32_t                          in_n_frames_in_flight,
+                              VkDeviceSize                      in_ring_buffer_size_per_frame)
+    :m_device_ptr                (in_device_ptr),
+     m_is_frame_active           (false),
+     m_last_present_result       (VK_SUCCESS),
+     m_mapped_ring_buffer_ptr    (nullptr),
+     m_n_current_frame_slot      (in_n_frames_in_flight - 1),
+     m_n_frames_in_flight        (in_n_frames_in_flight),
+     m_n_max_frames_in_flight    (in_n_frames_in_flight),
+     m_n_started_frames          (0),
+     m_ring_buffer_size_per_frame(in_ring_buffer_size_per_frame),
+     m_swapchain_ptr             (in_opt_swapchain_ptr),
+     m_swapchain_image_index     (UINT32_MAX)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::FramePacer::~FramePacer()
+{
+    anvil_assert(!m_is_frame_active);
+
+    /* Frame slot resources must not be released while the GPU may still use them */
+    for (uint32_t n_frame_slot = 0;
+                  n_frame_slot < m_n_frames_in_flight;
+                ++n_frame_slot)
+    {
+        wait_for_frame(n_frame_slot);
+    }
+
+    if (m_mapped_ring_buffer_ptr != nullptr)
+    {
+        m_ring_buffer_ptr->get_memory_block(0)->unmap();
+
+        m_mapped_ring_buffer_ptr = nullptr;
+    }
+}
+
+/** Please see header for specification */
+bool Anvil::FramePacer::allocate_ring_memory(VkDeviceSize  in_size,
+                                             VkDeviceSize  in_alignment,
+                                             VkDeviceSize* out_offset_ptr,
+                                             void**        out_opt_mapped_ptr)
+{
+    FrameSlot&         frame_slot = m_frame_slots[m_n_current_frame_slot];
+    VkDeviceSize       offset     = 0;
+    bool               result     = false;
+    const VkDeviceSize slot_start = m_ring_buffer_size_per_frame * m_n_current_frame_slot;
+
+    anvil_assert(m_is_frame_active);
+    anvil_assert(in_alignment > 0 && (in_alignment & (in_alignment - 1)) == 0);
+
+    if (m_ring_buffer_ptr == nullptr)
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    /* Slot regions start at offsets which are multiples of 256, so aligning the offset relative to the
+     * slot's start is enough for all alignments up to 256. */
+    anvil_assert(in_alignment <= 256);
+
+    offset = (frame_slot.n_ring_bytes_used + in_alignment - 1) & ~(in_alignment - 1);
+
+    if (offset + in_size > m_ring_buffer_size_per_frame)
+    {
+        goto end;
+    }
+
+    frame_slot.n_ring_bytes_used = offset + in_size;
+    *out_offset_ptr              = slot_start + offset;
+
+    if (out_opt_mapped_ptr != nullptr)
+    {
+        *out_opt_mapped_ptr = m_mapped_ring_buffer_ptr + slot_start + offset;
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::FramePacer::begin_frame()
+{
+    FrameSlot* frame_slot_ptr    = nullptr;
+    uint32_t   n_frame_slot_wait = 0;
+    bool       result            = false;
+
+    anvil_assert(!m_is_frame_active);
+
+    m_n_current_frame_slot = (m_n_current_frame_slot + 1) % m_n_frames_in_flight;
+    frame_slot_ptr         = &m_frame_slots[m_n_current_frame_slot];
+
+    /* Block until frame (N - k) finishes executing. Frames finish executing in the order they were submitted
+     * in, so this also guarantees that frame (N - n_frames_in_flight), which has last used this frame slot,
+     * has finished executing. */
+    n_frame_slot_wait = (m_n_current_frame_slot + m_n_frames_in_flight - m_n_max_frames_in_flight) % m_n_frames_in_flight;
+
+    if (!wait_for_frame(n_frame_slot_wait) ||
+        !wait_for_frame(m_n_current_frame_slot) )
+    {
+        goto end;
+    }
+
+    if (frame_slot_ptr->has_been_submitted)
+    {
+        if (!frame_slot_ptr->fence_ptr->reset() )
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        frame_slot_ptr->has_been_submitted = false;
+    }
+
+    if (!frame_slot_ptr->command_pool_ptr->reset(false) ) /* release_resources */
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    if (m_swapchain_ptr != nullptr)
+    {
+        m_swapchain_image_index = m_swapchain_ptr->acquire_image_by_setting_semaphore(frame_slot_ptr->acquire_semaphore_ptr);
+
+        if (m_swapchain_image_index == UINT32_MAX)
+        {
+            goto end;
+        }
+    }
+
+    frame_slot_ptr->frame_index       = m_n_started_frames++;
+    frame_slot_ptr->n_ring_bytes_used = 0;
+    m_is_frame_active                 = true;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::FramePacer> Anvil::FramePacer::create(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
+                                                             std::shared_ptr<Anvil::Swapchain> in_opt_swapchain_ptr,
+                                                             uint32_t                          in_n_frames_in_flight,
+                                                             VkDeviceSize                      in_ring_buffer_size_per_frame,
+                                                             VkBufferUsageFlags                in_ring_buffer_usage_flags)
+{
+    std::shared_ptr<Anvil::FramePacer> result_ptr;
+
+    if (in_n_frames_in_flight == 0)
+    {
+        anvil_assert(in_n_frames_in_flight > 0);
+
+        goto end;
+    }
+
+    result_ptr.reset(
+        new Anvil::FramePacer(in_device_ptr,
+                              in_opt_swapchain_ptr,
+                              in_n_frames_in_flight,
+                              (in_ring_buffer_size_per_frame + 255) & ~static_cast<VkDeviceSize>(255) )
+    );
+
+    if (!result_ptr->init(in_ring_buffer_usage_flags) )
+    {
+        result_ptr.reset();
+    }
+
+end:
+    return result_ptr;
+}
+
+/** Please see header for specification */
+bool Anvil::FramePacer::end_frame(uint32_t                                         in_n_cmd_buffers,
+                                  std::shared_ptr<Anvil::CommandBufferBase> const* in_opt_cmd_buffer_ptrs,
+                                  VkPipelineStageFlags                             in_acquire_wait_stage_mask)
+{
+    std::shared_ptr<Anvil::BaseDevice>            device_locked_ptr         (m_device_ptr);
+    std::shared_ptr<Anvil::DeferredDeletionQueue> deferred_deletion_queue_ptr(device_locked_ptr->get_deferred_deletion_queue() );
+    FrameSlot&                                    frame_slot                (m_frame_slots[m_n_current_frame_slot]);
+    std::shared_ptr<Anvil::Queue>                 queue_ptr                 (device_locked_ptr->get_universal_queue(0) );
+    bool                                          result                    (false);
+
+    anvil_assert(m_is_frame_active);
+
+    if (m_swapchain_ptr != nullptr)
+    {
+        queue_ptr->submit_command_buffers(in_n_cmd_buffers,
+                                          in_opt_cmd_buffer_ptrs,
+                                          1, /* n_semaphores_to_signal */
+                                         &frame_slot.present_semaphore_ptr,
+                                          1, /* n_semaphores_to_wait_on */
+                                         &frame_slot.acquire_semaphore_ptr,
+                                         &in_acquire_wait_stage_mask,
+                                          false, /* should_block */
+                                          frame_slot.fence_ptr);
+
+        m_last_present_result = queue_ptr->present(m_swapchain_ptr,
+                                                   m_swapchain_image_index,
+                                                   1, /* n_wait_semaphores */
+                                                  &frame_slot.present_semaphore_ptr);
+    }
+    else
+    {
+        queue_ptr->submit_command_buffers(in_n_cmd_buffers,
+                                          in_opt_cmd_buffer_ptrs,
+                                          0,       /* n_semaphores_to_signal           */
+                                          nullptr, /* opt_semaphore_to_signal_ptr_ptrs */
+                                          0,       /* n_semaphores_to_wait_on          */
+                                          nullptr, /* opt_semaphore_to_wait_on_ptr_ptrs */
+                                          nullptr, /* opt_dst_stage_masks_to_wait_on_ptrs */
+                                          false,   /* should_block */
+                                          frame_slot.fence_ptr);
+    }
+
+    frame_slot.has_been_submitted = true;
+    m_is_frame_active             = false;
+
+    if (deferred_deletion_queue_ptr != nullptr &&
+        deferred_deletion_queue_ptr->is_enabled() )
+    {
+        deferred_deletion_queue_ptr->end_serial();
+    }
+
+    result = is_vk_call_successful(m_last_present_result);
+    return result;
+}
+
+/** Creates resources of all frame slots and, if requested, the persistently mapped ring buffer.
+ *
+ *  @param in_ring_buffer_usage_flags Please see create() for specification.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::FramePacer::init(VkBufferUsageFlags in_ring_buffer_usage_flags)
+{
+    bool result = false;
+
+    m_frame_slots.resize(m_n_frames_in_flight);
+
+    for (auto frame_slot_iterator  = m_frame_slots.begin();
+              frame_slot_iterator != m_frame_slots.end();
+            ++frame_slot_iterator)
+    {
+        frame_slot_iterator->acquire_semaphore_ptr = Anvil::Semaphore::create  (m_device_ptr);
+        frame_slot_iterator->command_pool_ptr      = Anvil::CommandPool::create(m_device_ptr,
+                                                                                true,  /* transient_allocations_friendly */
+                                                                                false, /* support_per_cmdbuf_reset_ops   */
+                                                                                Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL);
+        frame_slot_iterator->fence_ptr             = Anvil::Fence::create      (m_device_ptr,
+                                                                                false); /* create_signalled */
+        frame_slot_iterator->present_semaphore_ptr = Anvil::Semaphore::create  (m_device_ptr);
+
+        if (frame_slot_iterator->acquire_semaphore_ptr == nullptr ||
+            frame_slot_iterator->command_pool_ptr      == nullptr ||
+            frame_slot_iterator->fence_ptr             == nullptr ||
+            frame_slot_iterator->present_semaphore_ptr == nullptr)
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+    }
+
+    if (m_ring_buffer_size_per_frame > 0)
+    {
+        const VkDeviceSize buffer_size = m_ring_buffer_size_per_frame * m_n_frames_in_flight;
+        void*              mapped_ptr  = nullptr;
+
+        m_ring_buffer_ptr = Anvil::Buffer::create_nonsparse(m_device_ptr,
+                                                            buffer_size,
+                                                            Anvil::QUEUE_FAMILY_COMPUTE_BIT | Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                            VK_SHARING_MODE_EXCLUSIVE,
+                                                            in_ring_buffer_usage_flags,
+                                                            true,     /* should_be_mappable */
+                                                            true,     /* should_be_coherent */
+                                                            nullptr); /* opt_client_data    */
+
+        if (m_ring_buffer_ptr == nullptr)
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        if (!m_ring_buffer_ptr->get_memory_block(0)->map(m_ring_buffer_ptr->get_start_offset(),
+                                                         buffer_size,
+                                                        &mapped_ptr) )
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        m_mapped_ring_buffer_ptr = static_cast<uint8_t*>(mapped_ptr);
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+void Anvil::FramePacer::set_n_max_frames_in_flight(uint32_t in_n_max_frames_in_flight)
+{
+    anvil_assert(in_n_max_frames_in_flight >= 1 &&
+                 in_n_max_frames_in_flight <= m_n_frames_in_flight);
+
+    if (in_n_max_frames_in_flight < 1)
+    {
+        in_n_max_frames_in_flight = 1;
+    }
+    else
+    if (in_n_max_frames_in_flight > m_n_frames_in_flight)
+    {
+        in_n_max_frames_in_flight = m_n_frames_in_flight;
+    }
+
+    m_n_max_frames_in_flight = in_n_max_frames_in_flight;
+}
+
+/** Blocks until the frame, which has last used the specified frame slot, finishes executing.
+ *  Returns immediately if the slot has not been submitted since its fence was last reset.
+ *
+ *  @param in_n_frame_slot Index of the frame slot to wait on.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::FramePacer::wait_for_frame(uint32_t in_n_frame_slot)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    FrameSlot&                         frame_slot       (m_frame_slots[in_n_frame_slot]);
+    bool                               result           (true);
+    VkResult                           result_vk;
+
+    if (!frame_slot.has_been_submitted)
+    {
+        goto end;
+    }
+
+    result_vk = vkWaitForFences(device_locked_ptr->get_device_vk(),
+                                1, /* fenceCount */
+                                frame_slot.fence_ptr->get_fence_ptr(),
+                                VK_TRUE,     /* waitAll */
+                                UINT64_MAX); /* timeout */
+
+    anvil_assert_vk_call_succeeded(result_vk);
+
+    result = is_vk_call_successful(result_vk);
+end:
+    return result;
+}
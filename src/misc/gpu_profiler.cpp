@@ -0,0 +1,433 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "misc/debug.h"
+#include "misc/gpu_profiler.h"
+#include "misc/io.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/device.h"
+#include "wrappers/query_pool.h"
+#include <algorithm>
+#include <sstream>
+
+
+/** Please see header for specification */
+Anvil::GPUProfiler::GPUProfiler(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                uint32_t                         in_n_frames_in_flight,
+                                uint32_t                         in_n_max_zones_per_frame,
+                                uint32_t                         in_n_max_trace_events)
+    :m_device_ptr              (in_device_ptr),
+     m_is_frame_active         (false),
+     m_n_current_frame_slot    (in_n_frames_in_flight - 1),
+     m_n_dropped_frames        (0),
+     m_n_frames_in_flight      (in_n_frames_in_flight),
+     m_n_max_trace_events      (in_n_max_trace_events),
+     m_n_max_zones_per_frame   (in_n_max_zones_per_frame),
+     m_n_next_trace_event      (0),
+     m_n_resolved_frames       (0),
+     m_timestamp_period_ns     (1.0),
+     m_trace_base_timestamp_set(false),
+     m_trace_base_timestamp    (0)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::GPUProfiler::~GPUProfiler()
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+bool Anvil::GPUProfiler::begin_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr)
+{
+    FrameSlot* frame_slot_ptr = nullptr;
+    bool       result         = false;
+
+    anvil_assert(!m_is_frame_active);
+    anvil_assert(m_open_zones.size() == 0);
+
+    m_n_current_frame_slot = (m_n_current_frame_slot + 1) % m_n_frames_in_flight;
+    frame_slot_ptr         = &m_frame_slots[m_n_current_frame_slot];
+
+    if (frame_slot_ptr->has_pending_results)
+    {
+        resolve_frame(frame_slot_ptr);
+    }
+
+    frame_slot_ptr->n_zones = 0;
+
+    if (!in_cmd_buffer_ptr->record_reset_query_pool(frame_slot_ptr->query_pool_ptr,
+                                                    0, /* in_start_query */
+                                                    frame_slot_ptr->query_pool_ptr->get_capacity() ))
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    m_is_frame_active = true;
+    result            = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::GPUProfiler::begin_zone(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                                    const char*                               in_name)
+{
+    FrameSlot* frame_slot_ptr = &m_frame_slots[m_n_current_frame_slot];
+    uint32_t   n_zone         = UINT32_MAX;
+    bool       result         = false;
+
+    anvil_assert(m_is_frame_active);
+
+    if (!m_is_frame_active                                  ||
+         frame_slot_ptr->n_zones >= m_n_max_zones_per_frame)
+    {
+        goto end;
+    }
+
+    if (!in_cmd_buffer_ptr->record_write_timestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                                   frame_slot_ptr->query_pool_ptr,
+                                                   frame_slot_ptr->n_zones * 2) )
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    n_zone = frame_slot_ptr->n_zones++;
+
+    if (n_zone == frame_slot_ptr->zone_names.size() )
+    {
+        frame_slot_ptr->zone_names.push_back(in_name);
+    }
+    else
+    {
+        frame_slot_ptr->zone_names[n_zone].assign(in_name);
+    }
+
+    result = true;
+end:
+    /* Ignored zones are pushed too, so that end_zone() calls always match begin_zone() calls. */
+    m_open_zones.push_back(n_zone);
+
+    return result;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::GPUProfiler> Anvil::GPUProfiler::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                               uint32_t                         in_n_frames_in_flight,
+                                                               uint32_t                         in_n_max_zones_per_frame,
+                                                               uint32_t                         in_n_max_trace_events)
+{
+    std::shared_ptr<GPUProfiler> result_ptr;
+
+    anvil_assert(in_n_frames_in_flight    > 0);
+    anvil_assert(in_n_max_zones_per_frame > 0);
+
+    result_ptr.reset(
+        new Anvil::GPUProfiler(in_device_ptr,
+                               in_n_frames_in_flight,
+                               in_n_max_zones_per_frame,
+                               in_n_max_trace_events)
+    );
+
+    if (!result_ptr->init() )
+    {
+        result_ptr.reset();
+    }
+
+    return result_ptr;
+}
+
+/** Please see header for specification */
+void Anvil::GPUProfiler::end_frame()
+{
+    FrameSlot* frame_slot_ptr = &m_frame_slots[m_n_current_frame_slot];
+
+    anvil_assert(m_is_frame_active);
+    anvil_assert(m_open_zones.size() == 0);
+
+    frame_slot_ptr->has_pending_results = (frame_slot_ptr->n_zones > 0);
+    m_is_frame_active                   = false;
+}
+
+/** Please see header for specification */
+bool Anvil::GPUProfiler::end_zone(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr)
+{
+    FrameSlot* frame_slot_ptr = &m_frame_slots[m_n_current_frame_slot];
+    uint32_t   n_zone;
+    bool       result         = false;
+
+    anvil_assert(m_open_zones.size() > 0);
+
+    if (m_open_zones.size() == 0)
+    {
+        goto end;
+    }
+
+    n_zone = m_open_zones.back();
+
+    m_open_zones.pop_back();
+
+    if (n_zone == UINT32_MAX)
+    {
+        /* The zone has been ignored */
+        goto end;
+    }
+
+    if (!in_cmd_buffer_ptr->record_write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                                   frame_slot_ptr->query_pool_ptr,
+                                                   n_zone * 2 + 1) )
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+std::string Anvil::GPUProfiler::get_chrome_trace() const
+{
+    const uint32_t    n_events           = static_cast<uint32_t>(m_trace_events.size() );
+    const uint32_t    n_first_event      = (n_events == m_n_max_trace_events) ? m_n_next_trace_event : 0;
+    std::stringstream result_sstream;
+
+    result_sstream.setf(std::ios::fixed);
+    result_sstream.precision(3);
+
+    result_sstream << "{\"traceEvents\":[";
+
+    for (uint32_t n_event = 0;
+                  n_event < n_events;
+                ++n_event)
+    {
+        const TraceEvent& event = m_trace_events[(n_first_event + n_event) % n_events];
+
+        if (n_event > 0)
+        {
+            result_sstream << ",";
+        }
+
+        result_sstream << "\n{\"name\":\"";
+
+        for (auto char_iterator  = event.name_ptr->cbegin();
+                  char_iterator != event.name_ptr->cend();
+                ++char_iterator)
+        {
+            if (*char_iterator == '"' ||
+                *char_iterator == '\\')
+            {
+                result_sstream << '\\';
+            }
+
+            if (static_cast<unsigned char>(*char_iterator) >= 0x20)
+            {
+                result_sstream << *char_iterator;
+            }
+        }
+
+        result_sstream << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+                       << "\"ts\":"  << event.start_us    << ","
+                       << "\"dur\":" << event.duration_us << "}";
+    }
+
+    result_sstream << "\n]}\n";
+
+    return result_sstream.str();
+}
+
+/** Please see header for specification */
+bool Anvil::GPUProfiler::get_zone_stats(const std::string&    in_name,
+                                        GPUProfilerZoneStats* out_stats_ptr) const
+{
+    auto stats_iterator = m_zone_stats.find(in_name);
+    bool result         = false;
+
+    if (stats_iterator != m_zone_stats.end() )
+    {
+        *out_stats_ptr = stats_iterator->second;
+        result         = true;
+    }
+
+    return result;
+}
+
+/** Creates query pools for all frames in flight.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::GPUProfiler::init()
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    bool                               result           = false;
+
+    m_timestamp_period_ns = static_cast<double>(device_locked_ptr->get_physical_device_properties().limits.timestampPeriod);
+
+    m_frame_slots.resize(m_n_frames_in_flight);
+
+    for (auto frame_slot_iterator  = m_frame_slots.begin();
+              frame_slot_iterator != m_frame_slots.end();
+            ++frame_slot_iterator)
+    {
+        frame_slot_iterator->query_pool_ptr = Anvil::QueryPool::create_non_ps_query_pool(m_device_ptr,
+                                                                                          VK_QUERY_TYPE_TIMESTAMP,
+                                                                                          m_n_max_zones_per_frame * 2);
+
+        if (frame_slot_iterator->query_pool_ptr                    == nullptr ||
+            frame_slot_iterator->query_pool_ptr->get_query_pool() == VK_NULL_HANDLE)
+        {
+            goto end;
+        }
+
+        frame_slot_iterator->zone_names.reserve(m_n_max_zones_per_frame);
+    }
+
+    /* Each query result is followed by its availability value */
+    m_query_results.resize(m_n_max_zones_per_frame * 2 /* timestamps */ * 2 /* value + availability */);
+    m_open_zones.reserve  (m_n_max_zones_per_frame);
+    m_trace_events.reserve(m_n_max_trace_events);
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+void Anvil::GPUProfiler::reset_stats()
+{
+    m_n_dropped_frames         = 0;
+    m_n_next_trace_event       = 0;
+    m_n_resolved_frames        = 0;
+    m_trace_base_timestamp_set = false;
+
+    m_trace_events.clear();
+    m_zone_stats.clear  ();
+}
+
+/** Reads back the timestamps written by the frame which last used the specified frame slot, and updates
+ *  zone statistics and trace events.
+ *
+ *  Does not wait for the results. If any of them is not available, the frame is counted as dropped.
+ *
+ *  @param in_frame_slot_ptr Frame slot to process. Must not be nullptr.
+ **/
+void Anvil::GPUProfiler::resolve_frame(FrameSlot* in_frame_slot_ptr)
+{
+    bool         are_all_results_available = false;
+    const double ns_to_ms                  = 1.0 / 1000000.0;
+
+    in_frame_slot_ptr->has_pending_results = false;
+
+    if (!in_frame_slot_ptr->query_pool_ptr->get_results(0, /* in_first_query */
+                                                        in_frame_slot_ptr->n_zones * 2,
+                                                        VK_QUERY_RESULT_WITH_AVAILABILITY_BIT,
+                                                        static_cast<uint32_t>(m_query_results.size() ),
+                                                       &m_query_results[0],
+                                                       &are_all_results_available) ||
+        !are_all_results_available)
+    {
+        ++m_n_dropped_frames;
+
+        return;
+    }
+
+    for (uint32_t n_zone = 0;
+                  n_zone < in_frame_slot_ptr->n_zones;
+                ++n_zone)
+    {
+        const uint64_t* zone_results_ptr = &m_query_results[n_zone * 4];
+        const uint64_t  begin_timestamp  = zone_results_ptr[0];
+        const uint64_t  end_timestamp    = zone_results_ptr[2];
+        double          time_ms;
+
+        if (zone_results_ptr[1] == 0              ||
+            zone_results_ptr[3] == 0              ||
+            end_timestamp        < begin_timestamp)
+        {
+            continue;
+        }
+
+        time_ms = static_cast<double>(end_timestamp - begin_timestamp) * m_timestamp_period_ns * ns_to_ms;
+
+        /* Update the statistics */
+        auto stats_iterator = m_zone_stats.find(in_frame_slot_ptr->zone_names[n_zone]);
+
+        if (stats_iterator == m_zone_stats.end() )
+        {
+            stats_iterator = m_zone_stats.insert(std::make_pair(in_frame_slot_ptr->zone_names[n_zone],
+                                                                GPUProfilerZoneStats() )).first;
+        }
+
+        GPUProfilerZoneStats& stats = stats_iterator->second;
+
+        stats.last_time_ms   = time_ms;
+        stats.max_time_ms    = (stats.n_samples > 0) ? std::max(stats.max_time_ms, time_ms) : time_ms;
+        stats.min_time_ms    = (stats.n_samples > 0) ? std::min(stats.min_time_ms, time_ms) : time_ms;
+        stats.total_time_ms += time_ms;
+
+        ++stats.n_samples;
+
+        /* Store the trace event. Once the limit is reached, the oldest event is overwritten. */
+        if (m_n_max_trace_events > 0)
+        {
+            TraceEvent event;
+
+            if (!m_trace_base_timestamp_set)
+            {
+                m_trace_base_timestamp     = begin_timestamp;
+                m_trace_base_timestamp_set = true;
+            }
+
+            event.duration_us = time_ms * 1000.0;
+            event.name_ptr    = &stats_iterator->first;
+            event.start_us    = (begin_timestamp >= m_trace_base_timestamp) ? static_cast<double>(begin_timestamp - m_trace_base_timestamp) * m_timestamp_period_ns / 1000.0
+                                                                            : 0.0;
+
+            if (m_trace_events.size() < m_n_max_trace_events)
+            {
+                m_trace_events.push_back(event);
+            }
+            else
+            {
+                m_trace_events[m_n_next_trace_event] = event;
+            }
+
+            m_n_next_trace_event = (m_n_next_trace_event + 1) % m_n_max_trace_events;
+        }
+    }
+
+    ++m_n_resolved_frames;
+}
+
+/** Please see header for specification */
+void Anvil::GPUProfiler::write_chrome_trace(const std::string& in_filename) const
+{
+    Anvil::IO::write_text_file(in_filename,
+                               get_chrome_trace() );
+}
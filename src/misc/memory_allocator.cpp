@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/fence_pool.h"
 #include "misc/formats.h"
 #include "misc/memory_allocator.h"
 #include "wrappers/buffer.h"
@@ -434,6 +435,54 @@ end:
     return result;
 }
 
+/** Please see header for specification */
+bool Anvil::MemoryAllocator::add_transient_buffer(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                                  uint32_t                       in_first_use,
+                                                  uint32_t                       in_last_use,
+                                                  MemoryFeatureFlags             in_required_memory_features)
+{
+    bool result;
+
+    anvil_assert(in_first_use <= in_last_use);
+    anvil_assert(!in_buffer_ptr->is_sparse() );
+
+    result = add_buffer_internal(in_buffer_ptr,
+                                 in_required_memory_features);
+
+    if (result)
+    {
+        m_items.back().is_transient        = true;
+        m_items.back().transient_first_use = in_first_use;
+        m_items.back().transient_last_use  = in_last_use;
+    }
+
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::MemoryAllocator::add_transient_image_whole(std::shared_ptr<Anvil::Image> in_image_ptr,
+                                                       uint32_t                      in_first_use,
+                                                       uint32_t                      in_last_use,
+                                                       MemoryFeatureFlags            in_required_memory_features)
+{
+    bool result;
+
+    anvil_assert(in_first_use <= in_last_use);
+    anvil_assert(!in_image_ptr->is_sparse() );
+
+    result = add_image_whole(in_image_ptr,
+                             in_required_memory_features);
+
+    if (result)
+    {
+        m_items.back().is_transient        = true;
+        m_items.back().transient_first_use = in_first_use;
+        m_items.back().transient_last_use  = in_last_use;
+    }
+
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::MemoryAllocator::bake()
 {
@@ -507,11 +556,19 @@ bool Anvil::MemoryAllocator::bake()
             {
                 std::shared_ptr<Anvil::MemoryBlock> new_memory_block_ptr;
                 VkDeviceSize                        n_bytes_required      = 0;
+                std::vector<Item*>                  transient_items;
 
                 /* Go through the items, calculate offsets and the total amount of memory we're going
                  * to need to alloc off the heap */
                 for (auto& current_item_ptr : current_item_vector)
                 {
+                    if (current_item_ptr->is_transient)
+                    {
+                        transient_items.push_back(current_item_ptr);
+
+                        continue;
+                    }
+
                     n_bytes_required = Anvil::Utils::round_up(n_bytes_required,
                                                               current_item_ptr->alloc_memory_required_alignment);
 
@@ -519,6 +576,74 @@ bool Anvil::MemoryAllocator::bake()
                     n_bytes_required               += current_item_ptr->alloc_size;
                 }
 
+                /* Transient items are placed after persistent ones. Items whose life-times overlap must not
+                 * share memory, the others can. Place the largest items first, each at the lowest offset which
+                 * does not collide with any already placed item it is alive at the same time with.
+                 *
+                 * All transient items are aligned to bufferImageGranularity, so that linear and optimal
+                 * resources never end up sharing a page in a way which is not allowed by the spec. */
+                if (transient_items.size() > 0)
+                {
+                    const VkDeviceSize buffer_image_granularity = device_locked_ptr->get_physical_device_properties().limits.bufferImageGranularity;
+                    const VkDeviceSize transient_base_offset    = Anvil::Utils::round_up(n_bytes_required,
+                                                                                         buffer_image_granularity);
+
+                    std::stable_sort(transient_items.begin(),
+                                     transient_items.end(),
+                                     [](const Item* in_item1_ptr,
+                                        const Item* in_item2_ptr)
+                                     {
+                                         return in_item1_ptr->alloc_size > in_item2_ptr->alloc_size;
+                                     });
+
+                    n_bytes_required = transient_base_offset;
+
+                    for (uint32_t n_transient_item = 0;
+                                  n_transient_item < static_cast<uint32_t>(transient_items.size() );
+                                ++n_transient_item)
+                    {
+                        Item*              current_item_ptr = transient_items[n_transient_item];
+                        const VkDeviceSize alignment        = std::max(current_item_ptr->alloc_memory_required_alignment,
+                                                                       buffer_image_granularity);
+                        VkDeviceSize       candidate_offset = transient_base_offset;
+                        bool               has_collision    = true;
+
+                        while (has_collision)
+                        {
+                            has_collision    = false;
+                            candidate_offset = Anvil::Utils::round_up(candidate_offset,
+                                                                      alignment);
+
+                            for (uint32_t n_placed_item = 0;
+                                          n_placed_item < n_transient_item;
+                                        ++n_placed_item)
+                            {
+                                const Item* placed_item_ptr = transient_items[n_placed_item];
+
+                                if (placed_item_ptr->transient_first_use > current_item_ptr->transient_last_use ||
+                                    placed_item_ptr->transient_last_use  < current_item_ptr->transient_first_use)
+                                {
+                                    /* Life-times do not overlap, so memory can be shared */
+                                    continue;
+                                }
+
+                                if (placed_item_ptr->alloc_offset                               < candidate_offset + current_item_ptr->alloc_size &&
+                                    placed_item_ptr->alloc_offset + placed_item_ptr->alloc_size > candidate_offset)
+                                {
+                                    candidate_offset = placed_item_ptr->alloc_offset + placed_item_ptr->alloc_size;
+                                    has_collision    = true;
+
+                                    break;
+                                }
+                            }
+                        }
+
+                        current_item_ptr->alloc_offset = candidate_offset;
+                        n_bytes_required               = std::max(n_bytes_required,
+                                                                  candidate_offset + current_item_ptr->alloc_size);
+                    }
+                }
+
                 /* Bake the block and stash it */
                 new_memory_block_ptr = Anvil::MemoryBlock::create(m_device_ptr,
                                                                   1u << current_memory_type_index,
@@ -569,8 +694,7 @@ bool Anvil::MemoryAllocator::bake()
 
     if (needs_sparse_memory_binding)
     {
-        std::shared_ptr<Anvil::Fence> wait_fence_ptr = Anvil::Fence::create(m_device_ptr,
-                                                                            false); /* create_signalled */
+        std::shared_ptr<Anvil::Fence> wait_fence_ptr = device_locked_ptr->get_fence_pool()->get_fence();
 
         sparse_memory_binding.set_fence(wait_fence_ptr);
 
@@ -131,7 +131,8 @@ const char* Anvil::ObjectTracker::get_object_type_name(ObjectType object_type) c
         "Swapchain",
 
         /* Fake types: */
-        "Graphics Pipeline (fake)"
+        "Graphics Pipeline (fake)",
+        "Pipeline (fake)"
     };
 
     static_assert(sizeof(result_array) / sizeof(result_array[0]) == OBJECT_TYPE_COUNT,
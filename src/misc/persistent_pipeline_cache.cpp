@@ -0,0 +1,428 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "misc/debug.h"
+#include "misc/persistent_pipeline_cache.h"
+#include "wrappers/device.h"
+#include "wrappers/pipeline_cache.h"
+#include <algorithm>
+#include <stdio.h>
+
+/* "ANVC" */
+#define FILE_HEADER_MAGIC   (0x43564E41)
+#define FILE_HEADER_VERSION (1)
+
+/* Number of caches merged with a single vkMergePipelineCaches() call. PipelineCache::merge() accepts
+ * up to 63 caches at a time. */
+#define N_MAX_CACHES_PER_MERGE (32)
+
+
+/** Please see header for specification */
+Anvil::PersistentPipelineCache::PersistentPipelineCache(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                        const std::string&               in_cache_directory)
+    :m_device_ptr    (in_device_ptr),
+     m_n_loaded_bytes(0)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(in_device_ptr);
+    const VkPhysicalDeviceProperties&  props            (device_locked_ptr->get_physical_device_properties() );
+    char                               filename_buffer  [64];
+
+    snprintf(filename_buffer,
+             sizeof(filename_buffer),
+             "anvil_pipeline_cache_%08x_%08x.bin",
+             props.vendorID,
+             props.deviceID);
+
+    m_filename = in_cache_directory;
+
+    if (!m_filename.empty()       &&
+         m_filename.back() != '/' &&
+         m_filename.back() != '\\')
+    {
+        m_filename += "/";
+    }
+
+    m_filename += filename_buffer;
+}
+
+/** Please see header for specification */
+Anvil::PersistentPipelineCache::~PersistentPipelineCache()
+{
+    m_thread_pipeline_caches.clear();
+    m_pipeline_cache_ptr = nullptr;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::PersistentPipelineCache> Anvil::PersistentPipelineCache::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                                                       const std::string&               in_cache_directory)
+{
+    std::shared_ptr<Anvil::PersistentPipelineCache> result_ptr;
+
+    result_ptr.reset(
+        new Anvil::PersistentPipelineCache(in_device_ptr,
+                                           in_cache_directory)
+    );
+
+    result_ptr->init();
+
+    return result_ptr;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::PipelineCache> Anvil::PersistentPipelineCache::get_thread_pipeline_cache()
+{
+    std::unique_lock<std::mutex>           lock      (m_mutex);
+    std::shared_ptr<Anvil::PipelineCache>& result_ptr(m_thread_pipeline_caches[std::this_thread::get_id()]);
+
+    if (result_ptr == nullptr)
+    {
+        result_ptr = Anvil::PipelineCache::create(m_device_ptr);
+    }
+
+    return result_ptr;
+}
+
+/** Computes a 64-bit FNV-1a hash of the specified data buffer. */
+uint64_t Anvil::PersistentPipelineCache::hash_data(const void* in_data_ptr,
+                                                   size_t      in_data_size)
+{
+    const uint8_t* data_u8_ptr = static_cast<const uint8_t*>(in_data_ptr);
+    uint64_t       result      = 14695981039346656037ull;
+
+    for (size_t n_byte = 0;
+                n_byte < in_data_size;
+              ++n_byte)
+    {
+        result ^= data_u8_ptr[n_byte];
+        result *= 1099511628211ull;
+    }
+
+    return result;
+}
+
+/** Loads cache data from the cache file, if it exists and is compatible with the device, and creates
+ *  the main pipeline cache. */
+void Anvil::PersistentPipelineCache::init()
+{
+    std::vector<uint8_t> data;
+    FILE*                file_handle = fopen(m_filename.c_str(),
+                                             "rb");
+    FileHeader           header;
+
+    if (file_handle == nullptr)
+    {
+        /* No data stored yet. */
+        goto end;
+    }
+
+    if (fread(&header,
+              sizeof(header),
+              1, /* count */
+              file_handle) != 1)
+    {
+        goto end;
+    }
+
+    if (header.magic     != FILE_HEADER_MAGIC   ||
+        header.version   != FILE_HEADER_VERSION ||
+        header.data_size == 0)
+    {
+        goto end;
+    }
+
+    /* Do not trust the stored data size before the file size is known to match it. */
+    {
+        long data_start_offset = ftell(file_handle);
+
+        if (fseek(file_handle,
+                  0,
+                  SEEK_END) != 0)
+        {
+            goto end;
+        }
+
+        if (static_cast<uint64_t>(ftell(file_handle) - data_start_offset) != header.data_size)
+        {
+            goto end;
+        }
+
+        fseek(file_handle,
+              data_start_offset,
+              SEEK_SET);
+    }
+
+    data.resize(static_cast<size_t>(header.data_size) );
+
+    if (fread(&data[0],
+              data.size(),
+              1, /* count */
+              file_handle) != 1)
+    {
+        goto end;
+    }
+
+    if (!is_cache_data_compatible(header,
+                                  &data[0]) )
+    {
+        goto end;
+    }
+
+    m_n_loaded_bytes = data.size();
+
+end:
+    if (file_handle != nullptr)
+    {
+        fclose(file_handle);
+    }
+
+    if (m_n_loaded_bytes > 0)
+    {
+        m_pipeline_cache_ptr = Anvil::PipelineCache::create(m_device_ptr,
+                                                            m_n_loaded_bytes,
+                                                           &data[0]);
+    }
+    else
+    {
+        m_pipeline_cache_ptr = Anvil::PipelineCache::create(m_device_ptr);
+    }
+}
+
+/** Fills @param out_header_ptr with device properties. Data size and hash fields are zeroed. */
+void Anvil::PersistentPipelineCache::init_file_header(FileHeader* out_header_ptr) const
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    const VkPhysicalDeviceProperties&  props            (device_locked_ptr->get_physical_device_properties() );
+
+    memset(out_header_ptr,
+           0,
+           sizeof(*out_header_ptr) );
+
+    out_header_ptr->device_id      = props.deviceID;
+    out_header_ptr->driver_version = props.driverVersion;
+    out_header_ptr->magic          = FILE_HEADER_MAGIC;
+    out_header_ptr->vendor_id      = props.vendorID;
+    out_header_ptr->version        = FILE_HEADER_VERSION;
+
+    memcpy(out_header_ptr->pipeline_cache_uuid,
+           props.pipelineCacheUUID,
+           sizeof(out_header_ptr->pipeline_cache_uuid) );
+}
+
+/** Tells whether cache data loaded from the file has been generated for the device this instance
+ *  has been created for. Both our own header, and the header Vulkan places at the start of pipeline
+ *  cache data, are checked. */
+bool Anvil::PersistentPipelineCache::is_cache_data_compatible(const FileHeader& in_header,
+                                                              const void*       in_data_ptr) const
+{
+    FileHeader            device_header;
+    bool                  result            = false;
+    const uint32_t*       vk_header_u32_ptr = static_cast<const uint32_t*>(in_data_ptr);
+    const uint8_t*        vk_header_u8_ptr  = static_cast<const uint8_t*> (in_data_ptr);
+    static const uint32_t vk_header_size    = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+
+    init_file_header(&device_header);
+
+    if (in_header.device_id      != device_header.device_id      ||
+        in_header.driver_version != device_header.driver_version ||
+        in_header.vendor_id      != device_header.vendor_id)
+    {
+        goto end;
+    }
+
+    if (memcmp(in_header.pipeline_cache_uuid,
+               device_header.pipeline_cache_uuid,
+               sizeof(device_header.pipeline_cache_uuid) ) != 0)
+    {
+        goto end;
+    }
+
+    if (hash_data(in_data_ptr,
+                  static_cast<size_t>(in_header.data_size) ) != in_header.data_hash)
+    {
+        goto end;
+    }
+
+    /* VkPipelineCacheHeaderVersionOne: header size, header version, vendor ID, device ID, UUID */
+    if (in_header.data_size < vk_header_size)
+    {
+        goto end;
+    }
+
+    if (vk_header_u32_ptr[0] <  vk_header_size                       ||
+        vk_header_u32_ptr[0] >  in_header.data_size                  ||
+        vk_header_u32_ptr[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        vk_header_u32_ptr[2] != device_header.vendor_id              ||
+        vk_header_u32_ptr[3] != device_header.device_id)
+    {
+        goto end;
+    }
+
+    if (memcmp(vk_header_u8_ptr + 4 * sizeof(uint32_t),
+               device_header.pipeline_cache_uuid,
+               VK_UUID_SIZE) != 0)
+    {
+        goto end;
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::PersistentPipelineCache::merge_thread_pipeline_caches()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    return merge_thread_pipeline_caches_internal();
+}
+
+/** Merges thread pipeline caches into the main pipeline cache. Assumes m_mutex is locked by the caller. */
+bool Anvil::PersistentPipelineCache::merge_thread_pipeline_caches_internal()
+{
+    std::vector<std::shared_ptr<const Anvil::PipelineCache> > caches;
+    bool                                                      result = true;
+
+    caches.reserve(m_thread_pipeline_caches.size() );
+
+    for (auto cache_iterator  = m_thread_pipeline_caches.cbegin();
+              cache_iterator != m_thread_pipeline_caches.cend();
+            ++cache_iterator)
+    {
+        caches.push_back(cache_iterator->second);
+    }
+
+    for (size_t n_first_cache = 0;
+                n_first_cache < caches.size();
+                n_first_cache += N_MAX_CACHES_PER_MERGE)
+    {
+        const uint32_t n_caches_to_merge = static_cast<uint32_t>(std::min(caches.size() - n_first_cache,
+                                                                          static_cast<size_t>(N_MAX_CACHES_PER_MERGE) ));
+
+        result &= m_pipeline_cache_ptr->merge(n_caches_to_merge,
+                                             &caches[n_first_cache]);
+    }
+
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::PersistentPipelineCache::store()
+{
+    std::vector<uint8_t>         data;
+    size_t                       data_size     = 0;
+    FILE*                        file_handle   = nullptr;
+    FileHeader                   header;
+    std::unique_lock<std::mutex> lock          (m_mutex);
+    bool                         result        = false;
+    const std::string            temp_filename = m_filename + ".tmp";
+
+    /* Merge per-thread caches first, so that their pipelines are persisted, too. A failed merge only
+     * means some pipelines are going to be compiled again next time. */
+    merge_thread_pipeline_caches_internal();
+
+    if (!m_pipeline_cache_ptr->get_data(&data_size,
+                                        nullptr) )
+    {
+        goto end;
+    }
+
+    if (data_size == 0)
+    {
+        goto end;
+    }
+
+    data.resize(data_size);
+
+    if (!m_pipeline_cache_ptr->get_data(&data_size,
+                                        &data[0]) )
+    {
+        goto end;
+    }
+
+    init_file_header(&header);
+
+    header.data_size = data_size;
+    header.data_hash = hash_data(&data[0],
+                                 data_size);
+
+    /* Write the data to a temporary file first.. */
+    file_handle = fopen(temp_filename.c_str(),
+                        "wb");
+
+    if (file_handle == nullptr)
+    {
+        goto end;
+    }
+
+    if (fwrite(&header,
+               sizeof(header),
+               1, /* count */
+               file_handle) != 1)
+    {
+        goto end;
+    }
+
+    if (fwrite(&data[0],
+               data_size,
+               1, /* count */
+               file_handle) != 1)
+    {
+        goto end;
+    }
+
+    if (fclose(file_handle) != 0)
+    {
+        file_handle = nullptr;
+
+        goto end;
+    }
+
+    file_handle = nullptr;
+
+    /* ..and replace the old cache file with it. */
+    #ifdef _WIN32
+    {
+        result = (MoveFileExA(temp_filename.c_str(),
+                              m_filename.c_str(),
+                              MOVEFILE_REPLACE_EXISTING) != 0);
+    }
+    #else
+    {
+        result = (rename(temp_filename.c_str(),
+                         m_filename.c_str() ) == 0);
+    }
+    #endif
+
+end:
+    if (file_handle != nullptr)
+    {
+        fclose(file_handle);
+    }
+
+    if (!result)
+    {
+        remove(temp_filename.c_str() );
+    }
+
+    return result;
+}
@@ -0,0 +1,490 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "misc/debug.h"
+#include "misc/pipeline_statistics_aggregator.h"
+#include "misc/query_pool_ring.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/query_pool.h"
+#include <algorithm>
+#include <sstream>
+
+
+/** Writes a JSON object holding the last frame's values and rolling averages of all counters.
+ *
+ *  @param in_stats        Statistics to write.
+ *  @param in_counter_bits Pipeline statistic bits, in counter order.
+ *  @param out_sstream_ptr Stream to write the object to. Must not be nullptr.
+ **/
+static void write_json_stats(const Anvil::PipelineStatisticsRegionStats&          in_stats,
+                             const std::vector<VkQueryPipelineStatisticFlagBits>& in_counter_bits,
+                             std::stringstream*                                   out_sstream_ptr)
+{
+    *out_sstream_ptr << "{\"frames\":" << in_stats.n_frames;
+
+    for (uint32_t n_counter = 0;
+                  n_counter < static_cast<uint32_t>(in_stats.last_frame_values.size() );
+                ++n_counter)
+    {
+        *out_sstream_ptr << ",\"" << Anvil::PipelineStatisticsAggregator::get_counter_name(in_counter_bits[n_counter]) << "\":"
+                         << "{\"last\":" << in_stats.last_frame_values [n_counter]
+                         << ",\"avg\":"  << in_stats.rolling_avg_values[n_counter] << "}";
+    }
+
+    *out_sstream_ptr << "}";
+}
+
+
+/** Please see header for specification */
+Anvil::PipelineStatisticsAggregator::PipelineStatisticsAggregator(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                                  VkQueryPipelineStatisticFlags    in_pipeline_statistics,
+                                                                  uint32_t                         in_n_frames_in_flight,
+                                                                  uint32_t                         in_n_max_regions_per_frame,
+                                                                  uint32_t                         in_n_rolling_avg_frames)
+    :CallbacksSupportProvider   (PIPELINE_STATISTICS_AGGREGATOR_CALLBACK_ID_COUNT),
+     m_active_query             (UINT32_MAX),
+     m_device_ptr               (in_device_ptr),
+     m_is_region_active         (false),
+     m_last_resolved_frame_index(UINT64_MAX),
+     m_n_frames_in_flight       (in_n_frames_in_flight),
+     m_n_max_regions_per_frame  (in_n_max_regions_per_frame),
+     m_n_rolling_avg_frames     (in_n_rolling_avg_frames),
+     m_pipeline_statistics      (in_pipeline_statistics)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::PipelineStatisticsAggregator::~PipelineStatisticsAggregator()
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+bool Anvil::PipelineStatisticsAggregator::begin_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr)
+{
+    bool result = false;
+
+    anvil_assert(!m_is_region_active);
+
+    if (!m_query_pool_ring_ptr->begin_frame(in_cmd_buffer_ptr) )
+    {
+        goto end;
+    }
+
+    if (m_query_pool_ring_ptr->has_resolved_results() )
+    {
+        resolve_frame();
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::PipelineStatisticsAggregator::begin_region(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                                                       const char*                               in_name)
+{
+    const uint32_t    n_frame_slot = static_cast<uint32_t>(m_query_pool_ring_ptr->get_current_frame_index() % m_n_frames_in_flight);
+    Anvil::QueryIndex query;
+    bool              result       = false;
+
+    if (m_is_region_active)
+    {
+        /* Only one pipeline statistics query can be active at a time */
+        anvil_assert(!m_is_region_active);
+
+        goto end;
+    }
+
+    m_active_query     = UINT32_MAX;
+    m_is_region_active = true;
+
+    if (!m_query_pool_ring_ptr->allocate_queries(1, /* in_n_queries */
+                                                &query) )
+    {
+        goto end;
+    }
+
+    if (!in_cmd_buffer_ptr->record_begin_query(m_query_pool_ring_ptr->get_current_query_pool(),
+                                               query,
+                                               0) ) /* in_flags */
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    /* Frames use ring slots in order, so the region names can be looked up by frame index at resolve time */
+    m_region_names_per_frame_slot[n_frame_slot][query].assign(in_name);
+
+    m_active_query = query;
+    result         = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::PipelineStatisticsAggregator> Anvil::PipelineStatisticsAggregator::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                                                                 VkQueryPipelineStatisticFlags    in_pipeline_statistics,
+                                                                                                 uint32_t                         in_n_frames_in_flight,
+                                                                                                 uint32_t                         in_n_max_regions_per_frame,
+                                                                                                 uint32_t                         in_n_rolling_avg_frames,
+                                                                                                 bool                             in_should_copy_results_to_buffer)
+{
+    std::shared_ptr<PipelineStatisticsAggregator> result_ptr;
+
+    anvil_assert(in_pipeline_statistics  != 0);
+    anvil_assert(in_n_rolling_avg_frames >  0);
+
+    result_ptr.reset(
+        new Anvil::PipelineStatisticsAggregator(in_device_ptr,
+                                                in_pipeline_statistics,
+                                                in_n_frames_in_flight,
+                                                in_n_max_regions_per_frame,
+                                                in_n_rolling_avg_frames)
+    );
+
+    if (!result_ptr->init(in_should_copy_results_to_buffer) )
+    {
+        result_ptr.reset();
+    }
+
+    return result_ptr;
+}
+
+/** Please see header for specification */
+bool Anvil::PipelineStatisticsAggregator::end_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr)
+{
+    anvil_assert(!m_is_region_active);
+
+    return m_query_pool_ring_ptr->end_frame(in_cmd_buffer_ptr);
+}
+
+/** Please see header for specification */
+bool Anvil::PipelineStatisticsAggregator::end_region(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr)
+{
+    bool result = false;
+
+    anvil_assert(m_is_region_active);
+
+    m_is_region_active = false;
+
+    if (m_active_query == UINT32_MAX)
+    {
+        /* The region has been ignored */
+        goto end;
+    }
+
+    if (!in_cmd_buffer_ptr->record_end_query(m_query_pool_ring_ptr->get_current_query_pool(),
+                                             m_active_query) )
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    result = true;
+end:
+    m_active_query = UINT32_MAX;
+
+    return result;
+}
+
+/** Please see header for specification */
+const char* Anvil::PipelineStatisticsAggregator::get_counter_name(VkQueryPipelineStatisticFlagBits in_counter_bit)
+{
+    const char* result = "?";
+
+    switch (in_counter_bit)
+    {
+        case VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT:                    result = "input_assembly_vertices";                    break;
+        case VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT:                  result = "input_assembly_primitives";                  break;
+        case VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT:                  result = "vertex_shader_invocations";                  break;
+        case VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT:                result = "geometry_shader_invocations";                break;
+        case VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT:                 result = "geometry_shader_primitives";                 break;
+        case VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT:                       result = "clipping_invocations";                       break;
+        case VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT:                        result = "clipping_primitives";                        break;
+        case VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT:                result = "fragment_shader_invocations";                break;
+        case VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT:        result = "tessellation_control_shader_patches";        break;
+        case VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT: result = "tessellation_evaluation_shader_invocations"; break;
+        case VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT:                 result = "compute_shader_invocations";                 break;
+
+        default:
+        {
+            anvil_assert(false);
+        }
+    }
+
+    return result;
+}
+
+/** Please see header for specification */
+std::string Anvil::PipelineStatisticsAggregator::get_json() const
+{
+    std::stringstream result_sstream;
+
+    result_sstream << "{\"frame\":";
+
+    if (m_last_resolved_frame_index != UINT64_MAX)
+    {
+        result_sstream << m_last_resolved_frame_index;
+    }
+    else
+    {
+        result_sstream << "null";
+    }
+
+    result_sstream << ",\"frame_totals\":";
+
+    write_json_stats(m_frame_stats,
+                     m_counter_bits,
+                    &result_sstream);
+
+    result_sstream << ",\"regions\":{";
+
+    for (auto stats_iterator  = m_region_stats.cbegin();
+              stats_iterator != m_region_stats.cend();
+            ++stats_iterator)
+    {
+        if (stats_iterator != m_region_stats.cbegin() )
+        {
+            result_sstream << ",";
+        }
+
+        result_sstream << "\"";
+
+        for (auto char_iterator  = stats_iterator->first.cbegin();
+                  char_iterator != stats_iterator->first.cend();
+                ++char_iterator)
+        {
+            if (*char_iterator == '"' ||
+                *char_iterator == '\\')
+            {
+                result_sstream << '\\';
+            }
+
+            if (static_cast<unsigned char>(*char_iterator) >= 0x20)
+            {
+                result_sstream << *char_iterator;
+            }
+        }
+
+        result_sstream << "\":";
+
+        write_json_stats(stats_iterator->second,
+                         m_counter_bits,
+                        &result_sstream);
+    }
+
+    result_sstream << "}}";
+
+    return result_sstream.str();
+}
+
+/** Please see header for specification */
+bool Anvil::PipelineStatisticsAggregator::get_region_stats(const std::string&             in_name,
+                                                           PipelineStatisticsRegionStats* out_stats_ptr) const
+{
+    auto stats_iterator = m_region_stats.find(in_name);
+    bool result         = false;
+
+    if (stats_iterator != m_region_stats.end() )
+    {
+        *out_stats_ptr = stats_iterator->second;
+        result         = true;
+    }
+
+    return result;
+}
+
+/** Decodes the enabled counters and creates the query pool ring.
+ *
+ *  @param in_should_copy_results_to_buffer Please see create() for specification.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::PipelineStatisticsAggregator::init(bool in_should_copy_results_to_buffer)
+{
+    bool result = false;
+
+    /* Query results hold values of the enabled counters, ordered by their bit positions */
+    for (uint32_t n_bit = 0;
+                  n_bit < 32;
+                ++n_bit)
+    {
+        const VkQueryPipelineStatisticFlags bit = 1u << n_bit;
+
+        if ((m_pipeline_statistics & bit) != 0)
+        {
+            m_counter_bits.push_back(static_cast<VkQueryPipelineStatisticFlagBits>(bit) );
+        }
+    }
+
+    m_query_pool_ring_ptr = Anvil::QueryPoolRing::create(m_device_ptr,
+                                                         VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                                                         m_pipeline_statistics,
+                                                         m_n_frames_in_flight,
+                                                         m_n_max_regions_per_frame,
+                                                         in_should_copy_results_to_buffer);
+
+    if (m_query_pool_ring_ptr == nullptr)
+    {
+        goto end;
+    }
+
+    anvil_assert(m_query_pool_ring_ptr->get_n_values_per_query() == m_counter_bits.size() );
+
+    m_frame_values.resize               (m_counter_bits.size() );
+    m_region_names_per_frame_slot.resize(m_n_frames_in_flight,
+                                         std::vector<std::string>(m_n_max_regions_per_frame) );
+
+    result = true;
+end:
+    return result;
+}
+
+/** Aggregates the results of the frame which has last been read back by the query pool ring, and
+ *  notifies the subscribers.
+ **/
+void Anvil::PipelineStatisticsAggregator::resolve_frame()
+{
+    const uint64_t                  frame_index  = m_query_pool_ring_ptr->get_resolved_frame_index();
+    const uint32_t                  n_counters   = static_cast<uint32_t>(m_counter_bits.size() );
+    uint32_t                        n_instances  = 0;
+    const std::vector<std::string>& region_names = m_region_names_per_frame_slot[frame_index % m_n_frames_in_flight];
+
+    std::fill(m_frame_values.begin(),
+              m_frame_values.end(),
+              0);
+
+    for (auto region_iterator  = m_frame_values_per_region.begin();
+              region_iterator != m_frame_values_per_region.end();
+            ++region_iterator)
+    {
+        region_iterator->second.n_instances = 0;
+
+        std::fill(region_iterator->second.values.begin(),
+                  region_iterator->second.values.end(),
+                  0);
+    }
+
+    /* Sum up values of all region instances */
+    for (uint32_t n_query = 0;
+                  n_query < m_query_pool_ring_ptr->get_n_resolved_queries();
+                ++n_query)
+    {
+        const uint64_t* query_results_ptr = m_query_pool_ring_ptr->get_resolved_query_results(n_query);
+
+        if (query_results_ptr == nullptr)
+        {
+            continue;
+        }
+
+        auto region_iterator = m_frame_values_per_region.find(region_names[n_query]);
+
+        if (region_iterator == m_frame_values_per_region.end() )
+        {
+            region_iterator = m_frame_values_per_region.insert(std::make_pair(region_names[n_query],
+                                                                              FrameRegionValues() )).first;
+
+            region_iterator->second.values.resize(n_counters,
+                                                  0);
+        }
+
+        for (uint32_t n_counter = 0;
+                      n_counter < n_counters;
+                    ++n_counter)
+        {
+            m_frame_values[n_counter]                 += query_results_ptr[n_counter];
+            region_iterator->second.values[n_counter] += query_results_ptr[n_counter];
+        }
+
+        ++region_iterator->second.n_instances;
+        ++n_instances;
+    }
+
+    /* Update the statistics */
+    for (auto region_iterator  = m_frame_values_per_region.cbegin();
+              region_iterator != m_frame_values_per_region.cend();
+            ++region_iterator)
+    {
+        if (region_iterator->second.n_instances > 0)
+        {
+            update_stats(region_iterator->second.values,
+                        &m_region_stats[region_iterator->first]);
+        }
+    }
+
+    if (n_instances > 0)
+    {
+        update_stats(m_frame_values,
+                    &m_frame_stats);
+    }
+
+    m_last_resolved_frame_index = frame_index;
+
+    /* Notify the subscribers */
+    {
+        PipelineStatisticsFrameResolvedCallbackData callback_data(this,
+                                                                  frame_index,
+                                                                  m_query_pool_ring_ptr->are_resolved_results_complete() );
+
+        callback(PIPELINE_STATISTICS_AGGREGATOR_CALLBACK_ID_FRAME_RESOLVED,
+                &callback_data);
+    }
+}
+
+/** Updates statistics with values gathered for a single frame.
+ *
+ *  @param in_frame_values Per-frame sums of counter values.
+ *  @param in_stats_ptr    Statistics to update. Must not be nullptr.
+ **/
+void Anvil::PipelineStatisticsAggregator::update_stats(const std::vector<uint64_t>&   in_frame_values,
+                                                       PipelineStatisticsRegionStats* in_stats_ptr)
+{
+    double smoothing_factor;
+
+    if (in_stats_ptr->last_frame_values.size() != in_frame_values.size() )
+    {
+        in_stats_ptr->last_frame_values.resize (in_frame_values.size(),
+                                                0);
+        in_stats_ptr->rolling_avg_values.resize(in_frame_values.size(),
+                                                0.0);
+    }
+
+    ++in_stats_ptr->n_frames;
+
+    smoothing_factor = 1.0 / static_cast<double>(std::min(in_stats_ptr->n_frames,
+                                                          m_n_rolling_avg_frames) );
+
+    for (uint32_t n_counter = 0;
+                  n_counter < static_cast<uint32_t>(in_frame_values.size() );
+                ++n_counter)
+    {
+        const double value = static_cast<double>(in_frame_values[n_counter]);
+
+        in_stats_ptr->last_frame_values [n_counter]  = in_frame_values[n_counter];
+        in_stats_ptr->rolling_avg_values[n_counter] += (value - in_stats_ptr->rolling_avg_values[n_counter]) * smoothing_factor;
+    }
+}
@@ -24,6 +24,16 @@
 #include "misc/pools.h"
 #include "wrappers/command_buffer.h"
 #include "wrappers/command_pool.h"
+#include <atomic>
+
+/* Please see header for specification */
+uint32_t Anvil::get_pool_thread_index()
+{
+    static std::atomic<uint32_t> n_threads(0);
+    static thread_local uint32_t thread_index = n_threads.fetch_add(1);
+
+    return thread_index;
+}
 
 std::shared_ptr<Anvil::PrimaryCommandBuffer> Anvil::PrimaryCommandBufferPoolWorker::create_item()
 {
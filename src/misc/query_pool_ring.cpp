@@ -0,0 +1,403 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "misc/debug.h"
+#include "misc/query_pool_ring.h"
+#include "wrappers/buffer.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/device.h"
+#include "wrappers/memory_block.h"
+#include "wrappers/query_pool.h"
+#include <cstring>
+
+
+/** Please see header for specification */
+Anvil::QueryPoolRing::QueryPoolRing(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                    VkQueryType                      in_query_type,
+                                    VkQueryPipelineStatisticFlags    in_pipeline_statistics,
+                                    uint32_t                         in_n_frames_in_flight,
+                                    uint32_t                         in_n_queries_per_frame,
+                                    bool                             in_should_copy_results_to_buffer)
+    :m_are_resolved_results_complete(false),
+     m_device_ptr                   (in_device_ptr),
+     m_has_resolved_results         (false),
+     m_is_frame_active              (false),
+     m_mapped_results_ptr           (nullptr),
+     m_n_current_frame_slot         (in_n_frames_in_flight - 1),
+     m_n_frames_in_flight           (in_n_frames_in_flight),
+     m_n_queries_per_frame          (in_n_queries_per_frame),
+     m_n_resolved_queries           (0),
+     m_n_started_frames             (0),
+     m_n_values_per_query           (0),
+     m_pipeline_statistics          ((in_query_type == VK_QUERY_TYPE_PIPELINE_STATISTICS) ? in_pipeline_statistics : 0),
+     m_query_type                   (in_query_type),
+     m_resolved_frame_index         (0),
+     m_should_copy_results_to_buffer(in_should_copy_results_to_buffer)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::QueryPoolRing::~QueryPoolRing()
+{
+    if (m_mapped_results_ptr != nullptr)
+    {
+        m_results_buffer_ptr->get_memory_block(0)->unmap();
+
+        m_mapped_results_ptr = nullptr;
+    }
+}
+
+/** Please see header for specification */
+bool Anvil::QueryPoolRing::allocate_queries(uint32_t           in_n_queries,
+                                            Anvil::QueryIndex* out_first_query_ptr)
+{
+    FrameSlot& frame_slot = m_frame_slots[m_n_current_frame_slot];
+    bool       result     = false;
+
+    anvil_assert(m_is_frame_active);
+
+    if (frame_slot.n_allocated_queries + in_n_queries > m_n_queries_per_frame)
+    {
+        goto end;
+    }
+
+    *out_first_query_ptr            = frame_slot.n_allocated_queries;
+    frame_slot.n_allocated_queries += in_n_queries;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::QueryPoolRing::begin_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr)
+{
+    FrameSlot* frame_slot_ptr = nullptr;
+    bool       result         = false;
+
+    anvil_assert(!m_is_frame_active);
+
+    m_n_current_frame_slot = (m_n_current_frame_slot + 1) % m_n_frames_in_flight;
+    frame_slot_ptr         = &m_frame_slots[m_n_current_frame_slot];
+    m_has_resolved_results = false;
+
+    if (frame_slot_ptr->has_pending_results)
+    {
+        if (!resolve_frame(m_n_current_frame_slot) )
+        {
+            goto end;
+        }
+    }
+
+    if (!in_cmd_buffer_ptr->record_reset_query_pool(frame_slot_ptr->query_pool_ptr,
+                                                    0, /* in_start_query */
+                                                    m_n_queries_per_frame) )
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    frame_slot_ptr->frame_index         = m_n_started_frames++;
+    frame_slot_ptr->has_pending_results = false;
+    frame_slot_ptr->n_allocated_queries = 0;
+    m_is_frame_active                   = true;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::QueryPoolRing> Anvil::QueryPoolRing::create(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
+                                                                   VkQueryType                      in_query_type,
+                                                                   VkQueryPipelineStatisticFlags    in_pipeline_statistics,
+                                                                   uint32_t                         in_n_frames_in_flight,
+                                                                   uint32_t                         in_n_queries_per_frame,
+                                                                   bool                             in_should_copy_results_to_buffer)
+{
+    std::shared_ptr<QueryPoolRing> result_ptr;
+
+    anvil_assert(in_n_frames_in_flight  > 0);
+    anvil_assert(in_n_queries_per_frame > 0);
+
+    result_ptr.reset(
+        new Anvil::QueryPoolRing(in_device_ptr,
+                                 in_query_type,
+                                 in_pipeline_statistics,
+                                 in_n_frames_in_flight,
+                                 in_n_queries_per_frame,
+                                 in_should_copy_results_to_buffer)
+    );
+
+    if (!result_ptr->init() )
+    {
+        result_ptr.reset();
+    }
+
+    return result_ptr;
+}
+
+/** Please see header for specification */
+bool Anvil::QueryPoolRing::end_frame(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr)
+{
+    FrameSlot& frame_slot = m_frame_slots[m_n_current_frame_slot];
+    bool       result     = false;
+
+    anvil_assert(m_is_frame_active);
+
+    if (m_should_copy_results_to_buffer &&
+        frame_slot.n_allocated_queries > 0)
+    {
+        const VkDeviceSize query_stride      = sizeof(uint64_t) * (m_n_values_per_query + 1 /* availability */);
+        const VkDeviceSize frame_slot_offset = query_stride * m_n_queries_per_frame * m_n_current_frame_slot;
+        const VkDeviceSize frame_slot_size   = query_stride * frame_slot.n_allocated_queries;
+
+        /* Let the GPU wait for the results, so that the CPU never has to */
+        if (!in_cmd_buffer_ptr->record_copy_query_pool_results(frame_slot.query_pool_ptr,
+                                                               0, /* in_start_query */
+                                                               frame_slot.n_allocated_queries,
+                                                               m_results_buffer_ptr,
+                                                               frame_slot_offset,
+                                                               query_stride,
+                                                               VK_QUERY_RESULT_64_BIT                |
+                                                               VK_QUERY_RESULT_WAIT_BIT              |
+                                                               VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) )
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        {
+            Anvil::BufferBarrier barrier(VK_ACCESS_TRANSFER_WRITE_BIT,
+                                         VK_ACCESS_HOST_READ_BIT,
+                                         VK_QUEUE_FAMILY_IGNORED,
+                                         VK_QUEUE_FAMILY_IGNORED,
+                                         m_results_buffer_ptr,
+                                         frame_slot_offset,
+                                         frame_slot_size);
+
+            if (!in_cmd_buffer_ptr->record_pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                                            VK_PIPELINE_STAGE_HOST_BIT,
+                                                            VK_FALSE, /* in_by_region */
+                                                            0,        /* in_memory_barrier_count */
+                                                            nullptr,  /* in_memory_barriers_ptr  */
+                                                            1,        /* in_buffer_memory_barrier_count */
+                                                           &barrier,
+                                                            0,        /* in_image_memory_barrier_count */
+                                                            nullptr)) /* in_image_memory_barriers_ptr  */
+            {
+                anvil_assert(false);
+
+                goto end;
+            }
+        }
+    }
+
+    frame_slot.has_pending_results = (frame_slot.n_allocated_queries > 0);
+    m_is_frame_active              = false;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+std::shared_ptr<Anvil::QueryPool> Anvil::QueryPoolRing::get_current_query_pool() const
+{
+    anvil_assert(m_is_frame_active);
+
+    return m_frame_slots[m_n_current_frame_slot].query_pool_ptr;
+}
+
+/** Please see header for specification */
+const uint64_t* Anvil::QueryPoolRing::get_resolved_query_results(Anvil::QueryIndex in_n_query) const
+{
+    const uint64_t* result_ptr = nullptr;
+
+    if (m_has_resolved_results &&
+        in_n_query < m_n_resolved_queries)
+    {
+        const uint64_t* query_results_ptr = &m_resolved_results[in_n_query * (m_n_values_per_query + 1)];
+
+        if (query_results_ptr[m_n_values_per_query] != 0)
+        {
+            result_ptr = query_results_ptr;
+        }
+    }
+
+    return result_ptr;
+}
+
+/** Creates query pools for all frames in flight and, if requested, the persistently mapped results buffer.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::QueryPoolRing::init()
+{
+    bool     result        = false;
+    uint32_t results_size;
+
+    m_frame_slots.resize(m_n_frames_in_flight);
+
+    for (auto frame_slot_iterator  = m_frame_slots.begin();
+              frame_slot_iterator != m_frame_slots.end();
+            ++frame_slot_iterator)
+    {
+        if (m_query_type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+        {
+            frame_slot_iterator->query_pool_ptr = Anvil::QueryPool::create_ps_query_pool(m_device_ptr,
+                                                                                          m_pipeline_statistics,
+                                                                                          m_n_queries_per_frame);
+        }
+        else
+        {
+            frame_slot_iterator->query_pool_ptr = Anvil::QueryPool::create_non_ps_query_pool(m_device_ptr,
+                                                                                              m_query_type,
+                                                                                              m_n_queries_per_frame);
+        }
+
+        if (frame_slot_iterator->query_pool_ptr                    == nullptr ||
+            frame_slot_iterator->query_pool_ptr->get_query_pool() == VK_NULL_HANDLE)
+        {
+            goto end;
+        }
+    }
+
+    m_n_values_per_query = m_frame_slots[0].query_pool_ptr->get_n_values_per_query();
+
+    /* Each query's values are followed by an availability value */
+    results_size = m_n_queries_per_frame * (m_n_values_per_query + 1);
+
+    m_resolved_results.resize(results_size);
+
+    if (m_should_copy_results_to_buffer)
+    {
+        const VkDeviceSize buffer_size = sizeof(uint64_t) * results_size * m_n_frames_in_flight;
+        void*              mapped_ptr  = nullptr;
+
+        m_results_buffer_ptr = Anvil::Buffer::create_nonsparse(m_device_ptr,
+                                                               buffer_size,
+                                                               Anvil::QUEUE_FAMILY_COMPUTE_BIT | Anvil::QUEUE_FAMILY_GRAPHICS_BIT,
+                                                               VK_SHARING_MODE_EXCLUSIVE,
+                                                               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                               true,     /* should_be_mappable */
+                                                               true,     /* should_be_coherent */
+                                                               nullptr); /* opt_client_data    */
+
+        if (m_results_buffer_ptr == nullptr)
+        {
+            goto end;
+        }
+
+        if (!m_results_buffer_ptr->get_memory_block(0)->map(m_results_buffer_ptr->get_start_offset(),
+                                                            buffer_size,
+                                                           &mapped_ptr) )
+        {
+            anvil_assert(false);
+
+            goto end;
+        }
+
+        m_mapped_results_ptr = static_cast<uint64_t*>(mapped_ptr);
+
+        /* Zeroed availability values tell the results of a frame have not been copied yet */
+        memset(m_mapped_results_ptr,
+               0,
+               static_cast<size_t>(buffer_size) );
+    }
+
+    result = true;
+end:
+    return result;
+}
+
+/** Reads back results of the frame which has last used the specified frame slot.
+ *
+ *  Never waits for the results. Queries whose results are not available are reported as such.
+ *
+ *  @param in_n_frame_slot Index of the frame slot to read back results for.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::QueryPoolRing::resolve_frame(uint32_t in_n_frame_slot)
+{
+    FrameSlot&     frame_slot = m_frame_slots[in_n_frame_slot];
+    const uint32_t n_values   = frame_slot.n_allocated_queries * (m_n_values_per_query + 1);
+    bool           result     = false;
+
+    /* Values of unavailable queries are not necessarily written, so start with a clean slate */
+    memset(&m_resolved_results[0],
+           0,
+           sizeof(uint64_t) * m_resolved_results.size() );
+
+    if (m_should_copy_results_to_buffer)
+    {
+        uint64_t* frame_slot_results_ptr = m_mapped_results_ptr + static_cast<size_t>(in_n_frame_slot) * m_resolved_results.size();
+
+        memcpy(&m_resolved_results[0],
+               frame_slot_results_ptr,
+               sizeof(uint64_t) * n_values);
+
+        /* Clear the availability values, in case the next copy to this slot does not execute in time */
+        memset(frame_slot_results_ptr,
+               0,
+               sizeof(uint64_t) * n_values);
+
+        m_are_resolved_results_complete = true;
+
+        for (uint32_t n_query = 0;
+                      n_query < frame_slot.n_allocated_queries;
+                    ++n_query)
+        {
+            if (m_resolved_results[n_query * (m_n_values_per_query + 1) + m_n_values_per_query] == 0)
+            {
+                m_are_resolved_results_complete = false;
+
+                break;
+            }
+        }
+    }
+    else
+    {
+        if (!frame_slot.query_pool_ptr->get_results(0, /* in_first_query */
+                                                    frame_slot.n_allocated_queries,
+                                                    VK_QUERY_RESULT_WITH_AVAILABILITY_BIT,
+                                                    static_cast<uint32_t>(m_resolved_results.size() ),
+                                                   &m_resolved_results[0],
+                                                   &m_are_resolved_results_complete) )
+        {
+            goto end;
+        }
+    }
+
+    frame_slot.has_pending_results = false;
+    m_has_resolved_results         = true;
+    m_n_resolved_queries           = frame_slot.n_allocated_queries;
+    m_resolved_frame_index         = frame_slot.frame_index;
+
+    result = true;
+end:
+    return result;
+}
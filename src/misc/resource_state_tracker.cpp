@@ -0,0 +1,738 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "misc/debug.h"
+#include "misc/resource_state_tracker.h"
+#include "wrappers/buffer.h"
+#include "wrappers/image.h"
+#include <algorithm>
+
+
+/** Please see header for specification */
+void Anvil::BufferRangeStates::get_states(VkDeviceSize        in_start_offset,
+                                          VkDeviceSize        in_end_offset,
+                                          std::vector<Range>* out_ranges_ptr) const
+{
+    VkDeviceSize current_offset = in_start_offset;
+
+    anvil_assert(in_start_offset < in_end_offset);
+
+    for (auto range_iterator  = m_ranges.cbegin();
+              range_iterator != m_ranges.cend() && current_offset < in_end_offset;
+            ++range_iterator)
+    {
+        if (range_iterator->end_offset <= current_offset)
+        {
+            continue;
+        }
+
+        if (range_iterator->start_offset > current_offset)
+        {
+            /* Gap which has not been assigned a state yet */
+            const VkDeviceSize gap_end_offset = std::min(range_iterator->start_offset,
+                                                         in_end_offset);
+
+            out_ranges_ptr->push_back(Range(current_offset,
+                                            gap_end_offset,
+                                            false, /* in_has_state */
+                                            Anvil::ResourceState() ));
+
+            current_offset = gap_end_offset;
+
+            if (current_offset >= in_end_offset)
+            {
+                break;
+            }
+        }
+
+        {
+            const VkDeviceSize range_end_offset = std::min(range_iterator->end_offset,
+                                                           in_end_offset);
+
+            out_ranges_ptr->push_back(Range(current_offset,
+                                            range_end_offset,
+                                            true, /* in_has_state */
+                                            range_iterator->state) );
+
+            current_offset = range_end_offset;
+        }
+    }
+
+    if (current_offset < in_end_offset)
+    {
+        out_ranges_ptr->push_back(Range(current_offset,
+                                        in_end_offset,
+                                        false, /* in_has_state */
+                                        Anvil::ResourceState() ));
+    }
+}
+
+/** Please see header for specification */
+void Anvil::BufferRangeStates::set_state(VkDeviceSize                in_start_offset,
+                                         VkDeviceSize                in_end_offset,
+                                         const Anvil::ResourceState& in_state)
+{
+    bool new_range_added = false;
+
+    anvil_assert(in_start_offset < in_end_offset);
+
+    m_temp_ranges.clear();
+
+    /* Rebuild the range list, clipping ranges which overlap with the updated region & inserting
+     * the new range in between. Adjacent ranges of equal state are merged on the way. */
+    auto append_range = [this](const Range& in_range)
+    {
+        if (!m_temp_ranges.empty()                                 &&
+             m_temp_ranges.back().end_offset == in_range.start_offset &&
+             m_temp_ranges.back().state      == in_range.state)
+        {
+            m_temp_ranges.back().end_offset = in_range.end_offset;
+        }
+        else
+        {
+            m_temp_ranges.push_back(in_range);
+        }
+    };
+
+    for (const auto& current_range : m_ranges)
+    {
+        if (current_range.end_offset <= in_start_offset)
+        {
+            append_range(current_range);
+
+            continue;
+        }
+
+        if (current_range.start_offset >= in_end_offset)
+        {
+            if (!new_range_added)
+            {
+                append_range(Range(in_start_offset,
+                                   in_end_offset,
+                                   true, /* in_has_state */
+                                   in_state) );
+
+                new_range_added = true;
+            }
+
+            append_range(current_range);
+
+            continue;
+        }
+
+        /* The range overlaps with the updated region. Preserve the parts which stick out of it. */
+        if (current_range.start_offset < in_start_offset)
+        {
+            append_range(Range(current_range.start_offset,
+                               in_start_offset,
+                               true, /* in_has_state */
+                               current_range.state) );
+        }
+
+        if (!new_range_added)
+        {
+            append_range(Range(in_start_offset,
+                               in_end_offset,
+                               true, /* in_has_state */
+                               in_state) );
+
+            new_range_added = true;
+        }
+
+        if (current_range.end_offset > in_end_offset)
+        {
+            append_range(Range(in_end_offset,
+                               current_range.end_offset,
+                               true, /* in_has_state */
+                               current_range.state) );
+        }
+    }
+
+    if (!new_range_added)
+    {
+        append_range(Range(in_start_offset,
+                           in_end_offset,
+                           true, /* in_has_state */
+                           in_state) );
+    }
+
+    m_ranges.swap(m_temp_ranges);
+}
+
+
+/** Please see header for specification */
+Anvil::ResourceStateTracker::ResourceStateTracker()
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::ResourceStateTracker::~ResourceStateTracker()
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+void Anvil::ResourceStateTracker::add_aliasing_dependency(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                                          const Anvil::ResourceState&    in_aliased_state)
+{
+    std::shared_ptr<Anvil::Buffer> base_buffer_ptr = in_buffer_ptr->get_base_buffer();
+    const VkDeviceSize             start_offset    = in_buffer_ptr->get_start_offset();
+    const VkDeviceSize             end_offset      = start_offset + in_buffer_ptr->get_size();
+    BufferData&                    buffer_data     = get_buffer_data(base_buffer_ptr,
+                                                                     start_offset,
+                                                                     end_offset);
+
+    m_temp_ranges.clear();
+
+    buffer_data.current_states.get_states(start_offset,
+                                          end_offset,
+                                         &m_temp_ranges);
+
+    for (const auto& current_range : m_temp_ranges)
+    {
+        buffer_data.current_states.set_state(current_range.start_offset,
+                                             current_range.end_offset,
+                                             Anvil::ResourceState(current_range.state.access_mask | in_aliased_state.access_mask,
+                                                                  current_range.state.layout,
+                                                                  current_range.state.stage_mask  | in_aliased_state.stage_mask) );
+    }
+}
+
+/** Please see header for specification */
+void Anvil::ResourceStateTracker::add_aliasing_dependency(std::shared_ptr<Anvil::Image> in_image_ptr,
+                                                          const Anvil::ResourceState&   in_aliased_state)
+{
+    ImageData&     image_data = get_image_data(in_image_ptr);
+    const uint32_t n_layers   = in_image_ptr->get_image_n_layers ();
+    const uint32_t n_mipmaps  = in_image_ptr->get_image_n_mipmaps();
+
+    for (uint32_t n_mipmap = 0;
+                  n_mipmap < n_mipmaps;
+                ++n_mipmap)
+    {
+        for (uint32_t n_layer = 0;
+                      n_layer < n_layers;
+                    ++n_layer)
+        {
+            /* Aliased memory does not hold valid contents of the image, so the layout it was left in is irrelevant */
+            ImageSubresourceData& subresource_data = get_image_subresource_data(image_data,
+                                                                                n_layer,
+                                                                                n_mipmap,
+                                                                                true); /* in_discard_contents */
+
+            subresource_data.current_state.access_mask |= in_aliased_state.access_mask;
+            subresource_data.current_state.stage_mask  |= in_aliased_state.stage_mask;
+        }
+    }
+}
+
+/** Please see header for specification */
+bool Anvil::ResourceStateTracker::commit()
+{
+    bool result = true;
+
+    for (auto& buffer_iterator : m_buffers)
+    {
+        Anvil::Buffer*               buffer_ptr = buffer_iterator.first;
+        std::unique_lock<std::mutex> lock      (buffer_ptr->m_tracked_states_mutex);
+
+        for (const auto& current_range : buffer_iterator.second.current_states.get_ranges() )
+        {
+            buffer_ptr->m_tracked_states.set_state(current_range.start_offset,
+                                                   current_range.end_offset,
+                                                   current_range.state);
+        }
+    }
+
+    for (auto& image_iterator : m_images)
+    {
+        Anvil::Image*   image_ptr  = image_iterator.first;
+        const uint32_t  n_layers   = image_ptr->get_image_n_layers();
+        const uint32_t  n_mipmaps  = image_ptr->get_image_n_mipmaps();
+
+        for (uint32_t n_mipmap = 0;
+                      n_mipmap < n_mipmaps;
+                    ++n_mipmap)
+        {
+            for (uint32_t n_layer = 0;
+                          n_layer < n_layers;
+                        ++n_layer)
+            {
+                const ImageSubresourceData& subresource_data = image_iterator.second.subresources.at(n_mipmap * n_layers + n_layer);
+
+                if (!subresource_data.is_used)
+                {
+                    continue;
+                }
+
+                /* The command buffer's barriers were recorded assuming the subresource is in a specific layout. If
+                 * another command buffer, submitted in the meantime, left it in a different layout, the barriers
+                 * are no longer valid. */
+                if (subresource_data.initial_state.layout                                         != VK_IMAGE_LAYOUT_UNDEFINED &&
+                    image_ptr->get_tracked_subresource_state(n_layer, n_mipmap).layout != subresource_data.initial_state.layout)
+                {
+                    result = false;
+                }
+
+                image_ptr->set_tracked_subresource_state(n_layer,
+                                                         n_mipmap,
+                                                         subresource_data.current_state);
+            }
+        }
+    }
+
+    return result;
+}
+
+/** Returns tracking data of a base buffer, making sure states of the <@param in_start_offset, @param in_end_offset)
+ *  region are known. Subranges which the command buffer has not touched yet are assumed to be in the state
+ *  committed by previous submissions.
+ **/
+Anvil::ResourceStateTracker::BufferData& Anvil::ResourceStateTracker::get_buffer_data(std::shared_ptr<Anvil::Buffer> in_base_buffer_ptr,
+                                                                                      VkDeviceSize                   in_start_offset,
+                                                                                      VkDeviceSize                   in_end_offset)
+{
+    auto buffer_iterator = m_buffers.find(in_base_buffer_ptr.get() );
+
+    if (buffer_iterator == m_buffers.end() )
+    {
+        m_buffers[in_base_buffer_ptr.get()].buffer_ptr = in_base_buffer_ptr;
+
+        buffer_iterator = m_buffers.find(in_base_buffer_ptr.get() );
+    }
+
+    BufferData& buffer_data = buffer_iterator->second;
+
+    m_temp_ranges.clear();
+
+    buffer_data.current_states.get_states(in_start_offset,
+                                          in_end_offset,
+                                         &m_temp_ranges);
+
+    for (uint32_t n_range = 0;
+                  n_range < static_cast<uint32_t>(m_temp_ranges.size() );
+                ++n_range)
+    {
+        if (m_temp_ranges[n_range].has_state)
+        {
+            continue;
+        }
+
+        m_temp_committed_ranges.clear();
+
+        {
+            std::unique_lock<std::mutex> lock(in_base_buffer_ptr->m_tracked_states_mutex);
+
+            in_base_buffer_ptr->m_tracked_states.get_states(m_temp_ranges[n_range].start_offset,
+                                                            m_temp_ranges[n_range].end_offset,
+                                                           &m_temp_committed_ranges);
+        }
+
+        for (const auto& committed_range : m_temp_committed_ranges)
+        {
+            buffer_data.initial_states.set_state(committed_range.start_offset,
+                                                 committed_range.end_offset,
+                                                 committed_range.state);
+            buffer_data.current_states.set_state(committed_range.start_offset,
+                                                 committed_range.end_offset,
+                                                 committed_range.state);
+        }
+    }
+
+    return buffer_data;
+}
+
+/** Computes a dependency required to safely access a resource, which is in state @param in_old_state,
+ *  the way described by @param in_new_state.
+ *
+ *  @param in_old_state            State the resource is in.
+ *  @param in_new_state            State the resource is going to be used in.
+ *  @param in_is_image             true if the resource is an image subresource, false if it's a buffer region.
+ *  @param out_src_stage_mask_ptr  Deref will be set to source stages the dependency must wait on.
+ *  @param out_src_access_mask_ptr Deref will be set to the source access mask of the barrier, if one is needed.
+ *  @param out_needs_barrier_ptr   Deref will be set to true if a buffer / image barrier is needed, or to false
+ *                                 if an execution dependency is enough.
+ *  @param out_updated_state_ptr   Deref will be set to the state the resource is going to be in after the
+ *                                 transition.
+ *
+ *  @return true if a dependency is needed, false otherwise.
+ **/
+bool Anvil::ResourceStateTracker::get_dependency(const Anvil::ResourceState& in_old_state,
+                                                 const Anvil::ResourceState& in_new_state,
+                                                 bool                        in_is_image,
+                                                 VkPipelineStageFlags*       out_src_stage_mask_ptr,
+                                                 VkAccessFlags*              out_src_access_mask_ptr,
+                                                 bool*                       out_needs_barrier_ptr,
+                                                 Anvil::ResourceState*       out_updated_state_ptr)
+{
+    const bool needs_layout_change = (in_is_image && in_old_state.layout != in_new_state.layout);
+    bool       result              = false;
+
+    *out_needs_barrier_ptr   = false;
+    *out_src_access_mask_ptr = 0;
+    *out_src_stage_mask_ptr  = 0;
+
+    if (!needs_layout_change               &&
+        !in_old_state.has_write_access()   &&
+        !in_new_state.has_write_access() )
+    {
+        /* Read-after-read. Previous writes, if any, have already been made available by the barrier which
+         * preceded the earlier reads. A barrier is only needed if the new reads happen at stages or through
+         * access types the data has not been made visible to yet. */
+        const bool is_covered = ((in_new_state.access_mask & ~in_old_state.access_mask) == 0 &&
+                                 (in_new_state.stage_mask  & ~in_old_state.stage_mask)  == 0);
+
+        if (!is_covered                     &&
+            in_old_state.stage_mask != 0)
+        {
+            *out_needs_barrier_ptr  = true;
+            *out_src_stage_mask_ptr = in_old_state.stage_mask;
+            result                  = true;
+        }
+
+        *out_updated_state_ptr = Anvil::ResourceState(in_old_state.access_mask | in_new_state.access_mask,
+                                                      in_new_state.layout,
+                                                      in_old_state.stage_mask  | in_new_state.stage_mask);
+    }
+    else
+    if (!needs_layout_change &&
+        !in_old_state.has_write_access() )
+    {
+        /* Write-after-read. An execution dependency is enough to prevent the hazard. */
+        if (in_old_state.stage_mask != 0)
+        {
+            *out_src_stage_mask_ptr = in_old_state.stage_mask;
+            result                  = true;
+        }
+
+        *out_updated_state_ptr = in_new_state;
+    }
+    else
+    {
+        /* Read-after-write, write-after-write or a layout transition. Only writes need to be made available. */
+        *out_needs_barrier_ptr   = true;
+        *out_src_access_mask_ptr = (in_old_state.has_write_access() ) ? in_old_state.access_mask
+                                                                      : 0;
+        *out_src_stage_mask_ptr  = (in_old_state.stage_mask != 0)     ? in_old_state.stage_mask
+                                                                      : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        *out_updated_state_ptr   = in_new_state;
+        result                   = true;
+    }
+
+    return result;
+}
+
+/** Returns tracking data of an image, creating it if the image has not been used by the command buffer yet. */
+Anvil::ResourceStateTracker::ImageData& Anvil::ResourceStateTracker::get_image_data(std::shared_ptr<Anvil::Image> in_image_ptr)
+{
+    auto image_iterator = m_images.find(in_image_ptr.get() );
+
+    if (image_iterator == m_images.end() )
+    {
+        ImageData& new_image_data = m_images[in_image_ptr.get()];
+
+        new_image_data.image_ptr = in_image_ptr;
+        new_image_data.subresources.resize(in_image_ptr->get_image_n_layers() * in_image_ptr->get_image_n_mipmaps() );
+
+        image_iterator = m_images.find(in_image_ptr.get() );
+    }
+
+    return image_iterator->second;
+}
+
+/** Returns tracking data of an image subresource. If the subresource has not been used by the command buffer yet,
+ *  it is assumed to be in the state committed by previous submissions.
+ *
+ *  @param in_image_data       Tracking data of the image.
+ *  @param in_n_layer          Index of the layer.
+ *  @param in_n_mipmap         Index of the mipmap.
+ *  @param in_discard_contents true if contents of the subresource are not going to be preserved. The layout
+ *                             the subresource is in at submission time is irrelevant in that case.
+ **/
+Anvil::ResourceStateTracker::ImageSubresourceData& Anvil::ResourceStateTracker::get_image_subresource_data(ImageData& in_image_data,
+                                                                                                          uint32_t   in_n_layer,
+                                                                                                          uint32_t   in_n_mipmap,
+                                                                                                          bool       in_discard_contents)
+{
+    ImageSubresourceData& result = in_image_data.subresources.at(in_n_mipmap * in_image_data.image_ptr->get_image_n_layers() + in_n_layer);
+
+    if (!result.is_used)
+    {
+        result.current_state = in_image_data.image_ptr->get_tracked_subresource_state(in_n_layer,
+                                                                                       in_n_mipmap);
+        result.initial_state = result.current_state;
+        result.is_used       = true;
+
+        if (in_discard_contents)
+        {
+            result.initial_state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+    }
+
+    return result;
+}
+
+/** Please see header for specification */
+void Anvil::ResourceStateTracker::reset()
+{
+    m_buffers.clear();
+    m_images.clear();
+}
+
+/** Please see header for specification */
+void Anvil::ResourceStateTracker::transition_buffer(std::shared_ptr<Anvil::Buffer>        in_buffer_ptr,
+                                                    VkDeviceSize                          in_offset,
+                                                    VkDeviceSize                          in_size,
+                                                    const Anvil::ResourceState&           in_new_state,
+                                                    VkPipelineStageFlags*                 out_src_stage_mask_ptr,
+                                                    std::vector<Anvil::BufferBarrierRef>* out_buffer_barriers_ptr)
+{
+    std::shared_ptr<Anvil::Buffer> base_buffer_ptr        = in_buffer_ptr->get_base_buffer();
+    const VkDeviceSize             start_offset           = in_buffer_ptr->get_start_offset() + in_offset;
+    const VkDeviceSize             end_offset             = (in_size == VK_WHOLE_SIZE) ? (in_buffer_ptr->get_start_offset() + in_buffer_ptr->get_size() )
+                                                                                       : (start_offset                          + in_size);
+    VkDeviceSize                   pending_barrier_end    = 0;
+    VkDeviceSize                   pending_barrier_start  = 0;
+    VkAccessFlags                  pending_barrier_access = 0;
+    bool                           has_pending_barrier    = false;
+
+    anvil_assert(start_offset < end_offset);
+
+    BufferData& buffer_data = get_buffer_data(base_buffer_ptr,
+                                              start_offset,
+                                              end_offset);
+
+    m_temp_ranges.clear();
+
+    buffer_data.current_states.get_states(start_offset,
+                                          end_offset,
+                                         &m_temp_ranges);
+
+    /* Work out the dependency. Barriers for adjacent subranges which share the source access mask
+     * are coalesced. */
+    for (const auto& current_range : m_temp_ranges)
+    {
+        bool                 needs_barrier   = false;
+        VkAccessFlags        src_access_mask = 0;
+        VkPipelineStageFlags src_stage_mask  = 0;
+        Anvil::ResourceState updated_state;
+
+        if (get_dependency(current_range.state,
+                           in_new_state,
+                           false, /* in_is_image */
+                          &src_stage_mask,
+                          &src_access_mask,
+                          &needs_barrier,
+                          &updated_state) )
+        {
+            *out_src_stage_mask_ptr |= src_stage_mask;
+
+            if (needs_barrier)
+            {
+                if (has_pending_barrier                                  &&
+                    pending_barrier_end    == current_range.start_offset &&
+                    pending_barrier_access == src_access_mask)
+                {
+                    pending_barrier_end = current_range.end_offset;
+                }
+                else
+                {
+                    if (has_pending_barrier)
+                    {
+                        out_buffer_barriers_ptr->push_back(Anvil::BufferBarrierRef(pending_barrier_access,
+                                                                                   in_new_state.access_mask,
+                                                                                   VK_QUEUE_FAMILY_IGNORED,
+                                                                                   VK_QUEUE_FAMILY_IGNORED,
+                                                                                   base_buffer_ptr->get_buffer(),
+                                                                                   pending_barrier_start,
+                                                                                   pending_barrier_end - pending_barrier_start) );
+                    }
+
+                    has_pending_barrier    = true;
+                    pending_barrier_access = src_access_mask;
+                    pending_barrier_end    = current_range.end_offset;
+                    pending_barrier_start  = current_range.start_offset;
+                }
+            }
+        }
+
+        buffer_data.current_states.set_state(current_range.start_offset,
+                                             current_range.end_offset,
+                                             updated_state);
+    }
+
+    if (has_pending_barrier)
+    {
+        out_buffer_barriers_ptr->push_back(Anvil::BufferBarrierRef(pending_barrier_access,
+                                                                   in_new_state.access_mask,
+                                                                   VK_QUEUE_FAMILY_IGNORED,
+                                                                   VK_QUEUE_FAMILY_IGNORED,
+                                                                   base_buffer_ptr->get_buffer(),
+                                                                   pending_barrier_start,
+                                                                   pending_barrier_end - pending_barrier_start) );
+    }
+}
+
+/** Please see header for specification */
+void Anvil::ResourceStateTracker::transition_image(std::shared_ptr<Anvil::Image>        in_image_ptr,
+                                                   const VkImageSubresourceRange&       in_subresource_range,
+                                                   const Anvil::ResourceState&          in_new_state,
+                                                   bool                                 in_discard_contents,
+                                                   VkPipelineStageFlags*                out_src_stage_mask_ptr,
+                                                   std::vector<Anvil::ImageBarrierRef>* out_image_barriers_ptr)
+{
+    const uint32_t image_n_layers  = in_image_ptr->get_image_n_layers ();
+    const uint32_t image_n_mipmaps = in_image_ptr->get_image_n_mipmaps();
+    const uint32_t n_layers        = (in_subresource_range.layerCount == VK_REMAINING_ARRAY_LAYERS) ? (image_n_layers  - in_subresource_range.baseArrayLayer)
+                                                                                                    : in_subresource_range.layerCount;
+    const uint32_t n_mipmaps       = (in_subresource_range.levelCount == VK_REMAINING_MIP_LEVELS)   ? (image_n_mipmaps - in_subresource_range.baseMipLevel)
+                                                                                                    : in_subresource_range.levelCount;
+
+    anvil_assert(in_subresource_range.baseArrayLayer + n_layers  <= image_n_layers);
+    anvil_assert(in_subresource_range.baseMipLevel   + n_mipmaps <= image_n_mipmaps);
+
+    ImageData& image_data = get_image_data(in_image_ptr);
+
+    m_temp_pending_image_barriers.clear();
+
+    for (uint32_t n_mipmap = in_subresource_range.baseMipLevel;
+                  n_mipmap < in_subresource_range.baseMipLevel + n_mipmaps;
+                ++n_mipmap)
+    {
+        bool          has_run             = false;
+        uint32_t      run_base_layer      = 0;
+        VkImageLayout run_old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkAccessFlags run_src_access_mask = 0;
+
+        /* Barriers for consecutive layers sharing the old layout & source access mask are coalesced into
+         * a single barrier. If the layer run matches a run of the previous mip, the latter is extended. */
+        auto flush_run = [&](uint32_t in_end_layer)
+        {
+            bool merged = false;
+
+            for (auto& pending_barrier : m_temp_pending_image_barriers)
+            {
+                if (pending_barrier.base_mipmap + pending_barrier.n_mipmaps == n_mipmap                           &&
+                    pending_barrier.base_layer                              == run_base_layer                     &&
+                    pending_barrier.n_layers                                == in_end_layer - run_base_layer      &&
+                    pending_barrier.old_layout                              == run_old_layout                     &&
+                    pending_barrier.src_access_mask                         == run_src_access_mask)
+                {
+                    ++pending_barrier.n_mipmaps;
+
+                    merged = true;
+                    break;
+                }
+            }
+
+            if (!merged)
+            {
+                PendingImageBarrier new_barrier;
+
+                new_barrier.base_layer      = run_base_layer;
+                new_barrier.base_mipmap     = n_mipmap;
+                new_barrier.n_layers        = in_end_layer - run_base_layer;
+                new_barrier.n_mipmaps       = 1;
+                new_barrier.old_layout      = run_old_layout;
+                new_barrier.src_access_mask = run_src_access_mask;
+
+                m_temp_pending_image_barriers.push_back(new_barrier);
+            }
+
+            has_run = false;
+        };
+
+        for (uint32_t n_layer = in_subresource_range.baseArrayLayer;
+                      n_layer < in_subresource_range.baseArrayLayer + n_layers;
+                    ++n_layer)
+        {
+            ImageSubresourceData& subresource_data = get_image_subresource_data(image_data,
+                                                                                n_layer,
+                                                                                n_mipmap,
+                                                                                in_discard_contents);
+            bool                  needs_barrier    = false;
+            Anvil::ResourceState  old_state;
+            VkAccessFlags         src_access_mask  = 0;
+            VkPipelineStageFlags  src_stage_mask   = 0;
+
+            old_state = subresource_data.current_state;
+
+            if (in_discard_contents)
+            {
+                old_state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+
+            get_dependency(old_state,
+                           in_new_state,
+                           true, /* in_is_image */
+                          &src_stage_mask,
+                          &src_access_mask,
+                          &needs_barrier,
+                          &subresource_data.current_state);
+
+            *out_src_stage_mask_ptr |= src_stage_mask;
+
+            if (has_run                                      &&
+                (!needs_barrier                              ||
+                 run_old_layout      != old_state.layout     ||
+                 run_src_access_mask != src_access_mask) )
+            {
+                flush_run(n_layer);
+            }
+
+            if (needs_barrier &&
+                !has_run)
+            {
+                has_run             = true;
+                run_base_layer      = n_layer;
+                run_old_layout      = old_state.layout;
+                run_src_access_mask = src_access_mask;
+            }
+        }
+
+        if (has_run)
+        {
+            flush_run(in_subresource_range.baseArrayLayer + n_layers);
+        }
+    }
+
+    for (const auto& pending_barrier : m_temp_pending_image_barriers)
+    {
+        VkImageSubresourceRange barrier_subresource_range;
+
+        barrier_subresource_range.aspectMask     = in_subresource_range.aspectMask;
+        barrier_subresource_range.baseArrayLayer = pending_barrier.base_layer;
+        barrier_subresource_range.baseMipLevel   = pending_barrier.base_mipmap;
+        barrier_subresource_range.layerCount     = pending_barrier.n_layers;
+        barrier_subresource_range.levelCount     = pending_barrier.n_mipmaps;
+
+        out_image_barriers_ptr->push_back(Anvil::ImageBarrierRef(pending_barrier.src_access_mask,
+                                                                 in_new_state.access_mask,
+                                                                 pending_barrier.old_layout,
+                                                                 in_new_state.layout,
+                                                                 VK_QUEUE_FAMILY_IGNORED,
+                                                                 VK_QUEUE_FAMILY_IGNORED,
+                                                                 in_image_ptr->get_image(),
+                                                                 barrier_subresource_range) );
+    }
+}
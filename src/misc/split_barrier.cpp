@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2017 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+#include "misc/debug.h"
+#include "misc/event_pool.h"
+#include "misc/split_barrier.h"
+#include "wrappers/command_buffer.h"
+#include "wrappers/device.h"
+#include "wrappers/event.h"
+
+
+/** Please see header for specification */
+Anvil::SplitBarrier::SplitBarrier(std::weak_ptr<Anvil::BaseDevice> in_device_ptr)
+    :m_device_ptr    (in_device_ptr),
+     m_src_stage_mask(0)
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+Anvil::SplitBarrier::~SplitBarrier()
+{
+    anvil_assert(!is_pending() );
+}
+
+/** Please see header for specification */
+bool Anvil::SplitBarrier::begin(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                                VkPipelineStageFlags                      in_src_stage_mask)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    std::shared_ptr<Anvil::Event>      event_ptr;
+    bool                               result           (false);
+
+    if (is_pending() )
+    {
+        anvil_assert(!is_pending() );
+
+        goto end;
+    }
+
+    event_ptr = device_locked_ptr->get_event_pool()->get_event();
+
+    if (event_ptr == nullptr)
+    {
+        anvil_assert(false);
+
+        goto end;
+    }
+
+    if (!in_cmd_buffer_ptr->record_set_event(event_ptr,
+                                             in_src_stage_mask) )
+    {
+        goto end;
+    }
+
+    /* The event must not return to the pool before the command buffer finishes executing */
+    in_cmd_buffer_ptr->fast().retain(event_ptr);
+
+    m_event_ptr      = event_ptr;
+    m_src_stage_mask = in_src_stage_mask;
+
+    result = true;
+end:
+    return result;
+}
+
+/** Please see header for specification */
+bool Anvil::SplitBarrier::end(std::shared_ptr<Anvil::CommandBufferBase> in_cmd_buffer_ptr,
+                              VkPipelineStageFlags                      in_dst_stage_mask,
+                              uint32_t                                  in_memory_barrier_count,
+                              const MemoryBarrier* const                in_memory_barriers_ptr,
+                              uint32_t                                  in_buffer_memory_barrier_count,
+                              const BufferBarrier* const                in_buffer_memory_barriers_ptr,
+                              uint32_t                                  in_image_memory_barrier_count,
+                              const ImageBarrier* const                 in_image_memory_barriers_ptr)
+{
+    bool result = false;
+
+    if (!is_pending() )
+    {
+        anvil_assert(is_pending() );
+
+        goto end;
+    }
+
+    if (!in_cmd_buffer_ptr->record_wait_events(1, /* in_event_count */
+                                              &m_event_ptr,
+                                               m_src_stage_mask,
+                                               in_dst_stage_mask,
+                                               in_memory_barrier_count,
+                                               in_memory_barriers_ptr,
+                                               in_buffer_memory_barrier_count,
+                                               in_buffer_memory_barriers_ptr,
+                                               in_image_memory_barrier_count,
+                                               in_image_memory_barriers_ptr) )
+    {
+        goto end;
+    }
+
+    /* Reset the event once all preceding commands, including the wait, have executed, so that the command
+     * buffers can be resubmitted. Subsequent commands do not wait on the reset. */
+    if (!in_cmd_buffer_ptr->record_reset_event(m_event_ptr,
+                                               VK_PIPELINE_STAGE_ALL_COMMANDS_BIT) )
+    {
+        goto end;
+    }
+
+    in_cmd_buffer_ptr->fast().retain(m_event_ptr);
+
+    m_event_ptr.reset();
+    m_src_stage_mask = 0;
+
+    result = true;
+end:
+    return result;
+}
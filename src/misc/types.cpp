@@ -780,6 +780,19 @@ bool Anvil::operator==(const Anvil::QueueFamilyInfo& in1,
             in1.n_timestamp_bits                      == in2.n_timestamp_bits);
 }
 
+/** Please see header for specification */
+bool Anvil::ResourceState::has_write_access() const
+{
+    const VkAccessFlags write_access_mask = VK_ACCESS_SHADER_WRITE_BIT                   |
+                                            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT         |
+                                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                            VK_ACCESS_TRANSFER_WRITE_BIT                 |
+                                            VK_ACCESS_HOST_WRITE_BIT                     |
+                                            VK_ACCESS_MEMORY_WRITE_BIT;
+
+    return (access_mask & write_access_mask) != 0;
+}
+
 /** Please see header for specification */
 Anvil::ShaderModuleStageEntryPoint::ShaderModuleStageEntryPoint()
 {
@@ -2048,3 +2061,106 @@ const char* Anvil::Utils::get_raw_string(VkStencilOp stencil_op)
     return result;
 }
 
+/* Please see header for specification */
+Anvil::ResourceState Anvil::Utils::get_resource_state_for_resource_usage(Anvil::ResourceUsage in_usage)
+{
+    static const Anvil::ResourceState states[] =
+    {
+        /* RESOURCE_USAGE_COLOR_ATTACHMENT */
+        Anvil::ResourceState(VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                             VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT),
+
+        /* RESOURCE_USAGE_COMPUTE_SHADER_READ */
+        Anvil::ResourceState(VK_ACCESS_SHADER_READ_BIT,
+                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT),
+
+        /* RESOURCE_USAGE_COMPUTE_SHADER_STORAGE */
+        Anvil::ResourceState(VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                             VK_IMAGE_LAYOUT_GENERAL,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT),
+
+        /* RESOURCE_USAGE_DEPTH_STENCIL_ATTACHMENT */
+        Anvil::ResourceState(VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                             VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                             VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT),
+
+        /* RESOURCE_USAGE_DEPTH_STENCIL_READ_ONLY */
+        Anvil::ResourceState(VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+                             VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                             VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT),
+
+        /* RESOURCE_USAGE_FRAGMENT_SHADER_READ */
+        Anvil::ResourceState(VK_ACCESS_SHADER_READ_BIT,
+                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT),
+
+        /* RESOURCE_USAGE_FRAGMENT_SHADER_STORAGE */
+        Anvil::ResourceState(VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                             VK_IMAGE_LAYOUT_GENERAL,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT),
+
+        /* RESOURCE_USAGE_HOST_READ */
+        Anvil::ResourceState(VK_ACCESS_HOST_READ_BIT,
+                             VK_IMAGE_LAYOUT_GENERAL,
+                             VK_PIPELINE_STAGE_HOST_BIT),
+
+        /* RESOURCE_USAGE_INDEX_BUFFER */
+        Anvil::ResourceState(VK_ACCESS_INDEX_READ_BIT,
+                             VK_IMAGE_LAYOUT_UNDEFINED,
+                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT),
+
+        /* RESOURCE_USAGE_INDIRECT_BUFFER */
+        Anvil::ResourceState(VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                             VK_IMAGE_LAYOUT_UNDEFINED,
+                             VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT),
+
+        /* RESOURCE_USAGE_INPUT_ATTACHMENT */
+        Anvil::ResourceState(VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT),
+
+        /* RESOURCE_USAGE_PRESENT */
+        Anvil::ResourceState(0, /* in_access_mask */
+                             VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT),
+
+        /* RESOURCE_USAGE_TRANSFER_SRC */
+        Anvil::ResourceState(VK_ACCESS_TRANSFER_READ_BIT,
+                             VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT),
+
+        /* RESOURCE_USAGE_TRANSFER_DST */
+        Anvil::ResourceState(VK_ACCESS_TRANSFER_WRITE_BIT,
+                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT),
+
+        /* RESOURCE_USAGE_UNIFORM_BUFFER */
+        Anvil::ResourceState(VK_ACCESS_UNIFORM_READ_BIT,
+                             VK_IMAGE_LAYOUT_UNDEFINED,
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT                  |
+                             VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT    |
+                             VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT |
+                             VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT                |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT                |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT),
+
+        /* RESOURCE_USAGE_VERTEX_BUFFER */
+        Anvil::ResourceState(VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+                             VK_IMAGE_LAYOUT_UNDEFINED,
+                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT),
+
+        /* RESOURCE_USAGE_VERTEX_SHADER_READ */
+        Anvil::ResourceState(VK_ACCESS_SHADER_READ_BIT,
+                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             VK_PIPELINE_STAGE_VERTEX_SHADER_BIT),
+    };
+    static const uint32_t n_states = sizeof(states) / sizeof(states[0]);
+
+    static_assert(n_states == RESOURCE_USAGE_COUNT,
+                  "Resource usage state table needs to be updated");
+    anvil_assert (in_usage < n_states);
+
+    return states[in_usage];
+}
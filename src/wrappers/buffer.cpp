@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/buffer.h"
 #include "wrappers/command_buffer.h"
@@ -136,9 +137,9 @@ Anvil::Buffer::~Buffer()
     {
         std::shared_ptr<BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyBuffer(device_locked_ptr->get_device_vk(),
-                        m_buffer,
-                        nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_BUFFER,
+                                              m_buffer);
 
         m_buffer = VK_NULL_HANDLE;
     }
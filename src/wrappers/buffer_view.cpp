@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/buffer.h"
 #include "wrappers/buffer_view.h"
@@ -70,9 +71,9 @@ Anvil::BufferView::~BufferView()
 {
     std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-    vkDestroyBufferView(device_locked_ptr->get_device_vk(),
-                        m_buffer_view,
-                        nullptr /* pAllocator */);
+    Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                          Anvil::OBJECT_TYPE_BUFFER_VIEW,
+                                          m_buffer_view);
 
     m_buffer_view = VK_NULL_HANDLE;
 
@@ -22,6 +22,7 @@
 
 #include "misc/callbacks.h"
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "wrappers/buffer.h"
 #include "wrappers/command_buffer.h"
 #include "wrappers/command_pool.h"
@@ -37,6 +38,7 @@
 #include "wrappers/pipeline_layout.h"
 #include "wrappers/query_pool.h"
 #include "wrappers/render_pass.h"
+#include <algorithm>
 
 
 /* Command stashing should be enabled by default for builds that care. */
@@ -819,13 +821,17 @@ Anvil::CommandBufferBase::WriteTimestampCommand::WriteTimestampCommand(VkPipelin
 Anvil::CommandBufferBase::CommandBufferBase(std::weak_ptr<Anvil::BaseDevice>    device_ptr,
                                             std::shared_ptr<Anvil::CommandPool> parent_command_pool_ptr,
                                             Anvil::CommandBufferType            type)
-    :CallbacksSupportProvider (COMMAND_BUFFER_CALLBACK_ID_COUNT),
-     m_command_buffer         (VK_NULL_HANDLE),
-     m_device_ptr             (device_ptr),
-     m_is_renderpass_active   (false),
-     m_parent_command_pool_ptr(parent_command_pool_ptr),
-     m_recording_in_progress  (false),
-     m_type                   (type)
+    :CallbacksSupportProvider           (COMMAND_BUFFER_CALLBACK_ID_COUNT),
+     m_command_buffer                   (VK_NULL_HANDLE),
+     m_device_ptr                       (device_ptr),
+     m_is_renderpass_active             (false),
+     m_parent_command_pool_ptr          (parent_command_pool_ptr),
+     m_recording_in_progress            (false),
+     m_type                             (type),
+     m_batched_dependency_flags         (0),
+     m_batched_dst_stage_mask           (0),
+     m_batched_src_stage_mask           (0),
+     m_pipeline_barrier_batching_enabled(false)
 {
     anvil_assert(parent_command_pool_ptr != nullptr);
 }
@@ -847,10 +853,10 @@ Anvil::CommandBufferBase::~CommandBufferBase()
         std::shared_ptr<Anvil::BaseDevice>  device_locked_ptr      (m_device_ptr);
 
         /* Physically free the command buffer we own */
-        vkFreeCommandBuffers(device_locked_ptr->get_device_vk(),
-                             command_pool_locked_ptr->get_command_pool(),
-                             1, /* commandBufferCount */
-                            &m_command_buffer);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_COMMAND_BUFFER,
+                                              m_command_buffer,
+                                              command_pool_locked_ptr->get_command_pool() );
 
         m_command_buffer = VK_NULL_HANDLE;
     }
@@ -862,6 +868,40 @@ Anvil::CommandBufferBase::~CommandBufferBase()
     #endif
 }
 
+/* Please see header for specification */
+void Anvil::CommandBufferBase::add_aliasing_dependency(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                                       const Anvil::ResourceState&    in_aliased_state)
+{
+    anvil_assert(m_recording_in_progress);
+
+    m_resource_state_tracker.add_aliasing_dependency(in_buffer_ptr,
+                                                     in_aliased_state);
+}
+
+/* Please see header for specification */
+void Anvil::CommandBufferBase::add_aliasing_dependency(std::shared_ptr<Anvil::Image> in_image_ptr,
+                                                       const Anvil::ResourceState&   in_aliased_state)
+{
+    anvil_assert(m_recording_in_progress);
+
+    m_resource_state_tracker.add_aliasing_dependency(in_image_ptr,
+                                                     in_aliased_state);
+}
+
+/** Drops all pipeline barriers which have been batched but not flushed yet. */
+void Anvil::CommandBufferBase::clear_batched_pipeline_barriers()
+{
+    m_batched_buffer_barrier_refs.clear();
+    m_batched_buffer_barriers.clear    ();
+    m_batched_image_barrier_refs.clear ();
+    m_batched_image_barriers.clear     ();
+    m_batched_memory_barriers.clear    ();
+
+    m_batched_dependency_flags = 0;
+    m_batched_dst_stage_mask   = 0;
+    m_batched_src_stage_mask   = 0;
+}
+
 #ifdef STORE_COMMAND_BUFFER_COMMANDS
     /** Clears the command vector by releasing all command descriptors back to the heap memory. */
     void Anvil::CommandBufferBase::clear_commands()
@@ -870,6 +910,230 @@ Anvil::CommandBufferBase::~CommandBufferBase()
     }
 #endif
 
+/** Commits states, which resources transitioned with record_transition() have been left in by
+ *  the command buffer, back to the resources. Called by Anvil::Queue at submission time.
+ *
+ *  @return true if the states the command buffer assumed the resources were in at recording
+ *          time are consistent with states committed by previous submissions, false otherwise.
+ **/
+bool Anvil::CommandBufferBase::commit_resource_states()
+{
+    anvil_assert(!m_recording_in_progress);
+
+    return m_resource_state_tracker.commit();
+}
+
+/** Tells whether the buffer regions described by @param in_barrier1 and @param in_barrier2 overlap. */
+static bool do_buffer_barriers_overlap(const VkBufferMemoryBarrier& in_barrier1,
+                                       const VkBufferMemoryBarrier& in_barrier2)
+{
+    const VkDeviceSize end1 = (in_barrier1.size == VK_WHOLE_SIZE) ? VK_WHOLE_SIZE
+                                                                  : in_barrier1.offset + in_barrier1.size;
+    const VkDeviceSize end2 = (in_barrier2.size == VK_WHOLE_SIZE) ? VK_WHOLE_SIZE
+                                                                  : in_barrier2.offset + in_barrier2.size;
+
+    return (in_barrier1.buffer == in_barrier2.buffer &&
+            in_barrier1.offset <  end2               &&
+            in_barrier2.offset <  end1);
+}
+
+/** Tells whether the image subresource ranges described by @param in_barrier1 and @param in_barrier2 overlap. */
+static bool do_image_barriers_overlap(const VkImageMemoryBarrier& in_barrier1,
+                                      const VkImageMemoryBarrier& in_barrier2)
+{
+    const VkImageSubresourceRange& range1     = in_barrier1.subresourceRange;
+    const VkImageSubresourceRange& range2     = in_barrier2.subresourceRange;
+    const uint32_t                 layer_end1 = (range1.layerCount == VK_REMAINING_ARRAY_LAYERS) ? UINT32_MAX
+                                                                                                 : range1.baseArrayLayer + range1.layerCount;
+    const uint32_t                 layer_end2 = (range2.layerCount == VK_REMAINING_ARRAY_LAYERS) ? UINT32_MAX
+                                                                                                 : range2.baseArrayLayer + range2.layerCount;
+    const uint32_t                 mip_end1   = (range1.levelCount == VK_REMAINING_MIP_LEVELS)   ? UINT32_MAX
+                                                                                                 : range1.baseMipLevel + range1.levelCount;
+    const uint32_t                 mip_end2   = (range2.levelCount == VK_REMAINING_MIP_LEVELS)   ? UINT32_MAX
+                                                                                                 : range2.baseMipLevel + range2.levelCount;
+
+    return (in_barrier1.image                          == in_barrier2.image &&
+            (range1.aspectMask & range2.aspectMask)    != 0                 &&
+            range1.baseArrayLayer                      <  layer_end2        &&
+            range2.baseArrayLayer                      <  layer_end1        &&
+            range1.baseMipLevel                        <  mip_end2          &&
+            range2.baseMipLevel                        <  mip_end1);
+}
+
+/** Tells whether @param in_barrier refers to a buffer region, which overlaps with a region
+ *  described by any of the batched buffer barriers.
+ *
+ *  Such barriers must not be merged into a single vkCmdPipelineBarrier() call, since
+ *  the second barrier may depend on the first one.
+ **/
+bool Anvil::CommandBufferBase::does_batched_pipeline_barrier_overlap(const BufferBarrierRef& in_barrier) const
+{
+    bool result = false;
+
+    for (uint32_t n_batched_barrier = 0;
+                  n_batched_barrier < static_cast<uint32_t>(m_batched_buffer_barriers.size() ) && !result;
+                ++n_batched_barrier)
+    {
+        result = do_buffer_barriers_overlap(m_batched_buffer_barriers.at(n_batched_barrier).buffer_barrier_vk,
+                                            in_barrier.buffer_barrier_vk);
+    }
+
+    for (uint32_t n_batched_barrier = 0;
+                  n_batched_barrier < static_cast<uint32_t>(m_batched_buffer_barrier_refs.size() ) && !result;
+                ++n_batched_barrier)
+    {
+        result = do_buffer_barriers_overlap(m_batched_buffer_barrier_refs.at(n_batched_barrier).buffer_barrier_vk,
+                                            in_barrier.buffer_barrier_vk);
+    }
+
+    return result;
+}
+
+/** Tells whether @param in_barrier refers to an image subresource range, which overlaps with a range
+ *  described by any of the batched image barriers.
+ *
+ *  Such barriers must not be merged into a single vkCmdPipelineBarrier() call, since
+ *  the second barrier may depend on the first one (eg. consecutive layout transitions).
+ **/
+bool Anvil::CommandBufferBase::does_batched_pipeline_barrier_overlap(const ImageBarrierRef& in_barrier) const
+{
+    bool result = false;
+
+    for (uint32_t n_batched_barrier = 0;
+                  n_batched_barrier < static_cast<uint32_t>(m_batched_image_barriers.size() ) && !result;
+                ++n_batched_barrier)
+    {
+        result = do_image_barriers_overlap(m_batched_image_barriers.at(n_batched_barrier).image_barrier_vk,
+                                           in_barrier.image_barrier_vk);
+    }
+
+    for (uint32_t n_batched_barrier = 0;
+                  n_batched_barrier < static_cast<uint32_t>(m_batched_image_barrier_refs.size() ) && !result;
+                ++n_batched_barrier)
+    {
+        result = do_image_barriers_overlap(m_batched_image_barrier_refs.at(n_batched_barrier).image_barrier_vk,
+                                           in_barrier.image_barrier_vk);
+    }
+
+    return result;
+}
+
+/* Please see header for specification */
+bool Anvil::CommandBufferBase::flush_pipeline_barriers()
+{
+    const uint32_t n_buffer_barriers = static_cast<uint32_t>(m_batched_buffer_barriers.size() + m_batched_buffer_barrier_refs.size() );
+    const uint32_t n_image_barriers  = static_cast<uint32_t>(m_batched_image_barriers.size () + m_batched_image_barrier_refs.size () );
+    const uint32_t n_memory_barriers = static_cast<uint32_t>(m_batched_memory_barriers.size() );
+    bool           result            = false;
+
+    if (n_buffer_barriers == 0 &&
+        n_image_barriers  == 0 &&
+        n_memory_barriers == 0)
+    {
+        /* Nothing to flush */
+        result = true;
+
+        goto end;
+    }
+
+    if (!m_recording_in_progress)
+    {
+        anvil_assert(m_recording_in_progress);
+
+        goto end;
+    }
+
+    #ifdef STORE_COMMAND_BUFFER_COMMANDS
+    {
+        if (!m_command_stashing_disabled)
+        {
+            PipelineBarrierCommand command(m_batched_src_stage_mask,
+                                           m_batched_dst_stage_mask,
+                                           m_batched_dependency_flags,
+                                           static_cast<uint32_t>(m_batched_memory_barriers.size() ),
+                                           (m_batched_memory_barriers.size() > 0) ? &m_batched_memory_barriers.at(0) : nullptr,
+                                           static_cast<uint32_t>(m_batched_buffer_barriers.size() ),
+                                           (m_batched_buffer_barriers.size() > 0) ? &m_batched_buffer_barriers.at(0) : nullptr,
+                                           static_cast<uint32_t>(m_batched_image_barriers.size() ),
+                                           (m_batched_image_barriers.size () > 0) ? &m_batched_image_barriers.at (0) : nullptr);
+
+            command.buffer_barrier_refs = m_batched_buffer_barrier_refs;
+            command.image_barrier_refs  = m_batched_image_barrier_refs;
+
+            m_commands.push_back(command);
+        }
+    }
+    #endif
+
+    if (get_n_of_callback_subscribers(COMMAND_BUFFER_CALLBACK_ID_PIPELINE_BARRIER_COMMAND_RECORDED) > 0)
+    {
+        PipelineBarrierCommand                     command_data(m_batched_src_stage_mask,
+                                                                m_batched_dst_stage_mask,
+                                                                m_batched_dependency_flags,
+                                                                static_cast<uint32_t>(m_batched_memory_barriers.size() ),
+                                                                (m_batched_memory_barriers.size() > 0) ? &m_batched_memory_barriers.at(0) : nullptr,
+                                                                static_cast<uint32_t>(m_batched_buffer_barriers.size() ),
+                                                                (m_batched_buffer_barriers.size() > 0) ? &m_batched_buffer_barriers.at(0) : nullptr,
+                                                                static_cast<uint32_t>(m_batched_image_barriers.size() ),
+                                                                (m_batched_image_barriers.size () > 0) ? &m_batched_image_barriers.at (0) : nullptr);
+        PipelineBarrierCommandRecordedCallbackData callback_data(this,
+                                                                &command_data);
+
+        command_data.buffer_barrier_refs = m_batched_buffer_barrier_refs;
+        command_data.image_barrier_refs  = m_batched_image_barrier_refs;
+
+        callback(COMMAND_BUFFER_CALLBACK_ID_PIPELINE_BARRIER_COMMAND_RECORDED,
+                &callback_data);
+    }
+
+    /* The Vulkan descriptor vectors are only ever cleared, so that their storage can be reused between flushes. */
+    m_batched_buffer_barriers_vk.clear();
+    m_batched_image_barriers_vk.clear ();
+    m_batched_memory_barriers_vk.clear();
+
+    for (const auto& buffer_barrier : m_batched_buffer_barriers)
+    {
+        m_batched_buffer_barriers_vk.push_back(buffer_barrier.get_barrier_vk() );
+    }
+
+    for (const auto& buffer_barrier : m_batched_buffer_barrier_refs)
+    {
+        m_batched_buffer_barriers_vk.push_back(buffer_barrier.get_barrier_vk() );
+    }
+
+    for (const auto& image_barrier : m_batched_image_barriers)
+    {
+        m_batched_image_barriers_vk.push_back(image_barrier.get_barrier_vk() );
+    }
+
+    for (const auto& image_barrier : m_batched_image_barrier_refs)
+    {
+        m_batched_image_barriers_vk.push_back(image_barrier.get_barrier_vk() );
+    }
+
+    for (const auto& memory_barrier : m_batched_memory_barriers)
+    {
+        m_batched_memory_barriers_vk.push_back(memory_barrier.get_barrier_vk() );
+    }
+
+    vkCmdPipelineBarrier(m_command_buffer,
+                         m_batched_src_stage_mask,
+                         m_batched_dst_stage_mask,
+                         m_batched_dependency_flags,
+                         n_memory_barriers,
+                         (n_memory_barriers > 0) ? &m_batched_memory_barriers_vk.at(0) : nullptr,
+                         n_buffer_barriers,
+                         (n_buffer_barriers > 0) ? &m_batched_buffer_barriers_vk.at(0) : nullptr,
+                         n_image_barriers,
+                         (n_image_barriers  > 0) ? &m_batched_image_barriers_vk.at (0) : nullptr);
+
+    clear_batched_pipeline_barriers();
+
+    result = true;
+end:
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::CommandBufferBase::record_begin_query(std::shared_ptr<Anvil::QueryPool> in_query_pool_ptr,
                                                   Anvil::QueryIndex                 in_entry,
@@ -885,6 +1149,8 @@ bool Anvil::CommandBufferBase::record_begin_query(std::shared_ptr<Anvil::QueryPo
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -935,6 +1201,8 @@ bool Anvil::CommandBufferBase::record_bind_descriptor_sets(VkPipelineBindPoint
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -979,6 +1247,8 @@ bool Anvil::CommandBufferBase::record_bind_index_buffer(std::shared_ptr<Anvil::B
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1016,6 +1286,8 @@ bool Anvil::CommandBufferBase::record_bind_pipeline(VkPipelineBindPoint in_pipel
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     pipeline_vk = (in_pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE)  ? device_locked_ptr->get_compute_pipeline_manager()->get_compute_pipeline  (in_pipeline_id)
                 : (in_pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS) ? device_locked_ptr->get_graphics_pipeline_manager()->get_graphics_pipeline(in_pipeline_id)
                                                                               : VK_NULL_HANDLE;
@@ -1058,6 +1330,8 @@ bool Anvil::CommandBufferBase::record_bind_vertex_buffers(uint32_t
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1113,6 +1387,8 @@ bool Anvil::CommandBufferBase::record_blit_image(std::shared_ptr<Anvil::Image> i
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1164,6 +1440,8 @@ bool Anvil::CommandBufferBase::record_clear_attachments(uint32_t
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1210,6 +1488,8 @@ bool Anvil::CommandBufferBase::record_clear_color_image(std::shared_ptr<Anvil::I
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1258,6 +1538,8 @@ bool Anvil::CommandBufferBase::record_clear_depth_stencil_image(std::shared_ptr<
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1305,6 +1587,8 @@ bool Anvil::CommandBufferBase::record_copy_buffer(std::shared_ptr<Anvil::Buffer>
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1351,6 +1635,8 @@ bool Anvil::CommandBufferBase::record_copy_buffer_to_image(std::shared_ptr<Anvil
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1400,6 +1686,8 @@ bool Anvil::CommandBufferBase::record_copy_image(std::shared_ptr<Anvil::Image> i
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1450,6 +1738,8 @@ bool Anvil::CommandBufferBase::record_copy_image_to_buffer(std::shared_ptr<Anvil
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1500,6 +1790,8 @@ bool Anvil::CommandBufferBase::record_copy_query_pool_results(std::shared_ptr<An
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1550,6 +1842,8 @@ bool Anvil::CommandBufferBase::record_dispatch(uint32_t in_x,
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1591,6 +1885,8 @@ bool Anvil::CommandBufferBase::record_dispatch_indirect(std::shared_ptr<Anvil::B
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1632,6 +1928,8 @@ bool Anvil::CommandBufferBase::record_draw(uint32_t in_vertex_count,
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1678,6 +1976,8 @@ bool Anvil::CommandBufferBase::record_draw_indexed(uint32_t in_index_count,
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1725,6 +2025,8 @@ bool Anvil::CommandBufferBase::record_draw_indexed_indirect(std::shared_ptr<Anvi
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1773,6 +2075,8 @@ bool Anvil::CommandBufferBase::record_draw_indexed_indirect_count_AMD(std::share
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1824,6 +2128,8 @@ bool Anvil::CommandBufferBase::record_draw_indirect(std::shared_ptr<Anvil::Buffe
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1872,6 +2178,8 @@ bool Anvil::CommandBufferBase::record_draw_indirect_count_AMD(std::shared_ptr<An
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1915,6 +2223,8 @@ bool Anvil::CommandBufferBase::record_end_query(std::shared_ptr<Anvil::QueryPool
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -1956,6 +2266,8 @@ bool Anvil::CommandBufferBase::record_fill_buffer(std::shared_ptr<Anvil::Buffer>
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2003,6 +2315,60 @@ bool Anvil::CommandBufferBase::record_pipeline_barrier(VkPipelineStageFlags
         goto end;
     }
 
+    if (m_pipeline_barrier_batching_enabled &&
+       !m_is_renderpass_active)
+    {
+        bool should_flush = (m_batched_dependency_flags != static_cast<VkDependencyFlags>(in_by_region) ) ||
+                            does_batched_pipeline_barrier_overlap(in_memory_barrier_count);
+
+        for (uint32_t n_buffer_barrier = 0;
+                      n_buffer_barrier < in_buffer_memory_barrier_count && !should_flush;
+                    ++n_buffer_barrier)
+        {
+            should_flush = does_batched_pipeline_barrier_overlap(in_buffer_memory_barriers_ptr[n_buffer_barrier]);
+        }
+
+        for (uint32_t n_image_barrier = 0;
+                      n_image_barrier < in_image_memory_barrier_count && !should_flush;
+                    ++n_image_barrier)
+        {
+            should_flush = does_batched_pipeline_barrier_overlap(in_image_memory_barriers_ptr[n_image_barrier]);
+        }
+
+        if (should_flush)
+        {
+            flush_pipeline_barriers();
+        }
+
+        for (uint32_t n_buffer_barrier = 0;
+                      n_buffer_barrier < in_buffer_memory_barrier_count;
+                    ++n_buffer_barrier)
+        {
+            m_batched_buffer_barriers.push_back(in_buffer_memory_barriers_ptr[n_buffer_barrier]);
+        }
+
+        for (uint32_t n_image_barrier = 0;
+                      n_image_barrier < in_image_memory_barrier_count;
+                    ++n_image_barrier)
+        {
+            m_batched_image_barriers.push_back(in_image_memory_barriers_ptr[n_image_barrier]);
+        }
+
+        for (uint32_t n_memory_barrier = 0;
+                      n_memory_barrier < in_memory_barrier_count;
+                    ++n_memory_barrier)
+        {
+            m_batched_memory_barriers.push_back(in_memory_barriers_ptr[n_memory_barrier]);
+        }
+
+        m_batched_dependency_flags  = in_by_region;
+        m_batched_dst_stage_mask   |= in_dst_stage_mask;
+        m_batched_src_stage_mask   |= in_src_stage_mask;
+
+        result = true;
+        goto end;
+    }
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2079,6 +2445,148 @@ end:
     return result;
 }
 
+/* Please see header for specification */
+bool Anvil::CommandBufferBase::record_pipeline_barrier(VkPipelineStageFlags          in_src_stage_mask,
+                                                       VkPipelineStageFlags          in_dst_stage_mask,
+                                                       VkBool32                      in_by_region,
+                                                       uint32_t                      in_memory_barrier_count,
+                                                       const MemoryBarrier* const    in_memory_barriers_ptr,
+                                                       uint32_t                      in_buffer_memory_barrier_count,
+                                                       const BufferBarrierRef* const in_buffer_memory_barriers_ptr,
+                                                       uint32_t                      in_image_memory_barrier_count,
+                                                       const ImageBarrierRef*  const in_image_memory_barriers_ptr)
+{
+    /* NOTE: The command can be executed both inside and outside a renderpass */
+    VkMemoryBarrier memory_barriers_vk[16];
+    bool            result = false;
+
+    if (!m_recording_in_progress)
+    {
+        anvil_assert(m_recording_in_progress);
+
+        goto end;
+    }
+
+    if (m_pipeline_barrier_batching_enabled &&
+       !m_is_renderpass_active)
+    {
+        bool should_flush = (m_batched_dependency_flags != static_cast<VkDependencyFlags>(in_by_region) ) ||
+                            does_batched_pipeline_barrier_overlap(in_memory_barrier_count);
+
+        for (uint32_t n_buffer_barrier = 0;
+                      n_buffer_barrier < in_buffer_memory_barrier_count && !should_flush;
+                    ++n_buffer_barrier)
+        {
+            should_flush = does_batched_pipeline_barrier_overlap(in_buffer_memory_barriers_ptr[n_buffer_barrier]);
+        }
+
+        for (uint32_t n_image_barrier = 0;
+                      n_image_barrier < in_image_memory_barrier_count && !should_flush;
+                    ++n_image_barrier)
+        {
+            should_flush = does_batched_pipeline_barrier_overlap(in_image_memory_barriers_ptr[n_image_barrier]);
+        }
+
+        if (should_flush)
+        {
+            flush_pipeline_barriers();
+        }
+
+        m_batched_buffer_barrier_refs.insert(m_batched_buffer_barrier_refs.end(),
+                                             in_buffer_memory_barriers_ptr,
+                                             in_buffer_memory_barriers_ptr + in_buffer_memory_barrier_count);
+        m_batched_image_barrier_refs.insert (m_batched_image_barrier_refs.end(),
+                                             in_image_memory_barriers_ptr,
+                                             in_image_memory_barriers_ptr + in_image_memory_barrier_count);
+
+        for (uint32_t n_memory_barrier = 0;
+                      n_memory_barrier < in_memory_barrier_count;
+                    ++n_memory_barrier)
+        {
+            m_batched_memory_barriers.push_back(in_memory_barriers_ptr[n_memory_barrier]);
+        }
+
+        m_batched_dependency_flags  = in_by_region;
+        m_batched_dst_stage_mask   |= in_dst_stage_mask;
+        m_batched_src_stage_mask   |= in_src_stage_mask;
+
+        result = true;
+        goto end;
+    }
+
+    #ifdef STORE_COMMAND_BUFFER_COMMANDS
+    {
+        if (!m_command_stashing_disabled)
+        {
+            PipelineBarrierCommand command(in_src_stage_mask,
+                                           in_dst_stage_mask,
+                                           in_by_region,
+                                           in_memory_barrier_count,
+                                           in_memory_barriers_ptr,
+                                           0,        /* in_buffer_memory_barrier_count */
+                                           nullptr,  /* in_buffer_memory_barriers_ptr  */
+                                           0,        /* in_image_memory_barrier_count  */
+                                           nullptr); /* in_image_memory_barriers_ptr   */
+
+            command.buffer_barrier_refs.assign(in_buffer_memory_barriers_ptr,
+                                               in_buffer_memory_barriers_ptr + in_buffer_memory_barrier_count);
+            command.image_barrier_refs.assign (in_image_memory_barriers_ptr,
+                                               in_image_memory_barriers_ptr  + in_image_memory_barrier_count);
+
+            m_commands.push_back(command);
+        }
+    }
+    #endif
+
+    if (get_n_of_callback_subscribers(COMMAND_BUFFER_CALLBACK_ID_PIPELINE_BARRIER_COMMAND_RECORDED) > 0)
+    {
+        PipelineBarrierCommand                     command_data(in_src_stage_mask,
+                                                                in_dst_stage_mask,
+                                                                in_by_region,
+                                                                in_memory_barrier_count,
+                                                                in_memory_barriers_ptr,
+                                                                0,        /* in_buffer_memory_barrier_count */
+                                                                nullptr,  /* in_buffer_memory_barriers_ptr  */
+                                                                0,        /* in_image_memory_barrier_count  */
+                                                                nullptr); /* in_image_memory_barriers_ptr   */
+        PipelineBarrierCommandRecordedCallbackData callback_data(this,
+                                                                &command_data);
+
+        command_data.buffer_barrier_refs.assign(in_buffer_memory_barriers_ptr,
+                                                in_buffer_memory_barriers_ptr + in_buffer_memory_barrier_count);
+        command_data.image_barrier_refs.assign (in_image_memory_barriers_ptr,
+                                                in_image_memory_barriers_ptr  + in_image_memory_barrier_count);
+
+        callback(COMMAND_BUFFER_CALLBACK_ID_PIPELINE_BARRIER_COMMAND_RECORDED,
+                &callback_data);
+    }
+
+    anvil_assert(sizeof(memory_barriers_vk) / sizeof(memory_barriers_vk[0]) >= in_memory_barrier_count);
+
+    for (uint32_t n_memory_barrier = 0;
+                  n_memory_barrier < in_memory_barrier_count;
+                ++n_memory_barrier)
+    {
+        memory_barriers_vk[n_memory_barrier] = in_memory_barriers_ptr[n_memory_barrier].get_barrier_vk();
+    }
+
+    /* Ref descriptors are binary-compatible with their Vulkan counterparts, so no copies are needed. */
+    vkCmdPipelineBarrier(m_command_buffer,
+                         in_src_stage_mask,
+                         in_dst_stage_mask,
+                         in_by_region,
+                         in_memory_barrier_count,
+                         memory_barriers_vk,
+                         in_buffer_memory_barrier_count,
+                         reinterpret_cast<const VkBufferMemoryBarrier*>(in_buffer_memory_barriers_ptr),
+                         in_image_memory_barrier_count,
+                         reinterpret_cast<const VkImageMemoryBarrier*> (in_image_memory_barriers_ptr) );
+
+    result = true;
+end:
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::CommandBufferBase::record_push_constants(std::shared_ptr<Anvil::PipelineLayout> in_layout_ptr,
                                                      VkShaderStageFlags                     in_stage_flags,
@@ -2096,6 +2604,8 @@ bool Anvil::CommandBufferBase::record_push_constants(std::shared_ptr<Anvil::Pipe
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2141,6 +2651,8 @@ bool Anvil::CommandBufferBase::record_reset_event(std::shared_ptr<Anvil::Event>
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2181,6 +2693,8 @@ bool Anvil::CommandBufferBase::record_reset_query_pool(std::shared_ptr<Anvil::Qu
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2226,6 +2740,8 @@ bool Anvil::CommandBufferBase::record_resolve_image(std::shared_ptr<Anvil::Image
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2266,6 +2782,8 @@ bool Anvil::CommandBufferBase::record_set_blend_constants(const float in_blend_c
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2298,6 +2816,8 @@ bool Anvil::CommandBufferBase::record_set_depth_bias(float in_depth_bias_constan
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2333,6 +2853,8 @@ bool Anvil::CommandBufferBase::record_set_depth_bounds(float in_min_depth_bounds
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2372,6 +2894,8 @@ bool Anvil::CommandBufferBase::record_set_event(std::shared_ptr<Anvil::Event> in
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2404,6 +2928,8 @@ bool Anvil::CommandBufferBase::record_set_line_width(float in_line_width)
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2436,6 +2962,8 @@ bool Anvil::CommandBufferBase::record_set_scissor(uint32_t        in_first_sciss
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2471,6 +2999,8 @@ bool Anvil::CommandBufferBase::record_set_stencil_compare_mask(VkStencilFaceFlag
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2504,6 +3034,8 @@ bool Anvil::CommandBufferBase::record_set_stencil_reference(VkStencilFaceFlags i
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2537,6 +3069,8 @@ bool Anvil::CommandBufferBase::record_set_stencil_write_mask(VkStencilFaceFlags
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2571,6 +3105,8 @@ bool Anvil::CommandBufferBase::record_set_viewport(uint32_t          in_first_vi
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2592,6 +3128,137 @@ end:
     return result;
 }
 
+/* Please see header for specification */
+bool Anvil::CommandBufferBase::record_transition(std::shared_ptr<Anvil::Buffer> in_buffer_ptr,
+                                                 VkDeviceSize                   in_offset,
+                                                 VkDeviceSize                   in_size,
+                                                 Anvil::ResourceUsage           in_usage)
+{
+    const Anvil::ResourceState new_state      = Anvil::Utils::get_resource_state_for_resource_usage(in_usage);
+    bool                       result         = false;
+    VkPipelineStageFlags       src_stage_mask = 0;
+
+    if (!m_recording_in_progress)
+    {
+        anvil_assert(m_recording_in_progress);
+
+        goto end;
+    }
+
+    if (m_is_renderpass_active)
+    {
+        anvil_assert(!m_is_renderpass_active);
+
+        goto end;
+    }
+
+    m_transition_buffer_barriers.clear();
+    m_transition_image_barriers.clear ();
+
+    m_resource_state_tracker.transition_buffer(in_buffer_ptr,
+                                               in_offset,
+                                               in_size,
+                                               new_state,
+                                              &src_stage_mask,
+                                              &m_transition_buffer_barriers);
+
+    result = record_transition_barriers(src_stage_mask,
+                                        new_state.stage_mask);
+end:
+    return result;
+}
+
+/* Please see header for specification */
+bool Anvil::CommandBufferBase::record_transition(std::shared_ptr<Anvil::Image>  in_image_ptr,
+                                                 const VkImageSubresourceRange& in_subresource_range,
+                                                 Anvil::ResourceUsage           in_usage,
+                                                 bool                           in_discard_contents)
+{
+    const Anvil::ResourceState new_state      = Anvil::Utils::get_resource_state_for_resource_usage(in_usage);
+    bool                       result         = false;
+    VkPipelineStageFlags       src_stage_mask = 0;
+
+    if (!m_recording_in_progress)
+    {
+        anvil_assert(m_recording_in_progress);
+
+        goto end;
+    }
+
+    if (m_is_renderpass_active)
+    {
+        anvil_assert(!m_is_renderpass_active);
+
+        goto end;
+    }
+
+    m_transition_buffer_barriers.clear();
+    m_transition_image_barriers.clear ();
+
+    m_resource_state_tracker.transition_image(in_image_ptr,
+                                              in_subresource_range,
+                                              new_state,
+                                              in_discard_contents,
+                                             &src_stage_mask,
+                                             &m_transition_image_barriers);
+
+    result = record_transition_barriers(src_stage_mask,
+                                        new_state.stage_mask);
+end:
+    return result;
+}
+
+/* Please see header for specification */
+bool Anvil::CommandBufferBase::record_transition(std::shared_ptr<Anvil::Image> in_image_ptr,
+                                                 Anvil::ResourceUsage          in_usage,
+                                                 bool                          in_discard_contents)
+{
+    return record_transition(in_image_ptr,
+                             in_image_ptr->get_subresource_range(),
+                             in_usage,
+                             in_discard_contents);
+}
+
+/** Records a pipeline barrier, which includes barriers stored in m_transition_buffer_barriers and
+ *  m_transition_image_barriers. Barriers are split over as many record_pipeline_barrier() calls as
+ *  necessary.
+ *
+ *  No-op if @param in_src_stage_mask is 0, which means no dependency is needed.
+ *
+ *  @param in_src_stage_mask Source stage mask to use.
+ *  @param in_dst_stage_mask Destination stage mask to use.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::CommandBufferBase::record_transition_barriers(VkPipelineStageFlags in_src_stage_mask,
+                                                          VkPipelineStageFlags in_dst_stage_mask)
+{
+    const uint32_t n_buffer_barriers = static_cast<uint32_t>(m_transition_buffer_barriers.size() );
+    const uint32_t n_image_barriers  = static_cast<uint32_t>(m_transition_image_barriers.size () );
+    bool           result            = true;
+
+    if (in_src_stage_mask == 0)
+    {
+        anvil_assert(n_buffer_barriers == 0 &&
+                     n_image_barriers  == 0);
+
+        goto end;
+    }
+
+    result = record_pipeline_barrier(in_src_stage_mask,
+                                     in_dst_stage_mask,
+                                     VK_FALSE, /* in_by_region */
+                                     0,        /* in_memory_barrier_count */
+                                     nullptr,  /* in_memory_barriers_ptr  */
+                                     n_buffer_barriers,
+                                     (n_buffer_barriers > 0) ? &m_transition_buffer_barriers.at(0) : nullptr,
+                                     n_image_barriers,
+                                     (n_image_barriers  > 0) ? &m_transition_image_barriers.at (0) : nullptr);
+
+end:
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::CommandBufferBase::record_update_buffer(std::shared_ptr<Anvil::Buffer> in_dst_buffer_ptr,
                                                     VkDeviceSize                   in_dst_offset,
@@ -2614,6 +3281,8 @@ bool Anvil::CommandBufferBase::record_update_buffer(std::shared_ptr<Anvil::Buffe
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2670,6 +3339,8 @@ bool Anvil::CommandBufferBase::record_wait_events(uint32_t
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2733,6 +3404,93 @@ end:
     return result;
 }
 
+/* Please see header for specification */
+bool Anvil::CommandBufferBase::record_wait_events(uint32_t                       in_event_count,
+                                                  std::shared_ptr<Anvil::Event>* in_events,
+                                                  VkPipelineStageFlags           in_src_stage_mask,
+                                                  VkPipelineStageFlags           in_dst_stage_mask,
+                                                  uint32_t                       in_memory_barrier_count,
+                                                  const MemoryBarrier* const     in_memory_barriers_ptr,
+                                                  uint32_t                       in_buffer_memory_barrier_count,
+                                                  const BufferBarrierRef* const  in_buffer_memory_barriers_ptr,
+                                                  uint32_t                       in_image_memory_barrier_count,
+                                                  const ImageBarrierRef* const   in_image_memory_barriers_ptr)
+
+{
+    /* NOTE: The command can be executed both inside and outside a renderpass */
+    VkEvent         events            [16];
+    VkMemoryBarrier memory_barriers_vk[16];
+    bool            result = false;
+
+    anvil_assert(in_event_count          > 0); /* as per spec - easy to miss */
+    anvil_assert(in_event_count          < sizeof(events)             / sizeof(events            [0]) );
+    anvil_assert(in_memory_barrier_count < sizeof(memory_barriers_vk) / sizeof(memory_barriers_vk[0]) );
+
+    if (!m_recording_in_progress)
+    {
+        anvil_assert(m_recording_in_progress);
+
+        goto end;
+    }
+
+    flush_pipeline_barriers();
+
+    #ifdef STORE_COMMAND_BUFFER_COMMANDS
+    {
+        if (!m_command_stashing_disabled)
+        {
+            WaitEventsCommand command(in_event_count,
+                                      in_events,
+                                      in_src_stage_mask,
+                                      in_dst_stage_mask,
+                                      in_memory_barrier_count,
+                                      in_memory_barriers_ptr,
+                                      0,        /* in_buffer_memory_barrier_count */
+                                      nullptr,  /* in_buffer_memory_barriers_ptr  */
+                                      0,        /* in_image_memory_barrier_count  */
+                                      nullptr); /* in_image_memory_barriers_ptr   */
+
+            command.buffer_barrier_refs.assign(in_buffer_memory_barriers_ptr,
+                                               in_buffer_memory_barriers_ptr + in_buffer_memory_barrier_count);
+            command.image_barrier_refs.assign (in_image_memory_barriers_ptr,
+                                               in_image_memory_barriers_ptr  + in_image_memory_barrier_count);
+
+            m_commands.push_back(command);
+        }
+    }
+    #endif
+
+    for (uint32_t n_event = 0;
+                  n_event < in_event_count;
+                ++n_event)
+    {
+        events[n_event] = in_events[n_event]->get_event();
+    }
+
+    for (uint32_t n_memory_barrier = 0;
+                  n_memory_barrier < in_memory_barrier_count;
+                ++n_memory_barrier)
+    {
+        memory_barriers_vk[n_memory_barrier] = in_memory_barriers_ptr[n_memory_barrier].get_barrier_vk();
+    }
+
+    vkCmdWaitEvents(m_command_buffer,
+                    in_event_count,
+                    events,
+                    in_src_stage_mask,
+                    in_dst_stage_mask,
+                    in_memory_barrier_count,
+                    memory_barriers_vk,
+                    in_buffer_memory_barrier_count,
+                    reinterpret_cast<const VkBufferMemoryBarrier*>(in_buffer_memory_barriers_ptr),
+                    in_image_memory_barrier_count,
+                    reinterpret_cast<const VkImageMemoryBarrier*> (in_image_memory_barriers_ptr) );
+
+    result = true;
+end:
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::CommandBufferBase::record_write_timestamp(VkPipelineStageFlagBits           in_pipeline_stage,
                                                       std::shared_ptr<Anvil::QueryPool> in_query_pool_ptr,
@@ -2748,6 +3506,8 @@ bool Anvil::CommandBufferBase::record_write_timestamp(VkPipelineStageFlagBits
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2792,6 +3552,10 @@ bool Anvil::CommandBufferBase::reset(bool should_release_resources)
         goto end;
     }
 
+    clear_batched_pipeline_barriers();
+    m_resource_state_tracker.reset ();
+    m_retained_objects.clear       ();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         clear_commands();
@@ -2803,6 +3567,18 @@ end:
     return result;
 }
 
+/* Please see header for specification */
+void Anvil::CommandBufferBase::set_pipeline_barrier_batching_enabled(bool in_enabled)
+{
+    if (!in_enabled                          &&
+         m_pipeline_barrier_batching_enabled)
+    {
+        flush_pipeline_barriers();
+    }
+
+    m_pipeline_barrier_batching_enabled = in_enabled;
+}
+
 /* Please see header for specification */
 bool Anvil::CommandBufferBase::stop_recording()
 {
@@ -2816,6 +3592,8 @@ bool Anvil::CommandBufferBase::stop_recording()
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     result_vk = vkEndCommandBuffer(m_command_buffer);
 
     if (!is_vk_call_successful(result_vk))
@@ -2886,6 +3664,8 @@ bool Anvil::PrimaryCommandBuffer::record_begin_render_pass(uint32_t
         goto end;
     }
 
+    flush_pipeline_barriers();
+
 
     anvil_assert(sgpu_device_locked_ptr != nullptr); /* User attempted to call this function prototype with in_n_physical_devices set to 0 */
 
@@ -2944,6 +3724,8 @@ bool Anvil::PrimaryCommandBuffer::record_end_render_pass()
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -2979,6 +3761,8 @@ bool Anvil::PrimaryCommandBuffer::record_execute_commands(uint32_t
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -3024,6 +3808,8 @@ bool Anvil::PrimaryCommandBuffer::record_next_subpass(VkSubpassContents in_conte
         goto end;
     }
 
+    flush_pipeline_barriers();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         if (!m_command_stashing_disabled)
@@ -3073,6 +3859,10 @@ bool Anvil::PrimaryCommandBuffer::start_recording(bool one_time_submit,
         goto end;
     }
 
+    clear_batched_pipeline_barriers();
+    m_resource_state_tracker.reset ();
+    m_retained_objects.clear       ();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         /* vkBeginCommandBuffer() implicitly resets all commands recorded previously */
@@ -3164,6 +3954,10 @@ bool Anvil::SecondaryCommandBuffer::start_recording(bool
         goto end;
     }
 
+    clear_batched_pipeline_barriers();
+    m_resource_state_tracker.reset ();
+    m_retained_objects.clear       ();
+
     #ifdef STORE_COMMAND_BUFFER_COMMANDS
     {
         /* vkBeginCommandBuffer() implicitly resets all commands recorded previously */
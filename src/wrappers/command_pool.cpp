@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "misc/types.h"
 #include "wrappers/command_buffer.h"
@@ -78,9 +79,9 @@ Anvil::CommandPool::~CommandPool()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyCommandPool(device_locked_ptr->get_device_vk(),
-                             m_command_pool,
-                             nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_COMMAND_POOL,
+                                              m_command_pool);
 
         m_command_pool = VK_NULL_HANDLE;
     }
@@ -93,8 +94,14 @@ Anvil::CommandPool::~CommandPool()
 /* Please see header for specification */
 std::shared_ptr<Anvil::PrimaryCommandBuffer> Anvil::CommandPool::alloc_primary_level_command_buffer()
 {
-    std::shared_ptr<PrimaryCommandBuffer> new_buffer_ptr(new PrimaryCommandBuffer(m_device_ptr,
-                                                                                  shared_from_this() ));
+    std::shared_ptr<PrimaryCommandBuffer> new_buffer_ptr;
+
+    free_collected_command_buffers();
+
+    new_buffer_ptr.reset(
+        new PrimaryCommandBuffer(m_device_ptr,
+                                 shared_from_this() )
+    );
 
     return new_buffer_ptr;
 }
@@ -102,8 +109,14 @@ std::shared_ptr<Anvil::PrimaryCommandBuffer> Anvil::CommandPool::alloc_primary_l
 /* Please see header for specification */
 std::shared_ptr<Anvil::SecondaryCommandBuffer> Anvil::CommandPool::alloc_secondary_level_command_buffer()
 {
-    std::shared_ptr<SecondaryCommandBuffer> new_buffer_ptr(new SecondaryCommandBuffer(m_device_ptr,
-                                                                                      shared_from_this() ));
+    std::shared_ptr<SecondaryCommandBuffer> new_buffer_ptr;
+
+    free_collected_command_buffers();
+
+    new_buffer_ptr.reset(
+        new SecondaryCommandBuffer(m_device_ptr,
+                                   shared_from_this() )
+    );
 
     return new_buffer_ptr;
 }
@@ -126,12 +139,29 @@ std::shared_ptr<Anvil::CommandPool> Anvil::CommandPool::create(std::weak_ptr<Anv
     return result_ptr;
 }
 
+/** Frees command buffers, allocated from this pool, which the device's deferred deletion queue has
+ *  collected. This has to happen on the thread owning the pool, since vkFreeCommandBuffers() requires
+ *  access to the pool to be externally synchronized.
+ **/
+void Anvil::CommandPool::free_collected_command_buffers()
+{
+    std::shared_ptr<Anvil::BaseDevice>            device_locked_ptr(m_device_ptr);
+    std::shared_ptr<Anvil::DeferredDeletionQueue> queue_ptr        (device_locked_ptr->get_deferred_deletion_queue() );
+
+    if (queue_ptr != nullptr)
+    {
+        queue_ptr->free_command_buffers(m_command_pool);
+    }
+}
+
 /* Please see header for specification */
 bool Anvil::CommandPool::reset(bool release_resources)
 {
     std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
     VkResult                           result_vk;
 
+    free_collected_command_buffers();
+
     result_vk = vkResetCommandPool(device_locked_ptr->get_device_vk(),
                                    m_command_pool,
                                    ((release_resources) ? VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT : 0u) );
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/compute_pipeline_manager.h"
 #include "wrappers/device.h"
@@ -72,12 +73,13 @@ Anvil::ComputePipelineManager::~ComputePipelineManager()
  **/
 bool Anvil::ComputePipelineManager::bake()
 {
-    std::shared_ptr<Anvil::BaseDevice>       locked_device_ptr(m_device_ptr);
-    std::vector<VkComputePipelineCreateInfo> pipeline_create_info_items_vk;
-    bool                                     result = false;
-    std::vector<VkPipeline>                  result_pipeline_items_vk;
-    VkResult                                 result_vk;
-    std::vector<VkSpecializationMapEntry>    specialization_map_entries_vk;
+    std::shared_ptr<Anvil::BaseDevice>                  locked_device_ptr(m_device_ptr);
+    std::vector<VkComputePipelineCreateInfo>            pipeline_create_info_items_vk;
+    bool                                                result = false;
+    std::vector<VkPipeline>                             result_pipeline_items_vk;
+    VkResult                                            result_vk;
+    std::vector<VkSpecializationInfo>                   specialization_info_items_vk;
+    std::vector<std::vector<VkSpecializationMapEntry> > specialization_map_entry_items_vk;
 
     typedef struct _bake_item
     {
@@ -99,15 +101,28 @@ bool Anvil::ComputePipelineManager::bake()
 
     std::map<VkPipelineLayout, std::vector<_bake_item> > layout_to_bake_item_map;
 
-    /* Iterate over all compute pipelines and identify the ones marked as dirty. Only these
-     * need to be re-created */
-    for (auto pipeline_iterator  = m_pipelines.begin();
-              pipeline_iterator != m_pipelines.end();
-            ++pipeline_iterator)
+    /* Create infos refer to specialization info descriptors stored in the vectors below, so make sure
+     * these are never reallocated. */
+    specialization_info_items_vk.reserve     (m_dirty_pipeline_ids.size() );
+    specialization_map_entry_items_vk.reserve(m_dirty_pipeline_ids.size() );
+
+    /* Iterate over compute pipelines marked as dirty. Only these need to be re-created */
+    for (auto dirty_pipeline_id_iterator  = m_dirty_pipeline_ids.begin();
+              dirty_pipeline_id_iterator != m_dirty_pipeline_ids.end();
+            ++dirty_pipeline_id_iterator)
     {
-        std::shared_ptr<Pipeline>   current_pipeline_ptr  = pipeline_iterator->second;
+        std::shared_ptr<Pipeline>   current_pipeline_ptr;
         VkComputePipelineCreateInfo pipeline_create_info;
-        VkSpecializationInfo        specialization_info;
+        auto                        pipeline_iterator       = m_pipelines.find(*dirty_pipeline_id_iterator);
+        VkSpecializationInfo*       specialization_info_ptr = nullptr;
+
+        if (pipeline_iterator == m_pipelines.end() )
+        {
+            /* The pipeline has been deleted in the meantime */
+            continue;
+        }
+
+        current_pipeline_ptr = pipeline_iterator->second;
 
         if (!current_pipeline_ptr->dirty     ||
              current_pipeline_ptr->is_proxy)
@@ -117,9 +132,9 @@ bool Anvil::ComputePipelineManager::bake()
 
         if (current_pipeline_ptr->baked_pipeline != VK_NULL_HANDLE)
         {
-            vkDestroyPipeline(locked_device_ptr->get_device_vk(),
-                              current_pipeline_ptr->baked_pipeline,
-                              nullptr /* pAllocator */);
+            Anvil::DeferredDeletionQueue::destroy(locked_device_ptr,
+                                                  Anvil::OBJECT_TYPE_PIPELINE,
+                                                  current_pipeline_ptr->baked_pipeline);
 
             current_pipeline_ptr->baked_pipeline = VK_NULL_HANDLE;
         }
@@ -133,10 +148,15 @@ bool Anvil::ComputePipelineManager::bake()
         {
             anvil_assert(current_pipeline_ptr->specialization_constant_data_buffer.size() == current_pipeline_ptr->specialization_constants_map.size());
 
+            specialization_info_items_vk.push_back     (VkSpecializationInfo() );
+            specialization_map_entry_items_vk.push_back(std::vector<VkSpecializationMapEntry>() );
+
+            specialization_info_ptr = &specialization_info_items_vk.back();
+
             bake_specialization_info_vk(current_pipeline_ptr->specialization_constants_map       [0],
                                        &current_pipeline_ptr->specialization_constant_data_buffer[0],
-                                       &specialization_map_entries_vk,
-                                       &specialization_info);
+                                       &specialization_map_entry_items_vk.back(),
+                                        specialization_info_ptr);
         }
 
         /* Prepare the Vulkan create info descriptor & store it in the map for later baking */
@@ -200,8 +220,7 @@ bool Anvil::ComputePipelineManager::bake()
         pipeline_create_info.stage.flags               = 0;
         pipeline_create_info.stage.pName               = current_pipeline_ptr->shader_stages[0].name;
         pipeline_create_info.stage.pNext               = nullptr;
-        pipeline_create_info.stage.pSpecializationInfo = (current_pipeline_ptr->specialization_constants_map[0].size() > 0) ? &specialization_info
-                                                                                                                            : VK_NULL_HANDLE;
+        pipeline_create_info.stage.pSpecializationInfo = specialization_info_ptr;
         pipeline_create_info.stage.stage               = VK_SHADER_STAGE_COMPUTE_BIT;
         pipeline_create_info.stage.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         pipeline_create_info.sType                     = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -223,52 +242,137 @@ bool Anvil::ComputePipelineManager::bake()
     }
 
     /* We can finally bake the pipeline objects. */
-    for (auto map_iterator  = layout_to_bake_item_map.begin();
-              map_iterator != layout_to_bake_item_map.end();
-            ++map_iterator)
+    if (m_n_bake_worker_threads > 0)
     {
-        uint32_t n_current_item = 0;
+        std::vector<int32_t>                    base_item_indices;
+        std::vector<double>                     bake_times_ms;
+        std::vector<std::shared_ptr<Pipeline> > bake_item_pipeline_ptrs;
+        ParallelBakeContext                     bake_context;
+        uint32_t                                n_bake_items;
+
+        /* Layouts do not matter when each pipeline is created with a separate call, so flatten the map. */
+        for (auto map_iterator  = layout_to_bake_item_map.begin();
+                  map_iterator != layout_to_bake_item_map.end();
+                ++map_iterator)
+        {
+            for (auto item_iterator  = map_iterator->second.begin();
+                      item_iterator != map_iterator->second.end();
+                    ++item_iterator)
+            {
+                bake_context.create_info_items_vk.push_back(item_iterator->create_info);
+                bake_item_pipeline_ptrs.push_back          (item_iterator->pipeline_ptr);
+            }
+        }
 
-        pipeline_create_info_items_vk.clear();
+        n_bake_items = static_cast<uint32_t>(bake_item_pipeline_ptrs.size() );
 
-        for (auto item_iterator  = map_iterator->second.begin();
-                  item_iterator != map_iterator->second.end();
-                ++item_iterator)
+        /* Base pipelines baked in this call are referred to by index. All other pipelines either come with
+         * a base pipeline handle, or are not derivatives at all. */
+        for (uint32_t n_bake_item = 0;
+                      n_bake_item < n_bake_items;
+                    ++n_bake_item)
         {
-            const _bake_item& current_bake_item = *item_iterator;
+            auto base_pipeline_iterator = std::find(bake_item_pipeline_ptrs.begin(),
+                                                    bake_item_pipeline_ptrs.end(),
+                                                    bake_item_pipeline_ptrs[n_bake_item]->base_pipeline_ptr);
 
-            pipeline_create_info_items_vk.push_back(current_bake_item.create_info);
+            if (base_pipeline_iterator != bake_item_pipeline_ptrs.end() )
+            {
+                base_item_indices.push_back(static_cast<int32_t>(base_pipeline_iterator - bake_item_pipeline_ptrs.begin() ));
+            }
+            else
+            {
+                base_item_indices.push_back(-1);
+
+                bake_context.create_info_items_vk[n_bake_item].basePipelineIndex = -1;
+            }
         }
 
-        result_pipeline_items_vk.resize(pipeline_create_info_items_vk.size() );
+        bake_context.device_vk         = locked_device_ptr->get_device_vk();
+        bake_context.pipeline_cache_vk = (m_pipeline_cache_ptr != nullptr) ? m_pipeline_cache_ptr->get_pipeline_cache()
+                                                                           : VK_NULL_HANDLE;
 
-        result_vk = vkCreateComputePipelines(locked_device_ptr->get_device_vk(),
-                                             m_pipeline_cache_ptr->get_pipeline_cache(),
-                                             (uint32_t) pipeline_create_info_items_vk.size(),
-                                            &pipeline_create_info_items_vk[0],
-                                             nullptr, /* pAllocator */
-                                            &result_pipeline_items_vk[0]);
+        bake_times_ms.resize           (n_bake_items);
+        result_pipeline_items_vk.resize(n_bake_items);
 
-        if (!is_vk_call_successful(result_vk))
+        if (n_bake_items > 0)
         {
-            anvil_assert_vk_call_succeeded(result_vk);
-
-            goto end;
+            if (!create_pipelines_in_parallel(m_n_bake_worker_threads,
+                                              n_bake_items,
+                                             &base_item_indices[0],
+                                              create_pipeline_for_parallel_bake,
+                                             &bake_context,
+                                             &result_pipeline_items_vk[0],
+                                             &bake_times_ms[0]) )
+            {
+                goto end;
+            }
         }
 
-        for (auto item_iterator  = map_iterator->second.begin();
-                  item_iterator != map_iterator->second.end();
-                ++item_iterator, ++n_current_item)
+        for (uint32_t n_bake_item = 0;
+                      n_bake_item < n_bake_items;
+                    ++n_bake_item)
+        {
+            anvil_assert(result_pipeline_items_vk[n_bake_item] != VK_NULL_HANDLE);
+
+            bake_item_pipeline_ptrs[n_bake_item]->bake_time_ms   = bake_times_ms[n_bake_item];
+            bake_item_pipeline_ptrs[n_bake_item]->baked_pipeline = result_pipeline_items_vk[n_bake_item];
+            bake_item_pipeline_ptrs[n_bake_item]->dirty          = false;
+        }
+    }
+    else
+    {
+        for (auto map_iterator  = layout_to_bake_item_map.begin();
+                  map_iterator != layout_to_bake_item_map.end();
+                ++map_iterator)
         {
-            const _bake_item& current_bake_item = *item_iterator;
+            uint32_t n_current_item = 0;
+
+            pipeline_create_info_items_vk.clear();
+
+            for (auto item_iterator  = map_iterator->second.begin();
+                      item_iterator != map_iterator->second.end();
+                    ++item_iterator)
+            {
+                const _bake_item& current_bake_item = *item_iterator;
+
+                pipeline_create_info_items_vk.push_back(current_bake_item.create_info);
+            }
+
+            result_pipeline_items_vk.resize(pipeline_create_info_items_vk.size() );
 
-            anvil_assert(result_pipeline_items_vk[n_current_item] != VK_NULL_HANDLE);
+            result_vk = vkCreateComputePipelines(locked_device_ptr->get_device_vk(),
+                                                 m_pipeline_cache_ptr->get_pipeline_cache(),
+                                                 (uint32_t) pipeline_create_info_items_vk.size(),
+                                                &pipeline_create_info_items_vk[0],
+                                                 nullptr, /* pAllocator */
+                                                &result_pipeline_items_vk[0]);
+
+            if (!is_vk_call_successful(result_vk))
+            {
+                anvil_assert_vk_call_succeeded(result_vk);
+
+                goto end;
+            }
+
+            for (auto item_iterator  = map_iterator->second.begin();
+                      item_iterator != map_iterator->second.end();
+                    ++item_iterator, ++n_current_item)
+            {
+                const _bake_item& current_bake_item = *item_iterator;
 
-            current_bake_item.pipeline_ptr->baked_pipeline  = result_pipeline_items_vk[n_current_item];
-            current_bake_item.pipeline_ptr->dirty           = false;
+                anvil_assert(result_pipeline_items_vk[n_current_item] != VK_NULL_HANDLE);
+
+                current_bake_item.pipeline_ptr->bake_time_ms    = -1.0;
+                current_bake_item.pipeline_ptr->baked_pipeline  = result_pipeline_items_vk[n_current_item];
+                current_bake_item.pipeline_ptr->dirty           = false;
+            }
         }
     }
 
+    /* All dirty pipelines have been baked */
+    m_dirty_pipeline_ids.clear();
+
     /* All done */
     result = true;
 end:
@@ -289,4 +393,31 @@ std::shared_ptr<Anvil::ComputePipelineManager> Anvil::ComputePipelineManager::cr
     );
 
     return result_ptr;
+}
+
+/** Creates a single compute pipeline in the parallel bake mode. Called from multiple threads at the same time.
+ *
+ *  Please see PFNCREATEPIPELINEPROC documentation for more details.
+ **/
+VkResult Anvil::ComputePipelineManager::create_pipeline_for_parallel_bake(void*       user_arg,
+                                                                          uint32_t    n_item,
+                                                                          VkPipeline  base_pipeline,
+                                                                          VkPipeline* out_pipeline_ptr)
+{
+    const ParallelBakeContext*  bake_context_ptr = static_cast<const ParallelBakeContext*>(user_arg);
+    VkComputePipelineCreateInfo create_info      = bake_context_ptr->create_info_items_vk[n_item];
+
+    if (base_pipeline != VK_NULL_HANDLE)
+    {
+        create_info.basePipelineHandle = base_pipeline;
+        create_info.basePipelineIndex  = -1;
+        create_info.flags             |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+    }
+
+    return vkCreateComputePipelines(bake_context_ptr->device_vk,
+                                    bake_context_ptr->pipeline_cache_vk,
+                                    1, /* createInfoCount */
+                                   &create_info,
+                                    nullptr, /* pAllocator */
+                                    out_pipeline_ptr);
 }
\ No newline at end of file
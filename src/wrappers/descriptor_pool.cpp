@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/descriptor_pool.h"
 #include "wrappers/descriptor_set.h"
@@ -55,9 +56,9 @@ Anvil::DescriptorPool::~DescriptorPool()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyDescriptorPool(device_locked_ptr->get_device_vk(),
-                                m_pool,
-                                nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_DESCRIPTOR_POOL,
+                                              m_pool);
 
         m_pool = VK_NULL_HANDLE;
     }
@@ -141,9 +142,9 @@ void Anvil::DescriptorPool::bake()
 
     if (m_pool != VK_NULL_HANDLE)
     {
-        vkDestroyDescriptorPool(device_locked_ptr->get_device_vk(),
-                                m_pool,
-                                nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_DESCRIPTOR_POOL,
+                                              m_pool);
 
         m_pool = VK_NULL_HANDLE;
     }
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/descriptor_set_layout.h"
 #include "wrappers/device.h"
@@ -44,9 +45,9 @@ Anvil::DescriptorSetLayout::~DescriptorSetLayout()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyDescriptorSetLayout(device_locked_ptr->get_device_vk(),
-                                     m_layout,
-                                     nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                                              m_layout);
 
         m_layout = VK_NULL_HANDLE;
     }
@@ -100,6 +101,32 @@ end:
     return result;
 }
 
+/** Please see header for specification */
+void Anvil::DescriptorSetLayout::append_contents_data(std::vector<uint64_t>* inout_data_ptr) const
+{
+    inout_data_ptr->push_back(m_bindings.size() );
+
+    for (auto binding_iterator  = m_bindings.begin();
+              binding_iterator != m_bindings.end();
+            ++binding_iterator)
+    {
+        const Binding& current_binding = binding_iterator->second;
+
+        inout_data_ptr->push_back(binding_iterator->first);
+        inout_data_ptr->push_back(current_binding.descriptor_type);
+        inout_data_ptr->push_back(current_binding.descriptor_array_size);
+        inout_data_ptr->push_back(current_binding.stage_flags);
+        inout_data_ptr->push_back(current_binding.immutable_samplers.size() );
+
+        for (auto sampler_iterator  = current_binding.immutable_samplers.begin();
+                  sampler_iterator != current_binding.immutable_samplers.end();
+                ++sampler_iterator)
+        {
+            inout_data_ptr->push_back((uint64_t) (*sampler_iterator)->get_sampler() );
+        }
+    }
+}
+
 /** Please see header for specification */
 bool Anvil::DescriptorSetLayout::bake()
 {
@@ -123,9 +150,9 @@ bool Anvil::DescriptorSetLayout::bake()
     /* Release an existing Vulkan layout, if one's already been baked in the past */
     if (m_layout != VK_NULL_HANDLE)
     {
-        vkDestroyDescriptorSetLayout(device_locked_ptr->get_device_vk(),
-                                     m_layout,
-                                     nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                                              m_layout);
 
         m_layout = VK_NULL_HANDLE;
     }
@@ -21,7 +21,12 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
+#include "misc/event_pool.h"
+#include "misc/fence_completion_service.h"
+#include "misc/fence_pool.h"
 #include "misc/object_tracker.h"
+#include "misc/persistent_pipeline_cache.h"
 #include "wrappers/command_pool.h"
 #include "wrappers/compute_pipeline_manager.h"
 #include "wrappers/descriptor_set.h"
@@ -78,6 +83,12 @@ void Anvil::BaseDevice::destroy()
 
     m_destroyed = true;
 
+    /* Write pipeline cache data back to disk, so that future runs can skip compiling pipelines baked so far. */
+    if (m_persistent_pipeline_cache_ptr != nullptr)
+    {
+        m_persistent_pipeline_cache_ptr->store();
+    }
+
     for (uint32_t n_command_pool = 0;
                   n_command_pool < sizeof(m_command_pool_ptrs) / sizeof(m_command_pool_ptrs[0]);
                 ++n_command_pool)
@@ -87,10 +98,22 @@ void Anvil::BaseDevice::destroy()
 
     m_compute_pipeline_manager_ptr  = nullptr;
     m_dummy_dsg_ptr                 = nullptr;
+    m_event_pool_ptr                = nullptr;
+    m_fence_completion_service_ptr  = nullptr; /* Blocks until all pending continuations have been run */
+    m_fence_pool_ptr                = nullptr;
     m_graphics_pipeline_manager_ptr = nullptr;
+    m_persistent_pipeline_cache_ptr = nullptr;
     m_pipeline_cache_ptr            = nullptr;
     m_pipeline_layout_manager_ptr   = nullptr;
 
+    /* Release all handles whose deletion has been deferred. Objects released from now on are destroyed
+     * right away. */
+    if (m_deferred_deletion_queue_ptr != nullptr)
+    {
+        m_deferred_deletion_queue_ptr->release_all();
+        m_deferred_deletion_queue_ptr = nullptr;
+    }
+
     /* Proceed with device-specific instances */
     for (Anvil::QueueFamilyType queue_family_type = Anvil::QUEUE_FAMILY_TYPE_FIRST;
                                 queue_family_type < Anvil::QUEUE_FAMILY_TYPE_COUNT + 1;
@@ -271,7 +294,8 @@ std::shared_ptr<Anvil::Queue> Anvil::BaseDevice::get_sparse_binding_queue(uint32
 void Anvil::BaseDevice::init(const std::vector<const char*>& extensions,
                              const std::vector<const char*>& layers,
                              bool                            transient_command_buffer_allocs_only,
-                             bool                            support_resettable_command_buffer_allocs)
+                             bool                            support_resettable_command_buffer_allocs,
+                             const std::string&              pipeline_cache_directory)
 {
 
     VkPhysicalDeviceFeatures         features_to_enable;
@@ -464,8 +488,31 @@ void Anvil::BaseDevice::init(const std::vector<const char*>& extensions,
     m_dummy_dsg_ptr->get_descriptor_set_layout(0)->bake();
     m_dummy_dsg_ptr->get_descriptor_set(0)->bake();
 
-    /* Set up the pipeline cache */
-    m_pipeline_cache_ptr = Anvil::PipelineCache::create(shared_from_this() );
+    /* Set up the deferred deletion queue */
+    m_deferred_deletion_queue_ptr = Anvil::DeferredDeletionQueue::create(shared_from_this() );
+
+    /* Set up the event pool */
+    m_event_pool_ptr = Anvil::EventPool::create(shared_from_this() );
+
+    /* Set up the fence pool */
+    m_fence_pool_ptr = Anvil::FencePool::create(shared_from_this(),
+                                                4); /* in_n_fences_to_preallocate */
+
+    /* Set up the fence completion service. Its thread is only started once it is first used. */
+    m_fence_completion_service_ptr = Anvil::FenceCompletionService::create(shared_from_this() );
+
+    /* Set up the pipeline cache. If a cache directory has been specified, the cache is pre-populated with
+     * data stored by earlier runs. */
+    if (!pipeline_cache_directory.empty() )
+    {
+        m_persistent_pipeline_cache_ptr = Anvil::PersistentPipelineCache::create(shared_from_this(),
+                                                                                 pipeline_cache_directory);
+        m_pipeline_cache_ptr            = m_persistent_pipeline_cache_ptr->get_pipeline_cache();
+    }
+    else
+    {
+        m_pipeline_cache_ptr = Anvil::PipelineCache::create(shared_from_this() );
+    }
 
     /* Cache a pipeline layout manager. This is needed to ensure the manager nevers goes out of scope while
      * the device is alive */
@@ -506,7 +553,8 @@ std::weak_ptr<Anvil::SGPUDevice> Anvil::SGPUDevice::create(std::weak_ptr<Anvil::
                                                            const std::vector<const char*>&      extensions,
                                                            const std::vector<const char*>&      layers,
                                                            bool                                 transient_command_buffer_allocs_only,
-                                                           bool                                 support_resettable_command_buffer_allocs)
+                                                           bool                                 support_resettable_command_buffer_allocs,
+                                                           const std::string&                   pipeline_cache_directory)
 {
     std::shared_ptr<Anvil::SGPUDevice> result_ptr;
 
@@ -516,7 +564,8 @@ std::weak_ptr<Anvil::SGPUDevice> Anvil::SGPUDevice::create(std::weak_ptr<Anvil::
     result_ptr->init(extensions,
                      layers,
                      transient_command_buffer_allocs_only,
-                     support_resettable_command_buffer_allocs);
+                     support_resettable_command_buffer_allocs,
+                     pipeline_cache_directory);
 
     return result_ptr;
 }
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/device.h"
 #include "wrappers/event.h"
@@ -99,9 +100,9 @@ void Anvil::Event::release_event()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyEvent(device_locked_ptr->get_device_vk(),
-                       m_event,
-                       nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_EVENT,
+                                              m_event);
 
         m_event = VK_NULL_HANDLE;
     }
@@ -128,6 +128,35 @@ bool Anvil::Fence::reset()
 /* Please see header for specification */
 bool Anvil::Fence::reset_fences(const uint32_t n_fences,
                                 Fence*         fences)
+{
+    Anvil::Fence*         fence_ptr_cache[32];
+    static const uint32_t fence_ptr_cache_capacity = sizeof(fence_ptr_cache) / sizeof(fence_ptr_cache[0]);
+    bool                  result                   = true;
+
+    for (uint32_t n_first_fence = 0;
+                  n_first_fence < n_fences;
+                  n_first_fence += fence_ptr_cache_capacity)
+    {
+        const uint32_t n_fences_in_batch = std::min(n_fences - n_first_fence,
+                                                    fence_ptr_cache_capacity);
+
+        for (uint32_t n_fence = 0;
+                      n_fence < n_fences_in_batch;
+                    ++n_fence)
+        {
+            fence_ptr_cache[n_fence] = fences + n_first_fence + n_fence;
+        }
+
+        result &= reset_fences(n_fences_in_batch,
+                               fence_ptr_cache);
+    }
+
+    return result;
+}
+
+/* Please see header for specification */
+bool Anvil::Fence::reset_fences(const uint32_t      n_fences,
+                                Fence* const* const fence_ptrs)
 {
     std::shared_ptr<Anvil::BaseDevice> device_locked_ptr;
     VkFence                            fence_cache[32];
@@ -135,22 +164,18 @@ bool Anvil::Fence::reset_fences(const uint32_t n_fences,
     bool                               result               = true;
     VkResult                           result_vk;
 
-    if (n_fences == 0)
+    for (uint32_t n_first_fence = 0;
+                  n_first_fence < n_fences;
+                  n_first_fence += fence_cache_capacity)
     {
-        goto end;
-    }
-
-    for (uint32_t n_fence_batch = 0;
-                  n_fence_batch < 1 + n_fences / fence_cache_capacity;
-                ++n_fence_batch)
-    {
-        const uint32_t n_fences_remaining = n_fences - n_fence_batch * fence_cache_capacity;
+        const uint32_t n_fences_in_batch = std::min(n_fences - n_first_fence,
+                                                    fence_cache_capacity);
 
         for (uint32_t n_fence = 0;
-                      n_fence < n_fences_remaining;
+                      n_fence < n_fences_in_batch;
                     ++n_fence)
         {
-            Anvil::Fence& current_fence = fences[n_fence_batch * fence_cache_capacity + n_fence];
+            Anvil::Fence& current_fence = *fence_ptrs[n_first_fence + n_fence];
 
             anvil_assert(device_locked_ptr == nullptr                                          ||
                          device_locked_ptr != nullptr && !current_fence.m_device_ptr.expired());
@@ -162,7 +187,7 @@ bool Anvil::Fence::reset_fences(const uint32_t n_fences,
         }
 
         result_vk = vkResetFences(device_locked_ptr->get_device_vk(),
-                                  n_fences_remaining,
+                                  n_fences_in_batch,
                                   fence_cache);
         anvil_assert_vk_call_succeeded(result_vk);
 
@@ -172,6 +197,5 @@ bool Anvil::Fence::reset_fences(const uint32_t n_fences,
         }
     }
 
-end:
     return result;
-}
\ No newline at end of file
+}
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/device.h"
 #include "wrappers/framebuffer.h"
@@ -93,9 +94,9 @@ Anvil::Framebuffer::~Framebuffer()
         anvil_assert(fb_iterator->second.framebuffer != VK_NULL_HANDLE);
 
         /* Destroy the Vulkan framebuffer object */
-        vkDestroyFramebuffer(device_locked_ptr->get_device_vk(),
-                             fb_iterator->second.framebuffer,
-                             nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_FRAMEBUFFER,
+                                              fb_iterator->second.framebuffer);
 
         /* Carry on and release the renderpass the framebuffer had been baked for */
         fb_iterator->first->unregister_from_callbacks(RENDER_PASS_CALLBACK_ID_BAKING_NEEDED,
@@ -225,9 +226,9 @@ bool Anvil::Framebuffer::bake(std::shared_ptr<Anvil::RenderPass> render_pass_ptr
 
     if (baked_fb_iterator != m_baked_framebuffers.end() )
     {
-        vkDestroyFramebuffer(device_locked_ptr->get_device_vk(),
-                             baked_fb_iterator->second.framebuffer,
-                             nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_FRAMEBUFFER,
+                                              baked_fb_iterator->second.framebuffer);
 
         m_baked_framebuffers.erase(baked_fb_iterator);
     }
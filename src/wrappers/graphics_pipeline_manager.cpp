@@ -32,29 +32,14 @@
 #include "wrappers/shader_module.h"
 #include "wrappers/swapchain.h"
 
-/** When baking a graphics pipeline descriptor, we currently use STL vectors to maintain storage
- *  for various Vulkan descriptors. These need to be stored on heap because:
- *
- *  1. The number of required descriptors depends on the pipeline configuration.
- *  2. Some parent descriptors use pointers to point at other child descriptors.
- *
- *  In order for vectors not to reallocate memory, we need to reserve memory up-front before
- *  we start pushing stuff. The number defined by N_CACHE_ITEMS tells how many items each
- *  vector will hold at max.
- *
- *  This #define could be removed by handling memory allocations manually, but for simplicity
- *  reasons we'll go with STL vectors for now.
- *  */
-#define N_CACHE_ITEMS 128
-
-
 /* Please see header for specification */
 Anvil::GraphicsPipelineManager::GraphicsPipelineManager(std::weak_ptr<Anvil::BaseDevice>      device_ptr,
                                                         bool                                  use_pipeline_cache,
                                                         std::shared_ptr<Anvil::PipelineCache> pipeline_cache_to_reuse_ptr)
-    :BasePipelineManager(device_ptr,
-                         use_pipeline_cache,
-                         pipeline_cache_to_reuse_ptr)
+    :BasePipelineManager        (device_ptr,
+                                 use_pipeline_cache,
+                                 pipeline_cache_to_reuse_ptr),
+     m_async_bake_ticket_counter(0)
 {
     /* Register the object */
     Anvil::ObjectTracker::get()->register_object(Anvil::OBJECT_TYPE_GRAPHICS_PIPELINE_MANAGER,
@@ -64,6 +49,12 @@ Anvil::GraphicsPipelineManager::GraphicsPipelineManager(std::weak_ptr<Anvil::Bas
 /* Please see header for specification */
 Anvil::GraphicsPipelineManager::~GraphicsPipelineManager()
 {
+    /* Wait for pending async bakes, so that their pipeline objects are released together with the pipelines */
+    while (m_async_bakes.size() > 0)
+    {
+        finish_async_bake(m_async_bakes.begin() );
+    }
+
     m_pipelines.clear();
 
     /* Unregister the object */
@@ -155,6 +146,45 @@ bool Anvil::GraphicsPipelineManager::add_derivative_pipeline_from_pipeline(bool
     return result;
 }
 
+/** Creates a new pipeline variant, as described by BasePipelineManager::add_pipeline_variant(), and assigns it
+ *  a copy of the base pipeline's configuration.
+ *
+ *  @param base_pipeline_id    ID of the pipeline to derive the variant from.
+ *  @param out_pipeline_id_ptr Deref will be set to the ID of the new pipeline. Must not be nullptr.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::GraphicsPipelineManager::add_pipeline_variant(PipelineID  base_pipeline_id,
+                                                          PipelineID* out_pipeline_id_ptr)
+{
+    auto base_config_iterator = m_pipeline_configurations.find(base_pipeline_id);
+    bool result               = false;
+
+    if (base_config_iterator == m_pipeline_configurations.end() )
+    {
+        anvil_assert(!(base_config_iterator == m_pipeline_configurations.end()) );
+
+        goto end;
+    }
+
+    if (!BasePipelineManager::add_pipeline_variant(base_pipeline_id,
+                                                   out_pipeline_id_ptr) )
+    {
+        goto end;
+    }
+
+    anvil_assert(m_pipeline_configurations.find(*out_pipeline_id_ptr) == m_pipeline_configurations.end() );
+
+    m_pipeline_configurations[*out_pipeline_id_ptr] = std::shared_ptr<GraphicsPipelineConfiguration>(new GraphicsPipelineConfiguration(base_config_iterator->second,
+                                                                                                                                        base_config_iterator->second->renderpass_ptr,
+                                                                                                                                        base_config_iterator->second->subpass_id) );
+
+    /* All done */
+    result = true;
+end:
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::GraphicsPipelineManager::add_proxy_pipeline(GraphicsPipelineID* out_proxy_graphics_pipeline_id_ptr)
 {
@@ -268,29 +298,56 @@ end:
 /* Please see header for specification */
 bool Anvil::GraphicsPipelineManager::bake()
 {
-    std::vector<VkPipelineColorBlendAttachmentState>    color_blend_attachment_states_vk_cache;
-    std::vector<VkPipelineColorBlendStateCreateInfo>    color_blend_state_create_info_items_vk_cache;
-    std::vector<VkPipelineDepthStencilStateCreateInfo>  depth_stencil_state_create_info_items_vk_cache;
-    std::vector<VkPipelineDynamicStateCreateInfo>       dynamic_state_create_info_items_vk_cache;
-    std::vector<VkDynamicState>                         enabled_dynamic_states_vk_cache;
-    std::vector<VkGraphicsPipelineCreateInfo>           graphics_pipeline_create_info_items_vk_cache;
-    std::vector<VkPipelineInputAssemblyStateCreateInfo> input_assembly_state_create_info_items_vk_cache;
-    std::vector<VkPipelineMultisampleStateCreateInfo>   multisample_state_create_info_items_vk_cache;
-    uint32_t                                            n_consumed_graphics_pipelines = 0;
-    std::vector<VkPipelineRasterizationStateCreateInfo> raster_state_create_info_items_vk_cache;
-    bool                                                result                        = false;
-    std::vector<VkPipeline>                             result_graphics_pipelines;
-    VkResult                                            result_vk;
-    std::vector<VkRect2D>                               scissor_boxes_vk_cache;
-    std::vector<VkPipelineShaderStageCreateInfo>        shader_stage_create_info_items_vk_cache;
-    std::vector<VkSpecializationInfo>                   specialization_info_vk_cache;
-    std::vector<VkSpecializationMapEntry>               specialization_map_entry_vk_cache;
-    std::vector<VkPipelineTessellationStateCreateInfo>  tessellation_state_create_info_items_vk_cache;
-    std::vector<VkPipelineVertexInputStateCreateInfo>   vertex_input_state_create_info_items_vk_cache;
-    std::vector<VkPipelineViewportStateCreateInfo>      viewport_state_create_info_items_vk_cache;
-    std::vector<VkViewport>                             viewports_vk_cache;
-
-    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    std::unique_ptr<BakeBatch> bake_batch_ptr;
+    bool                       result = false;
+
+    /* Reuse the batch of the previous bake() call, unless this call has been issued while the batch is in use
+     * (eg. from a post-bake call-back). */
+    if (m_bake_batch_ptr != nullptr)
+    {
+        bake_batch_ptr = std::move(m_bake_batch_ptr);
+    }
+    else
+    {
+        bake_batch_ptr.reset(new BakeBatch() );
+    }
+
+    if (!prepare_bake_batch(nullptr, /* opt_pipeline_ids_ptr */
+                            bake_batch_ptr.get() ) )
+    {
+        goto end;
+    }
+
+    result = finish_bake_batch(bake_batch_ptr.get(),
+                               create_bake_batch_pipelines(bake_batch_ptr.get() ));
+
+end:
+    bake_batch_ptr->clear();
+
+    m_bake_batch_ptr = std::move(bake_batch_ptr);
+
+    return result;
+}
+
+/** Forms create info descriptors for all dirty pipelines, which do not have an async bake pending, and stores them
+ *  in @param out_bake_batch_ptr. The descriptors refer to storage owned by pipeline configurations, which is only
+ *  modified for pipelines added to the batch. Pipelines whose state matches a pipeline object which already exists,
+ *  or which is going to be created for another pipeline in the batch, are set up to share that object.
+ *
+ *  All pipelines added to the batch are marked as clean.
+ *
+ *  @param opt_pipeline_ids_ptr If not nullptr, only pipelines whose IDs are stored in the vector are considered,
+ *                              along with dirty base pipelines of derivative pipelines among them.
+ *  @param out_bake_batch_ptr   Bake batch to fill. Must not be nullptr.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::GraphicsPipelineManager::prepare_bake_batch(const std::vector<GraphicsPipelineID>* opt_pipeline_ids_ptr,
+                                                        BakeBatch*                             out_bake_batch_ptr)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr   (m_device_ptr);
+    std::vector<GraphicsPipelineID>    pipeline_ids_to_bake;
+    bool                               result              (false);
 
     static const VkPipelineRasterizationStateRasterizationOrderAMD relaxed_rasterization_order_item =
     {
@@ -305,68 +362,113 @@ bool Anvil::GraphicsPipelineManager::bake()
         VK_RASTERIZATION_ORDER_STRICT_AMD
     };
 
-    /* Iterate over all stored pipelines, focus on the ones marked as dirty. */
-    typedef struct _bake_item
+    /* If the caller has restricted the bake to a subset of pipelines, derivative pipelines still need to be baked
+     * together with their base pipelines, unless the latter have been baked already. */
+    if (opt_pipeline_ids_ptr != nullptr)
+    {
+        pipeline_ids_to_bake = *opt_pipeline_ids_ptr;
+
+        for (uint32_t n_pipeline_id = 0;
+                      n_pipeline_id < static_cast<uint32_t>(pipeline_ids_to_bake.size() );
+                    ++n_pipeline_id)
+        {
+            auto pipeline_iterator = m_pipelines.find(pipeline_ids_to_bake[n_pipeline_id]);
+
+            if (pipeline_iterator == m_pipelines.end() )
+            {
+                anvil_assert(!(pipeline_iterator == m_pipelines.end()) );
+
+                goto end;
+            }
+
+            if (pipeline_iterator->second->base_pipeline_ptr == nullptr ||
+               !pipeline_iterator->second->base_pipeline_ptr->dirty)
+            {
+                continue;
+            }
+
+            /* Dirty pipelines are always on the dirty list */
+            for (auto dirty_pipeline_id_iterator  = m_dirty_pipeline_ids.begin();
+                      dirty_pipeline_id_iterator != m_dirty_pipeline_ids.end();
+                    ++dirty_pipeline_id_iterator)
+            {
+                auto base_pipeline_iterator = m_pipelines.find(*dirty_pipeline_id_iterator);
+
+                if (base_pipeline_iterator         != m_pipelines.end()                              &&
+                    base_pipeline_iterator->second == pipeline_iterator->second->base_pipeline_ptr)
+                {
+                    if (std::find(pipeline_ids_to_bake.begin(),
+                                  pipeline_ids_to_bake.end(),
+                                  base_pipeline_iterator->first) == pipeline_ids_to_bake.end() )
+                    {
+                        pipeline_ids_to_bake.push_back(base_pipeline_iterator->first);
+                    }
+
+                    break;
+                }
+            }
+        }
+    }
+
+    /* Iterate over pipelines on the dirty list. Entries of pipelines which have been deleted or baked in the meantime
+     * are dropped. */
+    for (auto dirty_pipeline_id_iterator  = m_dirty_pipeline_ids.begin();
+              dirty_pipeline_id_iterator != m_dirty_pipeline_ids.end();
+              )
     {
-        PipelineID                pipeline_id;
-        std::shared_ptr<Pipeline> pipeline_ptr;
+        std::shared_ptr<GraphicsPipelineConfiguration> pipeline_config_ptr;
+        auto                                           pipeline_iterator = m_pipelines.find(*dirty_pipeline_id_iterator);
 
-        _bake_item(PipelineID                in_pipeline_id,
-                   std::shared_ptr<Pipeline> in_pipeline_ptr)
+        if (pipeline_iterator == m_pipelines.end() ||
+           !pipeline_iterator->second->dirty       ||
+            pipeline_iterator->second->is_proxy)
         {
-            pipeline_id  = in_pipeline_id;
-            pipeline_ptr = in_pipeline_ptr;
+            dirty_pipeline_id_iterator = m_dirty_pipeline_ids.erase(dirty_pipeline_id_iterator);
+
+            continue;
         }
 
-        bool operator==(std::shared_ptr<Pipeline> in_pipeline_ptr)
+        /* Pipelines which are not baked in this call stay on the list */
+        ++dirty_pipeline_id_iterator;
+
+        if (!pipeline_iterator->second->is_bakeable)
         {
-            return pipeline_ptr == in_pipeline_ptr;
+            continue;
         }
-    } _bake_item;
 
-    std::vector<_bake_item> bake_items;
+        if (opt_pipeline_ids_ptr != nullptr                                  &&
+            std::find(pipeline_ids_to_bake.begin(),
+                      pipeline_ids_to_bake.end(),
+                      pipeline_iterator->first) == pipeline_ids_to_bake.end() )
+        {
+            continue;
+        }
 
+        pipeline_config_ptr = m_pipeline_configurations[pipeline_iterator->first];
 
-    for (auto pipeline_iterator  = m_pipelines.begin();
-              pipeline_iterator != m_pipelines.end();
-            ++pipeline_iterator)
-    {
-        if ( pipeline_iterator->second->dirty       &&
-            !pipeline_iterator->second->is_proxy    &&
-             pipeline_iterator->second->is_bakeable)
+        if (pipeline_config_ptr->pending_async_bake_ticket != 0)
         {
-            if (pipeline_iterator->second->layout_dirty)
-            {
-                pipeline_iterator->second->layout_ptr = get_pipeline_layout(pipeline_iterator->first);
-            }
+            /* The pipeline has been modified while an async bake is pending. It will be baked again once
+             * the pending bake completes. */
+            continue;
+        }
 
-            bake_items.push_back(_bake_item(pipeline_iterator->first,
-                                            pipeline_iterator->second) );
+        if (pipeline_iterator->second->layout_dirty)
+        {
+            pipeline_iterator->second->layout_ptr = get_pipeline_layout(pipeline_iterator->first);
         }
+
+        out_bake_batch_ptr->bake_items.push_back(BakeItem(pipeline_config_ptr,
+                                                          pipeline_iterator->second->layout_ptr,
+                                                          pipeline_iterator->first,
+                                                          pipeline_iterator->second) );
     }
 
-    color_blend_attachment_states_vk_cache.reserve         (N_CACHE_ITEMS);
-    color_blend_state_create_info_items_vk_cache.reserve   (N_CACHE_ITEMS);
-    depth_stencil_state_create_info_items_vk_cache.reserve (N_CACHE_ITEMS);
-    dynamic_state_create_info_items_vk_cache.reserve       (N_CACHE_ITEMS);
-    enabled_dynamic_states_vk_cache.reserve                (N_CACHE_ITEMS);
-    graphics_pipeline_create_info_items_vk_cache.reserve   (N_CACHE_ITEMS);
-    input_assembly_state_create_info_items_vk_cache.reserve(N_CACHE_ITEMS);
-    multisample_state_create_info_items_vk_cache.reserve   (N_CACHE_ITEMS);
-    raster_state_create_info_items_vk_cache.reserve        (N_CACHE_ITEMS);
-    scissor_boxes_vk_cache.reserve                         (N_CACHE_ITEMS);
-    shader_stage_create_info_items_vk_cache.reserve        (N_CACHE_ITEMS);
-    specialization_info_vk_cache.reserve                   (N_CACHE_ITEMS);
-    specialization_map_entry_vk_cache.reserve              (N_CACHE_ITEMS);
-    tessellation_state_create_info_items_vk_cache.reserve  (N_CACHE_ITEMS);
-    vertex_input_state_create_info_items_vk_cache.reserve  (N_CACHE_ITEMS);
-    viewport_state_create_info_items_vk_cache.reserve      (N_CACHE_ITEMS);
-    viewports_vk_cache.reserve                             (N_CACHE_ITEMS);
-
-    for (auto bake_item_iterator  = bake_items.begin();
-              bake_item_iterator != bake_items.end();
+    for (auto bake_item_iterator  = out_bake_batch_ptr->bake_items.begin();
+              bake_item_iterator != out_bake_batch_ptr->bake_items.end();
             ++bake_item_iterator)
     {
+        BakedCreateInfo*                               baked_create_info_ptr           = nullptr;
         bool                                           color_blend_state_used          = false;
         std::shared_ptr<GraphicsPipelineConfiguration> current_pipeline_config_ptr     = nullptr;
         const GraphicsPipelineID                       current_pipeline_id             = bake_item_iterator->pipeline_id;
@@ -377,7 +479,6 @@ bool Anvil::GraphicsPipelineManager::bake()
         VkPipelineInputAssemblyStateCreateInfo         input_assembly_state_create_info;
         bool                                           multisample_state_used          = false;
         VkPipelineRasterizationStateCreateInfo         raster_state_create_info;
-        uint32_t                                       shader_stage_start_offset       = UINT32_MAX;
         uint32_t                                       subpass_n_color_attachments     = 0;
         bool                                           tessellation_state_used         = false;
         VkPipelineVertexInputStateCreateInfo           vertex_input_state_create_info;
@@ -397,6 +498,7 @@ bool Anvil::GraphicsPipelineManager::bake()
         else
         {
             current_pipeline_config_ptr = m_pipeline_configurations[current_pipeline_id];
+            baked_create_info_ptr       = &current_pipeline_config_ptr->baked_create_info;
         }
 
         /* Extract subpass information */
@@ -409,7 +511,6 @@ bool Anvil::GraphicsPipelineManager::bake()
              subpass_n_color_attachments > 0)
         {
             VkPipelineColorBlendStateCreateInfo color_blend_state_create_info;
-            const uint32_t                      start_offset = (uint32_t) color_blend_attachment_states_vk_cache.size();
 
             color_blend_state_create_info.attachmentCount       = subpass_n_color_attachments;
             color_blend_state_create_info.flags                 = 0;
@@ -423,6 +524,8 @@ bool Anvil::GraphicsPipelineManager::bake()
                    current_pipeline_config_ptr->blend_constant,
                    sizeof(color_blend_state_create_info.blendConstants) );
 
+            baked_create_info_ptr->color_blend_attachment_states_vk.clear();
+
             for (uint32_t n_subpass_color_attachment = 0;
                           n_subpass_color_attachment < subpass_n_color_attachments;
                         ++n_subpass_color_attachment)
@@ -463,17 +566,17 @@ bool Anvil::GraphicsPipelineManager::bake()
                 }
                 #endif /* _DEBUG */
 
-                /* Convert internal descriptor to Vulkan descriptor & stash it in the cache vector. */
+                /* Convert internal descriptor to Vulkan descriptor & stash it in the storage vector. */
                 blend_attachment_state = current_attachment_blending_props_ptr->get_vk_descriptor();
 
-                color_blend_attachment_states_vk_cache.push_back(blend_attachment_state);
+                baked_create_info_ptr->color_blend_attachment_states_vk.push_back(blend_attachment_state);
             }
 
-            color_blend_state_create_info.pAttachments = (subpass_n_color_attachments > 0) ? &color_blend_attachment_states_vk_cache[start_offset]
+            color_blend_state_create_info.pAttachments = (subpass_n_color_attachments > 0) ? &baked_create_info_ptr->color_blend_attachment_states_vk[0]
                                                                                            : nullptr;
             color_blend_state_used                     = true;
 
-            color_blend_state_create_info_items_vk_cache.push_back(color_blend_state_create_info);
+            baked_create_info_ptr->color_blend_state_create_info_vk = color_blend_state_create_info;
         }
         else
         {
@@ -509,7 +612,7 @@ bool Anvil::GraphicsPipelineManager::bake()
 
             depth_stencil_state_used = true;
 
-            depth_stencil_state_create_info_items_vk_cache.push_back(depth_stencil_state_create_info);
+            baked_create_info_ptr->depth_stencil_state_create_info_vk = depth_stencil_state_create_info;
         }
         else
         {
@@ -526,63 +629,64 @@ bool Anvil::GraphicsPipelineManager::bake()
         if (current_pipeline_config_ptr->enabled_dynamic_states != 0)
         {
             VkPipelineDynamicStateCreateInfo dynamic_state_create_info;
-            const uint32_t                   start_offset = (uint32_t) enabled_dynamic_states_vk_cache.size();
+
+            baked_create_info_ptr->enabled_dynamic_states_vk.clear();
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_BLEND_CONSTANTS_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_BLEND_CONSTANTS);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_BLEND_CONSTANTS);
             }
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_DEPTH_BIAS_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
             }
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_DEPTH_BOUNDS_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_DEPTH_BOUNDS);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_DEPTH_BOUNDS);
             }
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_LINE_WIDTH_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_LINE_WIDTH);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_LINE_WIDTH);
             }
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_SCISSOR_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_SCISSOR);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_SCISSOR);
             }
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_STENCIL_COMPARE_MASK_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK);
             }
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_STENCIL_REFERENCE_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_STENCIL_REFERENCE);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_STENCIL_REFERENCE);
             }
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_STENCIL_WRITE_MASK_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_STENCIL_WRITE_MASK);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_STENCIL_WRITE_MASK);
             }
 
             if ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_VIEWPORT_BIT) != 0)
             {
-                enabled_dynamic_states_vk_cache.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+                baked_create_info_ptr->enabled_dynamic_states_vk.push_back(VK_DYNAMIC_STATE_VIEWPORT);
             }
 
-            dynamic_state_create_info.dynamicStateCount = (uint32_t) (enabled_dynamic_states_vk_cache.size() - start_offset);
+            dynamic_state_create_info.dynamicStateCount = (uint32_t) baked_create_info_ptr->enabled_dynamic_states_vk.size();
             dynamic_state_create_info.flags             = 0;
-            dynamic_state_create_info.pDynamicStates    = (dynamic_state_create_info.dynamicStateCount > 0) ? &enabled_dynamic_states_vk_cache[start_offset]
+            dynamic_state_create_info.pDynamicStates    = (dynamic_state_create_info.dynamicStateCount > 0) ? &baked_create_info_ptr->enabled_dynamic_states_vk[0]
                                                                                                             : VK_NULL_HANDLE;
             dynamic_state_create_info.pNext             = nullptr;
             dynamic_state_create_info.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 
             dynamic_state_used = true;
 
-            dynamic_state_create_info_items_vk_cache.push_back(dynamic_state_create_info);
+            baked_create_info_ptr->dynamic_state_create_info_vk = dynamic_state_create_info;
         }
         else
         {
@@ -596,26 +700,28 @@ bool Anvil::GraphicsPipelineManager::bake()
         input_assembly_state_create_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         input_assembly_state_create_info.topology               = current_pipeline_config_ptr->primitive_topology;
 
-        input_assembly_state_create_info_items_vk_cache.push_back(input_assembly_state_create_info);
+        baked_create_info_ptr->input_assembly_state_create_info_vk = input_assembly_state_create_info;
 
         /* Form the multisample state create info descriptor, if needed */
         if (!current_pipeline_config_ptr->rasterizer_discard_enabled)
         {
             VkPipelineMultisampleStateCreateInfo multisample_state_create_info;
 
+            baked_create_info_ptr->sample_mask_vk = current_pipeline_config_ptr->sample_mask;
+
             multisample_state_create_info.alphaToCoverageEnable = static_cast<VkBool32>(current_pipeline_config_ptr->alpha_to_coverage_enabled ? VK_TRUE : VK_FALSE);
             multisample_state_create_info.alphaToOneEnable      = static_cast<VkBool32>(current_pipeline_config_ptr->alpha_to_one_enabled      ? VK_TRUE : VK_FALSE);
             multisample_state_create_info.flags                 = 0;
             multisample_state_create_info.minSampleShading      = current_pipeline_config_ptr->min_sample_shading;
             multisample_state_create_info.pNext                 = nullptr;
-            multisample_state_create_info.pSampleMask           = &current_pipeline_config_ptr->sample_mask;
+            multisample_state_create_info.pSampleMask           = &baked_create_info_ptr->sample_mask_vk;
             multisample_state_create_info.rasterizationSamples  = static_cast<VkSampleCountFlagBits>(current_pipeline_config_ptr->sample_count);
             multisample_state_create_info.sampleShadingEnable   = static_cast<VkBool32>(current_pipeline_config_ptr->sample_shading_enabled ? VK_TRUE : VK_FALSE);
             multisample_state_create_info.sType                 = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 
             multisample_state_used = true;
 
-            multisample_state_create_info_items_vk_cache.push_back(multisample_state_create_info);
+            baked_create_info_ptr->multisample_state_create_info_vk = multisample_state_create_info;
         }
         else
         {
@@ -669,10 +775,13 @@ bool Anvil::GraphicsPipelineManager::bake()
                     "[!] Cannot enable out-of-order rasterization - VK_AMD_rasterization_order extension not enabled at device creation time");
         }
 
-        raster_state_create_info_items_vk_cache.push_back(raster_state_create_info);
+        baked_create_info_ptr->raster_state_create_info_vk = raster_state_create_info;
+
+        /* Form stage descriptors. Specialization constant data is copied, since the application may modify it
+         * while an async bake is pending. */
+        baked_create_info_ptr->specialization_constant_data = current_pipeline_ptr->specialization_constant_data_buffer;
 
-        /* Form stage descriptors */
-        shader_stage_start_offset = (uint32_t) shader_stage_create_info_items_vk_cache.size();
+        baked_create_info_ptr->shader_stage_create_info_items_vk.clear();
 
         for (uint32_t n_shader = 0;
                       n_shader < GRAPHICS_SHADER_STAGE_COUNT;
@@ -685,10 +794,10 @@ bool Anvil::GraphicsPipelineManager::bake()
 
                 if (current_pipeline_ptr->specialization_constants_map[n_shader].size() > 0)
                 {
-                    bake_specialization_info_vk(current_pipeline_ptr->specialization_constants_map       [n_shader],
-                                               &current_pipeline_ptr->specialization_constant_data_buffer[0],
-                                               &specialization_map_entry_vk_cache,
-                                               &specialization_info_vk_cache[n_shader]);
+                    bake_specialization_info_vk(current_pipeline_ptr->specialization_constants_map[n_shader],
+                                               &baked_create_info_ptr->specialization_constant_data[0],
+                                               &baked_create_info_ptr->specialization_map_entry_items_vk[n_shader],
+                                               &baked_create_info_ptr->specialization_info_items_vk     [n_shader]);
                 }
 
                 shader_module_ptr = current_pipeline_ptr->shader_stages[n_shader].shader_module_ptr;
@@ -703,7 +812,7 @@ bool Anvil::GraphicsPipelineManager::bake()
 
                 current_shader_stage_create_info.flags               = 0;
                 current_shader_stage_create_info.pNext               = nullptr;
-                current_shader_stage_create_info.pSpecializationInfo = (current_pipeline_ptr->specialization_constants_map[n_shader].size() > 0) ? &specialization_info_vk_cache[n_shader]
+                current_shader_stage_create_info.pSpecializationInfo = (current_pipeline_ptr->specialization_constants_map[n_shader].size() > 0) ? &baked_create_info_ptr->specialization_info_items_vk[n_shader]
                                                                                                                                                  : VK_NULL_HANDLE;
                 current_shader_stage_create_info.stage               = (n_shader == GRAPHICS_SHADER_STAGE_FRAGMENT)                ? VK_SHADER_STAGE_FRAGMENT_BIT
                                                                      : (n_shader == GRAPHICS_SHADER_STAGE_GEOMETRY)                ? VK_SHADER_STAGE_GEOMETRY_BIT
@@ -712,7 +821,7 @@ bool Anvil::GraphicsPipelineManager::bake()
                                                                                                                                    : VK_SHADER_STAGE_VERTEX_BIT;
                 current_shader_stage_create_info.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 
-                shader_stage_create_info_items_vk_cache.push_back(current_shader_stage_create_info);
+                baked_create_info_ptr->shader_stage_create_info_items_vk.push_back(current_shader_stage_create_info);
             }
         }
 
@@ -729,7 +838,7 @@ bool Anvil::GraphicsPipelineManager::bake()
 
             tessellation_state_used = true;
 
-            tessellation_state_create_info_items_vk_cache.push_back(tessellation_state_create_info);
+            baked_create_info_ptr->tessellation_state_create_info_vk = tessellation_state_create_info;
         }
         else
         {
@@ -739,24 +848,25 @@ bool Anvil::GraphicsPipelineManager::bake()
         /* Form the vertex input state create info descriptor */
         bake_vk_attributes_and_bindings(current_pipeline_config_ptr);
 
-        vertex_input_state_create_info.vertexAttributeDescriptionCount = (uint32_t) current_pipeline_config_ptr->vk_input_attributes.size();
-        vertex_input_state_create_info.vertexBindingDescriptionCount   = (uint32_t) current_pipeline_config_ptr->vk_input_bindings.size();
+        baked_create_info_ptr->vertex_input_attributes_vk = current_pipeline_config_ptr->vk_input_attributes;
+        baked_create_info_ptr->vertex_input_bindings_vk   = current_pipeline_config_ptr->vk_input_bindings;
+
+        vertex_input_state_create_info.vertexAttributeDescriptionCount = (uint32_t) baked_create_info_ptr->vertex_input_attributes_vk.size();
+        vertex_input_state_create_info.vertexBindingDescriptionCount   = (uint32_t) baked_create_info_ptr->vertex_input_bindings_vk.size();
 
         vertex_input_state_create_info.flags                        = 0;
         vertex_input_state_create_info.pNext                        = nullptr;
-        vertex_input_state_create_info.pVertexAttributeDescriptions = (vertex_input_state_create_info.vertexAttributeDescriptionCount > 0) ? &current_pipeline_config_ptr->vk_input_attributes[0]
+        vertex_input_state_create_info.pVertexAttributeDescriptions = (vertex_input_state_create_info.vertexAttributeDescriptionCount > 0) ? &baked_create_info_ptr->vertex_input_attributes_vk[0]
                                                                                                                                            : nullptr;
-        vertex_input_state_create_info.pVertexBindingDescriptions   = (vertex_input_state_create_info.vertexBindingDescriptionCount   > 0) ? &current_pipeline_config_ptr->vk_input_bindings[0]
+        vertex_input_state_create_info.pVertexBindingDescriptions   = (vertex_input_state_create_info.vertexBindingDescriptionCount   > 0) ? &baked_create_info_ptr->vertex_input_bindings_vk[0]
                                                                                                                                            : nullptr;
         vertex_input_state_create_info.sType                        = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-        vertex_input_state_create_info_items_vk_cache.push_back(vertex_input_state_create_info);
+        baked_create_info_ptr->vertex_input_state_create_info_vk = vertex_input_state_create_info;
 
         /* Form the viewport state create info descriptor, if needed */
         if (!current_pipeline_config_ptr->rasterizer_discard_enabled)
         {
-            const uint32_t                    scissor_boxes_start_offset = (uint32_t) scissor_boxes_vk_cache.size();
-            const uint32_t                    viewports_start_offset     = (uint32_t) viewports_vk_cache.size();
             VkPipelineViewportStateCreateInfo viewport_state_create_info;
 
             #ifdef _DEBUG
@@ -808,27 +918,30 @@ bool Anvil::GraphicsPipelineManager::bake()
             }
 
             /* Convert internal scissor box & viewport representations to Vulkan descriptors */
+            baked_create_info_ptr->scissor_boxes_vk.clear();
+            baked_create_info_ptr->viewports_vk.clear    ();
+
             for (auto scissor_box_iterator  = current_pipeline_config_ptr->scissor_boxes.cbegin();
                       scissor_box_iterator != current_pipeline_config_ptr->scissor_boxes.cend();
                     ++scissor_box_iterator)
             {
-                scissor_boxes_vk_cache.push_back(scissor_box_iterator->second.get_vk_descriptor() );
+                baked_create_info_ptr->scissor_boxes_vk.push_back(scissor_box_iterator->second.get_vk_descriptor() );
             }
 
             for (auto viewport_iterator  = current_pipeline_config_ptr->viewports.cbegin();
                       viewport_iterator != current_pipeline_config_ptr->viewports.cend();
                     ++viewport_iterator)
             {
-                viewports_vk_cache.push_back(viewport_iterator->second.get_vk_descriptor() );
+                baked_create_info_ptr->viewports_vk.push_back(viewport_iterator->second.get_vk_descriptor() );
             }
 
             /* Bake the descriptor */
             viewport_state_create_info.flags         = 0;
             viewport_state_create_info.pNext         = nullptr;
             viewport_state_create_info.pScissors     = ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_SCISSOR_BIT)  != 0) ? VK_NULL_HANDLE
-                                                                                                                                                 : &scissor_boxes_vk_cache[scissor_boxes_start_offset];
+                                                                                                                                                 : &baked_create_info_ptr->scissor_boxes_vk[0];
             viewport_state_create_info.pViewports    = ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_VIEWPORT_BIT) != 0) ? VK_NULL_HANDLE
-                                                                                                                                                 : &viewports_vk_cache    [viewports_start_offset];
+                                                                                                                                                 : &baked_create_info_ptr->viewports_vk    [0];
             viewport_state_create_info.scissorCount  = ((current_pipeline_config_ptr->enabled_dynamic_states & DYNAMIC_STATE_SCISSOR_BIT)  != 0) ? current_pipeline_config_ptr->n_dynamic_scissor_boxes 
                                                                                                                                                  : (uint32_t) current_pipeline_config_ptr->scissor_boxes.size();
             viewport_state_create_info.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -839,7 +952,7 @@ bool Anvil::GraphicsPipelineManager::bake()
 
             viewport_state_used = true;
 
-            viewport_state_create_info_items_vk_cache.push_back(viewport_state_create_info);
+            baked_create_info_ptr->viewport_state_create_info_vk = viewport_state_create_info;
         }
         else
         {
@@ -862,15 +975,15 @@ bool Anvil::GraphicsPipelineManager::bake()
              *
              * NOTE: A slightly adjusted version of this code is re-used in ComputePipelineManager::bake()
              */
-            auto base_bake_item_iterator = std::find(bake_items.begin(),
-                                                     bake_items.end(),
+            auto base_bake_item_iterator = std::find(out_bake_batch_ptr->bake_items.begin(),
+                                                     out_bake_batch_ptr->bake_items.end(),
                                                      current_pipeline_ptr->base_pipeline_ptr);
 
-            if (base_bake_item_iterator != bake_items.end() )
+            if (base_bake_item_iterator != out_bake_batch_ptr->bake_items.end() )
             {
                 /* Case 1 */
                 graphics_pipeline_create_info.basePipelineHandle = current_pipeline_ptr->base_pipeline;
-                graphics_pipeline_create_info.basePipelineIndex  = static_cast<int32_t>(base_bake_item_iterator - bake_items.begin() );
+                graphics_pipeline_create_info.basePipelineIndex  = static_cast<int32_t>(base_bake_item_iterator - out_bake_batch_ptr->bake_items.begin() );
             }
             else
             if (current_pipeline_ptr->base_pipeline_ptr                 != nullptr            &&
@@ -903,26 +1016,26 @@ bool Anvil::GraphicsPipelineManager::bake()
         anvil_assert(!current_pipeline_ptr->layout_dirty);
 
         graphics_pipeline_create_info.flags               = 0;
-        graphics_pipeline_create_info.layout              = current_pipeline_ptr->layout_ptr->get_pipeline_layout();
-        graphics_pipeline_create_info.pColorBlendState    = (color_blend_state_used)    ? &color_blend_state_create_info_items_vk_cache[color_blend_state_create_info_items_vk_cache.size() - 1]
+        graphics_pipeline_create_info.layout              = bake_item_iterator->layout_ptr->get_pipeline_layout();
+        graphics_pipeline_create_info.pColorBlendState    = (color_blend_state_used)    ? &baked_create_info_ptr->color_blend_state_create_info_vk
                                                                                         : VK_NULL_HANDLE;
-        graphics_pipeline_create_info.pDepthStencilState  = (depth_stencil_state_used)  ? &depth_stencil_state_create_info_items_vk_cache[depth_stencil_state_create_info_items_vk_cache.size() - 1]
+        graphics_pipeline_create_info.pDepthStencilState  = (depth_stencil_state_used)  ? &baked_create_info_ptr->depth_stencil_state_create_info_vk
                                                                                         : VK_NULL_HANDLE;
-        graphics_pipeline_create_info.pDynamicState       = (dynamic_state_used)        ? &dynamic_state_create_info_items_vk_cache[dynamic_state_create_info_items_vk_cache.size() - 1]
+        graphics_pipeline_create_info.pDynamicState       = (dynamic_state_used)        ? &baked_create_info_ptr->dynamic_state_create_info_vk
                                                                                         : VK_NULL_HANDLE;
-        graphics_pipeline_create_info.pInputAssemblyState = &input_assembly_state_create_info_items_vk_cache[input_assembly_state_create_info_items_vk_cache.size() - 1];
-        graphics_pipeline_create_info.pMultisampleState   = (multisample_state_used)    ? &multisample_state_create_info_items_vk_cache[multisample_state_create_info_items_vk_cache.size() - 1]
+        graphics_pipeline_create_info.pInputAssemblyState = &baked_create_info_ptr->input_assembly_state_create_info_vk;
+        graphics_pipeline_create_info.pMultisampleState   = (multisample_state_used)    ? &baked_create_info_ptr->multisample_state_create_info_vk
                                                                                         : VK_NULL_HANDLE;
         graphics_pipeline_create_info.pNext               = nullptr;
-        graphics_pipeline_create_info.pRasterizationState = &raster_state_create_info_items_vk_cache[raster_state_create_info_items_vk_cache.size() - 1];
-        graphics_pipeline_create_info.pStages             = &shader_stage_create_info_items_vk_cache[shader_stage_start_offset];
-        graphics_pipeline_create_info.pTessellationState  = (tessellation_state_used)   ? &tessellation_state_create_info_items_vk_cache[tessellation_state_create_info_items_vk_cache.size() - 1]
+        graphics_pipeline_create_info.pRasterizationState = &baked_create_info_ptr->raster_state_create_info_vk;
+        graphics_pipeline_create_info.pStages             = &baked_create_info_ptr->shader_stage_create_info_items_vk[0];
+        graphics_pipeline_create_info.pTessellationState  = (tessellation_state_used)   ? &baked_create_info_ptr->tessellation_state_create_info_vk
                                                                                         : VK_NULL_HANDLE;
-        graphics_pipeline_create_info.pVertexInputState   = &vertex_input_state_create_info_items_vk_cache[vertex_input_state_create_info_items_vk_cache.size() - 1];
-        graphics_pipeline_create_info.pViewportState      = (viewport_state_used)       ? &viewport_state_create_info_items_vk_cache[viewport_state_create_info_items_vk_cache.size() - 1]
+        graphics_pipeline_create_info.pVertexInputState   = &baked_create_info_ptr->vertex_input_state_create_info_vk;
+        graphics_pipeline_create_info.pViewportState      = (viewport_state_used)       ? &baked_create_info_ptr->viewport_state_create_info_vk
                                                                                         : VK_NULL_HANDLE;
         graphics_pipeline_create_info.renderPass          = current_pipeline_config_ptr->renderpass_ptr->get_render_pass();
-        graphics_pipeline_create_info.stageCount          = (uint32_t) shader_stage_create_info_items_vk_cache.size() - shader_stage_start_offset;
+        graphics_pipeline_create_info.stageCount          = (uint32_t) baked_create_info_ptr->shader_stage_create_info_items_vk.size();
         graphics_pipeline_create_info.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
         graphics_pipeline_create_info.subpass             = current_pipeline_config_ptr->subpass_id;
 
@@ -945,91 +1058,213 @@ bool Anvil::GraphicsPipelineManager::bake()
 
         /* Stash the descriptor for now. We will issue one expensive vkCreateGraphicsPipelines() call after all pipeline objects
          * are iterated over. */
-        graphics_pipeline_create_info_items_vk_cache.push_back(graphics_pipeline_create_info);
-    }
+        baked_create_info_ptr->graphics_pipeline_create_info_vk = graphics_pipeline_create_info;
+    }
+
+    /* Pipelines whose state matches a pipeline baked earlier, or another pipeline baked in this call, share a single
+     * Vulkan pipeline object instead of creating a new one.
+     *
+     * Derivative pipelines, and pipelines which can be derived from, refer to other pipelines by index or handle,
+     * so they are always baked separately. So are pipelines with a pre-bake call-back, since the call-back may
+     * modify the create info in ways we cannot key. */
+    out_bake_batch_ptr->bake_item_shared_pipeline_ptrs.resize(out_bake_batch_ptr->bake_items.size() );
+    out_bake_batch_ptr->bake_item_source_indices.assign      (out_bake_batch_ptr->bake_items.size(),
+                                                              -1);
+    out_bake_batch_ptr->bake_item_state_key_hashes.assign    (out_bake_batch_ptr->bake_items.size(),
+                                                              0);
+    out_bake_batch_ptr->bake_item_state_keys.resize          (out_bake_batch_ptr->bake_items.size() );
+
+    for (uint32_t n_bake_item = 0;
+                  n_bake_item < static_cast<uint32_t>(out_bake_batch_ptr->bake_items.size() );
+                ++n_bake_item)
+    {
+        std::shared_ptr<GraphicsPipelineConfiguration> current_pipeline_config_ptr = m_pipeline_configurations[out_bake_batch_ptr->bake_items[n_bake_item].pipeline_id];
+        std::shared_ptr<Pipeline>                      current_pipeline_ptr        = out_bake_batch_ptr->bake_items[n_bake_item].pipeline_ptr;
+        PipelineStateKey&                              current_state_key           = out_bake_batch_ptr->bake_item_state_keys      [n_bake_item];
+        uint64_t&                                      current_state_key_hash      = out_bake_batch_ptr->bake_item_state_key_hashes[n_bake_item];
+        auto                                           shared_pipelines_iterator   = m_shared_pipelines.end();
+
+        /* The key may have been left over by a bake this batch has been used for previously */
+        current_state_key.clear();
+
+        if (current_pipeline_ptr->allow_derivatives                                ||
+            current_pipeline_ptr->is_derivative                                    ||
+            current_pipeline_config_ptr->pfn_pipeline_prebake_callback_proc != nullptr)
+        {
+            continue;
+        }
 
-    #ifdef _DEBUG
-    {
-        /* If you hit any of the below assertion failures, please bump up the value under the #define.
-         *
-         * We use the vectors to hold structure instances. If more than N_CACHE_ITEMS items is ever requested from any of these vectors,
-         * the underlying storage will likely be reallocated. Many of the descriptors use pointers to refer to children descriptors,
-         * and when the data is moved around, the pointers are no longer valid.
-         */
-        anvil_assert(color_blend_attachment_states_vk_cache.size()          <= N_CACHE_ITEMS);
-        anvil_assert(color_blend_state_create_info_items_vk_cache.size()    <= N_CACHE_ITEMS);
-        anvil_assert(depth_stencil_state_create_info_items_vk_cache.size()  <= N_CACHE_ITEMS);
-        anvil_assert(dynamic_state_create_info_items_vk_cache.size()        <= N_CACHE_ITEMS);
-        anvil_assert(enabled_dynamic_states_vk_cache.size()                 <= N_CACHE_ITEMS);
-        anvil_assert(graphics_pipeline_create_info_items_vk_cache.size()    <= N_CACHE_ITEMS);
-        anvil_assert(input_assembly_state_create_info_items_vk_cache.size() <= N_CACHE_ITEMS);
-        anvil_assert(multisample_state_create_info_items_vk_cache.size()    <= N_CACHE_ITEMS);
-        anvil_assert(raster_state_create_info_items_vk_cache.size()         <= N_CACHE_ITEMS);
-        anvil_assert(scissor_boxes_vk_cache.size()                          <= N_CACHE_ITEMS);
-        anvil_assert(shader_stage_create_info_items_vk_cache.size()         <= N_CACHE_ITEMS);
-        anvil_assert(specialization_info_vk_cache.size()                    <= N_CACHE_ITEMS);
-        anvil_assert(specialization_map_entry_vk_cache.size()               <= N_CACHE_ITEMS);
-        anvil_assert(tessellation_state_create_info_items_vk_cache.size()   <= N_CACHE_ITEMS);
-        anvil_assert(vertex_input_state_create_info_items_vk_cache.size()   <= N_CACHE_ITEMS);
-        anvil_assert(viewport_state_create_info_items_vk_cache.size()       <= N_CACHE_ITEMS);
-        anvil_assert(viewports_vk_cache.size()                              <= N_CACHE_ITEMS);
-    }
-    #endif
+        if (!get_pipeline_state_key(current_pipeline_config_ptr->baked_create_info.graphics_pipeline_create_info_vk,
+                                    current_pipeline_config_ptr->renderpass_ptr,
+                                   &current_state_key,
+                                   &current_state_key_hash) )
+        {
+            current_state_key.clear();
 
-    /* All right. Try to bake all pipeline objects at once */
-    result_graphics_pipelines.resize(bake_items.size() );
+            continue;
+        }
 
-    result_vk = vkCreateGraphicsPipelines(device_locked_ptr->get_device_vk(),
-                                          m_pipeline_cache_ptr->get_pipeline_cache(),
-                                          (uint32_t) graphics_pipeline_create_info_items_vk_cache.size(),
-                                         &graphics_pipeline_create_info_items_vk_cache[0],
-                                          nullptr, /* pAllocator */
-                                         &result_graphics_pipelines[0]);
+        /* Is there a matching pipeline object, which is still alive? */
+        shared_pipelines_iterator = m_shared_pipelines.find(current_state_key_hash);
 
-    if (!is_vk_call_successful(result_vk) )
-    {
-        anvil_assert(result_vk);
+        if (shared_pipelines_iterator != m_shared_pipelines.end() )
+        {
+            for (auto entry_iterator  = shared_pipelines_iterator->second.begin();
+                      entry_iterator != shared_pipelines_iterator->second.end();
+                    ++entry_iterator)
+            {
+                if (entry_iterator->state_key == current_state_key)
+                {
+                    out_bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item] = entry_iterator->pipeline_ptr.lock();
 
-        goto end;
-    }
+                    if (out_bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item] != nullptr)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
 
-    for (auto bake_item_iterator  = bake_items.begin();
-              bake_item_iterator != bake_items.end();
-            ++bake_item_iterator)
-    {
-        if (!bake_item_iterator->pipeline_ptr->dirty)
+        if (out_bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item] != nullptr)
         {
             continue;
         }
 
-        if (m_pipeline_configurations[bake_item_iterator->pipeline_id]->pfn_pipeline_postbake_callback_proc != nullptr)
+        /* Is a matching pipeline object going to be created in this call? */
+        for (uint32_t n_preceding_bake_item = 0;
+                      n_preceding_bake_item < n_bake_item;
+                    ++n_preceding_bake_item)
         {
-            m_pipeline_configurations[bake_item_iterator->pipeline_id]->pfn_pipeline_postbake_callback_proc(m_device_ptr,
-                                                                                                            bake_item_iterator->pipeline_id,
-                                                                                                            m_pipeline_configurations[bake_item_iterator->pipeline_id]->pipeline_postbake_callback_user_arg);
+            if (out_bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_preceding_bake_item] == nullptr                &&
+                out_bake_batch_ptr->bake_item_source_indices      [n_preceding_bake_item] == -1                     &&
+                out_bake_batch_ptr->bake_item_state_key_hashes    [n_preceding_bake_item] == current_state_key_hash &&
+                out_bake_batch_ptr->bake_item_state_keys          [n_preceding_bake_item] == current_state_key)
+            {
+                out_bake_batch_ptr->bake_item_source_indices[n_bake_item] = static_cast<int32_t>(n_preceding_bake_item);
+
+                break;
+            }
         }
     }
 
-    /* Distribute the result pipeline objects to pipeline configuration descriptors */
-    for (auto pipeline_iterator  = m_pipelines.begin();
-              pipeline_iterator != m_pipelines.end();
-            ++pipeline_iterator)
+    /* Gather create info descriptors of pipelines we need to create. Base pipelines are never deduplicated, so
+     * base pipeline indices only need to be adjusted to skip the removed descriptors. */
+    out_bake_batch_ptr->bake_item_created_pipeline_indices.assign(out_bake_batch_ptr->bake_items.size(),
+                                                                  -1);
+
+    for (uint32_t n_bake_item = 0;
+                  n_bake_item < static_cast<uint32_t>(out_bake_batch_ptr->bake_items.size() );
+                ++n_bake_item)
     {
-        const GraphicsPipelineID  current_pipeline_id  = pipeline_iterator->first;
-        std::shared_ptr<Pipeline> current_pipeline_ptr = pipeline_iterator->second;
+        if (out_bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item] == nullptr &&
+            out_bake_batch_ptr->bake_item_source_indices      [n_bake_item] == -1)
+        {
+            out_bake_batch_ptr->bake_item_created_pipeline_indices[n_bake_item] = static_cast<int32_t>(out_bake_batch_ptr->create_info_items_to_bake_vk.size() );
+
+            out_bake_batch_ptr->create_info_items_to_bake_vk.push_back(out_bake_batch_ptr->bake_items[n_bake_item].config_ptr->baked_create_info.graphics_pipeline_create_info_vk);
+        }
+    }
 
-        if (!current_pipeline_ptr->dirty       ||
-             current_pipeline_ptr->is_proxy    ||
-            !current_pipeline_ptr->is_bakeable)
+    for (auto create_info_iterator  = out_bake_batch_ptr->create_info_items_to_bake_vk.begin();
+              create_info_iterator != out_bake_batch_ptr->create_info_items_to_bake_vk.end();
+            ++create_info_iterator)
+    {
+        if (create_info_iterator->basePipelineHandle == VK_NULL_HANDLE &&
+            create_info_iterator->basePipelineIndex  >= 0)
         {
-            continue;
+            create_info_iterator->basePipelineIndex = out_bake_batch_ptr->bake_item_created_pipeline_indices[create_info_iterator->basePipelineIndex];
+
+            anvil_assert(create_info_iterator->basePipelineIndex >= 0);
         }
+    }
+
+    out_bake_batch_ptr->created_pipeline_bake_times_ms.assign(out_bake_batch_ptr->create_info_items_to_bake_vk.size(),
+                                                              -1.0);
+    out_bake_batch_ptr->created_pipelines.assign             (out_bake_batch_ptr->create_info_items_to_bake_vk.size(),
+                                                              VK_NULL_HANDLE);
+
+    out_bake_batch_ptr->device_vk             = device_locked_ptr->get_device_vk();
+    out_bake_batch_ptr->n_bake_worker_threads = m_n_bake_worker_threads;
+    out_bake_batch_ptr->pipeline_cache_vk     = (m_pipeline_cache_ptr != nullptr) ? m_pipeline_cache_ptr->get_pipeline_cache()
+                                                                                  : VK_NULL_HANDLE;
+
+    /* Pipeline state has been captured. Any modification applied from now on marks the pipelines dirty again. */
+    for (auto bake_item_iterator  = out_bake_batch_ptr->bake_items.begin();
+              bake_item_iterator != out_bake_batch_ptr->bake_items.end();
+            ++bake_item_iterator)
+    {
+        bake_item_iterator->pipeline_ptr->dirty = false;
+
+        m_dirty_pipeline_ids.erase(bake_item_iterator->pipeline_id);
+    }
+
+    /* All done */
+    result = true;
+end:
+    return result;
+}
+
+/* Please see header for specification */
+bool Anvil::GraphicsPipelineManager::bake_async(uint32_t                  n_pipelines,
+                                                const GraphicsPipelineID* pipeline_ids,
+                                                AsyncBakeTicket*          out_ticket_ptr)
+{
+    std::shared_ptr<BakeBatch>      bake_batch_ptr(new BakeBatch() );
+    BakeBatch*                      bake_batch_raw_ptr = bake_batch_ptr.get();
+    std::vector<GraphicsPipelineID> pipeline_ids_to_bake;
+    bool                            result             = false;
+
+    anvil_assert(out_ticket_ptr != nullptr);
+
+    *out_ticket_ptr = 0;
+
+    if (n_pipelines > 0)
+    {
+        anvil_assert(pipeline_ids != nullptr);
 
-        m_pipelines[current_pipeline_id]->baked_pipeline = result_graphics_pipelines[n_consumed_graphics_pipelines++];
-        current_pipeline_ptr->dirty                      = false;
+        pipeline_ids_to_bake.assign(pipeline_ids,
+                                    pipeline_ids + n_pipelines);
     }
 
-    anvil_assert(n_consumed_graphics_pipelines == (uint32_t) result_graphics_pipelines.size() );
+    if (!prepare_bake_batch(&pipeline_ids_to_bake,
+                             bake_batch_raw_ptr) )
+    {
+        goto end;
+    }
+
+    if (bake_batch_ptr->bake_items.size() == 0)
+    {
+        /* None of the pipelines need baking */
+        result = true;
+
+        goto end;
+    }
+
+    /* 0 is reserved for "no bake" */
+    if (++m_async_bake_ticket_counter == 0)
+    {
+        ++m_async_bake_ticket_counter;
+    }
+
+    bake_batch_ptr->ticket = m_async_bake_ticket_counter;
+
+    for (auto bake_item_iterator  = bake_batch_ptr->bake_items.begin();
+              bake_item_iterator != bake_batch_ptr->bake_items.end();
+            ++bake_item_iterator)
+    {
+        bake_item_iterator->config_ptr->pending_async_bake_ticket = bake_batch_ptr->ticket;
+    }
+
+    /* The batch is kept alive by m_async_bakes until the job has completed. */
+    m_async_bakes[bake_batch_ptr->ticket] = bake_batch_ptr;
+
+    bake_batch_ptr->async_job.pfn_job_proc = run_async_bake;
+    bake_batch_ptr->async_job.user_arg     = bake_batch_raw_ptr;
+    bake_batch_ptr->manager_ptr            = this;
+
+    push_bake_worker_job(&bake_batch_ptr->async_job);
+
+    *out_ticket_ptr = bake_batch_ptr->ticket;
 
     /* All done */
     result = true;
@@ -1037,6 +1272,129 @@ end:
     return result;
 }
 
+/** Creates Vulkan pipeline objects for all create info descriptors held by @param bake_batch_ptr. Worker threads
+ *  are used if the parallel bake mode had been enabled at the time the batch was prepared.
+ *
+ *  Does not access manager state other than the bake worker threads, so it is safe to call from a bake worker job.
+ *
+ *  @param bake_batch_ptr Bake batch to use. Must not be nullptr.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::GraphicsPipelineManager::create_bake_batch_pipelines(BakeBatch* bake_batch_ptr)
+{
+    const uint32_t n_pipelines_to_create = static_cast<uint32_t>(bake_batch_ptr->create_info_items_to_bake_vk.size() );
+    bool           result                = false;
+
+    if (n_pipelines_to_create == 0)
+    {
+        /* All pipelines have been deduplicated */
+        result = true;
+    }
+    else
+    if (bake_batch_ptr->n_bake_worker_threads > 0)
+    {
+        /* Split the pipelines across worker threads. Base pipelines baked in this call are referred to by index,
+         * so that derivatives are only created after their bases have been baked. */
+        ParallelBakeContext bake_context;
+
+        bake_batch_ptr->created_pipeline_base_indices.clear();
+
+        for (uint32_t n_pipeline = 0;
+                      n_pipeline < n_pipelines_to_create;
+                    ++n_pipeline)
+        {
+            const VkGraphicsPipelineCreateInfo& current_create_info = bake_batch_ptr->create_info_items_to_bake_vk[n_pipeline];
+
+            bake_batch_ptr->created_pipeline_base_indices.push_back((current_create_info.basePipelineHandle == VK_NULL_HANDLE) ? current_create_info.basePipelineIndex
+                                                                                                                              : -1);
+        }
+
+        bake_context.create_info_items_vk_ptr = &bake_batch_ptr->create_info_items_to_bake_vk[0];
+        bake_context.device_vk                = bake_batch_ptr->device_vk;
+        bake_context.pipeline_cache_vk        = bake_batch_ptr->pipeline_cache_vk;
+
+        result = create_pipelines_in_parallel(bake_batch_ptr->n_bake_worker_threads,
+                                              n_pipelines_to_create,
+                                             &bake_batch_ptr->created_pipeline_base_indices[0],
+                                              create_pipeline_for_parallel_bake,
+                                             &bake_context,
+                                             &bake_batch_ptr->created_pipelines[0],
+                                             &bake_batch_ptr->created_pipeline_bake_times_ms[0]);
+    }
+    else
+    {
+        result = create_bake_batch_pipelines_serially(bake_batch_ptr);
+    }
+
+    return result;
+}
+
+/** Creates Vulkan pipeline objects for all create info descriptors held by @param bake_batch_ptr with a single
+ *  vkCreateGraphicsPipelines() call. Does not access manager state, so it is safe to call from a background thread.
+ *
+ *  @param bake_batch_ptr Bake batch to use. Must not be nullptr.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::GraphicsPipelineManager::create_bake_batch_pipelines_serially(BakeBatch* bake_batch_ptr)
+{
+    const uint32_t n_pipelines_to_create = static_cast<uint32_t>(bake_batch_ptr->create_info_items_to_bake_vk.size() );
+    VkResult       result_vk             = VK_SUCCESS;
+
+    if (n_pipelines_to_create > 0)
+    {
+        result_vk = vkCreateGraphicsPipelines(bake_batch_ptr->device_vk,
+                                              bake_batch_ptr->pipeline_cache_vk,
+                                              n_pipelines_to_create,
+                                             &bake_batch_ptr->create_info_items_to_bake_vk[0],
+                                              nullptr, /* pAllocator */
+                                             &bake_batch_ptr->created_pipelines[0]);
+
+        anvil_assert_vk_call_succeeded(result_vk);
+    }
+
+    return is_vk_call_successful(result_vk);
+}
+
+
+/** Bake worker job, which creates Vulkan pipeline objects of an async bake.
+ *
+ *  @param user_arg Bake batch of the async bake. Must not be nullptr.
+ **/
+void Anvil::GraphicsPipelineManager::run_async_bake(void* user_arg)
+{
+    BakeBatch* bake_batch_ptr = static_cast<BakeBatch*>(user_arg);
+
+    bake_batch_ptr->result = bake_batch_ptr->manager_ptr->create_bake_batch_pipelines(bake_batch_ptr);
+}
+
+/** Creates a single graphics pipeline in the parallel bake mode. Called from multiple threads at the same time.
+ *
+ *  Please see PFNCREATEPIPELINEPROC documentation for more details.
+ **/
+VkResult Anvil::GraphicsPipelineManager::create_pipeline_for_parallel_bake(void*       user_arg,
+                                                                           uint32_t    n_item,
+                                                                           VkPipeline  base_pipeline,
+                                                                           VkPipeline* out_pipeline_ptr)
+{
+    const ParallelBakeContext*   bake_context_ptr = static_cast<const ParallelBakeContext*>(user_arg);
+    VkGraphicsPipelineCreateInfo create_info      = bake_context_ptr->create_info_items_vk_ptr[n_item];
+
+    if (base_pipeline != VK_NULL_HANDLE)
+    {
+        create_info.basePipelineHandle = base_pipeline;
+        create_info.basePipelineIndex  = -1;
+    }
+
+    return vkCreateGraphicsPipelines(bake_context_ptr->device_vk,
+                                     bake_context_ptr->pipeline_cache_vk,
+                                     1, /* createInfoCount */
+                                    &create_info,
+                                     nullptr, /* pAllocator */
+                                     out_pipeline_ptr);
+}
+
 /** Converts the internal vertex attribute descriptors to one or more VkVertexInputAttributeDescription & VkVertexInputBindingDescription
  *  structures.
  *
@@ -1143,6 +1501,198 @@ end:
     return result;
 }
 
+/** Waits until the job of the specified async bake completes, hands the pipeline objects over to the baked pipelines
+ *  and retires the bake.
+ *
+ *  @param async_bake_iterator Iterator pointing at the async bake to finish. Must be valid.
+ *
+ *  @return true if the pipelines have been baked successfully, false otherwise.
+ **/
+bool Anvil::GraphicsPipelineManager::finish_async_bake(AsyncBakes::iterator async_bake_iterator)
+{
+    std::shared_ptr<BakeBatch> bake_batch_ptr = async_bake_iterator->second;
+    bool                       result;
+
+    wait_for_bake_worker_job(&bake_batch_ptr->async_job);
+
+    m_async_bakes.erase(async_bake_iterator);
+
+    result = finish_bake_batch(bake_batch_ptr.get(),
+                               bake_batch_ptr->result);
+
+    return result;
+}
+
+/** Hands pipeline objects created for @param bake_batch_ptr over to the baked pipelines, registers new pipeline
+ *  objects for sharing and invokes post-bake call-backs. For async bakes, this is done on the thread which owns
+ *  the manager, after the bake worker job has completed.
+ *
+ *  @param bake_batch_ptr     Bake batch to use. Must not be nullptr.
+ *  @param creation_succeeded true if all pipeline objects have been created successfully. If false, pipeline objects
+ *                            which have been created are released, and the pipelines are marked as dirty again.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::GraphicsPipelineManager::finish_bake_batch(BakeBatch* bake_batch_ptr,
+                                                       bool       creation_succeeded)
+{
+    bool result = false;
+
+    /* The pipelines are no longer waiting for the batch */
+    for (auto bake_item_iterator  = bake_batch_ptr->bake_items.begin();
+              bake_item_iterator != bake_batch_ptr->bake_items.end();
+            ++bake_item_iterator)
+    {
+        if (bake_item_iterator->config_ptr->pending_async_bake_ticket == bake_batch_ptr->ticket)
+        {
+            bake_item_iterator->config_ptr->pending_async_bake_ticket = 0;
+        }
+    }
+
+    if (!creation_succeeded)
+    {
+        std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+
+        for (auto pipeline_iterator  = bake_batch_ptr->created_pipelines.begin();
+                  pipeline_iterator != bake_batch_ptr->created_pipelines.end();
+                ++pipeline_iterator)
+        {
+            if (*pipeline_iterator != VK_NULL_HANDLE)
+            {
+                vkDestroyPipeline(device_locked_ptr->get_device_vk(),
+                                 *pipeline_iterator,
+                                  nullptr /* pAllocator */);
+            }
+        }
+
+        for (auto bake_item_iterator  = bake_batch_ptr->bake_items.begin();
+                  bake_item_iterator != bake_batch_ptr->bake_items.end();
+                ++bake_item_iterator)
+        {
+            auto pipeline_iterator = m_pipelines.find(bake_item_iterator->pipeline_id);
+
+            if (pipeline_iterator         != m_pipelines.end()                &&
+                pipeline_iterator->second == bake_item_iterator->pipeline_ptr)
+            {
+                mark_pipeline_dirty(bake_item_iterator->pipeline_id);
+            }
+        }
+
+        goto end;
+    }
+
+    /* Assign pipeline objects to bake items. Any pipeline object we have created for a keyed pipeline is registered,
+     * so that later bake() calls can share it, too. */
+    bake_batch_ptr->bake_item_bake_times_ms.assign   (bake_batch_ptr->bake_items.size(),
+                                                      -1.0);
+    bake_batch_ptr->bake_item_result_pipelines.assign(bake_batch_ptr->bake_items.size(),
+                                                      VK_NULL_HANDLE);
+
+    for (uint32_t n_bake_item = 0;
+                  n_bake_item < static_cast<uint32_t>(bake_batch_ptr->bake_items.size() );
+                ++n_bake_item)
+    {
+        const int32_t n_created_pipeline = bake_batch_ptr->bake_item_created_pipeline_indices[n_bake_item];
+        const int32_t n_source_bake_item = bake_batch_ptr->bake_item_source_indices          [n_bake_item];
+
+        if (n_source_bake_item != -1)
+        {
+            bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item] = bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_source_bake_item];
+        }
+        else
+        if (n_created_pipeline != -1)
+        {
+            bake_batch_ptr->bake_item_bake_times_ms   [n_bake_item] = bake_batch_ptr->created_pipeline_bake_times_ms[n_created_pipeline];
+            bake_batch_ptr->bake_item_result_pipelines[n_bake_item] = bake_batch_ptr->created_pipelines             [n_created_pipeline];
+
+            if (!bake_batch_ptr->bake_item_state_keys[n_bake_item].empty() )
+            {
+                const std::shared_ptr<Pipeline>&            pipeline_ptr = bake_batch_ptr->bake_items[n_bake_item].pipeline_ptr;
+                std::vector<SharedPipelineEntry>&           entries      = m_shared_pipelines[bake_batch_ptr->bake_item_state_key_hashes[n_bake_item] ];
+                std::vector<std::shared_ptr<ShaderModule> > shader_module_ptrs;
+
+                for (auto shader_stage_iterator  = pipeline_ptr->shader_stages.cbegin();
+                          shader_stage_iterator != pipeline_ptr->shader_stages.cend();
+                        ++shader_stage_iterator)
+                {
+                    if (shader_stage_iterator->shader_module_ptr != nullptr)
+                    {
+                        shader_module_ptrs.push_back(shader_stage_iterator->shader_module_ptr);
+                    }
+                }
+
+                bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item].reset(
+                    new SharedVkPipeline(m_device_ptr,
+                                         bake_batch_ptr->created_pipelines[n_created_pipeline],
+                                         pipeline_ptr->layout_ptr,
+                                         shader_module_ptrs)
+                );
+
+                /* Drop entries whose pipeline objects have been released in the meantime */
+                entries.erase(std::remove_if(entries.begin(),
+                                             entries.end(),
+                                             [](const SharedPipelineEntry& in_entry)
+                                             {
+                                                 return in_entry.pipeline_ptr.expired();
+                                             }),
+                              entries.end() );
+
+                entries.push_back(SharedPipelineEntry(bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item],
+                                                      bake_batch_ptr->bake_item_state_keys          [n_bake_item]) );
+            }
+        }
+
+        if (bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item] != nullptr)
+        {
+            bake_batch_ptr->bake_item_result_pipelines[n_bake_item] = bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item]->pipeline;
+        }
+    }
+
+    for (auto bake_item_iterator  = bake_batch_ptr->bake_items.begin();
+              bake_item_iterator != bake_batch_ptr->bake_items.end();
+            ++bake_item_iterator)
+    {
+        auto pipeline_iterator = m_pipelines.find(bake_item_iterator->pipeline_id);
+
+        /* Pipelines deleted while an async bake was pending no longer need to be notified */
+        if (pipeline_iterator         == m_pipelines.end()                ||
+            pipeline_iterator->second != bake_item_iterator->pipeline_ptr)
+        {
+            continue;
+        }
+
+        if (bake_item_iterator->config_ptr->pfn_pipeline_postbake_callback_proc != nullptr)
+        {
+            bake_item_iterator->config_ptr->pfn_pipeline_postbake_callback_proc(m_device_ptr,
+                                                                                bake_item_iterator->pipeline_id,
+                                                                                bake_item_iterator->config_ptr->pipeline_postbake_callback_user_arg);
+        }
+    }
+
+    /* Distribute the result pipeline objects to pipeline configuration descriptors. Pipeline objects baked for
+     * these pipelines previously are released (or dereferenced, if shared) first.
+     *
+     * The pipelines have been marked as clean when the batch was prepared. Those which have been modified since
+     * are left dirty, so that they are baked again at next use. */
+    for (uint32_t n_bake_item = 0;
+                  n_bake_item < static_cast<uint32_t>(bake_batch_ptr->bake_items.size() );
+                ++n_bake_item)
+    {
+        std::shared_ptr<Pipeline> current_pipeline_ptr = bake_batch_ptr->bake_items[n_bake_item].pipeline_ptr;
+
+        current_pipeline_ptr->release_vulkan_objects();
+
+        current_pipeline_ptr->bake_time_ms              = bake_batch_ptr->bake_item_bake_times_ms       [n_bake_item];
+        current_pipeline_ptr->baked_pipeline            = bake_batch_ptr->bake_item_result_pipelines    [n_bake_item];
+        current_pipeline_ptr->shared_baked_pipeline_ptr = bake_batch_ptr->bake_item_shared_pipeline_ptrs[n_bake_item];
+    }
+
+    /* All done */
+    result = true;
+end:
+    return result;
+}
+
 /** Please see header for specification */
 bool Anvil::GraphicsPipelineManager::get_alpha_to_coverage_state(GraphicsPipelineID graphics_pipeline_id,
                                                                  bool*              out_opt_is_enabled_ptr) const
@@ -1651,9 +2201,10 @@ end:
 /* Please see header for specification */
 VkPipeline Anvil::GraphicsPipelineManager::get_graphics_pipeline(GraphicsPipelineID pipeline_id)
 {
-    auto       pipeline_iterator = m_pipelines.find(pipeline_id);
-    bool       result            = false;
-    VkPipeline result_pipeline   = VK_NULL_HANDLE;
+    std::shared_ptr<GraphicsPipelineConfiguration> pipeline_config_ptr;
+    auto                                           pipeline_iterator   = m_pipelines.find(pipeline_id);
+    bool                                           result              = false;
+    VkPipeline                                     result_pipeline     = VK_NULL_HANDLE;
 
     ANVIL_REDUNDANT_VARIABLE(result);
 
@@ -1664,6 +2215,22 @@ VkPipeline Anvil::GraphicsPipelineManager::get_graphics_pipeline(GraphicsPipelin
         goto end;
     }
 
+    /* Do not block if an async bake is still pending for the pipeline. Use the fallback pipeline instead, if any. */
+    pipeline_config_ptr = m_pipeline_configurations[pipeline_id];
+
+    if ( pipeline_config_ptr->pending_async_bake_ticket != 0 &&
+        !is_async_bake_complete(pipeline_config_ptr->pending_async_bake_ticket) )
+    {
+        if (pipeline_config_ptr->has_fallback_pipeline)
+        {
+            anvil_assert(pipeline_config_ptr->fallback_pipeline_id != pipeline_id);
+
+            result_pipeline = get_graphics_pipeline(pipeline_config_ptr->fallback_pipeline_id);
+        }
+
+        goto end;
+    }
+
     if (pipeline_iterator->second->baked_pipeline == VK_NULL_HANDLE ||
         pipeline_iterator->second->dirty)
     {
@@ -1688,6 +2255,18 @@ std::shared_ptr<Anvil::PipelineLayout> Anvil::GraphicsPipelineManager::get_graph
     return get_pipeline_layout(pipeline_id);
 }
 
+/** Please see header for specification */
+bool Anvil::GraphicsPipelineManager::get_graphics_pipeline_variant(GraphicsPipelineID                 base_pipeline_id,
+                                                                   uint32_t                           n_values,
+                                                                   const SpecializationConstantValue* value_ptrs,
+                                                                   GraphicsPipelineID*                out_variant_pipeline_id_ptr)
+{
+    return get_pipeline_variant(base_pipeline_id,
+                                n_values,
+                                value_ptrs,
+                                out_variant_pipeline_id_ptr);
+}
+
 /** Please see header for specification */
 bool Anvil::GraphicsPipelineManager::get_input_assembly_properties(GraphicsPipelineID   graphics_pipeline_id,
                                                                    VkPrimitiveTopology* out_opt_primitive_topology_ptr) const
@@ -1787,6 +2366,309 @@ end:
     return result;
 }
 
+/** Serializes all state described by a graphics pipeline create info descriptor into a key, and hashes the key.
+ *
+ *  Shader modules and the pipeline layout are identified by their Vulkan handles, since both are shared by
+ *  pipelines which use identical objects. This is safe, since SharedVkPipeline keeps these objects alive: a handle
+ *  cannot be reused by a new object while a live pipeline object is registered under a key holding it, and entries
+ *  whose pipeline objects have been released are never matched. The render pass handle is replaced with the render pass compatibility
+ *  key, since a pipeline can be used with any render pass compatible with the one it was created for.
+ *
+ *  @param create_info            Descriptor to use. Must be fully baked.
+ *  @param renderpass_ptr         Render pass the descriptor refers to. Must not be nullptr.
+ *  @param out_state_key_ptr      Deref will be set to the key. Must not be nullptr.
+ *  @param out_state_key_hash_ptr Deref will be set to the hash of the key. Must not be nullptr.
+ *
+ *  @return true if successful, false if the descriptor chains structures the function does not recognize.
+ **/
+bool Anvil::GraphicsPipelineManager::get_pipeline_state_key(const VkGraphicsPipelineCreateInfo& create_info,
+                                                            std::shared_ptr<RenderPass>         renderpass_ptr,
+                                                            PipelineStateKey*                   out_state_key_ptr,
+                                                            uint64_t*                           out_state_key_hash_ptr)
+{
+    uint64_t              hash = 14695981039346656037ull; /* FNV-1a offset basis */
+    std::vector<uint32_t> renderpass_key;
+    bool                  result = false;
+
+    auto append = [&](uint32_t in_value)
+    {
+        out_state_key_ptr->push_back(in_value);
+    };
+    auto append_bytes = [&](const void* in_data_ptr,
+                            size_t      in_n_bytes)
+    {
+        append(static_cast<uint32_t>(in_n_bytes) );
+
+        for (size_t n_byte = 0;
+                    n_byte < in_n_bytes;
+                    n_byte += sizeof(uint32_t) )
+        {
+            uint32_t word = 0;
+
+            memcpy(&word,
+                   static_cast<const uint8_t*>(in_data_ptr) + n_byte,
+                   std::min(sizeof(uint32_t),
+                            in_n_bytes - n_byte) );
+
+            append(word);
+        }
+    };
+    auto append_float = [&](float in_value)
+    {
+        append_bytes(&in_value,
+                     sizeof(in_value) );
+    };
+
+    out_state_key_ptr->clear();
+
+    if (create_info.pNext != nullptr)
+    {
+        goto end;
+    }
+
+    append      (create_info.flags);
+    append_bytes(&create_info.layout,
+                 sizeof(create_info.layout) );
+    append_bytes(&create_info.basePipelineHandle,
+                 sizeof(create_info.basePipelineHandle) );
+    append      (static_cast<uint32_t>(create_info.basePipelineIndex) );
+
+    renderpass_ptr->get_compatibility_key(&renderpass_key);
+
+    append(static_cast<uint32_t>(renderpass_key.size() ));
+    append(create_info.subpass);
+
+    out_state_key_ptr->insert(out_state_key_ptr->end(),
+                              renderpass_key.begin(),
+                              renderpass_key.end() );
+
+    /* Shader stages */
+    append(create_info.stageCount);
+
+    for (uint32_t n_stage = 0;
+                  n_stage < create_info.stageCount;
+                ++n_stage)
+    {
+        const VkPipelineShaderStageCreateInfo& current_stage                   = create_info.pStages[n_stage];
+        const VkSpecializationInfo*            current_specialization_info_ptr = current_stage.pSpecializationInfo;
+
+        if (current_stage.pNext != nullptr)
+        {
+            goto end;
+        }
+
+        append      (current_stage.flags);
+        append      (current_stage.stage);
+        append_bytes(&current_stage.module,
+                     sizeof(current_stage.module) );
+        append_bytes(current_stage.pName,
+                     strlen(current_stage.pName) );
+
+        append((current_specialization_info_ptr != nullptr) ? 1u : 0u);
+
+        if (current_specialization_info_ptr != nullptr)
+        {
+            append(current_specialization_info_ptr->mapEntryCount);
+
+            for (uint32_t n_map_entry = 0;
+                          n_map_entry < current_specialization_info_ptr->mapEntryCount;
+                        ++n_map_entry)
+            {
+                append(current_specialization_info_ptr->pMapEntries[n_map_entry].constantID);
+                append(current_specialization_info_ptr->pMapEntries[n_map_entry].offset);
+                append(static_cast<uint32_t>(current_specialization_info_ptr->pMapEntries[n_map_entry].size) );
+            }
+
+            append_bytes(current_specialization_info_ptr->pData,
+                         current_specialization_info_ptr->dataSize);
+        }
+    }
+
+    /* Vertex input state */
+    if (create_info.pVertexInputState->pNext != nullptr)
+    {
+        goto end;
+    }
+
+    append      (create_info.pVertexInputState->flags);
+    append_bytes(create_info.pVertexInputState->pVertexBindingDescriptions,
+                 create_info.pVertexInputState->vertexBindingDescriptionCount   * sizeof(VkVertexInputBindingDescription) );
+    append_bytes(create_info.pVertexInputState->pVertexAttributeDescriptions,
+                 create_info.pVertexInputState->vertexAttributeDescriptionCount * sizeof(VkVertexInputAttributeDescription) );
+
+    /* Input assembly state */
+    if (create_info.pInputAssemblyState->pNext != nullptr)
+    {
+        goto end;
+    }
+
+    append(create_info.pInputAssemblyState->flags);
+    append(create_info.pInputAssemblyState->primitiveRestartEnable);
+    append(create_info.pInputAssemblyState->topology);
+
+    /* Tessellation state */
+    append((create_info.pTessellationState != nullptr) ? 1u : 0u);
+
+    if (create_info.pTessellationState != nullptr)
+    {
+        if (create_info.pTessellationState->pNext != nullptr)
+        {
+            goto end;
+        }
+
+        append(create_info.pTessellationState->flags);
+        append(create_info.pTessellationState->patchControlPoints);
+    }
+
+    /* Viewport state. Viewports and scissor boxes are not specified if they are dynamic. */
+    append((create_info.pViewportState != nullptr) ? 1u : 0u);
+
+    if (create_info.pViewportState != nullptr)
+    {
+        if (create_info.pViewportState->pNext != nullptr)
+        {
+            goto end;
+        }
+
+        append(create_info.pViewportState->flags);
+        append(create_info.pViewportState->scissorCount);
+        append(create_info.pViewportState->viewportCount);
+
+        append_bytes(create_info.pViewportState->pScissors,
+                     (create_info.pViewportState->pScissors != nullptr) ? create_info.pViewportState->scissorCount * sizeof(VkRect2D)
+                                                                        : 0);
+        append_bytes(create_info.pViewportState->pViewports,
+                     (create_info.pViewportState->pViewports != nullptr) ? create_info.pViewportState->viewportCount * sizeof(VkViewport)
+                                                                         : 0);
+    }
+
+    /* Rasterization state. The only structure we may chain is the one specifying the AMD rasterization order. */
+    if (create_info.pRasterizationState->pNext != nullptr)
+    {
+        const VkPipelineRasterizationStateRasterizationOrderAMD* rasterization_order_ptr = static_cast<const VkPipelineRasterizationStateRasterizationOrderAMD*>(create_info.pRasterizationState->pNext);
+
+        if (rasterization_order_ptr->sType != VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_RASTERIZATION_ORDER_AMD ||
+            rasterization_order_ptr->pNext != nullptr)
+        {
+            goto end;
+        }
+
+        append(rasterization_order_ptr->rasterizationOrder);
+    }
+    else
+    {
+        append(VK_RASTERIZATION_ORDER_MAX_ENUM_AMD);
+    }
+
+    append      (create_info.pRasterizationState->cullMode);
+    append_float(create_info.pRasterizationState->depthBiasClamp);
+    append_float(create_info.pRasterizationState->depthBiasConstantFactor);
+    append      (create_info.pRasterizationState->depthBiasEnable);
+    append_float(create_info.pRasterizationState->depthBiasSlopeFactor);
+    append      (create_info.pRasterizationState->depthClampEnable);
+    append      (create_info.pRasterizationState->flags);
+    append      (create_info.pRasterizationState->frontFace);
+    append_float(create_info.pRasterizationState->lineWidth);
+    append      (create_info.pRasterizationState->polygonMode);
+    append      (create_info.pRasterizationState->rasterizerDiscardEnable);
+
+    /* Multisample state */
+    append((create_info.pMultisampleState != nullptr) ? 1u : 0u);
+
+    if (create_info.pMultisampleState != nullptr)
+    {
+        if (create_info.pMultisampleState->pNext != nullptr)
+        {
+            goto end;
+        }
+
+        append      (create_info.pMultisampleState->alphaToCoverageEnable);
+        append      (create_info.pMultisampleState->alphaToOneEnable);
+        append      (create_info.pMultisampleState->flags);
+        append_float(create_info.pMultisampleState->minSampleShading);
+        append      (create_info.pMultisampleState->rasterizationSamples);
+        append      (create_info.pMultisampleState->sampleShadingEnable);
+
+        append_bytes(create_info.pMultisampleState->pSampleMask,
+                     (create_info.pMultisampleState->pSampleMask != nullptr) ? (create_info.pMultisampleState->rasterizationSamples + 31) / 32 * sizeof(VkSampleMask)
+                                                                             : 0);
+    }
+
+    /* Depth/stencil state */
+    append((create_info.pDepthStencilState != nullptr) ? 1u : 0u);
+
+    if (create_info.pDepthStencilState != nullptr)
+    {
+        if (create_info.pDepthStencilState->pNext != nullptr)
+        {
+            goto end;
+        }
+
+        append_bytes(&create_info.pDepthStencilState->back,
+                     sizeof(create_info.pDepthStencilState->back) );
+        append      (create_info.pDepthStencilState->depthBoundsTestEnable);
+        append      (create_info.pDepthStencilState->depthCompareOp);
+        append      (create_info.pDepthStencilState->depthTestEnable);
+        append      (create_info.pDepthStencilState->depthWriteEnable);
+        append      (create_info.pDepthStencilState->flags);
+        append_bytes(&create_info.pDepthStencilState->front,
+                     sizeof(create_info.pDepthStencilState->front) );
+        append_float(create_info.pDepthStencilState->maxDepthBounds);
+        append_float(create_info.pDepthStencilState->minDepthBounds);
+        append      (create_info.pDepthStencilState->stencilTestEnable);
+    }
+
+    /* Color blend state */
+    append((create_info.pColorBlendState != nullptr) ? 1u : 0u);
+
+    if (create_info.pColorBlendState != nullptr)
+    {
+        if (create_info.pColorBlendState->pNext != nullptr)
+        {
+            goto end;
+        }
+
+        append_bytes(create_info.pColorBlendState->pAttachments,
+                     create_info.pColorBlendState->attachmentCount * sizeof(VkPipelineColorBlendAttachmentState) );
+        append_bytes(create_info.pColorBlendState->blendConstants,
+                     sizeof(create_info.pColorBlendState->blendConstants) );
+        append      (create_info.pColorBlendState->flags);
+        append      (create_info.pColorBlendState->logicOp);
+        append      (create_info.pColorBlendState->logicOpEnable);
+    }
+
+    /* Dynamic state */
+    append((create_info.pDynamicState != nullptr) ? 1u : 0u);
+
+    if (create_info.pDynamicState != nullptr)
+    {
+        if (create_info.pDynamicState->pNext != nullptr)
+        {
+            goto end;
+        }
+
+        append      (create_info.pDynamicState->flags);
+        append_bytes(create_info.pDynamicState->pDynamicStates,
+                     create_info.pDynamicState->dynamicStateCount * sizeof(VkDynamicState) );
+    }
+
+    /* Hash the key with 64-bit FNV-1a, applied to 32-bit words */
+    for (auto key_iterator  = out_state_key_ptr->cbegin();
+              key_iterator != out_state_key_ptr->cend();
+            ++key_iterator)
+    {
+        hash ^= *key_iterator;
+        hash *= 1099511628211ull; /* FNV-1a prime */
+    }
+
+    *out_state_key_hash_ptr = hash;
+
+    /* All done */
+    result = true;
+end:
+    return result;
+}
+
 /** Please see header for specification */
 bool Anvil::GraphicsPipelineManager::get_primitive_restart_state(GraphicsPipelineID graphics_pipeline_id,
                                                                  bool*              out_opt_is_enabled_ptr) const
@@ -2346,6 +3228,31 @@ end:
     return result;
 }
 
+/* Please see header for specification */
+bool Anvil::GraphicsPipelineManager::is_async_bake_complete(AsyncBakeTicket ticket)
+{
+    auto async_bake_iterator = m_async_bakes.find(ticket);
+    bool result              = true;
+
+    if (async_bake_iterator == m_async_bakes.end() )
+    {
+        /* The bake has been retired already */
+        goto end;
+    }
+
+    if (!async_bake_iterator->second->async_job.is_complete)
+    {
+        result = false;
+
+        goto end;
+    }
+
+    finish_async_bake(async_bake_iterator);
+
+end:
+    return result;
+}
+
 /* Please see header for specification */
 void Anvil::GraphicsPipelineManager::set_blending_properties(GraphicsPipelineID graphics_pipeline_id,
                                                              const float*       blend_constant_vec4)
@@ -2371,7 +3278,7 @@ void Anvil::GraphicsPipelineManager::set_blending_properties(GraphicsPipelineID
            blend_constant_vec4,
            sizeof(pipeline_config_ptr->blend_constant) );
 
-    pipeline_iterator->second->dirty = true;
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2417,7 +3324,8 @@ void Anvil::GraphicsPipelineManager::set_color_blend_attachment_properties(Graph
     attachment_blending_props_ptr->dst_color_blend_factor = dst_color_blend_factor;
     attachment_blending_props_ptr->src_alpha_blend_factor = src_alpha_blend_factor;
     attachment_blending_props_ptr->src_color_blend_factor = src_color_blend_factor;
-    pipeline_iterator->second->dirty                      = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2444,7 +3352,8 @@ void Anvil::GraphicsPipelineManager::set_dynamic_scissor_state_properties(Graphi
     }
 
     pipeline_config_ptr->n_dynamic_scissor_boxes = n_dynamic_scissor_boxes;
-    pipeline_iterator->second->dirty             = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2471,7 +3380,8 @@ void Anvil::GraphicsPipelineManager::set_dynamic_viewport_state_properties(Graph
     }
 
     pipeline_config_ptr->n_dynamic_viewports = n_dynamic_viewports;
-    pipeline_iterator->second->dirty         = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2498,7 +3408,8 @@ void Anvil::GraphicsPipelineManager::set_input_assembly_properties(GraphicsPipel
     }
 
     pipeline_config_ptr->primitive_topology = primitive_topology;
-    pipeline_iterator->second->dirty        = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2531,12 +3442,47 @@ void Anvil::GraphicsPipelineManager::set_multisampling_properties(GraphicsPipeli
     pipeline_config_ptr->min_sample_shading = min_sample_shading;
     pipeline_config_ptr->sample_count       = sample_count;
     pipeline_config_ptr->sample_mask        = sample_mask;
-    pipeline_iterator->second->dirty        = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 
 end:
     ;
 }
 
+/* Please see header for specification */
+bool Anvil::GraphicsPipelineManager::set_pipeline_fallback(GraphicsPipelineID graphics_pipeline_id,
+                                                           GraphicsPipelineID fallback_graphics_pipeline_id)
+{
+    auto fallback_pipeline_iterator = m_pipelines.find              (fallback_graphics_pipeline_id);
+    auto pipeline_config_iterator   = m_pipeline_configurations.find(graphics_pipeline_id);
+    bool result                     = false;
+
+    if (pipeline_config_iterator   == m_pipeline_configurations.end() ||
+        fallback_pipeline_iterator == m_pipelines.end()               ||
+        fallback_pipeline_iterator->second->is_proxy)
+    {
+        anvil_assert(!(pipeline_config_iterator   == m_pipeline_configurations.end() ||
+                       fallback_pipeline_iterator == m_pipelines.end()               ||
+                       fallback_pipeline_iterator->second->is_proxy) );
+
+        goto end;
+    }
+
+    if (graphics_pipeline_id == fallback_graphics_pipeline_id)
+    {
+        anvil_assert(graphics_pipeline_id != fallback_graphics_pipeline_id);
+
+        goto end;
+    }
+
+    pipeline_config_iterator->second->fallback_pipeline_id  = fallback_graphics_pipeline_id;
+    pipeline_config_iterator->second->has_fallback_pipeline = true;
+
+    result = true;
+end:
+    return result;
+}
+
 /* Please see header for specification */
 bool Anvil::GraphicsPipelineManager::set_pipeline_post_bake_callback(GraphicsPipelineID              graphics_pipeline_id,
                                                                      PFNPIPELINEPOSTBAKECALLBACKPROC pfn_pipeline_post_bake_proc,
@@ -2605,10 +3551,7 @@ end:
 bool Anvil::GraphicsPipelineManager::set_pipeline_state_from_pipeline(GraphicsPipelineID target_pipeline_id,
                                                                       GraphicsPipelineID source_pipeline_id)
 {
-    std::shared_ptr<RenderPass>                    cached_renderpass_ptr;
-    SubPassID                                      cached_subpass_id     = UINT32_MAX;
-    bool                                           result                = false;
-    std::shared_ptr<GraphicsPipelineConfiguration> source_pipeline_config_ptr;
+    bool result = false;
 
     if (m_pipelines.find(target_pipeline_id) == m_pipelines.end() )
     {
@@ -2631,15 +3574,12 @@ bool Anvil::GraphicsPipelineManager::set_pipeline_state_from_pipeline(GraphicsPi
         goto end;
     }
 
-    cached_renderpass_ptr = m_pipeline_configurations[target_pipeline_id]->renderpass_ptr;
-    cached_subpass_id     = m_pipeline_configurations[target_pipeline_id]->subpass_id;
-
-    m_pipeline_configurations[target_pipeline_id]          = m_pipeline_configurations[source_pipeline_id];
-    m_pipelines              [target_pipeline_id]->dsg_ptr = m_pipelines[source_pipeline_id]->dsg_ptr;
-    m_pipelines              [target_pipeline_id]->dirty   = true;
+    /* Copy the state over, instead of sharing the configuration descriptor. The assignment operator leaves
+     * the render pass, the subpass ID and the baked create info of the target pipeline intact. */
+    *m_pipeline_configurations[target_pipeline_id]         = *m_pipeline_configurations[source_pipeline_id];
+     m_pipelines              [target_pipeline_id]->dsg_ptr =  m_pipelines[source_pipeline_id]->dsg_ptr;
 
-    m_pipeline_configurations[target_pipeline_id]->renderpass_ptr = cached_renderpass_ptr;
-    m_pipeline_configurations[target_pipeline_id]->subpass_id     = cached_subpass_id;
+    mark_pipeline_dirty(target_pipeline_id);
 
     result = true;
 end:
@@ -2670,7 +3610,8 @@ void Anvil::GraphicsPipelineManager::set_rasterization_order(GraphicsPipelineID
     if (pipeline_config_ptr->rasterization_order != rasterization_order)
     {
         pipeline_config_ptr->rasterization_order = rasterization_order;
-        pipeline_iterator->second->dirty         = true;
+
+        mark_pipeline_dirty(pipeline_iterator->first);
     }
 
 end:
@@ -2706,7 +3647,7 @@ void Anvil::GraphicsPipelineManager::set_rasterization_properties(GraphicsPipeli
     pipeline_config_ptr->line_width   = line_width;
     pipeline_config_ptr->polygon_mode = polygon_mode;
 
-    pipeline_iterator->second->dirty = true;
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2741,7 +3682,7 @@ void Anvil::GraphicsPipelineManager::set_scissor_box_properties(GraphicsPipeline
                                                                            width,
                                                                            height);
 
-    pipeline_iterator->second->dirty = true;
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2786,7 +3727,7 @@ void Anvil::GraphicsPipelineManager::set_stencil_test_properties(GraphicsPipelin
     stencil_op_state_ptr->reference   = stencil_reference;
     stencil_op_state_ptr->writeMask   = stencil_write_mask;
 
-    pipeline_iterator->second->dirty  = true;
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2813,7 +3754,8 @@ void Anvil::GraphicsPipelineManager::set_tessellation_properties(GraphicsPipelin
     }
 
     pipeline_config_ptr->n_patch_control_points = n_patch_control_points;
-    pipeline_iterator->second->dirty            = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2852,7 +3794,7 @@ void Anvil::GraphicsPipelineManager::set_viewport_properties(GraphicsPipelineID
                                                                   min_depth,
                                                                   max_depth);
 
-    pipeline_iterator->second->dirty = true;
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2879,7 +3821,8 @@ void Anvil::GraphicsPipelineManager::toggle_alpha_to_coverage(GraphicsPipelineID
     }
 
     pipeline_config_ptr->alpha_to_coverage_enabled = should_enable;
-    pipeline_iterator->second->dirty               = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2906,7 +3849,8 @@ void Anvil::GraphicsPipelineManager::toggle_alpha_to_one(GraphicsPipelineID grap
     }
 
     pipeline_config_ptr->alpha_to_one_enabled = should_enable;
-    pipeline_iterator->second->dirty          = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2937,7 +3881,8 @@ void Anvil::GraphicsPipelineManager::toggle_depth_bounds_test(GraphicsPipelineID
     pipeline_config_ptr->depth_bounds_test_enabled = should_enable;
     pipeline_config_ptr->max_depth_bounds          = max_depth_bounds;
     pipeline_config_ptr->min_depth_bounds          = min_depth_bounds;
-    pipeline_iterator->second->dirty               = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2970,7 +3915,8 @@ void Anvil::GraphicsPipelineManager::toggle_depth_bias(GraphicsPipelineID graphi
     pipeline_config_ptr->depth_bias_clamp           = depth_bias_clamp;
     pipeline_config_ptr->depth_bias_enabled         = should_enable;
     pipeline_config_ptr->depth_bias_slope_factor    = depth_bias_slope_factor;
-    pipeline_iterator->second->dirty                = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -2997,7 +3943,8 @@ void Anvil::GraphicsPipelineManager::toggle_depth_clamp(GraphicsPipelineID graph
     }
 
     pipeline_config_ptr->depth_clamp_enabled = should_enable;
-    pipeline_iterator->second->dirty         = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 
 end:
     ;
@@ -3027,7 +3974,8 @@ void Anvil::GraphicsPipelineManager::toggle_depth_test(GraphicsPipelineID graphi
 
     pipeline_config_ptr->depth_test_enabled    = should_enable;
     pipeline_config_ptr->depth_test_compare_op = compare_op;
-    pipeline_iterator->second->dirty           = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 
 end:
     ;
@@ -3055,7 +4003,8 @@ void Anvil::GraphicsPipelineManager::toggle_depth_writes(GraphicsPipelineID grap
     }
 
     pipeline_config_ptr->depth_writes_enabled = should_enable;
-    pipeline_iterator->second->dirty          = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -3091,7 +4040,7 @@ void Anvil::GraphicsPipelineManager::toggle_dynamic_states(GraphicsPipelineID
         pipeline_config_ptr->enabled_dynamic_states &= ~dynamic_state_bits;
     }
 
-    pipeline_iterator->second->dirty = true;
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -3120,7 +4069,8 @@ void Anvil::GraphicsPipelineManager::toggle_logic_op(GraphicsPipelineID graphics
 
     pipeline_config_ptr->logic_op         = logic_op;
     pipeline_config_ptr->logic_op_enabled = should_enable;
-    pipeline_iterator->second->dirty      = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -3147,7 +4097,8 @@ void Anvil::GraphicsPipelineManager::toggle_primitive_restart(GraphicsPipelineID
     }
 
     pipeline_config_ptr->primitive_restart_enabled = should_enable;
-    pipeline_iterator->second->dirty               = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 
 end:
     ;
@@ -3175,7 +4126,8 @@ void Anvil::GraphicsPipelineManager::toggle_rasterizer_discard(GraphicsPipelineI
     }
 
     pipeline_config_ptr->rasterizer_discard_enabled = should_enable;
-    pipeline_iterator->second->dirty                = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 
 end:
     ;
@@ -3203,7 +4155,8 @@ void Anvil::GraphicsPipelineManager::toggle_sample_shading(GraphicsPipelineID gr
     }
 
     pipeline_config_ptr->sample_shading_enabled = should_enable;
-    pipeline_iterator->second->dirty            = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 end:
     ;
 }
@@ -3230,8 +4183,23 @@ void Anvil::GraphicsPipelineManager::toggle_stencil_test(GraphicsPipelineID grap
     }
 
     pipeline_config_ptr->stencil_test_enabled = should_enable;
-    pipeline_iterator->second->dirty          = true;
+
+    mark_pipeline_dirty(pipeline_iterator->first);
 
 end:
     ;
+}
+
+/* Please see header for specification */
+bool Anvil::GraphicsPipelineManager::wait_for_async_bake(AsyncBakeTicket ticket)
+{
+    auto async_bake_iterator = m_async_bakes.find(ticket);
+    bool result              = true;
+
+    if (async_bake_iterator != m_async_bakes.end() )
+    {
+        result = finish_async_bake(async_bake_iterator);
+    }
+
+    return result;
 }
\ No newline at end of file
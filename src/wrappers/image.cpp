@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/formats.h"
 #include "misc/object_tracker.h"
 #include "wrappers/buffer.h"
@@ -1058,9 +1059,9 @@ Anvil::Image::~Image()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyImage(device_locked_ptr->get_device_vk(),
-                       m_image,
-                       nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_IMAGE,
+                                              m_image);
 
         m_image = VK_NULL_HANDLE;
     }
@@ -1193,6 +1194,32 @@ VkImageSubresourceRange Anvil::Image::get_subresource_range() const
     return result;
 }
 
+/** Please see header for specification */
+Anvil::ResourceState Anvil::Image::get_tracked_subresource_state(uint32_t n_layer,
+                                                                 uint32_t n_mipmap) const
+{
+    std::unique_lock<std::mutex> lock(m_tracked_subresource_states_mutex);
+
+    anvil_assert(n_layer  < m_n_layers);
+    anvil_assert(n_mipmap < m_n_mipmaps);
+
+    if (m_tracked_subresource_states.size() == 0)
+    {
+        return get_untracked_subresource_state();
+    }
+
+    return m_tracked_subresource_states.at(n_mipmap * m_n_layers + n_layer);
+}
+
+/** Returns the state all subresources are in until a submission transitions any of them. */
+Anvil::ResourceState Anvil::Image::get_untracked_subresource_state() const
+{
+    return Anvil::ResourceState(0, /* in_access_mask */
+                                (m_has_transitioned_to_post_create_layout) ? m_post_create_layout
+                                                                           : VK_IMAGE_LAYOUT_UNDEFINED,
+                                0  /* in_stage_mask */);
+}
+
 /** Please see header for specification */
 bool Anvil::Image::has_aspects(VkImageAspectFlags aspects) const
 {
@@ -1656,6 +1683,31 @@ void Anvil::Image::set_memory_sparse(const VkImageSubresource&           subreso
     }
 }
 
+/** Updates the state stored for the specified subresource. Used by Anvil::ResourceStateTracker to commit
+ *  states at command buffer submission time.
+ *
+ *  @param n_layer  Index of the layer to update.
+ *  @param n_mipmap Index of the mipmap to update.
+ *  @param state    New state to use.
+ **/
+void Anvil::Image::set_tracked_subresource_state(uint32_t                    n_layer,
+                                                 uint32_t                    n_mipmap,
+                                                 const Anvil::ResourceState& state)
+{
+    std::unique_lock<std::mutex> lock(m_tracked_subresource_states_mutex);
+
+    anvil_assert(n_layer  < m_n_layers);
+    anvil_assert(n_mipmap < m_n_mipmaps);
+
+    if (m_tracked_subresource_states.size() == 0)
+    {
+        m_tracked_subresource_states.resize(m_n_layers * m_n_mipmaps,
+                                            get_untracked_subresource_state() );
+    }
+
+    m_tracked_subresource_states.at(n_mipmap * m_n_layers + n_layer) = state;
+}
+
 /* Transitions the underlying Vulkan image to the layout stored in m_post_create_layout.
  *
  * @param source_access_mask All access types used to fill the image with data.
@@ -1675,6 +1727,9 @@ void Anvil::Image::transition_to_post_create_image_layout(VkAccessFlags source_a
     universal_queue_ptr           = device_locked_ptr->get_universal_queue(0);
     transition_command_buffer_ptr = device_locked_ptr->get_command_pool   (Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL)->alloc_primary_level_command_buffer();
 
+    /* The command buffer is only recorded through the wrapper, so its barriers can be batched */
+    transition_command_buffer_ptr->set_pipeline_barrier_batching_enabled(true);
+
     transition_command_buffer_ptr->start_recording(true,   /* one_time_submit          */
                                                    false); /* simultaneous_use_allowed */
     {
@@ -1706,7 +1761,11 @@ void Anvil::Image::transition_to_post_create_image_layout(VkAccessFlags source_a
                                                    true /* should_block */);
     }
 
-    m_has_transitioned_to_post_create_layout = true;
+    {
+        std::unique_lock<std::mutex> lock(m_tracked_subresource_states_mutex);
+
+        m_has_transitioned_to_post_create_layout = true;
+    }
 }
 
 /** Please see header for specification */
@@ -1948,6 +2007,9 @@ void Anvil::Image::upload_mipmaps(const std::vector<MipmapRawData>* mipmaps_ptr,
         temp_cmdbuf_ptr = device_locked_ptr->get_command_pool(Anvil::QUEUE_FAMILY_TYPE_UNIVERSAL)->alloc_primary_level_command_buffer();
         anvil_assert(temp_cmdbuf_ptr != nullptr);
 
+        /* The command buffer is only recorded through the wrapper, so its barriers can be batched */
+        temp_cmdbuf_ptr->set_pipeline_barrier_batching_enabled(true);
+
         temp_cmdbuf_ptr->start_recording(true, /* one_time_submit          */
                                          false /* simultaneous_use_allowed */);
         {
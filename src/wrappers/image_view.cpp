@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/device.h"
 #include "wrappers/image.h"
@@ -334,9 +335,9 @@ Anvil::ImageView::~ImageView()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyImageView(device_locked_ptr->get_device_vk(),
-                           m_image_view,
-                           nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_IMAGE_VIEW,
+                                              m_image_view);
 
         m_image_view = VK_NULL_HANDLE;
     }
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/buffer.h"
 #include "wrappers/device.h"
@@ -92,9 +93,9 @@ Anvil::MemoryBlock::~MemoryBlock()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkFreeMemory(device_locked_ptr->get_device_vk(),
-                     m_memory,
-                     nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_MEMORY_BLOCK,
+                                              m_memory);
 
         m_memory = VK_NULL_HANDLE;
     }
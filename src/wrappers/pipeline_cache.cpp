@@ -94,8 +94,8 @@ std::shared_ptr<Anvil::PipelineCache> Anvil::PipelineCache::create(std::weak_ptr
 }
 
 /** Please see header for specification */
-bool Anvil::PipelineCache::get_data(size_t*      out_n_data_bytes_ptr,
-                                    const void** out_data_ptr)
+bool Anvil::PipelineCache::get_data(size_t* out_n_data_bytes_ptr,
+                                    void*   out_data_ptr)
 {
     std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
     VkResult                           result_vk;
@@ -105,7 +105,7 @@ bool Anvil::PipelineCache::get_data(size_t*      out_n_data_bytes_ptr,
                                        out_n_data_bytes_ptr,
                                        out_data_ptr);
 
-    anvil_assert(result_vk);
+    anvil_assert_vk_call_succeeded(result_vk);
 
     return is_vk_call_successful(result_vk);
 }
@@ -132,7 +132,7 @@ bool Anvil::PipelineCache::merge(uint32_t
                                       n_pipeline_caches,
                                       src_pipeline_caches);
 
-    anvil_assert(result_vk);
+    anvil_assert_vk_call_succeeded(result_vk);
 
     return is_vk_call_successful(result_vk);
 }
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/descriptor_set_group.h"
 #include "wrappers/descriptor_set_layout.h"
@@ -77,9 +78,9 @@ Anvil::PipelineLayout::~PipelineLayout()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyPipelineLayout(device_locked_ptr->get_device_vk(),
-                                m_layout_vk,
-                                nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_PIPELINE_LAYOUT,
+                                              m_layout_vk);
 
         m_layout_vk = VK_NULL_HANDLE;
     }
@@ -135,9 +136,9 @@ bool Anvil::PipelineLayout::bake()
 
     if (m_layout_vk != VK_NULL_HANDLE)
     {
-        vkDestroyPipelineLayout(device_locked_ptr->get_device_vk(),
-                                m_layout_vk,
-                                nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_PIPELINE_LAYOUT,
+                                              m_layout_vk);
 
         m_layout_vk = VK_NULL_HANDLE;
     }
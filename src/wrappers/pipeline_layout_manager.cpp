@@ -23,6 +23,7 @@
 #include "misc/debug.h"
 #include "misc/object_tracker.h"
 #include "wrappers/descriptor_set_group.h"
+#include "wrappers/descriptor_set_layout.h"
 #include "wrappers/pipeline_layout.h"
 #include "wrappers/pipeline_layout_manager.h"
 #include <algorithm>
@@ -63,73 +64,88 @@ bool Anvil::PipelineLayoutManager::get_layout(std::shared_ptr<DescriptorSetGroup
                                               const PushConstantRanges&               push_constant_ranges,
                                               std::shared_ptr<Anvil::PipelineLayout>* out_pipeline_layout_ptr_ptr)
 {
-    bool result = false;
+    PipelineLayoutIDsByHash::iterator      hash_bucket_iterator;
+    PipelineLayoutKey                      key;
+    uint64_t                               key_hash           = 0;
+    std::shared_ptr<Anvil::PipelineLayout> new_layout_ptr;
+    Anvil::PipelineLayoutID                pipeline_layout_id = 0;
+    bool                                   result             = false;
 
-    for (auto layout_iterator  = m_pipeline_layouts.begin();
-              layout_iterator != m_pipeline_layouts.end();
-            ++layout_iterator)
+    get_layout_key(dsg_ptr,
+                   push_constant_ranges,
+                  &key,
+                  &key_hash);
+
+    /* Only layouts with a matching hash need to be considered */
+    hash_bucket_iterator = m_pipeline_layout_ids_by_hash.find(key_hash);
+
+    if (hash_bucket_iterator != m_pipeline_layout_ids_by_hash.end() )
     {
-        if (layout_iterator->second.expired() )
+        for (auto layout_id_iterator  = hash_bucket_iterator->second.begin();
+                  layout_id_iterator != hash_bucket_iterator->second.end();
+                ++layout_id_iterator)
         {
-            continue;
-        }
+            auto layout_iterator = m_pipeline_layouts.find(*layout_id_iterator);
 
-        std::shared_ptr<Anvil::PipelineLayout> current_pipeline_layout_ptr = layout_iterator->second.lock();
+            anvil_assert(layout_iterator != m_pipeline_layouts.end() );
 
-        if (current_pipeline_layout_ptr->get_attached_dsg()                  == dsg_ptr              &&
-            current_pipeline_layout_ptr->get_attached_push_constant_ranges() == push_constant_ranges)
-        {
-            *out_pipeline_layout_ptr_ptr = current_pipeline_layout_ptr;
-            result                       = true;
+            if (layout_iterator->second.key != key)
+            {
+                continue;
+            }
 
-            break;
+            std::shared_ptr<Anvil::PipelineLayout> current_pipeline_layout_ptr = layout_iterator->second.layout_ptr.lock();
+
+            if (current_pipeline_layout_ptr != nullptr)
+            {
+                *out_pipeline_layout_ptr_ptr = current_pipeline_layout_ptr;
+                result                       = true;
+
+                goto end;
+            }
         }
     }
 
+    /* Try to create a new layout for the specified DSG + push constant range set */
+    new_layout_ptr = Anvil::PipelineLayout::create(m_device_ptr);
+
+    result = new_layout_ptr->set_dsg(dsg_ptr);
+
     if (!result)
     {
-        result = true;
-
-        /* Try to create a new layout for the specified DSG + push constant range set */
-        std::shared_ptr<Anvil::PipelineLayout> new_layout_ptr = Anvil::PipelineLayout::create(m_device_ptr);
+        goto end;
+    }
 
-        result = new_layout_ptr->set_dsg(dsg_ptr);
+    for (auto push_constant_range_iterator  = push_constant_ranges.begin();
+              push_constant_range_iterator != push_constant_ranges.end();
+            ++push_constant_range_iterator)
+    {
+        result = new_layout_ptr->attach_push_constant_range((*push_constant_range_iterator).offset,
+                                                            (*push_constant_range_iterator).size,
+                                                            (*push_constant_range_iterator).stages);
 
         if (!result)
         {
             goto end;
         }
+    }
 
-        for (auto push_constant_range_iterator  = push_constant_ranges.begin();
-                  push_constant_range_iterator != push_constant_ranges.end();
-                ++push_constant_range_iterator)
-        {
-            result = new_layout_ptr->attach_push_constant_range((*push_constant_range_iterator).offset,
-                                                                (*push_constant_range_iterator).size,
-                                                                (*push_constant_range_iterator).stages);
+    new_layout_ptr->register_for_callbacks(PIPELINE_LAYOUT_CALLBACK_ID_OBJECT_ABOUT_TO_BE_DELETED,
+                                           on_pipeline_layout_dropped,
+                                           this);
 
-            if (!result)
-            {
-                goto end;
-            }
-        }
+    pipeline_layout_id = new_layout_ptr->get_id();
 
-        new_layout_ptr->register_for_callbacks(PIPELINE_LAYOUT_CALLBACK_ID_OBJECT_ABOUT_TO_BE_DELETED,
-                                               on_pipeline_layout_dropped,
-                                               this);
+    anvil_assert(m_pipeline_layouts.find(pipeline_layout_id) == m_pipeline_layouts.end() );
 
-        if (result)
-        {
-            const PipelineLayoutID pipeline_layout_id = new_layout_ptr->get_id();
+    new_layout_ptr->bake();
 
-            anvil_assert(m_pipeline_layouts.find(pipeline_layout_id) == m_pipeline_layouts.end() );
+    m_pipeline_layouts           [pipeline_layout_id] = PipelineLayoutInfo(key,
+                                                                           key_hash,
+                                                                           new_layout_ptr);
+    m_pipeline_layout_ids_by_hash[key_hash].push_back(pipeline_layout_id);
 
-            new_layout_ptr->bake();
-
-            m_pipeline_layouts[pipeline_layout_id] = new_layout_ptr;
-            *out_pipeline_layout_ptr_ptr           = new_layout_ptr;
-        }
-    }
+    *out_pipeline_layout_ptr_ptr = new_layout_ptr;
 end:
     return result;
 }
@@ -138,41 +154,112 @@ end:
 std::shared_ptr<Anvil::PipelineLayout> Anvil::PipelineLayoutManager::get_layout_by_id(Anvil::PipelineLayoutID id) const
 {
     if (m_pipeline_layouts.find(id) == m_pipeline_layouts.end() ||
-        m_pipeline_layouts.at(id).expired() )
+        m_pipeline_layouts.at(id).layout_ptr.expired() )
     {
         return std::shared_ptr<Anvil::PipelineLayout>();
     }
     else
     {
-        return m_pipeline_layouts.at(id).lock();
+        return m_pipeline_layouts.at(id).layout_ptr.lock();
     }
 }
 
+/** Serializes the contents of all descriptor set layouts of the specified DSG, as well as the specified push constant
+ *  ranges, into a key, and hashes the key. Pipeline layouts created for equal keys are identical.
+ *
+ *  @param dsg_ptr              DSG to use. May be nullptr.
+ *  @param push_constant_ranges Push constant ranges to use.
+ *  @param out_key_ptr          Deref will be set to the key. Must not be nullptr.
+ *  @param out_key_hash_ptr     Deref will be set to the hash of the key. Must not be nullptr.
+ **/
+void Anvil::PipelineLayoutManager::get_layout_key(std::shared_ptr<DescriptorSetGroup> dsg_ptr,
+                                                  const PushConstantRanges&           push_constant_ranges,
+                                                  PipelineLayoutKey*                  out_key_ptr,
+                                                  uint64_t*                           out_key_hash_ptr)
+{
+    uint64_t hash = 14695981039346656037ull; /* FNV-1a offset basis */
+
+    out_key_ptr->clear();
+
+    if (dsg_ptr != nullptr)
+    {
+        const uint32_t n_sets = dsg_ptr->get_n_of_descriptor_sets();
+
+        out_key_ptr->push_back(n_sets);
+
+        for (uint32_t n_set = 0;
+                      n_set < n_sets;
+                    ++n_set)
+        {
+            const uint32_t ds_binding_index = dsg_ptr->get_descriptor_set_binding_index(n_set);
+
+            out_key_ptr->push_back(ds_binding_index);
+
+            dsg_ptr->get_descriptor_set_layout(ds_binding_index)->append_contents_data(out_key_ptr);
+        }
+    }
+    else
+    {
+        out_key_ptr->push_back(0);
+    }
+
+    out_key_ptr->push_back(push_constant_ranges.size() );
+
+    for (auto push_constant_range_iterator  = push_constant_ranges.begin();
+              push_constant_range_iterator != push_constant_ranges.end();
+            ++push_constant_range_iterator)
+    {
+        out_key_ptr->push_back(push_constant_range_iterator->offset);
+        out_key_ptr->push_back(push_constant_range_iterator->size);
+        out_key_ptr->push_back(push_constant_range_iterator->stages);
+    }
+
+    for (auto key_iterator  = out_key_ptr->begin();
+              key_iterator != out_key_ptr->end();
+            ++key_iterator)
+    {
+        hash ^= *key_iterator;
+        hash *= 1099511628211ull; /* FNV-1a prime */
+    }
+
+    *out_key_hash_ptr = hash;
+}
+
 /** Called back whenever a pipeline layout is released **/
 void Anvil::PipelineLayoutManager::on_pipeline_layout_dropped(void* callback_arg,
                                                               void* user_arg)
 {
-    PipelineLayouts::iterator     layout_iterator;
-    Anvil::PipelineLayoutManager* layout_manager_ptr = static_cast<PipelineLayoutManager*>(user_arg);
+    PipelineLayoutIDsByHash::iterator hash_bucket_iterator;
+    PipelineLayouts::iterator         layout_iterator;
+    Anvil::PipelineLayoutManager*     layout_manager_ptr  = static_cast<PipelineLayoutManager*>(user_arg);
+    Anvil::PipelineLayout*            pipeline_layout_ptr = static_cast<Anvil::PipelineLayout*>(callback_arg);
 
-    ANVIL_REDUNDANT_ARGUMENT(callback_arg);
+    layout_iterator = layout_manager_ptr->m_pipeline_layouts.find(pipeline_layout_ptr->get_id() );
 
-    /* Are we the last standing layout user? */
-    for (layout_iterator  = layout_manager_ptr->m_pipeline_layouts.begin();
-         layout_iterator != layout_manager_ptr->m_pipeline_layouts.end();
-        )
+    if (layout_iterator == layout_manager_ptr->m_pipeline_layouts.end() )
     {
-        if (layout_iterator->second.expired() )
-        {
-            layout_manager_ptr->m_pipeline_layouts.erase(layout_iterator);
+        anvil_assert(!(layout_iterator == layout_manager_ptr->m_pipeline_layouts.end()) );
 
-            layout_iterator = layout_manager_ptr->m_pipeline_layouts.begin();
-        }
-        else
+        goto end;
+    }
+
+    hash_bucket_iterator = layout_manager_ptr->m_pipeline_layout_ids_by_hash.find(layout_iterator->second.key_hash);
+
+    if (hash_bucket_iterator != layout_manager_ptr->m_pipeline_layout_ids_by_hash.end() )
+    {
+        hash_bucket_iterator->second.erase(std::find(hash_bucket_iterator->second.begin(),
+                                                     hash_bucket_iterator->second.end(),
+                                                     layout_iterator->first) );
+
+        if (hash_bucket_iterator->second.size() == 0)
         {
-            ++layout_iterator;
+            layout_manager_ptr->m_pipeline_layout_ids_by_hash.erase(hash_bucket_iterator);
         }
     }
+
+    layout_manager_ptr->m_pipeline_layouts.erase(layout_iterator);
+end:
+    ;
 }
 
 /* Please see header for specification */
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/device.h"
 #include "wrappers/pipeline_layout.h"
@@ -31,8 +32,10 @@
 Anvil::QueryPool::QueryPool(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
                             VkQueryType                      in_query_type,
                             uint32_t                         in_n_max_concurrent_queries)
-    :m_device_ptr   (in_device_ptr),
-     m_n_max_indices(in_n_max_concurrent_queries)
+    :m_device_ptr         (in_device_ptr),
+     m_n_max_indices      (in_n_max_concurrent_queries),
+     m_pipeline_statistics(0),
+     m_query_type         (in_query_type)
 {
     anvil_assert(in_query_type == VK_QUERY_TYPE_OCCLUSION ||
                  in_query_type == VK_QUERY_TYPE_TIMESTAMP);
@@ -52,8 +55,10 @@ Anvil::QueryPool::QueryPool(std::weak_ptr<Anvil::BaseDevice> in_device_ptr,
                             VkQueryType                      in_query_type,
                             VkFlags                          in_query_flags,
                             uint32_t                         in_n_max_concurrent_queries)
-    :m_device_ptr   (in_device_ptr),
-     m_n_max_indices(in_n_max_concurrent_queries)
+    :m_device_ptr         (in_device_ptr),
+     m_n_max_indices      (in_n_max_concurrent_queries),
+     m_pipeline_statistics((in_query_type == VK_QUERY_TYPE_PIPELINE_STATISTICS) ? in_query_flags : 0),
+     m_query_type         (in_query_type)
 {
     init(in_device_ptr,
          in_query_type,
@@ -73,9 +78,9 @@ Anvil::QueryPool::~QueryPool()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyQueryPool(device_locked_ptr->get_device_vk(),
-                           m_query_pool_vk,
-                           nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_QUERY_POOL,
+                                              m_query_pool_vk);
 
         m_query_pool_vk = VK_NULL_HANDLE;
     }
@@ -118,6 +123,134 @@ std::shared_ptr<Anvil::QueryPool> Anvil::QueryPool::create_ps_query_pool(std::we
     return result_ptr;
 }
 
+/* Please see header for specification */
+uint32_t Anvil::QueryPool::get_n_values_per_query() const
+{
+    uint32_t result = 1;
+
+    if (m_query_type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+    {
+        result = 0;
+
+        for (VkQueryPipelineStatisticFlags flags = m_pipeline_statistics;
+                                           flags != 0;
+                                           flags &= flags - 1)
+        {
+            ++result;
+        }
+    }
+
+    return result;
+}
+
+/* Please see header for specification */
+bool Anvil::QueryPool::get_results(Anvil::QueryIndex  in_first_query,
+                                   uint32_t           in_n_queries,
+                                   VkQueryResultFlags in_flags,
+                                   uint32_t           in_n_out_values,
+                                   uint32_t*          out_results_ptr,
+                                   bool*              opt_out_all_available_ptr)
+{
+    return get_results_internal(in_first_query,
+                                in_n_queries,
+                                in_flags & ~VK_QUERY_RESULT_64_BIT,
+                                sizeof(uint32_t),
+                                in_n_out_values,
+                                out_results_ptr,
+                                opt_out_all_available_ptr);
+}
+
+/* Please see header for specification */
+bool Anvil::QueryPool::get_results(Anvil::QueryIndex  in_first_query,
+                                   uint32_t           in_n_queries,
+                                   VkQueryResultFlags in_flags,
+                                   uint32_t           in_n_out_values,
+                                   uint64_t*          out_results_ptr,
+                                   bool*              opt_out_all_available_ptr)
+{
+    return get_results_internal(in_first_query,
+                                in_n_queries,
+                                in_flags | VK_QUERY_RESULT_64_BIT,
+                                sizeof(uint64_t),
+                                in_n_out_values,
+                                out_results_ptr,
+                                opt_out_all_available_ptr);
+}
+
+/** Issues a vkGetQueryPoolResults() call for the specified range of queries.
+ *
+ *  @param in_value_size Size of a single result value. Must match VK_QUERY_RESULT_64_BIT state in @param in_flags.
+ *
+ *  For other arguments, please see get_results() documentation.
+ *
+ *  @return true if successful, false otherwise.
+ **/
+bool Anvil::QueryPool::get_results_internal(Anvil::QueryIndex  in_first_query,
+                                            uint32_t           in_n_queries,
+                                            VkQueryResultFlags in_flags,
+                                            uint32_t           in_value_size,
+                                            uint32_t           in_n_out_values,
+                                            void*              out_results_ptr,
+                                            bool*              opt_out_all_available_ptr)
+{
+    std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
+    const uint32_t                     n_values_per_query = get_n_values_per_query() + (((in_flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) != 0) ? 1 : 0);
+    bool                               result             = false;
+    VkResult                           result_vk;
+
+    if (in_first_query + in_n_queries > m_n_max_indices)
+    {
+        anvil_assert(in_first_query + in_n_queries <= m_n_max_indices);
+
+        goto end;
+    }
+
+    if (in_n_out_values < in_n_queries * n_values_per_query)
+    {
+        anvil_assert(in_n_out_values >= in_n_queries * n_values_per_query);
+
+        goto end;
+    }
+
+    if (in_n_queries == 0)
+    {
+        if (opt_out_all_available_ptr != nullptr)
+        {
+            *opt_out_all_available_ptr = true;
+        }
+
+        result = true;
+
+        goto end;
+    }
+
+    result_vk = vkGetQueryPoolResults(device_locked_ptr->get_device_vk(),
+                                      m_query_pool_vk,
+                                      in_first_query,
+                                      in_n_queries,
+                                      static_cast<size_t>(in_n_queries) * n_values_per_query * in_value_size,
+                                      out_results_ptr,
+                                      static_cast<VkDeviceSize>(n_values_per_query) * in_value_size,
+                                      in_flags);
+
+    if (result_vk != VK_SUCCESS   &&
+        result_vk != VK_NOT_READY)
+    {
+        anvil_assert_vk_call_succeeded(result_vk);
+
+        goto end;
+    }
+
+    if (opt_out_all_available_ptr != nullptr)
+    {
+        *opt_out_all_available_ptr = (result_vk == VK_SUCCESS);
+    }
+
+    result = true;
+end:
+    return result;
+}
+
 /* Please see header for specification */
 void Anvil::QueryPool::init(std::weak_ptr<Anvil::BaseDevice>  in_device_ptr,
                             VkQueryType                       in_query_type,
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/fence_pool.h"
 #include "misc/object_tracker.h"
 #include "misc/window.h"
 #include "wrappers/buffer.h"
@@ -36,15 +37,137 @@
 #define MAX_SWAPCHAINS (32)
 
 
+/** Please see header for specification */
+Anvil::QueueSubmitBatch::QueueSubmitBatch()
+{
+    /* Stub */
+}
+
+/** Please see header for specification */
+void Anvil::QueueSubmitBatch::add_submit(uint32_t                                         n_command_buffers,
+                                         std::shared_ptr<Anvil::CommandBufferBase> const* opt_cmd_buffer_ptrs,
+                                         uint32_t                                         n_semaphores_to_signal,
+                                         std::shared_ptr<Anvil::Semaphore> const*         opt_semaphore_to_signal_ptr_ptrs,
+                                         uint32_t                                         n_semaphores_to_wait_on,
+                                         std::shared_ptr<Anvil::Semaphore> const*         opt_semaphore_to_wait_on_ptr_ptrs,
+                                         const VkPipelineStageFlags*                      opt_dst_stage_masks_to_wait_on_ptrs)
+{
+    Submit submit;
+
+    submit.n_command_buffers        = n_command_buffers;
+    submit.n_first_command_buffer   = static_cast<uint32_t>(m_cmd_buffers.size         () );
+    submit.n_first_signal_semaphore = static_cast<uint32_t>(m_signal_semaphores_vk.size() );
+    submit.n_first_wait_semaphore   = static_cast<uint32_t>(m_wait_semaphores_vk.size  () );
+    submit.n_signal_semaphores      = n_semaphores_to_signal;
+    submit.n_wait_semaphores        = n_semaphores_to_wait_on;
+
+    for (uint32_t n_command_buffer = 0;
+                  n_command_buffer < n_command_buffers;
+                ++n_command_buffer)
+    {
+        m_cmd_buffers.push_back   (opt_cmd_buffer_ptrs[n_command_buffer]);
+        m_cmd_buffers_vk.push_back(opt_cmd_buffer_ptrs[n_command_buffer]->get_command_buffer() );
+    }
+
+    for (uint32_t n_signal_semaphore = 0;
+                  n_signal_semaphore < n_semaphores_to_signal;
+                ++n_signal_semaphore)
+    {
+        m_semaphores.push_back          (opt_semaphore_to_signal_ptr_ptrs[n_signal_semaphore]);
+        m_signal_semaphores_vk.push_back(opt_semaphore_to_signal_ptr_ptrs[n_signal_semaphore]->get_semaphore() );
+    }
+
+    for (uint32_t n_wait_semaphore = 0;
+                  n_wait_semaphore < n_semaphores_to_wait_on;
+                ++n_wait_semaphore)
+    {
+        m_semaphores.push_back          (opt_semaphore_to_wait_on_ptr_ptrs  [n_wait_semaphore]);
+        m_wait_dst_stage_masks.push_back(opt_dst_stage_masks_to_wait_on_ptrs[n_wait_semaphore]);
+        m_wait_semaphores_vk.push_back  (opt_semaphore_to_wait_on_ptr_ptrs  [n_wait_semaphore]->get_semaphore() );
+    }
+
+    m_submits.push_back(submit);
+}
+
+/** Please see header for specification */
+void Anvil::QueueSubmitBatch::clear()
+{
+    m_cmd_buffers.clear         ();
+    m_cmd_buffers_vk.clear      ();
+    m_semaphores.clear          ();
+    m_signal_semaphores_vk.clear();
+    m_submit_infos_vk.clear     ();
+    m_submits.clear             ();
+    m_wait_dst_stage_masks.clear();
+    m_wait_semaphores_vk.clear  ();
+}
+
+/** Moves all logical submissions held by @param in_batch to the end of this batch, and clears
+ *  @param in_batch.
+ *
+ *  @param in_batch Batch to move the submissions from. Must not be this batch.
+ **/
+void Anvil::QueueSubmitBatch::move_submits_from(QueueSubmitBatch& in_batch)
+{
+    anvil_assert(&in_batch != this);
+
+    if (m_submits.size() == 0)
+    {
+        /* Swap storage, so that neither of the batches needs to reallocate later on. */
+        m_cmd_buffers.swap         (in_batch.m_cmd_buffers);
+        m_cmd_buffers_vk.swap      (in_batch.m_cmd_buffers_vk);
+        m_semaphores.swap          (in_batch.m_semaphores);
+        m_signal_semaphores_vk.swap(in_batch.m_signal_semaphores_vk);
+        m_submits.swap             (in_batch.m_submits);
+        m_wait_dst_stage_masks.swap(in_batch.m_wait_dst_stage_masks);
+        m_wait_semaphores_vk.swap  (in_batch.m_wait_semaphores_vk);
+    }
+    else
+    {
+        const uint32_t n_first_command_buffer   = static_cast<uint32_t>(m_cmd_buffers.size         () );
+        const uint32_t n_first_signal_semaphore = static_cast<uint32_t>(m_signal_semaphores_vk.size() );
+        const uint32_t n_first_wait_semaphore   = static_cast<uint32_t>(m_wait_semaphores_vk.size  () );
+
+        m_cmd_buffers.insert         (m_cmd_buffers.end         (), in_batch.m_cmd_buffers.begin         (), in_batch.m_cmd_buffers.end         () );
+        m_cmd_buffers_vk.insert      (m_cmd_buffers_vk.end      (), in_batch.m_cmd_buffers_vk.begin      (), in_batch.m_cmd_buffers_vk.end      () );
+        m_semaphores.insert          (m_semaphores.end          (), in_batch.m_semaphores.begin          (), in_batch.m_semaphores.end          () );
+        m_signal_semaphores_vk.insert(m_signal_semaphores_vk.end(), in_batch.m_signal_semaphores_vk.begin(), in_batch.m_signal_semaphores_vk.end() );
+        m_wait_dst_stage_masks.insert(m_wait_dst_stage_masks.end(), in_batch.m_wait_dst_stage_masks.begin(), in_batch.m_wait_dst_stage_masks.end() );
+        m_wait_semaphores_vk.insert  (m_wait_semaphores_vk.end  (), in_batch.m_wait_semaphores_vk.begin  (), in_batch.m_wait_semaphores_vk.end  () );
+
+        for (auto submit_iterator  = in_batch.m_submits.cbegin();
+                  submit_iterator != in_batch.m_submits.cend();
+                ++submit_iterator)
+        {
+            Submit submit = *submit_iterator;
+
+            submit.n_first_command_buffer   += n_first_command_buffer;
+            submit.n_first_signal_semaphore += n_first_signal_semaphore;
+            submit.n_first_wait_semaphore   += n_first_wait_semaphore;
+
+            m_submits.push_back(submit);
+        }
+    }
+
+    in_batch.clear();
+}
+
+
 /** Please see header for specification */
 Anvil::Queue::Queue(std::weak_ptr<Anvil::BaseDevice> device_ptr,
                     uint32_t                         queue_family_index,
                     uint32_t                         queue_index)
 
-    :m_device_ptr        (device_ptr),
-     m_queue             (VK_NULL_HANDLE),
-     m_queue_family_index(queue_family_index),
-     m_queue_index       (queue_index)
+    :m_device_ptr                 (device_ptr),
+     m_n_submissions              (0),
+     m_queue                      (VK_NULL_HANDLE),
+     m_queue_family_index         (queue_family_index),
+     m_queue_index                (queue_index),
+     m_submission_mode            (Anvil::QUEUE_SUBMISSION_MODE_UNSYNCHRONIZED),
+     m_n_submit_requests_pushed   (0),
+     m_n_submit_requests_submitted(0),
+     m_submit_requests_head       (nullptr),
+     m_submit_thread_should_quit  (false)
 {
     std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(device_ptr);
 
@@ -67,12 +190,53 @@ Anvil::Queue::Queue(std::weak_ptr<Anvil::BaseDevice> device_ptr,
 /** Please see header for specification */
 Anvil::Queue::~Queue()
 {
-    /* Queues are indestructible. Nothing to do here. */
+    /* Queues are indestructible. Make sure all pending submissions have been handed over to Vulkan though. */
+    if (m_submission_mode == Anvil::QUEUE_SUBMISSION_MODE_SUBMIT_THREAD)
+    {
+        stop_submit_thread();
+    }
+
+    for (auto request_iterator  = m_free_submit_requests.begin();
+              request_iterator != m_free_submit_requests.end();
+            ++request_iterator)
+    {
+        delete *request_iterator;
+    }
+
+    m_free_submit_requests.clear();
 
     Anvil::ObjectTracker::get()->unregister_object(Anvil::OBJECT_TYPE_QUEUE,
                                                     this);
 }
 
+/** Retrieves a submit request descriptor, which can be filled and pushed to the submit thread.
+ *  Descriptors are recycled by the submit thread once their requests have been submitted.
+ *
+ *  @return Submit request descriptor. Never nullptr.
+ **/
+Anvil::Queue::SubmitRequest* Anvil::Queue::acquire_submit_request()
+{
+    SubmitRequest* result_ptr = nullptr;
+
+    {
+        std::unique_lock<std::mutex> lock(m_free_submit_requests_mutex);
+
+        if (m_free_submit_requests.size() > 0)
+        {
+            result_ptr = m_free_submit_requests.back();
+
+            m_free_submit_requests.pop_back();
+        }
+    }
+
+    if (result_ptr == nullptr)
+    {
+        result_ptr = new SubmitRequest();
+    }
+
+    return result_ptr;
+}
+
 /** Please see header for specification */
 bool Anvil::Queue::bind_sparse_memory(Anvil::Utils::SparseMemoryBindingUpdateInfo& update)
 {
@@ -85,10 +249,27 @@ bool Anvil::Queue::bind_sparse_memory(Anvil::Utils::SparseMemoryBindingUpdateInf
                                      &bind_info_items,
                                      &fence_ptr);
 
-    result = vkQueueBindSparse(m_queue,
-                               n_bind_info_items,
-                               bind_info_items,
-                               (fence_ptr != nullptr) ? fence_ptr->get_fence() : VK_NULL_HANDLE);
+    /* Semaphores waited on by the bind operation may be signalled by pending submissions */
+    flush_submissions();
+
+    ++m_n_submissions;
+
+    {
+        std::unique_lock<std::mutex> lock(m_queue_mutex,
+                                          std::defer_lock);
+
+        if (m_submission_mode != Anvil::QUEUE_SUBMISSION_MODE_UNSYNCHRONIZED)
+        {
+            lock.lock();
+        }
+
+        /* get_fence_ptr() marks the fence as possibly set, which tells the fence pool it has been submitted. */
+        result = vkQueueBindSparse(m_queue,
+                                   n_bind_info_items,
+                                   bind_info_items,
+                                   (fence_ptr != nullptr) ? *fence_ptr->get_fence_ptr() : VK_NULL_HANDLE);
+    }
+
     anvil_assert(result == VK_SUCCESS);
 
     for (uint32_t n_bind_info = 0;
@@ -208,6 +389,22 @@ std::shared_ptr<Anvil::Queue> Anvil::Queue::create(std::weak_ptr<Anvil::BaseDevi
     return result_ptr;
 }
 
+/** Please see header for specification */
+void Anvil::Queue::flush_submissions()
+{
+    if (m_submission_mode == Anvil::QUEUE_SUBMISSION_MODE_SUBMIT_THREAD)
+    {
+        const uint64_t               n_submit_requests_pushed = m_n_submit_requests_pushed.load();
+        std::unique_lock<std::mutex> lock                    (m_submit_thread_mutex);
+
+        m_submit_requests_submitted_cv.wait(lock,
+                                            [this, n_submit_requests_pushed]()
+                                            {
+                                                return m_n_submit_requests_submitted >= n_submit_requests_pushed;
+                                            });
+    }
+}
+
 /** Please see header for specification */
 VkResult Anvil::Queue::present(std::shared_ptr<Anvil::Swapchain>  swapchain_ptr,
                                uint32_t                           swapchain_image_index,
@@ -279,8 +476,21 @@ VkResult Anvil::Queue::present(std::shared_ptr<Anvil::Swapchain>  swapchain_ptr,
     image_presentation_info.swapchainCount     = 1;
     image_presentation_info.waitSemaphoreCount = n_wait_semaphores;
 
-    result = swapchain_entrypoints.vkQueuePresentKHR(m_queue,
-                                                    &image_presentation_info);
+    /* The semaphores to wait on are usually signalled by submissions which may still be pending */
+    flush_submissions();
+
+    {
+        std::unique_lock<std::mutex> lock(m_queue_mutex,
+                                          std::defer_lock);
+
+        if (m_submission_mode != Anvil::QUEUE_SUBMISSION_MODE_UNSYNCHRONIZED)
+        {
+            lock.lock();
+        }
+
+        result = swapchain_entrypoints.vkQueuePresentKHR(m_queue,
+                                                        &image_presentation_info);
+    }
 
     anvil_assert_vk_call_succeeded(result);
 
@@ -342,6 +552,322 @@ end:
     return result;
 }
 
+/** Processes a list of requests taken from the submit thread's request queue, coalescing
+ *  them into as few vkQueueSubmit() calls as possible. The request descriptors are recycled
+ *  afterward.
+ *
+ *  Only called from the submit thread.
+ *
+ *  @param in_requests_ptr Requests to process, in LIFO order. Must not be nullptr.
+ **/
+void Anvil::Queue::process_submit_requests(SubmitRequest* in_requests_ptr)
+{
+    uint32_t       n_requests         = 0;
+    SubmitRequest* request_ptr        = in_requests_ptr;
+    SubmitRequest* requests_fifo_ptr  = nullptr;
+
+    /* The request queue is a LIFO. Restore the order the requests were pushed in. */
+    while (request_ptr != nullptr)
+    {
+        SubmitRequest* next_request_ptr = request_ptr->next_ptr;
+
+        request_ptr->next_ptr = requests_fifo_ptr;
+        requests_fifo_ptr     = request_ptr;
+        request_ptr           = next_request_ptr;
+
+        ++n_requests;
+    }
+
+    /* Coalesce the requests. A fence is signalled once all submissions of the vkQueueSubmit() call
+     * it is passed to finish executing, so each fence ends a call. */
+    for (request_ptr  = requests_fifo_ptr;
+         request_ptr != nullptr;
+         request_ptr  = request_ptr->next_ptr)
+    {
+        m_submit_thread_batch.move_submits_from(request_ptr->batch);
+
+        if (request_ptr->fence_ptr != nullptr)
+        {
+            std::unique_lock<std::mutex> lock(m_queue_mutex);
+
+            submit_batch_internal(&m_submit_thread_batch,
+                                  request_ptr->fence_ptr);
+
+            request_ptr->fence_ptr.reset();
+        }
+    }
+
+    if (!m_submit_thread_batch.is_empty() )
+    {
+        std::unique_lock<std::mutex> lock(m_queue_mutex);
+
+        submit_batch_internal(&m_submit_thread_batch,
+                              nullptr); /* in_opt_fence_ptr */
+    }
+
+    /* Recycle the request descriptors */
+    {
+        std::unique_lock<std::mutex> lock(m_free_submit_requests_mutex);
+
+        for (request_ptr  = requests_fifo_ptr;
+             request_ptr != nullptr;
+             request_ptr  = request_ptr->next_ptr)
+        {
+            m_free_submit_requests.push_back(request_ptr);
+        }
+    }
+
+    /* Wake up threads waiting in flush_submissions() */
+    {
+        std::unique_lock<std::mutex> lock(m_submit_thread_mutex);
+
+        m_n_submit_requests_submitted += n_requests;
+    }
+
+    m_submit_requests_submitted_cv.notify_all();
+}
+
+/** Pushes a filled submit request descriptor to the submit thread's request queue.
+ *
+ *  The queue is a lock-free LIFO list. The submit thread takes the whole list at once, and
+ *  restores the FIFO order on its own. The submit thread's mutex is only taken if the list was
+ *  empty, since the submit thread may be about to sleep in that case.
+ *
+ *  @param in_request_ptr Request to push. Must not be nullptr.
+ **/
+void Anvil::Queue::push_submit_request(SubmitRequest* in_request_ptr)
+{
+    SubmitRequest* head_ptr = m_submit_requests_head.load(std::memory_order_relaxed);
+
+    do
+    {
+        in_request_ptr->next_ptr = head_ptr;
+    }
+    while (!m_submit_requests_head.compare_exchange_weak(head_ptr,
+                                                         in_request_ptr,
+                                                         std::memory_order_release,
+                                                         std::memory_order_relaxed) );
+
+    ++m_n_submit_requests_pushed;
+
+    if (head_ptr == nullptr)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_submit_thread_mutex);
+        }
+
+        m_submit_thread_cv.notify_one();
+    }
+}
+
+/** Please see header for specification */
+void Anvil::Queue::set_submission_mode(Anvil::QueueSubmissionMode in_submission_mode)
+{
+    anvil_assert(in_submission_mode < Anvil::QUEUE_SUBMISSION_MODE_COUNT);
+
+    if (in_submission_mode == m_submission_mode)
+    {
+        goto end;
+    }
+
+    if (m_submission_mode == Anvil::QUEUE_SUBMISSION_MODE_SUBMIT_THREAD)
+    {
+        stop_submit_thread();
+    }
+
+    m_submission_mode = in_submission_mode;
+
+    if (m_submission_mode == Anvil::QUEUE_SUBMISSION_MODE_SUBMIT_THREAD)
+    {
+        start_submit_thread();
+    }
+
+end:
+    ;
+}
+
+/** Spawns the submit thread. */
+void Anvil::Queue::start_submit_thread()
+{
+    anvil_assert(!m_submit_thread.joinable() );
+
+    m_submit_thread_should_quit = false;
+    m_submit_thread             = std::thread(&Anvil::Queue::submit_thread_entrypoint,
+                                              this);
+}
+
+/** Asks the submit thread to quit, and blocks until it does. All requests which have been pushed
+ *  prior to the call are submitted before the thread quits.
+ **/
+void Anvil::Queue::stop_submit_thread()
+{
+    anvil_assert(m_submit_thread.joinable() );
+
+    {
+        std::unique_lock<std::mutex> lock(m_submit_thread_mutex);
+
+        m_submit_thread_should_quit = true;
+    }
+
+    m_submit_thread_cv.notify_one();
+    m_submit_thread.join         ();
+}
+
+/** Please see header for specification */
+void Anvil::Queue::submit_batch(Anvil::QueueSubmitBatch*      batch_ptr,
+                                bool                          should_block,
+                                std::shared_ptr<Anvil::Fence> opt_fence_ptr)
+{
+    /* Sanity checks */
+    anvil_assert(m_device_ptr.lock()->get_type() == Anvil::DEVICE_TYPE_SINGLE_GPU);
+
+    if (batch_ptr->is_empty()     &&
+        opt_fence_ptr == nullptr &&
+        !should_block)
+    {
+        goto end;
+    }
+
+    /* Prepare for the submission */
+    if (opt_fence_ptr == nullptr &&
+        should_block)
+    {
+        opt_fence_ptr = m_device_ptr.lock()->get_fence_pool()->get_fence();
+    }
+
+    ++m_n_submissions;
+
+    if (!batch_ptr->m_cmd_buffers.empty() )
+    {
+        commit_resource_states(static_cast<uint32_t>(batch_ptr->m_cmd_buffers.size() ),
+                              &batch_ptr->m_cmd_buffers.at(0) );
+    }
+
+    switch (m_submission_mode)
+    {
+        case Anvil::QUEUE_SUBMISSION_MODE_UNSYNCHRONIZED:
+        {
+            submit_batch_internal(batch_ptr,
+                                  opt_fence_ptr);
+
+            break;
+        }
+
+        case Anvil::QUEUE_SUBMISSION_MODE_MUTEX:
+        {
+            std::unique_lock<std::mutex> lock(m_queue_mutex);
+
+            submit_batch_internal(batch_ptr,
+                                  opt_fence_ptr);
+
+            break;
+        }
+
+        case Anvil::QUEUE_SUBMISSION_MODE_SUBMIT_THREAD:
+        {
+            SubmitRequest* request_ptr = acquire_submit_request();
+
+            request_ptr->batch.move_submits_from(*batch_ptr);
+            request_ptr->fence_ptr = opt_fence_ptr;
+
+            push_submit_request(request_ptr);
+
+            break;
+        }
+
+        default:
+        {
+            anvil_assert(false);
+        }
+    }
+
+    if (should_block)
+    {
+        wait_for_fence(opt_fence_ptr);
+    }
+
+end:
+    batch_ptr->clear();
+}
+
+/** Commits resource states of the specified command buffers (please see
+ *  CommandBufferBase::commit_resource_states()).
+ *
+ *  Must be called on the thread which issued the submission, before the request is handed over to
+ *  the submit thread, so that command buffers recorded by that thread afterward see the committed states.
+ *
+ *  @param in_n_command_buffers Number of command buffers under @param in_cmd_buffer_ptrs.
+ *  @param in_cmd_buffer_ptrs   Command buffers to commit. May be nullptr if @param in_n_command_buffers is 0.
+ **/
+void Anvil::Queue::commit_resource_states(uint32_t                                         in_n_command_buffers,
+                                          std::shared_ptr<Anvil::CommandBufferBase> const* in_cmd_buffer_ptrs)
+{
+    for (uint32_t n_cmd_buffer = 0;
+                  n_cmd_buffer < in_n_command_buffers;
+                ++n_cmd_buffer)
+    {
+        const bool commit_result = in_cmd_buffer_ptrs[n_cmd_buffer]->commit_resource_states();
+
+        /* If this assertion fails, resources transitioned with record_transition() are in different states
+         * than the command buffer assumed at recording time. This happens if command buffers which transition
+         * the same resources are submitted in a different order than they were recorded in. */
+        anvil_assert(commit_result);
+        ANVIL_REDUNDANT_VARIABLE_CONST(commit_result);
+    }
+}
+
+/** Submits all logical submissions held by the batch with a single vkQueueSubmit() call, and
+ *  clears the batch.
+ *
+ *  Resource states of the command buffers must have been committed by the caller.
+ *
+ *  The caller is responsible for synchronizing access to the Vulkan queue.
+ *
+ *  @param in_batch_ptr     Batch to submit. Must not be nullptr.
+ *  @param in_opt_fence_ptr Fence to pass to vkQueueSubmit(). May be nullptr.
+ **/
+void Anvil::Queue::submit_batch_internal(Anvil::QueueSubmitBatch*      in_batch_ptr,
+                                         std::shared_ptr<Anvil::Fence> in_opt_fence_ptr)
+{
+    const uint32_t n_submits = in_batch_ptr->get_n_submits();
+    VkResult       result    (VK_ERROR_INITIALIZATION_FAILED);
+
+    ANVIL_REDUNDANT_VARIABLE(result);
+
+    /* Submit info descriptors can only be filled once all logical submissions have been added, since
+     * the arrays they point to may have been reallocated in the meantime. */
+    in_batch_ptr->m_submit_infos_vk.resize(n_submits);
+
+    for (uint32_t n_submit = 0;
+                  n_submit < n_submits;
+                ++n_submit)
+    {
+        const QueueSubmitBatch::Submit& submit      = in_batch_ptr->m_submits        [n_submit];
+        VkSubmitInfo&                   submit_info = in_batch_ptr->m_submit_infos_vk[n_submit];
+
+        submit_info.commandBufferCount   = submit.n_command_buffers;
+        submit_info.pCommandBuffers      = (submit.n_command_buffers   > 0) ? &in_batch_ptr->m_cmd_buffers_vk      [submit.n_first_command_buffer]   : nullptr;
+        submit_info.pNext                = nullptr;
+        submit_info.pSignalSemaphores    = (submit.n_signal_semaphores > 0) ? &in_batch_ptr->m_signal_semaphores_vk[submit.n_first_signal_semaphore] : nullptr;
+        submit_info.pWaitDstStageMask    = (submit.n_wait_semaphores   > 0) ? &in_batch_ptr->m_wait_dst_stage_masks[submit.n_first_wait_semaphore]   : nullptr;
+        submit_info.pWaitSemaphores      = (submit.n_wait_semaphores   > 0) ? &in_batch_ptr->m_wait_semaphores_vk  [submit.n_first_wait_semaphore]   : nullptr;
+        submit_info.signalSemaphoreCount = submit.n_signal_semaphores;
+        submit_info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.waitSemaphoreCount   = submit.n_wait_semaphores;
+    }
+
+    /* Go for it. get_fence_ptr() marks the fence as possibly set, which tells the fence pool it has been submitted. */
+    result = vkQueueSubmit(m_queue,
+                           n_submits,
+                           (n_submits        >  0)       ? &in_batch_ptr->m_submit_infos_vk[0]
+                                                         : nullptr,
+                           (in_opt_fence_ptr != nullptr) ? *in_opt_fence_ptr->get_fence_ptr()
+                                                         : VK_NULL_HANDLE);
+    anvil_assert_vk_call_succeeded(result);
+
+    in_batch_ptr->clear();
+}
+
 /** Please see header for specification */
 void Anvil::Queue::submit_command_buffers(uint32_t                                         n_command_buffers,
                                           std::shared_ptr<Anvil::CommandBufferBase> const* opt_cmd_buffer_ptrs,
@@ -353,78 +879,125 @@ void Anvil::Queue::submit_command_buffers(uint32_t
                                           bool                                             should_block,
                                           std::shared_ptr<Anvil::Fence>                    opt_fence_ptr)
 {
-    VkResult        result     (VK_ERROR_INITIALIZATION_FAILED);
-    VkSubmitInfo    submit_info;
-
-    VkCommandBuffer cmd_buffers_vk      [64];
-    VkSemaphore     signal_semaphores_vk[64];
-    VkSemaphore     wait_semaphores_vk  [64];
-
-    ANVIL_REDUNDANT_VARIABLE(result);
-
     /* Sanity checks */
     anvil_assert(m_device_ptr.lock()->get_type() == Anvil::DEVICE_TYPE_SINGLE_GPU);
-    anvil_assert(n_command_buffers               <  sizeof(cmd_buffers_vk)       / sizeof(cmd_buffers_vk      [0]) );
-    anvil_assert(n_semaphores_to_signal          <  sizeof(signal_semaphores_vk) / sizeof(signal_semaphores_vk[0]) );
-    anvil_assert(n_semaphores_to_wait_on         <  sizeof(wait_semaphores_vk)   / sizeof(wait_semaphores_vk  [0]) );
 
     /* Prepare for the submission */
     if (opt_fence_ptr == nullptr &&
         should_block)
     {
-        opt_fence_ptr = Anvil::Fence::create(m_device_ptr,
-                                             false /* create_signalled */);
+        opt_fence_ptr = m_device_ptr.lock()->get_fence_pool()->get_fence();
     }
 
-    for (uint32_t n_command_buffer = 0;
-                  n_command_buffer < n_command_buffers;
-                ++n_command_buffer)
+    ++m_n_submissions;
+
+    commit_resource_states(n_command_buffers,
+                           opt_cmd_buffer_ptrs);
+
+    /* A single logical submission is a batch of one. The batch's storage is reused across calls. */
+    if (m_submission_mode == Anvil::QUEUE_SUBMISSION_MODE_SUBMIT_THREAD)
     {
-        cmd_buffers_vk[n_command_buffer] = opt_cmd_buffer_ptrs[n_command_buffer]->get_command_buffer();
-    }
+        SubmitRequest* request_ptr = acquire_submit_request();
 
-    for (uint32_t n_signal_semaphore = 0;
-                  n_signal_semaphore < n_semaphores_to_signal;
-                ++n_signal_semaphore)
+        request_ptr->batch.add_submit(n_command_buffers,
+                                      opt_cmd_buffer_ptrs,
+                                      n_semaphores_to_signal,
+                                      opt_semaphore_to_signal_ptr_ptrs,
+                                      n_semaphores_to_wait_on,
+                                      opt_semaphore_to_wait_on_ptr_ptrs,
+                                      opt_dst_stage_masks_to_wait_on_ptrs);
+
+        request_ptr->fence_ptr = opt_fence_ptr;
+
+        push_submit_request(request_ptr);
+    }
+    else
     {
-        signal_semaphores_vk[n_signal_semaphore] = opt_semaphore_to_signal_ptr_ptrs[n_signal_semaphore]->get_semaphore();
+        std::unique_lock<std::mutex> lock(m_queue_mutex,
+                                          std::defer_lock);
+
+        if (m_submission_mode == Anvil::QUEUE_SUBMISSION_MODE_MUTEX)
+        {
+            lock.lock();
+        }
+
+        m_single_submit_batch.add_submit(n_command_buffers,
+                                         opt_cmd_buffer_ptrs,
+                                         n_semaphores_to_signal,
+                                         opt_semaphore_to_signal_ptr_ptrs,
+                                         n_semaphores_to_wait_on,
+                                         opt_semaphore_to_wait_on_ptr_ptrs,
+                                         opt_dst_stage_masks_to_wait_on_ptrs);
+
+        submit_batch_internal(&m_single_submit_batch,
+                              opt_fence_ptr);
     }
 
-    for (uint32_t n_wait_semaphore = 0;
-                  n_wait_semaphore < n_semaphores_to_wait_on;
-                ++n_wait_semaphore)
+    if (should_block)
     {
-        wait_semaphores_vk[n_wait_semaphore] = opt_semaphore_to_wait_on_ptr_ptrs[n_wait_semaphore]->get_semaphore();
+        wait_for_fence(opt_fence_ptr);
     }
+}
 
-    submit_info.commandBufferCount   = n_command_buffers;
-    submit_info.pCommandBuffers      = cmd_buffers_vk;
-    submit_info.pNext                = nullptr;
-    submit_info.pSignalSemaphores    = signal_semaphores_vk;
-    submit_info.pWaitDstStageMask    = opt_dst_stage_masks_to_wait_on_ptrs;
-    submit_info.pWaitSemaphores      = wait_semaphores_vk;
-    submit_info.signalSemaphoreCount = n_semaphores_to_signal;
-    submit_info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.waitSemaphoreCount   = n_semaphores_to_wait_on;
+/** Entry-point of the submit thread. Please see set_submission_mode() for more details. */
+void Anvil::Queue::submit_thread_entrypoint()
+{
+    while (true)
+    {
+        SubmitRequest* requests_ptr = nullptr;
+        bool           should_quit  = false;
 
-    /* Go for it */
-    result = vkQueueSubmit(m_queue,
-                           1, /* submitCount */
-                          &submit_info,
-                          (opt_fence_ptr != nullptr) ? opt_fence_ptr->get_fence() 
-                                                     : VK_NULL_HANDLE);
-    anvil_assert_vk_call_succeeded(result);
+        {
+            std::unique_lock<std::mutex> lock(m_submit_thread_mutex);
 
-    if (should_block)
-    {
-        /* Wait till initialization finishes GPU-side */
-        std::shared_ptr<Anvil::SGPUDevice> sgpu_device_locked_ptr(std::dynamic_pointer_cast<Anvil::SGPUDevice>(m_device_ptr.lock() ) );
+            m_submit_thread_cv.wait(lock,
+                                    [this]()
+                                    {
+                                        return m_submit_requests_head.load() != nullptr ||
+                                               m_submit_thread_should_quit;
+                                    });
+
+            should_quit = m_submit_thread_should_quit;
+        }
 
-        result = vkWaitForFences(sgpu_device_locked_ptr->get_device_vk(),
-                                 1, /* fenceCount */
-                                 opt_fence_ptr->get_fence_ptr(),
-                                 VK_TRUE,     /* waitAll */
-                                 UINT64_MAX); /* timeout */
-        anvil_assert_vk_call_succeeded(result);
+        requests_ptr = m_submit_requests_head.exchange(nullptr,
+                                                       std::memory_order_acquire);
+
+        if (requests_ptr != nullptr)
+        {
+            process_submit_requests(requests_ptr);
+        }
+        else
+        if (should_quit)
+        {
+            break;
+        }
     }
+}
+
+/** Blocks until the specified fence is signalled. In submit thread mode, first waits until the submit thread
+ *  has submitted all pending requests.
+ *
+ *  @param in_fence_ptr Fence to wait on. Must not be nullptr.
+ **/
+void Anvil::Queue::wait_for_fence(std::shared_ptr<Anvil::Fence> in_fence_ptr)
+{
+    std::shared_ptr<Anvil::SGPUDevice> sgpu_device_locked_ptr(std::dynamic_pointer_cast<Anvil::SGPUDevice>(m_device_ptr.lock() ) );
+    VkResult                           result                (VK_ERROR_INITIALIZATION_FAILED);
+
+    ANVIL_REDUNDANT_VARIABLE(result);
+
+    /* In submit thread mode, the fence may not have been submitted yet. Vulkan requires access to the fence to
+     * be externally synchronized, so it must not be waited on while the submit thread passes it to
+     * vkQueueSubmit(). Wait until all requests pushed so far, including the one the fence belongs to, have
+     * been submitted. */
+    flush_submissions();
+
+    /* Wait till the submissions finish executing GPU-side. */
+    result = vkWaitForFences(sgpu_device_locked_ptr->get_device_vk(),
+                             1, /* fenceCount */
+                             in_fence_ptr->get_fence_ptr(),
+                             VK_TRUE,     /* waitAll */
+                             UINT64_MAX); /* timeout */
+    anvil_assert_vk_call_succeeded(result);
 }
\ No newline at end of file
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/device.h"
 #include "wrappers/graphics_pipeline_manager.h"
@@ -51,9 +52,9 @@ Anvil::RenderPass::~RenderPass()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyRenderPass(device_locked_ptr->get_device_vk(),
-                            m_render_pass,
-                            nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_RENDER_PASS,
+                                              m_render_pass);
 
         m_render_pass = VK_NULL_HANDLE;
     }
@@ -678,9 +679,9 @@ bool Anvil::RenderPass::bake()
     /* If this is not first baking request, release the previously created render pass instance */
     if (m_render_pass != VK_NULL_HANDLE)
     {
-        vkDestroyRenderPass(device_locked_ptr->get_device_vk(),
-                            m_render_pass,
-                            nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_RENDER_PASS,
+                                              m_render_pass);
 
         m_render_pass = VK_NULL_HANDLE;
     }
@@ -1034,6 +1035,79 @@ end:
     return result;
 }
 
+/** Please see header for specification */
+void Anvil::RenderPass::get_compatibility_key(std::vector<uint32_t>* out_key_ptr) const
+{
+    auto get_attachment_index = [](const RenderPassAttachment* in_attachment_ptr)
+    {
+        return (in_attachment_ptr != nullptr) ? in_attachment_ptr->index
+                                              : VK_ATTACHMENT_UNUSED;
+    };
+
+    out_key_ptr->clear();
+
+    /* Attachment references are compatible if the attachments they refer to use the same format & sample count */
+    out_key_ptr->push_back(static_cast<uint32_t>(m_attachments.size() ));
+
+    for (auto attachment_iterator  = m_attachments.cbegin();
+              attachment_iterator != m_attachments.cend();
+            ++attachment_iterator)
+    {
+        out_key_ptr->push_back(static_cast<uint32_t>(attachment_iterator->format) );
+        out_key_ptr->push_back(static_cast<uint32_t>(attachment_iterator->sample_count) );
+    }
+
+    /* Subpasses must match in all respects other than attachment layouts */
+    out_key_ptr->push_back(static_cast<uint32_t>(m_subpasses.size() ));
+
+    for (auto subpass_iterator  = m_subpasses.cbegin();
+              subpass_iterator != m_subpasses.cend();
+            ++subpass_iterator)
+    {
+        const SubPass* current_subpass_ptr = *subpass_iterator;
+
+        out_key_ptr->push_back(static_cast<uint32_t>(current_subpass_ptr->color_attachments_map.size() ));
+
+        for (auto color_attachment_iterator  = current_subpass_ptr->color_attachments_map.cbegin();
+                  color_attachment_iterator != current_subpass_ptr->color_attachments_map.cend();
+                ++color_attachment_iterator)
+        {
+            out_key_ptr->push_back(color_attachment_iterator->first);
+            out_key_ptr->push_back(get_attachment_index(color_attachment_iterator->second.attachment_ptr) );
+            out_key_ptr->push_back(get_attachment_index(color_attachment_iterator->second.resolve_attachment_ptr) );
+        }
+
+        out_key_ptr->push_back(static_cast<uint32_t>(current_subpass_ptr->input_attachments_map.size() ));
+
+        for (auto input_attachment_iterator  = current_subpass_ptr->input_attachments_map.cbegin();
+                  input_attachment_iterator != current_subpass_ptr->input_attachments_map.cend();
+                ++input_attachment_iterator)
+        {
+            out_key_ptr->push_back(input_attachment_iterator->first);
+            out_key_ptr->push_back(get_attachment_index(input_attachment_iterator->second.attachment_ptr) );
+        }
+
+        out_key_ptr->push_back(get_attachment_index(current_subpass_ptr->depth_stencil_attachment.attachment_ptr) );
+    }
+
+    out_key_ptr->push_back(static_cast<uint32_t>(m_subpass_dependencies.size() ));
+
+    for (auto dependency_iterator  = m_subpass_dependencies.cbegin();
+              dependency_iterator != m_subpass_dependencies.cend();
+            ++dependency_iterator)
+    {
+        out_key_ptr->push_back((dependency_iterator->destination_subpass_ptr != nullptr) ? dependency_iterator->destination_subpass_ptr->index
+                                                                                         : VK_SUBPASS_EXTERNAL);
+        out_key_ptr->push_back((dependency_iterator->source_subpass_ptr      != nullptr) ? dependency_iterator->source_subpass_ptr->index
+                                                                                         : VK_SUBPASS_EXTERNAL);
+        out_key_ptr->push_back(static_cast<uint32_t>(dependency_iterator->destination_access_mask) );
+        out_key_ptr->push_back(static_cast<uint32_t>(dependency_iterator->destination_stage_mask) );
+        out_key_ptr->push_back(static_cast<uint32_t>(dependency_iterator->source_access_mask) );
+        out_key_ptr->push_back(static_cast<uint32_t>(dependency_iterator->source_stage_mask) );
+        out_key_ptr->push_back((dependency_iterator->by_region) ? 1u : 0u);
+    }
+}
+
 /** Please see header for specification */
 bool Anvil::RenderPass::get_dependency_properties(uint32_t              n_dependency,
                                                   SubPassID*            out_destination_subpass_id_ptr,
@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/device.h"
 #include "wrappers/physical_device.h"
@@ -103,9 +104,9 @@ Anvil::Sampler::~Sampler()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroySampler(device_locked_ptr->get_device_vk(),
-                         m_sampler,
-                         nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_SAMPLER,
+                                              m_sampler);
 
         m_sampler = VK_NULL_HANDLE;
     }
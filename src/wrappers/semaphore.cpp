@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/object_tracker.h"
 #include "wrappers/device.h"
 #include "wrappers/semaphore.h"
@@ -64,9 +65,9 @@ void Anvil::Semaphore::release_semaphore()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroySemaphore(device_locked_ptr->get_device_vk(),
-                           m_semaphore,
-                           nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_SEMAPHORE,
+                                              m_semaphore);
 
         m_semaphore = VK_NULL_HANDLE;
     }
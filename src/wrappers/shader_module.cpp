@@ -21,6 +21,7 @@
 //
 
 #include "misc/debug.h"
+#include "misc/deferred_deletion_queue.h"
 #include "misc/glsl_to_spirv.h"
 #include "misc/object_tracker.h"
 #include "wrappers/device.h"
@@ -104,9 +105,9 @@ Anvil::ShaderModule::~ShaderModule()
     {
         std::shared_ptr<Anvil::BaseDevice> device_locked_ptr(m_device_ptr);
 
-        vkDestroyShaderModule(device_locked_ptr->get_device_vk(),
-                              m_module,
-                              nullptr /* pAllocator */);
+        Anvil::DeferredDeletionQueue::destroy(device_locked_ptr,
+                                              Anvil::OBJECT_TYPE_SHADER_MODULE,
+                                              m_module);
 
         m_module = VK_NULL_HANDLE;
     }